@@ -0,0 +1,69 @@
+#ifndef CLIENT_ATOMIC_PRIMITIVES_H
+#define CLIENT_ATOMIC_PRIMITIVES_H
+
+//-- includes -----
+#include <atomic>
+#include <stdint.h>
+
+//-- definitions -----
+// Triple buffered snapshot of an object handed from one writer thread to one reader thread.
+// Both sides are wait-free: the writer fills its own buffer and swaps it into the middle slot,
+// the reader swaps the middle slot out only when the writer published something newer.
+// t_object_type must be cheap enough to copy on every store and fetch (plain data).
+template<typename t_object_type>
+class AtomicSnapshot
+{
+public:
+    AtomicSnapshot()
+        : m_writeIndex(0)
+        , m_readIndex(1)
+        , m_middleState(2)
+        , m_bHasReadValue(false)
+    {
+    }
+
+    /// Publishes a new value. Only ever call from the writer thread.
+    void storeValue(const t_object_type &object)
+    {
+        m_objects[m_writeIndex]= object;
+
+        // Hand the written buffer to the reader and take whatever buffer was in the middle
+        const uint8_t old_middle_state= m_middleState.exchange(m_writeIndex | k_fresh_flag, std::memory_order_acq_rel);
+        m_writeIndex= old_middle_state & k_index_mask;
+    }
+
+    /// Copies the latest published value into out_object.
+    /// Returns false if nothing was ever published. Only ever call from the reader thread.
+    bool fetchValue(t_object_type &out_object)
+    {
+        if ((m_middleState.load(std::memory_order_relaxed) & k_fresh_flag) != 0)
+        {
+            // Take the freshly published buffer, leaving our stale one in the middle for the writer
+            const uint8_t old_middle_state= m_middleState.exchange(m_readIndex, std::memory_order_acq_rel);
+            m_readIndex= old_middle_state & k_index_mask;
+            m_bHasReadValue= true;
+        }
+
+        if (m_bHasReadValue)
+        {
+            out_object= m_objects[m_readIndex];
+        }
+
+        return m_bHasReadValue;
+    }
+
+private:
+    static const uint8_t k_index_mask= 0x3;
+    static const uint8_t k_fresh_flag= 0x4;
+
+    t_object_type m_objects[3];
+    uint8_t m_writeIndex; // only touched by the writer
+    uint8_t m_readIndex; // only touched by the reader
+    std::atomic<uint8_t> m_middleState; // index of the middle buffer | k_fresh_flag if unread
+    bool m_bHasReadValue; // only touched by the reader
+
+    AtomicSnapshot(const AtomicSnapshot &copy) = delete;
+    AtomicSnapshot &operator=(const AtomicSnapshot &copy) = delete;
+};
+
+#endif // CLIENT_ATOMIC_PRIMITIVES_H
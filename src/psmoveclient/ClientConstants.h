@@ -18,6 +18,12 @@
 // The max length of the service version string
 #define PSMOVESERVICE_MAX_VERSION_STRING_LEN 32
 
+// The max number of pipeline stages in the service latency stats
+#define PSMOVESERVICE_MAX_LATENCY_STAGE_COUNT 16
+
+// The max length of a pipeline stage name in the service latency stats
+#define PSMOVESERVICE_MAX_LATENCY_STAGE_NAME_LEN 32
+
 // Defines a standard _PAUSE function
 #if __cplusplus >= 199711L  // if C++11
     #include <thread>
@@ -3,6 +3,7 @@
 
 //-- includes -----
 #include "PSMoveClient_export.h"
+#include "PSMoveProtocolInterface.h"
 #include <boost/system/error_code.hpp>
 
 //-- interface -----
@@ -16,4 +17,14 @@ public:
 	virtual void handle_server_connection_socket_error(const boost::system::error_code& ec) = 0;
 };
 
+// Only used when the client network manager runs its own network thread.
+// Gets each data frame on the network thread as soon as it's read off the socket,
+// before the IDataFrameListener gets it on the thread calling ClientNetworkManager::update().
+class PSM_CPP_PRIVATE_CLASS IAsyncDataFrameListener
+{
+public:
+	virtual void handle_data_frame_async(const PSMoveProtocol::DeviceOutputDataFrame *data_frame) = 0;
+	virtual void handle_compact_data_frame_async(const CompactDataFrame *compact_frame) = 0;
+};
+
 #endif // CLIENT_NETWORK_INTERFACE_H
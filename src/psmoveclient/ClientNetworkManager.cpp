@@ -1,12 +1,18 @@
 //-- includes -----
 #include "ClientNetworkManager.h"
 #include "ClientLog.h"
+#include "CompactDataFrame.h"
 #include "PackedMessage.h"
+#include "ProtocolMessagePool.h"
 #include "PSMoveProtocol.pb.h"
 #include <cassert>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <vector>
 #include <deque>
 #include <boost/asio.hpp>
@@ -21,6 +27,11 @@ using asio::ip::tcp;
 using asio::ip::udp;
 using boost::uint8_t;
 
+//-- constants -----
+// Data frames waiting for the main thread to poll, across all devices.
+// A client that polls less often than that loses the oldest ones (the async listener still saw them).
+static const size_t k_main_thread_data_frame_capacity= 64;
+
 //-- implementation -----
 
 // -ClientNetworkManagerImpl-
@@ -32,6 +43,7 @@ public:
         const std::string &host, 
         const std::string &port, 
         IDataFrameListener *dataFrameListener,
+        IAsyncDataFrameListener *asyncDataFrameListener,
         INotificationListener *notificationListener,
         IResponseListener *responseListener,
         IClientNetworkEventListener *netEventListener)
@@ -41,7 +53,14 @@ public:
         , m_io_service()
         , m_tcp_socket(m_io_service)
         , m_tcp_connection_id(-1)
-        , m_udp_socket(m_io_service, udp::endpoint(udp::v4(), 0))
+        , m_async_data_frame_listener(asyncDataFrameListener)
+        , m_udp_io_service()
+        , m_udp_io_work()
+        , m_udp_io_thread()
+        , m_dropped_data_frame_count(0)
+        , m_udp_socket(
+            asyncDataFrameListener != nullptr ? m_udp_io_service : m_io_service, 
+            udp::endpoint(udp::v4(), 0))
         , m_udp_server_endpoint()
         , m_udp_remote_endpoint()
         , m_connection_stopped(false)
@@ -63,8 +82,20 @@ public:
         , m_response_listener(responseListener)
         , m_netEventListener(netEventListener)
         , m_pending_requests()
+        , m_pending_data_frames()
+        , m_data_frame_pool(k_main_thread_data_frame_capacity)
     {
         memset(m_output_data_frame_buffer, 0, sizeof(m_output_data_frame_buffer));
+
+        m_received_data_frames.reserve(k_main_thread_data_frame_capacity);
+        m_dispatched_data_frames.reserve(k_main_thread_data_frame_capacity);
+        m_received_compact_frames.reserve(k_main_thread_data_frame_capacity);
+        m_dispatched_compact_frames.reserve(k_main_thread_data_frame_capacity);
+    }
+
+    virtual ~ClientNetworkManagerImpl()
+    {
+        stop_network_thread();
     }
 
     bool start()
@@ -73,6 +104,15 @@ public:
         tcp::resolver::iterator endpoint_iter= resolver.resolve(tcp::resolver::query(tcp::v4(), m_server_host, m_server_port));
 
         m_connection_stopped= false;
+
+        // The UDP socket lives on the network thread, the TCP socket stays on the thread calling update()
+        if (getUsesNetworkThread() && !m_udp_io_thread.joinable())
+        {
+            m_udp_io_service.reset();
+            m_udp_io_work.reset(new asio::io_service::work(m_udp_io_service));
+            m_udp_io_thread= std::thread([this]() { m_udp_io_service.run(); });
+        }
+
         bool success= start_tcp_connect(endpoint_iter);
 
         return success;
@@ -89,12 +129,24 @@ public:
         // Stamp the packet with the connection ID before it goes out
         data_frame->set_connection_id(m_tcp_connection_id);
 
-        m_pending_data_frames.push_back(data_frame);
-        start_udp_queued_data_frame_write();
+        run_on_udp_thread([this, data_frame]() {
+            m_pending_data_frames.push_back(data_frame);
+            start_udp_queued_data_frame_write();
+        });
     }
 
     void poll()
     {
+        if (getUsesNetworkThread())
+        {
+            // The network thread does all of the UDP work, only the TCP socket is polled here
+            m_io_service.poll();
+
+            // Hand everything the network thread received since the last poll to the listeners
+            dispatch_main_thread_callbacks();
+            return;
+        }
+
         bool keep_polling = true;
         int iteration_count = 0;
         const static int k_max_iteration_count = 32;
@@ -122,6 +174,9 @@ public:
 
     void stop()
     {
+        // After this, the UDP state is only touched from this thread
+        stop_network_thread();
+
         // drain any pending requests
         while (m_pending_requests.size() > 0)
         {
@@ -173,6 +228,104 @@ public:
     }
 
 private:
+    inline bool getUsesNetworkThread() const
+    {
+        return m_async_data_frame_listener != nullptr;
+    }
+
+    // Runs the handler on the thread that owns the UDP socket
+    void run_on_udp_thread(const std::function<void()> &handler)
+    {
+        if (getUsesNetworkThread())
+        {
+            m_udp_io_service.post(handler);
+        }
+        else
+        {
+            handler();
+        }
+    }
+
+    // Runs the callback on the thread calling update(), which is where the listeners expect to be called
+    void run_on_main_thread(const std::function<void()> &callback)
+    {
+        if (getUsesNetworkThread())
+        {
+            std::lock_guard<std::mutex> lock(m_main_thread_callback_mutex);
+            m_main_thread_callbacks.push_back(callback);
+        }
+        else
+        {
+            callback();
+        }
+    }
+
+    void dispatch_main_thread_callbacks()
+    {
+        std::vector<std::function<void()> > callbacks;
+        size_t dropped_data_frame_count;
+
+        // The data frames are double buffered rather than queued as callbacks,
+        // so once the buffers have grown to fit a poll's worth of frames neither thread allocates
+        {
+            std::lock_guard<std::mutex> lock(m_main_thread_callback_mutex);
+            callbacks.swap(m_main_thread_callbacks);
+            m_dispatched_data_frames.swap(m_received_data_frames);
+            m_dispatched_compact_frames.swap(m_received_compact_frames);
+            dropped_data_frame_count= m_dropped_data_frame_count;
+            m_dropped_data_frame_count= 0;
+        }
+
+        if (dropped_data_frame_count > 0)
+        {
+            CLIENT_LOG_WARNING("ClientNetworkManager::dispatch_main_thread_callbacks")
+                << "Dropped " << dropped_data_frame_count << " data frames that arrived since the last update" << std::endl;
+        }
+
+        // Connection events go first, so the listener hears the connection opened before any data frames
+        for (const std::function<void()> &callback : callbacks)
+        {
+            // A socket error callback can stop the connection, drop anything after that
+            if (m_connection_stopped)
+                break;
+
+            callback();
+        }
+
+        for (const DeviceOutputDataFramePtr &data_frame : m_dispatched_data_frames)
+        {
+            if (m_connection_stopped)
+                break;
+
+            m_data_frame_listener->handle_data_frame(data_frame.get());
+        }
+
+        for (const CompactDataFrame &compact_frame : m_dispatched_compact_frames)
+        {
+            if (m_connection_stopped)
+                break;
+
+            m_data_frame_listener->handle_compact_data_frame(&compact_frame);
+        }
+
+        // Hands the messages back to the pool, the vectors keep their capacity
+        m_dispatched_data_frames.clear();
+        m_dispatched_compact_frames.clear();
+    }
+
+    void stop_network_thread()
+    {
+        if (m_udp_io_thread.joinable())
+        {
+            m_udp_io_work.reset();
+            m_udp_io_service.stop();
+            m_udp_io_thread.join();
+
+            std::lock_guard<std::mutex> lock(m_main_thread_callback_mutex);
+            m_main_thread_callbacks.clear();
+        }
+    }
+
     bool start_tcp_connect(tcp::resolver::iterator endpoint_iter)
     {
         bool success= true;
@@ -268,7 +421,7 @@ private:
 
         // Send the connection id back to the server over UDP
         // to establish a UDP connected and associate it with the TCP connection
-        send_udp_connection_id();
+        run_on_udp_thread([this]() { send_udp_connection_id(); });
     }
 
     void send_udp_connection_id()
@@ -336,20 +489,24 @@ private:
             CLIENT_LOG_ERROR("ClientNetworkManager::handle_udp_read_connection_result") 
                 << "UDP Connect error: " << error.message() << std::endl;
 
-            if (m_netEventListener)
-            {
-                m_netEventListener->handle_server_connection_open_failed(error);
-            }
+            run_on_main_thread([this, error]() {
+                if (m_netEventListener)
+                {
+                    m_netEventListener->handle_server_connection_open_failed(error);
+                }
+            });
         }
         else if (m_udp_connection_result_read_buffer == false)
         {
             CLIENT_LOG_ERROR("ClientNetworkManager::handle_udp_read_connection_result") 
                 << "UDP Connect error: Invalid connection id" << std::endl;
 
-            if (m_netEventListener)
-            {
-                m_netEventListener->handle_server_connection_open_failed(boost::system::error_code());
-            }
+            run_on_main_thread([this]() {
+                if (m_netEventListener)
+                {
+                    m_netEventListener->handle_server_connection_open_failed(boost::system::error_code());
+                }
+            });
         }
         else
         {
@@ -359,14 +516,16 @@ private:
             // Start listening for any incoming data frames (UDP messages)
             start_udp_read_data_frame();
 
-            // If there are any requests waiting, send them off
-            start_tcp_write_request();
+            run_on_main_thread([this]() {
+                // If there are any requests waiting, send them off
+                start_tcp_write_request();
 
-            // Tell the network event listener that we are finally all connected
-            if (m_netEventListener)
-            {
-                m_netEventListener->handle_server_connection_opened();
-            }
+                // Tell the network event listener that we are finally all connected
+                if (m_netEventListener)
+                {
+                    m_netEventListener->handle_server_connection_opened();
+                }
+            });
         }
     }
 
@@ -629,6 +788,12 @@ private:
 
             // Remove the dataframe from the pending send queue now that it's sent
             m_pending_data_frames.pop_front();
+
+            // Nothing polls for the next write on the network thread, so start it right away
+            if (getUsesNetworkThread())
+            {
+                start_udp_queued_data_frame_write();
+            }
         }
         else
         {
@@ -648,11 +813,12 @@ private:
                 boost::bind(
                     &ClientNetworkManagerImpl::handle_udp_read_data_frame, 
                     this,
-                    asio::placeholders::error));
+                    asio::placeholders::error,
+                    asio::placeholders::bytes_transferred));
         }
     }
 
-    void handle_udp_read_data_frame(const boost::system::error_code& error)
+    void handle_udp_read_data_frame(const boost::system::error_code& error, std::size_t bytes_transferred)
     {
         if (m_connection_stopped)
             return;
@@ -662,7 +828,7 @@ private:
             CLIENT_LOG_DEBUG("ClientNetworkManager::handle_udp_read_data_frame") << "Received DataFrame" << std::endl;
 
             // Process the data frame now that we have received all of it
-            handle_udp_data_frame_received();
+            handle_udp_data_frame_received(bytes_transferred);
 
             // Start reading the next incoming data frame
             start_udp_read_data_frame();
@@ -671,47 +837,141 @@ private:
         {
             CLIENT_LOG_ERROR("ClientNetworkManager::handle_tcp_write_request_complete") 
                 << "Error on receive: "  << error.message() << std::endl;
-            stop();
 
-            if (m_netEventListener)
-            {
-                m_netEventListener->handle_server_connection_socket_error(error);
-            }
+            run_on_main_thread([this, error]() {
+                stop();
+
+                if (m_netEventListener)
+                {
+                    m_netEventListener->handle_server_connection_socket_error(error);
+                }
+            });
         }
     }
 
-    // Called when enough data was read into m_data_frame_read_buffer for a complete data frame message. 
-    // Parse the data_frame and forward it on to the response handler.
-    void handle_udp_data_frame_received()
+    // Called when a datagram of data frames was read into m_output_data_frame_buffer. 
+    // Parse each data_frame in it and forward it on to the response handler.
+    void handle_udp_data_frame_received(std::size_t datagram_size)
     {
         // No longer is there a pending read
         m_has_pending_udp_read= false;
 
         CLIENT_LOG_DEBUG("ClientNetworkManager::handle_udp_data_frame_received") << "Parsing DataFrame" << std::endl;
-        
-        // TODO: Switch on data frame type to choose which m_packed_data_frame_X to use.
-        unsigned msg_len = m_packed_output_data_frame.decode_header(m_output_data_frame_buffer, sizeof(m_output_data_frame_buffer));
-        unsigned total_len= HEADER_SIZE+msg_len;
-        CLIENT_LOG_DEBUG("    ") << show_hex(m_output_data_frame_buffer, total_len) << std::endl;
-        CLIENT_LOG_DEBUG("    ") << msg_len << " bytes" << std::endl;
+        CLIENT_LOG_DEBUG("    ") << show_hex(m_output_data_frame_buffer, static_cast<unsigned>(datagram_size)) << std::endl;
+        CLIENT_LOG_DEBUG("    ") << datagram_size << " bytes" << std::endl;
 
-        // Parse the response buffer
-        if (m_packed_output_data_frame.unpack(m_output_data_frame_buffer, total_len))
+        // The datagram holds one or more length prefixed data frames back to back.
+        // An empty header marks the end of the padding older services send.
+        std::size_t offset= 0;
+        while (offset + HEADER_SIZE <= datagram_size)
         {
-            const PSMoveProtocol::DeviceOutputDataFrame *data_frame = m_packed_output_data_frame.get_msg().get();
+            const uint8_t *packed_data_frame= &m_output_data_frame_buffer[offset];
+            const unsigned bytes_left= static_cast<unsigned>(datagram_size - offset);
+
+            // Fixed size pose frames don't go through protobuf at all
+            if (CompactDataFrame::isCompactDataFrame(packed_data_frame, bytes_left))
+            {
+                CompactDataFrame compact_frame;
+                const std::size_t frame_size= CompactDataFrame::getFrameSize(packed_data_frame, bytes_left);
 
-            m_data_frame_listener->handle_data_frame(data_frame);
+                if (frame_size == 0)
+                {
+                    CLIENT_LOG_ERROR("ClientNetworkManager::handle_udp_data_frame_received") << "Error malformed compact data frame" << std::endl;
+                    break;
+                }
+
+                if (CompactDataFrame::unpack(packed_data_frame, bytes_left, compact_frame))
+                {
+                    dispatch_compact_data_frame(compact_frame);
+                }
+                else
+                {
+                    CLIENT_LOG_WARNING("ClientNetworkManager::handle_udp_data_frame_received") << "Skipping compact data frame of an unsupported version" << std::endl;
+                }
+
+                offset+= frame_size;
+                continue;
+            }
+
+            // TODO: Switch on data frame type to choose which m_packed_data_frame_X to use.
+            unsigned msg_len = m_packed_output_data_frame.decode_header(packed_data_frame, bytes_left);
+            unsigned total_len= HEADER_SIZE+msg_len;
+
+            if (msg_len == 0)
+            {
+                break;
+            }
+
+            // The main thread holds on to the data frames the network thread unpacks until its next poll,
+            // so each one gets unpacked straight into a message of its own
+            if (getUsesNetworkThread())
+            {
+                m_packed_output_data_frame.set_msg(m_data_frame_pool.acquire());
+            }
+
+            // Parse the response buffer
+            if (total_len <= bytes_left && m_packed_output_data_frame.unpack(packed_data_frame, total_len))
+            {
+                dispatch_data_frame(m_packed_output_data_frame.get_msg());
+            }
+            else
+            {
+                CLIENT_LOG_ERROR("ClientNetworkManager::handle_udp_data_frame_received") << "Error malformed response" << std::endl;
+
+                run_on_main_thread([this]() {
+                    stop();
+
+                    if (m_netEventListener)
+                    {
+                        //###HipsterSloth $TODO pick a better error code that means "malformed data"
+                        m_netEventListener->handle_server_connection_socket_error(boost::asio::error::message_size);
+                    }
+                });
+
+                return;
+            }
+
+            offset+= total_len;
+        }
+    }
+
+    void dispatch_data_frame(const DeviceOutputDataFramePtr &data_frame)
+    {
+        if (getUsesNetworkThread())
+        {
+            m_async_data_frame_listener->handle_data_frame_async(data_frame.get());
+
+            std::lock_guard<std::mutex> lock(m_main_thread_callback_mutex);
+            if (m_received_data_frames.size() >= k_main_thread_data_frame_capacity)
+            {
+                m_received_data_frames.erase(m_received_data_frames.begin());
+                ++m_dropped_data_frame_count;
+            }
+            m_received_data_frames.push_back(data_frame);
         }
         else
         {
-            CLIENT_LOG_ERROR("ClientNetworkManager::handle_udp_data_frame_received") << "Error malformed response" << std::endl;
-            stop();
+            m_data_frame_listener->handle_data_frame(data_frame.get());
+        }
+    }
 
-            if (m_netEventListener)
+    void dispatch_compact_data_frame(const CompactDataFrame &compact_frame)
+    {
+        if (getUsesNetworkThread())
+        {
+            m_async_data_frame_listener->handle_compact_data_frame_async(&compact_frame);
+
+            std::lock_guard<std::mutex> lock(m_main_thread_callback_mutex);
+            if (m_received_compact_frames.size() >= k_main_thread_data_frame_capacity)
             {
-                //###HipsterSloth $TODO pick a better error code that means "malformed data"
-                m_netEventListener->handle_server_connection_socket_error(boost::asio::error::message_size);
+                m_received_compact_frames.erase(m_received_compact_frames.begin());
+                ++m_dropped_data_frame_count;
             }
+            m_received_compact_frames.push_back(compact_frame);
+        }
+        else
+        {
+            m_data_frame_listener->handle_compact_data_frame(&compact_frame);
         }
     }
 
@@ -723,6 +983,19 @@ private:
     tcp::socket m_tcp_socket;
     int m_tcp_connection_id;
 
+    // Only used with the network thread, which then runs all of the UDP socket work
+    IAsyncDataFrameListener *m_async_data_frame_listener;
+    asio::io_service m_udp_io_service;
+    std::unique_ptr<asio::io_service::work> m_udp_io_work;
+    std::thread m_udp_io_thread;
+    std::mutex m_main_thread_callback_mutex;
+    std::vector<std::function<void()> > m_main_thread_callbacks;
+    std::vector<DeviceOutputDataFramePtr> m_received_data_frames; // filled by the network thread
+    std::vector<DeviceOutputDataFramePtr> m_dispatched_data_frames; // emptied by the main thread
+    std::vector<CompactDataFrame> m_received_compact_frames;
+    std::vector<CompactDataFrame> m_dispatched_compact_frames;
+    size_t m_dropped_data_frame_count; // pushed out of the received frames before the main thread polled them
+
     udp::socket m_udp_socket;
     udp::endpoint m_udp_server_endpoint;
     udp::endpoint m_udp_remote_endpoint;
@@ -737,7 +1010,7 @@ private:
     vector<uint8_t> m_response_read_buffer;
     PackedMessage<PSMoveProtocol::Response> m_packed_response;
 
-    uint8_t m_output_data_frame_buffer[HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+    uint8_t m_output_data_frame_buffer[MAX_OUTPUT_DATA_FRAME_DATAGRAM_SIZE];
     PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> m_packed_output_data_frame;
 
     uint8_t m_input_data_frame_buffer[HEADER_SIZE + MAX_INPUT_DATA_FRAME_MESSAGE_SIZE];
@@ -753,6 +1026,9 @@ private:
 
     deque<RequestPtr> m_pending_requests;
     deque<DeviceInputDataFramePtr> m_pending_data_frames;
+
+    // Recycled data frames handed to the main thread, only acquired from on the network thread
+    ProtocolMessagePool<PSMoveProtocol::DeviceOutputDataFrame> m_data_frame_pool;
 };
 
 // -ClientNetworkManager-
@@ -763,6 +1039,7 @@ ClientNetworkManager::ClientNetworkManager(
     const std::string &host, 
     const std::string &port, 
     IDataFrameListener *dataFrameListener,
+    IAsyncDataFrameListener *asyncDataFrameListener,
     INotificationListener *notificationListener,
     IResponseListener *responseListener,
     IClientNetworkEventListener *netEventListener)
@@ -771,6 +1048,7 @@ ClientNetworkManager::ClientNetworkManager(
             host, 
             port, 
             dataFrameListener,
+            asyncDataFrameListener,
             notificationListener,
             responseListener,
             netEventListener))
@@ -10,12 +10,15 @@
 // -Server Network Manager-
 // Maintains TCP/UDP connection state with PSMoveService.
 // Routes requests to the given request handler.
+// Given an IAsyncDataFrameListener, the UDP socket is run by a network thread of its own
+// and everything it receives is handed to the other listeners in update().
 class PSM_CPP_PRIVATE_CLASS ClientNetworkManager 
 {
 public:
     ClientNetworkManager(
         const std::string &host, const std::string &port, 
         IDataFrameListener *dataFrameListener,
+        IAsyncDataFrameListener *asyncDataFrameListener, // nullptr for no network thread
         INotificationListener *notificationListener,
         IResponseListener *responseListener,
         IClientNetworkEventListener *netEventListener);
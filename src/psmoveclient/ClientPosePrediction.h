@@ -0,0 +1,142 @@
+#ifndef CLIENT_POSE_PREDICTION_H
+#define CLIENT_POSE_PREDICTION_H
+
+//-- includes -----
+#include "PSMoveClient_CAPI.h"
+#include <chrono>
+#include <cmath>
+#include <stdint.h>
+
+//-- constants -----
+// Number of recent clock round trips the service clock offset is picked from
+#define SERVICE_CLOCK_SAMPLE_WINDOW_SIZE 8
+
+//-- definitions -----
+/// Estimates the offset from the client's monotonic clock to the service's one from timed request round trips.
+/// The service read its clock somewhere between when the request was sent and when the response arrived,
+/// so the round trip with the least delay in the recent window gives the tightest estimate
+/// (assuming the delay is about the same both ways).
+class ServiceClockEstimator
+{
+public:
+    ServiceClockEstimator()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        m_sampleCount= 0;
+        m_nextSampleIndex= 0;
+        m_offsetUs= 0;
+        m_roundTripUs= 0;
+    }
+
+    /// The client monotonic clock, in microseconds. Same clock source as the service uses.
+    static int64_t getClientTimeUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// Adds a round trip where the service reported service_time_us
+    void addSample(int64_t request_sent_us, int64_t service_time_us, int64_t response_received_us)
+    {
+        const int64_t round_trip_us= response_received_us - request_sent_us;
+
+        if (round_trip_us < 0)
+        {
+            return;
+        }
+
+        ClockSample &sample= m_samples[m_nextSampleIndex];
+        sample.round_trip_us= round_trip_us;
+        sample.offset_us= service_time_us - (request_sent_us + round_trip_us/2);
+
+        m_nextSampleIndex= (m_nextSampleIndex + 1) % SERVICE_CLOCK_SAMPLE_WINDOW_SIZE;
+        if (m_sampleCount < SERVICE_CLOCK_SAMPLE_WINDOW_SIZE)
+        {
+            ++m_sampleCount;
+        }
+
+        // Older samples age out of the window, so the estimate follows any drift between the clocks
+        const ClockSample *best_sample= &m_samples[0];
+        for (int sample_index = 1; sample_index < m_sampleCount; ++sample_index)
+        {
+            if (m_samples[sample_index].round_trip_us < best_sample->round_trip_us)
+            {
+                best_sample= &m_samples[sample_index];
+            }
+        }
+
+        m_offsetUs= best_sample->offset_us;
+        m_roundTripUs= best_sample->round_trip_us;
+    }
+
+    inline bool getHasEstimate() const { return m_sampleCount > 0; }
+    inline bool getIsSampleWindowFull() const { return m_sampleCount >= SERVICE_CLOCK_SAMPLE_WINDOW_SIZE; }
+
+    /// service time = client time + offset
+    inline int64_t getServiceTimeOffsetUs() const { return m_offsetUs; }
+
+    /// Round trip of the sample the offset came from, twice the worst case error of the offset
+    inline int64_t getRoundTripUs() const { return m_roundTripUs; }
+
+    inline int64_t clientToServiceTimeUs(int64_t client_time_us) const { return client_time_us + m_offsetUs; }
+
+private:
+    struct ClockSample
+    {
+        int64_t round_trip_us;
+        int64_t offset_us;
+    };
+
+    ClockSample m_samples[SERVICE_CLOCK_SAMPLE_WINDOW_SIZE];
+    int m_sampleCount;
+    int m_nextSampleIndex;
+    int64_t m_offsetUs;
+    int64_t m_roundTripUs;
+};
+
+/// Second order extrapolation of a pose time_seconds into the future (or past) from the filter's physics.
+/// The angular velocity and acceleration are in the frame of the pose orientation, as the service pose filters keep them.
+inline PSMPosef extrapolatePose(const PSMPosef &pose, const PSMPhysicsData &physics, float time_seconds)
+{
+    const float half_t_sqr= 0.5f*time_seconds*time_seconds;
+    PSMPosef result= pose;
+
+    result.Position.x+= physics.LinearVelocityCmPerSec.x*time_seconds + physics.LinearAccelerationCmPerSecSqr.x*half_t_sqr;
+    result.Position.y+= physics.LinearVelocityCmPerSec.y*time_seconds + physics.LinearAccelerationCmPerSecSqr.y*half_t_sqr;
+    result.Position.z+= physics.LinearVelocityCmPerSec.z*time_seconds + physics.LinearAccelerationCmPerSecSqr.z*half_t_sqr;
+
+    // Rotation vector swept over the interval: w*t + a*t^2/2
+    const float rx= physics.AngularVelocityRadPerSec.x*time_seconds + physics.AngularAccelerationRadPerSecSqr.x*half_t_sqr;
+    const float ry= physics.AngularVelocityRadPerSec.y*time_seconds + physics.AngularAccelerationRadPerSecSqr.y*half_t_sqr;
+    const float rz= physics.AngularVelocityRadPerSec.z*time_seconds + physics.AngularAccelerationRadPerSecSqr.z*half_t_sqr;
+    const float angle= sqrtf(rx*rx + ry*ry + rz*rz);
+
+    if (angle > 1e-6f)
+    {
+        const float s= sinf(0.5f*angle)/angle;
+        const PSMQuatf &q= pose.Orientation;
+        const float dw= cosf(0.5f*angle), dx= rx*s, dy= ry*s, dz= rz*s;
+
+        // q * dq, then renormalize to keep float error from building up
+        PSMQuatf r;
+        r.w= q.w*dw - q.x*dx - q.y*dy - q.z*dz;
+        r.x= q.w*dx + q.x*dw + q.y*dz - q.z*dy;
+        r.y= q.w*dy - q.x*dz + q.y*dw + q.z*dx;
+        r.z= q.w*dz + q.x*dy - q.y*dx + q.z*dw;
+
+        const float length= sqrtf(r.w*r.w + r.x*r.x + r.y*r.y + r.z*r.z);
+        if (length > 1e-6f)
+        {
+            r.w/= length; r.x/= length; r.y/= length; r.z/= length;
+            result.Orientation= r;
+        }
+    }
+
+    return result;
+}
+
+#endif // CLIENT_POSE_PREDICTION_H
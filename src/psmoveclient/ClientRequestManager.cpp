@@ -3,6 +3,7 @@
 #include "ClientNetworkManager.h"
 #include "PSMoveProtocolInterface.h"
 #include "PSMoveProtocol.pb.h"
+#include "ProtocolMessagePool.h"
 #include <cassert>
 #include <map>
 #include <utility>
@@ -30,6 +31,9 @@ public:
         , m_callback_userdata(userdata)
         , m_pending_requests()
         , m_next_request_id(0)
+        , m_request_reference_cache()
+        , m_response_reference_cache()
+        , m_response_pool()
     {
     }
 
@@ -136,7 +140,8 @@ public:
             // If we just add the given event smart pointer to the reference cache
             // we'll be storing a reference to the shared m_packed_response on the client network manager
             // which gets constantly overwritten with new incoming responses.
-            ResponsePtr responseCopy(new PSMoveProtocol::Response(*response.get()));
+            ResponsePtr responseCopy= m_response_pool.acquire();
+            responseCopy->CopyFrom(*response.get());
 
             // Attach an opaque pointer to the PSMoveProtocol response.
             // Client code that has linked against PSMoveProtocol library
@@ -161,6 +166,10 @@ public:
 			case PSMoveProtocol::Response_ResponseType_SERVICE_VERSION:
                 build_service_version_response_message(response, &out_response_message->payload.service_version);
                 out_response_message->payload_type = PSMResponseMessage::_responsePayloadType_ServiceVersion;
+                break;
+			case PSMoveProtocol::Response_ResponseType_SERVICE_LATENCY_STATS:
+                build_service_latency_stats_response_message(response, &out_response_message->payload.latency_stats);
+                out_response_message->payload_type = PSMResponseMessage::_responsePayloadType_ServiceLatencyStats;
                 break;
             case PSMoveProtocol::Response_ResponseType_CONTROLLER_LIST:
                 build_controller_list_response_message(response, &out_response_message->payload.controller_list);
@@ -194,6 +203,58 @@ public:
 		strncpy(service_version->version_string, VersionResponse.version().c_str(), PSMOVESERVICE_MAX_VERSION_STRING_LEN);
 	}
 
+	void build_service_latency_stats_response_message(
+		ResponsePtr response,
+		PSMServiceLatencyStats *latency_stats)
+	{
+		const auto &LatencyStatsResponse = response->result_service_latency_stats();
+
+		int stage_count= 0;
+		for (const auto &StageResponse : LatencyStatsResponse.stages())
+		{
+			if (stage_count >= PSMOVESERVICE_MAX_LATENCY_STAGE_COUNT)
+			{
+				break;
+			}
+
+			PSMLatencyStage &stage= latency_stats->stages[stage_count];
+
+			strncpy(stage.stage_name, StageResponse.stage_name().c_str(), PSMOVESERVICE_MAX_LATENCY_STAGE_NAME_LEN);
+			stage.stage_name[PSMOVESERVICE_MAX_LATENCY_STAGE_NAME_LEN - 1]= '\0';
+			stage.sample_count= StageResponse.sample_count();
+			stage.p50_us= StageResponse.p50_us();
+			stage.p99_us= StageResponse.p99_us();
+			stage.max_us= StageResponse.max_us();
+
+			++stage_count;
+		}
+
+		latency_stats->stage_count= stage_count;
+		latency_stats->message_pool_misses_per_second= LatencyStatsResponse.message_pool_misses_per_second();
+
+		int controller_queue_count= 0;
+		for (const auto &QueueResponse : LatencyStatsResponse.controller_queues())
+		{
+			if (controller_queue_count >= PSMOVESERVICE_MAX_CONTROLLER_COUNT)
+			{
+				break;
+			}
+
+			PSMControllerQueueStats &queue_stats= latency_stats->controller_queues[controller_queue_count];
+
+			queue_stats.controller_id= QueueResponse.controller_id();
+			queue_stats.imu_queue_depth_max= QueueResponse.imu_queue_depth_max();
+			queue_stats.optical_queue_depth_max= QueueResponse.optical_queue_depth_max();
+			queue_stats.imu_dropped_count= QueueResponse.imu_dropped_count();
+			queue_stats.optical_dropped_count= QueueResponse.optical_dropped_count();
+			queue_stats.merge_dropped_count= QueueResponse.merge_dropped_count();
+
+			++controller_queue_count;
+		}
+
+		latency_stats->controller_queue_count= controller_queue_count;
+	}
+
     void build_controller_list_response_message(
         ResponsePtr response,
         PSMControllerList *controller_list)
@@ -406,6 +467,9 @@ private:
     // The ClientAPI message queue contains raw void pointers to the request/response and event data.
     t_request_reference_cache m_request_reference_cache;
     t_response_reference_cache m_response_reference_cache;
+
+    // Response copies go back to the pool once the reference cache lets go of them
+    ProtocolMessagePool<PSMoveProtocol::Response> m_response_pool;
 };
 
 //-- public methods -----
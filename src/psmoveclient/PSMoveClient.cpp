@@ -5,9 +5,10 @@
 #include "ClientLog.h"
 #include "PSMoveProtocol.pb.h"
 #include "SharedTrackerState.h"
+#include "CompactDataFrame.h"
+#include "SharedDeviceState.h"
 #include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/mapped_region.hpp>
-#include <boost/interprocess/sync/scoped_lock.hpp>
 #include <algorithm>
 #include <iostream>
 #include <thread>
@@ -26,6 +27,19 @@ typedef std::vector<ResponsePtr> t_event_reference_cache;
 #define IS_VALID_TRACKER_INDEX(x) ((x) >= 0 && (x) < PSMOVESERVICE_MAX_TRACKER_COUNT)
 #define IS_VALID_HMD_INDEX(x) ((x) >= 0 && (x) < PSMOVESERVICE_MAX_HMD_COUNT)
 
+// -- constants -----
+// How often to refine the service clock offset once the first window of round trips is in
+static const int64_t k_service_clock_sync_interval_us= 1000000;
+
+// Furthest a pose gets extrapolated away from the service's prediction, in seconds
+static const float k_max_pose_extrapolation_time= 0.1f;
+
+// Stream options that are only sent in UDP data frames, never through the shared device state
+static const unsigned int k_data_frame_only_stream_flags=
+	PSMStreamFlags_includeRawSensorData |
+	PSMStreamFlags_includeCalibratedSensorData |
+	PSMStreamFlags_includeRawTrackerData;
+
 // -- prototypes -----
 static void processPSMoveRecenterAction(PSMController *controller);
 static void processDualShock4RecenterAction(PSMController *controller);
@@ -40,6 +54,14 @@ static void applyTrackerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_Tr
 static void applyHmdDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, PSMHeadMountedDisplay *hmd);
 static void applyMorpheusDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, PSMMorpheus *morpheus);
 static void applyVirtualHMDDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, PSMVirtualHMD *virtualHMD);
+static void applyCompactControllerDataFrame(const CompactDataFrame *compact_frame, PSMController *controller);
+static void applyCompactHmdDataFrame(const CompactDataFrame *compact_frame, PSMHeadMountedDisplay *hmd);
+static void applySharedControllerState(const SharedControllerState &shared_state, unsigned int stream_flags, PSMController *controller);
+static void applySharedHmdState(const SharedHMDState &shared_state, unsigned int stream_flags, PSMHeadMountedDisplay *hmd);
+static void applySharedPhysicsState(const SharedDevicePhysics &shared_physics, unsigned int stream_flags, PSMPhysicsData *physics_data);
+static void applySharedPoseState(const float orientation[4], const float position_cm[3], PSMPosef *pose);
+static void updateDataFrameReceiveStats(long long &last_received_time, float &average_fps);
+static bool isLocalHost(const std::string &host);
 
 // -- private definitions -----
 class SharedVideoFrameReadOnlyAccessor
@@ -49,10 +71,12 @@ public:
         : m_shared_memory_object(nullptr)
         , m_region(nullptr)
         , m_bgr_frame_buffer(nullptr)
+        , m_bgr_back_buffer(nullptr)
         , m_frame_width(0)
         , m_frame_height(0)
         , m_frame_stride(0)
         , m_last_frame_index(0)
+        , m_last_frame_timestamp_us(0)
     {}
 
     ~SharedVideoFrameReadOnlyAccessor()
@@ -114,29 +138,27 @@ public:
             m_shared_memory_object = nullptr;
         }
 
-        if (m_bgr_frame_buffer != nullptr)
-        {
-            delete[] m_bgr_frame_buffer;
-            m_bgr_frame_buffer = nullptr;
-        }
+        freeVideoBuffer();
     }
 
     bool readVideoFrame()
     {
         bool bNewFrame = false;
-        SharedVideoFrameHeader *sharedFrameState = getFrameHeader();
-        boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(sharedFrameState->mutex);
+        const SharedVideoFrameHeader *sharedFrameState = getFrameHeader();
 
-        // Make sure the target buffer is big enough to read the video frame into
-        size_t buffer_size =
-            SharedVideoFrameHeader::computeVideoBufferSize(sharedFrameState->stride, sharedFrameState->height);
+        // A service with a different frame layout wrote this block, so none of the offsets below hold
+        if (m_region->get_size() < sizeof(SharedVideoFrameHeader) ||
+            sharedFrameState->version != SHARED_VIDEO_FRAME_VERSION)
+        {
+            return false;
+        }
 
         // Make sure the shared memory is the size we expect
         size_t total_shared_mem_size =
             SharedVideoFrameHeader::computeTotalSize(sharedFrameState->stride, sharedFrameState->height);
         assert(m_region->get_size() >= total_shared_mem_size);
 
-        // Re-allocate the buffer if any of the video properties changed
+        // Re-allocate the buffers if any of the video properties changed
         if (m_frame_width != sharedFrameState->width ||
             m_frame_height != sharedFrameState->height ||
             m_frame_stride != sharedFrameState->stride)
@@ -150,17 +172,23 @@ public:
             allocateVideoBuffer();
         }
 
-        // Copy over the video frame if the frame index changed
-        if (m_last_frame_index != sharedFrameState->frame_index)
+        // Copy the latest frame into the back buffer if the frame index changed.
+        // The server never waits on us, so a frame torn by the server is simply dropped
+        // and the front buffer keeps the last complete frame.
+        if (m_bgr_back_buffer != nullptr)
         {
-            if (buffer_size > 0)
-            {
-                std::memcpy(m_bgr_frame_buffer, sharedFrameState->getBufferMutable(), buffer_size);
-            }
+            uint32_t frame_index= 0;
+            int64_t frame_timestamp_us= 0;
 
-            m_last_frame_index = sharedFrameState->frame_index;
+            if (sharedFrameState->readLatestVideoFrame(
+                    m_bgr_back_buffer, m_last_frame_index, frame_index, frame_timestamp_us))
+            {
+                std::swap(m_bgr_frame_buffer, m_bgr_back_buffer);
+                m_last_frame_index = frame_index;
+                m_last_frame_timestamp_us = frame_timestamp_us;
 
-            bNewFrame = true;
+                bNewFrame = true;
+            }
         }
 
         return bNewFrame;
@@ -172,18 +200,26 @@ public:
 
         if (buffer_size > 0)
         {
-            // Allocate the buffer to copy the video frame into
+            // Allocate the buffers to copy the video frame into
             m_bgr_frame_buffer = new unsigned char[buffer_size];
+            m_bgr_back_buffer = new unsigned char[buffer_size];
+            std::memset(m_bgr_frame_buffer, 0, buffer_size);
         }
     }
 
     void freeVideoBuffer()
     {
-        // free the video frame buffer
+        // free the video frame buffers
         if (m_bgr_frame_buffer != nullptr)
         {
             delete[] m_bgr_frame_buffer;
-            m_bgr_frame_buffer = 0;
+            m_bgr_frame_buffer = nullptr;
+        }
+
+        if (m_bgr_back_buffer != nullptr)
+        {
+            delete[] m_bgr_back_buffer;
+            m_bgr_back_buffer = nullptr;
         }
     }
 
@@ -191,12 +227,20 @@ public:
     inline int getVideoFrameWidth() const { return m_frame_width; }
     inline int getVideoFrameHeight() const { return m_frame_height; }
     inline int getVideoFrameStride() const { return m_frame_stride; }
-    inline int getLastVideoFrameIndex() const { return m_last_frame_index; }
+    inline int getLastVideoFrameIndex() const { return static_cast<int>(m_last_frame_index); }
+
+    // Age of the last frame read, measured from when the server published it
+    double getLastVideoFrameAgeSeconds() const
+    {
+        const int64_t age_us = SharedVideoFrameHeader::getTimestampMicroseconds() - m_last_frame_timestamp_us;
+
+        return static_cast<double>(age_us) / 1000000.0;
+    }
 
 protected:
-    SharedVideoFrameHeader *getFrameHeader()
+    const SharedVideoFrameHeader *getFrameHeader() const
     {
-        return reinterpret_cast<SharedVideoFrameHeader *>(m_region->get_address());
+        return reinterpret_cast<const SharedVideoFrameHeader *>(m_region->get_address());
     }
 
 private:
@@ -204,16 +248,136 @@ private:
     boost::interprocess::shared_memory_object *m_shared_memory_object;
     boost::interprocess::mapped_region *m_region;
     unsigned char *m_bgr_frame_buffer;
+    unsigned char *m_bgr_back_buffer;
     int m_frame_width, m_frame_height, m_frame_stride;
-    int m_last_frame_index;
+    uint32_t m_last_frame_index;
+    int64_t m_last_frame_timestamp_us;
+};
+
+class SharedDeviceStateReadOnlyAccessor
+{
+public:
+    SharedDeviceStateReadOnlyAccessor()
+        : m_shared_memory_object(nullptr)
+        , m_region(nullptr)
+    {
+        memset(m_last_controller_sequence, 0, sizeof(m_last_controller_sequence));
+        memset(m_last_hmd_sequence, 0, sizeof(m_last_hmd_sequence));
+    }
+
+    ~SharedDeviceStateReadOnlyAccessor()
+    {
+        dispose();
+    }
+
+    bool initialize(const char *shared_memory_name)
+    {
+        bool bSuccess = false;
+
+        try
+        {
+            CLIENT_LOG_INFO("SharedDeviceState::initialize()") << "Opening shared memory: " << shared_memory_name;
+
+            // Open the shared memory object the service created
+            m_shared_memory_object =
+                new boost::interprocess::shared_memory_object(
+                boost::interprocess::open_only,
+                shared_memory_name,
+                boost::interprocess::read_write);
+
+            // Map all of the shared memory for read/write access (the slot sequences are atomics)
+            m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_write);
+
+            if (m_region->get_size() >= sizeof(SharedDeviceStateHeader) &&
+                getDeviceStateHeader()->version == SHARED_DEVICE_STATE_VERSION)
+            {
+                bSuccess = true;
+            }
+            else
+            {
+                CLIENT_LOG_WARNING("SharedDeviceState::initialize()") << "Ignoring shared memory: " << shared_memory_name
+                    << ", unexpected layout version";
+                dispose();
+            }
+        }
+        catch (boost::interprocess::interprocess_exception &ex)
+        {
+            dispose();
+            CLIENT_LOG_INFO("SharedDeviceState::initialize()") << "Shared device state unavailable: " << shared_memory_name
+                << ", reason: " << ex.what();
+        }
+        catch (std::exception &ex)
+        {
+            dispose();
+            CLIENT_LOG_ERROR("SharedDeviceState::initialize()") << "Failed to open shared memory: " << shared_memory_name
+                << ", reason: " << ex.what();
+        }
+
+        return bSuccess;
+    }
+
+    void dispose()
+    {
+        if (m_region != nullptr)
+        {
+            delete m_region;
+            m_region = nullptr;
+        }
+
+        if (m_shared_memory_object != nullptr)
+        {
+            delete m_shared_memory_object;
+            m_shared_memory_object = nullptr;
+        }
+
+        memset(m_last_controller_sequence, 0, sizeof(m_last_controller_sequence));
+        memset(m_last_hmd_sequence, 0, sizeof(m_last_hmd_sequence));
+    }
+
+    // Copies out the controller state if the service published a new one since the last read
+    bool readControllerState(PSMControllerID controller_id, SharedControllerState &out_state)
+    {
+        const SharedDeviceStateSlot<SharedControllerState> &slot= getDeviceStateHeader()->controllers[controller_id];
+
+        return slot.read(m_last_controller_sequence[controller_id], out_state, m_last_controller_sequence[controller_id]);
+    }
+
+    // Copies out the HMD state if the service published a new one since the last read
+    bool readHmdState(PSMHmdID hmd_id, SharedHMDState &out_state)
+    {
+        const SharedDeviceStateSlot<SharedHMDState> &slot= getDeviceStateHeader()->hmds[hmd_id];
+
+        return slot.read(m_last_hmd_sequence[hmd_id], out_state, m_last_hmd_sequence[hmd_id]);
+    }
+
+protected:
+    const SharedDeviceStateHeader *getDeviceStateHeader() const
+    {
+        return reinterpret_cast<const SharedDeviceStateHeader *>(m_region->get_address());
+    }
+
+private:
+    boost::interprocess::shared_memory_object *m_shared_memory_object;
+    boost::interprocess::mapped_region *m_region;
+    uint32_t m_last_controller_sequence[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    uint32_t m_last_hmd_sequence[PSMOVESERVICE_MAX_HMD_COUNT];
 };
 
 // -- methods -----
 PSMoveClient::PSMoveClient(
     const std::string &host, 
-    const std::string &port)
+    const std::string &port,
+    bool bUseNetworkThread)
     : m_request_manager(nullptr)  // ClientPSMoveAPIImpl::handle_response_message userdata
     , m_network_manager(nullptr) // IClientNetworkEventListener
+    , m_host(host)
+    , m_shared_device_state_accessor(nullptr)
+    , m_bUseNetworkThread(bUseNetworkThread)
+    , m_service_clock()
+    , m_service_clock_request_id(PSM_INVALID_REQUEST_ID)
+    , m_service_clock_request_sent_us(0)
+    , m_service_clock_last_sync_us(0)
+    , m_bIsServiceClockSyncActive(false)
 	, m_bIsConnected(false)
 	, m_bHasConnectionStatusChanged(false)
 	, m_bHasControllerListChanged(false)
@@ -229,13 +393,22 @@ PSMoveClient::PSMoveClient(
 		new ClientNetworkManager(
 			host, port, 
 			this, // IDataFrameListener
+			bUseNetworkThread ? this : nullptr, // IAsyncDataFrameListener
 			this, // INotificationListener
 			m_request_manager, // IResponseListener
 			this); // IClientNetworkEventListener
+
+    memset(m_bControllerStreamUsesSharedMemory, 0, sizeof(m_bControllerStreamUsesSharedMemory));
+    memset(m_controllerSharedMemoryStreamFlags, 0, sizeof(m_controllerSharedMemoryStreamFlags));
+    memset(m_bHmdStreamUsesSharedMemory, 0, sizeof(m_bHmdStreamUsesSharedMemory));
+    memset(m_hmdSharedMemoryStreamFlags, 0, sizeof(m_hmdSharedMemoryStreamFlags));
+    memset(m_controllerDataStreamRateHz, 0, sizeof(m_controllerDataStreamRateHz));
+    memset(m_hmdDataStreamRateHz, 0, sizeof(m_hmdDataStreamRateHz));
 }
 
 PSMoveClient::~PSMoveClient()
 {
+    close_shared_device_state();
 	delete m_network_manager;
 	delete m_request_manager;
 }
@@ -335,6 +508,22 @@ bool PSMoveClient::startup(e_log_severity_level log_level)
 			m_HMDs[hmd_id].HmdID= hmd_id;
 			m_HMDs[hmd_id].HmdType= PSMHmd_None;
 		}
+
+		// The network thread only starts receiving data frames once a later update() finishes connecting
+		memcpy(m_async_controllers, m_controllers, sizeof(m_async_controllers));
+		memcpy(m_async_HMDs, m_HMDs, sizeof(m_async_HMDs));
+		memset(m_controllerSnapshotSequenceNum, 0, sizeof(m_controllerSnapshotSequenceNum));
+		memset(m_hmdSnapshotSequenceNum, 0, sizeof(m_hmdSnapshotSequenceNum));
+		for (PSMControllerID controller_id= 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+		{
+			m_controllerViewResetCount[controller_id].store(0);
+			m_asyncControllerViewResetCount[controller_id]= 0;
+		}
+		for (PSMHmdID hmd_id= 0; hmd_id < PSMOVESERVICE_MAX_HMD_COUNT; ++hmd_id)
+		{
+			m_hmdViewResetCount[hmd_id].store(0);
+			m_asyncHmdViewResetCount[hmd_id]= 0;
+		}
 	}
 
     return success;
@@ -360,6 +549,18 @@ void PSMoveClient::update()
 
     // Process incoming/outgoing networking requests
     m_network_manager->update();
+
+    // Pull the latest state of the devices streaming through shared memory
+    poll_shared_device_state();
+
+    // Keep the service clock offset fresh for pose extrapolation
+    update_service_clock_sync();
+
+    // Without a network thread the snapshots are only as fresh as the last update
+    if (!m_bUseNetworkThread)
+    {
+        store_device_snapshots();
+    }
 }
 
 void PSMoveClient::process_messages()
@@ -413,7 +614,7 @@ void PSMoveClient::publish()
 
 			if (bHasUnpublishedState)
 			{
-				DeviceInputDataFramePtr data_frame(new PSMoveProtocol::DeviceInputDataFrame);
+				DeviceInputDataFramePtr data_frame= m_input_data_frame_pool.acquire();
 				data_frame->set_device_category(PSMoveProtocol::DeviceInputDataFrame_DeviceCategory_CONTROLLER);
 
 				auto *controller_data_packet= data_frame->mutable_controller_data_packet();
@@ -617,6 +818,9 @@ void PSMoveClient::shutdown()
     // Close all active network connections
     m_network_manager->shutdown();
 
+    // Stop reading device state published by the service
+    close_shared_device_state();
+
     // Drop an unread messages from the previous call to update
     m_message_queue.clear();
 
@@ -628,6 +832,8 @@ void PSMoveClient::shutdown()
 
     // No more pending requests
     m_pending_request_map.clear();
+    m_service_clock_request_id= PSM_INVALID_REQUEST_ID;
+    m_bIsServiceClockSyncActive= false;
 }
 
 // -- System Requests ----
@@ -644,6 +850,41 @@ PSMRequestID PSMoveClient::get_service_version()
     return request->request_id();
 }
 
+PSMRequestID PSMoveClient::get_service_latency_stats(bool reset_stats)
+{
+    CLIENT_LOG_INFO("get_service_latency_stats") << "requesting service latency stats" << std::endl;
+
+    // Tell the psmove service that we want the pipeline latency histograms
+    RequestPtr request(new PSMoveProtocol::Request());
+    request->set_type(PSMoveProtocol::Request_RequestType_GET_SERVICE_LATENCY_STATS);
+    request->mutable_request_get_service_latency_stats()->set_reset_stats(reset_stats);
+
+    m_request_manager->send_request(request);
+
+    return request->request_id();
+}
+
+float PSMoveClient::get_pose_extrapolation_time(
+    long long sample_time_us, 
+    float prediction_time, 
+    double client_time_seconds) const
+{
+    float extrapolation_time= 0.f;
+
+    // Without a clock offset or a sample time the pose can only be used as published
+    if (m_service_clock.getHasEstimate() && sample_time_us != 0)
+    {
+        const int64_t client_time_us= static_cast<int64_t>(client_time_seconds*1000000.0);
+        const int64_t pose_time_us= sample_time_us + static_cast<int64_t>(prediction_time*1000000.f);
+        const int64_t target_time_us= m_service_clock.clientToServiceTimeUs(client_time_us);
+        const float time_seconds= static_cast<float>(target_time_us - pose_time_us)/1000000.f;
+
+        extrapolation_time= std::max(std::min(time_seconds, k_max_pose_extrapolation_time), -k_max_pose_extrapolation_time);
+    }
+
+    return extrapolation_time;
+}
+
 // -- ClientPSMoveAPI Requests -----
 bool PSMoveClient::allocate_controller_listener(PSMControllerID ControllerID)
 {
@@ -655,9 +896,7 @@ bool PSMoveClient::allocate_controller_listener(PSMControllerID ControllerID)
 
 		if (controller->ListenerCount == 0)
 		{
-			memset(controller, 0, sizeof(PSMController));
-			controller->ControllerID= ControllerID;
-			controller->ControllerType = PSMController_None;
+			reset_controller_view(ControllerID, controller);
 		}
 
 		++controller->ListenerCount;
@@ -678,9 +917,7 @@ void PSMoveClient::free_controller_listener(PSMControllerID ControllerID)
 
 		if (controller->ListenerCount <= 0)
 		{
-			memset(controller, 0, sizeof(PSMController));
-			controller->ControllerID= ControllerID;
-			controller->ControllerType= PSMController_None;
+			reset_controller_view(ControllerID, controller);
 		}
 	}
 }
@@ -690,6 +927,13 @@ PSMController* PSMoveClient::get_controller_view(PSMControllerID controller_id)
 	return IS_VALID_CONTROLLER_INDEX(controller_id) ? &m_controllers[controller_id] : nullptr;
 }
 
+bool PSMoveClient::get_controller_snapshot(PSMControllerID controller_id, PSMController *out_controller)
+{
+	return 
+		IS_VALID_CONTROLLER_INDEX(controller_id) && 
+		m_controller_snapshots[controller_id].fetchValue(*out_controller);
+}
+
 PSMRequestID PSMoveClient::get_controller_list()
 {
     CLIENT_LOG_INFO("get_controller_list") << "requesting controller list" << std::endl;
@@ -750,6 +994,26 @@ PSMRequestID PSMoveClient::start_controller_data_stream(PSMControllerID controll
 			request->mutable_request_start_psmove_data_stream()->set_disable_roi(true);
 		}
 
+		// A service on this machine can hand us the pose through shared memory instead of UDP,
+		// as long as we don't want any of the sensor or tracker data that only the data frame carries
+		m_bControllerStreamUsesSharedMemory[controller_id]=
+			m_shared_device_state_accessor != nullptr &&
+			(flags & k_data_frame_only_stream_flags) == 0;
+		m_controllerSharedMemoryStreamFlags[controller_id]= flags;
+
+		if (m_bControllerStreamUsesSharedMemory[controller_id])
+		{
+			request->mutable_request_start_psmove_data_stream()->set_shared_memory_only(true);
+		}
+		else if ((flags & k_data_frame_only_stream_flags) == 0)
+		{
+			// Otherwise just the pose means the smaller fixed size data frames will do
+			request->mutable_request_start_psmove_data_stream()->set_use_compact_data_frames(true);
+		}
+
+		// Let the service coalesce state updates we couldn't consume anyway
+		request->mutable_request_start_psmove_data_stream()->set_publish_rate_hz(m_controllerDataStreamRateHz[controller_id]);
+
 		m_request_manager->send_request(request);
 
 		requestID= request->request_id();
@@ -771,6 +1035,9 @@ PSMRequestID PSMoveClient::stop_controller_data_stream(PSMControllerID controlle
 		request->set_type(PSMoveProtocol::Request_RequestType_STOP_CONTROLLER_DATA_STREAM);
 		request->mutable_request_stop_psmove_data_stream()->set_controller_id(controller_id);
 
+		m_bControllerStreamUsesSharedMemory[controller_id]= false;
+		m_controllerSharedMemoryStreamFlags[controller_id]= 0;
+
 		m_request_manager->send_request(request);
 
 		requestID= request->request_id();
@@ -851,6 +1118,21 @@ PSMRequestID PSMoveClient::set_controller_data_stream_tracker_index(PSMControlle
 	return requestID;
 }
 
+bool PSMoveClient::set_controller_data_stream_rate(PSMControllerID controller_id, float publish_rate_hz)
+{
+	bool bSuccess= false;
+
+	if (IS_VALID_CONTROLLER_INDEX(controller_id) && publish_rate_hz >= 0.f)
+	{
+		CLIENT_LOG_INFO("set_controller_data_stream_rate") << "set rate: " << publish_rate_hz << "Hz for ControllerID: " << controller_id << std::endl;
+
+		m_controllerDataStreamRateHz[controller_id]= publish_rate_hz;
+		bSuccess= true;
+	}
+
+	return bSuccess;
+}
+
 PSMRequestID PSMoveClient::set_controller_hand(PSMControllerID controller_id, PSMControllerHand controller_hand)
 {
 	PSMRequestID requestID= PSM_INVALID_REQUEST_ID;
@@ -1073,6 +1355,31 @@ const unsigned char *PSMoveClient::get_video_frame_buffer(PSMTrackerID tracker_i
 
 	return buffer;
 }
+
+bool PSMoveClient::get_video_frame_info(PSMTrackerID tracker_id, int *out_frame_index, double *out_frame_age_seconds) const
+{
+	bool bSuccess= false;
+
+	if (IS_VALID_TRACKER_INDEX(tracker_id))
+	{
+		const PSMTracker *tracker= &m_trackers[tracker_id];
+
+		if (tracker->opaque_shared_memory_accesor != nullptr)
+		{
+			SharedVideoFrameReadOnlyAccessor *shared_memory_accesor = 
+				reinterpret_cast<SharedVideoFrameReadOnlyAccessor *>(tracker->opaque_shared_memory_accesor);
+
+			if (shared_memory_accesor->getLastVideoFrameIndex() != 0)
+			{
+				*out_frame_index= shared_memory_accesor->getLastVideoFrameIndex();
+				*out_frame_age_seconds= shared_memory_accesor->getLastVideoFrameAgeSeconds();
+				bSuccess= true;
+			}
+		}
+	}
+
+	return bSuccess;
+}
     
 bool PSMoveClient::allocate_hmd_listener(PSMHmdID hmd_id)
 {
@@ -1084,9 +1391,7 @@ bool PSMoveClient::allocate_hmd_listener(PSMHmdID hmd_id)
 
         if (hmd->ListenerCount == 0)
         {
-			memset(hmd, 0, sizeof(PSMHeadMountedDisplay));
-            hmd->HmdID= hmd_id;
-            hmd->HmdType = PSMHmd_None;
+            reset_hmd_view(hmd_id, hmd);
         }
 
         ++hmd->ListenerCount;
@@ -1107,9 +1412,7 @@ void PSMoveClient::free_hmd_listener(PSMHmdID hmd_id)
 
         if (hmd->ListenerCount <= 0)
         {
-            memset(hmd, 0, sizeof(PSMHeadMountedDisplay));
-            hmd->HmdID= hmd_id;
-            hmd->HmdType= PSMHmd_None;
+            reset_hmd_view(hmd_id, hmd);
         }
     }
 }
@@ -1119,6 +1422,13 @@ PSMHeadMountedDisplay* PSMoveClient::get_hmd_view(PSMHmdID hmd_id)
 	return IS_VALID_HMD_INDEX(hmd_id) ? &m_HMDs[hmd_id] : nullptr;
 }
 
+bool PSMoveClient::get_hmd_snapshot(PSMHmdID hmd_id, PSMHeadMountedDisplay *out_hmd)
+{
+	return 
+		IS_VALID_HMD_INDEX(hmd_id) && 
+		m_hmd_snapshots[hmd_id].fetchValue(*out_hmd);
+}
+
 PSMRequestID PSMoveClient::get_hmd_list()
 {
     CLIENT_LOG_INFO("get_hmd_list") << "requesting hmd list" << std::endl;
@@ -1174,6 +1484,26 @@ PSMRequestID PSMoveClient::start_hmd_data_stream(
 		request->mutable_request_start_hmd_data_stream()->set_disable_roi(true);
 	}
 
+	// Same as controllers, only pose and physics can come through shared memory
+	if (IS_VALID_HMD_INDEX(hmd_id))
+	{
+		m_bHmdStreamUsesSharedMemory[hmd_id]=
+			m_shared_device_state_accessor != nullptr &&
+			(flags & k_data_frame_only_stream_flags) == 0;
+		m_hmdSharedMemoryStreamFlags[hmd_id]= flags;
+
+		if (m_bHmdStreamUsesSharedMemory[hmd_id])
+		{
+			request->mutable_request_start_hmd_data_stream()->set_shared_memory_only(true);
+		}
+		else if ((flags & k_data_frame_only_stream_flags) == 0)
+		{
+			request->mutable_request_start_hmd_data_stream()->set_use_compact_data_frames(true);
+		}
+
+		request->mutable_request_start_hmd_data_stream()->set_publish_rate_hz(m_hmdDataStreamRateHz[hmd_id]);
+	}
+
     m_request_manager->send_request(request);
 
     return request->request_id();
@@ -1189,6 +1519,12 @@ PSMRequestID PSMoveClient::stop_hmd_data_stream(
     request->set_type(PSMoveProtocol::Request_RequestType_STOP_HMD_DATA_STREAM);
     request->mutable_request_stop_hmd_data_stream()->set_hmd_id(hmd_id);
 
+    if (IS_VALID_HMD_INDEX(hmd_id))
+    {
+        m_bHmdStreamUsesSharedMemory[hmd_id]= false;
+        m_hmdSharedMemoryStreamFlags[hmd_id]= 0;
+    }
+
     m_request_manager->send_request(request);
 
     return request->request_id();
@@ -1208,6 +1544,21 @@ PSMRequestID PSMoveClient::set_hmd_data_stream_tracker_index(PSMHmdID hmd_id, PS
     return request->request_id();
 }
     
+bool PSMoveClient::set_hmd_data_stream_rate(PSMHmdID hmd_id, float publish_rate_hz)
+{
+	bool bSuccess= false;
+
+	if (IS_VALID_HMD_INDEX(hmd_id) && publish_rate_hz >= 0.f)
+	{
+		CLIENT_LOG_INFO("set_hmd_data_stream_rate") << "set rate: " << publish_rate_hz << "Hz for HmdID: " << hmd_id << std::endl;
+
+		m_hmdDataStreamRateHz[hmd_id]= publish_rate_hz;
+		bSuccess= true;
+	}
+
+	return bSuccess;
+}
+
 PSMRequestID PSMoveClient::send_opaque_request(
     PSMRequestHandle request_handle)
 {
@@ -1275,6 +1626,127 @@ void PSMoveClient::handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame
     }
 }
 
+void PSMoveClient::handle_compact_data_frame(const CompactDataFrame *compact_frame)
+{
+    switch (compact_frame->device_category)
+    {
+    case CompactDataFrameDevice_Controller:
+        {
+			const PSMControllerID controller_id= compact_frame->device_id;
+
+			if (IS_VALID_CONTROLLER_INDEX(controller_id))
+			{
+				applyCompactControllerDataFrame(compact_frame, get_controller_view(controller_id));
+			}
+        } break;
+    case CompactDataFrameDevice_HMD:
+        {
+			const PSMHmdID hmd_id= compact_frame->device_id;
+
+			if (IS_VALID_HMD_INDEX(hmd_id))
+			{
+				applyCompactHmdDataFrame(compact_frame, get_hmd_view(hmd_id));
+			}
+        } break;
+    }
+}
+
+// IAsyncDataFrameListener
+// Called on the network thread, which only ever touches its own copy of the device views
+void PSMoveClient::handle_data_frame_async(const PSMoveProtocol::DeviceOutputDataFrame *data_frame)
+{
+    switch (data_frame->device_category())
+    {
+    case PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER:
+        {
+            const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet= data_frame->controller_data_packet();
+			const PSMControllerID controller_id= controller_packet.controller_id();
+
+			if (IS_VALID_CONTROLLER_INDEX(controller_id))
+			{
+				PSMController *controller= get_async_controller_view(controller_id);
+
+				applyControllerDataFrame(controller_packet, controller);
+				m_controller_snapshots[controller_id].storeValue(*controller);
+			}
+        } break;
+    case PSMoveProtocol::DeviceOutputDataFrame::HMD:
+        {
+            const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet = data_frame->hmd_data_packet();
+			const PSMHmdID hmd_id= hmd_packet.hmd_id();
+
+			if (IS_VALID_HMD_INDEX(hmd_id))
+			{
+				PSMHeadMountedDisplay *hmd= get_async_hmd_view(hmd_id);
+
+				applyHmdDataFrame(hmd_packet, hmd);
+				m_hmd_snapshots[hmd_id].storeValue(*hmd);
+			}
+        } break;
+    default:
+        // Only controllers and HMDs have snapshots
+        break;
+    }
+}
+
+void PSMoveClient::handle_compact_data_frame_async(const CompactDataFrame *compact_frame)
+{
+    switch (compact_frame->device_category)
+    {
+    case CompactDataFrameDevice_Controller:
+        {
+			const PSMControllerID controller_id= compact_frame->device_id;
+
+			if (IS_VALID_CONTROLLER_INDEX(controller_id))
+			{
+				PSMController *controller= get_async_controller_view(controller_id);
+
+				applyCompactControllerDataFrame(compact_frame, controller);
+				m_controller_snapshots[controller_id].storeValue(*controller);
+			}
+        } break;
+    case CompactDataFrameDevice_HMD:
+        {
+			const PSMHmdID hmd_id= compact_frame->device_id;
+
+			if (IS_VALID_HMD_INDEX(hmd_id))
+			{
+				PSMHeadMountedDisplay *hmd= get_async_hmd_view(hmd_id);
+
+				applyCompactHmdDataFrame(compact_frame, hmd);
+				m_hmd_snapshots[hmd_id].storeValue(*hmd);
+			}
+        } break;
+    }
+}
+
+static void applyCompactControllerDataFrame(
+	const CompactDataFrame *compact_frame,
+	PSMController *controller)
+{
+    // Only carries what the shared device state does, so it's applied the same way
+	SharedControllerState controller_state;
+
+	compact_frame->decodeControllerState(controller_state);
+	applySharedControllerState(
+		controller_state, 
+		(compact_frame->section_flags & CompactDataFrameSection_Physics) != 0 ? PSMStreamFlags_includePhysicsData : 0,
+		controller);
+}
+
+static void applyCompactHmdDataFrame(
+	const CompactDataFrame *compact_frame,
+	PSMHeadMountedDisplay *hmd)
+{
+	SharedHMDState hmd_state;
+
+	compact_frame->decodeHmdState(hmd_state);
+	applySharedHmdState(
+		hmd_state, 
+		(compact_frame->section_flags & CompactDataFrameSection_Physics) != 0 ? PSMStreamFlags_includePhysicsData : 0,
+		hmd);
+}
+
 static void applyControllerDataFrame(
 	const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, 
 	PSMController *controller)
@@ -1288,24 +1760,11 @@ static void applyControllerDataFrame(
     controller->ControllerType = static_cast<PSMControllerType>(controller_packet.controller_type());
     controller->OutputSequenceNum = controller_packet.sequence_num();
     controller->IsConnected = controller_packet.isconnected();
+    controller->DataFrameSampleTimeUs = controller_packet.sample_time_us();
+    controller->DataFramePredictionTime = controller_packet.prediction_time();
 
     // Compute the data frame receive window statistics if we have received enough samples
-    {
-        long long now = 
-            std::chrono::duration_cast< std::chrono::milliseconds >(
-                std::chrono::system_clock::now().time_since_epoch()).count();
-        long long diff= now - controller->DataFrameLastReceivedTime;
-
-        if (diff > 0)
-        {
-            float seconds= static_cast<float>(diff) / 1000.f;
-            float fps= 1.f / seconds;
-
-            controller->DataFrameAverageFPS= (0.9f)*controller->DataFrameAverageFPS + (0.1f)*fps;
-        }
-
-        controller->DataFrameLastReceivedTime= now;
-    }
+    updateDataFrameReceiveStats(controller->DataFrameLastReceivedTime, controller->DataFrameAverageFPS);
    
 	// Don't bother updating the rest of the controller state if it's not connected
 	if (!controller->IsConnected)
@@ -1898,24 +2357,11 @@ static void applyHmdDataFrame(
     hmd->HmdType = static_cast<PSMHmdType>(hmd_packet.hmd_type());
     hmd->OutputSequenceNum = hmd_packet.sequence_num();
     hmd->IsConnected = hmd_packet.isconnected();
+    hmd->DataFrameSampleTimeUs = hmd_packet.sample_time_us();
+    hmd->DataFramePredictionTime = hmd_packet.prediction_time();
 
     // Compute the data frame receive window statistics if we have received enough samples
-    {
-        long long now = 
-            std::chrono::duration_cast< std::chrono::milliseconds >(
-                std::chrono::system_clock::now().time_since_epoch()).count();
-        long long diff= now - hmd->DataFrameLastReceivedTime;
-
-        if (diff > 0)
-        {
-            float seconds= static_cast<float>(diff) / 1000.f;
-            float fps= 1.f / seconds;
-
-            hmd->DataFrameAverageFPS= (0.9f)*hmd->DataFrameAverageFPS + (0.1f)*fps;
-        }
-
-        hmd->DataFrameLastReceivedTime= now;
-    }
+    updateDataFrameReceiveStats(hmd->DataFrameLastReceivedTime, hmd->DataFrameAverageFPS);
 
 	// Don't bother updating the rest of the hmd state if it's not connected
 	if (!hmd->IsConnected)
@@ -2136,6 +2582,305 @@ static void applyVirtualHMDDataFrame(
 	}
 }
 
+static void applySharedControllerState(
+	const SharedControllerState &shared_state,
+	unsigned int stream_flags,
+	PSMController *controller)
+{
+	// Ignore state we've already applied
+	if (shared_state.sequence_num <= controller->OutputSequenceNum)
+		return;
+
+    // Set the generic items
+    controller->bValid = shared_state.controller_type != -1;
+    controller->ControllerType = static_cast<PSMControllerType>(shared_state.controller_type);
+    controller->OutputSequenceNum = shared_state.sequence_num;
+    controller->IsConnected = (shared_state.state_flags & SharedDeviceStateFlag_IsConnected) != 0;
+    controller->DataFrameSampleTimeUs = shared_state.sample_time_us;
+    controller->DataFramePredictionTime = shared_state.prediction_time;
+
+    updateDataFrameReceiveStats(controller->DataFrameLastReceivedTime, controller->DataFrameAverageFPS);
+
+	// Don't bother updating the rest of the controller state if it's not connected
+	if (!controller->IsConnected)
+		return;
+
+    const uint32_t flags= shared_state.state_flags;
+    const unsigned int button_bitmask= shared_state.button_down_bitmask;
+
+    switch (controller->ControllerType) 
+	{
+        case PSMController_Move:
+            {
+                PSMPSMove *psmove= &controller->ControllerState.PSMoveState;
+
+                psmove->bHasValidHardwareCalibration = (flags & SharedDeviceStateFlag_HasValidHardwareCalibration) != 0;
+                psmove->bIsTrackingEnabled = (flags & SharedDeviceStateFlag_IsTrackingEnabled) != 0;
+                psmove->bIsCurrentlyTracking = (flags & SharedDeviceStateFlag_IsCurrentlyTracking) != 0;
+                psmove->bIsOrientationValid = (flags & SharedDeviceStateFlag_IsOrientationValid) != 0;
+                psmove->bIsPositionValid = (flags & SharedDeviceStateFlag_IsPositionValid) != 0;
+
+                applySharedPoseState(shared_state.orientation, shared_state.position_cm, &psmove->Pose);
+                applySharedPhysicsState(shared_state.physics, stream_flags, &psmove->PhysicsData);
+
+                applyPSMButtonState(psmove->TriangleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIANGLE);
+                applyPSMButtonState(psmove->CircleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CIRCLE);
+                applyPSMButtonState(psmove->CrossButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CROSS);
+                applyPSMButtonState(psmove->SquareButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SQUARE);
+                applyPSMButtonState(psmove->SelectButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SELECT);
+                applyPSMButtonState(psmove->StartButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_START);
+                applyPSMButtonState(psmove->PSButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_PS);
+                applyPSMButtonState(psmove->MoveButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_MOVE);
+                applyPSMButtonState(psmove->TriggerButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIGGER);
+
+                psmove->TriggerValue = static_cast<unsigned char>(shared_state.analog_values[0]);
+                psmove->BatteryValue = static_cast<PSMBatteryState>(shared_state.battery_value);
+            } break;
+
+        case PSMController_Navi:
+            {
+                PSMPSNavi *psnavi= &controller->ControllerState.PSNaviState;
+
+                applyPSMButtonState(psnavi->L1Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_L1);
+                applyPSMButtonState(psnavi->L2Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_L2);
+                applyPSMButtonState(psnavi->L3Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_L3);
+                applyPSMButtonState(psnavi->CircleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CIRCLE);
+                applyPSMButtonState(psnavi->CrossButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CROSS);
+                applyPSMButtonState(psnavi->PSButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_PS);
+                applyPSMButtonState(psnavi->TriggerButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIGGER);
+                applyPSMButtonState(psnavi->DPadUpButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_UP);
+                applyPSMButtonState(psnavi->DPadRightButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_RIGHT);
+                applyPSMButtonState(psnavi->DPadDownButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_DOWN);
+                applyPSMButtonState(psnavi->DPadLeftButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_LEFT);
+
+                psnavi->TriggerValue= static_cast<unsigned char>(shared_state.analog_values[0]);
+                psnavi->Stick_XAxis= static_cast<unsigned char>(shared_state.analog_values[1]);
+                psnavi->Stick_YAxis= static_cast<unsigned char>(shared_state.analog_values[2]);
+            } break;
+
+        case PSMController_DualShock4:
+            {
+                PSMDualShock4 *ds4= &controller->ControllerState.PSDS4State;
+
+                ds4->bHasValidHardwareCalibration = (flags & SharedDeviceStateFlag_HasValidHardwareCalibration) != 0;
+                ds4->bIsTrackingEnabled = (flags & SharedDeviceStateFlag_IsTrackingEnabled) != 0;
+                ds4->bIsCurrentlyTracking = (flags & SharedDeviceStateFlag_IsCurrentlyTracking) != 0;
+                ds4->bIsOrientationValid = (flags & SharedDeviceStateFlag_IsOrientationValid) != 0;
+                ds4->bIsPositionValid = (flags & SharedDeviceStateFlag_IsPositionValid) != 0;
+
+                applySharedPoseState(shared_state.orientation, shared_state.position_cm, &ds4->Pose);
+                applySharedPhysicsState(shared_state.physics, stream_flags, &ds4->PhysicsData);
+
+                applyPSMButtonState(ds4->DPadUpButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_UP);
+                applyPSMButtonState(ds4->DPadDownButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_DOWN);
+                applyPSMButtonState(ds4->DPadLeftButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_LEFT);
+                applyPSMButtonState(ds4->DPadRightButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_RIGHT);
+
+                applyPSMButtonState(ds4->L1Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_L1);
+                applyPSMButtonState(ds4->L2Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_L2);
+                applyPSMButtonState(ds4->L3Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_L3);
+                applyPSMButtonState(ds4->R1Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_R1);
+                applyPSMButtonState(ds4->R2Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_R2);
+                applyPSMButtonState(ds4->R3Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_R3);
+
+                applyPSMButtonState(ds4->TriangleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIANGLE);
+                applyPSMButtonState(ds4->CircleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CIRCLE);
+                applyPSMButtonState(ds4->CrossButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CROSS);
+                applyPSMButtonState(ds4->SquareButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SQUARE);
+
+                applyPSMButtonState(ds4->ShareButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SHARE);
+                applyPSMButtonState(ds4->OptionsButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_OPTIONS);
+
+                applyPSMButtonState(ds4->PSButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_PS);
+                applyPSMButtonState(ds4->TrackPadButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRACKPAD);
+
+                ds4->LeftAnalogX = shared_state.analog_values[0];
+                ds4->LeftAnalogY = shared_state.analog_values[1];
+                ds4->RightAnalogX = shared_state.analog_values[2];
+                ds4->RightAnalogY = shared_state.analog_values[3];
+                ds4->LeftTriggerValue = shared_state.analog_values[4];
+                ds4->RightTriggerValue = shared_state.analog_values[5];
+            } break;
+
+        case PSMController_Virtual:
+            {
+                PSMVirtualController *virtual_controller= &controller->ControllerState.VirtualController;
+
+                virtual_controller->bIsTrackingEnabled = (flags & SharedDeviceStateFlag_IsTrackingEnabled) != 0;
+                virtual_controller->bIsCurrentlyTracking = (flags & SharedDeviceStateFlag_IsCurrentlyTracking) != 0;
+                virtual_controller->bIsPositionValid = (flags & SharedDeviceStateFlag_IsPositionValid) != 0;
+
+                // Virtual controllers are position only
+                virtual_controller->Pose.Orientation.w= 1.f;
+                virtual_controller->Pose.Orientation.x= 0.f;
+                virtual_controller->Pose.Orientation.y= 0.f;
+                virtual_controller->Pose.Orientation.z= 0.f;
+
+                virtual_controller->Pose.Position.x= shared_state.position_cm[0];
+                virtual_controller->Pose.Position.y= shared_state.position_cm[1];
+                virtual_controller->Pose.Position.z= shared_state.position_cm[2];
+
+                virtual_controller->vendorID= shared_state.vendor_id;
+                virtual_controller->productID= shared_state.product_id;
+
+                virtual_controller->numAxes = std::min<int>(shared_state.axis_count, PSM_MAX_VIRTUAL_CONTROLLER_AXES);
+                virtual_controller->numButtons = shared_state.button_count;
+
+                memset(virtual_controller->buttonStates, PSMButtonState_UP, sizeof(virtual_controller->buttonStates));
+                for (int button_index = 0; button_index < virtual_controller->numButtons; ++button_index)
+                {
+                    applyPSMButtonState(virtual_controller->buttonStates[button_index], button_bitmask, button_index);
+                }
+
+                memset(virtual_controller->axisStates, 0x7f, sizeof(virtual_controller->axisStates));
+                for (int axis_index = 0; axis_index < virtual_controller->numAxes; ++axis_index)
+                {
+                    virtual_controller->axisStates[axis_index]= shared_state.axis_states[axis_index];
+                }
+
+                applySharedPhysicsState(shared_state.physics, stream_flags, &virtual_controller->PhysicsData);
+                virtual_controller->PhysicsData.AngularVelocityRadPerSec = {0.f, 0.f, 0.f};
+                virtual_controller->PhysicsData.AngularAccelerationRadPerSecSqr = {0.f, 0.f, 0.f};
+            } break;
+
+        default:
+            break;
+    }
+}
+
+static void applySharedHmdState(
+	const SharedHMDState &shared_state,
+	unsigned int stream_flags,
+	PSMHeadMountedDisplay *hmd)
+{
+	// Ignore state we've already applied
+	if (shared_state.sequence_num <= hmd->OutputSequenceNum)
+		return;
+
+    // Set the generic items
+    hmd->bValid = shared_state.hmd_type != -1;
+    hmd->HmdType = static_cast<PSMHmdType>(shared_state.hmd_type);
+    hmd->OutputSequenceNum = shared_state.sequence_num;
+    hmd->IsConnected = (shared_state.state_flags & SharedDeviceStateFlag_IsConnected) != 0;
+    hmd->DataFrameSampleTimeUs = shared_state.sample_time_us;
+    hmd->DataFramePredictionTime = shared_state.prediction_time;
+
+    updateDataFrameReceiveStats(hmd->DataFrameLastReceivedTime, hmd->DataFrameAverageFPS);
+
+	// Don't bother updating the rest of the hmd state if it's not connected
+	if (!hmd->IsConnected)
+		return;
+
+    const uint32_t flags= shared_state.state_flags;
+
+    switch (hmd->HmdType) 
+	{
+        case PSMHmd_Morpheus:
+            {
+                PSMMorpheus *morpheus= &hmd->HmdState.MorpheusState;
+
+                morpheus->bIsTrackingEnabled = (flags & SharedDeviceStateFlag_IsTrackingEnabled) != 0;
+                morpheus->bIsCurrentlyTracking = (flags & SharedDeviceStateFlag_IsCurrentlyTracking) != 0;
+                morpheus->bIsOrientationValid = (flags & SharedDeviceStateFlag_IsOrientationValid) != 0;
+                morpheus->bIsPositionValid = (flags & SharedDeviceStateFlag_IsPositionValid) != 0;
+
+                applySharedPoseState(shared_state.orientation, shared_state.position_cm, &morpheus->Pose);
+                applySharedPhysicsState(shared_state.physics, stream_flags, &morpheus->PhysicsData);
+            } break;
+
+        case PSMHmd_Virtual:
+            {
+                PSMVirtualHMD *virtualHMD= &hmd->HmdState.VirtualHMDState;
+
+                virtualHMD->bIsTrackingEnabled = (flags & SharedDeviceStateFlag_IsTrackingEnabled) != 0;
+                virtualHMD->bIsCurrentlyTracking = (flags & SharedDeviceStateFlag_IsCurrentlyTracking) != 0;
+                virtualHMD->bIsPositionValid = (flags & SharedDeviceStateFlag_IsPositionValid) != 0;
+
+                // Virtual HMDs are position only
+                virtualHMD->Pose.Orientation.w = 1.f;
+                virtualHMD->Pose.Orientation.x = 0.f;
+                virtualHMD->Pose.Orientation.y = 0.f;
+                virtualHMD->Pose.Orientation.z = 0.f;
+
+                virtualHMD->Pose.Position.x = shared_state.position_cm[0];
+                virtualHMD->Pose.Position.y = shared_state.position_cm[1];
+                virtualHMD->Pose.Position.z = shared_state.position_cm[2];
+
+                applySharedPhysicsState(shared_state.physics, stream_flags, &virtualHMD->PhysicsData);
+                virtualHMD->PhysicsData.AngularVelocityRadPerSec = {0.f, 0.f, 0.f};
+                virtualHMD->PhysicsData.AngularAccelerationRadPerSecSqr = {0.f, 0.f, 0.f};
+            } break;
+
+        default:
+            break;
+    }
+}
+
+static void applySharedPhysicsState(
+	const SharedDevicePhysics &shared_physics,
+	unsigned int stream_flags,
+	PSMPhysicsData *physics_data)
+{
+    // The service always publishes the physics, but only hand it out if the stream asked for it
+    // so that the client sees the same thing it would from a UDP data frame
+    if ((stream_flags & PSMStreamFlags_includePhysicsData) > 0)
+    {
+        physics_data->LinearVelocityCmPerSec = 
+            {shared_physics.velocity_cm_per_sec[0], shared_physics.velocity_cm_per_sec[1], shared_physics.velocity_cm_per_sec[2]};
+        physics_data->LinearAccelerationCmPerSecSqr = 
+            {shared_physics.acceleration_cm_per_sec_sqr[0], shared_physics.acceleration_cm_per_sec_sqr[1], shared_physics.acceleration_cm_per_sec_sqr[2]};
+        physics_data->AngularVelocityRadPerSec = 
+            {shared_physics.angular_velocity_rad_per_sec[0], shared_physics.angular_velocity_rad_per_sec[1], shared_physics.angular_velocity_rad_per_sec[2]};
+        physics_data->AngularAccelerationRadPerSecSqr = 
+            {shared_physics.angular_acceleration_rad_per_sec_sqr[0], shared_physics.angular_acceleration_rad_per_sec_sqr[1], shared_physics.angular_acceleration_rad_per_sec_sqr[2]};
+        physics_data->TimeInSeconds= -1.0;
+    }
+    else
+    {
+        memset(physics_data, 0, sizeof(PSMPhysicsData));
+    }
+}
+
+static void applySharedPoseState(
+	const float orientation[4],
+	const float position_cm[3],
+	PSMPosef *pose)
+{
+    pose->Orientation.w= orientation[0];
+    pose->Orientation.x= orientation[1];
+    pose->Orientation.y= orientation[2];
+    pose->Orientation.z= orientation[3];
+
+    pose->Position.x= position_cm[0];
+    pose->Position.y= position_cm[1];
+    pose->Position.z= position_cm[2];
+}
+
+static void updateDataFrameReceiveStats(
+	long long &last_received_time,
+	float &average_fps)
+{
+    long long now = 
+        std::chrono::duration_cast< std::chrono::milliseconds >(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    long long diff= now - last_received_time;
+
+    if (diff > 0)
+    {
+        float seconds= static_cast<float>(diff) / 1000.f;
+        float fps= 1.f / seconds;
+
+        average_fps= (0.9f)*average_fps + (0.1f)*fps;
+    }
+
+    last_received_time= now;
+}
+
+static bool isLocalHost(const std::string &host)
+{
+    return host == "localhost" || host == "127.0.0.1" || host == "::1";
+}
+
 // INotificationListener
 void PSMoveClient::handle_notification(ResponsePtr notification)
 {
@@ -2168,6 +2913,18 @@ void PSMoveClient::handle_server_connection_opened()
 {
     CLIENT_LOG_INFO("handle_server_connection_opened") << "Connected to service" << std::endl;
 
+    // A service on this machine publishes device state we can read directly.
+    // Only polled in update(), so not worth it when the network thread keeps the snapshots fresh.
+    if (isLocalHost(m_host) && !m_bUseNetworkThread)
+    {
+        open_shared_device_state();
+    }
+
+    // Start lining the clocks up from scratch, the service may have restarted
+    m_service_clock.reset();
+    m_service_clock_request_id= PSM_INVALID_REQUEST_ID;
+    m_bIsServiceClockSyncActive= true;
+
     enqueue_event_message(PSMEventMessage::PSMEvent_connectedToService, ResponsePtr());
 }
 
@@ -2182,6 +2939,10 @@ void PSMoveClient::handle_server_connection_closed()
 {
     CLIENT_LOG_INFO("handle_server_connection_closed") << "Disconnected from service" << std::endl;
 
+    close_shared_device_state();
+
+    m_bIsServiceClockSyncActive= false;
+
     enqueue_event_message(PSMEventMessage::PSMEvent_disconnectedFromService, ResponsePtr());
 }
 
@@ -2195,6 +2956,194 @@ void PSMoveClient::handle_server_connection_socket_error(const boost::system::er
     CLIENT_LOG_ERROR("handle_server_connection_close_failed") << "Socket error: " << ec.message() << std::endl;
 }
 
+// Shared Memory Device State
+bool PSMoveClient::open_shared_device_state()
+{
+    close_shared_device_state();
+
+    SharedDeviceStateReadOnlyAccessor *accessor= new SharedDeviceStateReadOnlyAccessor();
+
+    if (accessor->initialize(SHARED_DEVICE_STATE_MEMORY_NAME))
+    {
+        CLIENT_LOG_INFO("open_shared_device_state") << "Reading device state from shared memory" << std::endl;
+        m_shared_device_state_accessor= accessor;
+    }
+    else
+    {
+        // Not fatal, device streams just fall back to UDP data frames
+        delete accessor;
+    }
+
+    return m_shared_device_state_accessor != nullptr;
+}
+
+void PSMoveClient::close_shared_device_state()
+{
+    if (m_shared_device_state_accessor != nullptr)
+    {
+        delete m_shared_device_state_accessor;
+        m_shared_device_state_accessor= nullptr;
+    }
+
+    memset(m_bControllerStreamUsesSharedMemory, 0, sizeof(m_bControllerStreamUsesSharedMemory));
+    memset(m_bHmdStreamUsesSharedMemory, 0, sizeof(m_bHmdStreamUsesSharedMemory));
+}
+
+void PSMoveClient::poll_shared_device_state()
+{
+    if (m_shared_device_state_accessor == nullptr)
+        return;
+
+    for (PSMControllerID controller_id= 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+    {
+        SharedControllerState shared_state;
+
+        if (m_bControllerStreamUsesSharedMemory[controller_id] &&
+            m_shared_device_state_accessor->readControllerState(controller_id, shared_state))
+        {
+            applySharedControllerState(
+                shared_state, m_controllerSharedMemoryStreamFlags[controller_id], &m_controllers[controller_id]);
+        }
+    }
+
+    for (PSMHmdID hmd_id= 0; hmd_id < PSMOVESERVICE_MAX_HMD_COUNT; ++hmd_id)
+    {
+        SharedHMDState shared_state;
+
+        if (m_bHmdStreamUsesSharedMemory[hmd_id] &&
+            m_shared_device_state_accessor->readHmdState(hmd_id, shared_state))
+        {
+            applySharedHmdState(shared_state, m_hmdSharedMemoryStreamFlags[hmd_id], &m_HMDs[hmd_id]);
+        }
+    }
+}
+
+// Device Snapshots
+void PSMoveClient::store_device_snapshots()
+{
+    // Only hand over the devices that got new state since the last update
+    for (PSMControllerID controller_id= 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+    {
+        const PSMController &controller= m_controllers[controller_id];
+
+        if (controller.OutputSequenceNum != m_controllerSnapshotSequenceNum[controller_id])
+        {
+            m_controller_snapshots[controller_id].storeValue(controller);
+            m_controllerSnapshotSequenceNum[controller_id]= controller.OutputSequenceNum;
+        }
+    }
+
+    for (PSMHmdID hmd_id= 0; hmd_id < PSMOVESERVICE_MAX_HMD_COUNT; ++hmd_id)
+    {
+        const PSMHeadMountedDisplay &hmd= m_HMDs[hmd_id];
+
+        if (hmd.OutputSequenceNum != m_hmdSnapshotSequenceNum[hmd_id])
+        {
+            m_hmd_snapshots[hmd_id].storeValue(hmd);
+            m_hmdSnapshotSequenceNum[hmd_id]= hmd.OutputSequenceNum;
+        }
+    }
+}
+
+void PSMoveClient::reset_controller_view(PSMControllerID controller_id, PSMController *controller)
+{
+    memset(controller, 0, sizeof(PSMController));
+    controller->ControllerID= controller_id;
+    controller->ControllerType= PSMController_None;
+
+    // The network thread resets its own copy the next time it gets a data frame for the controller
+    m_controllerViewResetCount[controller_id].fetch_add(1, std::memory_order_release);
+}
+
+void PSMoveClient::reset_hmd_view(PSMHmdID hmd_id, PSMHeadMountedDisplay *hmd)
+{
+    memset(hmd, 0, sizeof(PSMHeadMountedDisplay));
+    hmd->HmdID= hmd_id;
+    hmd->HmdType= PSMHmd_None;
+
+    m_hmdViewResetCount[hmd_id].fetch_add(1, std::memory_order_release);
+}
+
+// Called on the network thread
+PSMController *PSMoveClient::get_async_controller_view(PSMControllerID controller_id)
+{
+    PSMController *controller= &m_async_controllers[controller_id];
+    const int reset_count= m_controllerViewResetCount[controller_id].load(std::memory_order_acquire);
+
+    // Otherwise the sequence number left over from the controller's last stream
+    // would hold back every data frame of the next one
+    if (reset_count != m_asyncControllerViewResetCount[controller_id])
+    {
+        memset(controller, 0, sizeof(PSMController));
+        controller->ControllerID= controller_id;
+        controller->ControllerType= PSMController_None;
+        m_asyncControllerViewResetCount[controller_id]= reset_count;
+    }
+
+    return controller;
+}
+
+// Called on the network thread
+PSMHeadMountedDisplay *PSMoveClient::get_async_hmd_view(PSMHmdID hmd_id)
+{
+    PSMHeadMountedDisplay *hmd= &m_async_HMDs[hmd_id];
+    const int reset_count= m_hmdViewResetCount[hmd_id].load(std::memory_order_acquire);
+
+    if (reset_count != m_asyncHmdViewResetCount[hmd_id])
+    {
+        memset(hmd, 0, sizeof(PSMHeadMountedDisplay));
+        hmd->HmdID= hmd_id;
+        hmd->HmdType= PSMHmd_None;
+        m_asyncHmdViewResetCount[hmd_id]= reset_count;
+    }
+
+    return hmd;
+}
+
+// Service Clock Sync
+void PSMoveClient::update_service_clock_sync()
+{
+    if (!m_bIsServiceClockSyncActive || m_service_clock_request_id != PSM_INVALID_REQUEST_ID)
+    {
+        return;
+    }
+
+    // Fill the sample window one round trip per update, then just keep it fresh
+    const int64_t now_us= ServiceClockEstimator::getClientTimeUs();
+    if (!m_service_clock.getIsSampleWindowFull() || 
+        now_us - m_service_clock_last_sync_us >= k_service_clock_sync_interval_us)
+    {
+        RequestPtr request(new PSMoveProtocol::Request());
+        request->set_type(PSMoveProtocol::Request_RequestType_GET_SERVICE_TIME);
+
+        m_service_clock_request_sent_us= ServiceClockEstimator::getClientTimeUs();
+        m_request_manager->send_request(request);
+
+        m_service_clock_request_id= request->request_id();
+    }
+}
+
+void PSMoveClient::handle_service_time_response(const PSMResponseMessage *response_message)
+{
+    // Responses are only read in update(), so the round trip includes the time spent waiting on it.
+    // The estimator favors the quickest round trips, which waited the least.
+    const int64_t received_us= ServiceClockEstimator::getClientTimeUs();
+
+    if (response_message->result_code == PSMResult_Success)
+    {
+        const PSMoveProtocol::Response *response= 
+            reinterpret_cast<const PSMoveProtocol::Response *>(response_message->opaque_response_handle);
+
+        m_service_clock.addSample(
+            m_service_clock_request_sent_us, 
+            response->result_service_time().service_time_us(), 
+            received_us);
+    }
+
+    m_service_clock_request_id= PSM_INVALID_REQUEST_ID;
+    m_service_clock_last_sync_us= received_us;
+}
+
 // Request Manager Callback
 void PSMoveClient::handle_response_message(
     const PSMResponseMessage *response_message,
@@ -2204,9 +3153,14 @@ void PSMoveClient::handle_response_message(
 
     if (response_message->request_id != PSM_INVALID_REQUEST_ID)
     {
+        // Clock sync requests are internal, the API user never sees them
+        if (response_message->request_id == this_ptr->m_service_clock_request_id)
+        {
+            this_ptr->handle_service_time_response(response_message);
+        }
         // If there is a callback waiting to be called for this request,
         // then go ahead and execute it now.
-        if (!this_ptr->execute_callback(response_message))
+        else if (!this_ptr->execute_callback(response_message))
         {
             // Otherwise go ahead and enqueue a message that can be picked up
             // in poll_next_message() this frame.
@@ -2276,7 +3230,8 @@ void PSMoveClient::enqueue_event_message(
         // If we just add the given event smart pointer to the reference cache
         // we'll be storing a reference to the shared m_packed_response on the client network manager
         // which gets constantly overwritten with new incoming events.
-        ResponsePtr eventCopy(new PSMoveProtocol::Response(*event.get()));
+        ResponsePtr eventCopy= m_event_pool.acquire();
+        eventCopy->CopyFrom(*event.get());
 
         //NOTE: This pointer is only safe until the next update call to update is made
         message.event_data.event_data_handle = static_cast<const void *>(eventCopy.get());
@@ -4,10 +4,15 @@
 //-- includes -----
 #include "PSMoveClient_CAPI.h"
 #include "PSMoveProtocolInterface.h"
+#include "ClientAtomicPrimitives.h"
 #include "ClientNetworkInterface.h"
 #include "ClientLog.h"
+#include "ClientPosePrediction.h"
+#include "ProtocolMessagePool.h"
+#include <atomic>
 #include <deque>
 #include <map>
+#include <string>
 #include <vector>
 
 //-- typedefs -----
@@ -17,13 +22,15 @@ typedef std::vector<ResponsePtr> t_event_reference_cache;
 //-- definitions -----
 class PSMoveClient : 
     public IDataFrameListener,
+    public IAsyncDataFrameListener,
     public INotificationListener,
     public IClientNetworkEventListener
 {
 public:
     PSMoveClient(
         const std::string &host, 
-        const std::string &port);
+        const std::string &port,
+        bool bUseNetworkThread);
     virtual ~PSMoveClient();
 
 	// -- State Queries ----
@@ -43,17 +50,21 @@ public:
 
 	// -- System Requests ----
     PSMRequestID get_service_version();
+    PSMRequestID get_service_latency_stats(bool reset_stats);
+    float get_pose_extrapolation_time(long long sample_time_us, float prediction_time, double client_time_seconds) const;
 
     // -- ClientPSMoveAPI Requests -----
     bool allocate_controller_listener(PSMControllerID controller_id);
     void free_controller_listener(PSMControllerID controller_id);   
     PSMController* get_controller_view(PSMControllerID controller_id);
+    bool get_controller_snapshot(PSMControllerID controller_id, PSMController *out_controller);
     PSMRequestID get_controller_list();
     PSMRequestID start_controller_data_stream(PSMControllerID controller_id, unsigned int flags);
     PSMRequestID stop_controller_data_stream(PSMControllerID controller_id);
     PSMRequestID set_led_tracking_color(PSMControllerID controller_id, PSMTrackingColorType tracking_color);
     PSMRequestID reset_orientation(PSMControllerID controller_id, const PSMQuatf& q_pose);
     PSMRequestID set_controller_data_stream_tracker_index(PSMControllerID controller_id, PSMTrackerID tracker_id);
+    bool set_controller_data_stream_rate(PSMControllerID controller_id, float publish_rate_hz);
 	PSMRequestID set_controller_hand(PSMControllerID controller_id, PSMControllerHand controller_hand);
 
     bool allocate_tracker_listener(const PSMClientTrackerInfo &trackerInfo);
@@ -67,14 +78,17 @@ public:
 	bool poll_video_stream(PSMTrackerID tracker_id);
 	void close_video_stream(PSMTrackerID tracker_id);
 	const unsigned char *get_video_frame_buffer(PSMTrackerID tracker_id) const;
+	bool get_video_frame_info(PSMTrackerID tracker_id, int *out_frame_index, double *out_frame_age_seconds) const;
 
     bool allocate_hmd_listener(PSMHmdID HmdID);
     void free_hmd_listener(PSMHmdID HmdID);   
 	PSMHeadMountedDisplay* get_hmd_view(PSMHmdID tracker_id);
+    bool get_hmd_snapshot(PSMHmdID hmd_id, PSMHeadMountedDisplay *out_hmd);
     PSMRequestID get_hmd_list();    
     PSMRequestID start_hmd_data_stream(PSMHmdID hmd_id, unsigned int flags);
     PSMRequestID stop_hmd_data_stream(PSMHmdID hmd_id);
     PSMRequestID set_hmd_data_stream_tracker_index(PSMHmdID hmd_id, PSMTrackerID tracker_id);
+    bool set_hmd_data_stream_rate(PSMHmdID hmd_id, float publish_rate_hz);
     
     PSMRequestID send_opaque_request(PSMRequestHandle request_handle);
 
@@ -87,6 +101,11 @@ protected:
 
     // IDataFrameListener
     virtual void handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame) override;
+    virtual void handle_compact_data_frame(const CompactDataFrame *compact_frame) override;
+
+    // IAsyncDataFrameListener
+    virtual void handle_data_frame_async(const PSMoveProtocol::DeviceOutputDataFrame *data_frame) override;
+    virtual void handle_compact_data_frame_async(const CompactDataFrame *compact_frame) override;
 
     // INotificationListener
     virtual void handle_notification(ResponsePtr notification) override;
@@ -98,6 +117,25 @@ protected:
     virtual void handle_server_connection_close_failed(const boost::system::error_code& ec) override;
     virtual void handle_server_connection_socket_error(const boost::system::error_code& ec) override;
 
+    // Shared Memory Device State
+    //---------------------------
+    bool open_shared_device_state();
+    void close_shared_device_state();
+    void poll_shared_device_state();
+
+    // Device Snapshots
+    //-----------------
+    void store_device_snapshots();
+    void reset_controller_view(PSMControllerID controller_id, PSMController *controller);
+    void reset_hmd_view(PSMHmdID hmd_id, PSMHeadMountedDisplay *hmd);
+    PSMController *get_async_controller_view(PSMControllerID controller_id);
+    PSMHeadMountedDisplay *get_async_hmd_view(PSMHmdID hmd_id);
+
+    // Service Clock Sync
+    //-------------------
+    void update_service_clock_sync();
+    void handle_service_time_response(const PSMResponseMessage *response_message);
+
     // Request Manager Callback
     static void handle_response_message(const PSMResponseMessage *response_message, void *userdata);
 
@@ -114,7 +152,48 @@ private:
     
     //-- Session Management -----
     class ClientNetworkManager *m_network_manager;
+    std::string m_host;
+
+    //-- Shared Memory Device State -----
+    // Only opened when the service runs on the same host.
+    // Device streams started while it's open skip the UDP data frames and read their state from it instead.
+    class SharedDeviceStateReadOnlyAccessor *m_shared_device_state_accessor;
+    bool m_bControllerStreamUsesSharedMemory[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    unsigned int m_controllerSharedMemoryStreamFlags[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    bool m_bHmdStreamUsesSharedMemory[PSMOVESERVICE_MAX_HMD_COUNT];
+    unsigned int m_hmdSharedMemoryStreamFlags[PSMOVESERVICE_MAX_HMD_COUNT];
+
+    //-- Data Stream Rates -----
+    // Most data frames per second to ask the service for when a stream starts (0 = every state update)
+    float m_controllerDataStreamRateHz[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    float m_hmdDataStreamRateHz[PSMOVESERVICE_MAX_HMD_COUNT];
     
+    //-- Device Snapshots -----
+    // Latest controller and HMD state for a thread that doesn't call update() (like a render thread).
+    // Stored by the network thread as data frames arrive if it's enabled, otherwise at the end of update().
+    // The network thread applies the data frames to its own copy of the device views.
+    bool m_bUseNetworkThread;
+    AtomicSnapshot<PSMController> m_controller_snapshots[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    AtomicSnapshot<PSMHeadMountedDisplay> m_hmd_snapshots[PSMOVESERVICE_MAX_HMD_COUNT];
+    int m_controllerSnapshotSequenceNum[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    int m_hmdSnapshotSequenceNum[PSMOVESERVICE_MAX_HMD_COUNT];
+    PSMController m_async_controllers[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    PSMHeadMountedDisplay m_async_HMDs[PSMOVESERVICE_MAX_HMD_COUNT];
+    // Bumped by the main thread whenever it resets a device view, so the network thread resets its copy too
+    std::atomic_int m_controllerViewResetCount[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    std::atomic_int m_hmdViewResetCount[PSMOVESERVICE_MAX_HMD_COUNT];
+    int m_asyncControllerViewResetCount[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    int m_asyncHmdViewResetCount[PSMOVESERVICE_MAX_HMD_COUNT];
+
+    //-- Service Clock Sync -----
+    // Lines the client clock up with the service clock the data frame sample times are in,
+    // by timing GET_SERVICE_TIME requests that never show up as API responses.
+    ServiceClockEstimator m_service_clock;
+    PSMRequestID m_service_clock_request_id; // The outstanding GET_SERVICE_TIME request, if any
+    int64_t m_service_clock_request_sent_us;
+    int64_t m_service_clock_last_sync_us;
+    bool m_bIsServiceClockSyncActive;
+
     //-- Controller Views -----
 	PSMController m_controllers[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
 
@@ -151,6 +230,10 @@ private:
     // response and event parameter data valid until the next update call.
     // The message queue contains raw void pointers to the response and event data.
     t_event_reference_cache m_event_reference_cache;
+
+    // Recycled event copies and outgoing input data frames
+    ProtocolMessagePool<PSMoveProtocol::Response> m_event_pool;
+    ProtocolMessagePool<PSMoveProtocol::DeviceInputDataFrame> m_input_data_frame_pool;
 };
 
 
@@ -25,6 +25,7 @@ const PSMVector3f k_identity_gravity_calibration_direction= {0.f, 1.f, 0.f};
 
 // -- private data ---
 PSMoveClient *g_psm_client= nullptr;
+bool g_psm_use_network_thread= false;
 
 // -- private definitions -----
 class PSMCallbackTimeout
@@ -120,6 +121,107 @@ protected:
     PSMResponseMessage m_response;
 };
 
+// -- private methods -----
+static PSMResult get_controller_pose(const PSMController *controller, PSMPosef *out_pose)
+{
+    PSMResult result= PSMResult_Error;
+
+    switch (controller->ControllerType)
+    {
+    case PSMController_Move:
+        {
+			const PSMPSMove &State= controller->ControllerState.PSMoveState;
+			*out_pose = State.Pose;
+
+			result= (State.bIsOrientationValid && State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
+        } break;
+    case PSMController_Navi:
+        break;
+    case PSMController_DualShock4:
+        {
+			const PSMDualShock4 &State= controller->ControllerState.PSDS4State;
+			*out_pose = State.Pose;
+
+			result= (State.bIsOrientationValid && State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
+        } break;
+    case PSMController_Virtual:
+        {
+			const PSMVirtualController &State= controller->ControllerState.VirtualController;
+			*out_pose = State.Pose;
+
+			result= (State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
+        } break;
+    }
+
+    return result;
+}
+
+static const PSMPhysicsData *get_controller_physics(const PSMController *controller)
+{
+    const PSMPhysicsData *physics= nullptr;
+
+    switch (controller->ControllerType)
+    {
+    case PSMController_Move:
+        physics= &controller->ControllerState.PSMoveState.PhysicsData;
+        break;
+    case PSMController_DualShock4:
+        physics= &controller->ControllerState.PSDS4State.PhysicsData;
+        break;
+    case PSMController_Virtual:
+        physics= &controller->ControllerState.VirtualController.PhysicsData;
+        break;
+    default:
+        break;
+    }
+
+    return physics;
+}
+
+static const PSMPhysicsData *get_hmd_physics(const PSMHeadMountedDisplay *hmd)
+{
+    const PSMPhysicsData *physics= nullptr;
+
+    switch (hmd->HmdType)
+    {
+    case PSMHmd_Morpheus:
+        physics= &hmd->HmdState.MorpheusState.PhysicsData;
+        break;
+    case PSMHmd_Virtual:
+        physics= &hmd->HmdState.VirtualHMDState.PhysicsData;
+        break;
+    default:
+        break;
+    }
+
+    return physics;
+}
+
+static PSMResult get_hmd_pose(const PSMHeadMountedDisplay *hmd, PSMPosef *out_pose)
+{
+    PSMResult result= PSMResult_Error;
+
+    switch (hmd->HmdType)
+    {
+    case PSMHmd_Morpheus:
+        {
+			const PSMMorpheus &State= hmd->HmdState.MorpheusState;
+			*out_pose = State.Pose;
+
+			result= (State.bIsOrientationValid && State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
+        } break;
+    case PSMHmd_Virtual:
+        {
+			const PSMVirtualHMD &State= hmd->HmdState.VirtualHMDState;
+			*out_pose = State.Pose;
+
+			result= (State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
+        } break;
+    }
+
+    return result;
+}
+
 // -- public interface -----
 const char* PSM_GetClientVersionString()
 {
@@ -191,6 +293,25 @@ PSMResult PSM_Initialize(const char* host, const char* port, int timeout_ms)
     return result;
 }
 
+double PSM_GetClientTimeInSeconds()
+{
+    return static_cast<double>(ServiceClockEstimator::getClientTimeUs())/1000000.0;
+}
+
+PSMResult PSM_SetUseNetworkThread(bool bUseNetworkThread)
+{
+	PSMResult result= PSMResult_Error;
+
+	// The client reads this flag when it gets created
+	if (g_psm_client == nullptr)
+	{
+		g_psm_use_network_thread= bUseNetworkThread;
+		result= PSMResult_Success;
+	}
+
+	return result;
+}
+
 PSMResult PSM_InitializeAsync(const char* host, const char* port)
 {
 	PSMResult result= PSMResult_Error;
@@ -202,7 +323,7 @@ PSMResult PSM_InitializeAsync(const char* host, const char* port)
 			std::string s_host(host);
 			std::string s_port(port);
 
-			g_psm_client= new PSMoveClient(s_host, s_port);
+			g_psm_client= new PSMoveClient(s_host, s_port, g_psm_use_network_thread);
 		}
 
 		if (g_psm_client->startup(_log_severity_level_info))
@@ -245,6 +366,26 @@ PSMResult PSM_GetServiceVersionString(char *out_version_string, size_t max_versi
     return result_code;
 }
 
+PSMResult PSM_GetServiceLatencyStats(PSMServiceLatencyStats *out_latency_stats, bool reset_stats, int timeout_ms)
+{
+    PSMResult result_code= PSMResult_Error;
+
+    if (g_psm_client != nullptr && out_latency_stats != nullptr)
+    {
+	    PSMBlockingRequest request(g_psm_client->get_service_latency_stats(reset_stats));
+        result_code= request.send(timeout_ms);
+
+        if (result_code == PSMResult_Success)
+        {
+            assert(request.get_response_payload_type() == PSMResponseMessage::_responsePayloadType_ServiceLatencyStats);
+
+		    *out_latency_stats= request.get_response_message().payload.latency_stats;
+        }
+    }
+    
+    return result_code;
+}
+
 PSMResult PSM_GetServiceVersionStringAsync(PSMRequestID *out_request_id)
 {
     PSMResult result= PSMResult_Error;
@@ -264,6 +405,25 @@ PSMResult PSM_GetServiceVersionStringAsync(PSMRequestID *out_request_id)
     return result;
 }
 
+PSMResult PSM_GetServiceLatencyStatsAsync(bool reset_stats, PSMRequestID *out_request_id)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (g_psm_client != nullptr)
+    {
+        PSMRequestID req_id = g_psm_client->get_service_latency_stats(reset_stats);
+
+        if (out_request_id != nullptr)
+        {
+            *out_request_id= req_id;
+        }
+
+        result= (req_id != PSM_INVALID_REQUEST_ID) ? PSMResult_RequestSent : PSMResult_Error;
+    }
+
+    return result;
+}
+
 PSMResult PSM_Shutdown()
 {
 	PSMResult result= PSMResult_Error;
@@ -699,31 +859,61 @@ PSMResult PSM_GetControllerPose(PSMControllerID controller_id, PSMPosef *out_pos
     {
         PSMController *controller= g_psm_client->get_controller_view(controller_id);
         
-        switch (controller->ControllerType)
+        result= get_controller_pose(controller, out_pose);
+    }
+
+    return result;
+}
+
+PSMResult PSM_GetControllerPoseAtTime(PSMControllerID controller_id, double time_in_seconds, PSMPosef *out_pose)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_pose);
+
+    if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
+    {
+        const PSMController *controller= g_psm_client->get_controller_view(controller_id);
+        
+        result= get_controller_pose(controller, out_pose);
+
+        if (result == PSMResult_Success)
         {
-        case PSMController_Move:
-            {
-				PSMPSMove State= controller->ControllerState.PSMoveState;
-				*out_pose = State.Pose;
+            const float extrapolation_time= 
+                g_psm_client->get_pose_extrapolation_time(
+                    controller->DataFrameSampleTimeUs, controller->DataFramePredictionTime, time_in_seconds);
 
-				result= (State.bIsOrientationValid && State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
-            } break;
-        case PSMController_Navi:
-            break;
-        case PSMController_DualShock4:
-            {
-				PSMDualShock4 State= controller->ControllerState.PSDS4State;
-				*out_pose = State.Pose;
+            *out_pose= extrapolatePose(*out_pose, *get_controller_physics(controller), extrapolation_time);
+        }
+    }
 
-				result= (State.bIsOrientationValid && State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
-            } break;
-        case PSMController_Virtual:
-            {
-				PSMVirtualController State= controller->ControllerState.VirtualController;
-				*out_pose = State.Pose;
+    return result;
+}
 
-				result= (State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
-            } break;
+PSMResult PSM_GetControllerAtomic(PSMControllerID controller_id, PSMController *out_controller)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_controller);
+
+    if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
+    {
+        result= g_psm_client->get_controller_snapshot(controller_id, out_controller) ? PSMResult_Success : PSMResult_Error;
+    }
+
+    return result;
+}
+
+PSMResult PSM_GetControllerPoseAtomic(PSMControllerID controller_id, PSMPosef *out_pose)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_pose);
+
+    if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
+    {
+        PSMController controller;
+
+        if (g_psm_client->get_controller_snapshot(controller_id, &controller))
+        {
+            result= get_controller_pose(&controller, out_pose);
         }
     }
 
@@ -1037,6 +1227,19 @@ PSMResult PSM_SetControllerDataStreamTrackerIndex(PSMControllerID controller_id,
     return result;
 }
 
+PSMResult PSM_SetControllerDataStreamRate(PSMControllerID controller_id, float publish_rate_hz)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (g_psm_client != nullptr && 
+        g_psm_client->set_controller_data_stream_rate(controller_id, publish_rate_hz))
+    {
+        result= PSMResult_Success;
+    }
+
+    return result;
+}
+
 PSMResult PSM_SetControllerHand(PSMControllerID controller_id, PSMControllerHand hand, int timeout_ms)
 {
     PSMResult result= PSMResult_Error;
@@ -1229,6 +1432,23 @@ PSMResult PSM_GetTrackerVideoFrameBuffer(PSMTrackerID tracker_id, const unsigned
     return result;
 }
 
+PSMResult PSM_GetTrackerVideoFrameInfo(PSMTrackerID tracker_id, int *out_frame_index, double *out_frame_age_seconds)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_frame_index != nullptr);
+	assert(out_frame_age_seconds != nullptr);
+
+    if (g_psm_client != nullptr && IS_VALID_TRACKER_INDEX(tracker_id))
+    {
+		if (g_psm_client->get_video_frame_info(tracker_id, out_frame_index, out_frame_age_seconds))
+		{
+			result= PSMResult_Success;
+		}
+    }
+
+    return result;
+}
+
 PSMResult PSM_GetTrackerFrustum(PSMTrackerID tracker_id, PSMFrustum *out_frustum)
 {
     PSMResult result= PSMResult_Error;
@@ -1426,22 +1646,61 @@ PSMResult PSM_GetHmdPose(PSMHmdID hmd_id, PSMPosef *out_pose)
     {
         PSMHeadMountedDisplay *hmd= g_psm_client->get_hmd_view(hmd_id);
         
-        switch (hmd->HmdType)
+        result= get_hmd_pose(hmd, out_pose);
+    }
+
+    return result;
+}
+
+PSMResult PSM_GetHmdPoseAtTime(PSMHmdID hmd_id, double time_in_seconds, PSMPosef *out_pose)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_pose);
+
+    if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
+    {
+        const PSMHeadMountedDisplay *hmd= g_psm_client->get_hmd_view(hmd_id);
+        
+        result= get_hmd_pose(hmd, out_pose);
+
+        if (result == PSMResult_Success)
         {
-        case PSMHmd_Morpheus:
-            {
-				PSMMorpheus State= hmd->HmdState.MorpheusState;
-				*out_pose = State.Pose;
+            const float extrapolation_time= 
+                g_psm_client->get_pose_extrapolation_time(
+                    hmd->DataFrameSampleTimeUs, hmd->DataFramePredictionTime, time_in_seconds);
 
-				result= (State.bIsOrientationValid && State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
-            } break;
-        case PSMHmd_Virtual:
-            {
-				PSMVirtualHMD State= hmd->HmdState.VirtualHMDState;
-				*out_pose = State.Pose;
+            *out_pose= extrapolatePose(*out_pose, *get_hmd_physics(hmd), extrapolation_time);
+        }
+    }
 
-				result= (State.bIsPositionValid) ? PSMResult_Success : PSMResult_Error;
-            } break;
+    return result;
+}
+
+PSMResult PSM_GetHmdAtomic(PSMHmdID hmd_id, PSMHeadMountedDisplay *out_hmd)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_hmd);
+
+    if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
+    {
+        result= g_psm_client->get_hmd_snapshot(hmd_id, out_hmd) ? PSMResult_Success : PSMResult_Error;
+    }
+
+    return result;
+}
+
+PSMResult PSM_GetHmdPoseAtomic(PSMHmdID hmd_id, PSMPosef *out_pose)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_pose);
+
+    if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
+    {
+        PSMHeadMountedDisplay hmd;
+
+        if (g_psm_client->get_hmd_snapshot(hmd_id, &hmd))
+        {
+            result= get_hmd_pose(&hmd, out_pose);
         }
     }
 
@@ -1713,6 +1972,19 @@ PSMResult PSM_SetHmdDataStreamTrackerIndex(PSMHmdID hmd_id, PSMTrackerID tracker
     return result;
 }
 
+PSMResult PSM_SetHmdDataStreamRate(PSMHmdID hmd_id, float publish_rate_hz)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (g_psm_client != nullptr && 
+        g_psm_client->set_hmd_data_stream_rate(hmd_id, publish_rate_hz))
+    {
+        result= PSMResult_Success;
+    }
+
+    return result;
+}
+
 /// Async HMD Methods
 PSMResult PSM_GetHmdListAsync(PSMRequestID *out_request_id)
 {
@@ -405,6 +405,8 @@ typedef struct
     bool            IsConnected;
     long long       DataFrameLastReceivedTime;
     float           DataFrameAverageFPS;
+    long long       DataFrameSampleTimeUs;      ///< Service clock time of the filter sample the pose came from, 0 if unknown
+    float           DataFramePredictionTime;    ///< Seconds the service already predicted the pose past DataFrameSampleTimeUs
     int             ListenerCount;
 } PSMController;
 
@@ -521,6 +523,8 @@ typedef struct
     bool            IsConnected;
     long long       DataFrameLastReceivedTime;
     float           DataFrameAverageFPS;
+    long long       DataFrameSampleTimeUs;      ///< Service clock time of the filter sample the pose came from, 0 if unknown
+    float           DataFramePredictionTime;    ///< Seconds the service already predicted the pose past DataFrameSampleTimeUs
     int             ListenerCount;
 } PSMHeadMountedDisplay;
 
@@ -559,6 +563,38 @@ typedef struct
 	char version_string[PSMOVESERVICE_MAX_VERSION_STRING_LEN];
 } PSMServiceVersion;
 
+/// Latency of one stage of the PSMoveService tracking pipeline, in microseconds
+typedef struct
+{
+	char stage_name[PSMOVESERVICE_MAX_LATENCY_STAGE_NAME_LEN];
+	unsigned int sample_count;
+	unsigned int p50_us;
+	unsigned int p99_us;
+	unsigned int max_us;
+} PSMLatencyStage;
+
+/// Backlog and drops of the sensor packet queues feeding a controller's pose filter
+typedef struct
+{
+	PSMControllerID controller_id;
+	int imu_queue_depth_max;			///< Deepest IMU packet backlog one service update drained
+	int optical_queue_depth_max;		///< Deepest optical packet backlog one service update drained
+	unsigned long long imu_dropped_count;		///< IMU packets posted to a full queue
+	unsigned long long optical_dropped_count;	///< Optical packets posted to a full queue
+	unsigned long long merge_dropped_count;		///< Packets too old to feed to the filter in one update
+} PSMControllerQueueStats;
+
+/// Latency histograms for each stage of the PSMoveService tracking pipeline,
+/// from sensor report or video frame capture to the data frame being sent
+typedef struct
+{
+	PSMLatencyStage stages[PSMOVESERVICE_MAX_LATENCY_STAGE_COUNT];
+	int stage_count;
+	float message_pool_misses_per_second; ///< Misses of the service's protocol message pools, 0 once they are warm. Other heap use isn't counted.
+	PSMControllerQueueStats controller_queues[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+	int controller_queue_count;
+} PSMServiceLatencyStats;
+
 /// List of controllers attached to PSMoveService
 typedef struct
 {
@@ -617,6 +653,7 @@ typedef struct
         PSMTrackerList tracker_list;		///< Response to tracker list request
 		PSMHmdList hmd_list;				///< Response to hmd list request
         PSMTrackingSpace tracking_space;	///< Response to tracking space request
+		PSMServiceLatencyStats latency_stats;	///< Response to service latency stats request
     } payload;
 
 	/// Type of response sent from PSMoveService
@@ -628,6 +665,7 @@ typedef struct
         _responsePayloadType_TrackerList,
         _responsePayloadType_TrackingSpace,
 		_responsePayloadType_HmdList,
+		_responsePayloadType_ServiceLatencyStats,
 
         _responsePayloadType_Count
     } payload_type;
@@ -701,6 +739,26 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_Shutdown();
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_InitializeAsync(const char* host, const char* port);
 
+/** \brief Selects whether the client receives device data frames on its own network thread.
+ When enabled, controller and HMD data frames are read on an internal thread as soon as they arrive
+ and published to the wait-free snapshots read by \ref PSM_GetControllerPoseAtomic() and \ref PSM_GetHmdPoseAtomic(),
+ so a render thread sees new poses without waiting on the next \ref PSM_Update().
+ The regular controller and HMD views are still only updated by \ref PSM_Update().
+ Same-host shared memory device state is not used in this mode.
+ Disabled by default.
+
+ \remark Must be called before \ref PSM_Initialize() or \ref PSM_InitializeAsync()
+ \param bUseNetworkThread true to start a network thread with the next connection
+ \returns PSMResult_Success or PSMResult_Error if the client was already initialized.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetUseNetworkThread(bool bUseNetworkThread);
+
+/** \brief Get the client's monotonic clock time
+	The clock used by \ref PSM_GetControllerPoseAtTime() and \ref PSM_GetHmdPoseAtTime().
+	\return The current time in seconds
+ */
+PSM_PUBLIC_FUNCTION(double) PSM_GetClientTimeInSeconds();
+
 // Update
 /** \brief Poll the connection and process messages.
 	This function will poll the connection for new messages from PSMoveService.
@@ -802,6 +860,17 @@ PSM_PUBLIC_FUNCTION(bool) PSM_WasSystemButtonPressed();
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceVersionString(char *out_version_string, size_t max_version_string, int timeout_ms);
 
+/** \brief Get the latency histograms of the PSMoveService tracking pipeline
+	Sends a request to PSMoveService for the p50/p99/max latency of each pipeline stage
+	(capture, segmentation, triangulation, filter, serialization and send) since startup or the last reset.
+	\remark Blocking - Returns after either the stats are returned OR the timeout period is reached. 
+	\param[out] out_latency_stats The latency of each pipeline stage
+	\param reset_stats If true, the service clears its histograms after reporting them
+	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
+	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceLatencyStats(PSMServiceLatencyStats *out_latency_stats, bool reset_stats, int timeout_ms);
+
 // System Async Queries
 /** \brief Get the client API version string from PSMoveService
 	Sends a request to PSMoveService to get the protocol version.
@@ -816,6 +885,17 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceVersionString(char *out_version_str
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceVersionStringAsync(PSMRequestID *out_request_id);
 
+/** \brief Get the latency histograms of the PSMoveService tracking pipeline
+	\remark Async - Starts a request for the latency stats. Result obtained in one of two ways:
+	  - Register callback for request id with \ref PSM_RegisterCallback and the poll with \ref PSM_Update()
+	  - Poll with \ref PSM_UpdateNoPollMessages() and then call \ref PSM_PollNextMessage() to see if 
+	  \ref PSMServiceLatencyStats result has been received.
+	\param reset_stats If true, the service clears its histograms after reporting them
+	\param[out] out_request_id The id of the request sent to PSMoveService. Can be used to register callback with \ref PSM_RegisterCallback.
+	\return PSMResult_RequestSent on success or PSMResult_Error if there was no valid connection.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceLatencyStatsAsync(bool reset_stats, PSMRequestID *out_request_id);
+
 // Async Message Handling API
 /** \brief Retrieve the next message from the message queue.
 	A call to \ref PSM_UpdateNoPollMessages will queue messages received from PSMoveService.
@@ -973,6 +1053,17 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_ResetControllerOrientation(PSMControllerID co
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetControllerDataStreamTrackerIndex(PSMControllerID controller_id, PSMTrackerID tracker_id, int timeout_ms);
 
+/** \brief Sets the most data frames per second a controller data stream should deliver
+	PSMoveService publishes controller state as fast as it filters it, which can be much faster than
+	a client's render loop. With a rate set the service skips state updates that arrive early and sends
+	the freshest state once the next frame is due. Takes effect the next time the data stream is started.
+	\remark Non-Blocking - Doesn't send a request
+	\param controller_id The ID of the controller whose data stream rate we want to set
+	\param publish_rate_hz The target data frame rate, or 0 to get every state update (the default)
+	\return PSMResult_Success or PSMResult_Error if the controller id or rate was invalid
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetControllerDataStreamRate(PSMControllerID controller_id, float publish_rate_hz);
+
 /** \brief Requests setting the hand assigned to a controller
 	This request is used to set the suggested hand for a controller.
 	Hand information is used by external APIs and not by PSMoveService.
@@ -1007,6 +1098,39 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerPosition(PSMControllerID control
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerPose(PSMControllerID controller_id, PSMPosef *out_pose);
 
+/** \brief Get the pose of a controller extrapolated to the given client time
+	The pose is extrapolated from the service's filter sample with the controller's linear and angular 
+	velocity and acceleration, using the clock offset the client measures over the service connection.
+	Use it to predict a pose to when a frame will reach the display.
+	Without PSMStreamFlags_includePhysicsData on the stream there is no motion to extrapolate with
+	and this returns the same pose as \ref PSM_GetControllerPose().
+	\remark The pose is extrapolated at most 0.1 seconds away from the pose the service published
+	\param controller_id The id of the controller
+	\param time_in_seconds The time to predict the pose at, in \ref PSM_GetClientTimeInSeconds() time
+	\param[out] out_pose The extrapolated pose of the controller
+	\return PSMResult_Success if controller has a valid pose
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerPoseAtTime(PSMControllerID controller_id, double time_in_seconds, PSMPosef *out_pose);
+
+/** \brief Get a copy of the latest controller state published to the controller's snapshot
+	Wait-free, so it's safe to call from a render thread while another thread runs \ref PSM_Update().
+	The snapshot is refreshed by the network thread (see \ref PSM_SetUseNetworkThread()) or else by \ref PSM_Update().
+	\remark Only one thread at a time may read the snapshot of a given controller
+	\param controller_id The id of the controller
+	\param[out] out_controller A copy of the controller state
+	\return PSMResult_Success if a controller state was published since the controller started streaming
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerAtomic(PSMControllerID controller_id, PSMController *out_controller);
+
+/** \brief Get the latest pose of a controller from the controller's snapshot
+	Same as \ref PSM_GetControllerPose() but reads the wait-free snapshot (see \ref PSM_GetControllerAtomic()).
+	\remark Only one thread at a time may read the snapshot of a given controller
+	\param controller_id The id of the controller
+	\param[out] out_pose The pose of the controller
+	\return PSMResult_Success if controller has a valid pose
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerPoseAtomic(PSMControllerID controller_id, PSMPosef *out_pose);
+
 /** \brief Get the current rumble fraction of a controller
 	\param controller_id The id of the controller
 	\param channel The channel to get the rumble for. The PSMove has one channel. The DualShock4 has two.
@@ -1313,6 +1437,16 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_CloseTrackerVideoStream(PSMTrackerID tracker_
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetTrackerVideoFrameBuffer(PSMTrackerID tracker_id, const unsigned char **out_buffer); 
 
+/** \brief Fetch the sequence number and age of the last video frame read from an opened tracker video stream
+	The frame age is the time since PSMoveService published the frame into the shared memory buffer.
+	Gaps in the frame index mean frames were published faster than \ref PSM_PollTrackerVideoStream was called.
+	\param tracker_id The tracker to get the video frame info for
+	\param[out] out_frame_index The sequence number of the last video frame read
+	\param[out] out_frame_age_seconds The age of the last video frame read in seconds
+	\return PSMResult_Success if a video frame has been read
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetTrackerVideoFrameInfo(PSMTrackerID tracker_id, int *out_frame_index, double *out_frame_age_seconds);
+
 /** \brief Helper function to fetch tracking frustum properties from a tracker
 	\param The id of the tracker we wish to get the tracking frustum properties for
 	\param out_frustum The tracking frustum properties to write the result into
@@ -1420,6 +1554,34 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdPosition(PSMHmdID hmd_id, PSMVector3f *
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdPose(PSMHmdID hmd_id, PSMPosef *out_pose);
 
+/** \brief Get the pose of an HMD extrapolated to the given client time
+	Same as \ref PSM_GetControllerPoseAtTime() for an HMD.
+	\param hmd_id The id of the HMD
+	\param time_in_seconds The time to predict the pose at, in \ref PSM_GetClientTimeInSeconds() time
+	\param[out] out_pose The extrapolated pose of the HMD
+	\return PSMResult_Success if HMD has a valid pose
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdPoseAtTime(PSMHmdID hmd_id, double time_in_seconds, PSMPosef *out_pose);
+
+/** \brief Get a copy of the latest HMD state published to the HMD's snapshot
+	Wait-free, so it's safe to call from a render thread while another thread runs \ref PSM_Update().
+	The snapshot is refreshed by the network thread (see \ref PSM_SetUseNetworkThread()) or else by \ref PSM_Update().
+	\remark Only one thread at a time may read the snapshot of a given HMD
+	\param hmd_id The id of the HMD
+	\param[out] out_hmd A copy of the HMD state
+	\return PSMResult_Success if an HMD state was published since the HMD started streaming
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdAtomic(PSMHmdID hmd_id, PSMHeadMountedDisplay *out_hmd);
+
+/** \brief Get the latest pose of an HMD from the HMD's snapshot
+	Same as \ref PSM_GetHmdPose() but reads the wait-free snapshot (see \ref PSM_GetHmdAtomic()).
+	\remark Only one thread at a time may read the snapshot of a given HMD
+	\param hmd_id The id of the HMD
+	\param[out] out_pose The pose of the HMD
+	\return PSMResult_Success if HMD has a valid pose
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdPoseAtomic(PSMHmdID hmd_id, PSMPosef *out_pose);
+
 /** \brief Helper used to tell if the HMD is upright on a level surface.
 	This method is used as a calibration helper when you want to get a number of HMD samples. 
 	Often in this instance you want to make sure the HMD is sitting upright on a table.
@@ -1527,6 +1689,16 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_StopHmdDataStream(PSMHmdID hmd_id, int timeou
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetHmdDataStreamTrackerIndex(PSMHmdID hmd_id, PSMTrackerID tracker_id, int timeout_ms);
 
+/** \brief Sets the most data frames per second an HMD data stream should deliver
+	Works the same way as \ref PSM_SetControllerDataStreamRate.
+	Takes effect the next time the data stream is started.
+	\remark Non-Blocking - Doesn't send a request
+	\param hmd_id The ID of the HMD whose data stream rate we want to set
+	\param publish_rate_hz The target data frame rate, or 0 to get every state update (the default)
+	\return PSMResult_Success or PSMResult_Error if the HMD id or rate was invalid
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetHmdDataStreamRate(PSMHmdID hmd_id, float publish_rate_hz);
+
 // Async HMD Methods
 /** \brief Requests a list of the HMDs currently connected to PSMoveService.
 	Sends a request to PSMoveService to get the list of HMDs.
@@ -4,6 +4,16 @@
 #include "Eigen/Dense"
 #include <iostream>
 
+//-- prototypes -----
+static double compute_weighted_reprojection_error(
+	const Eigen::Matrix<float, 3, 4> *projection_matrices,
+	const Eigen::Vector2f *screen_locations,
+	const float *weights,
+	const int view_count,
+	const Eigen::Vector3d &position,
+	Eigen::Matrix3d *out_JTJ,
+	Eigen::Vector3d *out_JTr);
+
 //-- public methods -----
 Eigen::Quaternionf
 eigen_alignment_quaternion_between_vectors(const Eigen::Vector3f &from, const Eigen::Vector3f &to)
@@ -1209,4 +1219,158 @@ eigen_alignment_compute_camera_fundamental_matrix(
 
 	// Compute the fundamental matrix from camera A to camera B
 	F_ab = Kb.inverse().transpose() * E * Ka.inverse();
-}
\ No newline at end of file
+}
+
+bool
+eigen_alignment_triangulate_weighted_n_view(
+	const Eigen::Matrix<float, 3, 4> *projection_matrices,
+	const Eigen::Vector2f *screen_locations,
+	const float *weights,
+	const int view_count,
+	const int refinement_iterations,
+	Eigen::Vector3f *out_position)
+{
+	// Accumulate the normal equations A^T*W*A of the homogeneous DLT system.
+	// Each view contributes the rows x*P3 - P1 and y*P3 - P2, scaled to unit length
+	// so that the weights alone decide how much each view counts.
+	Eigen::Matrix4d ATA = Eigen::Matrix4d::Zero();
+	int used_view_count = 0;
+
+	for (int view_index = 0; view_index < view_count; ++view_index)
+	{
+		const double weight = (weights != nullptr) ? static_cast<double>(weights[view_index]) : 1.0;
+		if (weight <= 0.0)
+		{
+			continue;
+		}
+
+		const Eigen::Matrix<double, 3, 4> P = projection_matrices[view_index].cast<double>();
+		const Eigen::Vector2d screen_location = screen_locations[view_index].cast<double>();
+
+		for (int axis = 0; axis < 2; ++axis)
+		{
+			Eigen::Matrix<double, 1, 4> row = screen_location(axis) * P.row(2) - P.row(axis);
+			const double row_length = row.norm();
+
+			if (row_length > k_real64_epsilon)
+			{
+				row /= row_length;
+				ATA.noalias() += weight * row.transpose() * row;
+			}
+		}
+
+		++used_view_count;
+	}
+
+	if (used_view_count < 2)
+	{
+		return false;
+	}
+
+	// The homogeneous position is the eigenvector with the smallest eigenvalue (they're sorted ascending)
+	const Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> eigen_solver(ATA);
+	if (eigen_solver.info() != Eigen::Success)
+	{
+		return false;
+	}
+
+	const Eigen::Vector4d homogeneous_position = eigen_solver.eigenvectors().col(0);
+	if (fabs(homogeneous_position.w()) <= k_real64_epsilon)
+	{
+		// Parallel rays, so the point is at infinity
+		return false;
+	}
+
+	Eigen::Vector3d position = homogeneous_position.head<3>() / homogeneous_position.w();
+
+	// Refine the algebraic solution with Gauss-Newton steps on the reprojection error.
+	// Steps that don't lower the error are thrown away.
+	Eigen::Matrix3d JTJ;
+	Eigen::Vector3d JTr;
+	double error = 
+		compute_weighted_reprojection_error(
+			projection_matrices, screen_locations, weights, view_count, position, &JTJ, &JTr);
+
+	for (int iteration = 0; iteration < refinement_iterations; ++iteration)
+	{
+		const Eigen::Vector3d step = JTJ.ldlt().solve(-JTr);
+		if (!step.allFinite())
+		{
+			break;
+		}
+
+		const Eigen::Vector3d new_position = position + step;
+		Eigen::Matrix3d new_JTJ;
+		Eigen::Vector3d new_JTr;
+		const double new_error = 
+			compute_weighted_reprojection_error(
+				projection_matrices, screen_locations, weights, view_count, new_position, &new_JTJ, &new_JTr);
+
+		if (!(new_error < error))
+		{
+			break;
+		}
+
+		position = new_position;
+		error = new_error;
+		JTJ = new_JTJ;
+		JTr = new_JTr;
+
+		if (step.squaredNorm() <= k_real64_positional_epsilon*k_real64_positional_epsilon)
+		{
+			break;
+		}
+	}
+
+	*out_position = position.cast<float>();
+
+	return eigen_vector3f_is_valid(*out_position);
+}
+
+//-- private methods -----
+// Returns the weighted sum of the squared reprojection errors at the given position,
+// along with the Gauss-Newton normal equations (J^T*W*J and J^T*W*r) for it
+static double compute_weighted_reprojection_error(
+	const Eigen::Matrix<float, 3, 4> *projection_matrices,
+	const Eigen::Vector2f *screen_locations,
+	const float *weights,
+	const int view_count,
+	const Eigen::Vector3d &position,
+	Eigen::Matrix3d *out_JTJ,
+	Eigen::Vector3d *out_JTr)
+{
+	double error = 0.0;
+
+	out_JTJ->setZero();
+	out_JTr->setZero();
+
+	for (int view_index = 0; view_index < view_count; ++view_index)
+	{
+		const double weight = (weights != nullptr) ? static_cast<double>(weights[view_index]) : 1.0;
+		if (weight <= 0.0)
+		{
+			continue;
+		}
+
+		const Eigen::Matrix<double, 3, 4> P = projection_matrices[view_index].cast<double>();
+		const Eigen::Vector3d h = P.leftCols<3>() * position + P.col(3);
+		if (fabs(h.z()) <= k_real64_epsilon)
+		{
+			continue;
+		}
+
+		const Eigen::Vector2d projection = h.head<2>() / h.z();
+		const Eigen::Vector2d residual = projection - screen_locations[view_index].cast<double>();
+
+		// Derivative of the projection with respect to the position
+		Eigen::Matrix<double, 2, 3> J;
+		J.row(0) = (P.block<1, 3>(0, 0) - projection.x() * P.block<1, 3>(2, 0)) / h.z();
+		J.row(1) = (P.block<1, 3>(1, 0) - projection.y() * P.block<1, 3>(2, 0)) / h.z();
+
+		error += weight * residual.squaredNorm();
+		out_JTJ->noalias() += weight * J.transpose() * J;
+		out_JTr->noalias() += weight * J.transpose() * residual;
+	}
+
+	return error;
+}
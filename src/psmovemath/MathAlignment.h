@@ -188,4 +188,19 @@ eigen_alignment_compute_camera_fundamental_matrix(
 	const Eigen::Matrix3f &Kb, // intrinsic matrix of camera B
 	Eigen::Matrix3f &F_ab); // Output Fundamental matric F_ab
 
+// Triangulate the world position of a point seen by any number of cameras at once.
+// Solves the weighted linear least squares (DLT) system built from every view,
+// then optionally refines the result with Gauss-Newton steps on the weighted reprojection error.
+// * projection_matrices are the 3x4 pinhole (intrinsic * extrinsic) matrices of the cameras
+// * weights can be nullptr for equal weights, otherwise views with a weight <= 0 are ignored
+// * Needs at least two usable views. Nothing is allocated.
+bool
+eigen_alignment_triangulate_weighted_n_view(
+	const Eigen::Matrix<float, 3, 4> *projection_matrices,
+	const Eigen::Vector2f *screen_locations,
+	const float *weights,
+	const int view_count,
+	const int refinement_iterations,
+	Eigen::Vector3f *out_position);
+
 #endif // MATH_UTILITY_H
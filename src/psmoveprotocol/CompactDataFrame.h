@@ -0,0 +1,356 @@
+#ifndef COMPACT_DATA_FRAME_H
+#define COMPACT_DATA_FRAME_H
+
+//-- includes -----
+#include "SharedDeviceState.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//-- constants -----
+// First byte of a compact data frame.
+// A protobuf data frame starts with its big endian length, which is always under MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE,
+// so its first byte is zero and both kinds of data frames can be mixed in one datagram.
+#define COMPACT_DATA_FRAME_MARKER 0xC5
+
+// Bumped whenever the layout of CompactDataFrame changes
+#define COMPACT_DATA_FRAME_VERSION 2
+
+// Quantization steps of the fixed point fields
+#define COMPACT_DATA_FRAME_POSITION_CM_PER_UNIT             0.05f   // +/-16m
+#define COMPACT_DATA_FRAME_VELOCITY_CM_PER_UNIT             0.1f    // +/-32m/s
+#define COMPACT_DATA_FRAME_ACCELERATION_CM_PER_UNIT         1.f     // +/-327m/s^2
+#define COMPACT_DATA_FRAME_ANGULAR_VELOCITY_RAD_PER_UNIT    0.001f  // +/-32rad/s
+#define COMPACT_DATA_FRAME_ANGULAR_ACCELERATION_RAD_PER_UNIT 0.01f  // +/-327rad/s^2
+
+enum eCompactDataFrameDeviceCategory
+{
+    CompactDataFrameDevice_Controller= 0,
+    CompactDataFrameDevice_HMD= 1,
+};
+
+// Which of the optional sections of a compact data frame were filled in
+enum eCompactDataFrameSections
+{
+    CompactDataFrameSection_Orientation=    1 << 0,
+    CompactDataFrameSection_Position=       1 << 1,
+    CompactDataFrameSection_Physics=        1 << 2,
+    CompactDataFrameSection_Buttons=        1 << 3,
+    CompactDataFrameSection_Analog=         1 << 4,
+};
+
+//-- definitions -----
+/// A fixed size alternative to a protobuf DeviceOutputDataFrame for the pose streams of
+/// PSMove, PSNavi and DualShock4 controllers and of HMDs (72 bytes, pinned by the static_assert after it, vs ~200 bytes with physics).
+/// The orientation is sent "smallest three" encoded in 32 bits and the position and physics are 16 bit fixed point.
+/// The frame is memcpy'd on and off the wire as is, which makes it little endian on every platform we support.
+/// Streams that want sensor or tracker data, and virtual controllers, keep using protobuf data frames.
+#pragma pack(push, 1)
+struct CompactDataFrame
+{
+    // Header, the same size as a PackedMessage header
+    uint8_t marker;         // COMPACT_DATA_FRAME_MARKER
+    uint8_t version;        // COMPACT_DATA_FRAME_VERSION
+    uint16_t frame_size;    // sizeof(CompactDataFrame), lets readers skip frames of other versions
+
+    uint8_t device_category;    // eCompactDataFrameDeviceCategory
+    uint8_t device_id;
+    int8_t device_type;         // PSMoveProtocol::ControllerType or HMDType
+    uint8_t section_flags;      // eCompactDataFrameSections
+    int32_t sequence_num;
+    uint16_t state_flags;       // eSharedDeviceStateFlags
+    uint8_t battery_value;
+    uint8_t reserved;
+
+    uint32_t orientation;       // smallest three: index of the dropped component in the top 2 bits, 3x10 bit components
+    int16_t position[3];
+    int16_t velocity[3];
+    int16_t acceleration[3];
+    int16_t angular_velocity[3];
+    int16_t angular_acceleration[3];
+
+    uint32_t button_down_bitmask;
+    // PSMove: [trigger], PSNavi: [trigger, stick x, stick y],
+    // DualShock4: [left x, left y, right x, right y, left trigger, right trigger] mapped to [0, 255]
+    uint8_t analog_values[SHARED_CONTROLLER_ANALOG_VALUE_COUNT];
+
+    int64_t sample_time_us;     // service clock time of the newest sample the pose filter processed
+    float prediction_time;      // seconds the pose was predicted past sample_time_us
+
+    /// True if the buffer starts with a compact data frame (protobuf data frames start with a zero byte)
+    static bool isCompactDataFrame(const uint8_t *buffer, size_t buffer_size)
+    {
+        return buffer_size >= 1 && buffer[0] == COMPACT_DATA_FRAME_MARKER;
+    }
+
+    /// The size of the compact data frame at the start of the buffer, from its header.
+    /// Lets a reader skip frames of other versions. Returns 0 if the header is malformed.
+    static size_t getFrameSize(const uint8_t *buffer, size_t buffer_size)
+    {
+        uint16_t size= 0;
+
+        if (buffer_size >= 4)
+        {
+            std::memcpy(&size, buffer + 2, sizeof(size));
+        }
+
+        return (size >= 4 && size <= buffer_size) ? static_cast<size_t>(size) : 0;
+    }
+
+    /// Copies a compact data frame off the wire. Fails if it's truncated or from a different version.
+    static bool unpack(const uint8_t *buffer, size_t buffer_size, CompactDataFrame &out_frame)
+    {
+        if (buffer_size < sizeof(CompactDataFrame))
+            return false;
+
+        std::memcpy(&out_frame, buffer, sizeof(CompactDataFrame));
+
+        return out_frame.marker == COMPACT_DATA_FRAME_MARKER &&
+                out_frame.version == COMPACT_DATA_FRAME_VERSION &&
+                out_frame.frame_size == sizeof(CompactDataFrame);
+    }
+
+    void encodeControllerState(int controller_id, const SharedControllerState &state, bool bIncludePhysics)
+    {
+        encodeHeader(CompactDataFrameDevice_Controller, controller_id, state.controller_type, state.sequence_num, state.state_flags);
+
+        // The PSNavi has no pose
+        if (state.controller_type != k_psnavi_controller_type)
+        {
+            encodePose(state.orientation, state.position_cm);
+            sample_time_us= state.sample_time_us;
+            prediction_time= state.prediction_time;
+
+            if (bIncludePhysics)
+            {
+                encodePhysics(state.physics);
+            }
+        }
+
+        section_flags|= CompactDataFrameSection_Buttons | CompactDataFrameSection_Analog;
+        button_down_bitmask= state.button_down_bitmask;
+        battery_value= static_cast<uint8_t>(state.battery_value);
+
+        for (int analog_index = 0; analog_index < SHARED_CONTROLLER_ANALOG_VALUE_COUNT; ++analog_index)
+        {
+            analog_values[analog_index]= encodeAnalogValue(state.controller_type, analog_index, state.analog_values[analog_index]);
+        }
+    }
+
+    void encodeHmdState(int hmd_id, const SharedHMDState &state, bool bIncludePhysics)
+    {
+        encodeHeader(CompactDataFrameDevice_HMD, hmd_id, state.hmd_type, state.sequence_num, state.state_flags);
+        encodePose(state.orientation, state.position_cm);
+        sample_time_us= state.sample_time_us;
+        prediction_time= state.prediction_time;
+
+        if (bIncludePhysics)
+        {
+            encodePhysics(state.physics);
+        }
+    }
+
+    void decodeControllerState(SharedControllerState &out_state) const
+    {
+        std::memset(&out_state, 0, sizeof(SharedControllerState));
+
+        out_state.controller_type= device_type;
+        out_state.sequence_num= sequence_num;
+        out_state.state_flags= state_flags;
+        decodePose(out_state.orientation, out_state.position_cm);
+        decodePhysics(out_state.physics);
+        out_state.sample_time_us= sample_time_us;
+        out_state.prediction_time= prediction_time;
+
+        out_state.button_down_bitmask= button_down_bitmask;
+        out_state.battery_value= battery_value;
+
+        for (int analog_index = 0; analog_index < SHARED_CONTROLLER_ANALOG_VALUE_COUNT; ++analog_index)
+        {
+            out_state.analog_values[analog_index]= decodeAnalogValue(device_type, analog_index, analog_values[analog_index]);
+        }
+    }
+
+    void decodeHmdState(SharedHMDState &out_state) const
+    {
+        std::memset(&out_state, 0, sizeof(SharedHMDState));
+
+        out_state.hmd_type= device_type;
+        out_state.sequence_num= sequence_num;
+        out_state.state_flags= state_flags;
+        decodePose(out_state.orientation, out_state.position_cm);
+        decodePhysics(out_state.physics);
+        out_state.sample_time_us= sample_time_us;
+        out_state.prediction_time= prediction_time;
+    }
+
+    /// Packs a unit quaternion (w, x, y, z) into 32 bits by dropping its largest component,
+    /// which is recovered from the unit length. The other three are in [-1/sqrt(2), 1/sqrt(2)].
+    static uint32_t encodeQuaternion(const float q[4])
+    {
+        int largest_index= 0;
+        for (int i = 1; i < 4; ++i)
+        {
+            if (std::fabs(q[i]) > std::fabs(q[largest_index]))
+            {
+                largest_index= i;
+            }
+        }
+
+        // q and -q are the same rotation, flip it so the dropped component is positive
+        const float sign= (q[largest_index] < 0.f) ? -1.f : 1.f;
+
+        uint32_t packed= static_cast<uint32_t>(largest_index) << 30;
+        int shift= 20;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (i != largest_index)
+            {
+                const float normalized= (sign*q[i]*k_sqrt2 + 1.f) * 0.5f; // [0, 1]
+                const uint32_t quantized=
+                    static_cast<uint32_t>(clamp(std::floor(normalized*k_quaternion_component_max + 0.5f), 0.f, k_quaternion_component_max));
+
+                packed|= quantized << shift;
+                shift-= 10;
+            }
+        }
+
+        return packed;
+    }
+
+    static void decodeQuaternion(uint32_t packed, float out_q[4])
+    {
+        const int largest_index= static_cast<int>(packed >> 30);
+
+        float sum_squares= 0.f;
+        int shift= 20;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (i != largest_index)
+            {
+                const float normalized= static_cast<float>((packed >> shift) & 0x3ff) / k_quaternion_component_max;
+
+                out_q[i]= (normalized*2.f - 1.f) / k_sqrt2;
+                sum_squares+= out_q[i]*out_q[i];
+                shift-= 10;
+            }
+        }
+
+        out_q[largest_index]= std::sqrt(std::max(1.f - sum_squares, 0.f));
+    }
+
+private:
+    static constexpr int k_psnavi_controller_type= 1; // PSMoveProtocol::PSNAVI
+    static constexpr int k_psdualshock4_controller_type= 2; // PSMoveProtocol::PSDUALSHOCK4
+    static constexpr float k_sqrt2= 1.41421356f;
+    static constexpr float k_quaternion_component_max= 1023.f;
+
+    void encodeHeader(eCompactDataFrameDeviceCategory category, int id, int type, int32_t sequence, uint32_t flags)
+    {
+        std::memset(this, 0, sizeof(CompactDataFrame));
+
+        marker= COMPACT_DATA_FRAME_MARKER;
+        version= COMPACT_DATA_FRAME_VERSION;
+        frame_size= static_cast<uint16_t>(sizeof(CompactDataFrame));
+        device_category= static_cast<uint8_t>(category);
+        device_id= static_cast<uint8_t>(id);
+        device_type= static_cast<int8_t>(type);
+        sequence_num= sequence;
+        state_flags= static_cast<uint16_t>(flags);
+    }
+
+    void encodePose(const float in_orientation[4], const float in_position_cm[3])
+    {
+        section_flags|= CompactDataFrameSection_Orientation | CompactDataFrameSection_Position;
+        orientation= encodeQuaternion(in_orientation);
+        encodeVector(in_position_cm, COMPACT_DATA_FRAME_POSITION_CM_PER_UNIT, position);
+    }
+
+    void encodePhysics(const SharedDevicePhysics &physics)
+    {
+        section_flags|= CompactDataFrameSection_Physics;
+        encodeVector(physics.velocity_cm_per_sec, COMPACT_DATA_FRAME_VELOCITY_CM_PER_UNIT, velocity);
+        encodeVector(physics.acceleration_cm_per_sec_sqr, COMPACT_DATA_FRAME_ACCELERATION_CM_PER_UNIT, acceleration);
+        encodeVector(physics.angular_velocity_rad_per_sec, COMPACT_DATA_FRAME_ANGULAR_VELOCITY_RAD_PER_UNIT, angular_velocity);
+        encodeVector(physics.angular_acceleration_rad_per_sec_sqr, COMPACT_DATA_FRAME_ANGULAR_ACCELERATION_RAD_PER_UNIT, angular_acceleration);
+    }
+
+    void decodePose(float out_orientation[4], float out_position_cm[3]) const
+    {
+        if ((section_flags & CompactDataFrameSection_Orientation) != 0)
+        {
+            decodeQuaternion(orientation, out_orientation);
+        }
+        else
+        {
+            out_orientation[0]= 1.f;
+            out_orientation[1]= out_orientation[2]= out_orientation[3]= 0.f;
+        }
+
+        if ((section_flags & CompactDataFrameSection_Position) != 0)
+        {
+            decodeVector(position, COMPACT_DATA_FRAME_POSITION_CM_PER_UNIT, out_position_cm);
+        }
+    }
+
+    void decodePhysics(SharedDevicePhysics &out_physics) const
+    {
+        if ((section_flags & CompactDataFrameSection_Physics) != 0)
+        {
+            decodeVector(velocity, COMPACT_DATA_FRAME_VELOCITY_CM_PER_UNIT, out_physics.velocity_cm_per_sec);
+            decodeVector(acceleration, COMPACT_DATA_FRAME_ACCELERATION_CM_PER_UNIT, out_physics.acceleration_cm_per_sec_sqr);
+            decodeVector(angular_velocity, COMPACT_DATA_FRAME_ANGULAR_VELOCITY_RAD_PER_UNIT, out_physics.angular_velocity_rad_per_sec);
+            decodeVector(angular_acceleration, COMPACT_DATA_FRAME_ANGULAR_ACCELERATION_RAD_PER_UNIT, out_physics.angular_acceleration_rad_per_sec_sqr);
+        }
+    }
+
+    static void encodeVector(const float v[3], float units_per_step, int16_t out_v[3])
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            out_v[i]= static_cast<int16_t>(clamp(std::floor(v[i]/units_per_step + 0.5f), -32767.f, 32767.f));
+        }
+    }
+
+    static void decodeVector(const int16_t v[3], float units_per_step, float out_v[3])
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            out_v[i]= static_cast<float>(v[i])*units_per_step;
+        }
+    }
+
+    // The PSMove and PSNavi analog values already are bytes, the DualShock4 ones are [-1, 1] sticks and [0, 1] triggers
+    static uint8_t encodeAnalogValue(int controller_type, int analog_index, float value)
+    {
+        if (controller_type == k_psdualshock4_controller_type)
+        {
+            value= (analog_index < 4) ? (value + 1.f)*127.5f : value*255.f;
+        }
+
+        return static_cast<uint8_t>(clamp(std::floor(value + 0.5f), 0.f, 255.f));
+    }
+
+    static float decodeAnalogValue(int controller_type, int analog_index, uint8_t value)
+    {
+        if (controller_type == k_psdualshock4_controller_type)
+        {
+            return (analog_index < 4) ? static_cast<float>(value)/127.5f - 1.f : static_cast<float>(value)/255.f;
+        }
+
+        return static_cast<float>(value);
+    }
+
+    static float clamp(float value, float min_value, float max_value)
+    {
+        return std::min(std::max(value, min_value), max_value);
+    }
+};
+#pragma pack(pop)
+
+static_assert(sizeof(CompactDataFrame) == 72, "CompactDataFrame wire layout changed, bump COMPACT_DATA_FRAME_VERSION");
+
+#endif // COMPACT_DATA_FRAME_H
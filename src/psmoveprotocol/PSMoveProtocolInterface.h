@@ -26,6 +26,7 @@ namespace PSMoveProtocol
 	class Request;
 	class Response;
 };
+struct CompactDataFrame;
 
 typedef std::shared_ptr<PSMoveProtocol::DeviceOutputDataFrame> DeviceOutputDataFramePtr;
 typedef std::shared_ptr<PSMoveProtocol::DeviceInputDataFrame> DeviceInputDataFramePtr;
@@ -43,6 +44,7 @@ class IDataFrameListener
 {
 public:
     virtual void handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame) = 0;
+    virtual void handle_compact_data_frame(const CompactDataFrame *compact_frame) = 0;
 };
 
 class IResponseListener
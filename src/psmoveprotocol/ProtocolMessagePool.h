@@ -0,0 +1,132 @@
+#ifndef PROTOCOL_MESSAGE_POOL_H
+#define PROTOCOL_MESSAGE_POOL_H
+
+//-- includes -----
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+//-- constants -----
+// Messages a pool holds on to for reuse. Any more in flight at once get allocated and freed as usual.
+#define PROTOCOL_MESSAGE_POOL_DEFAULT_CAPACITY 16
+
+//-- definitions -----
+/// Counts the pool misses of every ProtocolMessagePool in the process, i.e. the messages they had to allocate.
+/// Once the pools are warm this stops moving. It only sees the pooled messages though,
+/// not any other heap use (like the handlers queued between the network threads).
+inline std::atomic<uint64_t> &getProtocolMessagePoolMissCounter()
+{
+    static std::atomic<uint64_t> s_pool_miss_count(0);
+    return s_pool_miss_count;
+}
+
+/// Recycles protocol messages (or anything else with a protobuf style Clear()) handed out by shared pointer.
+/// The pool keeps a reference to every message it made, so a message is free again
+/// when the pool's reference is the only one left. The message and its shared_ptr control block
+/// both get reused, and Clear() keeps the capacity of strings and repeated fields,
+/// so acquiring from a warm pool doesn't allocate at all.
+/// Only call acquire() from one thread. The messages it hands out can be released on any thread.
+template<typename t_message_type>
+class ProtocolMessagePool
+{
+public:
+    ProtocolMessagePool(size_t capacity= PROTOCOL_MESSAGE_POOL_DEFAULT_CAPACITY)
+        : m_messages()
+        , m_capacity(capacity)
+        , m_nextIndex(0)
+        , m_allocationCount(0)
+    {
+        m_messages.reserve(capacity);
+    }
+
+    /// Returns a cleared message that no one else references
+    std::shared_ptr<t_message_type> acquire()
+    {
+        const size_t message_count= m_messages.size();
+
+        // Start after the last message handed out, which is the least likely one to be free yet
+        for (size_t probe = 0; probe < message_count; ++probe)
+        {
+            const size_t index= (m_nextIndex + probe) % message_count;
+
+            if (m_messages[index].use_count() == 1)
+            {
+                // Pairs with the release of the last outside reference,
+                // so whatever that thread did to the message is done before we touch it
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                m_nextIndex= (index + 1) % message_count;
+                m_messages[index]->Clear();
+
+                return m_messages[index];
+            }
+        }
+
+        std::shared_ptr<t_message_type> message= std::make_shared<t_message_type>();
+
+        ++m_allocationCount;
+        getProtocolMessagePoolMissCounter().fetch_add(1, std::memory_order_relaxed);
+
+        if (m_messages.size() < m_capacity)
+        {
+            m_messages.push_back(message);
+        }
+
+        return message;
+    }
+
+    /// The number of messages this pool has had to allocate
+    inline uint64_t getAllocationCount() const { return m_allocationCount; }
+    /// The number of messages the pool holds on to, in use or not
+    inline size_t getPooledMessageCount() const { return m_messages.size(); }
+
+private:
+    std::vector<std::shared_ptr<t_message_type> > m_messages;
+    size_t m_capacity;
+    size_t m_nextIndex;
+    uint64_t m_allocationCount;
+
+    ProtocolMessagePool(const ProtocolMessagePool &copy) = delete;
+    ProtocolMessagePool &operator=(const ProtocolMessagePool &copy) = delete;
+};
+
+/// Turns the process wide pool miss counter into misses per second.
+/// Call update() regularly (i.e. once a tick), the rate refreshes once a second.
+class ProtocolMessagePoolMissRate
+{
+public:
+    ProtocolMessagePoolMissRate()
+        : m_windowStart(std::chrono::steady_clock::now())
+        , m_windowStartCount(getProtocolMessagePoolMissCounter().load(std::memory_order_relaxed))
+        , m_missesPerSecond(0)
+    {
+    }
+
+    void update()
+    {
+        const std::chrono::steady_clock::time_point now= std::chrono::steady_clock::now();
+        const std::chrono::duration<double> window_duration= now - m_windowStart;
+
+        if (window_duration.count() >= 1.0)
+        {
+            const uint64_t miss_count= getProtocolMessagePoolMissCounter().load(std::memory_order_relaxed);
+
+            m_missesPerSecond= static_cast<double>(miss_count - m_windowStartCount) / window_duration.count();
+            m_windowStart= now;
+            m_windowStartCount= miss_count;
+        }
+    }
+
+    /// Pool misses per second over the last complete window
+    inline double getMissesPerSecond() const { return m_missesPerSecond; }
+
+private:
+    std::chrono::steady_clock::time_point m_windowStart;
+    uint64_t m_windowStartCount;
+    double m_missesPerSecond;
+};
+
+#endif // PROTOCOL_MESSAGE_POOL_H
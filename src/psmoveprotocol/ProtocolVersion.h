@@ -26,7 +26,7 @@
 #define PSM_PROTOCOL_VERSION_MAJOR   9
 #define PSM_PROTOCOL_VERSION_PHASE   alpha
 #define PSM_PROTOCOL_VERSION_MINOR   9
-#define PSM_PROTOCOL_VERSION_RELEASE 0
+#define PSM_PROTOCOL_VERSION_RELEASE 1
 #define PSM_PROTOCOL_VERSION_HOTFIX  0
 
 /// "Product.Major-Phase Minor.Release.Hotfix"
@@ -7,6 +7,12 @@
 #define MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE 500
 #define MAX_INPUT_DATA_FRAME_MESSAGE_SIZE 64
 
+// Output data frames are sent as a run of length prefixed messages per UDP datagram.
+// Clients must be able to receive a datagram of the max size (the max UDP payload),
+// the service defaults to batching up to what fits in an ethernet frame without fragmenting.
+#define MAX_OUTPUT_DATA_FRAME_DATAGRAM_SIZE 65507
+#define DEFAULT_OUTPUT_DATA_FRAME_DATAGRAM_SIZE 1472
+
 // See ControllerManager.h in PSMoveService
 #define PSMOVESERVICE_MAX_CONTROLLER_COUNT  5
 
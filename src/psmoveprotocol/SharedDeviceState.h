@@ -0,0 +1,203 @@
+#ifndef SHARED_DEVICE_STATE_H
+#define SHARED_DEVICE_STATE_H
+
+#ifdef WIN32
+#define BOOST_INTERPROCESS_SHARED_DIR_PATH "shared_mem"
+#endif // WIN32
+
+#include "SharedConstants.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+// Name of the shared memory block the service publishes controller and HMD state in
+#define SHARED_DEVICE_STATE_MEMORY_NAME "PSMoveService_DeviceState"
+
+// Bumped whenever the layout of SharedDeviceStateHeader changes
+#define SHARED_DEVICE_STATE_VERSION 2
+
+// Number of analog values kept per controller (the DualShock4 has the most)
+#define SHARED_CONTROLLER_ANALOG_VALUE_COUNT 6
+
+// The slot sequences are shared between processes,
+// which is only safe when the atomics don't need a lock
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared device state atomics must be lock free");
+
+enum eSharedDeviceStateFlags
+{
+    SharedDeviceStateFlag_IsConnected=                  1 << 0,
+    SharedDeviceStateFlag_HasValidHardwareCalibration=  1 << 1,
+    SharedDeviceStateFlag_IsTrackingEnabled=            1 << 2,
+    SharedDeviceStateFlag_IsCurrentlyTracking=          1 << 3,
+    SharedDeviceStateFlag_IsOrientationValid=           1 << 4,
+    SharedDeviceStateFlag_IsPositionValid=              1 << 5,
+};
+
+// Filtered physics of a device, in the same units as the PhysicsData data frame message
+struct SharedDevicePhysics
+{
+    float velocity_cm_per_sec[3];
+    float acceleration_cm_per_sec_sqr[3];
+    float angular_velocity_rad_per_sec[3];
+    float angular_acceleration_rad_per_sec_sqr[3];
+};
+
+// Everything a pose/physics controller data stream carries, in a fixed layout.
+// Plain data so that it can be copied in and out of shared memory with memcpy.
+struct SharedControllerState
+{
+    int32_t controller_type; // PSMoveProtocol::ControllerType, -1 if no controller is open
+    int32_t sequence_num;
+    uint32_t state_flags; // eSharedDeviceStateFlags
+    // Bit per PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::ButtonType
+    // (bit per button index on a virtual controller)
+    uint32_t button_down_bitmask;
+
+    float orientation[4]; // w, x, y, z
+    float position_cm[3];
+    SharedDevicePhysics physics;
+
+    // PSMove: [trigger]
+    // PSNavi: [trigger, stick x, stick y]
+    // DualShock4: [left x, left y, right x, right y, left trigger, right trigger]
+    float analog_values[SHARED_CONTROLLER_ANALOG_VALUE_COUNT];
+
+    // Virtual controller gamepad state
+    int32_t vendor_id;
+    int32_t product_id;
+    int32_t axis_count;
+    int32_t button_count;
+    uint8_t axis_states[PSM_MAX_VIRTUAL_CONTROLLER_AXES];
+
+    int32_t battery_value;
+    // Time the state was published, in microseconds of std::chrono::steady_clock
+    int64_t publish_time_us;
+    // Time of the newest sample the pose filter processed, in the same clock (0 if none yet)
+    int64_t sample_time_us;
+    // How far past sample_time_us the pose was predicted, in seconds
+    float prediction_time;
+};
+
+struct SharedHMDState
+{
+    int32_t hmd_type; // PSMoveProtocol::HMDType, -1 if no HMD is open
+    int32_t sequence_num;
+    uint32_t state_flags; // eSharedDeviceStateFlags
+
+    float orientation[4]; // w, x, y, z
+    float position_cm[3];
+    SharedDevicePhysics physics;
+
+    // Time the state was published, in microseconds of std::chrono::steady_clock
+    int64_t publish_time_us;
+    // Time of the newest sample the pose filter processed, in the same clock (0 if none yet)
+    int64_t sample_time_us;
+    // How far past sample_time_us the pose was predicted, in seconds
+    float prediction_time;
+};
+
+// The state of a single device, guarded by a seqlock:
+// the sequence is odd while the writer is filling in the state and even once it's done.
+// Readers copy the state and then check that the sequence didn't change underneath them,
+// so the service never waits on a client.
+template <typename t_device_state>
+struct SharedDeviceStateSlot
+{
+    std::atomic<uint32_t> sequence;
+
+    // Written inside the seqlock, only valid if the sequence checks out
+    t_device_state state;
+
+    SharedDeviceStateSlot()
+        : sequence(0)
+    {
+        std::memset(&state, 0, sizeof(t_device_state));
+    }
+
+    /// Publishes new device state without ever blocking on readers.
+    /// Must only be called from one writer at a time.
+    void write(const t_device_state &new_state)
+    {
+        const uint32_t old_sequence= sequence.load(std::memory_order_relaxed);
+
+        // Mark the slot as being written (odd sequence) before touching the state
+        sequence.store(old_sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(&state, &new_state, sizeof(t_device_state));
+
+        // Mark the slot as complete (even sequence)
+        sequence.store(old_sequence + 2, std::memory_order_release);
+    }
+
+    /// Copies the device state into out_state if the slot changed since last_sequence.
+    /// Returns false if nothing was published since or if every attempt was torn by the writer.
+    bool read(uint32_t last_sequence, t_device_state &out_state, uint32_t &out_sequence) const
+    {
+        static const int k_max_read_attempt_count= 4;
+
+        for (int attempt = 0; attempt < k_max_read_attempt_count; ++attempt)
+        {
+            const uint32_t sequence_before= sequence.load(std::memory_order_acquire);
+            if (sequence_before == last_sequence)
+            {
+                return false;
+            }
+            if ((sequence_before & 1) != 0)
+            {
+                // The writer is filling the slot in right now
+                continue;
+            }
+
+            std::memcpy(&out_state, &state, sizeof(t_device_state));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint32_t sequence_after= sequence.load(std::memory_order_relaxed);
+
+            if (sequence_before == sequence_after)
+            {
+                out_sequence= sequence_before;
+                return true;
+            }
+            // else the state was torn by the writer, try again
+        }
+
+        return false;
+    }
+};
+
+class SharedDeviceStateHeader
+{
+public:
+    SharedDeviceStateHeader()
+        : version(SHARED_DEVICE_STATE_VERSION)
+        , controllers()
+        , hmds()
+    {
+        for (int controller_id = 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+        {
+            controllers[controller_id].state.controller_type= -1;
+        }
+
+        for (int hmd_id = 0; hmd_id < PSMOVESERVICE_MAX_HMD_COUNT; ++hmd_id)
+        {
+            hmds[hmd_id].state.hmd_type= -1;
+        }
+    }
+
+    // Readers should ignore the block if this doesn't match SHARED_DEVICE_STATE_VERSION
+    uint32_t version;
+
+    SharedDeviceStateSlot<SharedControllerState> controllers[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    SharedDeviceStateSlot<SharedHMDState> hmds[PSMOVESERVICE_MAX_HMD_COUNT];
+
+    static int64_t getTimestampMicroseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+#endif // SHARED_DEVICE_STATE_H
@@ -5,48 +5,181 @@
 #define BOOST_INTERPROCESS_SHARED_DIR_PATH "shared_mem"
 #endif // WIN32
 
-#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+// Number of frame buffers in the shared video stream.
+// With three slots the writer always has a slot that is neither the latest frame
+// nor the frame before it, so a reader copying the latest frame is rarely lapped.
+#define SHARED_VIDEO_FRAME_SLOT_COUNT 3
+
+// Bumped whenever the layout of SharedVideoFrameHeader changes
+// (version 1 was the single buffer guarded by an interprocess mutex, which had no version field)
+#define SHARED_VIDEO_FRAME_VERSION 2
+
+// The slot sequence and latest slot index are shared between processes,
+// which is only safe when the atomics don't need a lock
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared video frame atomics must be lock free");
+
+// A single frame buffer in the shared video stream, guarded by a seqlock:
+// the slot sequence is odd while the writer is filling the slot and even once it's done.
+// Readers copy the frame and then check that the slot sequence didn't change underneath them.
+struct SharedVideoFrameSlot
+{
+    std::atomic<uint32_t> slot_sequence;
+
+    // Written inside the seqlock, only valid if the slot sequence checks out
+    uint32_t frame_index;
+    // Time the frame was published, in microseconds of std::chrono::steady_clock
+    // (monotonic and shared by all processes on the machine)
+    int64_t timestamp_us;
+
+    SharedVideoFrameSlot()
+        : slot_sequence(0)
+        , frame_index(0)
+        , timestamp_us(0)
+    {
+    }
+};
 
 class SharedVideoFrameHeader
 {
 public:
     SharedVideoFrameHeader()
-        : mutex()
+        : version(SHARED_VIDEO_FRAME_VERSION)
         , width(0)
         , height(0)
         , stride(0)
+        , latest_slot_index(-1)
         , frame_index(0)
+        , slots()
     {
     }
-    
-    //Mutex to protect access to the shared memory
-    boost::interprocess::interprocess_mutex mutex;
 
+    // Readers should ignore the block if this doesn't match SHARED_VIDEO_FRAME_VERSION
+    uint32_t version;
+
+    // The frame format doesn't change once the shared memory is initialized
     int width;
     int height;
     int stride;
-    int frame_index;
-    // Buffer stored past the end of the header
 
-    const unsigned char *getBuffer() const
+    // The slot holding the most recently published frame, -1 until the first frame is written
+    std::atomic<int32_t> latest_slot_index;
+    // The frame index of the most recently published frame
+    std::atomic<uint32_t> frame_index;
+
+    SharedVideoFrameSlot slots[SHARED_VIDEO_FRAME_SLOT_COUNT];
+    // Slot buffers stored past the end of the header
+
+    const unsigned char *getSlotBuffer(int slot_index) const
+    {
+        return
+            reinterpret_cast<const unsigned char *>(this) + sizeof(SharedVideoFrameHeader) +
+            slot_index*computeVideoBufferSize(stride, height);
+    }
+
+    unsigned char *getSlotBufferMutable(int slot_index)
     {
-        return reinterpret_cast<const unsigned char *>(this) + sizeof(SharedVideoFrameHeader);
+        return const_cast<unsigned char *>(getSlotBuffer(slot_index));
     }
 
-    unsigned char *getBufferMutable()
+    static int64_t getTimestampMicroseconds()
     {
-        return const_cast<unsigned char *>(getBuffer());
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
     static size_t computeVideoBufferSize(int stride, int height)
     {
-        return stride*height;
+        return static_cast<size_t>(stride)*static_cast<size_t>(height);
     }
 
     static size_t computeTotalSize(int stride, int height)
     {
-        return sizeof(SharedVideoFrameHeader) + computeVideoBufferSize(stride, height);
+        return sizeof(SharedVideoFrameHeader) + SHARED_VIDEO_FRAME_SLOT_COUNT*computeVideoBufferSize(stride, height);
+    }
+
+    /// Publishes a new frame without ever blocking on readers.
+    /// Must only be called from one writer at a time.
+    void writeVideoFrame(const unsigned char *buffer)
+    {
+        const int32_t latest_index= latest_slot_index.load(std::memory_order_relaxed);
+        const int slot_index= (latest_index + 1) % SHARED_VIDEO_FRAME_SLOT_COUNT;
+        const uint32_t new_frame_index= frame_index.load(std::memory_order_relaxed) + 1;
+        SharedVideoFrameSlot &slot= slots[slot_index];
+
+        // Mark the slot as being written (odd sequence) before touching the frame data
+        const uint32_t sequence= slot.slot_sequence.load(std::memory_order_relaxed);
+        slot.slot_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.frame_index= new_frame_index;
+        slot.timestamp_us= getTimestampMicroseconds();
+        std::memcpy(getSlotBufferMutable(slot_index), buffer, computeVideoBufferSize(stride, height));
+
+        // Mark the slot as complete (even sequence) and then make it the latest frame
+        slot.slot_sequence.store(sequence + 2, std::memory_order_release);
+        latest_slot_index.store(slot_index, std::memory_order_release);
+        frame_index.store(new_frame_index, std::memory_order_release);
+    }
+
+    /// Copies the latest frame into out_buffer if it's newer than last_frame_index.
+    /// Returns false if there was no new frame or the writer kept overwriting the slot
+    /// being read (a torn read) for every attempt, in which case out_buffer may hold a torn frame.
+    bool readLatestVideoFrame(
+        unsigned char *out_buffer,
+        uint32_t last_frame_index,
+        uint32_t &out_frame_index,
+        int64_t &out_timestamp_us) const
+    {
+        static const int k_max_read_attempt_count= 4;
+
+        for (int attempt = 0; attempt < k_max_read_attempt_count; ++attempt)
+        {
+            const int32_t slot_index= latest_slot_index.load(std::memory_order_acquire);
+            if (slot_index < 0 || slot_index >= SHARED_VIDEO_FRAME_SLOT_COUNT)
+            {
+                return false;
+            }
+
+            const SharedVideoFrameSlot &slot= slots[slot_index];
+            const uint32_t sequence_before= slot.slot_sequence.load(std::memory_order_acquire);
+            if ((sequence_before & 1) != 0)
+            {
+                // The writer lapped us and is refilling the slot, look up the latest slot again
+                continue;
+            }
+
+            const uint32_t slot_frame_index= slot.frame_index;
+            const int64_t slot_timestamp_us= slot.timestamp_us;
+
+            if (slot_frame_index != last_frame_index)
+            {
+                std::memcpy(out_buffer, getSlotBuffer(slot_index), computeVideoBufferSize(stride, height));
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint32_t sequence_after= slot.slot_sequence.load(std::memory_order_relaxed);
+
+            if (sequence_before == sequence_after)
+            {
+                if (slot_frame_index == last_frame_index)
+                {
+                    return false;
+                }
+
+                out_frame_index= slot_frame_index;
+                out_timestamp_us= slot_timestamp_us;
+                return true;
+            }
+            // else the frame was torn by the writer, try again with the new latest slot
+        }
+
+        return false;
     }
 };
 
-#endif // SHARED_TRACKER_STATE_H
\ No newline at end of file
+#endif // SHARED_TRACKER_STATE_H
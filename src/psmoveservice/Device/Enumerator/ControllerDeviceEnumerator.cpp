@@ -3,6 +3,7 @@
 #include "ControllerHidDeviceEnumerator.h"
 #include "ControllerUSBDeviceEnumerator.h"
 #include "ControllerGamepadEnumerator.h"
+#include "ReplayControllerEnumerator.h"
 #include "VirtualControllerEnumerator.h"
 #include "assert.h"
 #include "string.h"
@@ -35,13 +36,24 @@ ControllerDeviceEnumerator::ControllerDeviceEnumerator(
 		enumerators[0] = new ControllerGamepadEnumerator;
 		enumerator_count = 1;
 		break;
+	case eAPIType::CommunicationType_VIRTUAL:
+		enumerators = new DeviceEnumerator *[1];
+		enumerators[0] = new VirtualControllerEnumerator;
+		enumerator_count = 1;
+		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerators = new DeviceEnumerator *[1];
+		enumerators[0] = new ReplayControllerEnumerator;
+		enumerator_count = 1;
+		break;
 	case eAPIType::CommunicationType_ALL:
-		enumerators = new DeviceEnumerator *[4];
+		enumerators = new DeviceEnumerator *[5];
 		enumerators[0] = new ControllerHidDeviceEnumerator;
 		enumerators[1] = new ControllerUSBDeviceEnumerator;
 		enumerators[2] = new ControllerGamepadEnumerator;
         enumerators[3] = new VirtualControllerEnumerator;
-		enumerator_count = 4;
+        enumerators[4] = new ReplayControllerEnumerator;
+		enumerator_count = 5;
 		break;
 	}
 
@@ -86,13 +98,19 @@ ControllerDeviceEnumerator::ControllerDeviceEnumerator(
 		enumerators[0] = new VirtualControllerEnumerator;
 		enumerator_count = 1;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerators = new DeviceEnumerator *[1];
+		enumerators[0] = new ReplayControllerEnumerator(deviceTypeFilter);
+		enumerator_count = 1;
+		break;
 	case eAPIType::CommunicationType_ALL:
-		enumerators = new DeviceEnumerator *[4];
+		enumerators = new DeviceEnumerator *[5];
 		enumerators[0] = new ControllerHidDeviceEnumerator(deviceTypeFilter);
 		enumerators[1] = new ControllerUSBDeviceEnumerator(deviceTypeFilter);
 		enumerators[2] = new ControllerGamepadEnumerator(deviceTypeFilter);
         enumerators[3] = new VirtualControllerEnumerator;
-		enumerator_count = 4;
+        enumerators[4] = new ReplayControllerEnumerator(deviceTypeFilter);
+		enumerator_count = 5;
 		break;
 	}
 
@@ -163,6 +181,9 @@ ControllerDeviceEnumerator::eAPIType ControllerDeviceEnumerator::get_api_type()
 	case eAPIType::CommunicationType_VIRTUAL:
 		result = (enumerator_index < enumerator_count) ? ControllerDeviceEnumerator::CommunicationType_VIRTUAL : ControllerDeviceEnumerator::CommunicationType_INVALID;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		result = (enumerator_index < enumerator_count) ? ControllerDeviceEnumerator::CommunicationType_REPLAY : ControllerDeviceEnumerator::CommunicationType_INVALID;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -180,6 +201,9 @@ ControllerDeviceEnumerator::eAPIType ControllerDeviceEnumerator::get_api_type()
 			case 3:
 				result = ControllerDeviceEnumerator::CommunicationType_VIRTUAL;
 				break;
+			case 4:
+				result = ControllerDeviceEnumerator::CommunicationType_REPLAY;
+				break;
 			default:
 				result = ControllerDeviceEnumerator::CommunicationType_INVALID;
 				break;
@@ -213,6 +237,9 @@ const ControllerHidDeviceEnumerator *ControllerDeviceEnumerator::get_hid_control
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -246,6 +273,9 @@ const ControllerUSBDeviceEnumerator *ControllerDeviceEnumerator::get_usb_control
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -279,6 +309,9 @@ const ControllerGamepadEnumerator *ControllerDeviceEnumerator::get_gamepad_contr
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -312,6 +345,9 @@ const VirtualControllerEnumerator *ControllerDeviceEnumerator::get_virtual_contr
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = (enumerator_index < enumerator_count) ? static_cast<VirtualControllerEnumerator *>(enumerators[0]) : nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -327,6 +363,42 @@ const VirtualControllerEnumerator *ControllerDeviceEnumerator::get_virtual_contr
 	return enumerator;
 }
 
+const ReplayControllerEnumerator *ControllerDeviceEnumerator::get_replay_controller_enumerator() const
+{
+	ReplayControllerEnumerator *enumerator = nullptr;
+
+	switch (api_type)
+	{
+	case eAPIType::CommunicationType_HID:
+		enumerator = nullptr;
+		break;
+	case eAPIType::CommunicationType_USB:
+		enumerator = nullptr;
+		break;
+	case eAPIType::CommunicationType_GAMEPAD:
+		enumerator = nullptr;
+		break;
+	case eAPIType::CommunicationType_VIRTUAL:
+		enumerator = nullptr;
+		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = (enumerator_index < enumerator_count) ? static_cast<ReplayControllerEnumerator *>(enumerators[0]) : nullptr;
+		break;
+	case eAPIType::CommunicationType_ALL:
+		if (enumerator_index < enumerator_count)
+		{
+			enumerator = (enumerator_index == 4) ? static_cast<ReplayControllerEnumerator *>(enumerators[4]) : nullptr;
+		}
+		else
+		{
+			enumerator = nullptr;
+		}
+		break;
+	}
+
+	return enumerator;
+}
+
 bool ControllerDeviceEnumerator::is_valid() const
 {
     bool bIsValid = false;
@@ -0,0 +1,134 @@
+// -- includes -----
+#include "ReplayControllerEnumerator.h"
+#include "HidPacketRecording.h"
+#include "ServerLog.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <fstream>
+
+// -- constants -----
+#define SONY_VENDOR_ID 0x054c
+
+//-- Statics
+bool ReplayControllerEnumerator::replay_enabled= false;
+std::string ReplayControllerEnumerator::recording_path;
+
+// -- ReplayControllerEnumerator -----
+ReplayControllerEnumerator::ReplayControllerEnumerator()
+    : DeviceEnumerator()
+    , m_recordings()
+    , m_recording_index(0)
+{
+    build_recording_list();
+}
+
+ReplayControllerEnumerator::ReplayControllerEnumerator(CommonDeviceState::eDeviceType deviceTypeFilter)
+    : DeviceEnumerator(deviceTypeFilter)
+    , m_recordings()
+    , m_recording_index(0)
+{
+    build_recording_list();
+}
+
+void ReplayControllerEnumerator::build_recording_list()
+{
+    if (!replay_enabled)
+    {
+        return;
+    }
+
+    boost::system::error_code error;
+
+    if (!boost::filesystem::is_directory(recording_path, error))
+    {
+        SERVER_LOG_WARNING("ReplayControllerEnumerator") << "Controller recording folder not found: " << recording_path;
+        return;
+    }
+
+    for (boost::filesystem::directory_iterator iter(recording_path, error), end; 
+        !error && iter != end; 
+        iter.increment(error))
+    {
+        const boost::filesystem::path &path= iter->path();
+
+        if (path.extension() != HID_PACKET_RECORDING_FILE_EXTENSION)
+        {
+            continue;
+        }
+
+        // Only the header is needed to tell what kind of controller was recorded
+        HidPacketRecordingFileHeader header;
+        std::ifstream file(path.string().c_str(), std::ios::binary);
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        {
+            continue;
+        }
+
+        const CommonDeviceState::eDeviceType device_type= 
+            static_cast<CommonDeviceState::eDeviceType>(header.device_type);
+
+        // The PSMove is the only controller with a replay path for now
+        if (device_type == CommonDeviceState::PSMove &&
+            (m_deviceTypeFilter == CommonDeviceState::INVALID_DEVICE_TYPE || m_deviceTypeFilter == device_type))
+        {
+            RecordingEntry entry;
+            entry.path= path.string();
+            entry.device_type= device_type;
+            entry.product_id= header.product_id;
+
+            m_recordings.push_back(entry);
+        }
+        else
+        {
+            SERVER_LOG_INFO("ReplayControllerEnumerator") << "Skipping recording of unsupported controller type: " << path.string();
+        }
+    }
+
+    // Keep the controller order stable from run to run
+    std::sort(
+        m_recordings.begin(), m_recordings.end(),
+        [](const RecordingEntry &a, const RecordingEntry &b) -> bool
+        {
+            return a.path < b.path;
+        });
+
+    if (is_valid())
+    {
+        m_deviceType= m_recordings[m_recording_index].device_type;
+    }
+}
+
+const char *ReplayControllerEnumerator::get_path() const
+{
+	return is_valid() ? m_recordings[m_recording_index].path.c_str() : nullptr;
+}
+
+int ReplayControllerEnumerator::get_vendor_id() const
+{
+	return is_valid() ? SONY_VENDOR_ID : -1;
+}
+
+int ReplayControllerEnumerator::get_product_id() const
+{
+	return is_valid() ? m_recordings[m_recording_index].product_id : -1;
+}
+
+bool ReplayControllerEnumerator::is_valid() const
+{
+	return m_recording_index < static_cast<int>(m_recordings.size());
+}
+
+bool ReplayControllerEnumerator::next()
+{
+	if (is_valid())
+	{
+		++m_recording_index;
+	}
+
+	if (is_valid())
+	{
+		m_deviceType= m_recordings[m_recording_index].device_type;
+	}
+
+	return is_valid();
+}
@@ -0,0 +1,42 @@
+#ifndef REPLAY_CONTROLLER_ENUMERATOR_H
+#define REPLAY_CONTROLLER_ENUMERATOR_H
+
+// -- includes -----
+#include "DeviceEnumerator.h"
+#include <vector>
+#include <string>
+
+// -- definitions -----
+/// Enumerates the controller HID recordings (*.psmhid) in the controller recording folder
+/// that can be replayed (currently PSMove recordings only)
+class ReplayControllerEnumerator : public DeviceEnumerator
+{
+public:
+    ReplayControllerEnumerator();
+    ReplayControllerEnumerator(CommonDeviceState::eDeviceType deviceTypeFilter);
+
+    bool is_valid() const override;
+    bool next() override;
+	int get_vendor_id() const override;
+	int get_product_id() const override;
+    const char *get_path() const override;
+
+    // Assigned by the controller manager on startup
+    static bool replay_enabled;
+    static std::string recording_path;
+
+private:
+    void build_recording_list();
+
+    struct RecordingEntry
+    {
+        std::string path;
+        CommonDeviceState::eDeviceType device_type;
+        int product_id;
+    };
+
+	std::vector<RecordingEntry> m_recordings;
+    int m_recording_index;
+};
+
+#endif // REPLAY_CONTROLLER_ENUMERATOR_H
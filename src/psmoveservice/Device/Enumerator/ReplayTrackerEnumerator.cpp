@@ -0,0 +1,76 @@
+// -- includes -----
+#include "ReplayTrackerEnumerator.h"
+#include "TrackerFrameRecording.h"
+#include "ServerLog.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+
+//-- Statics
+bool ReplayTrackerEnumerator::replay_enabled= false;
+std::string ReplayTrackerEnumerator::recording_path;
+
+// -- ReplayTrackerEnumerator -----
+ReplayTrackerEnumerator::ReplayTrackerEnumerator()
+    : DeviceEnumerator(CommonDeviceState::ReplayTracker)
+    , m_recording_paths()
+    , m_recording_index(0)
+{
+	m_deviceType= CommonDeviceState::ReplayTracker;
+
+    if (replay_enabled)
+    {
+        boost::system::error_code error;
+
+        if (boost::filesystem::is_directory(recording_path, error))
+        {
+            for (boost::filesystem::directory_iterator iter(recording_path, error), end; 
+                !error && iter != end; 
+                iter.increment(error))
+            {
+                const boost::filesystem::path &path= iter->path();
+
+                if (path.extension() == TRACKER_RECORDING_FILE_EXTENSION)
+                {
+                    m_recording_paths.push_back(path.string());
+                }
+            }
+
+            // Keep the tracker order stable from run to run
+            std::sort(m_recording_paths.begin(), m_recording_paths.end());
+        }
+        else
+        {
+            SERVER_LOG_WARNING("ReplayTrackerEnumerator") << "Tracker recording folder not found: " << recording_path;
+        }
+    }
+}
+
+const char *ReplayTrackerEnumerator::get_path() const
+{
+	return is_valid() ? m_recording_paths[m_recording_index].c_str() : nullptr;
+}
+
+int ReplayTrackerEnumerator::get_vendor_id() const
+{
+	return is_valid() ? 0x0000 : -1;
+}
+
+int ReplayTrackerEnumerator::get_product_id() const
+{
+	return is_valid() ? 0x0000 : -1;
+}
+
+bool ReplayTrackerEnumerator::is_valid() const
+{
+	return m_recording_index < static_cast<int>(m_recording_paths.size());
+}
+
+bool ReplayTrackerEnumerator::next()
+{
+	if (is_valid())
+	{
+		++m_recording_index;
+	}
+
+	return is_valid();
+}
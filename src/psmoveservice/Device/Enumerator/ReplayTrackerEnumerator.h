@@ -0,0 +1,31 @@
+#ifndef REPLAY_TRACKER_ENUMERATOR_H
+#define REPLAY_TRACKER_ENUMERATOR_H
+
+// -- includes -----
+#include "DeviceEnumerator.h"
+#include <vector>
+#include <string>
+
+// -- definitions -----
+/// Enumerates the tracker recordings (*.psmrec) in the tracker recording folder
+class ReplayTrackerEnumerator : public DeviceEnumerator
+{
+public:
+    ReplayTrackerEnumerator();
+
+    bool is_valid() const override;
+    bool next() override;
+	int get_vendor_id() const override;
+	int get_product_id() const override;
+    const char *get_path() const override;
+
+    // Assigned by the tracker manager on startup
+    static bool replay_enabled;
+    static std::string recording_path;
+
+private:
+	std::vector<std::string> m_recording_paths;
+    int m_recording_index;
+};
+
+#endif // REPLAY_TRACKER_ENUMERATOR_H
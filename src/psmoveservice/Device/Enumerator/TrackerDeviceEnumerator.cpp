@@ -1,5 +1,6 @@
 // -- includes -----
 #include "TrackerDeviceEnumerator.h"
+#include "ReplayTrackerEnumerator.h"
 #include "ServerUtility.h"
 #include "USBDeviceManager.h"
 #include "ServerLog.h"
@@ -14,10 +15,11 @@
 
 // -- macros ----
 #define MAX_CAMERA_TYPE_INDEX               GET_DEVICE_TYPE_INDEX(CommonDeviceState::SUPPORTED_CAMERA_TYPE_COUNT)
+#define MAX_USB_CAMERA_TYPE_INDEX           GET_DEVICE_TYPE_INDEX(CommonDeviceState::ReplayTracker)
 
 // -- globals -----
-// NOTE: This list must match the tracker order in CommonDeviceState::eDeviceType
-USBDeviceFilter k_supported_tracker_infos[MAX_CAMERA_TYPE_INDEX] = {
+// NOTE: This list must match the USB tracker order in CommonDeviceState::eDeviceType
+USBDeviceFilter k_supported_tracker_infos[MAX_USB_CAMERA_TYPE_INDEX] = {
     { 0x1415, 0x2000 }, // PS3Eye
     //{ 0x05a9, 0x058a }, // PS4 Camera - TODO
 };
@@ -29,22 +31,35 @@ static bool is_tracker_supported(USBDeviceEnumerator* enumerator, CommonDeviceSt
 TrackerDeviceEnumerator::TrackerDeviceEnumerator()
 	: DeviceEnumerator()
 	, m_usb_enumerator(nullptr)
+	, m_replay_enumerator(nullptr)
     , m_cameraIndex(-1)
 {
-	USBDeviceManager *usbRequestMgr = USBDeviceManager::getInstance();
-
-	m_deviceType= CommonDeviceState::PS3EYE;
-	assert(m_deviceType >= 0 && GET_DEVICE_TYPE_INDEX(m_deviceType) < MAX_CAMERA_TYPE_INDEX);
-	m_usb_enumerator = usb_device_enumerator_allocate();
-
-	// If the first USB device handle isn't a tracker, move on to the next device
-	if (testUSBEnumerator())
+	if (ReplayTrackerEnumerator::replay_enabled)
 	{
-		m_cameraIndex= 0;
+		// Tracker recordings stand in for the cameras when replaying
+		m_deviceType= CommonDeviceState::ReplayTracker;
+		m_replay_enumerator = new ReplayTrackerEnumerator;
+
+		if (m_replay_enumerator->is_valid())
+		{
+			m_cameraIndex= 0;
+		}
 	}
 	else
 	{
-		next();
+		m_deviceType= CommonDeviceState::PS3EYE;
+		assert(m_deviceType >= 0 && GET_DEVICE_TYPE_INDEX(m_deviceType) < MAX_CAMERA_TYPE_INDEX);
+		m_usb_enumerator = usb_device_enumerator_allocate();
+
+		// If the first USB device handle isn't a tracker, move on to the next device
+		if (testUSBEnumerator())
+		{
+			m_cameraIndex= 0;
+		}
+		else
+		{
+			next();
+		}
 	}
 }
 
@@ -54,6 +69,11 @@ TrackerDeviceEnumerator::~TrackerDeviceEnumerator()
 	{
 		usb_device_enumerator_free(m_usb_enumerator);
 	}
+
+	if (m_replay_enumerator != nullptr)
+	{
+		delete m_replay_enumerator;
+	}
 }
 
 int TrackerDeviceEnumerator::get_vendor_id() const
@@ -61,7 +81,11 @@ int TrackerDeviceEnumerator::get_vendor_id() const
 	USBDeviceFilter devInfo;
 	int vendor_id = -1;
 
-	if (is_valid() && usb_device_enumerator_get_filter(m_usb_enumerator, devInfo))
+	if (m_replay_enumerator != nullptr)
+	{
+		vendor_id = m_replay_enumerator->get_vendor_id();
+	}
+	else if (is_valid() && usb_device_enumerator_get_filter(m_usb_enumerator, devInfo))
 	{
 		vendor_id = devInfo.vendor_id;
 	}
@@ -74,7 +98,11 @@ int TrackerDeviceEnumerator::get_product_id() const
 	USBDeviceFilter devInfo;
 	int product_id = -1;
 
-	if (is_valid() && usb_device_enumerator_get_filter(m_usb_enumerator, devInfo))
+	if (m_replay_enumerator != nullptr)
+	{
+		product_id = m_replay_enumerator->get_product_id();
+	}
+	else if (is_valid() && usb_device_enumerator_get_filter(m_usb_enumerator, devInfo))
 	{
 		product_id = devInfo.product_id;
 	}
@@ -86,7 +114,12 @@ const char *TrackerDeviceEnumerator::get_path() const
 {
     const char *result = nullptr;
 
-    if (is_valid())
+    if (m_replay_enumerator != nullptr)
+    {
+        // The path of the tracker recording
+        result= m_replay_enumerator->get_path();
+    }
+    else if (is_valid())
     {
         // Return a pointer to our member variable that has the path cached
         result= m_currentUSBPath;
@@ -97,14 +130,32 @@ const char *TrackerDeviceEnumerator::get_path() const
 
 bool TrackerDeviceEnumerator::is_valid() const
 {
+	if (m_replay_enumerator != nullptr)
+	{
+		return m_replay_enumerator->is_valid();
+	}
+
 	return m_usb_enumerator != nullptr && usb_device_enumerator_is_valid(m_usb_enumerator);
 }
 
 bool TrackerDeviceEnumerator::next()
 {
-	USBDeviceManager *usbRequestMgr = USBDeviceManager::getInstance();
 	bool foundValid = false;
 
+	if (m_replay_enumerator != nullptr)
+	{
+		foundValid= m_replay_enumerator->next();
+
+		if (foundValid)
+		{
+			++m_cameraIndex;
+		}
+
+		return foundValid;
+	}
+
+	USBDeviceManager *usbRequestMgr = USBDeviceManager::getInstance();
+
 	while (is_valid() && !foundValid)
 	{
 		usb_device_enumerator_next(m_usb_enumerator);
@@ -164,7 +215,7 @@ static bool is_tracker_supported(
 	if (usb_device_enumerator_get_filter(enumerator, devInfo))
 	{
 		// See if the next filtered device is a camera that we care about
-		for (int tracker_type_index = 0; tracker_type_index < MAX_CAMERA_TYPE_INDEX; ++tracker_type_index)
+		for (int tracker_type_index = 0; tracker_type_index < MAX_USB_CAMERA_TYPE_INDEX; ++tracker_type_index)
 		{
 			const USBDeviceFilter &supported_type = k_supported_tracker_infos[tracker_type_index];
 
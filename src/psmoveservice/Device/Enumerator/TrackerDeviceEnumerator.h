@@ -26,6 +26,7 @@ protected:
 private:
     char m_currentUSBPath[256];
 	struct USBDeviceEnumerator* m_usb_enumerator;
+	class ReplayTrackerEnumerator* m_replay_enumerator;
     int m_cameraIndex;
 };
 
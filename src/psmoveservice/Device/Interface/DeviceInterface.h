@@ -2,6 +2,8 @@
 #define DEVICE_INTERFACE_H
 
 // -- includes -----
+#include <memory>
+#include <stdint.h>
 #include <string>
 #include <tuple>
 
@@ -12,6 +14,9 @@ namespace PSMoveProtocol
     class TrackingColorPreset;
 };
 
+class VideoFrame;
+typedef std::shared_ptr<const VideoFrame> VideoFramePtr;
+
 // -- constants -----
 enum eCommonTrackingColorID {
     INVALID_COLOR= -1,
@@ -204,7 +209,8 @@ struct CommonDeviceState
         SUPPORTED_CONTROLLER_TYPE_COUNT = Controller + 0x04,
         
         PS3EYE = TrackingCamera + 0x00,
-        SUPPORTED_CAMERA_TYPE_COUNT = TrackingCamera + 0x01,
+        ReplayTracker = TrackingCamera + 0x01,
+        SUPPORTED_CAMERA_TYPE_COUNT = TrackingCamera + 0x02,
         
         Morpheus = HeadMountedDisplay + 0x00,
         VirtualHMD = HeadMountedDisplay + 0x01,
@@ -245,6 +251,9 @@ struct CommonDeviceState
         case PS3EYE:
             result = "PSEYE";
             break;
+        case ReplayTracker:
+            result = "ReplayTracker";
+            break;
         case Morpheus:
             result = "Morpheus";
             break;
@@ -456,6 +465,10 @@ class IControllerListener
 public:
 	// Called when new sensor state has been read from the controller
 	virtual void notifySensorDataReceived(const CommonDeviceState *sensor_state) = 0;
+
+	// Called when sensor state has been replayed from a HID recording.
+	// sample_time_us is when the packet was recorded, relative to the start of the replay.
+	virtual void notifyRecordedSensorDataReceived(const CommonDeviceState *sensor_state, int64_t sample_time_us) = 0;
 };
 
 /// Abstract class for controller interface. Implemented in PSMoveController.cpp
@@ -538,8 +551,9 @@ public:
     // Returns the video frame size (used to compute frame buffer size)
     virtual bool getVideoFrameDimensions(int *out_width, int *out_height, int *out_stride) const = 0;
 
-    // Returns a pointer to the last video frame buffer captured
-    virtual const unsigned char *getVideoFrameBuffer() const = 0;
+    // Returns a reference to the last video frame captured.
+    // The frame contents won't change for as long as the reference is held.
+    virtual VideoFramePtr getVideoFrame() const = 0;
 
     static const char *getDriverTypeString(eDriverType device_type)
     {
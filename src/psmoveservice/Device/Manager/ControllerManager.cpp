@@ -10,11 +10,20 @@
 #include "ServerDeviceView.h"
 #include "ServerNetworkManager.h"
 #include "ServerUtility.h"
+#include "ReplayControllerEnumerator.h"
 #include "VirtualControllerEnumerator.h"
+#include "WorkStealingJobPool.h"
+#include "DeviceManager.h"
 
 #include "hidapi.h"
 #include "gamepad/Gamepad.h"
 
+#include <algorithm>
+
+//-- prototypes -----
+static void update_controller_state_job(void *job_context);
+static void update_controller_optical_pose_and_state_job(void *job_context);
+
 //-- methods -----
 //-- Tracker Manager Config -----
 const int ControllerManagerConfig::CONFIG_VERSION = 1;
@@ -22,6 +31,11 @@ const int ControllerManagerConfig::CONFIG_VERSION = 1;
 ControllerManagerConfig::ControllerManagerConfig(const std::string &fnamebase)
     : PSMoveConfig(fnamebase)
     , virtual_controller_count(0)
+    , controller_recording_path("controller_recordings")
+    , record_controller_hid_packets(false)
+    , replay_controller_hid_packets(false)
+    , controller_replay_speed(1.f)
+    , loop_controller_replay(true)
 {
 
 };
@@ -33,6 +47,11 @@ ControllerManagerConfig::config2ptree()
 
     pt.put("version", ControllerManagerConfig::CONFIG_VERSION);
     pt.put("virtual_controller_count", virtual_controller_count);
+    pt.put("controller_recording_path", controller_recording_path);
+    pt.put("record_controller_hid_packets", record_controller_hid_packets);
+    pt.put("replay_controller_hid_packets", replay_controller_hid_packets);
+    pt.put("controller_replay_speed", controller_replay_speed);
+    pt.put("loop_controller_replay", loop_controller_replay);
 
     return pt;
 }
@@ -45,6 +64,14 @@ ControllerManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
     if (version == ControllerManagerConfig::CONFIG_VERSION)
     {
         virtual_controller_count = pt.get<int>("virtual_controller_count", 0);
+        controller_recording_path = pt.get<std::string>("controller_recording_path", controller_recording_path);
+        record_controller_hid_packets = pt.get<bool>("record_controller_hid_packets", record_controller_hid_packets);
+        replay_controller_hid_packets = pt.get<bool>("replay_controller_hid_packets", replay_controller_hid_packets);
+        loop_controller_replay = pt.get<bool>("loop_controller_replay", loop_controller_replay);
+
+        // 0 replays as fast as the packets can be processed
+        controller_replay_speed = pt.get<float>("controller_replay_speed", controller_replay_speed);
+        controller_replay_speed = std::min(std::max(controller_replay_speed, 0.f), 100.f);
     }
     else
     {
@@ -82,6 +109,8 @@ ControllerManager::startup()
         // This breaks the dependency between the Controller Manager and the enumerator.
         VirtualControllerEnumerator::virtual_controller_count= cfg.virtual_controller_count;
         ControllerGamepadEnumerator::virtual_controller_count= cfg.virtual_controller_count;
+        ReplayControllerEnumerator::replay_enabled= cfg.replay_controller_hid_packets;
+        ReplayControllerEnumerator::recording_path= cfg.controller_recording_path;
 
         // Initialize HIDAPI
         if (hid_init() == -1)
@@ -123,8 +152,14 @@ ControllerManager::shutdown()
 }
 
 void
-ControllerManager::updateStateAndPredict(TrackerManager* tracker_manager)
+ControllerManager::updateStateAndPredict(TrackerManager* tracker_manager, WorkStealingJobPool *job_pool)
 {
+	// Tracker frame processing threads post optical poses as new video frames arrive
+	const WorkStealingJobPool::t_job_function update_job= 
+		tracker_manager->getConfig().use_tracker_processing_threads
+		? update_controller_state_job
+		: update_controller_optical_pose_and_state_job;
+
 	for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
 	{
 		ServerControllerViewPtr controllerView = getControllerViewPtr(device_id);
@@ -133,8 +168,8 @@ ControllerManager::updateStateAndPredict(TrackerManager* tracker_manager)
 			controllerView->getControllerDeviceType() != CommonDeviceState::PSNavi &&
             (controllerView->getIsBluetooth() || controllerView->getIsVirtualController()))
 		{
-			controllerView->updateOpticalPoseEstimation(tracker_manager);
-			controllerView->updateStateAndPredict();
+			// Each controller has its own pose filter, so the controllers can be updated in parallel
+			job_pool->addJob(update_job, controllerView.get());
 		}
 	}
 }
@@ -226,4 +261,22 @@ ControllerManager::getControllerViewPtr(int device_id)
     assert(m_deviceViews != nullptr);
 
     return std::static_pointer_cast<ServerControllerView>(m_deviceViews[device_id]);
-}
\ No newline at end of file
+}
+//-- private functions -----
+// Run on the device update job pool threads
+static void
+update_controller_state_job(void *job_context)
+{
+	ServerControllerView *controllerView = static_cast<ServerControllerView *>(job_context);
+
+	controllerView->updateStateAndPredict();
+}
+
+static void
+update_controller_optical_pose_and_state_job(void *job_context)
+{
+	ServerControllerView *controllerView = static_cast<ServerControllerView *>(job_context);
+
+	controllerView->updateOpticalPoseEstimation(DeviceManager::getInstance()->m_tracker_manager);
+	controllerView->updateStateAndPredict();
+}
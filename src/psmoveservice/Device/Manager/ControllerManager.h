@@ -11,6 +11,7 @@
 #include <memory>
 
 //-- typedefs -----
+class WorkStealingJobPool;
 class ServerControllerView;
 typedef std::shared_ptr<ServerControllerView> ServerControllerViewPtr;
 
@@ -27,6 +28,11 @@ public:
 
     int version;
     int virtual_controller_count;
+    std::string controller_recording_path;
+    bool record_controller_hid_packets;
+    bool replay_controller_hid_packets;
+    float controller_replay_speed;
+    bool loop_controller_replay;
 };
 
 class ControllerManager : public DeviceTypeManager
@@ -40,7 +46,9 @@ public:
     /// Call hid_close()
     void shutdown() override;
     
-    void updateStateAndPredict(TrackerManager* tracker_manager);
+    /// Adds a job to job_pool for each controller that needs its pose filter updated.
+    /// DeviceManager::update() runs the jobs before publishing.
+    void updateStateAndPredict(TrackerManager* tracker_manager, WorkStealingJobPool *job_pool);
     void publish() override;
 
     inline const ControllerManagerConfig& getConfig() const
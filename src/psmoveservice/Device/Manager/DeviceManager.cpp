@@ -19,8 +19,11 @@
 #include "PSMoveProtocol.pb.h"
 #include "PSMoveConfig.h"
 #include "TrackerManager.h"
+#include "WorkStealingJobPool.h"
 
+#include <algorithm>
 #include <chrono>
+#include <thread>
 
 //-- constants -----
 static const int k_default_controller_reconnect_interval= 1000; // ms
@@ -29,6 +32,7 @@ static const int k_default_tracker_reconnect_interval= 10000; // ms
 static const int k_default_tracker_poll_interval= 13; // 1000/75 ms
 static const int k_default_hmd_reconnect_interval= 10000; // ms
 static const int k_default_hmd_poll_interval= 2; // ms
+static const int k_default_device_update_thread_count= 0; // update serially on the main thread
 
 class DeviceManagerConfig : public PSMoveConfig
 {
@@ -45,6 +49,7 @@ public:
         , hmd_poll_interval(k_default_hmd_poll_interval)
 		, gamepad_api_enabled(true)
 		, platform_api_enabled(true)
+		, device_update_thread_count(k_default_device_update_thread_count)
     {};
 
     const boost::property_tree::ptree
@@ -61,6 +66,7 @@ public:
         pt.put("hmd_poll_interval", hmd_poll_interval); 
 		pt.put("gamepad_api_enabled", gamepad_api_enabled);
 		pt.put("platform_api_enabled", platform_api_enabled);
+		pt.put("device_update_thread_count", device_update_thread_count);
 
         return pt;
     }
@@ -80,6 +86,7 @@ public:
             hmd_poll_interval = pt.get<int>("hmd_poll_interval", k_default_hmd_poll_interval);
 		    gamepad_api_enabled = pt.get<bool>("gamepad_api_enabled", gamepad_api_enabled);
 		    platform_api_enabled = pt.get<bool>("platform_api_enabled", platform_api_enabled);
+		    device_update_thread_count = pt.get<int>("device_update_thread_count", k_default_device_update_thread_count);
         }
         else
         {
@@ -98,6 +105,7 @@ public:
     int hmd_poll_interval;    
 	bool gamepad_api_enabled;
 	bool platform_api_enabled;
+	int device_update_thread_count; // worker threads helping the main thread update the pose filters, -1 = one less than the number of cores
 };
 
 // DeviceManager - This is the interface used by PSMoveService
@@ -107,6 +115,7 @@ DeviceManager::DeviceManager()
     : m_config() // NULL config until startup
 	, m_platform_api_type(_eDevicePlatformApiType_None)
 	, m_platform_api(nullptr)
+	, m_device_update_job_pool(nullptr)
     , m_controller_manager(new ControllerManager())
     , m_tracker_manager(new TrackerManager())
     , m_hmd_manager(new HMDManager())
@@ -123,6 +132,11 @@ DeviceManager::~DeviceManager()
 	{
 		delete m_platform_api;
 	}
+
+	if (m_device_update_job_pool != nullptr)
+	{
+		delete m_device_update_job_pool;
+	}
 }
 
 bool
@@ -185,6 +199,20 @@ DeviceManager::startup()
     m_hmd_manager->reconnect_interval = hmd_reconnect_interval;
     m_hmd_manager->poll_interval = m_config->hmd_poll_interval;
     success &= m_hmd_manager->startup();    
+
+	// Every controller and HMD pose filter update is a job.
+	// The main thread works on the jobs too, so there's no use in more workers than jobs minus one.
+	const int max_device_update_job_count= m_controller_manager->getMaxDevices() + m_hmd_manager->getMaxDevices();
+	int device_update_thread_count= m_config->device_update_thread_count;
+	if (device_update_thread_count < 0)
+	{
+		device_update_thread_count= static_cast<int>(std::thread::hardware_concurrency()) - 1;
+	}
+	device_update_thread_count= std::max(std::min(device_update_thread_count, max_device_update_job_count - 1), 0);
+
+	m_device_update_job_pool= new WorkStealingJobPool("DeviceUpdate", max_device_update_job_count);
+	m_device_update_job_pool->startWorkers(device_update_thread_count);
+	SERVER_LOG_INFO("DeviceManager::startup") << "Updating device pose filters on " << device_update_thread_count << " worker threads";
     
     m_instance= this;
     
@@ -203,14 +231,23 @@ DeviceManager::update()
     m_tracker_manager->poll(); // Update tracker count and poll video frames
     m_hmd_manager->poll(); // Update HMD count and poll IMU state
 
-    m_controller_manager->updateStateAndPredict(m_tracker_manager); // Compute pose/prediction of tracking blob+IMU state
-    m_hmd_manager->updateStateAndPredict(m_tracker_manager); // Compute pose/prediction of tracking blobs+IMU state
+    m_controller_manager->updateStateAndPredict(m_tracker_manager, m_device_update_job_pool); // Compute pose/prediction of tracking blob+IMU state
+    m_hmd_manager->updateStateAndPredict(m_tracker_manager, m_device_update_job_pool); // Compute pose/prediction of tracking blobs+IMU state
+    m_device_update_job_pool->runJobs(); // Wait for every device to finish updating before publishing
 
     m_controller_manager->publish(); // publish controller state to any listening clients  (common case)
     m_tracker_manager->publish(); // publish tracker state to any listening clients (probably only used by ConfigTool)
     m_hmd_manager->publish(); // publish hmd state to any listening clients (common case)
 }
 
+std::chrono::time_point<std::chrono::high_resolution_clock>
+DeviceManager::getNextPollDeadline() const
+{
+    return std::min(
+        std::min(m_controller_manager->getNextPollDeadline(), m_tracker_manager->getNextPollDeadline()),
+        m_hmd_manager->getNextPollDeadline());
+}
+
 void
 DeviceManager::shutdown()
 {
@@ -219,16 +256,24 @@ DeviceManager::shutdown()
 		m_config->save();
 	}
 
-	if (m_controller_manager != nullptr)
+	// Stop the device update workers before any of the devices they update go away
+	if (m_device_update_job_pool != nullptr)
 	{
-	    m_controller_manager->shutdown();
+		m_device_update_job_pool->stopWorkers();
 	}
 
+	// Shutdown the trackers first so that their frame processing threads
+	// stop before the controller and hmd views they update get freed
 	if (m_tracker_manager != nullptr)
 	{
 	    m_tracker_manager->shutdown();
 	}
 
+	if (m_controller_manager != nullptr)
+	{
+	    m_controller_manager->shutdown();
+	}
+
 	if (m_hmd_manager != nullptr)
 	{
 	    m_hmd_manager->shutdown();
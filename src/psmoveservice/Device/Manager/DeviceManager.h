@@ -49,6 +49,9 @@ public:
     void update();  /**< Poll all connected devices for each specific manager. */
     void shutdown();/**< Shutdown the interfaces for each specific manager. */
 
+    /// The earliest time any of the specific managers has timed polling, reconnect or deferred publish work to do
+    std::chrono::time_point<std::chrono::high_resolution_clock> getNextPollDeadline() const;
+
     static inline DeviceManager *getInstance()
     { return m_instance; }
 
@@ -92,6 +95,9 @@ private:
 	// List of registered hot-plug listeners
 	std::vector<DeviceHotplugListener> m_listeners;
 
+	// Updates the controller and HMD pose filters in parallel
+	class WorkStealingJobPool *m_device_update_job_pool;
+
 public:
     class ControllerManager *m_controller_manager;
     class TrackerManager *m_tracker_manager;
@@ -8,6 +8,8 @@
 #include "ServerUtility.h"
 #include "ServerRequestHandler.h"
 
+#include <algorithm>
+
 //-- methods -----
 /// Constructor and set intervals (ms) for reconnect and polling
 DeviceTypeManager::DeviceTypeManager(const int recon_int, const int poll_int)
@@ -107,6 +109,39 @@ DeviceTypeManager::poll()
     }
 }
 
+std::chrono::time_point<std::chrono::high_resolution_clock>
+DeviceTypeManager::getNextPollDeadline() const
+{
+    std::chrono::time_point<std::chrono::high_resolution_clock> deadline=
+        std::chrono::time_point<std::chrono::high_resolution_clock>::max();
+
+    // Nothing to poll while no devices are open
+    bool bHasOpenDevice= false;
+    if (m_deviceViews != nullptr)
+    {
+        for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
+        {
+            bHasOpenDevice|= m_deviceViews[device_id]->getIsOpen();
+
+            // Nothing signals when a rate limited stream becomes due, so wake up for it
+            deadline= std::min(deadline, m_deviceViews[device_id]->getDeferredPublishDeadline());
+        }
+    }
+
+    // A dirty device list gets retried at the poll rate until it goes through
+    // (i.e. once pending bluetooth operations finish)
+    if (bHasOpenDevice || m_bIsDeviceListDirty)
+    {
+        deadline= std::min(deadline, m_last_poll_time + std::chrono::milliseconds(poll_interval));
+    }
+    else if (reconnect_interval > 0)
+    {
+        deadline= std::min(deadline, m_last_reconnect_time + std::chrono::milliseconds(reconnect_interval));
+    }
+
+    return deadline;
+}
+
 bool
 DeviceTypeManager::update_connected_devices()
 {
@@ -26,6 +26,10 @@ public:
     void poll();
     virtual void publish();
 
+    /// The next time poll() or publish() has timed work to do: polling the open devices, a reconnect scan,
+    /// or sending rate limited streams the state they skipped. Work handed over by device threads wakes the main loop sooner.
+    std::chrono::time_point<std::chrono::high_resolution_clock> getNextPollDeadline() const;
+
     virtual int getMaxDevices() const = 0;
 
     /**
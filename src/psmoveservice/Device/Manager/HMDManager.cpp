@@ -4,9 +4,16 @@
 #include "ServerLog.h"
 #include "ServerHMDView.h"
 #include "ServerDeviceView.h"
+#include "TrackerManager.h"
 #include "PSMoveProtocol.pb.h"
 #include <boost/foreach.hpp>
 #include "VirtualHMDDeviceEnumerator.h"
+#include "WorkStealingJobPool.h"
+#include "DeviceManager.h"
+
+//-- prototypes -----
+static void update_hmd_state_job(void *job_context);
+static void update_hmd_optical_pose_and_state_job(void *job_context);
 
 //-- methods -----
 //-- Tracker Manager Config -----
@@ -15,6 +22,8 @@ const int HMDManagerConfig::CONFIG_VERSION = 1;
 HMDManagerConfig::HMDManagerConfig(const std::string &fnamebase)
     : PSMoveConfig(fnamebase)
     , virtual_hmd_count(0)
+    , hmd_recording_path("hmd_recordings")
+    , record_hmd_hid_packets(false)
 {
 
 };
@@ -26,6 +35,8 @@ HMDManagerConfig::config2ptree()
 
     pt.put("version", HMDManagerConfig::CONFIG_VERSION);
     pt.put("virtual_hmd_count", virtual_hmd_count);
+    pt.put("hmd_recording_path", hmd_recording_path);
+    pt.put("record_hmd_hid_packets", record_hmd_hid_packets);
 
     return pt;
 }
@@ -38,6 +49,8 @@ HMDManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
     if (version == HMDManagerConfig::CONFIG_VERSION)
     {
         virtual_hmd_count = pt.get<int>("virtual_hmd_count", 0);
+        hmd_recording_path = pt.get<std::string>("hmd_recording_path", hmd_recording_path);
+        record_hmd_hid_packets = pt.get<bool>("record_hmd_hid_packets", record_hmd_hid_packets);
     }
     else
     {
@@ -83,16 +96,22 @@ HMDManager::shutdown()
 }
 
 void
-HMDManager::updateStateAndPredict(TrackerManager* tracker_manager)
+HMDManager::updateStateAndPredict(TrackerManager* tracker_manager, WorkStealingJobPool *job_pool)
 {
+	// Tracker frame processing threads update the optical pose as new video frames arrive
+	const WorkStealingJobPool::t_job_function update_job= 
+		tracker_manager->getConfig().use_tracker_processing_threads
+		? update_hmd_state_job
+		: update_hmd_optical_pose_and_state_job;
+
 	for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
 	{
 		ServerHMDViewPtr hmdView = getHMDViewPtr(device_id);
 
 		if (hmdView->getIsOpen())
 		{
-			hmdView->updateOpticalPoseEstimation(tracker_manager);
-			hmdView->updateStateAndPredict();
+			// Each HMD has its own pose filter, so the HMDs can be updated in parallel
+			job_pool->addJob(update_job, hmdView.get());
 		}
 	}
 }
@@ -133,4 +152,22 @@ int
 HMDManager::getListUpdatedResponseType()
 {
     return (int)PSMoveProtocol::Response_ResponseType_HMD_LIST_UPDATED;
-}
\ No newline at end of file
+}
+//-- private functions -----
+// Run on the device update job pool threads
+static void
+update_hmd_state_job(void *job_context)
+{
+	ServerHMDView *hmdView = static_cast<ServerHMDView *>(job_context);
+
+	hmdView->updateStateAndPredict();
+}
+
+static void
+update_hmd_optical_pose_and_state_job(void *job_context)
+{
+	ServerHMDView *hmdView = static_cast<ServerHMDView *>(job_context);
+
+	hmdView->updateOpticalPoseEstimation(DeviceManager::getInstance()->m_tracker_manager);
+	hmdView->updateStateAndPredict();
+}
@@ -14,6 +14,7 @@
 class ServerHMDView;
 typedef std::shared_ptr<ServerHMDView> ServerHMDViewPtr;
 class TrackerManager;
+class WorkStealingJobPool;
 
 //-- definitions -----
 class HMDManagerConfig : public PSMoveConfig
@@ -28,6 +29,8 @@ public:
 
     int version;
     int virtual_hmd_count;
+    std::string hmd_recording_path;
+    bool record_hmd_hid_packets;
 };
 
 class HMDManager : public DeviceTypeManager
@@ -38,7 +41,9 @@ public:
     virtual bool startup() override;
     virtual void shutdown() override;
 
-	void updateStateAndPredict(TrackerManager* tracker_manager);
+	/// Adds a job to job_pool for each HMD that needs its pose filter updated.
+	/// DeviceManager::update() runs the jobs before publishing.
+	void updateStateAndPredict(TrackerManager* tracker_manager, WorkStealingJobPool *job_pool);
 
     static const int k_max_devices = PSMOVESERVICE_MAX_HMD_COUNT;
     int getMaxDevices() const override
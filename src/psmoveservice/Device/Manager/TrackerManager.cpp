@@ -1,6 +1,7 @@
 //-- includes -----
 #include "TrackerManager.h"
 #include "TrackerDeviceEnumerator.h"
+#include "ReplayTrackerEnumerator.h"
 #include "ControllerManager.h"
 #include "DeviceManager.h"
 #include "HMDManager.h"
@@ -25,8 +26,20 @@ TrackerManagerConfig::TrackerManagerConfig(const std::string &fnamebase)
 	ignore_pose_from_one_tracker = false;
     optical_tracking_timeout= 100;
 	tracker_sleep_ms = 1;
+	use_event_driven_main_loop = false;
 	use_bgr_to_hsv_lookup_table = true;
+	use_fused_hsv_color_classifier = false;
+	use_color_membership_cubes = false;
+	use_run_length_blob_extractor = false;
+	use_shared_frame_segmentation = false;
+	use_tracker_processing_threads = false;
+	tracker_recording_path = "tracker_recordings";
+	record_tracker_video = false;
+	replay_tracker_video = false;
+	replay_tracker_at_max_speed = false;
+	loop_tracker_replay = true;
 	exclude_opposed_cameras = false;
+	triangulation_refinement_iterations = 2;
 	min_valid_projection_area= 16;
 	disable_roi = false;
 	default_tracker_profile.frame_width = 640;
@@ -53,9 +66,21 @@ TrackerManagerConfig::config2ptree()
 	pt.put("ignore_pose_from_one_tracker", ignore_pose_from_one_tracker);
     pt.put("optical_tracking_timeout", optical_tracking_timeout);
 	pt.put("use_bgr_to_hsv_lookup_table", use_bgr_to_hsv_lookup_table);
+	pt.put("use_fused_hsv_color_classifier", use_fused_hsv_color_classifier);
+	pt.put("use_color_membership_cubes", use_color_membership_cubes);
+	pt.put("use_run_length_blob_extractor", use_run_length_blob_extractor);
+	pt.put("use_shared_frame_segmentation", use_shared_frame_segmentation);
+	pt.put("use_tracker_processing_threads", use_tracker_processing_threads);
+	pt.put("tracker_recording_path", tracker_recording_path);
+	pt.put("record_tracker_video", record_tracker_video);
+	pt.put("replay_tracker_video", replay_tracker_video);
+	pt.put("replay_tracker_at_max_speed", replay_tracker_at_max_speed);
+	pt.put("loop_tracker_replay", loop_tracker_replay);
 	pt.put("tracker_sleep_ms", tracker_sleep_ms);
+	pt.put("use_event_driven_main_loop", use_event_driven_main_loop);
 
 	pt.put("excluded_opposed_cameras", exclude_opposed_cameras);	
+	pt.put("triangulation_refinement_iterations", triangulation_refinement_iterations);
 
 	pt.put("min_valid_projection_area", min_valid_projection_area);	
 
@@ -85,8 +110,20 @@ TrackerManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
 		ignore_pose_from_one_tracker = pt.get<bool>("ignore_pose_from_one_tracker", ignore_pose_from_one_tracker);
         optical_tracking_timeout= pt.get<int>("optical_tracking_timeout", optical_tracking_timeout);
 		use_bgr_to_hsv_lookup_table = pt.get<bool>("use_bgr_to_hsv_lookup_table", use_bgr_to_hsv_lookup_table);
+		use_fused_hsv_color_classifier = pt.get<bool>("use_fused_hsv_color_classifier", use_fused_hsv_color_classifier);
+		use_color_membership_cubes = pt.get<bool>("use_color_membership_cubes", use_color_membership_cubes);
+		use_run_length_blob_extractor = pt.get<bool>("use_run_length_blob_extractor", use_run_length_blob_extractor);
+		use_shared_frame_segmentation = pt.get<bool>("use_shared_frame_segmentation", use_shared_frame_segmentation);
+		use_tracker_processing_threads = pt.get<bool>("use_tracker_processing_threads", use_tracker_processing_threads);
+		tracker_recording_path = pt.get<std::string>("tracker_recording_path", tracker_recording_path);
+		record_tracker_video = pt.get<bool>("record_tracker_video", record_tracker_video);
+		replay_tracker_video = pt.get<bool>("replay_tracker_video", replay_tracker_video);
+		replay_tracker_at_max_speed = pt.get<bool>("replay_tracker_at_max_speed", replay_tracker_at_max_speed);
+		loop_tracker_replay = pt.get<bool>("loop_tracker_replay", loop_tracker_replay);
 		tracker_sleep_ms = pt.get<int>("tracker_sleep_ms", tracker_sleep_ms);
+		use_event_driven_main_loop = pt.get<bool>("use_event_driven_main_loop", use_event_driven_main_loop);
 		exclude_opposed_cameras = pt.get<bool>("excluded_opposed_cameras", exclude_opposed_cameras);
+		triangulation_refinement_iterations = pt.get<int>("triangulation_refinement_iterations", triangulation_refinement_iterations);
 		min_valid_projection_area = pt.get<float>("min_valid_projection_area", min_valid_projection_area);	
 		disable_roi = pt.get<bool>("disable_roi", disable_roi);
 		default_tracker_profile.frame_width = pt.get<float>("default_tracker_profile.frame_width", 640);
@@ -163,6 +200,10 @@ TrackerManager::startup()
         // Save back out the config in case there were updated defaults
         cfg.save();
 
+        // Replaying recorded trackers takes the place of recording new ones
+        ReplayTrackerEnumerator::replay_enabled= cfg.replay_tracker_video;
+        ReplayTrackerEnumerator::recording_path= cfg.tracker_recording_path;
+
         // Refresh the tracker list
         mark_tracker_list_dirty();
 
@@ -54,8 +54,20 @@ public:
     long version;
     int optical_tracking_timeout;
 	int tracker_sleep_ms;
+	bool use_event_driven_main_loop; // sleep until device or network events rather than tracker_sleep_ms (runs the network thread)
 	bool use_bgr_to_hsv_lookup_table;
+	bool use_fused_hsv_color_classifier;
+	bool use_color_membership_cubes;
+	bool use_run_length_blob_extractor;
+	bool use_shared_frame_segmentation;
+	bool use_tracker_processing_threads;
+	std::string tracker_recording_path;
+	bool record_tracker_video;
+	bool replay_tracker_video;
+	bool replay_tracker_at_max_speed;
+	bool loop_tracker_replay;
 	bool exclude_opposed_cameras;
+	int triangulation_refinement_iterations;
 	float min_valid_projection_area;
 	bool disable_roi;
     TrackerProfile default_tracker_profile;
@@ -4,6 +4,7 @@
 #include "USBDeviceInfo.h"
 #include "LibUSBBulkTransferBundle.h"
 #include "LibUSBApi.h"
+#include "MainLoopWakeSignal.h"
 #include "NullUSBApi.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
@@ -383,6 +384,7 @@ public:
 		}
 
 		result_queue.push(state);
+		MainLoopWakeSignal::notify();
 	}
 
 protected:
@@ -5,7 +5,9 @@
 #include "BluetoothRequests.h"
 #include "ControllerManager.h"
 #include "DeviceManager.h"
+#include "MainLoopWakeSignal.h"
 #include "MathAlignment.h"
+#include "PipelineLatency.h"
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
 #include "CompoundPoseFilter.h"
@@ -18,9 +20,12 @@
 #include "PSMoveProtocol.pb.h"
 #include "ServerUtility.h"
 #include "ServerTrackerView.h"
+#include "SharedDeviceState.h"
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+
 //-- typedefs ----
 using t_high_resolution_timepoint= std::chrono::time_point<std::chrono::high_resolution_clock>;
 using t_high_resolution_duration= t_high_resolution_timepoint::duration;
@@ -58,11 +63,13 @@ static void post_imu_filter_packets_for_psmove(
 	const PSMoveControllerInputState *psmoveState,
     const t_high_resolution_timepoint now, 
 	const t_high_resolution_duration secondsSinceLastUpdate,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_sensor_queue *pose_filter_queue);
 static void post_optical_filter_packet_for_psmove(
     const PSMoveController *psmove,
     const t_high_resolution_timepoint now,
     const ControllerOpticalPoseEstimation *poseEstimation,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_optical_queue *pose_filter_queue);
 
 static void post_imu_filter_packets_for_ds4(
@@ -70,17 +77,20 @@ static void post_imu_filter_packets_for_ds4(
 	const DualShock4ControllerInputState *psmoveState,
     const t_high_resolution_timepoint now, 
 	const t_high_resolution_duration secondsSinceLastUpdate,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_sensor_queue *pose_filter_queue);
 static void post_optical_filter_packet_for_ds4(
     const PSDualShock4Controller *ds4,
     const t_high_resolution_timepoint now,
     const ControllerOpticalPoseEstimation *poseEstimation,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_optical_queue *pose_filter_queue);
 
 static void post_optical_filter_packet_for_virtual_controller(
     const VirtualController *ds4,
     const t_high_resolution_timepoint now,
     const ControllerOpticalPoseEstimation *poseEstimation,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_optical_queue *pose_filter_queue);
 
 static void generate_psmove_data_frame_for_stream(
@@ -91,6 +101,9 @@ static void generate_psdualshock4_data_frame_for_stream(
     const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, PSMoveProtocol::DeviceOutputDataFrame *data_frame);
 static void generate_virtual_controller_data_frame_for_stream(
     const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, PSMoveProtocol::DeviceOutputDataFrame *data_frame);
+static unsigned int get_psmove_button_bitmask(const PSMoveControllerInputState *psmove_state);
+static unsigned int get_psnavi_button_bitmask(const PSNaviControllerInputState *psnavi_state);
+static unsigned int get_psdualshock4_button_bitmask(const DualShock4ControllerInputState *psds4_state);
 
 static void computeSpherePoseForControllerFromSingleTracker(
     const ServerControllerView *controllerView,
@@ -125,6 +138,10 @@ ServerControllerView::ServerControllerView(const int device_id)
     , m_roi_disable_count(0)
     , m_LED_override_active(false)
     , m_device(nullptr)
+    , m_lastSensorDataTimestamp()
+    , m_bIsLastSensorDataTimestampValid(false)
+    , m_replayBaseTimestamp()
+    , m_lastReplaySampleTimeUs(0)
     , m_tracker_pose_estimations(nullptr)
     , m_multicam_pose_estimation(nullptr)
     , m_pose_filter(nullptr)
@@ -132,7 +149,9 @@ ServerControllerView::ServerControllerView(const int device_id)
     , m_lastPollSeqNumProcessed(-1)
     , m_last_filter_update_timestamp()
     , m_last_filter_update_timestamp_valid(false)
+    , m_last_filter_sample_time_us(0)
 {
+    m_last_filter_stage_times.clear();
     m_tracking_color = std::make_tuple(0x00, 0x00, 0x00);
     m_LED_override_color = std::make_tuple(0x00, 0x00, 0x00);
 }
@@ -144,6 +163,8 @@ ServerControllerView::~ServerControllerView()
 bool ServerControllerView::allocate_device_interface(
     const class DeviceEnumerator *enumerator)
 {
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
     switch (enumerator->get_device_type())
     {
     case CommonDeviceState::PSMove:
@@ -207,6 +228,8 @@ bool ServerControllerView::allocate_device_interface(
 
 void ServerControllerView::free_device_interface()
 {
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
     if (m_multicam_pose_estimation != nullptr)
     {
         delete m_multicam_pose_estimation;
@@ -329,6 +352,8 @@ bool ServerControllerView::open(const class DeviceEnumerator *enumerator)
     // Clear the filter update timestamp
     m_last_filter_update_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
     m_last_filter_update_timestamp_valid= false;
+    m_last_filter_stage_times.clear();
+    m_last_filter_sample_time_us= 0;
 
     return bSuccess;
 }
@@ -351,6 +376,7 @@ void ServerControllerView::close()
 
 bool ServerControllerView::recenterOrientation(const CommonDeviceQuaternion& q_pose_relative_to_identity_pose)
 {
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
     bool bSuccess = false;
     IPoseFilter *filter = getPoseFilterMutable();
 
@@ -398,6 +424,7 @@ bool ServerControllerView::recenterOrientation(const CommonDeviceQuaternion& q_p
 
 void ServerControllerView::resetPoseFilter()
 {
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
     assert(m_device != nullptr);
 
     if (m_pose_filter != nullptr)
@@ -442,175 +469,320 @@ void ServerControllerView::resetPoseFilter()
 
 void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_manager)
 {
-    const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
-
     // TODO: Probably need to first update IMU state to get velocity.
     // If velocity is too high, don't bother getting a new position.
     // Though it may be enough to just use the camera ROI as the limit.
+
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
+    // Timestamped under the lock, so the optical poses reach the filter in timestamp order
+    // no matter which thread fuses them
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+
+    PipelineStageTimes stage_times;
+    stage_times.clear();
     
     if (getIsTrackingEnabled())
     {
-        int valid_projection_tracker_ids[TrackerManager::k_max_devices];
-        int projections_found = 0;
-
-        CommonDeviceTrackingShape trackingShape;
-        m_device->getTrackingShape(trackingShape);
-        assert(trackingShape.shape_type != eCommonTrackingShapeType::INVALID_SHAPE);
-
-        // Find the projection of the controller from the perspective of each tracker.
+        // Find the projection of the controller from the perspective of each tracker with a new video frame.
         // In the case of sphere projections, go ahead and compute the tracker relative position as well.
         for (int tracker_id = 0; tracker_id < tracker_manager->getMaxDevices(); ++tracker_id)
         {
             ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
-            ControllerOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
 
-            const bool bWasTracking= trackerPoseEstimateRef.bCurrentlyTracking;
+            // Trackers with a frame processing thread call notifyTrackerDataReceived() instead
+            if (tracker->getIsOpen() && 
+                !tracker->getIsFrameProcessingThreaded() && 
+                tracker->getHasUnpublishedState())
+            {
+                ControllerOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
 
-            // Assume we're going to lose tracking this frame
-            bool bCurrentlyTracking = false;
+                // Time the newest of the frames that go into the fused pose
+                if (tracker->getFrameCaptureTimeUs() > stage_times.capture_us)
+                {
+                    stage_times.capture_us= tracker->getFrameCaptureTimeUs();
+                    stage_times.segmentation_done_us= tracker->getFrameSegmentationDoneTimeUs();
+                }
 
-            if (tracker->getIsOpen())
-            {
-                // See how long it's been since we got a new video frame
-                const std::chrono::time_point<std::chrono::high_resolution_clock> now= 
-                    std::chrono::high_resolution_clock::now();
-                const std::chrono::duration<float, std::milli> timeSinceNewDataMillis= 
-                    now - tracker->getLastNewDataTimestamp();
-                const float timeoutMilli= 
-                    static_cast<float>(DeviceManager::getInstance()->m_tracker_manager->getConfig().optical_tracking_timeout);
-
-                // Can't compute tracking on video data that's too old
-                if (timeSinceNewDataMillis.count() < timeoutMilli)
+                // Search with the same request the frame was segmented with.
+                // Rebuilding it now would center the ROI on where the filter has moved to since.
+                TrackedDeviceProjectionRequest request;
+                if (!tracker->getSegmentedProjectionRequestForController(getDeviceID(), &request))
                 {
-                    // Initially the newTrackerPoseEstimate is a copy of the existing pose
-                    bool bIsVisibleThisUpdate= false;
+                    build_projection_request(tracker.get(), &request);
+                }
 
-                    // If a new video frame is available this tick, 
-                    // attempt to update the tracking location
-                    if (tracker->getHasUnpublishedState())
-                    {
-                        // Create a copy of the pose estimate state so that in event of a 
-                        // failure part way through computing the projection we don't
-                        // set partially valid state
-                        ControllerOpticalPoseEstimation newTrackerPoseEstimate= trackerPoseEstimateRef;
-
-                        if (tracker->computeProjectionForController(
-                                this, 
-                                &trackingShape,
-                                &newTrackerPoseEstimate))
-                        {
-                            bIsVisibleThisUpdate= true;
+                // Create a copy of the pose estimate state so that in event of a 
+                // failure part way through computing the projection we don't
+                // set partially valid state
+                ControllerOpticalPoseEstimation newTrackerPoseEstimate= trackerPoseEstimateRef;
 
-                            // Actually apply the pose estimate state
-                            trackerPoseEstimateRef= newTrackerPoseEstimate;
-                            trackerPoseEstimateRef.last_visible_timestamp = now;
-                        }
-                    }
+                if (tracker->computeProjectionForController(&request, &newTrackerPoseEstimate))
+                {
+                    // Actually apply the pose estimate state
+                    trackerPoseEstimateRef= newTrackerPoseEstimate;
+                    trackerPoseEstimateRef.last_visible_timestamp = now;
+                    trackerPoseEstimateRef.bCurrentlyTracking = true;
+                }
+            }
+        }
 
-                    // If the projection isn't too old (or updated this tick), 
-                    // say we have a valid tracked location
-                    if (bWasTracking || bIsVisibleThisUpdate)
-                    {
-                        const std::chrono::duration<float, std::milli> timeSinceLastVisibleMillis= 
-                            now - trackerPoseEstimateRef.last_visible_timestamp;
+        update_multicam_pose_estimation(tracker_manager, now);
 
-                        if (timeSinceLastVisibleMillis.count() < timeoutMilli)
-                        {
-                            // If this tracker has a valid projection for the controller
-                            // add it to the tracker id list
-                            valid_projection_tracker_ids[projections_found] = tracker_id;
-                            ++projections_found;
+        stage_times.triangulation_done_us= PipelineLatencyStats::getTimestampUs();
+        PipelineLatencyStats::recordStageLatency(
+            PipelineLatencyStage_SegmentationToTriangulation, stage_times.segmentation_done_us, stage_times.triangulation_done_us);
+    }
 
-                            // Flag this pose estimate as invalid
-                            bCurrentlyTracking = true;
-                        }
-                    }
-                }
-            }
+	// Update the filter if we have a valid optically tracked pose
+    post_optical_pose_estimation(now, stage_times);
+}
+
+bool ServerControllerView::getProjectionRequestForTracker(
+    const ServerTrackerView *tracker,
+    TrackedDeviceProjectionRequest *out_request,
+    ControllerOpticalPoseEstimation *out_prior_pose_estimate) const
+{
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
 
-            // Keep track of the last time the position estimate was updated
-            trackerPoseEstimateRef.last_update_timestamp = now;
-            trackerPoseEstimateRef.bValidTimestamps = true;
-            trackerPoseEstimateRef.bCurrentlyTracking = bCurrentlyTracking;
+    if (!get_is_optically_trackable_internal())
+    {
+        return false;
+    }
+
+    build_projection_request(tracker, out_request);
+    *out_prior_pose_estimate= m_tracker_pose_estimations[tracker->getDeviceID()];
+
+    return true;
+}
+
+void ServerControllerView::notifyTrackerDataReceived(
+    ServerTrackerView *tracker,
+    const TrackedDeviceProjectionRequest *request,
+    const ControllerOpticalPoseEstimation *prior_pose_estimate)
+{
+    const int tracker_id= tracker->getDeviceID();
+    ControllerOpticalPoseEstimation newTrackerPoseEstimate= *prior_pose_estimate;
+
+    // Search the video frame without holding the lock so that 
+    // other trackers can process their frames for this controller in parallel
+    const bool bIsVisible= tracker->computeProjectionForController(request, &newTrackerPoseEstimate);
+
+    // Fuse the new projection with the other trackers and post the result to the filter
+    {
+        std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
+        // Another tracker thread may have posted while this one waited on the lock,
+        // so only now is the timestamp guaranteed to be newer than the last one posted
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+
+        // The controller may have been closed or stopped tracking while we were busy
+        if (!get_is_optically_trackable_internal())
+        {
+            return;
         }
 
-        // How we compute the final world pose estimate varies based on
-        // * Number of trackers that currently have a valid projections of the controller
-        // * The kind of projection shape (psmove sphere or ds4 lightbar)
-        if (projections_found > 1)
+        if (bIsVisible)
         {
-            // If multiple trackers can see the controller, 
-            // triangulate all pairs of projections and average the results
-            switch (trackingShape.shape_type)
-            {
-            case eCommonTrackingShapeType::Sphere:
-                computeSpherePoseForControllerFromMultipleTrackers(
-                    this,
-                    tracker_manager,
-                    valid_projection_tracker_ids,
-                    projections_found,
-                    m_tracker_pose_estimations,
-                    m_multicam_pose_estimation);
-                break;
-            case eCommonTrackingShapeType::LightBar:
-                computeLightBarPoseForControllerFromMultipleTrackers(
-                    this,
-                    tracker_manager,
-                    valid_projection_tracker_ids,
-                    projections_found,
-                    m_tracker_pose_estimations,
-                    m_multicam_pose_estimation);
-                break;
-            default:
-                assert(false && "unreachable");
-            }
+            ControllerOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
+
+            trackerPoseEstimateRef= newTrackerPoseEstimate;
+            trackerPoseEstimateRef.last_visible_timestamp = now;
+            trackerPoseEstimateRef.bCurrentlyTracking = true;
         }
-        else if (projections_found == 1 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
+
+        update_multicam_pose_estimation(DeviceManager::getInstance()->m_tracker_manager, now);
+
+        PipelineStageTimes stage_times;
+        stage_times.clear();
+        stage_times.capture_us= tracker->getFrameCaptureTimeUs();
+        stage_times.segmentation_done_us= tracker->getFrameSegmentationDoneTimeUs();
+        stage_times.triangulation_done_us= PipelineLatencyStats::getTimestampUs();
+        PipelineLatencyStats::recordStageLatency(
+            PipelineLatencyStage_SegmentationToTriangulation, stage_times.segmentation_done_us, stage_times.triangulation_done_us);
+
+        post_optical_pose_estimation(now, stage_times);
+    }
+}
+
+bool ServerControllerView::get_is_optically_trackable_internal() const
+{
+    return 
+        getIsOpen() &&
+        getIsTrackingEnabled() &&
+        getControllerDeviceType() != CommonDeviceState::PSNavi &&
+        (getIsBluetooth() || getIsVirtualController());
+}
+
+void ServerControllerView::build_projection_request(
+    const ServerTrackerView *tracker,
+    TrackedDeviceProjectionRequest *out_request) const
+{
+    m_device->getTrackingShape(out_request->tracking_shape);
+    assert(out_request->tracking_shape.shape_type != eCommonTrackingShapeType::INVALID_SHAPE);
+
+    // Get the HSV filter used to find the tracking blob.
+    // This can run on the tracker's frame processing thread, so use the preset the tracker published
+    // for its latest video frame. If the color changed since then, skip this frame.
+    eCommonTrackingColorID tracked_color_id = getTrackingColorID();
+    if (tracked_color_id != eCommonTrackingColorID::INVALID_COLOR &&
+        !tracker->getPublishedControllerTrackingColorPreset(getDeviceID(), tracked_color_id, &out_request->hsv_color_range))
+    {
+        tracked_color_id= eCommonTrackingColorID::INVALID_COLOR;
+    }
+    out_request->tracking_color_id= tracked_color_id;
+    if (tracked_color_id == eCommonTrackingColorID::INVALID_COLOR)
+    {
+        out_request->hsv_color_range.clear();
+    }
+
+    // Center the region of interest on the current filtered position
+    out_request->bIsROIDisabled= getIsROIDisabled();
+    out_request->roi_world_position_cm= getFilteredPose().PositionCm;
+}
+
+void ServerControllerView::update_multicam_pose_estimation(
+    const TrackerManager* tracker_manager,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &now)
+{
+    int valid_projection_tracker_ids[TrackerManager::k_max_devices];
+    int projections_found = 0;
+
+    CommonDeviceTrackingShape trackingShape;
+    m_device->getTrackingShape(trackingShape);
+    assert(trackingShape.shape_type != eCommonTrackingShapeType::INVALID_SHAPE);
+
+    const float timeoutMilli= 
+        static_cast<float>(DeviceManager::getInstance()->m_tracker_manager->getConfig().optical_tracking_timeout);
+
+    // Determine which trackers still have a recent enough projection of the controller.
+    // The pose estimates are guarded by m_pose_estimation_mutex, which the caller holds,
+    // but the other trackers' state has to come from the copy they publish for their threads.
+    for (int tracker_id = 0; tracker_id < tracker_manager->getMaxDevices(); ++tracker_id)
+    {
+        ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
+        ControllerOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
+
+        TrackerFusionState trackerState;
+        tracker->getFusionState(&trackerState);
+
+        const bool bWasTracking= trackerPoseEstimateRef.bCurrentlyTracking;
+
+        // Assume we're going to lose tracking this frame
+        bool bCurrentlyTracking = false;
+
+        if (trackerState.bIsOpen)
         {
-            const int tracker_id = valid_projection_tracker_ids[0];
-            const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
+            // See how long it's been since we got a new video frame
+            const std::chrono::duration<float, std::milli> timeSinceNewDataMillis= 
+                now - trackerState.last_new_data_timestamp;
 
-            // If only one tracker can see the controller, 
-            // then use the tracker to derive a world space location
-            switch (trackingShape.shape_type)
+            // Can't compute tracking on video data that's too old
+            // If the projection isn't too old (or updated this tick), 
+            // say we have a valid tracked location
+            if (timeSinceNewDataMillis.count() < timeoutMilli && bWasTracking)
             {
-            case eCommonTrackingShapeType::Sphere:
-                computeSpherePoseForControllerFromSingleTracker(
-                    this,
-                    tracker,
-                    &m_tracker_pose_estimations[tracker_id],
-                    m_multicam_pose_estimation);
-                break;
-            case eCommonTrackingShapeType::LightBar:
-                computeLightBarPoseForControllerFromSingleTracker(
-                    this,
-                    tracker,
-                    &m_tracker_pose_estimations[tracker_id],
-                    m_multicam_pose_estimation);
-                break;
-            default:
-                assert(false && "unreachable");
+                const std::chrono::duration<float, std::milli> timeSinceLastVisibleMillis= 
+                    now - trackerPoseEstimateRef.last_visible_timestamp;
+
+                if (timeSinceLastVisibleMillis.count() < timeoutMilli)
+                {
+                    // If this tracker has a valid projection for the controller
+                    // add it to the tracker id list
+                    valid_projection_tracker_ids[projections_found] = tracker_id;
+                    ++projections_found;
+
+                    // Flag this pose estimate as invalid
+                    bCurrentlyTracking = true;
+                }
             }
         }
-        // If no trackers can see the controller, maintain the last known position and time it was seen
-        else
-        {
-            m_multicam_pose_estimation->bCurrentlyTracking= false;
+
+        // Keep track of the last time the position estimate was updated
+        trackerPoseEstimateRef.last_update_timestamp = now;
+        trackerPoseEstimateRef.bValidTimestamps = true;
+        trackerPoseEstimateRef.bCurrentlyTracking = bCurrentlyTracking;
+    }
+
+    // How we compute the final world pose estimate varies based on
+    // * Number of trackers that currently have a valid projections of the controller
+    // * The kind of projection shape (psmove sphere or ds4 lightbar)
+    if (projections_found > 1)
+    {
+        // If multiple trackers can see the controller, 
+        // triangulate all pairs of projections and average the results
+        switch (trackingShape.shape_type)
+        {
+        case eCommonTrackingShapeType::Sphere:
+            computeSpherePoseForControllerFromMultipleTrackers(
+                this,
+                tracker_manager,
+                valid_projection_tracker_ids,
+                projections_found,
+                m_tracker_pose_estimations,
+                m_multicam_pose_estimation);
+            break;
+        case eCommonTrackingShapeType::LightBar:
+            computeLightBarPoseForControllerFromMultipleTrackers(
+                this,
+                tracker_manager,
+                valid_projection_tracker_ids,
+                projections_found,
+                m_tracker_pose_estimations,
+                m_multicam_pose_estimation);
+            break;
+        default:
+            assert(false && "unreachable");
         }
+    }
+    else if (projections_found == 1 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
+    {
+        const int tracker_id = valid_projection_tracker_ids[0];
+        const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
 
-        // Update the position estimation timestamps
-        if (m_multicam_pose_estimation->bCurrentlyTracking)
+        // If only one tracker can see the controller, 
+        // then use the tracker to derive a world space location
+        switch (trackingShape.shape_type)
         {
-            m_multicam_pose_estimation->last_visible_timestamp = now;
+        case eCommonTrackingShapeType::Sphere:
+            computeSpherePoseForControllerFromSingleTracker(
+                this,
+                tracker,
+                &m_tracker_pose_estimations[tracker_id],
+                m_multicam_pose_estimation);
+            break;
+        case eCommonTrackingShapeType::LightBar:
+            computeLightBarPoseForControllerFromSingleTracker(
+                this,
+                tracker,
+                &m_tracker_pose_estimations[tracker_id],
+                m_multicam_pose_estimation);
+            break;
+        default:
+            assert(false && "unreachable");
         }
-        m_multicam_pose_estimation->last_update_timestamp = now;
-        m_multicam_pose_estimation->bValidTimestamps = true;
+    }
+    // If no trackers can see the controller, maintain the last known position and time it was seen
+    else
+    {
+        m_multicam_pose_estimation->bCurrentlyTracking= false;
     }
 
-	// Update the filter if we have a valid optically tracked pose
-	// TODO: These packets will eventually get posted from the notifyTrackerDataReceived()
-	// callback function which will be called by camera processing threads as new video
-	// frames are received.
+    // Update the position estimation timestamps
+    if (m_multicam_pose_estimation->bCurrentlyTracking)
+    {
+        m_multicam_pose_estimation->last_visible_timestamp = now;
+    }
+    m_multicam_pose_estimation->last_update_timestamp = now;
+    m_multicam_pose_estimation->bValidTimestamps = true;
+}
+
+void ServerControllerView::post_optical_pose_estimation(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &now,
+    const PipelineStageTimes &stage_times)
+{
+	// Update the filter if we have a valid optically tracked pose.
+	// When tracker frame processing threads are used this gets called from those threads.
 	if (m_multicam_pose_estimation->bCurrentlyTracking)
 	{
 		switch (getControllerDeviceType())
@@ -623,6 +795,7 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
 					psmove,
 					now,
 					m_multicam_pose_estimation,
+					stage_times,
 					&m_PoseSensorOpticalPacketQueue);
 			} break;
 		case CommonDeviceState::PSDualShock4:
@@ -633,6 +806,7 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
 					ds4,
 					now,
 					m_multicam_pose_estimation,
+					stage_times,
 					&m_PoseSensorOpticalPacketQueue);
 			} break;
 		case CommonDeviceState::VirtualController:
@@ -643,6 +817,7 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
 					virtual_controller,
 					now,
 					m_multicam_pose_estimation,
+					stage_times,
 					&m_PoseSensorOpticalPacketQueue);
 			} break;
 		default:
@@ -653,9 +828,37 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
 
 void 
 ServerControllerView::notifySensorDataReceived(const CommonDeviceState *sensor_state)
+{
+    post_sensor_data_received(sensor_state, std::chrono::high_resolution_clock::now());
+}
+
+void 
+ServerControllerView::notifyRecordedSensorDataReceived(const CommonDeviceState *sensor_state, int64_t sample_time_us)
+{
+	// Replays can run faster than real time, so the filter is fed the recorded sample times
+	// (anchored at the first replayed packet) rather than the time the packet was handed to us.
+	// Re-anchor when the replay restarts so that filter time never runs backwards.
+	if (!m_bIsLastSensorDataTimestampValid || sample_time_us < m_lastReplaySampleTimeUs)
+	{
+		const t_high_resolution_timepoint now = std::chrono::high_resolution_clock::now();
+
+		m_replayBaseTimestamp= 
+			(m_bIsLastSensorDataTimestampValid && m_lastSensorDataTimestamp > now) ? m_lastSensorDataTimestamp : now;
+		m_replayBaseTimestamp-= std::chrono::duration_cast<t_high_resolution_duration>(std::chrono::microseconds(sample_time_us));
+	}
+	m_lastReplaySampleTimeUs= sample_time_us;
+
+    post_sensor_data_received(
+		sensor_state, 
+		m_replayBaseTimestamp + std::chrono::duration_cast<t_high_resolution_duration>(std::chrono::microseconds(sample_time_us)));
+}
+
+void 
+ServerControllerView::post_sensor_data_received(
+	const CommonDeviceState *sensor_state,
+	const t_high_resolution_timepoint &now)
 {
     // Compute the time in seconds since the last update
-    const t_high_resolution_timepoint now = std::chrono::high_resolution_clock::now();
 	t_high_resolution_duration durationSinceLastUpdate= t_high_resolution_duration::zero();
 
 	if (m_bIsLastSensorDataTimestampValid)
@@ -665,6 +868,11 @@ ServerControllerView::notifySensorDataReceived(const CommonDeviceState *sensor_s
 	m_lastSensorDataTimestamp= now;
 	m_bIsLastSensorDataTimestampValid= true;
 
+	// Replayed samples are timed from when they were handed to us, like live ones
+	PipelineStageTimes stage_times;
+	stage_times.clear();
+	stage_times.capture_us= PipelineLatencyStats::getTimestampUs();
+
 	// Apply device specific filtering
     switch (sensor_state->DeviceType)
     {
@@ -678,6 +886,7 @@ ServerControllerView::notifySensorDataReceived(const CommonDeviceState *sensor_s
             post_imu_filter_packets_for_psmove(
                 psmove, psmoveState,
                 now, durationSinceLastUpdate,
+				stage_times,
 				&m_PoseSensorIMUPacketQueue);
         } break;
     case CommonDeviceState::PSDualShock4:
@@ -690,6 +899,7 @@ ServerControllerView::notifySensorDataReceived(const CommonDeviceState *sensor_s
             post_imu_filter_packets_for_ds4(
                 ds4, ds4State,
                 now, durationSinceLastUpdate,
+				stage_times,
 				&m_PoseSensorIMUPacketQueue);
         } break;
     default:
@@ -698,59 +908,34 @@ ServerControllerView::notifySensorDataReceived(const CommonDeviceState *sensor_s
 
     // Consider this HMD state sequence num processed
     m_lastPollSeqNumProcessed = sensor_state->PollSequenceNumber;
+
+    // Have the main loop filter and publish the new sensor packet right away
+    MainLoopWakeSignal::notify();
 }
 
 void ServerControllerView::updateStateAndPredict()
 {
-	std::vector<PoseSensorPacket> timeSortedPackets;
+	// Drain the packet queues filled by the threads.
+	// Each queue is already in time order, so the merger only has to interleave them.
+	const uint64_t merge_dropped_before= m_PoseSensorPacketMerger.getMergeDroppedCount();
+	const int packet_count= m_PoseSensorPacketMerger.drainQueues(m_PoseSensorIMUPacketQueue, m_PoseSensorOpticalPacketQueue);
+	const uint64_t excess= m_PoseSensorPacketMerger.getMergeDroppedCount() - merge_dropped_before;
 
-	// Drain the packet queues filled by the threads
-	PoseSensorPacket packet;
-	while (m_PoseSensorIMUPacketQueue.try_dequeue(packet))
+	if (excess > 0)
 	{
-		timeSortedPackets.push_back(packet);
-	}
-	//TODO: m_PoseSensorOpticalPacketQueue is currently getting filled on the main thread by
-	// updateOpticalPoseEstimation() when triangulating the optical pose estimates.
-	// Eventually this work will move to it's own camera processing thread 
-	// this line will read from a lock-less queue just like the IMU packet queue.
-	while (m_PoseSensorOpticalPacketQueue.size() > 0)
-	{		
-		timeSortedPackets.push_back(m_PoseSensorOpticalPacketQueue.front());
-		m_PoseSensorOpticalPacketQueue.pop_front();
+		SERVER_MT_LOG_WARNING("updatePoseFilter()") << "Incoming packet count: " << packet_count + excess << ", trimming: " << excess;
 	}
 
-	// Sort the packets in order of ascending time
-	if (timeSortedPackets.size() > 1)
-	{
-		std::sort(
-			timeSortedPackets.begin(), timeSortedPackets.end(), 
-			[](const PoseSensorPacket & a, const PoseSensorPacket & b) -> bool
-			{
-				return a.timestamp < b.timestamp; 
-			});
-
-		t_high_resolution_duration duration= 
-			timeSortedPackets[timeSortedPackets.size()-1].timestamp - timeSortedPackets[0].timestamp;
-		std::chrono::duration<float, std::milli> milli_duration= duration;
-
-		const size_t k_max_process_count= 100;
-		if (timeSortedPackets.size() > k_max_process_count)
-		{
-			const size_t excess= timeSortedPackets.size() - k_max_process_count;
-
-			SERVER_LOG_WARNING("updatePoseFilter()") << "Incoming packet count: " << timeSortedPackets.size() << " (" << milli_duration.count() << "ms)" << ", trimming: " << excess;
-			timeSortedPackets.erase(timeSortedPackets.begin(), timeSortedPackets.begin()+excess);
-		}
-		else
-		{
-			//SERVER_LOG_DEBUG("updatePoseFilter()") << "Incoming packet count: " << timeSortedPackets.size() << " (" << milli_duration.count() << "ms)";
-		}
-	}
+	// The tracker frame processing threads read the filter state when computing the ROI
+	std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
 
 	// Process the sensor packets from oldest to newest
-	for (const PoseSensorPacket &sensorPacket : timeSortedPackets)
+	for (const PoseSensorPacket *next_packet= m_PoseSensorPacketMerger.nextPacket(); 
+		next_packet != nullptr; 
+		next_packet= m_PoseSensorPacketMerger.nextPacket())
     {
+		const PoseSensorPacket &sensorPacket= *next_packet;
+
 		// Compute the time since the last packet
 		float time_delta_seconds;
 		if (m_last_filter_update_timestamp_valid)
@@ -783,6 +968,33 @@ void ServerControllerView::updateStateAndPredict()
 			m_pose_filter->update(time_delta_seconds, filter_packet);
 		}
 
+		m_last_filter_stage_times= sensorPacket.stage_times;
+		if (m_pose_filter->getIsFusingAtCaptureTime())
+		{
+			// A rolled back optical sample gets the newer IMU samples replayed on top of it,
+			// so the state stays as of the newest sample the filter has seen
+			m_last_filter_sample_time_us=
+				std::max(m_last_filter_sample_time_us, sensorPacket.stage_times.getFilterSampleTimeUs(true));
+		}
+		else
+		{
+			// The capture time of an optical sample is a camera frame older than the fused state
+			m_last_filter_sample_time_us= sensorPacket.stage_times.getFilterSampleTimeUs(false);
+		}
+		m_last_filter_stage_times.filter_done_us= PipelineLatencyStats::getTimestampUs();
+		if (m_last_filter_stage_times.triangulation_done_us != 0)
+		{
+			PipelineLatencyStats::recordStageLatency(
+				PipelineLatencyStage_TriangulationToFilter, 
+				m_last_filter_stage_times.triangulation_done_us, m_last_filter_stage_times.filter_done_us);
+		}
+		else
+		{
+			PipelineLatencyStats::recordStageLatency(
+				PipelineLatencyStage_SensorCaptureToFilter, 
+				m_last_filter_stage_times.capture_us, m_last_filter_stage_times.filter_done_us);
+		}
+
 		// Flag the state as unpublished, which will trigger an update to the client
 		markStateAsUnpublished();
 	}
@@ -892,6 +1104,13 @@ ServerControllerView::getIsStreamable() const
             {
                 bIsStreamableController= true;
             } break;
+        case CommonDeviceState::PS3EYE:
+        case CommonDeviceState::ReplayTracker:
+        default:
+            {
+                // Trackers, live or replayed, and HMDs never stream as controllers
+                bIsStreamableController= false;
+            } break;
         }
     }
 
@@ -1094,7 +1313,10 @@ void ServerControllerView::set_tracking_enabled_internal(bool bEnabled)
             m_tracking_color = std::make_tuple(0x00, 0x00, 0x00);
         }
 
-        m_tracking_enabled = bEnabled;
+        {
+            std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+            m_tracking_enabled = bEnabled;
+        }
 
         update_LED_color_internal();
     }
@@ -1222,10 +1444,34 @@ bool ServerControllerView::setControllerRumble(
 
 void ServerControllerView::publish_device_data_frame()
 {
+    // Don't let the tracker threads update the pose estimates while they are being published
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
     // Tell the server request handler we want to send out controller updates.
     // This will call generate_controller_data_frame_for_stream for each listening connection.
     ServerRequestHandler::get_instance()->publish_controller_data_frame(
-        this, &ServerControllerView::generate_controller_data_frame_for_stream);
+        this, &ServerControllerView::generate_controller_data_frame_for_stream, false);
+
+    // Same host clients read the controller state straight out of shared memory instead
+    SharedDeviceStateSlot<SharedControllerState> *shared_state_slot=
+        ServerRequestHandler::get_instance()->get_shared_controller_state_slot(getDeviceID());
+    if (shared_state_slot != nullptr)
+    {
+        SharedControllerState shared_state;
+
+        generate_controller_shared_state(this, &shared_state);
+        shared_state_slot->write(shared_state);
+    }
+}
+
+void ServerControllerView::publish_deferred_device_data_frame()
+{
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
+    // Only the rate limited streams that skipped the latest state get it now.
+    // The shared memory state was already written when the state was first published.
+    ServerRequestHandler::get_instance()->publish_controller_data_frame(
+        this, &ServerControllerView::generate_controller_data_frame_for_stream, true);
 }
 
 void ServerControllerView::generate_controller_data_frame_for_stream(
@@ -1240,6 +1486,22 @@ void ServerControllerView::generate_controller_data_frame_for_stream(
     controller_data_frame->set_sequence_num(controller_view->m_sequence_number);
     controller_data_frame->set_isconnected(controller_view->getDevice()->getIsOpen());
 
+    // Lets clients extrapolate the (predicted) pose in this frame to their own render time
+    controller_data_frame->set_sample_time_us(controller_view->m_last_filter_sample_time_us);
+
+    // Lets clients (and the network layer) see where the time went for the newest filtered sample
+    const PipelineStageTimes &stage_times= controller_view->m_last_filter_stage_times;
+    if (stage_times.filter_done_us != 0)
+    {
+        PSMoveProtocol::DeviceOutputDataFrame_PipelineTimestamps *pipeline_timestamps=
+            data_frame->mutable_pipeline_timestamps();
+
+        pipeline_timestamps->set_capture_us(stage_times.capture_us);
+        pipeline_timestamps->set_segmentation_done_us(stage_times.segmentation_done_us);
+        pipeline_timestamps->set_triangulation_done_us(stage_times.triangulation_done_us);
+        pipeline_timestamps->set_filter_done_us(stage_times.filter_done_us);
+    }
+
     switch (controller_view->getControllerDeviceType())
     {
     case CommonControllerState::PSMove:
@@ -1265,6 +1527,204 @@ void ServerControllerView::generate_controller_data_frame_for_stream(
     data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER);
 }
 
+void ServerControllerView::generate_controller_shared_state(
+    const ServerControllerView *controller_view,
+    SharedControllerState *shared_state)
+{
+    const CommonControllerState *controller_state= controller_view->getState();
+    float prediction_time= 0.f;
+    bool bHasPose= false;
+
+    memset(shared_state, 0, sizeof(SharedControllerState));
+    shared_state->controller_type= -1;
+    shared_state->sequence_num= controller_view->m_sequence_number;
+    shared_state->publish_time_us= SharedDeviceStateHeader::getTimestampMicroseconds();
+
+    if (controller_view->getDevice()->getIsOpen())
+    {
+        shared_state->state_flags|= SharedDeviceStateFlag_IsConnected;
+    }
+
+    if (controller_state == nullptr)
+    {
+        return;
+    }
+
+    switch (controller_view->getControllerDeviceType())
+    {
+    case CommonControllerState::PSMove:
+        {
+            const PSMoveControllerConfig *psmove_config= controller_view->castCheckedConst<PSMoveController>()->getConfig();
+            const PSMoveControllerInputState *psmove_state= static_cast<const PSMoveControllerInputState *>(controller_state);
+
+            shared_state->controller_type= PSMoveProtocol::PSMOVE;
+            shared_state->button_down_bitmask= get_psmove_button_bitmask(psmove_state);
+            shared_state->analog_values[0]= psmove_state->TriggerValue;
+            shared_state->battery_value= psmove_state->BatteryValue;
+            if (psmove_config->is_valid)
+            {
+                shared_state->state_flags|= SharedDeviceStateFlag_HasValidHardwareCalibration;
+            }
+
+            prediction_time= psmove_config->prediction_time;
+            bHasPose= true;
+        } break;
+    case CommonControllerState::PSNavi:
+        {
+            const PSNaviControllerInputState *psnavi_state= static_cast<const PSNaviControllerInputState *>(controller_state);
+
+            shared_state->controller_type= PSMoveProtocol::PSNAVI;
+            shared_state->button_down_bitmask= get_psnavi_button_bitmask(psnavi_state);
+            shared_state->analog_values[0]= psnavi_state->Trigger;
+            shared_state->analog_values[1]= psnavi_state->Stick_XAxis;
+            shared_state->analog_values[2]= psnavi_state->Stick_YAxis;
+        } break;
+    case CommonControllerState::PSDualShock4:
+        {
+            const PSDualShock4ControllerConfig *ds4_config= controller_view->castCheckedConst<PSDualShock4Controller>()->getConfig();
+            const DualShock4ControllerInputState *psds4_state= static_cast<const DualShock4ControllerInputState *>(controller_state);
+
+            shared_state->controller_type= PSMoveProtocol::PSDUALSHOCK4;
+            shared_state->button_down_bitmask= get_psdualshock4_button_bitmask(psds4_state);
+            shared_state->analog_values[0]= psds4_state->LeftAnalogX;
+            shared_state->analog_values[1]= psds4_state->LeftAnalogY;
+            shared_state->analog_values[2]= psds4_state->RightAnalogX;
+            shared_state->analog_values[3]= psds4_state->RightAnalogY;
+            shared_state->analog_values[4]= psds4_state->LeftTrigger;
+            shared_state->analog_values[5]= psds4_state->RightTrigger;
+            if (ds4_config->is_valid)
+            {
+                shared_state->state_flags|= SharedDeviceStateFlag_HasValidHardwareCalibration;
+            }
+
+            prediction_time= ds4_config->prediction_time;
+            bHasPose= true;
+        } break;
+    case CommonControllerState::VirtualController:
+        {
+            const VirtualControllerConfig *virtual_config= controller_view->castCheckedConst<VirtualController>()->getConfig();
+            const VirtualControllerState *virtual_controller_state= static_cast<const VirtualControllerState *>(controller_state);
+            const int axis_count= std::min(virtual_controller_state->numAxes, PSM_MAX_VIRTUAL_CONTROLLER_AXES);
+
+            shared_state->controller_type= PSMoveProtocol::VIRTUALCONTROLLER;
+            shared_state->button_down_bitmask= controller_state->AllButtons;
+            shared_state->vendor_id= virtual_controller_state->vendorID;
+            shared_state->product_id= virtual_controller_state->productID;
+            shared_state->axis_count= axis_count;
+            shared_state->button_count= virtual_controller_state->numButtons;
+            memcpy(shared_state->axis_states, virtual_controller_state->axisStates, axis_count);
+
+            prediction_time= virtual_config->prediction_time;
+            bHasPose= true;
+        } break;
+    default:
+        assert(0 && "Unhandled controller type");
+    }
+
+    if (bHasPose)
+    {
+        const IPoseFilter *pose_filter= controller_view->getPoseFilter();
+        const CommonDevicePose controller_pose= controller_view->getFilteredPose(prediction_time);
+        const CommonDevicePhysics controller_physics= controller_view->getFilteredPhysics();
+
+        if (controller_view->getIsTrackingEnabled())
+        {
+            shared_state->state_flags|= SharedDeviceStateFlag_IsTrackingEnabled;
+        }
+        if (controller_view->getIsCurrentlyTracking())
+        {
+            shared_state->state_flags|= SharedDeviceStateFlag_IsCurrentlyTracking;
+        }
+        if (pose_filter->getIsOrientationStateValid())
+        {
+            shared_state->state_flags|= SharedDeviceStateFlag_IsOrientationValid;
+        }
+        if (pose_filter->getIsPositionStateValid())
+        {
+            shared_state->state_flags|= SharedDeviceStateFlag_IsPositionValid;
+        }
+
+        shared_state->orientation[0]= controller_pose.Orientation.w;
+        shared_state->orientation[1]= controller_pose.Orientation.x;
+        shared_state->orientation[2]= controller_pose.Orientation.y;
+        shared_state->orientation[3]= controller_pose.Orientation.z;
+
+        shared_state->position_cm[0]= controller_pose.PositionCm.x;
+        shared_state->position_cm[1]= controller_pose.PositionCm.y;
+        shared_state->position_cm[2]= controller_pose.PositionCm.z;
+
+        copy_shared_device_physics(controller_physics, &shared_state->physics);
+        shared_state->sample_time_us= controller_view->m_last_filter_sample_time_us;
+        shared_state->prediction_time= prediction_time;
+    }
+}
+
+static unsigned int get_psmove_button_bitmask(const PSMoveControllerInputState *psmove_state)
+{
+    unsigned int button_bitmask= 0;
+
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIANGLE, psmove_state->Triangle);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CIRCLE, psmove_state->Circle);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CROSS, psmove_state->Cross);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SQUARE, psmove_state->Square);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SELECT, psmove_state->Select);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::START, psmove_state->Start);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::PS, psmove_state->PS);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::MOVE, psmove_state->Move);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIGGER, psmove_state->Trigger);
+
+    return button_bitmask;
+}
+
+static unsigned int get_psnavi_button_bitmask(const PSNaviControllerInputState *psnavi_state)
+{
+    unsigned int button_bitmask= 0;
+
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L1, psnavi_state->L1);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L2, psnavi_state->L2);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIGGER, psnavi_state->L2);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L3, psnavi_state->L3);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CIRCLE, psnavi_state->Circle);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CROSS, psnavi_state->Cross);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::PS, psnavi_state->PS);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::UP, psnavi_state->DPad_Up);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::RIGHT, psnavi_state->DPad_Right);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::DOWN, psnavi_state->DPad_Down);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::LEFT, psnavi_state->DPad_Left);
+
+    return button_bitmask;
+}
+
+static unsigned int get_psdualshock4_button_bitmask(const DualShock4ControllerInputState *psds4_state)
+{
+    unsigned int button_bitmask= 0;
+
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::UP, psds4_state->DPad_Up);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::DOWN, psds4_state->DPad_Down);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::LEFT, psds4_state->DPad_Left);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::RIGHT, psds4_state->DPad_Right);
+
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L1, psds4_state->L1);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::R1, psds4_state->R1);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L2, psds4_state->L2);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::R2, psds4_state->R2);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L3, psds4_state->L3);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::R3, psds4_state->R3);
+
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIANGLE, psds4_state->Triangle);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CIRCLE, psds4_state->Circle);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CROSS, psds4_state->Cross);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SQUARE, psds4_state->Square);
+
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SHARE, psds4_state->Share);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::OPTIONS, psds4_state->Options);
+
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::PS, psds4_state->PS);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRACKPAD, psds4_state->TrackPadButton);
+
+    return button_bitmask;
+}
+
 static void generate_psmove_data_frame_for_stream(
     const ServerControllerView *controller_view,
     const ControllerStreamInfo *stream_info,
@@ -1278,6 +1738,8 @@ static void generate_psmove_data_frame_for_stream(
 
     auto *controller_data_frame= data_frame->mutable_controller_data_packet();
     auto *psmove_data_frame = controller_data_frame->mutable_psmove_state();
+
+    controller_data_frame->set_prediction_time(psmove_config->prediction_time);
    
     if (controller_state != nullptr)
     {        
@@ -1311,17 +1773,7 @@ static void generate_psmove_data_frame_for_stream(
         psmove_data_frame->set_trigger_value(psmove_state->TriggerValue);
         psmove_data_frame->set_battery_value(psmove_state->BatteryValue);
 
-        unsigned int button_bitmask= 0;
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIANGLE, psmove_state->Triangle);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CIRCLE, psmove_state->Circle);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CROSS, psmove_state->Cross);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SQUARE, psmove_state->Square);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SELECT, psmove_state->Select);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::START, psmove_state->Start);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::PS, psmove_state->PS);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::MOVE, psmove_state->Move);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIGGER, psmove_state->Trigger);
-        controller_data_frame->set_button_down_bitmask(button_bitmask);
+        controller_data_frame->set_button_down_bitmask(get_psmove_button_bitmask(psmove_state));
 
         // If requested, get the raw sensor data for the controller
         if (stream_info->include_raw_sensor_data)
@@ -1492,19 +1944,7 @@ static void generate_psnavi_data_frame_for_stream(
         psnavi_data_frame->set_stick_xaxis(psnavi_state->Stick_XAxis);
         psnavi_data_frame->set_stick_yaxis(psnavi_state->Stick_YAxis);
 
-        unsigned int button_bitmask= 0;
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L1, psnavi_state->L1);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L2, psnavi_state->L2);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIGGER, psnavi_state->L2);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L3, psnavi_state->L3);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CIRCLE, psnavi_state->Circle);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CROSS, psnavi_state->Cross);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::PS, psnavi_state->PS);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::UP, psnavi_state->DPad_Up);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::RIGHT, psnavi_state->DPad_Right);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::DOWN, psnavi_state->DPad_Down);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::LEFT, psnavi_state->DPad_Left);
-        controller_data_frame->set_button_down_bitmask(button_bitmask);
+        controller_data_frame->set_button_down_bitmask(get_psnavi_button_bitmask(psnavi_state));
     }
 
     controller_data_frame->set_controller_type(PSMoveProtocol::PSNAVI);
@@ -1524,6 +1964,8 @@ static void generate_psdualshock4_data_frame_for_stream(
     auto *controller_data_frame = data_frame->mutable_controller_data_packet();
     auto *psds4_data_frame = controller_data_frame->mutable_psdualshock4_state();
 
+    controller_data_frame->set_prediction_time(psmove_config->prediction_time);
+
     if (controller_state != nullptr)
     {
         assert(controller_state->DeviceType == CommonDeviceState::PSDualShock4);
@@ -1562,30 +2004,7 @@ static void generate_psdualshock4_data_frame_for_stream(
         psds4_data_frame->set_left_trigger_value(psds4_state->LeftTrigger);
         psds4_data_frame->set_right_trigger_value(psds4_state->RightTrigger);
 
-        unsigned int button_bitmask = 0;
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::UP, psds4_state->DPad_Up);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::DOWN, psds4_state->DPad_Down);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::LEFT, psds4_state->DPad_Left);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::RIGHT, psds4_state->DPad_Right);
-
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L1, psds4_state->L1);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::R1, psds4_state->R1);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L2, psds4_state->L2);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::R2, psds4_state->R2);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L3, psds4_state->L3);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::R3, psds4_state->R3);
-
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIANGLE, psds4_state->Triangle);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CIRCLE, psds4_state->Circle);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CROSS, psds4_state->Cross);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SQUARE, psds4_state->Square);
-
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SHARE, psds4_state->Share);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::OPTIONS, psds4_state->Options);
-
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::PS, psds4_state->PS);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRACKPAD, psds4_state->TrackPadButton);
-        controller_data_frame->set_button_down_bitmask(button_bitmask);
+        controller_data_frame->set_button_down_bitmask(get_psdualshock4_button_bitmask(psds4_state));
 
         // If requested, get the raw sensor data for the controller
         if (stream_info->include_raw_sensor_data)
@@ -1766,6 +2185,8 @@ static void generate_virtual_controller_data_frame_for_stream(
 
     auto *controller_data_frame= data_frame->mutable_controller_data_packet();
     auto *virtual_controller_data_frame = controller_data_frame->mutable_virtualcontroller_state();
+
+    controller_data_frame->set_prediction_time(controller_config->prediction_time);
    
     if (controller_state != nullptr)
     {        
@@ -2088,6 +2509,8 @@ init_filters_for_psmove(
     constants.position_constants.accelerometer_noise_radius= psmove_config->accelerometer_noise_radius;
     constants.position_constants.max_velocity= psmove_config->max_velocity;
     constants.position_constants.mean_update_time_delta= psmove_config->mean_update_time_delta;
+    constants.fixed_lag_window_seconds= psmove_config->pose_filter_fixed_lag_window;
+    constants.use_single_precision= psmove_config->pose_filter_use_single_precision;
     constants.position_constants.position_variance_curve.A = psmove_config->position_variance_exp_fit_a;
     constants.position_constants.position_variance_curve.B = psmove_config->position_variance_exp_fit_b;
     constants.position_constants.position_variance_curve.MaxValue = 1.f;
@@ -2151,6 +2574,8 @@ init_filters_for_psdualshock4(
     constants.position_constants.accelerometer_noise_radius= ds4_config->accelerometer_noise_radius;
     constants.position_constants.max_velocity= ds4_config->max_velocity;
     constants.position_constants.mean_update_time_delta= ds4_config->mean_update_time_delta;
+    constants.fixed_lag_window_seconds= ds4_config->pose_filter_fixed_lag_window;
+    constants.use_single_precision= ds4_config->pose_filter_use_single_precision;
     constants.position_constants.position_variance_curve.A = ds4_config->position_variance_exp_fit_a;
     constants.position_constants.position_variance_curve.B = ds4_config->position_variance_exp_fit_b;
     constants.position_constants.position_variance_curve.MaxValue = 1.f;
@@ -2220,6 +2645,7 @@ static void post_imu_filter_packets_for_psmove(
 	const PSMoveControllerInputState *psmoveState,
 	const t_high_resolution_timepoint now,
 	const t_high_resolution_duration duration_since_last_update,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_sensor_queue *pose_filter_queue)
 {
     const PSMoveControllerConfig *config = psmove->getConfig();
@@ -2227,6 +2653,7 @@ static void post_imu_filter_packets_for_psmove(
     PoseSensorPacket sensor_packet;
 
     sensor_packet.clear();
+    sensor_packet.stage_times= stage_times;
 
 	// One magnetometer update for every two accel/gryo readings
 	if (psmove->getSupportsMagnetometer())
@@ -2266,7 +2693,7 @@ static void post_imu_filter_packets_for_psmove(
 				psmoveState->CalibratedGyro[frame][2]);
 		sensor_packet.has_gyroscope_measurement= true;
 
-		pose_filter_queue->enqueue(sensor_packet);
+		pose_filter_queue->post(sensor_packet);
 	}
 	else
 	{
@@ -2308,7 +2735,7 @@ static void post_imu_filter_packets_for_psmove(
 					psmoveState->CalibratedGyro[frame][2]);
 			sensor_packet.has_gyroscope_measurement= true;
 
-			pose_filter_queue->enqueue(sensor_packet);
+			pose_filter_queue->post(sensor_packet);
 		}
 	}
 }
@@ -2317,12 +2744,14 @@ static void post_optical_filter_packet_for_psmove(
     const PSMoveController *psmove,
     const t_high_resolution_timepoint now,
     const ControllerOpticalPoseEstimation *pose_estimation,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_optical_queue *pose_filter_queue)
 {
     const PSMoveControllerConfig *config = psmove->getConfig();
     PoseSensorPacket sensor_packet;
 
     sensor_packet.clear();
+    sensor_packet.stage_times= stage_times;
 	sensor_packet.timestamp= now;
 
     // PSMove cant do optical orientation
@@ -2339,7 +2768,7 @@ static void post_optical_filter_packet_for_psmove(
 		sensor_packet.tracking_projection_area_px_sqr= pose_estimation->projection.screen_area;
     }
 
-	pose_filter_queue->push_back(sensor_packet);
+	pose_filter_queue->post(sensor_packet);
 }
 
 static void post_imu_filter_packets_for_ds4(
@@ -2347,6 +2776,7 @@ static void post_imu_filter_packets_for_ds4(
 	const DualShock4ControllerInputState *ds4State,
     const t_high_resolution_timepoint now, 
 	const t_high_resolution_duration duration_since_last_update,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_sensor_queue *pose_filter_queue)
 {
     const PSDualShock4ControllerConfig *config = ds4->getConfig();
@@ -2354,6 +2784,7 @@ static void post_imu_filter_packets_for_ds4(
     PoseSensorPacket sensor_packet;
 
     sensor_packet.clear();
+    sensor_packet.stage_times= stage_times;
 
 	sensor_packet.timestamp= now;
 
@@ -2379,13 +2810,14 @@ static void post_imu_filter_packets_for_ds4(
             ds4State->CalibratedGyro.k);
 	sensor_packet.has_gyroscope_measurement= true;
 
-    pose_filter_queue->enqueue(sensor_packet);
+    pose_filter_queue->post(sensor_packet);
 }
 
 static void post_optical_filter_packet_for_ds4(
     const PSDualShock4Controller *ds4,
     const t_high_resolution_timepoint now,
     const ControllerOpticalPoseEstimation *pose_estimation,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_optical_queue *pose_filter_queue)
 {
     const PSDualShock4ControllerConfig *config = ds4->getConfig();
@@ -2393,6 +2825,7 @@ static void post_optical_filter_packet_for_ds4(
     PoseSensorPacket sensor_packet;
 
     sensor_packet.clear();
+    sensor_packet.stage_times= stage_times;
 	sensor_packet.timestamp= now;
 
     if (pose_estimation->bOrientationValid)
@@ -2419,13 +2852,14 @@ static void post_optical_filter_packet_for_ds4(
 		sensor_packet.tracking_projection_area_px_sqr= screen_area;
     }
 
-	pose_filter_queue->push_back(sensor_packet);
+	pose_filter_queue->post(sensor_packet);
 }
 
 static void post_optical_filter_packet_for_virtual_controller(
     const VirtualController *virtual_controller,
     const t_high_resolution_timepoint now,
     const ControllerOpticalPoseEstimation *pose_estimation,
+	const PipelineStageTimes &stage_times,
 	t_controller_pose_optical_queue *pose_filter_queue)
 {
     const VirtualControllerConfig *config = virtual_controller->getConfig();
@@ -2433,6 +2867,7 @@ static void post_optical_filter_packet_for_virtual_controller(
     PoseSensorPacket sensor_packet;
 
     sensor_packet.clear();
+    sensor_packet.stage_times= stage_times;
 	sensor_packet.timestamp= now;
 
 	// Virtual controllers don't currently support an optical orientation
@@ -2448,7 +2883,7 @@ static void post_optical_filter_packet_for_virtual_controller(
 		sensor_packet.tracking_projection_area_px_sqr= pose_estimation->projection.screen_area;
     }
 
-	pose_filter_queue->push_back(sensor_packet);
+	pose_filter_queue->post(sensor_packet);
 }
 
 static void computeSpherePoseForControllerFromSingleTracker(
@@ -2523,67 +2958,38 @@ static void computeSpherePoseForControllerFromMultipleTrackers(
     ControllerOpticalPoseEstimation *tracker_pose_estimations,
     ControllerOpticalPoseEstimation *multicam_pose_estimation)
 {
-    const TrackerManagerConfig &cfg = tracker_manager->getConfig();
+    const ServerTrackerView *trackers[TrackerManager::k_max_devices];
+    CommonDeviceScreenLocation position2d_list[TrackerManager::k_max_devices];
+    float screen_areas[TrackerManager::k_max_devices];
     float screen_area_sum = 0;
+    int biggest_prjection_id = -1;
 
     // Project the tracker relative 3d tracking position back on to the tracker camera plane
-    // and sum up the total controller projection area across all trackers
-    CommonDeviceScreenLocation position2d_list[TrackerManager::k_max_devices];
+    // and sum up the total projection area across all trackers
     for (int list_index = 0; list_index < projections_found; ++list_index)
     {
         const int tracker_id = valid_projection_tracker_ids[list_index];
         const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
         const ControllerOpticalPoseEstimation &poseEstimate = tracker_pose_estimations[tracker_id];
 
+        trackers[list_index] = tracker.get();
         position2d_list[list_index] = tracker->projectTrackerRelativePosition(&poseEstimate.position_cm);
+        screen_areas[list_index] = poseEstimate.projection.screen_area;
         screen_area_sum += poseEstimate.projection.screen_area;
-    }
-
-    // Compute triangulations amongst all pairs of projections
-    int pair_count = 0;
-    int biggest_prjection_id = -1;
-    CommonDevicePosition average_world_position = { 0.f, 0.f, 0.f };
-    for (int list_index = 0; list_index < projections_found; ++list_index)
-    {
-        const int tracker_id = valid_projection_tracker_ids[list_index];
-        const CommonDeviceScreenLocation &screen_location = position2d_list[list_index];
-        const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
 
-        for (int other_list_index = list_index + 1; other_list_index < projections_found; ++other_list_index)
+        if (biggest_prjection_id < 0 || screen_areas[list_index] > tracker_pose_estimations[biggest_prjection_id].projection.screen_area)
         {
-            const int other_tracker_id = valid_projection_tracker_ids[other_list_index];
-            const CommonDeviceScreenLocation &other_screen_location = position2d_list[other_list_index];
-            const ServerTrackerViewPtr other_tracker = tracker_manager->getTrackerViewPtr(other_tracker_id);
-            // if trackers are on poposite sides
-            if (cfg.exclude_opposed_cameras)
-            {
-                if ((tracker->getTrackerPose().PositionCm.x > 0) == (other_tracker->getTrackerPose().PositionCm.x < 0) &&
-                    (tracker->getTrackerPose().PositionCm.z > 0) == (other_tracker->getTrackerPose().PositionCm.z < 0))
-                {
-                    float screen_area = tracker_pose_estimations[tracker_id].projection.screen_area;
-                    float other_screen_area = tracker_pose_estimations[other_tracker_id].projection.screen_area;
-
-                    biggest_prjection_id = screen_area > other_screen_area ? tracker_id : other_tracker_id;
-
-                    continue;
-                }
-            }
-
-            // Using the screen locations on two different trackers we can triangulate a world position
-            CommonDevicePosition world_position =
-                ServerTrackerView::triangulateWorldPosition(
-                    tracker.get(), &screen_location,
-                    other_tracker.get(), &other_screen_location);
-
-            average_world_position.x += world_position.x;
-            average_world_position.y += world_position.y;
-            average_world_position.z += world_position.z;
-
-            ++pair_count;
+            biggest_prjection_id = tracker_id;
         }
     }
 
-    if (pair_count == 0 && biggest_prjection_id >= 0 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
+    // Using the screen locations on the trackers we can triangulate a world position
+    CommonDevicePosition world_position;
+    const bool bTriangulated = 
+        ServerTrackerView::triangulateWorldPositionFromVisibleTrackers(
+            trackers, position2d_list, screen_areas, projections_found, &world_position);
+
+    if (!bTriangulated && biggest_prjection_id >= 0 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
     {
         // Position not triangulated from opposed camera, estimate from one tracker only.
 
@@ -2593,26 +2999,19 @@ static void computeSpherePoseForControllerFromMultipleTrackers(
             &tracker_pose_estimations[biggest_prjection_id],
             multicam_pose_estimation);		
     }
-    else if(pair_count > 0)
+    else if (bTriangulated)
     {
-        // Compute the average position
-        const float N = static_cast<float>(pair_count);
-
-        average_world_position.x /= N;
-        average_world_position.y /= N;
-        average_world_position.z /= N;
-
-        // Store the averaged tracking position
+        // Store the triangulated tracking position
         const float q = tracker_manager->getConfig().controller_position_smoothing;
         if (q <= 0.01f)
         {
-            multicam_pose_estimation->position_cm = average_world_position;
+            multicam_pose_estimation->position_cm = world_position;
         }
         else
         {
-            multicam_pose_estimation->position_cm.x = q * multicam_pose_estimation->position_cm.x + (1 - q) * average_world_position.x;
-            multicam_pose_estimation->position_cm.y = q * multicam_pose_estimation->position_cm.y + (1 - q) * average_world_position.y;
-            multicam_pose_estimation->position_cm.z = q * multicam_pose_estimation->position_cm.z + (1 - q) * average_world_position.z;
+            multicam_pose_estimation->position_cm.x = q * multicam_pose_estimation->position_cm.x + (1 - q) * world_position.x;
+            multicam_pose_estimation->position_cm.y = q * multicam_pose_estimation->position_cm.y + (1 - q) * world_position.y;
+            multicam_pose_estimation->position_cm.z = q * multicam_pose_estimation->position_cm.z + (1 - q) * world_position.z;
         }
 
         multicam_pose_estimation->bCurrentlyTracking = true;
@@ -2641,7 +3040,9 @@ static void computeLightBarPoseForControllerFromMultipleTrackers(
     float orientation_weights[k_max_pairs];
     float screen_area_sum = 0;
 
-    // Compute triangulations amongst all pairs of projections
+    // Compute triangulations amongst all pairs of projections.
+    // Unlike the sphere, this doesn't use the N-view solve yet: the orientation comes from 
+    // fitting a plane to the lightbar vertices triangulated for each pair of trackers.
     int pair_count = 0;
     CommonDevicePosition average_world_position = { 0.f, 0.f, 0.f };
     for (int list_index = 0; list_index < projections_found; ++list_index)
@@ -11,15 +11,16 @@
 #include <atomic>
 #include <chrono>
 #include <deque>
+#include <mutex>
 #include <vector>
 
-#include "readerwriterqueue.h" // lockfree queue
+#include "PoseSensorPacketQueue.h"
 
 // -- pre-declarations -----
 class TrackerManager;
 
-using t_controller_pose_sensor_queue= moodycamel::ReaderWriterQueue<PoseSensorPacket, 1024>;
-using t_controller_pose_optical_queue= std::deque<PoseSensorPacket>;
+using t_controller_pose_sensor_queue= PoseSensorPacketQueue;
+using t_controller_pose_optical_queue= PoseSensorPacketQueue;
 
 template<typename t_object_type>
 class AtomicObject;
@@ -78,6 +79,21 @@ public:
     void updateOpticalPoseEstimation(TrackerManager* tracker_manager);
     void updateStateAndPredict();
 
+    // Snapshots the state a tracker needs to search a video frame for this controller.
+    // Returns false if the controller isn't currently optically trackable.
+    bool getProjectionRequestForTracker(
+        const class ServerTrackerView *tracker,
+        struct TrackedDeviceProjectionRequest *out_request,
+        struct ControllerOpticalPoseEstimation *out_prior_pose_estimate) const;
+
+    // Called on a tracker's frame processing thread when it has a new video frame.
+    // Finds the controller in the frame and posts the fused optical pose to the filter queue.
+    // The request and prior pose estimate come from getProjectionRequestForTracker().
+    void notifyTrackerDataReceived(
+        class ServerTrackerView *tracker,
+        const struct TrackedDeviceProjectionRequest *request,
+        const struct ControllerOpticalPoseEstimation *prior_pose_estimate);
+
     // Registers the address of the bluetooth adapter on the host PC with the controller
     bool setHostBluetoothAddress(const std::string &address);
     
@@ -174,6 +190,19 @@ public:
 	// Get the prediction time used for ROI tracking
 	float getROIPredictionTime() const;
 
+    // Get the pipeline stage times of the newest sample the pose filter processed
+    inline const PipelineStageTimes &getLastFilterStageTimes() const { return m_last_filter_stage_times; }
+
+    // Get the depth and drop counts of the pose sensor packet queues since the last reset
+    inline void getPoseSensorQueueStats(PoseSensorQueueStats &out_stats) const {
+        m_PoseSensorPacketMerger.getStats(m_PoseSensorIMUPacketQueue, m_PoseSensorOpticalPacketQueue, out_stats);
+    }
+    inline void resetPoseSensorQueueStats() {
+        m_PoseSensorIMUPacketQueue.resetDroppedCount();
+        m_PoseSensorOpticalPacketQueue.resetDroppedCount();
+        m_PoseSensorPacketMerger.resetStats();
+    }
+
     // Get the pose estimate relative to the given tracker id
     inline const ControllerOpticalPoseEstimation *getTrackerPoseEstimate(int trackerId) const {
         return (m_tracker_pose_estimations != nullptr) ? &m_tracker_pose_estimations[trackerId] : nullptr;
@@ -198,15 +227,33 @@ public:
         const struct ControllerStreamInfo *stream_info,
         PSMoveProtocol::DeviceOutputDataFrame *data_frame);
 
+    // Helper used to publish the current controller state to same host clients and to compact data frames
+    static void generate_controller_shared_state(
+        const ServerControllerView *controller_view,
+        struct SharedControllerState *shared_state);
+
 	// Incoming device data callbacks
 	void notifySensorDataReceived(const CommonDeviceState *sensor_state) override;
+	void notifyRecordedSensorDataReceived(const CommonDeviceState *sensor_state, int64_t sample_time_us) override;
 
 protected:
     void set_tracking_enabled_internal(bool bEnabled);
     void update_LED_color_internal();
+    bool get_is_optically_trackable_internal() const;
+    void build_projection_request(const class ServerTrackerView *tracker, struct TrackedDeviceProjectionRequest *out_request) const;
+    void update_multicam_pose_estimation(
+        const TrackerManager* tracker_manager, 
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now);
+    void post_optical_pose_estimation(
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now,
+        const PipelineStageTimes &stage_times);
+    void post_sensor_data_received(
+        const CommonDeviceState *sensor_state,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &sample_time);
     bool allocate_device_interface(const class DeviceEnumerator *enumerator) override;
     void free_device_interface() override;
     void publish_device_data_frame() override;
+    void publish_deferred_device_data_frame() override;
 
 private:
     // Tracking color state
@@ -227,10 +274,17 @@ private:
 	// Filter State (IMU Thread)
 	std::chrono::time_point<std::chrono::high_resolution_clock> m_lastSensorDataTimestamp;
 	bool m_bIsLastSensorDataTimestampValid;
+	std::chrono::time_point<std::chrono::high_resolution_clock> m_replayBaseTimestamp; // maps recorded sample times to filter time
+	int64_t m_lastReplaySampleTimeUs;
 
 	// Filter State (Shared)
 	t_controller_pose_sensor_queue m_PoseSensorIMUPacketQueue;
-	t_controller_pose_optical_queue m_PoseSensorOpticalPacketQueue; // TODO: Currently on main thread
+	t_controller_pose_optical_queue m_PoseSensorOpticalPacketQueue; // Filled by tracker frame processing threads
+	PoseSensorPacketMerger m_PoseSensorPacketMerger; // Feeds both queues to the filter in time order
+
+	// Guards the optical pose estimates and pose filter against the tracker frame processing threads.
+	// Tracker threads only hold this while snapshotting and fusing, never while searching a frame.
+	mutable std::mutex m_pose_estimation_mutex;
     
     // Filter state
     ControllerOpticalPoseEstimation *m_tracker_pose_estimations; // array of size TrackerManager::k_max_devices
@@ -240,6 +294,8 @@ private:
     int m_lastPollSeqNumProcessed;
     std::chrono::time_point<std::chrono::high_resolution_clock> m_last_filter_update_timestamp;
     bool m_last_filter_update_timestamp_valid;
+    PipelineStageTimes m_last_filter_stage_times; // stage times of the newest sample the filter processed
+    int64_t m_last_filter_sample_time_us; // PipelineLatencyStats::getTimestampUs() time of the newest state the filter processed
 };
 
 #endif // SERVER_CONTROLLER_VIEW_H
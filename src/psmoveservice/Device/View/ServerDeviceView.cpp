@@ -1,6 +1,7 @@
 //-- includes -----
 #include "ServerDeviceView.h"
 #include "ServerLog.h"
+#include "SharedDeviceState.h"
 
 #include <chrono>
 
@@ -10,6 +11,8 @@
 ServerDeviceView::ServerDeviceView(
     const int device_id)
     : m_bHasUnpublishedState(false)
+    , m_bHasDeferredState(false)
+    , m_deferredPublishDeadline()
     , m_pollNoDataCount(0)
     , m_sequence_number(0)
     , m_deviceID(device_id)
@@ -110,11 +113,22 @@ void ServerDeviceView::publish()
 {
     if (m_bHasUnpublishedState)
     {
+        // The new state supersedes anything the rate limited streams skipped
+        m_bHasDeferredState= false;
         publish_device_data_frame();
 
         m_bHasUnpublishedState= false;
         m_sequence_number++;
     }
+    else if (m_bHasDeferredState)
+    {
+        // Retry the rate limited streams that skipped the latest state
+        // (they flag it as deferred again if they still aren't due)
+        m_bHasDeferredState= false;
+        publish_deferred_device_data_frame();
+
+        m_sequence_number++;
+    }
 }
 
 void
@@ -131,4 +145,24 @@ bool
 ServerDeviceView::matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const
 {
     return getIsOpen() && getDevice()->matchesDeviceEnumerator(enumerator);
-}
\ No newline at end of file
+}
+
+void
+ServerDeviceView::copy_shared_device_physics(const CommonDevicePhysics &physics, SharedDevicePhysics *out_physics)
+{
+    out_physics->velocity_cm_per_sec[0]= physics.VelocityCmPerSec.i;
+    out_physics->velocity_cm_per_sec[1]= physics.VelocityCmPerSec.j;
+    out_physics->velocity_cm_per_sec[2]= physics.VelocityCmPerSec.k;
+
+    out_physics->acceleration_cm_per_sec_sqr[0]= physics.AccelerationCmPerSecSqr.i;
+    out_physics->acceleration_cm_per_sec_sqr[1]= physics.AccelerationCmPerSecSqr.j;
+    out_physics->acceleration_cm_per_sec_sqr[2]= physics.AccelerationCmPerSecSqr.k;
+
+    out_physics->angular_velocity_rad_per_sec[0]= physics.AngularVelocityRadPerSec.i;
+    out_physics->angular_velocity_rad_per_sec[1]= physics.AngularVelocityRadPerSec.j;
+    out_physics->angular_velocity_rad_per_sec[2]= physics.AngularVelocityRadPerSec.k;
+
+    out_physics->angular_acceleration_rad_per_sec_sqr[0]= physics.AngularAccelerationRadPerSecSqr.i;
+    out_physics->angular_acceleration_rad_per_sec_sqr[1]= physics.AngularAccelerationRadPerSecSqr.j;
+    out_physics->angular_acceleration_rad_per_sec_sqr[2]= physics.AngularAccelerationRadPerSecSqr.k;
+}
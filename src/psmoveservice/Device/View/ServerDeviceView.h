@@ -55,17 +55,29 @@ public:
     { return m_bHasUnpublishedState; }
     inline std::chrono::time_point<std::chrono::high_resolution_clock> getLastNewDataTimestamp() const
     { return m_lastNewDataTimestamp; }
+    // When publish() owes the rate limited streams the state they skipped (time_point::max() if it doesn't)
+    inline std::chrono::time_point<std::chrono::high_resolution_clock> getDeferredPublishDeadline() const
+    { return m_bHasDeferredState ? m_deferredPublishDeadline : std::chrono::time_point<std::chrono::high_resolution_clock>::max(); }
     
     // setters
     inline void markStateAsUnpublished()
     { m_bHasUnpublishedState= true; }
+    // Rate limited streams skipped the last published state and want it once they're due, the first at publish_deadline
+    inline void markStateAsDeferred(const std::chrono::time_point<std::chrono::high_resolution_clock> &publish_deadline)
+    { m_bHasDeferredState= true; m_deferredPublishDeadline= publish_deadline; }
     
 protected:
     virtual bool allocate_device_interface(const class DeviceEnumerator *enumerator) = 0;
     virtual void free_device_interface() = 0;
     virtual void publish_device_data_frame() = 0;
+    virtual void publish_deferred_device_data_frame() {}
+
+    // Copies filtered physics into the layout same host clients read out of shared memory
+    static void copy_shared_device_physics(const CommonDevicePhysics &physics, struct SharedDevicePhysics *out_physics);
 
     bool m_bHasUnpublishedState;
+    bool m_bHasDeferredState;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_deferredPublishDeadline;
     int m_pollNoDataCount;
     int m_sequence_number;
     std::chrono::time_point<std::chrono::high_resolution_clock> m_lastNewDataTimestamp;
@@ -3,6 +3,7 @@
 #include "ServerHMDView.h"
 #include "MathAlignment.h"
 #include "MorpheusHMD.h"
+#include "PipelineLatency.h"
 #include "VirtualHMD.h"
 #include "CompoundPoseFilter.h"
 #include "PoseFilterInterface.h"
@@ -10,6 +11,7 @@
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
 #include "ServerTrackerView.h"
+#include "SharedDeviceState.h"
 #include "TrackerManager.h"
 
 //-- constants -----
@@ -86,7 +88,10 @@ ServerHMDView::ServerHMDView(const int device_id)
 	, m_lastPollSeqNumProcessed(-1)
 	, m_last_filter_update_timestamp()
 	, m_last_filter_update_timestamp_valid(false)
+	, m_last_filter_sample_time_us(0)
 {
+	m_multicam_stage_times.clear();
+	m_last_filter_stage_times.clear();
 }
 
 ServerHMDView::~ServerHMDView()
@@ -95,6 +100,8 @@ ServerHMDView::~ServerHMDView()
 
 bool ServerHMDView::allocate_device_interface(const class DeviceEnumerator *enumerator)
 {
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
     switch (enumerator->get_device_type())
     {
     case CommonDeviceState::Morpheus:
@@ -134,6 +141,8 @@ bool ServerHMDView::allocate_device_interface(const class DeviceEnumerator *enum
 
 void ServerHMDView::free_device_interface()
 {
+	std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
 	if (m_multicam_pose_estimation != nullptr)
 	{
 		delete m_multicam_pose_estimation;
@@ -218,6 +227,10 @@ bool ServerHMDView::open(const class DeviceEnumerator *enumerator)
 
         // Reset the poll sequence number high water mark
         m_lastPollSeqNumProcessed = -1;
+
+        m_multicam_stage_times.clear();
+        m_last_filter_stage_times.clear();
+        m_last_filter_sample_time_us= 0;
     }
 
     return bSuccess;
@@ -241,6 +254,7 @@ void ServerHMDView::close()
 
 void ServerHMDView::resetPoseFilter()
 {
+	std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
 	assert(m_device != nullptr);
 
 	if (m_pose_filter != nullptr)
@@ -276,170 +290,310 @@ void ServerHMDView::resetPoseFilter()
 
 void ServerHMDView::updateOpticalPoseEstimation(TrackerManager* tracker_manager)
 {
-    const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
-
     // TODO: Probably need to first update IMU state to get velocity.
     // If velocity is too high, don't bother getting a new position.
     // Though it may be enough to just use the camera ROI as the limit.
+
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
+    // Timestamped under the lock, so the tracker threads can't fuse an older estimate after this one
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+
+    PipelineStageTimes stage_times;
+    stage_times.clear();
     
     if (getIsTrackingEnabled())
     {
-        int valid_projection_tracker_ids[TrackerManager::k_max_devices];
-        int projections_found = 0;
-
-        CommonDeviceTrackingShape trackingShape;
-        m_device->getTrackingShape(trackingShape);
-        assert(trackingShape.shape_type != eCommonTrackingShapeType::INVALID_SHAPE);
-
-        // Find the projection of the controller from the perspective of each tracker.
+        // Find the projection of the HMD from the perspective of each tracker with a new video frame.
         // In the case of sphere projections, go ahead and compute the tracker relative position as well.
         for (int tracker_id = 0; tracker_id < tracker_manager->getMaxDevices(); ++tracker_id)
         {
             ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
-            HMDOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
 
-            const bool bWasTracking= trackerPoseEstimateRef.bCurrentlyTracking;
+            // Trackers with a frame processing thread call notifyTrackerDataReceived() instead
+            if (tracker->getIsOpen() && 
+                !tracker->getIsFrameProcessingThreaded() && 
+                tracker->getHasUnpublishedState())
+            {
+                HMDOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
 
-            // Assume we're going to lose tracking this frame
-            bool bCurrentlyTracking = false;
+                // Time the newest of the frames that go into the fused pose
+                if (tracker->getFrameCaptureTimeUs() > stage_times.capture_us)
+                {
+                    stage_times.capture_us= tracker->getFrameCaptureTimeUs();
+                    stage_times.segmentation_done_us= tracker->getFrameSegmentationDoneTimeUs();
+                }
 
-            if (tracker->getIsOpen())
-            {
-                // See how long it's been since we got a new video frame
-                const std::chrono::time_point<std::chrono::high_resolution_clock> now= 
-                    std::chrono::high_resolution_clock::now();
-                const std::chrono::duration<float, std::milli> timeSinceNewDataMillis= 
-                    now - tracker->getLastNewDataTimestamp();
-                const float timeoutMilli= 
-                    static_cast<float>(DeviceManager::getInstance()->m_tracker_manager->getConfig().optical_tracking_timeout);
-
-                // Can't compute tracking on video data that's too old
-                if (timeSinceNewDataMillis.count() < timeoutMilli)
+                // Search with the same request the frame was segmented with.
+                // Rebuilding it now would center the ROI on where the filter has moved to since.
+                TrackedDeviceProjectionRequest request;
+                if (!tracker->getSegmentedProjectionRequestForHMD(getDeviceID(), &request))
                 {
-                    // Initially the newTrackerPoseEstimate is a copy of the existing pose
-                    bool bIsVisibleThisUpdate= false;
+                    build_projection_request(tracker.get(), &request);
+                }
 
-                    // If a new video frame is available this tick, 
-                    // attempt to update the tracking location
-                    if (tracker->getHasUnpublishedState())
-                    {
-                        // Create a copy of the pose estimate state so that in event of a 
-                        // failure part way through computing the projection we don't
-                        // set partially valid state
-                        HMDOpticalPoseEstimation newTrackerPoseEstimate= trackerPoseEstimateRef;
-
-                        if (tracker->computeProjectionForHMD(
-                                this, 
-                                &trackingShape,
-                                &newTrackerPoseEstimate))
-                        {
-                            bIsVisibleThisUpdate= true;
-
-                            // Actually apply the pose estimate state
-                            trackerPoseEstimateRef= newTrackerPoseEstimate;
-                            trackerPoseEstimateRef.last_visible_timestamp = now;
-                        }
-                    }
+                // Create a copy of the pose estimate state so that in event of a 
+                // failure part way through computing the projection we don't
+                // set partially valid state
+                HMDOpticalPoseEstimation newTrackerPoseEstimate= trackerPoseEstimateRef;
 
-                    // If the projection isn't too old (or updated this tick), 
-                    // say we have a valid tracked location
-                    if (bWasTracking || bIsVisibleThisUpdate)
-                    {
-                        const std::chrono::duration<float, std::milli> timeSinceLastVisibleMillis= 
-                            now - trackerPoseEstimateRef.last_visible_timestamp;
-
-                        if (timeSinceLastVisibleMillis.count() < timeoutMilli)
-                        {
-                            // If this tracker has a valid projection for the controller
-                            // add it to the tracker id list
-                            valid_projection_tracker_ids[projections_found] = tracker_id;
-                            ++projections_found;
-
-                            // Flag this pose estimate as invalid
-                            bCurrentlyTracking = true;
-                        }
-                    }
+                if (tracker->computeProjectionForHMD(&request, &newTrackerPoseEstimate))
+                {
+                    // Actually apply the pose estimate state
+                    trackerPoseEstimateRef= newTrackerPoseEstimate;
+                    trackerPoseEstimateRef.last_visible_timestamp = now;
+                    trackerPoseEstimateRef.bCurrentlyTracking = true;
                 }
             }
+        }
+
+        update_multicam_pose_estimation(tracker_manager, now);
+
+        if (stage_times.capture_us != 0)
+        {
+            stage_times.triangulation_done_us= PipelineLatencyStats::getTimestampUs();
+            PipelineLatencyStats::recordStageLatency(
+                PipelineLatencyStage_SegmentationToTriangulation, stage_times.segmentation_done_us, stage_times.triangulation_done_us);
 
-            // Keep track of the last time the position estimate was updated
-            trackerPoseEstimateRef.last_update_timestamp = now;
-            trackerPoseEstimateRef.bValidTimestamps = true;
-            trackerPoseEstimateRef.bCurrentlyTracking = bCurrentlyTracking;
+            // The filter picks these up with the multicam estimate on the next updateStateAndPredict()
+            m_multicam_stage_times= stage_times;
         }
+    }
+}
+
+bool ServerHMDView::getProjectionRequestForTracker(
+    const ServerTrackerView *tracker,
+    TrackedDeviceProjectionRequest *out_request,
+    HMDOpticalPoseEstimation *out_prior_pose_estimate) const
+{
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
+    if (!get_is_optically_trackable_internal())
+    {
+        return false;
+    }
+
+    build_projection_request(tracker, out_request);
+    *out_prior_pose_estimate= m_tracker_pose_estimations[tracker->getDeviceID()];
+
+    return true;
+}
+
+void ServerHMDView::notifyTrackerDataReceived(
+    ServerTrackerView *tracker,
+    const TrackedDeviceProjectionRequest *request,
+    const HMDOpticalPoseEstimation *prior_pose_estimate)
+{
+    const int tracker_id= tracker->getDeviceID();
+    HMDOpticalPoseEstimation newTrackerPoseEstimate= *prior_pose_estimate;
+
+    // Search the video frame without holding the lock so that 
+    // other trackers can process their frames for this HMD in parallel
+    const bool bIsVisible= tracker->computeProjectionForHMD(request, &newTrackerPoseEstimate);
 
-        // How we compute the final world pose estimate varies based on
-        // * Number of trackers that currently have a valid projections of the controller
-        // * The kind of projection shape (psmove sphere or ds4 lightbar)
-        if (projections_found > 1)
+    // Fuse the new projection with the other trackers.
+    // The filter picks up the multicam estimate on the next updateStateAndPredict().
+    {
+        std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
+        // Taken under the lock so the fused estimates are timestamped in the order they're made
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+
+        // The HMD may have been closed or stopped tracking while we were busy
+        if (!get_is_optically_trackable_internal())
         {
-            // If multiple trackers can see the controller, 
-            // triangulate all pairs of projections and average the results
-            switch (trackingShape.shape_type)
-            {
-            case eCommonTrackingShapeType::Sphere:
-                computeSpherePoseForHmdFromMultipleTrackers(
-                    this,
-                    tracker_manager,
-                    valid_projection_tracker_ids,
-                    projections_found,
-                    m_tracker_pose_estimations,
-                    m_multicam_pose_estimation);
-                break;
-            case eCommonTrackingShapeType::PointCloud:
-                computePointCloudPoseForHmdFromMultipleTrackers(
-                    this,
-                    tracker_manager,
-                    valid_projection_tracker_ids,
-                    projections_found,
-                    m_tracker_pose_estimations,
-                    m_multicam_pose_estimation);
-                break;
-            default:
-                assert(false && "unreachable");
-            }
+            return;
         }
-        else if (projections_found == 1 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
+
+        if (bIsVisible)
         {
-            const int tracker_id = valid_projection_tracker_ids[0];
-            const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
+            HMDOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
+
+            trackerPoseEstimateRef= newTrackerPoseEstimate;
+            trackerPoseEstimateRef.last_visible_timestamp = now;
+            trackerPoseEstimateRef.bCurrentlyTracking = true;
+        }
 
-            // If only one tracker can see the controller, 
-            // then use the tracker to derive a world space location
-            switch (trackingShape.shape_type)
+        update_multicam_pose_estimation(DeviceManager::getInstance()->m_tracker_manager, now);
+
+        PipelineStageTimes stage_times;
+        stage_times.clear();
+        stage_times.capture_us= tracker->getFrameCaptureTimeUs();
+        stage_times.segmentation_done_us= tracker->getFrameSegmentationDoneTimeUs();
+        stage_times.triangulation_done_us= PipelineLatencyStats::getTimestampUs();
+        PipelineLatencyStats::recordStageLatency(
+            PipelineLatencyStage_SegmentationToTriangulation, stage_times.segmentation_done_us, stage_times.triangulation_done_us);
+
+        m_multicam_stage_times= stage_times;
+    }
+}
+
+bool ServerHMDView::get_is_optically_trackable_internal() const
+{
+    return getIsOpen() && getIsTrackingEnabled();
+}
+
+void ServerHMDView::build_projection_request(
+    const ServerTrackerView *tracker,
+    TrackedDeviceProjectionRequest *out_request) const
+{
+    m_device->getTrackingShape(out_request->tracking_shape);
+    assert(out_request->tracking_shape.shape_type != eCommonTrackingShapeType::INVALID_SHAPE);
+
+    // Get the HSV filter used to find the tracking blob.
+    // This can run on the tracker's frame processing thread, so use the preset the tracker published
+    // for its latest video frame. If the color changed since then, skip this frame.
+    eCommonTrackingColorID tracked_color_id = getTrackingColorID();
+    if (tracked_color_id != eCommonTrackingColorID::INVALID_COLOR &&
+        !tracker->getPublishedHMDTrackingColorPreset(getDeviceID(), tracked_color_id, &out_request->hsv_color_range))
+    {
+        tracked_color_id= eCommonTrackingColorID::INVALID_COLOR;
+    }
+    out_request->tracking_color_id= tracked_color_id;
+    if (tracked_color_id == eCommonTrackingColorID::INVALID_COLOR)
+    {
+        out_request->hsv_color_range.clear();
+    }
+
+    // Center the region of interest on the current filtered position
+    out_request->bIsROIDisabled= getIsROIDisabled();
+    out_request->roi_world_position_cm= getFilteredPose().PositionCm;
+}
+
+void ServerHMDView::update_multicam_pose_estimation(
+    const TrackerManager* tracker_manager,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &now)
+{
+    int valid_projection_tracker_ids[TrackerManager::k_max_devices];
+    int projections_found = 0;
+
+    CommonDeviceTrackingShape trackingShape;
+    m_device->getTrackingShape(trackingShape);
+    assert(trackingShape.shape_type != eCommonTrackingShapeType::INVALID_SHAPE);
+
+    const float timeoutMilli= 
+        static_cast<float>(DeviceManager::getInstance()->m_tracker_manager->getConfig().optical_tracking_timeout);
+
+    // Determine which trackers still have a recent enough projection of the HMD.
+    // The pose estimates are guarded by m_pose_estimation_mutex, which the caller holds,
+    // but the other trackers' state has to come from the copy they publish for their threads.
+    for (int tracker_id = 0; tracker_id < tracker_manager->getMaxDevices(); ++tracker_id)
+    {
+        ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
+        HMDOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
+
+        TrackerFusionState trackerState;
+        tracker->getFusionState(&trackerState);
+
+        const bool bWasTracking= trackerPoseEstimateRef.bCurrentlyTracking;
+
+        // Assume we're going to lose tracking this frame
+        bool bCurrentlyTracking = false;
+
+        if (trackerState.bIsOpen)
+        {
+            // See how long it's been since we got a new video frame
+            const std::chrono::duration<float, std::milli> timeSinceNewDataMillis= 
+                now - trackerState.last_new_data_timestamp;
+
+            // Can't compute tracking on video data that's too old
+            // If the projection isn't too old (or updated this tick), 
+            // say we have a valid tracked location
+            if (timeSinceNewDataMillis.count() < timeoutMilli && bWasTracking)
             {
-            case eCommonTrackingShapeType::Sphere:
-                computeSpherePoseForHmdFromSingleTracker(
-                    this,
-                    tracker,
-                    &m_tracker_pose_estimations[tracker_id],
-                    m_multicam_pose_estimation);
-                break;
-            case eCommonTrackingShapeType::PointCloud:
-                computePointCloudPoseForHmdFromSingleTracker(
-                    this,
-                    tracker,
-                    &m_tracker_pose_estimations[tracker_id],
-                    m_multicam_pose_estimation);
-                break;
-            default:
-                assert(false && "unreachable");
+                const std::chrono::duration<float, std::milli> timeSinceLastVisibleMillis= 
+                    now - trackerPoseEstimateRef.last_visible_timestamp;
+
+                if (timeSinceLastVisibleMillis.count() < timeoutMilli)
+                {
+                    // If this tracker has a valid projection for the HMD
+                    // add it to the tracker id list
+                    valid_projection_tracker_ids[projections_found] = tracker_id;
+                    ++projections_found;
+
+                    // Flag this pose estimate as invalid
+                    bCurrentlyTracking = true;
+                }
             }
         }
-        // If no trackers can see the controller, maintain the last known position and time it was seen
-        else
+
+        // Keep track of the last time the position estimate was updated
+        trackerPoseEstimateRef.last_update_timestamp = now;
+        trackerPoseEstimateRef.bValidTimestamps = true;
+        trackerPoseEstimateRef.bCurrentlyTracking = bCurrentlyTracking;
+    }
+
+    // How we compute the final world pose estimate varies based on
+    // * Number of trackers that currently have a valid projections of the HMD
+    // * The kind of projection shape (sphere or point cloud)
+    if (projections_found > 1)
+    {
+        // If multiple trackers can see the HMD, 
+        // triangulate all pairs of projections and average the results
+        switch (trackingShape.shape_type)
         {
-            m_multicam_pose_estimation->bCurrentlyTracking= false;
+        case eCommonTrackingShapeType::Sphere:
+            computeSpherePoseForHmdFromMultipleTrackers(
+                this,
+                tracker_manager,
+                valid_projection_tracker_ids,
+                projections_found,
+                m_tracker_pose_estimations,
+                m_multicam_pose_estimation);
+            break;
+        case eCommonTrackingShapeType::PointCloud:
+            computePointCloudPoseForHmdFromMultipleTrackers(
+                this,
+                tracker_manager,
+                valid_projection_tracker_ids,
+                projections_found,
+                m_tracker_pose_estimations,
+                m_multicam_pose_estimation);
+            break;
+        default:
+            assert(false && "unreachable");
         }
+    }
+    else if (projections_found == 1 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
+    {
+        const int tracker_id = valid_projection_tracker_ids[0];
+        const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
 
-        // Update the position estimation timestamps
-        if (m_multicam_pose_estimation->bCurrentlyTracking)
+        // If only one tracker can see the HMD, 
+        // then use the tracker to derive a world space location
+        switch (trackingShape.shape_type)
         {
-            m_multicam_pose_estimation->last_visible_timestamp = now;
+        case eCommonTrackingShapeType::Sphere:
+            computeSpherePoseForHmdFromSingleTracker(
+                this,
+                tracker,
+                &m_tracker_pose_estimations[tracker_id],
+                m_multicam_pose_estimation);
+            break;
+        case eCommonTrackingShapeType::PointCloud:
+            computePointCloudPoseForHmdFromSingleTracker(
+                this,
+                tracker,
+                &m_tracker_pose_estimations[tracker_id],
+                m_multicam_pose_estimation);
+            break;
+        default:
+            assert(false && "unreachable");
         }
-        m_multicam_pose_estimation->last_update_timestamp = now;
-        m_multicam_pose_estimation->bValidTimestamps = true;
     }
+    // If no trackers can see the HMD, maintain the last known position and time it was seen
+    else
+    {
+        m_multicam_pose_estimation->bCurrentlyTracking= false;
+    }
+
+    // Update the position estimation timestamps
+    if (m_multicam_pose_estimation->bCurrentlyTracking)
+    {
+        m_multicam_pose_estimation->last_visible_timestamp = now;
+    }
+    m_multicam_pose_estimation->last_update_timestamp = now;
+    m_multicam_pose_estimation->bValidTimestamps = true;
 }
 
 void ServerHMDView::updateStateAndPredict()
@@ -480,6 +634,25 @@ void ServerHMDView::updateStateAndPredict()
 	m_last_filter_update_timestamp = now;
 	m_last_filter_update_timestamp_valid = true;
 
+	// The tracker frame processing threads update the multicam pose estimate
+	// and read the filter state when computing the ROI
+	std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
+	// HMD states don't carry the time their HID report was read,
+	// so IMU only updates are timed from when the filter takes them
+	PipelineStageTimes stage_times;
+	stage_times.clear();
+	if (getIsCurrentlyTracking() &&
+		m_multicam_stage_times.triangulation_done_us > m_last_filter_stage_times.triangulation_done_us)
+	{
+		// A new multicam estimate gets fused with the states below
+		stage_times= m_multicam_stage_times;
+	}
+	else
+	{
+		stage_times.capture_us= PipelineLatencyStats::getTimestampUs();
+	}
+
 	// Evenly apply the list of hmd state updates over the time since last filter update
 	float per_state_time_delta_seconds = time_delta_seconds / static_cast<float>(firstLookBackIndex + 1);
 
@@ -524,6 +697,17 @@ void ServerHMDView::updateStateAndPredict()
 		// Consider this hmd state sequence num processed
 		m_lastPollSeqNumProcessed = hmdState->PollSequenceNumber;
 	}
+
+	m_last_filter_stage_times= stage_times;
+	// The published pose is as of the newest state processed above (HMD filters never roll back)
+	m_last_filter_sample_time_us= stage_times.getFilterSampleTimeUs(false);
+	m_last_filter_stage_times.filter_done_us= PipelineLatencyStats::getTimestampUs();
+	if (m_last_filter_stage_times.triangulation_done_us != 0)
+	{
+		PipelineLatencyStats::recordStageLatency(
+			PipelineLatencyStage_TriangulationToFilter, 
+			m_last_filter_stage_times.triangulation_done_us, m_last_filter_stage_times.filter_done_us);
+	}
 }
 
 CommonDevicePose
@@ -672,6 +856,7 @@ void ServerHMDView::set_tracking_enabled_internal(bool bEnabled)
 			assert(0 && "unreachable");
 		}
 
+		std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
 		m_tracking_enabled = bEnabled;
 	}
 }
@@ -728,10 +913,34 @@ float ServerHMDView::getROIPredictionTime() const
 
 void ServerHMDView::publish_device_data_frame()
 {
+    // Don't let the tracker threads update the pose estimates while they are being published
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
     // Tell the server request handler we want to send out HMD updates.
     // This will call generate_hmd_data_frame_for_stream for each listening connection.
     ServerRequestHandler::get_instance()->publish_hmd_data_frame(
-        this, &ServerHMDView::generate_hmd_data_frame_for_stream);
+        this, &ServerHMDView::generate_hmd_data_frame_for_stream, false);
+
+    // Same host clients read the HMD state straight out of shared memory instead
+    SharedDeviceStateSlot<SharedHMDState> *shared_state_slot=
+        ServerRequestHandler::get_instance()->get_shared_hmd_state_slot(getDeviceID());
+    if (shared_state_slot != nullptr)
+    {
+        SharedHMDState shared_state;
+
+        generate_hmd_shared_state(this, &shared_state);
+        shared_state_slot->write(shared_state);
+    }
+}
+
+void ServerHMDView::publish_deferred_device_data_frame()
+{
+    std::lock_guard<std::mutex> lock(m_pose_estimation_mutex);
+
+    // Only the rate limited streams that skipped the latest state get it now.
+    // The shared memory state was already written when the state was first published.
+    ServerRequestHandler::get_instance()->publish_hmd_data_frame(
+        this, &ServerHMDView::generate_hmd_data_frame_for_stream, true);
 }
 
 void ServerHMDView::generate_hmd_data_frame_for_stream(
@@ -746,6 +955,23 @@ void ServerHMDView::generate_hmd_data_frame_for_stream(
     hmd_data_frame->set_sequence_num(hmd_view->m_sequence_number);
     hmd_data_frame->set_isconnected(hmd_view->getDevice()->getIsOpen());
 
+    // Lets clients extrapolate the pose in this frame to their own render time (HMD poses aren't predicted)
+    hmd_data_frame->set_sample_time_us(hmd_view->m_last_filter_sample_time_us);
+    hmd_data_frame->set_prediction_time(0.f);
+
+    // Lets clients (and the network layer) see where the time went for the newest filtered sample
+    const PipelineStageTimes &stage_times= hmd_view->m_last_filter_stage_times;
+    if (stage_times.filter_done_us != 0)
+    {
+        PSMoveProtocol::DeviceOutputDataFrame_PipelineTimestamps *pipeline_timestamps=
+            data_frame->mutable_pipeline_timestamps();
+
+        pipeline_timestamps->set_capture_us(stage_times.capture_us);
+        pipeline_timestamps->set_segmentation_done_us(stage_times.segmentation_done_us);
+        pipeline_timestamps->set_triangulation_done_us(stage_times.triangulation_done_us);
+        pipeline_timestamps->set_filter_done_us(stage_times.filter_done_us);
+    }
+
     switch (hmd_view->getHMDDeviceType())
     {
     case CommonHMDState::Morpheus:
@@ -763,6 +989,77 @@ void ServerHMDView::generate_hmd_data_frame_for_stream(
     data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame::HMD);
 }
 
+void ServerHMDView::generate_hmd_shared_state(
+    const ServerHMDView *hmd_view,
+    SharedHMDState *shared_state)
+{
+    memset(shared_state, 0, sizeof(SharedHMDState));
+    shared_state->hmd_type= -1;
+    shared_state->sequence_num= hmd_view->m_sequence_number;
+    shared_state->publish_time_us= SharedDeviceStateHeader::getTimestampMicroseconds();
+
+    if (hmd_view->getDevice()->getIsOpen())
+    {
+        shared_state->state_flags|= SharedDeviceStateFlag_IsConnected;
+    }
+
+    if (hmd_view->getState() == nullptr)
+    {
+        return;
+    }
+
+    const IPoseFilter *pose_filter= hmd_view->getPoseFilter();
+    const CommonDevicePose hmd_pose= hmd_view->getFilteredPose();
+    const CommonDevicePhysics hmd_physics= hmd_view->getFilteredPhysics();
+
+    switch (hmd_view->getHMDDeviceType())
+    {
+    case CommonHMDState::Morpheus:
+        {
+            shared_state->hmd_type= PSMoveProtocol::Morpheus;
+
+            if (pose_filter->getIsStateValid())
+            {
+                shared_state->state_flags|=
+                    SharedDeviceStateFlag_IsOrientationValid | SharedDeviceStateFlag_IsPositionValid;
+            }
+        } break;
+    case CommonHMDState::VirtualHMD:
+        {
+            shared_state->hmd_type= PSMoveProtocol::VirtualHMD;
+
+            if (pose_filter->getIsStateValid())
+            {
+                shared_state->state_flags|= SharedDeviceStateFlag_IsPositionValid;
+            }
+        } break;
+    default:
+        assert(0 && "Unhandled HMD type");
+    }
+
+    if (hmd_view->getIsTrackingEnabled())
+    {
+        shared_state->state_flags|= SharedDeviceStateFlag_IsTrackingEnabled;
+    }
+    if (hmd_view->getIsCurrentlyTracking())
+    {
+        shared_state->state_flags|= SharedDeviceStateFlag_IsCurrentlyTracking;
+    }
+
+    shared_state->orientation[0]= hmd_pose.Orientation.w;
+    shared_state->orientation[1]= hmd_pose.Orientation.x;
+    shared_state->orientation[2]= hmd_pose.Orientation.y;
+    shared_state->orientation[3]= hmd_pose.Orientation.z;
+
+    shared_state->position_cm[0]= hmd_pose.PositionCm.x;
+    shared_state->position_cm[1]= hmd_pose.PositionCm.y;
+    shared_state->position_cm[2]= hmd_pose.PositionCm.z;
+
+    copy_shared_device_physics(hmd_physics, &shared_state->physics);
+    shared_state->sample_time_us= hmd_view->m_last_filter_sample_time_us;
+    shared_state->prediction_time= 0.f;
+}
+
 static void
 init_filters_for_morpheus_hmd(
     const MorpheusHMD *morpheusHMD,
@@ -1469,67 +1766,38 @@ static void computeSpherePoseForHmdFromMultipleTrackers(
     HMDOpticalPoseEstimation *tracker_pose_estimations,
     HMDOpticalPoseEstimation *multicam_pose_estimation)
 {
-    const TrackerManagerConfig &cfg = tracker_manager->getConfig();
+    const ServerTrackerView *trackers[TrackerManager::k_max_devices];
+    CommonDeviceScreenLocation position2d_list[TrackerManager::k_max_devices];
+    float screen_areas[TrackerManager::k_max_devices];
     float screen_area_sum = 0;
+    int biggest_prjection_id = -1;
 
     // Project the tracker relative 3d tracking position back on to the tracker camera plane
-    // and sum up the total controller projection area across all trackers
-    CommonDeviceScreenLocation position2d_list[TrackerManager::k_max_devices];
+    // and sum up the total projection area across all trackers
     for (int list_index = 0; list_index < projections_found; ++list_index)
     {
         const int tracker_id = valid_projection_tracker_ids[list_index];
         const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
         const HMDOpticalPoseEstimation &poseEstimate = tracker_pose_estimations[tracker_id];
 
+        trackers[list_index] = tracker.get();
         position2d_list[list_index] = tracker->projectTrackerRelativePosition(&poseEstimate.position_cm);
+        screen_areas[list_index] = poseEstimate.projection.screen_area;
         screen_area_sum += poseEstimate.projection.screen_area;
-    }
 
-    // Compute triangulations amongst all pairs of projections
-    int pair_count = 0;
-    int biggest_prjection_id = -1;
-    CommonDevicePosition average_world_position = { 0.f, 0.f, 0.f };
-    for (int list_index = 0; list_index < projections_found; ++list_index)
-    {
-        const int tracker_id = valid_projection_tracker_ids[list_index];
-        const CommonDeviceScreenLocation &screen_location = position2d_list[list_index];
-        const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
-
-        for (int other_list_index = list_index + 1; other_list_index < projections_found; ++other_list_index)
+        if (biggest_prjection_id < 0 || screen_areas[list_index] > tracker_pose_estimations[biggest_prjection_id].projection.screen_area)
         {
-            const int other_tracker_id = valid_projection_tracker_ids[other_list_index];
-            const CommonDeviceScreenLocation &other_screen_location = position2d_list[other_list_index];
-            const ServerTrackerViewPtr other_tracker = tracker_manager->getTrackerViewPtr(other_tracker_id);
-            // if trackers are on opposite sides
-            if (cfg.exclude_opposed_cameras)
-            {
-                if ((tracker->getTrackerPose().PositionCm.x > 0) == (other_tracker->getTrackerPose().PositionCm.x < 0) &&
-                    (tracker->getTrackerPose().PositionCm.z > 0) == (other_tracker->getTrackerPose().PositionCm.z < 0))
-                {
-                    float screen_area = tracker_pose_estimations[tracker_id].projection.screen_area;
-                    float other_screen_area = tracker_pose_estimations[other_tracker_id].projection.screen_area;
-
-                    biggest_prjection_id = screen_area > other_screen_area ? tracker_id : other_tracker_id;
-
-                    continue;
-                }
-            }
-
-            // Using the screen locations on two different trackers we can triangulate a world position
-            CommonDevicePosition world_position =
-                ServerTrackerView::triangulateWorldPosition(
-                    tracker.get(), &screen_location,
-                    other_tracker.get(), &other_screen_location);
-
-            average_world_position.x += world_position.x;
-            average_world_position.y += world_position.y;
-            average_world_position.z += world_position.z;
-
-            ++pair_count;
+            biggest_prjection_id = tracker_id;
         }
     }
 
-    if (pair_count == 0 && biggest_prjection_id >= 0 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
+    // Using the screen locations on the trackers we can triangulate a world position
+    CommonDevicePosition world_position;
+    const bool bTriangulated = 
+        ServerTrackerView::triangulateWorldPositionFromVisibleTrackers(
+            trackers, position2d_list, screen_areas, projections_found, &world_position);
+
+    if (!bTriangulated && biggest_prjection_id >= 0 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
     {
         // Position not triangulated from opposed camera, estimate from one tracker only.
         computeSpherePoseForHmdFromSingleTracker(
@@ -1538,26 +1806,19 @@ static void computeSpherePoseForHmdFromMultipleTrackers(
             &tracker_pose_estimations[biggest_prjection_id],
             multicam_pose_estimation);		
     }
-    else if(pair_count > 0)
+    else if (bTriangulated)
     {
-        // Compute the average position
-        const float N = static_cast<float>(pair_count);
-
-        average_world_position.x /= N;
-        average_world_position.y /= N;
-        average_world_position.z /= N;
-
-        // Store the averaged tracking position
+        // Store the triangulated tracking position
         const float q = tracker_manager->getConfig().controller_position_smoothing;
         if (q <= 0.01f)
         {
-            multicam_pose_estimation->position_cm = average_world_position;
+            multicam_pose_estimation->position_cm = world_position;
         }
         else
         {
-            multicam_pose_estimation->position_cm.x = q * multicam_pose_estimation->position_cm.x + (1 - q) * average_world_position.x;
-            multicam_pose_estimation->position_cm.y = q * multicam_pose_estimation->position_cm.y + (1 - q) * average_world_position.y;
-            multicam_pose_estimation->position_cm.z = q * multicam_pose_estimation->position_cm.z + (1 - q) * average_world_position.z;
+            multicam_pose_estimation->position_cm.x = q * multicam_pose_estimation->position_cm.x + (1 - q) * world_position.x;
+            multicam_pose_estimation->position_cm.y = q * multicam_pose_estimation->position_cm.y + (1 - q) * world_position.y;
+            multicam_pose_estimation->position_cm.z = q * multicam_pose_estimation->position_cm.z + (1 - q) * world_position.z;
         }
 
         multicam_pose_estimation->bCurrentlyTracking = true;
@@ -1581,67 +1842,38 @@ static void computePointCloudPoseForHmdFromMultipleTrackers(
     HMDOpticalPoseEstimation *tracker_pose_estimations,
     HMDOpticalPoseEstimation *multicam_pose_estimation)
 {
-    const TrackerManagerConfig &cfg = tracker_manager->getConfig();
+    const ServerTrackerView *trackers[TrackerManager::k_max_devices];
+    CommonDeviceScreenLocation position2d_list[TrackerManager::k_max_devices];
+    float screen_areas[TrackerManager::k_max_devices];
     float screen_area_sum = 0;
+    int biggest_prjection_id = -1;
 
     // Project the tracker relative 3d tracking position back on to the tracker camera plane
-    // and sum up the total controller projection area across all trackers
-    CommonDeviceScreenLocation position2d_list[TrackerManager::k_max_devices];
+    // and sum up the total projection area across all trackers
     for (int list_index = 0; list_index < projections_found; ++list_index)
     {
         const int tracker_id = valid_projection_tracker_ids[list_index];
         const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
         const HMDOpticalPoseEstimation &poseEstimate = tracker_pose_estimations[tracker_id];
 
+        trackers[list_index] = tracker.get();
         position2d_list[list_index] = tracker->projectTrackerRelativePosition(&poseEstimate.position_cm);
+        screen_areas[list_index] = poseEstimate.projection.screen_area;
         screen_area_sum += poseEstimate.projection.screen_area;
-    }
-
-    // Compute triangulations amongst all pairs of projections
-    int pair_count = 0;
-    int biggest_prjection_id = -1;
-    CommonDevicePosition average_world_position = { 0.f, 0.f, 0.f };
-    for (int list_index = 0; list_index < projections_found; ++list_index)
-    {
-        const int tracker_id = valid_projection_tracker_ids[list_index];
-        const CommonDeviceScreenLocation &screen_location = position2d_list[list_index];
-        const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
 
-        for (int other_list_index = list_index + 1; other_list_index < projections_found; ++other_list_index)
+        if (biggest_prjection_id < 0 || screen_areas[list_index] > tracker_pose_estimations[biggest_prjection_id].projection.screen_area)
         {
-            const int other_tracker_id = valid_projection_tracker_ids[other_list_index];
-            const CommonDeviceScreenLocation &other_screen_location = position2d_list[other_list_index];
-            const ServerTrackerViewPtr other_tracker = tracker_manager->getTrackerViewPtr(other_tracker_id);
-            // if trackers are on opposite sides
-            if (cfg.exclude_opposed_cameras)
-            {
-                if ((tracker->getTrackerPose().PositionCm.x > 0) == (other_tracker->getTrackerPose().PositionCm.x < 0) &&
-                    (tracker->getTrackerPose().PositionCm.z > 0) == (other_tracker->getTrackerPose().PositionCm.z < 0))
-                {
-                    float screen_area = tracker_pose_estimations[tracker_id].projection.screen_area;
-                    float other_screen_area = tracker_pose_estimations[other_tracker_id].projection.screen_area;
-
-                    biggest_prjection_id = screen_area > other_screen_area ? tracker_id : other_tracker_id;
-
-                    continue;
-                }
-            }
-
-            // Using the screen locations on two different trackers we can triangulate a world position
-            CommonDevicePosition world_position =
-                ServerTrackerView::triangulateWorldPosition(
-                    tracker.get(), &screen_location,
-                    other_tracker.get(), &other_screen_location);
-
-            average_world_position.x += world_position.x;
-            average_world_position.y += world_position.y;
-            average_world_position.z += world_position.z;
-
-            ++pair_count;
+            biggest_prjection_id = tracker_id;
         }
     }
 
-    if (pair_count == 0 && biggest_prjection_id >= 0 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
+    // Using the screen locations on the trackers we can triangulate a world position
+    CommonDevicePosition world_position;
+    const bool bTriangulated = 
+        ServerTrackerView::triangulateWorldPositionFromVisibleTrackers(
+            trackers, position2d_list, screen_areas, projections_found, &world_position);
+
+    if (!bTriangulated && biggest_prjection_id >= 0 && !DeviceManager::getInstance()->m_tracker_manager->getConfig().ignore_pose_from_one_tracker)
     {
         // Position not triangulated from opposed camera, estimate from one tracker only.
         computePointCloudPoseForHmdFromSingleTracker(
@@ -1650,26 +1882,19 @@ static void computePointCloudPoseForHmdFromMultipleTrackers(
             &tracker_pose_estimations[biggest_prjection_id],
             multicam_pose_estimation);		
     }
-    else if(pair_count > 0)
+    else if (bTriangulated)
     {
-        // Compute the average position
-        const float N = static_cast<float>(pair_count);
-
-        average_world_position.x /= N;
-        average_world_position.y /= N;
-        average_world_position.z /= N;
-
-        // Store the averaged tracking position
+        // Store the triangulated tracking position
         const float q = tracker_manager->getConfig().controller_position_smoothing;
         if (q <= 0.01f)
         {
-            multicam_pose_estimation->position_cm = average_world_position;
+            multicam_pose_estimation->position_cm = world_position;
         }
         else
         {
-            multicam_pose_estimation->position_cm.x = q * multicam_pose_estimation->position_cm.x + (1 - q) * average_world_position.x;
-            multicam_pose_estimation->position_cm.y = q * multicam_pose_estimation->position_cm.y + (1 - q) * average_world_position.y;
-            multicam_pose_estimation->position_cm.z = q * multicam_pose_estimation->position_cm.z + (1 - q) * average_world_position.z;
+            multicam_pose_estimation->position_cm.x = q * multicam_pose_estimation->position_cm.x + (1 - q) * world_position.x;
+            multicam_pose_estimation->position_cm.y = q * multicam_pose_estimation->position_cm.y + (1 - q) * world_position.y;
+            multicam_pose_estimation->position_cm.z = q * multicam_pose_estimation->position_cm.z + (1 - q) * world_position.z;
         }
 
         multicam_pose_estimation->bCurrentlyTracking = true;
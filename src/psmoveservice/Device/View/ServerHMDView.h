@@ -3,8 +3,11 @@
 
 //-- includes -----
 #include "ServerDeviceView.h"
+#include "PipelineLatency.h"
 #include "PSMoveProtocolInterface.h"
+#include <cstdint>
 #include <cstring>
+#include <mutex>
 
 // -- pre-declarations -----
 class TrackerManager;
@@ -56,6 +59,21 @@ public:
 	void updateOpticalPoseEstimation(TrackerManager* tracker_manager);
     void updateStateAndPredict();
 
+	// Snapshots the state a tracker needs to search a video frame for this HMD.
+	// Returns false if the HMD isn't currently optically trackable.
+	bool getProjectionRequestForTracker(
+	    const class ServerTrackerView *tracker,
+	    struct TrackedDeviceProjectionRequest *out_request,
+	    struct HMDOpticalPoseEstimation *out_prior_pose_estimate) const;
+
+	// Called on a tracker's frame processing thread when it has a new video frame.
+	// Finds the HMD in the frame and fuses it into the multicam pose estimate.
+	// The request and prior pose estimate come from getProjectionRequestForTracker().
+	void notifyTrackerDataReceived(
+	    class ServerTrackerView *tracker,
+	    const struct TrackedDeviceProjectionRequest *request,
+	    const struct HMDOpticalPoseEstimation *prior_pose_estimate);
+
     IDeviceInterface* getDevice() const override { return m_device; }
 	inline class IPoseFilter * getPoseFilterMutable() { return m_pose_filter; }
 	inline const class IPoseFilter * getPoseFilter() const { return m_pose_filter; }
@@ -121,16 +139,30 @@ public:
 		return m_multicam_pose_estimation;
 	}
 
+	// Get the pipeline stage times of the newest sample the pose filter processed
+	inline const PipelineStageTimes &getLastFilterStageTimes() const { return m_last_filter_stage_times; }
+
 	// return true if one or more cameras saw this controller last update
 	inline bool getIsCurrentlyTracking() const {
 		return getIsTrackingEnabled() ? m_multicam_pose_estimation->bCurrentlyTracking : false;
 	}
 
+    // Helper used to publish the current HMD state to same host clients and to compact data frames
+    static void generate_hmd_shared_state(
+        const ServerHMDView *hmd_view,
+        struct SharedHMDState *shared_state);
+
 protected:
 	void set_tracking_enabled_internal(bool bEnabled);
+	bool get_is_optically_trackable_internal() const;
+	void build_projection_request(const class ServerTrackerView *tracker, struct TrackedDeviceProjectionRequest *out_request) const;
+	void update_multicam_pose_estimation(
+		const TrackerManager* tracker_manager,
+		const std::chrono::time_point<std::chrono::high_resolution_clock> &now);
     bool allocate_device_interface(const class DeviceEnumerator *enumerator) override;
     void free_device_interface() override;
     void publish_device_data_frame() override;
+    void publish_deferred_device_data_frame() override;
     static void generate_hmd_data_frame_for_stream(
         const ServerHMDView *hmd_view,
         const struct HMDStreamInfo *stream_info,
@@ -147,14 +179,20 @@ private:
 	// Device State
     IHMDInterface *m_device;
 
+	// Guards the optical pose estimates and pose filter against the tracker frame processing threads
+	mutable std::mutex m_pose_estimation_mutex;
+
 	// Filter state
 	HMDOpticalPoseEstimation *m_tracker_pose_estimations; // array of size TrackerManager::k_max_devices
 	HMDOpticalPoseEstimation *m_multicam_pose_estimation;
+	PipelineStageTimes m_multicam_stage_times; // stage times of the newest frames fused into the multicam pose estimate
 	class IPoseFilter *m_pose_filter;
 	class PoseFilterSpace *m_pose_filter_space;
     int m_lastPollSeqNumProcessed;
 	std::chrono::time_point<std::chrono::high_resolution_clock> m_last_filter_update_timestamp;
 	bool m_last_filter_update_timestamp_valid;
+	PipelineStageTimes m_last_filter_stage_times; // stage times of the newest sample the filter processed
+	int64_t m_last_filter_sample_time_us; // PipelineLatencyStats::getTimestampUs() time of the newest state the filter processed
 };
 
 #endif // SERVER_HMD_VIEW_H
\ No newline at end of file
@@ -1,6 +1,11 @@
 //-- includes -----
+#include "ControllerManager.h"
 #include "DeviceEnumerator.h"
 #include "DeviceManager.h"
+#include "ColorMembershipCube.h"
+#include "HMDManager.h"
+#include "HSVColorClassifier.h"
+#include "MainLoopWakeSignal.h"
 #include "ServerTrackerView.h"
 #include "ServerControllerView.h"
 #include "ServerHMDView.h"
@@ -8,24 +13,31 @@
 #include "MathEigen.h"
 #include "MathGLM.h"
 #include "MathAlignment.h"
+#include "PipelineLatency.h"
 #include "PS3EyeTracker.h"
 #include "PSMoveProtocol.pb.h"
+#include "ReplayTracker.h"
+#include "RunLengthBlobExtractor.h"
 #include "ServerUtility.h"
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
 #include "SharedTrackerState.h"
 #include "TrackerManager.h"
+#include "VideoFramePool.h"
 #include "PoseFilterInterface.h"
+#include "WorkerThread.h"
 
 #include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/mapped_region.hpp>
-#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 
 #include "opencv2/opencv.hpp"
 #include "opencv2/calib3d/calib3d.hpp"
 
 #include <algorithm>
+#include <iterator>
 
 #define USE_OPEN_CV_ELLIPSE_FIT
 
@@ -43,6 +55,9 @@ typedef std::vector<t_opencv_float_contour> t_opencv_float_contour_list;
 template<typename t_opencv_contour_type>
 cv::Point2f computeSafeCenterOfMassForContour(const t_opencv_contour_type &contour);
 
+//-- utility methods -----
+static void computeDisjointRegionsForROIUnion(const std::vector<cv::Rect2i> &ROIs, std::vector<cv::Rect2i> &out_regions);
+
 //-- private methods -----
 class SharedVideoFrameReadWriteAccessor
 {
@@ -84,23 +99,25 @@ public:
                     permissions);
 
             // Resize the shared memory
-            m_shared_memory_object->truncate(SharedVideoFrameHeader::computeTotalSize(stride, width));
+            m_shared_memory_object->truncate(SharedVideoFrameHeader::computeTotalSize(stride, height));
 
             // Map all of the shared memory for read/write access
             m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_write);
 
             // Initialize the shared memory (call constructor using placement new)
-            // This make sure the mutex has the constructor called on it.
+            // This make sure the frame slot atomics have the constructor called on them.
             SharedVideoFrameHeader *frameState = new (getFrameHeader()) SharedVideoFrameHeader();
             
             frameState->width = width;
             frameState->height = height;
             frameState->stride = stride;
-            frameState->frame_index = 0;
-            std::memset(
-                frameState->getBufferMutable(),
-                0,
-                SharedVideoFrameHeader::computeVideoBufferSize(stride, height));
+            for (int slot_index = 0; slot_index < SHARED_VIDEO_FRAME_SLOT_COUNT; ++slot_index)
+            {
+                std::memset(
+                    frameState->getSlotBufferMutable(slot_index),
+                    0,
+                    SharedVideoFrameHeader::computeVideoBufferSize(stride, height));
+            }
 
             bSuccess = true;
         }
@@ -119,7 +136,6 @@ public:
         if (m_region != nullptr)
         {
             // Call the destructor manually on the frame header since it was constructed via placement new
-            // This will make sure the mutex has the destructor called on it.
             getFrameHeader()->~SharedVideoFrameHeader();
             
             delete m_region;
@@ -141,16 +157,13 @@ public:
     void writeVideoFrame(const unsigned char *buffer)
     {
         SharedVideoFrameHeader *sharedFrameState = getFrameHeader();
-        boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(sharedFrameState->mutex);
 
-        size_t buffer_size = 
-            SharedVideoFrameHeader::computeVideoBufferSize(sharedFrameState->stride, sharedFrameState->height);
         size_t total_shared_mem_size =
             SharedVideoFrameHeader::computeTotalSize(sharedFrameState->stride, sharedFrameState->height);
         assert(m_region->get_size() >= total_shared_mem_size);
 
-        ++sharedFrameState->frame_index;
-        std::memcpy(sharedFrameState->getBufferMutable(), buffer, buffer_size);
+        // Never blocks: readers that get lapped detect the torn frame and retry
+        sharedFrameState->writeVideoFrame(buffer);
     }
 
 protected:
@@ -332,28 +345,127 @@ private:
 OpenCVBGRToHSVMapper *OpenCVBGRToHSVMapper::m_instance = nullptr;
 int OpenCVBGRToHSVMapper::m_refCount= 0;
 
+struct OpenCVHSVColorBounds
+{
+    // The hue angle can wrap around, so it's tested against two ranges
+    uint8_t hue_min[2];
+    uint8_t hue_max[2];
+    uint8_t saturation_min;
+    uint8_t saturation_max;
+    uint8_t value_min;
+    uint8_t value_max;
+
+    static OpenCVHSVColorBounds createFromColorRange(const CommonHSVColorRange &hsvColorRange)
+    {
+        const float hue_min = hsvColorRange.hue_range.center - hsvColorRange.hue_range.range;
+        const float hue_max = hsvColorRange.hue_range.center + hsvColorRange.hue_range.range;
+        const float saturation_min = clampf(hsvColorRange.saturation_range.center - hsvColorRange.saturation_range.range, 0, 255);
+        const float saturation_max = clampf(hsvColorRange.saturation_range.center + hsvColorRange.saturation_range.range, 0, 255);
+        const float value_min = clampf(hsvColorRange.value_range.center - hsvColorRange.value_range.range, 0, 255);
+        const float value_max = clampf(hsvColorRange.value_range.center + hsvColorRange.value_range.range, 0, 255);
+
+        // Bounds are rounded to the nearest integer the same way cv::inRange does it
+        OpenCVHSVColorBounds bounds;
+        bounds.saturation_min= cv::saturate_cast<uint8_t>(saturation_min);
+        bounds.saturation_max= cv::saturate_cast<uint8_t>(saturation_max);
+        bounds.value_min= cv::saturate_cast<uint8_t>(value_min);
+        bounds.value_max= cv::saturate_cast<uint8_t>(value_max);
+
+        if (hue_min < 0)
+        {
+            bounds.hue_min[0]= 0;
+            bounds.hue_max[0]= cv::saturate_cast<uint8_t>(clampf(hue_max, 0, 180));
+            bounds.hue_min[1]= cv::saturate_cast<uint8_t>(clampf(180 + hue_min, 0, 180));
+            bounds.hue_max[1]= 180;
+        }
+        else if (hue_max > 180)
+        {
+            bounds.hue_min[0]= 0;
+            bounds.hue_max[0]= cv::saturate_cast<uint8_t>(clampf(hue_max - 180, 0, 180));
+            bounds.hue_min[1]= cv::saturate_cast<uint8_t>(clampf(hue_min, 0, 180));
+            bounds.hue_max[1]= 180;
+        }
+        else
+        {
+            bounds.hue_min[0]= cv::saturate_cast<uint8_t>(hue_min);
+            bounds.hue_max[0]= cv::saturate_cast<uint8_t>(hue_max);
+            bounds.hue_min[1]= 1; // empty range
+            bounds.hue_max[1]= 0;
+        }
+
+        return bounds;
+    }
+
+    inline bool hasWrappedHueRange() const
+    {
+        return hue_min[1] <= hue_max[1];
+    }
+
+    inline bool contains(const uint8_t h, const uint8_t s, const uint8_t v) const
+    {
+        return 
+            s >= saturation_min && s <= saturation_max &&
+            v >= value_min && v <= value_max &&
+            ((h >= hue_min[0] && h <= hue_max[0]) || (h >= hue_min[1] && h <= hue_max[1]));
+    }
+
+    HSVColorClassifierBounds toClassifierBounds(const uint8_t mask_bits) const
+    {
+        HSVColorClassifierBounds classifier_bounds;
+        classifier_bounds.hue_min[0]= hue_min[0];
+        classifier_bounds.hue_max[0]= hue_max[0];
+        classifier_bounds.hue_min[1]= hue_min[1];
+        classifier_bounds.hue_max[1]= hue_max[1];
+        classifier_bounds.saturation_min= saturation_min;
+        classifier_bounds.saturation_max= saturation_max;
+        classifier_bounds.value_min= value_min;
+        classifier_bounds.value_max= value_max;
+        classifier_bounds.mask_bits= mask_bits;
+
+        return classifier_bounds;
+    }
+
+    bool operator==(const OpenCVHSVColorBounds &other) const
+    {
+        return 
+            hue_min[0] == other.hue_min[0] && hue_max[0] == other.hue_max[0] &&
+            hue_min[1] == other.hue_min[1] && hue_max[1] == other.hue_max[1] &&
+            saturation_min == other.saturation_min && saturation_max == other.saturation_max &&
+            value_min == other.value_min && value_max == other.value_max;
+    }
+};
+
 class OpenCVBufferState
 {
 public:
     OpenCVBufferState(ITrackerInterface *device)
         : bgrBuffer(nullptr)
         , bgrShmemBuffer(nullptr)
+        , bDrawDebugOverlay(false)
         , hsvBuffer(nullptr)
         , gsLowerBuffer(nullptr)
         , gsUpperBuffer(nullptr)
         , maskedBuffer(nullptr)
+        , colorMaskBuffer(nullptr)
     {
         device->getVideoFrameDimensions(&frameWidth, &frameHeight, nullptr);
 
-        bgrBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
+        bgrBuffer = new cv::Mat(cv::Mat::zeros(frameHeight, frameWidth, CV_8UC3));
         bgrShmemBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
         hsvBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
         gsLowerBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
         gsUpperBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
         maskedBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
+        colorMaskBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
         
         const TrackerManagerConfig &cfg= DeviceManager::getInstance()->m_tracker_manager->getConfig();
-        if (cfg.use_bgr_to_hsv_lookup_table)
+        // The cubes cache the fused classifier's answers, so turning them on 
+        // switches the fused classifier over to looking them up
+        bUseColorMembershipCubes= cfg.use_color_membership_cubes;
+        bUseFusedColorClassifier= cfg.use_fused_hsv_color_classifier && !bUseColorMembershipCubes;
+        bUseRunLengthBlobExtractor= cfg.use_run_length_blob_extractor;
+        bUseSharedSegmentation= cfg.use_shared_frame_segmentation;
+        if (cfg.use_bgr_to_hsv_lookup_table && !bUseFusedColorClassifier && !bUseColorMembershipCubes)
         {
             bgr2hsv = OpenCVBGRToHSVMapper::allocate();
         }
@@ -362,12 +474,19 @@ public:
             bgr2hsv = nullptr;
         }
         
+        clearSegmentation();
+
         //Apply default ROI (full frame).
         applyROI(cv::Rect2i(cv::Point(0,0), cv::Size(frameWidth, frameHeight)));
     }
 
     virtual ~OpenCVBufferState()
     {
+        if (colorMaskBuffer != nullptr)
+        {
+            delete colorMaskBuffer;
+        }
+
         if (maskedBuffer != nullptr)
         {
             delete maskedBuffer;
@@ -404,28 +523,271 @@ public:
         }
     }
 
-    void writeVideoFrame(const unsigned char *video_buffer)
+    // Point the source buffer at the given pooled frame (no copy).
+    // The debug overlay only gets a copy of the frame if someone is going to look at it.
+    void setVideoFrame(const VideoFramePtr &video_frame, bool bWantsDebugOverlay)
     {
-        const cv::Mat videoBufferMat(frameHeight, frameWidth, CV_8UC3, const_cast<unsigned char *>(video_buffer));
+        assert(video_frame->getWidth() == frameWidth && video_frame->getHeight() == frameHeight);
+
+        // Hold a reference so the driver can't recycle the buffer while we read from it
+        videoFrame= video_frame;
+        *bgrBuffer= cv::Mat(
+            frameHeight, frameWidth, CV_8UC3, 
+            const_cast<unsigned char *>(videoFrame->getData()), static_cast<size_t>(videoFrame->getStride()));
 
-        videoBufferMat.copyTo(*bgrBuffer);
-        videoBufferMat.copyTo(*bgrShmemBuffer);
+        bDrawDebugOverlay= bWantsDebugOverlay;
+        if (bDrawDebugOverlay)
+        {
+            bgrBuffer->copyTo(*bgrShmemBuffer);
+        }
+
+        clearSegmentation();
+    }
+
+    inline bool getHasDebugOverlay() const
+    {
+        return bDrawDebugOverlay;
     }
     
-    void updateHsvBuffer()
+    void updateHsvBuffer(const cv::Mat &bgrRegion, cv::Mat &hsvRegion)
     {
         // Convert the video buffer to the HSV color space
         if (bgr2hsv != nullptr)
         {
-            bgr2hsv->cvtColor(bgrROI, hsvROI);
+            bgr2hsv->cvtColor(bgrRegion, hsvRegion);
         }
         else
         {
-            cv::cvtColor(bgrROI, hsvROI, cv::COLOR_BGR2HSV);
+            cv::cvtColor(bgrRegion, hsvRegion, cv::COLOR_BGR2HSV);
         }
     }
-    
-    void applyROI(cv::Rect2i ROI)
+
+    // Convert a BGR region to HSV and clamp it to the given color bounds in a single pass
+    void classifyRegion(
+        const cv::Mat &bgrRegion, cv::Mat &maskRegion,
+        const HSVColorClassifierBounds *bounds, int bounds_count)
+    {
+        for (int row = 0; row < bgrRegion.rows; ++row)
+        {
+            HSVColorClassifier::classify_bgr_row(
+                bgrRegion.ptr<uint8_t>(row), maskRegion.ptr<uint8_t>(row), bgrRegion.cols,
+                bounds, bounds_count);
+        }
+    }
+
+    // Get the membership cube for the given color,
+    // rebuilding it if the color's HSV range changed since it was last used (i.e. the preset was edited)
+    const ColorMembershipCube *getColorMembershipCube(eCommonTrackingColorID color_id, const OpenCVHSVColorBounds &bounds)
+    {
+        assert(color_id >= 0 && color_id < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES);
+        const HSVColorClassifierBounds classifier_bounds= bounds.toClassifierBounds(0);
+        ColorMembershipCube &cube= colorCubes[color_id];
+
+        if (!cube.getHasBounds(classifier_bounds))
+        {
+            cube.rebuild(classifier_bounds);
+        }
+
+        return &cube;
+    }
+
+    // Classify a BGR region against the given color membership cubes
+    void classifyRegion(
+        const cv::Mat &bgrRegion, cv::Mat &maskRegion,
+        const ColorMembershipCube * const *cubes, const uint8_t *mask_bits, int cube_count)
+    {
+        for (int row = 0; row < bgrRegion.rows; ++row)
+        {
+            ColorMembershipCube::classify_bgr_row(
+                bgrRegion.ptr<uint8_t>(row), maskRegion.ptr<uint8_t>(row), bgrRegion.cols,
+                cubes, mask_bits, cube_count);
+        }
+    }
+
+    // Forget the color segmentation from the previous video frame
+    void clearSegmentation()
+    {
+        segmentationROIs.clear();
+        segmentationColorIDs.clear();
+        segmentationColorBounds.clear();
+
+        segmentedRegions.clear();
+        segmentedColorCount= 0;
+    }
+
+    void addSegmentationRequest(const cv::Rect2i &ROI, eCommonTrackingColorID color_id, const CommonHSVColorRange &hsvColorRange)
+    {
+        assert(color_id >= 0 && color_id < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES);
+
+        segmentationROIs.push_back(clampROI(ROI));
+        segmentationColorIDs.push_back(color_id);
+        segmentationColorBounds.push_back(OpenCVHSVColorBounds::createFromColorRange(hsvColorRange));
+    }
+
+    // Convert the union of all requested ROIs to HSV once and classify every pixel
+    // against all of the requested colors in the same pass.
+    // Each pixel of the color mask buffer gets bit (1 << color_id) set for every matching color.
+    static_assert(eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES <= 8,
+        "the color mask buffer has one bit per tracking color in a uint8_t per pixel");
+    void computeSegmentation()
+    {
+        segmentedRegions.clear();
+        segmentedColorCount= 0;
+
+        // Gather the distinct (color, HSV range) pairs requested this frame.
+        // The mask has one bit per color, so if two devices ask for the same color with different HSV ranges
+        // only the first range is segmented. The other request is left out of the pass entirely 
+        // and segments its own ROI in computeBiggestNContours().
+        segmentedROIs.clear();
+        for (size_t request_index = 0; request_index < segmentationColorIDs.size(); ++request_index)
+        {
+            const eCommonTrackingColorID color_id= segmentationColorIDs[request_index];
+            const OpenCVHSVColorBounds &bounds= segmentationColorBounds[request_index];
+            bool bIsDuplicate= false;
+            bool bIsConflicting= false;
+
+            for (int color_index = 0; color_index < segmentedColorCount; ++color_index)
+            {
+                if (segmentedColorIDs[color_index] == color_id)
+                {
+                    bIsDuplicate= (segmentedColorBounds[color_index] == bounds);
+                    bIsConflicting= !bIsDuplicate;
+                    break;
+                }
+            }
+
+            if (bIsConflicting)
+            {
+                continue;
+            }
+
+            if (!bIsDuplicate)
+            {
+                segmentedColorIDs[segmentedColorCount]= color_id;
+                segmentedColorBounds[segmentedColorCount]= bounds;
+                ++segmentedColorCount;
+            }
+
+            segmentedROIs.push_back(segmentationROIs[request_index]);
+        }
+
+        if (segmentedColorCount == 0)
+        {
+            return;
+        }
+
+        // Split the union of the ROIs into non-overlapping rectangles
+        // so that no pixel gets converted or classified twice
+        computeDisjointRegionsForROIUnion(segmentedROIs, segmentedRegions);
+
+        if (bUseFusedColorClassifier)
+        {
+            HSVColorClassifierBounds classifier_bounds[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+            for (int color_index = 0; color_index < segmentedColorCount; ++color_index)
+            {
+                classifier_bounds[color_index]= 
+                    segmentedColorBounds[color_index].toClassifierBounds(
+                        static_cast<uint8_t>(1 << segmentedColorIDs[color_index]));
+            }
+
+            for (const cv::Rect2i &region : segmentedRegions)
+            {
+                const cv::Mat bgrRegion(*bgrBuffer, region);
+                cv::Mat colorMaskRegion(*colorMaskBuffer, region);
+
+                classifyRegion(bgrRegion, colorMaskRegion, classifier_bounds, segmentedColorCount);
+            }
+
+            return;
+        }
+
+        if (bUseColorMembershipCubes)
+        {
+            const ColorMembershipCube *cubes[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+            uint8_t mask_bits[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+            for (int color_index = 0; color_index < segmentedColorCount; ++color_index)
+            {
+                cubes[color_index]= getColorMembershipCube(segmentedColorIDs[color_index], segmentedColorBounds[color_index]);
+                mask_bits[color_index]= static_cast<uint8_t>(1 << segmentedColorIDs[color_index]);
+            }
+
+            for (const cv::Rect2i &region : segmentedRegions)
+            {
+                const cv::Mat bgrRegion(*bgrBuffer, region);
+                cv::Mat colorMaskRegion(*colorMaskBuffer, region);
+
+                classifyRegion(bgrRegion, colorMaskRegion, cubes, mask_bits, segmentedColorCount);
+            }
+
+            return;
+        }
+
+        for (const cv::Rect2i &region : segmentedRegions)
+        {
+            const cv::Mat bgrRegion(*bgrBuffer, region);
+            cv::Mat hsvRegion(*hsvBuffer, region);
+            cv::Mat colorMaskRegion(*colorMaskBuffer, region);
+
+            updateHsvBuffer(bgrRegion, hsvRegion);
+
+            for (int row = 0; row < region.height; ++row)
+            {
+                const uint8_t *hsv_pixel = hsvRegion.ptr<uint8_t>(row);
+                uint8_t *color_mask_pixel = colorMaskRegion.ptr<uint8_t>(row);
+
+                for (int col = 0; col < region.width; ++col)
+                {
+                    const uint8_t h= hsv_pixel[0];
+                    const uint8_t s= hsv_pixel[1];
+                    const uint8_t v= hsv_pixel[2];
+                    uint8_t color_bits= 0;
+
+                    for (int color_index = 0; color_index < segmentedColorCount; ++color_index)
+                    {
+                        if (segmentedColorBounds[color_index].contains(h, s, v))
+                        {
+                            color_bits|= static_cast<uint8_t>(1 << segmentedColorIDs[color_index]);
+                        }
+                    }
+
+                    *color_mask_pixel= color_bits;
+                    hsv_pixel+= 3;
+                    ++color_mask_pixel;
+                }
+            }
+        }
+    }
+
+    // Returns true if the current ROI was already classified for the given color this frame
+    bool getIsROISegmented(eCommonTrackingColorID color_id, const OpenCVHSVColorBounds &bounds) const
+    {
+        bool bIsColorSegmented= false;
+        for (int color_index = 0; color_index < segmentedColorCount; ++color_index)
+        {
+            if (segmentedColorIDs[color_index] == color_id)
+            {
+                bIsColorSegmented= (segmentedColorBounds[color_index] == bounds);
+                break;
+            }
+        }
+
+        if (!bIsColorSegmented)
+        {
+            return false;
+        }
+
+        // The segmented regions don't overlap, 
+        // so the ROI is covered when the overlapping areas add up to the ROI area
+        int covered_area= 0;
+        for (const cv::Rect2i &region : segmentedRegions)
+        {
+            covered_area+= (region & currentROI).area();
+        }
+
+        return covered_area == currentROI.area();
+    }
+
+    cv::Rect2i clampROI(cv::Rect2i ROI) const
     {
         // Make sure the ROI box is always clamped in bounds of the frame buffer
         int x0= std::min(std::max(ROI.tl().x, 0), frameWidth-1);
@@ -451,24 +813,35 @@ public:
             ROI.width = frameWidth;
             ROI.height = frameHeight;
         }
+
+        return ROI;
+    }
+    
+    void applyROI(cv::Rect2i ROI)
+    {
+        ROI= clampROI(ROI);
        
         //Create the ROI matrices.
         //It's not a full copy, so this isn't too slow.
         //adjustROI is probably slightly faster but I ran into trouble with it.
+        currentROI = ROI;
         bgrROI = cv::Mat(*bgrBuffer, ROI);
         hsvROI = cv::Mat(*hsvBuffer, ROI);
         gsLowerROI = cv::Mat(*gsLowerBuffer, ROI);
         gsUpperROI = cv::Mat(*gsUpperBuffer, ROI);
-        
-        updateHsvBuffer();
+        colorMaskROI = cv::Mat(*colorMaskBuffer, ROI);
         
         //Draw ROI.
-        cv::rectangle(*bgrShmemBuffer, ROI, cv::Scalar(255, 0, 0));
+        if (bDrawDebugOverlay)
+        {
+            cv::rectangle(*bgrShmemBuffer, ROI, cv::Scalar(255, 0, 0));
+        }
     }
 
     // Return points in raw image space:
     // i.e. [0, 0] at lower left  to [frameWidth-1, frameHeight-1] at lower right
     bool computeBiggestNContours(
+        const eCommonTrackingColorID color_id,
         const CommonHSVColorRange &hsvColorRange,
         t_opencv_int_contour_list &out_biggest_N_contours,
         std::vector<double> &out_contour_areas,
@@ -477,131 +850,184 @@ public:
     {
         out_biggest_N_contours.clear();
         out_contour_areas.clear();
-        
-        // Clamp the HSV image, taking into account wrapping the hue angle
+
+        const OpenCVHSVColorBounds bounds= OpenCVHSVColorBounds::createFromColorRange(hsvColorRange);
+
+        if (getIsROISegmented(color_id, bounds))
+        {
+            // Reuse the per-frame classification from computeSegmentation()
+            cv::bitwise_and(colorMaskROI, cv::Scalar(1 << color_id), gsLowerROI);
+        }
+        else if (bUseFusedColorClassifier)
         {
-            const float hue_min = hsvColorRange.hue_range.center - hsvColorRange.hue_range.range;
-            const float hue_max = hsvColorRange.hue_range.center + hsvColorRange.hue_range.range;
-            const float saturation_min = clampf(hsvColorRange.saturation_range.center - hsvColorRange.saturation_range.range, 0, 255);
-            const float saturation_max = clampf(hsvColorRange.saturation_range.center + hsvColorRange.saturation_range.range, 0, 255);
-            const float value_min = clampf(hsvColorRange.value_range.center - hsvColorRange.value_range.range, 0, 255);
-            const float value_max = clampf(hsvColorRange.value_range.center + hsvColorRange.value_range.range, 0, 255);
+            const HSVColorClassifierBounds classifier_bounds= bounds.toClassifierBounds(255);
 
-            if (hue_min < 0)
-            {
-                cv::inRange(
-                    hsvROI,
-                    cv::Scalar(0, saturation_min, value_min),
-                    cv::Scalar(clampf(hue_max, 0, 180), saturation_max, value_max),
-                    gsLowerROI);
-                cv::inRange(
-                    hsvROI,
-                    cv::Scalar(clampf(180 + hue_min, 0, 180), saturation_min, value_min),
-                    cv::Scalar(180, saturation_max, value_max),
-                    gsUpperROI);
-                cv::bitwise_or(gsLowerROI, gsUpperROI, gsLowerROI);
-            }
-            else if (hue_max > 180)
+            classifyRegion(bgrROI, gsLowerROI, &classifier_bounds, 1);
+        }
+        else if (bUseColorMembershipCubes)
+        {
+            const ColorMembershipCube *cube= getColorMembershipCube(color_id, bounds);
+            const uint8_t mask_bits= 255;
+
+            classifyRegion(bgrROI, gsLowerROI, &cube, &mask_bits, 1);
+        }
+        else
+        {
+            updateHsvBuffer(bgrROI, hsvROI);
+
+            // Clamp the HSV image, taking into account wrapping the hue angle
+            cv::inRange(
+                hsvROI,
+                cv::Scalar(bounds.hue_min[0], bounds.saturation_min, bounds.value_min),
+                cv::Scalar(bounds.hue_max[0], bounds.saturation_max, bounds.value_max),
+                gsLowerROI);
+
+            if (bounds.hasWrappedHueRange())
             {
                 cv::inRange(
                     hsvROI,
-                    cv::Scalar(0, saturation_min, value_min),
-                    cv::Scalar(clampf(hue_max - 180, 0, 180), saturation_max, value_max),
-                    gsLowerROI);
-                cv::inRange(
-                    hsvROI,
-                    cv::Scalar(clampf(hue_min, 0, 180), saturation_min, value_min),
-                    cv::Scalar(180, saturation_max, value_max),
+                    cv::Scalar(bounds.hue_min[1], bounds.saturation_min, bounds.value_min),
+                    cv::Scalar(bounds.hue_max[1], bounds.saturation_max, bounds.value_max),
                     gsUpperROI);
                 cv::bitwise_or(gsLowerROI, gsUpperROI, gsLowerROI);
             }
-            else
-            {
-                cv::inRange(
-                    hsvROI,
-                    cv::Scalar(hue_min, saturation_min, value_min),
-                    cv::Scalar(hue_max, saturation_max, value_max),
-                    gsLowerROI);
-            }
         }
         
         //TODO: Why no blurring of the gsLowerBuffer?
 
-        // Find the largest convex blob in the filtered grayscale buffer
+        if (bUseRunLengthBlobExtractor)
         {
-            struct ContourInfo
-            {
-                int contour_index;
-                double contour_area;
-            };
-            std::vector<ContourInfo> sorted_contour_list;
-
-            // Find all counters in the image buffer
-            cv::Size size; cv::Point ofs;
-            gsLowerROI.locateROI(size, ofs);
-            t_opencv_int_contour_list contours;
-            cv::findContours(gsLowerROI,
-                             contours,
-                             CV_RETR_EXTERNAL,
-                             CV_CHAIN_APPROX_SIMPLE,  //CV_CHAIN_APPROX_NONE?
-                             ofs);
-
-            // Compute the area of each contour
-            int contour_index = 0;
-            for (auto it = contours.begin(); it != contours.end(); ++it) 
-            {
-                const double contour_area = cv::contourArea(*it);
-                const ContourInfo contour_info = { contour_index, contour_area };
+            computeBiggestNBlobs(out_biggest_N_contours, out_contour_areas, max_contour_count, min_points_in_contour);
+        }
+        else
+        {
+            computeBiggestNContoursOpenCV(out_biggest_N_contours, out_contour_areas, max_contour_count, min_points_in_contour);
+        }
 
-                sorted_contour_list.push_back(contour_info);
-                ++contour_index;
-            }
-            
-            // Sort the list of contours by area, largest to smallest
-            if (sorted_contour_list.size() > 1)
-            {
-                std::sort(
-                    sorted_contour_list.begin(), sorted_contour_list.end(), 
-                    [](const ContourInfo &a, const ContourInfo &b) {
-                        return b.contour_area < a.contour_area;
-                });
-            }
+        return (out_biggest_N_contours.size() > 0);
+    }
+
+    // Label the blobs of the ROI mask in a single pass and trace the outlines of the biggest N
+    void computeBiggestNBlobs(
+        t_opencv_int_contour_list &out_biggest_N_contours,
+        std::vector<double> &out_contour_areas,
+        const int max_contour_count,
+        const int min_points_in_contour)
+    {
+        cv::Size size; cv::Point ofs;
+        gsLowerROI.locateROI(size, ofs);
+
+        // Only the biggest N blobs get outlined, so unlike computeBiggestNContoursOpenCV()
+        // a blob with too few outline points isn't replaced by the next biggest one.
+        // The blob area is its pixel count rather than the area of its outline.
+        const int blob_count=
+            blobExtractor.extractBiggestBlobs(
+                gsLowerROI.ptr<uint8_t>(0), gsLowerROI.cols, gsLowerROI.rows, static_cast<int>(gsLowerROI.step),
+                ofs.x, ofs.y, max_contour_count);
 
-            // Copy up to N valid contours
-            for (auto it = sorted_contour_list.begin(); 
-                it != sorted_contour_list.end() && static_cast<int>(out_biggest_N_contours.size()) < max_contour_count; 
-                ++it)
+        for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+        {
+            const BlobInfo &blob= blobExtractor.getBlob(blob_index);
+
+            if (blob.boundary_count > min_points_in_contour)
             {
-                const ContourInfo &contour_info = *it;
-                t_opencv_int_contour &contour = contours[contour_info.contour_index];
+                const BlobPoint *boundary= blobExtractor.getBlobBoundary(blob_index);
 
-                if (contour.size() > min_points_in_contour)
-                {
-                    // Remove any points in contour on edge of camera/ROI
-                    // TODO: Contours touching image border will be clipped,
-                    // so this might not be necessary.
-                    t_opencv_int_contour::iterator it = contour.begin();
-                    while (it != contour.end()) 
-                    {
-                        if (it->x == 0 || it->x == (frameWidth - 1) || it->y == 0 || it->y == (frameHeight - 1))
-                        {
-                            it = contour.erase(it);
-                        }
-                        else
-                        {
-                            ++it;
-                        }
-                    }
+                out_biggest_N_contours.push_back(t_opencv_int_contour());
+                t_opencv_int_contour &contour= out_biggest_N_contours.back();
+                contour.reserve(blob.boundary_count);
 
-                    // Add cleaned up contour to the output list
-                    out_biggest_N_contours.push_back(contour);
-                    // Add its area to the output list too.
-                    out_contour_areas.push_back(contour_info.contour_area);
+                for (int point_index = 0; point_index < blob.boundary_count; ++point_index)
+                {
+                    contour.push_back(cv::Point(boundary[point_index].x, boundary[point_index].y));
                 }
+
+                removeContourPointsOnFrameEdge(contour);
+                out_contour_areas.push_back(static_cast<double>(blob.m00));
             }
         }
+    }
 
-        return (out_biggest_N_contours.size() > 0);
+    // Find the contours of the ROI mask with OpenCV and keep the biggest N
+    void computeBiggestNContoursOpenCV(
+        t_opencv_int_contour_list &out_biggest_N_contours,
+        std::vector<double> &out_contour_areas,
+        const int max_contour_count,
+        const int min_points_in_contour)
+    {
+        struct ContourInfo
+        {
+            int contour_index;
+            double contour_area;
+        };
+        std::vector<ContourInfo> sorted_contour_list;
+
+        // Find all counters in the image buffer
+        cv::Size size; cv::Point ofs;
+        gsLowerROI.locateROI(size, ofs);
+        t_opencv_int_contour_list contours;
+        cv::findContours(gsLowerROI,
+                         contours,
+                         CV_RETR_EXTERNAL,
+                         CV_CHAIN_APPROX_SIMPLE,  //CV_CHAIN_APPROX_NONE?
+                         ofs);
+
+        // Compute the area of each contour
+        int contour_index = 0;
+        for (auto it = contours.begin(); it != contours.end(); ++it) 
+        {
+            const double contour_area = cv::contourArea(*it);
+            const ContourInfo contour_info = { contour_index, contour_area };
+
+            sorted_contour_list.push_back(contour_info);
+            ++contour_index;
+        }
+        
+        // Sort the list of contours by area, largest to smallest
+        if (sorted_contour_list.size() > 1)
+        {
+            std::sort(
+                sorted_contour_list.begin(), sorted_contour_list.end(), 
+                [](const ContourInfo &a, const ContourInfo &b) {
+                    return b.contour_area < a.contour_area;
+            });
+        }
+
+        // Copy up to N valid contours
+        for (auto it = sorted_contour_list.begin(); 
+            it != sorted_contour_list.end() && static_cast<int>(out_biggest_N_contours.size()) < max_contour_count; 
+            ++it)
+        {
+            const ContourInfo &contour_info = *it;
+            t_opencv_int_contour &contour = contours[contour_info.contour_index];
+
+            if (contour.size() > min_points_in_contour)
+            {
+                removeContourPointsOnFrameEdge(contour);
+
+                // Add cleaned up contour to the output list
+                out_biggest_N_contours.push_back(contour);
+                // Add its area to the output list too.
+                out_contour_areas.push_back(contour_info.contour_area);
+            }
+        }
+    }
+
+    void removeContourPointsOnFrameEdge(t_opencv_int_contour &contour) const
+    {
+        // Remove any points in contour on edge of camera/ROI
+        // TODO: Contours touching image border will be clipped,
+        // so this might not be necessary.
+        const int max_x= frameWidth - 1;
+        const int max_y= frameHeight - 1;
+
+        contour.erase(
+            std::remove_if(
+                contour.begin(), contour.end(),
+                [max_x, max_y](const cv::Point &point) {
+                    return point.x == 0 || point.x == max_x || point.y == 0 || point.y == max_y;
+            }),
+            contour.end());
     }
     
     void
@@ -609,6 +1035,11 @@ public:
     {
         // Draws the contour directly onto the shared mem buffer.
         // This is useful for debugging
+        if (!bDrawDebugOverlay)
+        {
+            return;
+        }
+
         std::vector<t_opencv_int_contour> contours = {contour};
         const cv::Point2f massCenter = computeSafeCenterOfMassForContour<t_opencv_int_contour>(contour);
         cv::drawContours(*bgrShmemBuffer, contours, 0, cv::Scalar(255, 255, 255));
@@ -622,6 +1053,11 @@ public:
     draw_pose_projection(const CommonDeviceTrackingProjection &pose_projection)
     {
         // Draw the projection of the pose onto the shared mem buffer.
+        if (!bDrawDebugOverlay)
+        {
+            return;
+        }
+
         switch (pose_projection.shape_type)
         {
         case eCommonTrackingProjectionType::ProjectionType_Ellipse:
@@ -698,8 +1134,10 @@ public:
     int frameWidth;
     int frameHeight;
 
+    VideoFramePtr videoFrame; // pooled video frame the source buffer points into
     cv::Mat *bgrBuffer; // source video frame
     cv::Mat *bgrShmemBuffer; //Frame onto which we draw debug lines, and transmit via shared mem.
+    bool bDrawDebugOverlay; // true if bgrShmemBuffer holds a copy of the current frame to draw on
     cv::Mat bgrROI;
     cv::Mat *hsvBuffer; // source frame converted to HSV color space
     cv::Mat hsvROI;
@@ -708,41 +1146,248 @@ public:
     cv::Mat *gsUpperBuffer; // HSV image clamped by HSV range into grayscale mask
     cv::Mat gsUpperROI;
     cv::Mat *maskedBuffer; // bgr image ANDed together with grayscale mask
+    cv::Mat *colorMaskBuffer; // bit (1 << color_id) set for every tracking color a pixel matches
+    cv::Mat colorMaskROI;
+    cv::Rect2i currentROI;
     OpenCVBGRToHSVMapper *bgr2hsv; // Used to convert an rgb image to an hsv image
+    bool bUseFusedColorClassifier; // Classify BGR pixels directly instead of converting to HSV first
+    bool bUseColorMembershipCubes; // Classify BGR pixels with a small quantized RGB cube per color
+    bool bUseRunLengthBlobExtractor; // Find blobs with blobExtractor instead of cv::findContours
+    bool bUseSharedSegmentation; // Segment the frame once for all tracked devices instead of once per device ROI
+    RunLengthBlobExtractor blobExtractor;
+    ColorMembershipCube colorCubes[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+
+    // Segmentation requests for the current video frame
+    std::vector<cv::Rect2i> segmentationROIs;
+    std::vector<eCommonTrackingColorID> segmentationColorIDs;
+    std::vector<OpenCVHSVColorBounds> segmentationColorBounds;
+
+    // Segmentation results for the current video frame
+    std::vector<cv::Rect2i> segmentedROIs; // ROIs of the requests that made it into the pass
+    std::vector<cv::Rect2i> segmentedRegions; // non-overlapping union of segmentedROIs
+    eCommonTrackingColorID segmentedColorIDs[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+    OpenCVHSVColorBounds segmentedColorBounds[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+    int segmentedColorCount;
 };
 
-// -- Utility Methods -----
-static glm::quat computeGLMCameraTransformQuaternion(const ITrackerInterface *tracker_device);
-static glm::mat4 computeGLMCameraTransformMatrix(const ITrackerInterface *tracker_device);
-static void computeOpenCVCameraExtrinsicMatrix(const ITrackerInterface *tracker_device,
-                                                      cv::Matx34f &extrinsicOut);
-cv::Mat cvDistCoeffs = cv::Mat(4, 1, cv::DataType<float>::type, 0.f);
-static void computeOpenCVCameraIntrinsicMatrix(const ITrackerInterface *tracker_device,
-                                               cv::Matx33f &intrinsicOut,
-                                               cv::Matx<float, 5, 1> &distortionOut);
-static cv::Matx34f computeOpenCVCameraPinholeMatrix(const ITrackerInterface *tracker_device);
-static bool computeTrackerRelativeLightBarProjection(
-    const CommonDeviceTrackingShape *tracking_shape,
-    const t_opencv_float_contour &opencv_contour,
-    CommonDeviceTrackingProjection *out_projection);
-static bool computeTrackerRelativeLightBarPose(
-    const ITrackerInterface *tracker_device,
-    const CommonDeviceTrackingShape *tracking_shape,
-    const CommonDeviceTrackingProjection *projection,
-    const CommonDevicePose *tracker_relative_pose_guess,
-    ControllerOpticalPoseEstimation *out_pose_estimate);
-static bool computeTrackerRelativePointCloudContourPose(
-    const ITrackerInterface *tracker_device,
-    const CommonDeviceTrackingShape *tracking_shape,
-    const t_opencv_float_contour_list &opencv_contours,
-    const CommonDevicePose *tracker_relative_pose_guess,
+class TrackerFrameProcessor : public WorkerThread
+{
+public:
+    TrackerFrameProcessor(ServerTrackerView *tracker_view)
+        : WorkerThread(std::string("TrackerFrameProcessor_") + std::to_string(tracker_view->getDeviceID()))
+        , m_trackerView(tracker_view)
+        , m_pendingVideoFrame()
+    {
+    }
+
+    void start()
+    {
+        if (!hasThreadStarted())
+        {
+            m_pendingVideoFrame.reset();
+
+            WorkerThread::startThread();
+        }
+    }
+
+    void stop()
+    {
+        WorkerThread::stopThread();
+    }
+
+    // Called on the main thread to see if the worker has taken the last posted frame yet
+    bool getHasPendingVideoFrame()
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+
+        return static_cast<bool>(m_pendingVideoFrame);
+    }
+
+    // Called on the main thread when the tracker has polled a new video frame
+    void postVideoFrame(const VideoFramePtr &video_frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_frameMutex);
+
+            // If the worker hasn't gotten to the previous frame of a live camera yet, it just gets replaced
+            // (and goes back to the driver's frame pool). Replays wait for the worker instead, see poll().
+            m_pendingVideoFrame= video_frame;
+        }
+
+        m_frameReadyCondition.notify_one();
+    }
+
+protected:
+    void onThreadHaltBegin() override
+    {
+        // Wake up the worker thread so that it sees the exit signal
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_frameReadyCondition.notify_one();
+    }
+
+    bool doWork() override
+    {
+        // Wait for the main thread to hand us a new video frame
+        VideoFramePtr video_frame;
+        {
+            std::unique_lock<std::mutex> lock(m_frameMutex);
+            m_frameReadyCondition.wait(lock, [this] { 
+                return m_pendingVideoFrame || m_exitSignaled.load(); 
+            });
+
+            if (!m_pendingVideoFrame)
+            {
+                return false;
+            }
+
+            video_frame.swap(m_pendingVideoFrame);
+        }
+
+        m_trackerView->m_opencv_buffer_state->setVideoFrame(
+            video_frame, m_trackerView->m_shared_memory_video_stream_count > 0);
+
+        ControllerManager *controller_manager= DeviceManager::getInstance()->m_controller_manager;
+        HMDManager *hmd_manager= DeviceManager::getInstance()->m_hmd_manager;
+
+        // Snapshot the state of every device being tracked
+        m_trackerView->beginFrameSegmentation();
+
+        for (int controller_id = 0; controller_id < controller_manager->getMaxDevices(); ++controller_id)
+        {
+            ControllerSnapshot &snapshot= m_controllerSnapshots[controller_id];
+
+            snapshot.bIsTrackable= 
+                controller_manager->getControllerViewPtr(controller_id)->getProjectionRequestForTracker(
+                    m_trackerView, &snapshot.request, &snapshot.prior_pose_estimate);
+            if (snapshot.bIsTrackable)
+            {
+                m_trackerView->addFrameSegmentationRequest(
+                    &snapshot.request,
+                    snapshot.prior_pose_estimate.bCurrentlyTracking ? &snapshot.prior_pose_estimate.projection : nullptr);
+            }
+        }
+
+        for (int hmd_id = 0; hmd_id < hmd_manager->getMaxDevices(); ++hmd_id)
+        {
+            HMDSnapshot &snapshot= m_hmdSnapshots[hmd_id];
+
+            snapshot.bIsTrackable= 
+                hmd_manager->getHMDViewPtr(hmd_id)->getProjectionRequestForTracker(
+                    m_trackerView, &snapshot.request, &snapshot.prior_pose_estimate);
+            if (snapshot.bIsTrackable)
+            {
+                m_trackerView->addFrameSegmentationRequest(
+                    &snapshot.request,
+                    snapshot.prior_pose_estimate.bCurrentlyTracking ? &snapshot.prior_pose_estimate.projection : nullptr);
+            }
+        }
+
+        // Classify the tracking colors for all of the devices in a single pass over the frame
+        m_trackerView->computeFrameSegmentation();
+
+        // Search the video frame for every device being tracked.
+        // Each device fuses the result with the other trackers and posts it to its filter.
+        for (int controller_id = 0; controller_id < controller_manager->getMaxDevices(); ++controller_id)
+        {
+            const ControllerSnapshot &snapshot= m_controllerSnapshots[controller_id];
+
+            if (snapshot.bIsTrackable)
+            {
+                controller_manager->getControllerViewPtr(controller_id)->notifyTrackerDataReceived(
+                    m_trackerView, &snapshot.request, &snapshot.prior_pose_estimate);
+            }
+        }
+
+        for (int hmd_id = 0; hmd_id < hmd_manager->getMaxDevices(); ++hmd_id)
+        {
+            const HMDSnapshot &snapshot= m_hmdSnapshots[hmd_id];
+
+            if (snapshot.bIsTrackable)
+            {
+                hmd_manager->getHMDViewPtr(hmd_id)->notifyTrackerDataReceived(
+                    m_trackerView, &snapshot.request, &snapshot.prior_pose_estimate);
+            }
+        }
+
+        // Have the main loop fuse and publish the new optical poses right away
+        MainLoopWakeSignal::notify();
+
+        // Copy the video frame (with debug overlay) to shared memory (if requested)
+        if (m_trackerView->m_shared_memory_accesor != nullptr && 
+            m_trackerView->m_opencv_buffer_state->getHasDebugOverlay())
+        {
+            m_trackerView->m_shared_memory_accesor->writeVideoFrame(
+                m_trackerView->m_opencv_buffer_state->bgrShmemBuffer->data);
+        }
+
+        return true;
+    }
+
+    // Main Thread State
+    ServerTrackerView *m_trackerView;
+
+    // Multithreaded state
+    std::mutex m_frameMutex;
+    std::condition_variable m_frameReadyCondition;
+    VideoFramePtr m_pendingVideoFrame;
+
+    // Worker Thread State
+    struct ControllerSnapshot
+    {
+        TrackedDeviceProjectionRequest request;
+        ControllerOpticalPoseEstimation prior_pose_estimate;
+        bool bIsTrackable;
+    };
+    struct HMDSnapshot
+    {
+        TrackedDeviceProjectionRequest request;
+        HMDOpticalPoseEstimation prior_pose_estimate;
+        bool bIsTrackable;
+    };
+    ControllerSnapshot m_controllerSnapshots[ControllerManager::k_max_devices];
+    HMDSnapshot m_hmdSnapshots[HMDManager::k_max_devices];
+};
+
+// -- Utility Methods -----
+static glm::quat computeGLMCameraTransformQuaternion(const CommonDevicePose &tracker_pose);
+static glm::mat4 computeGLMCameraTransformMatrix(const CommonDevicePose &tracker_pose);
+static void computeOpenCVCameraExtrinsicMatrix(const ITrackerInterface *tracker_device,
+                                                      cv::Matx34f &extrinsicOut);
+cv::Mat cvDistCoeffs = cv::Mat(4, 1, cv::DataType<float>::type, 0.f);
+static void computeOpenCVCameraIntrinsicMatrix(const ITrackerInterface *tracker_device,
+                                               cv::Matx33f &intrinsicOut,
+                                               cv::Matx<float, 5, 1> &distortionOut);
+static void computeOpenCVCameraIntrinsicMatrix(const ServerTrackerView *tracker,
+                                               cv::Matx33f &intrinsicOut,
+                                               cv::Matx<float, 5, 1> &distortionOut);
+static cv::Matx34f computeOpenCVCameraPinholeMatrix(const ITrackerInterface *tracker_device);
+static cv::Matx34f eigenProjectionMatrixToOpenCV(const Eigen::Matrix<float, 3, 4, Eigen::DontAlign> &projection_matrix);
+static bool computeTrackerRelativeLightBarProjection(
+    const CommonDeviceTrackingShape *tracking_shape,
+    const t_opencv_float_contour &opencv_contour,
+    CommonDeviceTrackingProjection *out_projection);
+static bool computeTrackerRelativeLightBarPose(
+    const ServerTrackerView *tracker,
+    const CommonDeviceTrackingShape *tracking_shape,
+    const CommonDeviceTrackingProjection *projection,
+    const CommonDevicePose *tracker_relative_pose_guess,
+    ControllerOpticalPoseEstimation *out_pose_estimate);
+static bool computeTrackerRelativePointCloudContourPose(
+    const ITrackerInterface *tracker_device,
+    const CommonDeviceTrackingShape *tracking_shape,
+    const t_opencv_float_contour_list &opencv_contours,
+    const CommonDevicePose *tracker_relative_pose_guess,
     HMDOpticalPoseEstimation *out_pose_estimate);
 static cv::Rect2i computeTrackerROIForPoseProjection(
     const bool disabled_roi,
     const ServerTrackerView *tracker,
-    const IPoseFilter* pose_filter,
+    const CommonDevicePosition *world_position_cm,
     const CommonDeviceTrackingProjection *prior_tracking_projection,
     const CommonDeviceTrackingShape *tracking_shape);
+static cv::Rect2i computeTrackerROIForProjectionRequest(
+    const ServerTrackerView *tracker,
+    const TrackedDeviceProjectionRequest *request,
+    const CommonDeviceTrackingProjection *prior_tracking_projection);
 static bool computeBestFitTriangleForContour(
     const t_opencv_float_contour &opencv_contour,
     cv::Point2f &out_triangle_top,
@@ -775,13 +1420,49 @@ ServerTrackerView::ServerTrackerView(const int device_id)
     , m_shared_memory_accesor(nullptr)
     , m_shared_memory_video_stream_count(0)
     , m_opencv_buffer_state(nullptr)
+    , m_frame_processor(nullptr)
     , m_device(nullptr)
 {
+    m_fusion_state.tracker_pose.clear();
+    m_fusion_state.projection_matrix.setZero();
+    m_fusion_state.camera_matrix.setIdentity();
+    m_fusion_state.distortion_coefficients.setZero();
+    m_fusion_state.last_new_data_timestamp= std::chrono::time_point<std::chrono::high_resolution_clock>();
+    m_fusion_state.frame_capture_time_us= 0;
+    m_fusion_state.frame_segmentation_done_time_us= 0;
+    m_fusion_state.bIsOpen= false;
+
+    for (SegmentedProjectionRequest &segmented_request : m_segmentedControllerRequests)
+    {
+        segmented_request.bIsValid= false;
+    }
+    for (SegmentedProjectionRequest &segmented_request : m_segmentedHMDRequests)
+    {
+        segmented_request.bIsValid= false;
+    }
+
+    for (PublishedColorPreset &published_preset : m_publishedControllerColorPresets)
+    {
+        published_preset.hsv_color_range.clear();
+        published_preset.color_id= eCommonTrackingColorID::INVALID_COLOR;
+    }
+    for (PublishedColorPreset &published_preset : m_publishedHMDColorPresets)
+    {
+        published_preset.hsv_color_range.clear();
+        published_preset.color_id= eCommonTrackingColorID::INVALID_COLOR;
+    }
+
     ServerUtility::format_string(m_shared_memory_name, sizeof(m_shared_memory_name), "tracker_view_%d", device_id);
 }
 
 ServerTrackerView::~ServerTrackerView()
 {
+    if (m_frame_processor != nullptr)
+    {
+        m_frame_processor->stop();
+        delete m_frame_processor;
+    }
+
     if (m_shared_memory_accesor != nullptr)
     {
         delete m_shared_memory_accesor;
@@ -796,105 +1477,489 @@ ServerTrackerView::~ServerTrackerView()
     {
         delete m_device;
     }
-}
+}
+
+CommonDeviceState::eDeviceType
+ServerTrackerView::getTrackerDeviceType() const
+{
+    return m_device->getDeviceType();
+}
+
+ITrackerInterface::eDriverType 
+ServerTrackerView::getTrackerDriverType() const
+{
+    return m_device->getDriverType();
+}
+
+std::string
+ServerTrackerView::getUSBDevicePath() const
+{
+    return m_device->getUSBDevicePath();
+}
+
+std::string 
+ServerTrackerView::getSharedMemoryStreamName() const
+{
+    return std::string(m_shared_memory_name);
+}
+
+bool ServerTrackerView::open(const class DeviceEnumerator *enumerator)
+{
+    bool bSuccess = ServerDeviceView::open(enumerator);
+
+    if (bSuccess)
+    {
+        reallocate_video_buffers();
+        publish_camera_matrices();
+        publish_tracker_pose();
+
+        std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+        m_fusion_state.bIsOpen= true;
+    }
+
+    return bSuccess;
+}
+
+void ServerTrackerView::close()
+{
+    // Other trackers' threads stop fusing with this tracker before it goes away
+    {
+        std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+        m_fusion_state.bIsOpen= false;
+    }
+
+    // Stop processing video frames before freeing the buffers the processor uses
+    if (m_frame_processor != nullptr)
+    {
+        m_frame_processor->stop();
+        delete m_frame_processor;
+        m_frame_processor = nullptr;
+    }
+
+    if (m_shared_memory_accesor != nullptr)
+    {
+        delete m_shared_memory_accesor;
+        m_shared_memory_accesor = nullptr;
+    }
+
+    if (m_opencv_buffer_state != nullptr)
+    {
+        delete m_opencv_buffer_state;
+        m_opencv_buffer_state = nullptr;
+    }
+
+    ServerDeviceView::close();
+}
+
+void ServerTrackerView::reallocate_video_buffers()
+{
+    // The frame processor can't be running while we swap out the buffers it uses
+    if (m_frame_processor != nullptr)
+    {
+        m_frame_processor->stop();
+        delete m_frame_processor;
+        m_frame_processor = nullptr;
+    }
+
+    // close buffer
+    if (m_shared_memory_accesor != nullptr)
+    {
+        delete m_shared_memory_accesor;
+        m_shared_memory_accesor = nullptr;
+    }
+
+    if (m_opencv_buffer_state != nullptr)
+    {
+        delete m_opencv_buffer_state;
+        m_opencv_buffer_state = nullptr;
+    }
+
+    int width, height, stride;
+
+    // Make sure the shared memory block has been removed first
+    boost::interprocess::shared_memory_object::remove(m_shared_memory_name);
+
+    // Query the video frame first so that we know how big to make the buffer
+    if (m_device->getVideoFrameDimensions(&width, &height, &stride))
+    {
+        m_shared_memory_accesor = new SharedVideoFrameReadWriteAccessor();
+
+        if (!m_shared_memory_accesor->initialize(m_shared_memory_name, width, height, stride))
+        {
+            delete m_shared_memory_accesor;
+            m_shared_memory_accesor = nullptr;
+
+            SERVER_LOG_ERROR("ServerTrackerView::reallocate_video_buffers()") << "Failed to allocated shared memory: " << m_shared_memory_name;
+        }
+
+        // Allocate the OpenCV scratch buffers used for finding tracking blobs
+        m_opencv_buffer_state = new OpenCVBufferState(m_device);
+
+        // Process new video frames on their own thread if requested
+        if (DeviceManager::getInstance()->m_tracker_manager->getConfig().use_tracker_processing_threads)
+        {
+            m_frame_processor = new TrackerFrameProcessor(this);
+            m_frame_processor->start();
+        }
+    }
+    else
+    {
+        SERVER_LOG_ERROR("ServerTrackerView::reallocate_video_buffers()") << "Failed to video frame dimensions";
+    }
+}
+
+void ServerTrackerView::publish_camera_matrices()
+{
+    const cv::Matx34f pinhole_matrix= computeOpenCVCameraPinholeMatrix(m_device);
+    Eigen::Matrix<float, 3, 4, Eigen::DontAlign> projection_matrix;
+
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 4; ++col)
+        {
+            projection_matrix(row, col)= pinhole_matrix(row, col);
+        }
+    }
+
+    cv::Matx33f intrinsic_matrix;
+    cv::Matx<float, 5, 1> distortion;
+    computeOpenCVCameraIntrinsicMatrix(m_device, intrinsic_matrix, distortion);
+    Eigen::Matrix<float, 3, 3, Eigen::DontAlign> camera_matrix;
+    Eigen::Matrix<float, 5, 1, Eigen::DontAlign> distortion_coefficients;
+
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 3; ++col)
+        {
+            camera_matrix(row, col)= intrinsic_matrix(row, col);
+        }
+    }
+
+    for (int index = 0; index < 5; ++index)
+    {
+        distortion_coefficients(index)= distortion(index, 0);
+    }
+
+    // Tracker frame processing threads triangulate and undistort with these matrices
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    m_fusion_state.projection_matrix= projection_matrix;
+    m_fusion_state.camera_matrix= camera_matrix;
+    m_fusion_state.distortion_coefficients= distortion_coefficients;
+}
+
+void ServerTrackerView::publish_tracking_color_presets()
+{
+    ControllerManager *controller_manager= DeviceManager::getInstance()->m_controller_manager;
+    HMDManager *hmd_manager= DeviceManager::getInstance()->m_hmd_manager;
+    PublishedColorPreset controller_presets[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    PublishedColorPreset hmd_presets[PSMOVESERVICE_MAX_HMD_COUNT];
+
+    // Look the presets up outside of the lock, they live in the tracker config
+    for (int controller_id = 0; controller_id < controller_manager->getMaxDevices(); ++controller_id)
+    {
+        ServerControllerViewPtr controller_view= controller_manager->getControllerViewPtr(controller_id);
+        PublishedColorPreset &preset= controller_presets[controller_id];
+
+        preset.color_id= 
+            controller_view->getIsOpen() ? controller_view->getTrackingColorID() : eCommonTrackingColorID::INVALID_COLOR;
+        if (preset.color_id != eCommonTrackingColorID::INVALID_COLOR)
+        {
+            getControllerTrackingColorPreset(controller_view.get(), preset.color_id, &preset.hsv_color_range);
+        }
+        else
+        {
+            preset.hsv_color_range.clear();
+        }
+    }
+
+    for (int hmd_id = 0; hmd_id < hmd_manager->getMaxDevices(); ++hmd_id)
+    {
+        ServerHMDViewPtr hmd_view= hmd_manager->getHMDViewPtr(hmd_id);
+        PublishedColorPreset &preset= hmd_presets[hmd_id];
+
+        preset.color_id= 
+            hmd_view->getIsOpen() ? hmd_view->getTrackingColorID() : eCommonTrackingColorID::INVALID_COLOR;
+        if (preset.color_id != eCommonTrackingColorID::INVALID_COLOR)
+        {
+            getHMDTrackingColorPreset(hmd_view.get(), preset.color_id, &preset.hsv_color_range);
+        }
+        else
+        {
+            preset.hsv_color_range.clear();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    std::copy(std::begin(controller_presets), std::end(controller_presets), std::begin(m_publishedControllerColorPresets));
+    std::copy(std::begin(hmd_presets), std::end(hmd_presets), std::begin(m_publishedHMDColorPresets));
+}
+
+void ServerTrackerView::publish_tracker_pose()
+{
+    const CommonDevicePose tracker_pose= m_device->getTrackerPose();
+
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    m_fusion_state.tracker_pose= tracker_pose;
+}
+
+void ServerTrackerView::startSharedMemoryVideoStream()
+{
+    ++m_shared_memory_video_stream_count;
+}
+
+void ServerTrackerView::stopSharedMemoryVideoStream()
+{
+    assert(m_shared_memory_video_stream_count > 0);
+    --m_shared_memory_video_stream_count;
+}
+
+bool ServerTrackerView::getIsFrameProcessingThreaded() const
+{
+    return m_frame_processor != nullptr;
+}
+
+void ServerTrackerView::beginFrameSegmentation()
+{
+    m_opencv_buffer_state->clearSegmentation();
+}
+
+void ServerTrackerView::addFrameSegmentationRequest(
+    const TrackedDeviceProjectionRequest *request,
+    const CommonDeviceTrackingProjection *prior_projection)
+{
+    if (m_opencv_buffer_state->bUseSharedSegmentation &&
+        request->tracking_color_id != eCommonTrackingColorID::INVALID_COLOR)
+    {
+        const cv::Rect2i ROI= computeTrackerROIForProjectionRequest(this, request, prior_projection);
+
+        m_opencv_buffer_state->addSegmentationRequest(ROI, request->tracking_color_id, request->hsv_color_range);
+    }
+}
+
+void ServerTrackerView::computeFrameSegmentation()
+{
+    m_opencv_buffer_state->computeSegmentation();
+
+    const int64_t capture_time_us= 
+        m_opencv_buffer_state->videoFrame ? m_opencv_buffer_state->videoFrame->getCaptureTimeUs() : 0;
+    const int64_t segmentation_done_time_us= PipelineLatencyStats::getTimestampUs();
+    PipelineLatencyStats::recordStageLatency(
+        PipelineLatencyStage_FrameCaptureToSegmentation, capture_time_us, segmentation_done_time_us);
+
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    m_fusion_state.frame_capture_time_us= capture_time_us;
+    m_fusion_state.frame_segmentation_done_time_us= segmentation_done_time_us;
+}
+
+int64_t ServerTrackerView::getFrameCaptureTimeUs() const
+{
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    return m_fusion_state.frame_capture_time_us;
+}
+
+int64_t ServerTrackerView::getFrameSegmentationDoneTimeUs() const
+{
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    return m_fusion_state.frame_segmentation_done_time_us;
+}
+
+void ServerTrackerView::getFusionState(TrackerFusionState *out_state) const
+{
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    *out_state= m_fusion_state;
+}
+
+bool ServerTrackerView::getPublishedControllerTrackingColorPreset(
+    int controller_id,
+    eCommonTrackingColorID color,
+    CommonHSVColorRange *out_preset) const
+{
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    const PublishedColorPreset &published_preset= m_publishedControllerColorPresets[controller_id];
+
+    if (published_preset.color_id != color)
+    {
+        return false;
+    }
+
+    *out_preset= published_preset.hsv_color_range;
+    return true;
+}
+
+bool ServerTrackerView::getPublishedHMDTrackingColorPreset(
+    int hmd_id,
+    eCommonTrackingColorID color,
+    CommonHSVColorRange *out_preset) const
+{
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    const PublishedColorPreset &published_preset= m_publishedHMDColorPresets[hmd_id];
+
+    if (published_preset.color_id != color)
+    {
+        return false;
+    }
 
-CommonDeviceState::eDeviceType
-ServerTrackerView::getTrackerDeviceType() const
-{
-    return m_device->getDeviceType();
+    *out_preset= published_preset.hsv_color_range;
+    return true;
 }
 
-ITrackerInterface::eDriverType 
-ServerTrackerView::getTrackerDriverType() const
+void ServerTrackerView::getCameraIntrinsicMatrix(
+    Eigen::Matrix<float, 3, 3, Eigen::DontAlign> *out_camera_matrix,
+    Eigen::Matrix<float, 5, 1, Eigen::DontAlign> *out_distortion_coefficients) const
 {
-    return m_device->getDriverType();
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    *out_camera_matrix= m_fusion_state.camera_matrix;
+    *out_distortion_coefficients= m_fusion_state.distortion_coefficients;
 }
 
-std::string
-ServerTrackerView::getUSBDevicePath() const
+Eigen::Matrix<float, 3, 4, Eigen::DontAlign> ServerTrackerView::getProjectionMatrix() const
 {
-    return m_device->getUSBDevicePath();
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    return m_fusion_state.projection_matrix;
 }
 
-std::string 
-ServerTrackerView::getSharedMemoryStreamName() const
+void ServerTrackerView::segment_video_frame_for_tracked_devices()
 {
-    return std::string(m_shared_memory_name);
-}
+    ControllerManager *controller_manager= DeviceManager::getInstance()->m_controller_manager;
+    HMDManager *hmd_manager= DeviceManager::getInstance()->m_hmd_manager;
 
-bool ServerTrackerView::open(const class DeviceEnumerator *enumerator)
-{
-    bool bSuccess = ServerDeviceView::open(enumerator);
+    beginFrameSegmentation();
 
-    if (bSuccess)
+    // Without the shared pass every device segments its own ROI when it searches the frame,
+    // using a request built at that point like it always has
+    if (!m_opencv_buffer_state->bUseSharedSegmentation)
+    {
+        for (SegmentedProjectionRequest &segmented_request : m_segmentedControllerRequests)
+        {
+            segmented_request.bIsValid= false;
+        }
+        for (SegmentedProjectionRequest &segmented_request : m_segmentedHMDRequests)
+        {
+            segmented_request.bIsValid= false;
+        }
+
+        // Still time stamps the frame
+        computeFrameSegmentation();
+        return;
+    }
+
+    // Keep the requests around so that the device views search the frame with the same ROIs
+    for (int controller_id = 0; controller_id < controller_manager->getMaxDevices(); ++controller_id)
     {
-        int width, height, stride;
+        SegmentedProjectionRequest &segmented_request= m_segmentedControllerRequests[controller_id];
+        ControllerOpticalPoseEstimation prior_pose_estimate;
 
-        // Make sure the shared memory block has been removed first
-        boost::interprocess::shared_memory_object::remove(m_shared_memory_name);
+        segmented_request.bIsValid= 
+            controller_manager->getControllerViewPtr(controller_id)->getProjectionRequestForTracker(
+                this, &segmented_request.request, &prior_pose_estimate);
 
-        // Query the video frame first so that we know how big to make the buffer
-        if (m_device->getVideoFrameDimensions(&width, &height, &stride))
+        if (segmented_request.bIsValid)
         {
-            assert(m_shared_memory_accesor == nullptr);
-            m_shared_memory_accesor = new SharedVideoFrameReadWriteAccessor();
+            addFrameSegmentationRequest(
+                &segmented_request.request, 
+                prior_pose_estimate.bCurrentlyTracking ? &prior_pose_estimate.projection : nullptr);
+        }
+    }
 
-            if (!m_shared_memory_accesor->initialize(m_shared_memory_name, width, height, stride))
-            {
-                delete m_shared_memory_accesor;
-                m_shared_memory_accesor = nullptr;
+    for (int hmd_id = 0; hmd_id < hmd_manager->getMaxDevices(); ++hmd_id)
+    {
+        SegmentedProjectionRequest &segmented_request= m_segmentedHMDRequests[hmd_id];
+        HMDOpticalPoseEstimation prior_pose_estimate;
 
-                SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to allocated shared memory: " << m_shared_memory_name;
-            }
+        segmented_request.bIsValid= 
+            hmd_manager->getHMDViewPtr(hmd_id)->getProjectionRequestForTracker(
+                this, &segmented_request.request, &prior_pose_estimate);
 
-            // Allocate the OpenCV scratch buffers used for finding tracking blobs
-            m_opencv_buffer_state = new OpenCVBufferState(m_device);
-        }
-        else
+        if (segmented_request.bIsValid)
         {
-            SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to video frame dimensions";
+            addFrameSegmentationRequest(
+                &segmented_request.request, 
+                prior_pose_estimate.bCurrentlyTracking ? &prior_pose_estimate.projection : nullptr);
         }
     }
 
-    return bSuccess;
+    computeFrameSegmentation();
 }
 
-void ServerTrackerView::close()
+bool ServerTrackerView::getSegmentedProjectionRequestForController(
+    int controller_id, 
+    TrackedDeviceProjectionRequest *out_request) const
 {
-    if (m_shared_memory_accesor != nullptr)
+    const SegmentedProjectionRequest &segmented_request= m_segmentedControllerRequests[controller_id];
+
+    if (segmented_request.bIsValid)
     {
-        delete m_shared_memory_accesor;
-        m_shared_memory_accesor = nullptr;
+        *out_request= segmented_request.request;
     }
 
-    ServerDeviceView::close();
+    return segmented_request.bIsValid;
 }
 
-void ServerTrackerView::startSharedMemoryVideoStream()
+bool ServerTrackerView::getSegmentedProjectionRequestForHMD(
+    int hmd_id, 
+    TrackedDeviceProjectionRequest *out_request) const
 {
-    ++m_shared_memory_video_stream_count;
-}
+    const SegmentedProjectionRequest &segmented_request= m_segmentedHMDRequests[hmd_id];
 
-void ServerTrackerView::stopSharedMemoryVideoStream()
-{
-    assert(m_shared_memory_video_stream_count > 0);
-    --m_shared_memory_video_stream_count;
+    if (segmented_request.bIsValid)
+    {
+        *out_request= segmented_request.request;
+    }
+
+    return segmented_request.bIsValid;
 }
 
 bool ServerTrackerView::poll()
 {
+    // A replay never skips frames, so hold off on reading the next one until the frame processor
+    // has taken the last one. It wakes the main loop when it's done with the frame.
+    if (m_frame_processor != nullptr &&
+        m_device != nullptr &&
+        m_device->getDeviceType() == CommonDeviceState::ReplayTracker &&
+        m_frame_processor->getHasPendingVideoFrame())
+    {
+        return true;
+    }
+
     bool bSuccess = ServerDeviceView::poll();
 
+    // Let the threads fusing device poses see when this tracker last got a new frame
+    {
+        std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+        m_fusion_state.last_new_data_timestamp= getLastNewDataTimestamp();
+        m_fusion_state.bIsOpen= getIsOpen();
+    }
+
     if (bSuccess && m_device != nullptr)
     {
-        const unsigned char *buffer = m_device->getVideoFrameBuffer();
+        VideoFramePtr video_frame = m_device->getVideoFrame();
 
-        if (buffer != nullptr)
+        if (video_frame)
         {
-            // Cache the raw video frame
-            if (m_opencv_buffer_state != nullptr)
+            // The device views build their projection requests from these
+            if (getHasUnpublishedState())
+            {
+                publish_tracking_color_presets();
+            }
+
+            if (m_frame_processor != nullptr)
+            {
+                // Hand new video frames off to the frame processing thread
+                if (getHasUnpublishedState())
+                {
+                    m_frame_processor->postVideoFrame(video_frame);
+                }
+            }
+            else if (m_opencv_buffer_state != nullptr)
             {
-                m_opencv_buffer_state->writeVideoFrame(buffer);
+                // Track the raw video frame in place
+                m_opencv_buffer_state->setVideoFrame(video_frame, m_shared_memory_video_stream_count > 0);
+
+                // Classify the tracking colors for all of the tracked devices in one pass
+                if (getHasUnpublishedState())
+                {
+                    segment_video_frame_for_tracked_devices();
+                }
             }
         }
     }
@@ -910,6 +1975,10 @@ bool ServerTrackerView::allocate_device_interface(const class DeviceEnumerator *
     {
         m_device = new PS3EyeTracker();
     } break;
+    case CommonDeviceState::ReplayTracker:
+    {
+        m_device = new ReplayTracker();
+    } break;
     default:
         break;
     }
@@ -931,8 +2000,10 @@ void ServerTrackerView::free_device_interface()
 
 void ServerTrackerView::publish_device_data_frame()
 {
-    // Copy the video frame to shared memory (if requested)
-    if (m_shared_memory_accesor != nullptr && m_shared_memory_video_stream_count > 0)
+    // Copy the video frame to shared memory (if requested).
+    // The frame processing thread does this itself when it finishes with a frame.
+    if (m_frame_processor == nullptr &&
+        m_shared_memory_accesor != nullptr && m_opencv_buffer_state->getHasDebugOverlay())
     {
         m_shared_memory_accesor->writeVideoFrame(m_opencv_buffer_state->bgrShmemBuffer->data);
     }
@@ -961,6 +2032,9 @@ void ServerTrackerView::generate_tracker_data_frame_for_stream(
         {
             //TODO: PS3EYE tracker location
         } break;
+    case CommonDeviceState::ReplayTracker:
+        {
+        } break;
     default:
         assert(0 && "Unhandled Tracker type");
     }
@@ -971,6 +2045,8 @@ void ServerTrackerView::generate_tracker_data_frame_for_stream(
 void ServerTrackerView::loadSettings()
 {
     m_device->loadSettings();
+    publish_camera_matrices();
+    publish_tracker_pose();
 }
 
 void ServerTrackerView::saveSettings()
@@ -987,43 +2063,11 @@ void ServerTrackerView::setFrameWidth(double value, bool bUpdateConfig)
 {
     if (value == m_device->getFrameWidth()) return;
 
-    // close buffer
-    if (m_shared_memory_accesor != nullptr)
-    {
-        delete m_shared_memory_accesor;
-        m_shared_memory_accesor = nullptr;
-    }
-
     // change frame width
     m_device->setFrameWidth(value, bUpdateConfig);
 
-    // reopen buffer
-    int width, height, stride;
-
-    // Make sure the shared memory block has been removed first
-    boost::interprocess::shared_memory_object::remove(m_shared_memory_name);
-
-    // Query the video frame first so that we know how big to make the buffer
-    if (m_device->getVideoFrameDimensions(&width, &height, &stride))
-    {
-        assert(m_shared_memory_accesor == nullptr);
-        m_shared_memory_accesor = new SharedVideoFrameReadWriteAccessor();
-
-        if (!m_shared_memory_accesor->initialize(m_shared_memory_name, width, height, stride))
-        {
-            delete m_shared_memory_accesor;
-            m_shared_memory_accesor = nullptr;
-
-            SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to allocated shared memory: " << m_shared_memory_name;
-        }
-
-        // Allocate the OpenCV scratch buffers used for finding tracking blobs
-        m_opencv_buffer_state = new OpenCVBufferState(m_device);
-    }
-    else
-    {
-        SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to video frame dimensions";
-    }
+    // reopen buffers at the new frame size
+    reallocate_video_buffers();
 }
 
 double ServerTrackerView::getFrameHeight() const
@@ -1035,43 +2079,11 @@ void ServerTrackerView::setFrameHeight(double value, bool bUpdateConfig)
 {
     if (value == m_device->getFrameHeight()) return;
 
-    // close buffer
-    if (m_shared_memory_accesor != nullptr)
-    {
-        delete m_shared_memory_accesor;
-        m_shared_memory_accesor = nullptr;
-    }
-
     // change frame height
     m_device->setFrameHeight(value, bUpdateConfig);
 
-    // reopen buffer
-    int width, height, stride;
-
-    // Make sure the shared memory block has been removed first
-    boost::interprocess::shared_memory_object::remove(m_shared_memory_name);
-
-    // Query the video frame first so that we know how big to make the buffer
-    if (m_device->getVideoFrameDimensions(&width, &height, &stride))
-    {
-        assert(m_shared_memory_accesor == nullptr);
-        m_shared_memory_accesor = new SharedVideoFrameReadWriteAccessor();
-
-        if (!m_shared_memory_accesor->initialize(m_shared_memory_name, width, height, stride))
-        {
-            delete m_shared_memory_accesor;
-            m_shared_memory_accesor = nullptr;
-
-            SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to allocated shared memory: " << m_shared_memory_name;
-        }
-
-        // Allocate the OpenCV scratch buffers used for finding tracking blobs
-        m_opencv_buffer_state = new OpenCVBufferState(m_device);
-    }
-    else
-    {
-        SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to video frame dimensions";
-    }
+    // reopen buffers at the new frame size
+    reallocate_video_buffers();
 }
 
 double ServerTrackerView::getFrameRate() const
@@ -1128,17 +2140,21 @@ void ServerTrackerView::setCameraIntrinsics(
         principalX, principalY,
         distortionK1, distortionK2, distortionK3,
         distortionP1, distortionP2);
+    publish_camera_matrices();
 }
 
 CommonDevicePose ServerTrackerView::getTrackerPose() const
 {
-    return m_device->getTrackerPose();
+    std::lock_guard<std::mutex> lock(m_fusion_state_mutex);
+    return m_fusion_state.tracker_pose;
 }
 
 void ServerTrackerView::setTrackerPose(
     const struct CommonDevicePose *pose)
 {
     m_device->setTrackerPose(pose);
+    publish_camera_matrices();
+    publish_tracker_pose();
 }
 
 void ServerTrackerView::getPixelDimensions(float &outWidth, float &outHeight) const
@@ -1236,42 +2252,30 @@ void ServerTrackerView::getHMDTrackingColorPreset(
 
 bool
 ServerTrackerView::computeProjectionForController(
-    const ServerControllerView* tracked_controller,
-    const CommonDeviceTrackingShape *tracking_shape,
+    const TrackedDeviceProjectionRequest *request,
     ControllerOpticalPoseEstimation *out_pose_estimate)
 {
-    bool bSuccess = true;
+    // The ROI and the contour search share the tracker's OpenCV buffers
+    std::lock_guard<std::mutex> lock(m_projection_mutex);
 
-    // Get the HSV filter used to find the tracking blob
-    CommonHSVColorRange hsvColorRange;
-    if (bSuccess)
-    {
-        eCommonTrackingColorID tracked_color_id = tracked_controller->getTrackingColorID();
+    const CommonDeviceTrackingShape *tracking_shape= &request->tracking_shape;
+    bool bSuccess = request->tracking_color_id != eCommonTrackingColorID::INVALID_COLOR;
 
-        if (tracked_color_id != eCommonTrackingColorID::INVALID_COLOR)
-        {
-            getControllerTrackingColorPreset(tracked_controller, tracked_color_id, &hsvColorRange);
-        }
-        else
-        {
-            bSuccess = false;
-        }
-    }
+    // Get the HSV filter used to find the tracking blob
+    const CommonHSVColorRange &hsvColorRange= request->hsv_color_range;
 
     // Compute a region of interest in the tracker buffer around where we expect to find the tracking shape
     const TrackerManagerConfig &trackerMgrConfig= DeviceManager::getInstance()->m_tracker_manager->getConfig();
-    const bool bRoiDisabled = tracked_controller->getIsROIDisabled() || trackerMgrConfig.disable_roi;
+    const bool bRoiDisabled = request->bIsROIDisabled || trackerMgrConfig.disable_roi;
 
-    const ControllerOpticalPoseEstimation *priorPoseEst= 
-        tracked_controller->getTrackerPoseEstimate(this->getDeviceID());
-    const bool bIsTracking = priorPoseEst->bCurrentlyTracking;
+    // The incoming pose estimate is the prior pose estimate for this tracker
+    const CommonDeviceTrackingProjection priorProjection= out_pose_estimate->projection;
+    const bool bIsTracking = out_pose_estimate->bCurrentlyTracking;
 
-    cv::Rect2i ROI= computeTrackerROIForPoseProjection(
-        bRoiDisabled,
-        this,		
-        bIsTracking ? tracked_controller->getPoseFilter() : nullptr,
-        bIsTracking ? &priorPoseEst->projection : nullptr,
-        tracking_shape);
+    cv::Rect2i ROI= computeTrackerROIForProjectionRequest(
+        this,
+        request,
+        bIsTracking ? &priorProjection : nullptr);
 
     m_opencv_buffer_state->applyROI(ROI);
 
@@ -1280,7 +2284,8 @@ ServerTrackerView::computeProjectionForController(
     std::vector<double> contour_areas;
     if (bSuccess)
     {
-        bSuccess = m_opencv_buffer_state->computeBiggestNContours(hsvColorRange, biggest_contours, contour_areas, 1);
+        bSuccess = m_opencv_buffer_state->computeBiggestNContours(
+            request->tracking_color_id, hsvColorRange, biggest_contours, contour_areas, 1);
     }
     
     // Process the contour for its 2D and 3D pose.
@@ -1290,7 +2295,7 @@ ServerTrackerView::computeProjectionForController(
         // Needed for undistortion.
         cv::Matx33f camera_matrix;
         cv::Matx<float, 5, 1> distortions;
-        computeOpenCVCameraIntrinsicMatrix(m_device, camera_matrix, distortions);
+        computeOpenCVCameraIntrinsicMatrix(this, camera_matrix, distortions);
                 
         // Compute the tracker relative 3d position of the controller from the contour
         switch (tracking_shape->shape_type)
@@ -1419,42 +2424,28 @@ ServerTrackerView::computeProjectionForController(
 }
 
 bool ServerTrackerView::computeProjectionForHMD(
-    const class ServerHMDView* tracked_hmd,
-    const struct CommonDeviceTrackingShape *tracking_shape,
+    const struct TrackedDeviceProjectionRequest *request,
     struct HMDOpticalPoseEstimation *out_pose_estimate)
 {
-    bool bSuccess = true;
+    // The ROI and the contour search share the tracker's OpenCV buffers
+    std::lock_guard<std::mutex> lock(m_projection_mutex);
+
+    const CommonDeviceTrackingShape *tracking_shape= &request->tracking_shape;
+    bool bSuccess = request->tracking_color_id != eCommonTrackingColorID::INVALID_COLOR;
 
     // Get the HSV filter used to find the tracking blob
-    CommonHSVColorRange hsvColorRange;
-    if (bSuccess)
-    {
-        eCommonTrackingColorID tracked_color_id = tracked_hmd->getTrackingColorID();
+    const CommonHSVColorRange &hsvColorRange= request->hsv_color_range;
 
-        if (tracked_color_id != eCommonTrackingColorID::INVALID_COLOR)
-        {
-            getHMDTrackingColorPreset(tracked_hmd, tracked_color_id, &hsvColorRange);
-        }
-        else
-        {
-            bSuccess = false;
-        }
-    }
+    // The incoming pose estimate is the prior pose estimate for this tracker
+    const CommonDeviceTrackingProjection priorProjection= out_pose_estimate->projection;
+    const CommonDevicePose priorTrackerPose= {out_pose_estimate->position_cm, out_pose_estimate->orientation};
+    const bool bIsTracking = out_pose_estimate->bCurrentlyTracking;
     
     // Compute a region of interest in the tracker buffer around where we expect to find the tracking shape
-    const TrackerManagerConfig &trackerMgrConfig= DeviceManager::getInstance()->m_tracker_manager->getConfig();
-    const bool bRoiDisabled = tracked_hmd->getIsROIDisabled() || trackerMgrConfig.disable_roi;
-
-    const HMDOpticalPoseEstimation *priorPoseEst= 
-        tracked_hmd->getTrackerPoseEstimate(this->getDeviceID());
-    const bool bIsTracking = priorPoseEst->bCurrentlyTracking;
-
-    cv::Rect2i ROI = computeTrackerROIForPoseProjection(
-        bRoiDisabled,
-        this, 
-        bIsTracking ? tracked_hmd->getPoseFilter() : nullptr,
-        bIsTracking ? &priorPoseEst->projection : nullptr,
-        tracking_shape);
+    cv::Rect2i ROI = computeTrackerROIForProjectionRequest(
+        this,
+        request,
+        bIsTracking ? &priorProjection : nullptr);
     m_opencv_buffer_state->applyROI(ROI);
 
     // Find the N best contours associated with the HMD
@@ -1464,7 +2455,8 @@ bool ServerTrackerView::computeProjectionForHMD(
     {
         bSuccess = 
             m_opencv_buffer_state->computeBiggestNContours(
-                hsvColorRange, biggest_contours, contour_areas, CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT);
+                request->tracking_color_id, hsvColorRange, biggest_contours, contour_areas, 
+                CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT);
     }
 
     // Compute the tracker relative 3d position of the controller from the contour
@@ -1472,7 +2464,7 @@ bool ServerTrackerView::computeProjectionForHMD(
     {
         cv::Matx33f camera_matrix;
         cv::Matx<float, 5, 1> distortions;
-        computeOpenCVCameraIntrinsicMatrix(m_device, camera_matrix, distortions);
+        computeOpenCVCameraIntrinsicMatrix(this, camera_matrix, distortions);
 
         switch (tracking_shape->shape_type)
         {
@@ -1550,9 +2542,6 @@ bool ServerTrackerView::computeProjectionForHMD(
             } break;
         case eCommonTrackingShapeType::PointCloud:
             {
-                const HMDOpticalPoseEstimation *prior_post_est= tracked_hmd->getTrackerPoseEstimate(getDeviceID());
-                CommonDevicePose tracker_pose_guess= {prior_post_est->position_cm, prior_post_est->orientation};
-
                 // Undistort the source contours
                 t_opencv_float_contour_list undistorted_contours;
                 for (auto it = biggest_contours.begin(); it != biggest_contours.end(); ++it)
@@ -1580,7 +2569,7 @@ bool ServerTrackerView::computeProjectionForHMD(
                         m_device,
                         tracking_shape,
                         undistorted_contours,
-                        prior_post_est->bCurrentlyTracking ? &tracker_pose_guess : nullptr,
+                        bIsTracking ? &priorTrackerPose : nullptr,
                         out_pose_estimate);
 
                 //Draw results onto m_opencv_buffer_state
@@ -1615,7 +2604,7 @@ ServerTrackerView::computePoseForProjection(
         {
             bSuccess =
                 computeTrackerRelativeLightBarPose(
-                    m_device,
+                    this,
                     tracking_shape,
                     projection,
                     pose_guess,
@@ -1633,7 +2622,7 @@ ServerTrackerView::computeWorldPosition(
     const CommonDevicePosition *tracker_relative_position) const
 {
     const glm::vec4 rel_pos(tracker_relative_position->x, tracker_relative_position->y, tracker_relative_position->z, 1.f);
-    const glm::mat4 cameraTransform= computeGLMCameraTransformMatrix(m_device);
+    const glm::mat4 cameraTransform= computeGLMCameraTransformMatrix(getTrackerPose());
     const glm::vec4 world_pos = cameraTransform * rel_pos;
     
     CommonDevicePosition result;
@@ -1656,7 +2645,7 @@ ServerTrackerView::computeWorldOrientation(
         tracker_relative_orientation->x,
         tracker_relative_orientation->y,
         tracker_relative_orientation->z);    
-    const glm::quat camera_quat= computeGLMCameraTransformQuaternion(m_device);
+    const glm::quat camera_quat= computeGLMCameraTransformQuaternion(getTrackerPose());
     const glm::quat world_quat = global_forward_quat * camera_quat * rel_orientation;
     
     CommonDeviceQuaternion result;
@@ -1673,7 +2662,7 @@ ServerTrackerView::computeTrackerPosition(
     const CommonDevicePosition *world_relative_position) const
 {
     const glm::vec4 world_pos(world_relative_position->x, world_relative_position->y, world_relative_position->z, 1.f);
-    const glm::mat4 invCameraTransform= glm::inverse(computeGLMCameraTransformMatrix(m_device));
+    const glm::mat4 invCameraTransform= glm::inverse(computeGLMCameraTransformMatrix(getTrackerPose()));
     const glm::vec4 rel_pos = invCameraTransform * world_pos;
     
     CommonDevicePosition result;
@@ -1691,7 +2680,7 @@ ServerTrackerView::computeTrackerOrientation(
         world_relative_orientation->x,
         world_relative_orientation->y,
         world_relative_orientation->z);    
-    const glm::quat camera_inv_quat= glm::conjugate(computeGLMCameraTransformQuaternion(m_device));
+    const glm::quat camera_inv_quat= glm::conjugate(computeGLMCameraTransformQuaternion(getTrackerPose()));
     // combined_rotation = second_rotation * first_rotation;
     const glm::quat rel_quat = camera_inv_quat * world_orientation;
     
@@ -1845,6 +2834,107 @@ ServerTrackerView::triangulateWorldPose(
     return pose;
 }
 
+bool
+ServerTrackerView::triangulateWorldPositionFromMultipleTrackers(
+    const ServerTrackerView * const *trackers,
+    const CommonDeviceScreenLocation *screen_locations,
+    const float *screen_location_weights,
+    const int tracker_count,
+    CommonDevicePosition *out_result)
+{
+    Eigen::Matrix<float, 3, 4> projection_matrices[TrackerManager::k_max_devices];
+    Eigen::Vector2f eigen_screen_locations[TrackerManager::k_max_devices];
+    const int view_count= std::min(tracker_count, static_cast<int>(TrackerManager::k_max_devices));
+
+    for (int view_index = 0; view_index < view_count; ++view_index)
+    {
+        projection_matrices[view_index]= trackers[view_index]->getProjectionMatrix();
+        eigen_screen_locations[view_index]= 
+            Eigen::Vector2f(screen_locations[view_index].x, screen_locations[view_index].y);
+    }
+
+    // Solve for the point all of the views agree on best in one go,
+    // rather than triangulating every pair of trackers and averaging
+    const int refinement_iterations= 
+        DeviceManager::getInstance()->m_tracker_manager->getConfig().triangulation_refinement_iterations;
+    Eigen::Vector3f world_position;
+    if (!eigen_alignment_triangulate_weighted_n_view(
+            projection_matrices, eigen_screen_locations, screen_location_weights, view_count,
+            refinement_iterations, &world_position))
+    {
+        return false;
+    }
+
+    out_result->x= world_position.x();
+    out_result->y= world_position.y();
+    out_result->z= world_position.z();
+
+    return true;
+}
+
+bool
+ServerTrackerView::triangulateWorldPositionFromVisibleTrackers(
+    const ServerTrackerView * const *trackers,
+    const CommonDeviceScreenLocation *screen_locations,
+    const float *screen_areas,
+    const int tracker_count,
+    CommonDevicePosition *out_result)
+{
+    const TrackerManagerConfig &cfg= DeviceManager::getInstance()->m_tracker_manager->getConfig();
+    const int view_count= std::min(tracker_count, static_cast<int>(TrackerManager::k_max_devices));
+
+    CommonDevicePosition tracker_positions[TrackerManager::k_max_devices];
+    for (int view_index = 0; view_index < view_count; ++view_index)
+    {
+        tracker_positions[view_index]= trackers[view_index]->getTrackerPose().PositionCm;
+    }
+
+    // Collect the trackers that have a usable partner to triangulate with
+    const ServerTrackerView *triangulation_trackers[TrackerManager::k_max_devices];
+    CommonDeviceScreenLocation triangulation_screen_locations[TrackerManager::k_max_devices];
+    float triangulation_weights[TrackerManager::k_max_devices];
+    int triangulation_count= 0;
+    for (int view_index = 0; view_index < view_count; ++view_index)
+    {
+        const CommonDevicePosition &tracker_position= tracker_positions[view_index];
+        bool bHasUsablePair= false;
+
+        for (int other_view_index = 0; other_view_index < view_count && !bHasUsablePair; ++other_view_index)
+        {
+            if (other_view_index == view_index)
+            {
+                continue;
+            }
+
+            const CommonDevicePosition &other_tracker_position= tracker_positions[other_view_index];
+
+            // if trackers are on opposite sides
+            if (cfg.exclude_opposed_cameras &&
+                (tracker_position.x > 0) == (other_tracker_position.x < 0) &&
+                (tracker_position.z > 0) == (other_tracker_position.z < 0))
+            {
+                continue;
+            }
+
+            bHasUsablePair= true;
+        }
+
+        if (bHasUsablePair)
+        {
+            triangulation_trackers[triangulation_count]= trackers[view_index];
+            triangulation_screen_locations[triangulation_count]= screen_locations[view_index];
+            triangulation_weights[triangulation_count]= screen_areas[view_index];
+            ++triangulation_count;
+        }
+    }
+
+    return 
+        triangulation_count > 1 &&
+        triangulateWorldPositionFromMultipleTrackers(
+            triangulation_trackers, triangulation_screen_locations, triangulation_weights, triangulation_count,
+            out_result);
+}
+
 CommonDevicePosition
 ServerTrackerView::triangulateWorldPosition(
     const ServerTrackerView *tracker, 
@@ -1861,11 +2951,11 @@ ServerTrackerView::triangulateWorldPosition(
     cv::Mat projPoints1 = cv::Mat(cv::Point2f(screen_location->x, screen_location->y));
     cv::Mat projPoints2 = cv::Mat(cv::Point2f(other_screen_location->x, other_screen_location->y));
 
-    // Compute the pinhole camera matrix for each tracker that allows you to raycast
+    // The pinhole camera matrix for each tracker allows you to raycast
     // from the tracker center in world space through the screen location, into the world
     // See: http://docs.opencv.org/2.4/modules/calib3d/doc/camera_calibration_and_3d_reconstruction.html
-    cv::Mat projMat1 = cv::Mat(computeOpenCVCameraPinholeMatrix(tracker->m_device));
-    cv::Mat projMat2 = cv::Mat(computeOpenCVCameraPinholeMatrix(other_tracker->m_device));
+    cv::Mat projMat1 = cv::Mat(eigenProjectionMatrixToOpenCV(tracker->getProjectionMatrix()));
+    cv::Mat projMat2 = cv::Mat(eigenProjectionMatrixToOpenCV(other_tracker->getProjectionMatrix()));
 
     // Triangulate the world position from the two cameras
     cv::Mat point3D(1, 1, CV_32FC4);
@@ -1907,11 +2997,11 @@ ServerTrackerView::triangulateWorldPositions(
         projPoints2.push_back(cv::Point2f(p2.x, p2.y));
     }
 
-    // Compute the pinhole camera matrix for each tracker that allows you to raycast
+    // The pinhole camera matrix for each tracker allows you to raycast
     // from the tracker center in world space through the screen location, into the world
     // See: http://docs.opencv.org/2.4/modules/calib3d/doc/camera_calibration_and_3d_reconstruction.html
-    cv::Mat projMat1 = cv::Mat(computeOpenCVCameraPinholeMatrix(tracker->m_device));
-    cv::Mat projMat2 = cv::Mat(computeOpenCVCameraPinholeMatrix(other_tracker->m_device));
+    cv::Mat projMat1 = cv::Mat(eigenProjectionMatrixToOpenCV(tracker->getProjectionMatrix()));
+    cv::Mat projMat2 = cv::Mat(eigenProjectionMatrixToOpenCV(other_tracker->getProjectionMatrix()));
 
     // Triangulate the world positions from the two cameras
     cv::Mat points3D(1, screen_location_count, CV_32FC4);
@@ -1935,7 +3025,7 @@ ServerTrackerView::projectTrackerRelativePositions(const std::vector<CommonDevic
 {
     cv::Matx33f camera_matrix;
     cv::Matx<float, 5, 1> distortions;
-    computeOpenCVCameraIntrinsicMatrix(m_device, camera_matrix, distortions);
+    computeOpenCVCameraIntrinsicMatrix(this, camera_matrix, distortions);
     
     // Use the identity transform for tracker relative positions
     cv::Mat rvec(3, 1, cv::DataType<double>::type, double(0));
@@ -1979,23 +3069,19 @@ ServerTrackerView::projectTrackerRelativePosition(const CommonDevicePosition *tr
 
 
 // -- Tracker Utility Methods -----
-static glm::quat computeGLMCameraTransformQuaternion(const ITrackerInterface *tracker_device)
+static glm::quat computeGLMCameraTransformQuaternion(const CommonDevicePose &tracker_pose)
 {
-
-    const CommonDevicePose pose = tracker_device->getTrackerPose();
-    const CommonDeviceQuaternion &quat = pose.Orientation;
+    const CommonDeviceQuaternion &quat = tracker_pose.Orientation;
 
     const glm::quat glm_quat(quat.w, quat.x, quat.y, quat.z);
 
     return glm_quat;
 }
 
-static glm::mat4 computeGLMCameraTransformMatrix(const ITrackerInterface *tracker_device)
+static glm::mat4 computeGLMCameraTransformMatrix(const CommonDevicePose &tracker_pose)
 {
-
-    const CommonDevicePose pose = tracker_device->getTrackerPose();
-    const CommonDeviceQuaternion &quat = pose.Orientation;
-    const CommonDevicePosition &pos = pose.PositionCm;
+    const CommonDeviceQuaternion &quat = tracker_pose.Orientation;
+    const CommonDevicePosition &pos = tracker_pose.PositionCm;
 
     const glm::quat glm_quat(quat.w, quat.x, quat.y, quat.z);
     const glm::vec3 glm_pos(pos.x, pos.y, pos.z);
@@ -2008,7 +3094,7 @@ static void computeOpenCVCameraExtrinsicMatrix(const ITrackerInterface *tracker_
                                                cv::Matx34f &out)
 {
     // Extrinsic matrix is the inverse of the camera pose matrix
-    const glm::mat4 glm_camera_xform = computeGLMCameraTransformMatrix(tracker_device);
+    const glm::mat4 glm_camera_xform = computeGLMCameraTransformMatrix(tracker_device->getTrackerPose());
     const glm::mat4 glm_mat = glm::inverse(glm_camera_xform);
 
     out(0, 0) = glm_mat[0][0]; out(0, 1) = glm_mat[1][0]; out(0, 2) = glm_mat[2][0]; out(0, 3) = glm_mat[3][0];
@@ -2033,6 +3119,30 @@ static void computeOpenCVCameraIntrinsicMatrix(const ITrackerInterface *tracker_
     intrinsicOut(2, 0) = 0.f;   intrinsicOut(2, 1) = 0.f;   intrinsicOut(2, 2) = 1.f;
 }
 
+// Reads the intrinsics the tracker view published instead of the tracker device's,
+// so that frame processing threads don't race the main thread updating them
+static void computeOpenCVCameraIntrinsicMatrix(const ServerTrackerView *tracker,
+                                               cv::Matx33f &intrinsicOut,
+                                               cv::Matx<float, 5, 1> &distortionOut)
+{
+    Eigen::Matrix<float, 3, 3, Eigen::DontAlign> camera_matrix;
+    Eigen::Matrix<float, 5, 1, Eigen::DontAlign> distortion_coefficients;
+    tracker->getCameraIntrinsicMatrix(&camera_matrix, &distortion_coefficients);
+
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 3; ++col)
+        {
+            intrinsicOut(row, col)= camera_matrix(row, col);
+        }
+    }
+
+    for (int index = 0; index < 5; ++index)
+    {
+        distortionOut(index, 0)= distortion_coefficients(index);
+    }
+}
+
 static cv::Matx34f computeOpenCVCameraPinholeMatrix(const ITrackerInterface *tracker_device)
 {
     cv::Matx34f extrinsic_matrix;
@@ -2045,6 +3155,21 @@ static cv::Matx34f computeOpenCVCameraPinholeMatrix(const ITrackerInterface *tra
     return pinhole_matrix;
 }
 
+static cv::Matx34f eigenProjectionMatrixToOpenCV(const Eigen::Matrix<float, 3, 4, Eigen::DontAlign> &projection_matrix)
+{
+    cv::Matx34f pinhole_matrix;
+
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 4; ++col)
+        {
+            pinhole_matrix(row, col)= projection_matrix(row, col);
+        }
+    }
+
+    return pinhole_matrix;
+}
+
 static bool computeTrackerRelativeLightBarProjection(
     const CommonDeviceTrackingShape *tracking_shape,
     const t_opencv_float_contour &opencv_contour,
@@ -2127,7 +3252,7 @@ static bool computeTrackerRelativeLightBarProjection(
 }
 
 static bool computeTrackerRelativeLightBarPose(
-    const ITrackerInterface *tracker_device,
+    const ServerTrackerView *tracker,
     const CommonDeviceTrackingShape *tracking_shape,
     const CommonDeviceTrackingProjection *projection,
     const CommonDevicePose *tracker_relative_pose_guess,
@@ -2179,7 +3304,7 @@ static bool computeTrackerRelativeLightBarPose(
         // Get the tracker "intrinsic" matrix that encodes the camera FOV
         cv::Matx33f cvCameraMatrix;
         cv::Matx<float, 5, 1> cvDistCoeffs;
-        computeOpenCVCameraIntrinsicMatrix(tracker_device, cvCameraMatrix, cvDistCoeffs);
+        computeOpenCVCameraIntrinsicMatrix(tracker, cvCameraMatrix, cvDistCoeffs);
 
         // Fill out the initial guess in OpenCV format for the contour pose
         // if a guess pose was provided
@@ -2316,7 +3441,7 @@ static bool computeTrackerRelativePointCloudContourPose(
 static cv::Rect2i computeTrackerROIForPoseProjection(
     const bool roi_disabled,
     const ServerTrackerView *tracker,
-    const IPoseFilter* pose_filter,
+    const CommonDevicePosition *world_position_cm,
     const CommonDeviceTrackingProjection *prior_tracking_projection,
     const CommonDeviceTrackingShape *tracking_shape)
 {
@@ -2329,15 +3454,10 @@ static cv::Rect2i computeTrackerROIForPoseProjection(
     //Calculate a more refined ROI.
     //Based on the physical limits of the object's bounding box
     //projected onto the image.
-    if (!roi_disabled && pose_filter != nullptr && prior_tracking_projection != nullptr)
+    if (!roi_disabled && world_position_cm != nullptr && prior_tracking_projection != nullptr)
     {
-        // Get the (predicted) position in world space.
-        Eigen::Vector3f position_cm = pose_filter->getPositionCm(0.f); 
-        CommonDevicePosition world_position_cm;
-        world_position_cm.set(position_cm.x(), position_cm.y(), position_cm.z());
-
         // Get the (predicted) position in tracker-local space.
-        CommonDevicePosition tracker_position_cm = tracker->computeTrackerPosition(&world_position_cm);
+        CommonDevicePosition tracker_position_cm = tracker->computeTrackerPosition(world_position_cm);
 
         // Project the state computed position +/- object extents onto the image.
         CommonDevicePosition tl, br;
@@ -2471,6 +3591,72 @@ static cv::Rect2i computeTrackerROIForPoseProjection(
     return ROI;
 }
 
+static cv::Rect2i computeTrackerROIForProjectionRequest(
+    const ServerTrackerView *tracker,
+    const TrackedDeviceProjectionRequest *request,
+    const CommonDeviceTrackingProjection *prior_tracking_projection)
+{
+    const TrackerManagerConfig &trackerMgrConfig= DeviceManager::getInstance()->m_tracker_manager->getConfig();
+    const bool bRoiDisabled = request->bIsROIDisabled || trackerMgrConfig.disable_roi;
+
+    return computeTrackerROIForPoseProjection(
+        bRoiDisabled,
+        tracker,
+        prior_tracking_projection != nullptr ? &request->roi_world_position_cm : nullptr,
+        prior_tracking_projection,
+        &request->tracking_shape);
+}
+
+static void computeDisjointRegionsForROIUnion(
+    const std::vector<cv::Rect2i> &ROIs,
+    std::vector<cv::Rect2i> &out_regions)
+{
+    out_regions.clear();
+
+    // Cut the union into horizontal bands at the top and bottom edge of every ROI
+    std::vector<int> band_edges;
+    for (const cv::Rect2i &ROI : ROIs)
+    {
+        band_edges.push_back(ROI.y);
+        band_edges.push_back(ROI.y + ROI.height);
+    }
+    std::sort(band_edges.begin(), band_edges.end());
+    band_edges.erase(std::unique(band_edges.begin(), band_edges.end()), band_edges.end());
+
+    std::vector<std::pair<int, int>> spans;
+    for (size_t band_index = 1; band_index < band_edges.size(); ++band_index)
+    {
+        const int y0= band_edges[band_index - 1];
+        const int y1= band_edges[band_index];
+
+        // Every ROI either fully covers a band or doesn't touch it
+        spans.clear();
+        for (const cv::Rect2i &ROI : ROIs)
+        {
+            if (ROI.y <= y0 && ROI.y + ROI.height >= y1)
+            {
+                spans.push_back(std::make_pair(ROI.x, ROI.x + ROI.width));
+            }
+        }
+        std::sort(spans.begin(), spans.end());
+
+        // Merge the overlapping horizontal spans in the band
+        size_t span_index = 0;
+        while (span_index < spans.size())
+        {
+            const int x0= spans[span_index].first;
+            int x1= spans[span_index].second;
+
+            for (++span_index; span_index < spans.size() && spans[span_index].first <= x1; ++span_index)
+            {
+                x1= std::max(x1, spans[span_index].second);
+            }
+
+            out_regions.push_back(cv::Rect2i(x0, y0, x1 - x0, y1 - y0));
+        }
+    }
+}
+
 static bool computeBestFitTriangleForContour(
     const t_opencv_float_contour &opencv_contour,
     cv::Point2f &out_triangle_top,
@@ -4,6 +4,10 @@
 //-- includes -----
 #include "ServerDeviceView.h"
 #include "PSMoveProtocolInterface.h"
+#include "MathEigen.h"
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
 #include <vector>
 
 // -- pre-declarations -----
@@ -14,6 +18,34 @@ namespace PSMoveProtocol
 };
 
 // -- declarations -----
+// Snapshot of the tracked device state needed to search a video frame for its tracking shape.
+// Device views fill this in while holding their pose estimation lock so that the 
+// projection itself can be computed on the tracker's frame processing thread.
+struct TrackedDeviceProjectionRequest
+{
+    CommonDeviceTrackingShape tracking_shape;
+    CommonHSVColorRange hsv_color_range;
+    CommonDevicePosition roi_world_position_cm; // filtered world position used to center the ROI
+    eCommonTrackingColorID tracking_color_id;
+    bool bIsROIDisabled;
+};
+
+// Tracker state that device pose fusion reads from other trackers' frame processing threads.
+// The tracker view publishes a copy of it under a lock whenever the state changes.
+struct TrackerFusionState
+{
+    CommonDevicePose tracker_pose;
+    // The pinhole matrix (intrinsic * extrinsic) that projects world space positions onto the tracker screen
+    Eigen::Matrix<float, 3, 4, Eigen::DontAlign> projection_matrix;
+    // The intrinsic matrix (F_PY negated) and the K1, K2, P1, P2, K3 lens distortion coefficients
+    Eigen::Matrix<float, 3, 3, Eigen::DontAlign> camera_matrix;
+    Eigen::Matrix<float, 5, 1, Eigen::DontAlign> distortion_coefficients;
+    std::chrono::time_point<std::chrono::high_resolution_clock> last_new_data_timestamp;
+    int64_t frame_capture_time_us;
+    int64_t frame_segmentation_done_time_us;
+    bool bIsOpen;
+};
+
 class ServerTrackerView : public ServerDeviceView
 {
 public:
@@ -63,13 +95,52 @@ public:
     double getGain() const;
     void setGain(double value, bool bUpdateConfig);
     
+    // Returns true if video frames are processed on a dedicated thread for this tracker
+    bool getIsFrameProcessingThreaded() const;
+
+    // Segment the most recent video frame for a set of tracked devices in a single pass.
+    // The union of the device ROIs is converted to HSV once and each pixel is classified
+    // against every requested tracking color. computeProjectionFor*() then reuses the 
+    // resulting color masks for the rest of the frame.
+    // prior_projection should be null if the device isn't currently tracked by this tracker.
+    void beginFrameSegmentation();
+    void addFrameSegmentationRequest(
+        const struct TrackedDeviceProjectionRequest *request,
+        const struct CommonDeviceTrackingProjection *prior_projection);
+    void computeFrameSegmentation();
+
+    // The request a device was segmented with when the latest video frame was segmented on the main thread.
+    // Returns false if the device wasn't part of that segmentation pass.
+    // Searching the frame with the same request keeps the ROI inside the segmented area,
+    // even if the device's filtered pose has moved since.
+    bool getSegmentedProjectionRequestForController(int controller_id, struct TrackedDeviceProjectionRequest *out_request) const;
+    bool getSegmentedProjectionRequestForHMD(int hmd_id, struct TrackedDeviceProjectionRequest *out_request) const;
+
+    // When the most recently segmented video frame was captured and when its segmentation finished
+    // (PipelineLatencyStats time)
+    int64_t getFrameCaptureTimeUs() const;
+    int64_t getFrameSegmentationDoneTimeUs() const;
+
+    // Copy out the published tracker state used to fuse device poses. Safe to call from any thread.
+    void getFusionState(TrackerFusionState *out_state) const;
+
+    // The tracking color range of a device as of the last video frame polled on the main thread.
+    // Returns false if the device wasn't tracking with the given color then. Safe to call from any thread.
+    bool getPublishedControllerTrackingColorPreset(int controller_id, eCommonTrackingColorID color, CommonHSVColorRange *out_preset) const;
+    bool getPublishedHMDTrackingColorPreset(int hmd_id, eCommonTrackingColorID color, CommonHSVColorRange *out_preset) const;
+
+    // The published camera intrinsic matrix and lens distortion coefficients. Safe to call from any thread.
+    void getCameraIntrinsicMatrix(
+        Eigen::Matrix<float, 3, 3, Eigen::DontAlign> *out_camera_matrix,
+        Eigen::Matrix<float, 5, 1, Eigen::DontAlign> *out_distortion_coefficients) const;
+
+    // Search the most recent video frame for the projection of the requested device.
+    // out_pose_estimate should contain the prior pose estimate for this tracker on input.
     bool computeProjectionForController(
-        const class ServerControllerView* tracked_controller, 
-		const struct CommonDeviceTrackingShape *tracking_shape,
+        const struct TrackedDeviceProjectionRequest *request,
         struct ControllerOpticalPoseEstimation *out_pose_estimate);
     bool computeProjectionForHMD(
-		const class ServerHMDView* tracked_hmd,
-		const struct CommonDeviceTrackingShape *tracking_shape,
+        const struct TrackedDeviceProjectionRequest *request,
 		struct HMDOpticalPoseEstimation *out_pose_estimate);
     bool computePoseForProjection(
 		const struct CommonDeviceTrackingProjection *projection,
@@ -88,6 +159,31 @@ public:
     CommonDevicePosition computeTrackerPosition(const CommonDevicePosition *world_relative_position) const;
     CommonDeviceQuaternion computeTrackerOrientation(const CommonDeviceQuaternion *world_relative_orientation) const;
 
+    /// The pinhole matrix (intrinsic * extrinsic) that projects world space positions onto the tracker screen.
+    /// Cached until the tracker pose or camera intrinsics change. Safe to call from any thread.
+    Eigen::Matrix<float, 3, 4, Eigen::DontAlign> getProjectionMatrix() const;
+
+    /// Given a screen location of the same point on any number of trackers, compute the best fit world space location.
+    /// Each tracker's screen location counts as much as its weight (equal weights if screen_location_weights is nullptr).
+    static bool triangulateWorldPositionFromMultipleTrackers(
+        const ServerTrackerView * const *trackers,
+        const CommonDeviceScreenLocation *screen_locations,
+        const float *screen_location_weights,
+        const int tracker_count,
+        CommonDevicePosition *out_result);
+
+    /// Given the screen location of a device on every tracker that sees it, compute the best fit world space location.
+    /// Each tracker counts as much as the device's projection area on it (screen_areas), since the center of a bigger
+    /// projection can be located more precisely. Opposed trackers look along nearly the same ray, so with
+    /// exclude_opposed_cameras on, a tracker only takes part if a tracker that isn't opposed to it also sees the device.
+    /// Returns false if fewer than two trackers could take part.
+    static bool triangulateWorldPositionFromVisibleTrackers(
+        const ServerTrackerView * const *trackers,
+        const CommonDeviceScreenLocation *screen_locations,
+        const float *screen_areas,
+        const int tracker_count,
+        CommonDevicePosition *out_result);
+
     /// Given a single screen location on two different trackers, compute the triangulated world space location
     static CommonDevicePosition triangulateWorldPosition(
         const ServerTrackerView *tracker, const CommonDeviceScreenLocation *screen_location,
@@ -142,6 +238,11 @@ protected:
     bool allocate_device_interface(const class DeviceEnumerator *enumerator) override;
     void free_device_interface() override;
     void publish_device_data_frame() override;
+    void reallocate_video_buffers();
+    void publish_tracker_pose();
+    void publish_camera_matrices();
+    void publish_tracking_color_presets();
+    void segment_video_frame_for_tracked_devices();
     static void generate_tracker_data_frame_for_stream(
         const ServerTrackerView *tracker_view, const struct TrackerStreamInfo *stream_info,
         DeviceOutputDataFramePtr &data_frame);
@@ -149,9 +250,34 @@ protected:
 private:
     char m_shared_memory_name[256];
     class SharedVideoFrameReadWriteAccessor *m_shared_memory_accesor;
-    int m_shared_memory_video_stream_count;
+    std::atomic_int m_shared_memory_video_stream_count;
     class OpenCVBufferState *m_opencv_buffer_state;
+    std::mutex m_projection_mutex; // device update jobs can search the same video frame at once
+    class TrackerFrameProcessor *m_frame_processor;
     ITrackerInterface *m_device;
+    mutable std::mutex m_fusion_state_mutex;
+    TrackerFusionState m_fusion_state;
+
+    // Tracking color ranges of the tracked devices, guarded by m_fusion_state_mutex.
+    // The tracker's color presets are only touched on the main thread, so they get copied here for each new frame.
+    struct PublishedColorPreset
+    {
+        CommonHSVColorRange hsv_color_range;
+        eCommonTrackingColorID color_id;
+    };
+    PublishedColorPreset m_publishedControllerColorPresets[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    PublishedColorPreset m_publishedHMDColorPresets[PSMOVESERVICE_MAX_HMD_COUNT];
+
+    // Requests of the last segmentation pass made on the main thread, see getSegmentedProjectionRequestFor*()
+    struct SegmentedProjectionRequest
+    {
+        TrackedDeviceProjectionRequest request;
+        bool bIsValid;
+    };
+    SegmentedProjectionRequest m_segmentedControllerRequests[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    SegmentedProjectionRequest m_segmentedHMDRequests[PSMOVESERVICE_MAX_HMD_COUNT];
+
+    friend class TrackerFrameProcessor;
 };
 
 #endif // SERVER_TRACKER_VIEW_H
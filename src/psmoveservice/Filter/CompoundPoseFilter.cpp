@@ -225,6 +225,11 @@ Eigen::Vector3f CompoundPoseFilter::getAccelerationCmPerSecSqr() const
 	return (m_position_filter != nullptr) ? m_position_filter->getAccelerationCmPerSecSqr() : Eigen::Vector3f::Zero();
 }
 
+bool CompoundPoseFilter::getIsFusingAtCaptureTime() const
+{
+	return false;
+}
+
 void CompoundPoseFilter::dispose_filters()
 {
 	if (m_orientation_filter != nullptr)
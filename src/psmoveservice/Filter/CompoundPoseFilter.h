@@ -66,6 +66,7 @@ public:
     Eigen::Vector3f getPositionCm(float time = 0.f) const override;
     Eigen::Vector3f getVelocityCmPerSec() const override;
     Eigen::Vector3f getAccelerationCmPerSecSqr() const override;
+    bool getIsFusingAtCaptureTime() const override;
 
 protected:
 	void allocate_filters(
@@ -7,6 +7,7 @@
 #include <kalman/SquareRootBase.hpp>
 #include <kalman/SquareRootUnscentedKalmanFilter.hpp>
 
+#include <chrono>
 #include <vector>
 
 // The kalman filter runs way to slow in a fully unoptimized build.
@@ -18,6 +19,12 @@
 //-- constants --
 #define MEASUREMENT_LED_COUNT   9
 
+// Most packets the fixed lag history keeps, which bounds how many a late optical packet can replay
+#define FIXED_LAG_MAX_HISTORY_COUNT 64
+
+// Longest time step a packet gets in the fixed lag timeline, same as the controller view clamps to
+#define FIXED_LAG_MAX_TIME_STEP (1.f / 30.f)
+
 enum PoseFilterStateEnum
 {
     // Position State
@@ -103,8 +110,20 @@ template <class StateType>
 void Q_discrete_1st_order_white_noise(const double dT, const double var, const int state_index, Kalman::Covariance<StateType> &Q);
 template <class StateType>
 void Q_discrete_3rd_order_white_noise(const double dT, const double var, const int state_index, Kalman::Covariance<StateType> &Q);
+static std::chrono::time_point<std::chrono::high_resolution_clock> compute_packet_sample_time(const PoseFilterPacket &packet);
+static float compute_time_step(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &previous_sample_time,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &sample_time);
+static Eigen::Vector3f pose_clockwise_rotate(const Eigen::Quaternionf &q, const Eigen::Vector3f &v);
+static Eigen::Vector3d pose_clockwise_rotate(const Eigen::Quaterniond &q, const Eigen::Vector3d &v);
+static Eigen::Quaternionf pose_angular_velocity_to_quaternion_derivative(const Eigen::Quaternionf &q, const Eigen::Vector3f &ang_vel);
+static Eigen::Quaterniond pose_angular_velocity_to_quaternion_derivative(const Eigen::Quaterniond &q, const Eigen::Vector3d &ang_vel);
 
 //-- private definitions --
+// The filter math runs in float or double, picked per filter instance by PoseFilterConstants::use_single_precision
+template<typename T>
+using PoseVector3 = Eigen::Matrix<T, 3, 1>;
+
 template<typename T>
 class PoseStateVector : public Kalman::Vector<T, POSE_STATE_PARAMETER_COUNT>
 {
@@ -121,37 +140,36 @@ public:
     }
 
     // Accessors
-    Eigen::Vector3d get_position_meters() const { 
-        return Eigen::Vector3d((*this)[POSE_POSITION_X], (*this)[POSE_POSITION_Y], (*this)[POSE_POSITION_Z]); 
+    PoseVector3<T> get_position_meters() const { 
+        return PoseVector3<T>((*this)[POSE_POSITION_X], (*this)[POSE_POSITION_Y], (*this)[POSE_POSITION_Z]); 
     }
-    Eigen::Vector3d get_linear_velocity_m_per_sec() const {
-        return Eigen::Vector3d((*this)[POSE_LINEAR_VELOCITY_X], (*this)[POSE_LINEAR_VELOCITY_Y], (*this)[POSE_LINEAR_VELOCITY_Z]);
+    PoseVector3<T> get_linear_velocity_m_per_sec() const {
+        return PoseVector3<T>((*this)[POSE_LINEAR_VELOCITY_X], (*this)[POSE_LINEAR_VELOCITY_Y], (*this)[POSE_LINEAR_VELOCITY_Z]);
     }
-    Eigen::Vector3d get_linear_acceleration_m_per_sec_sqr() const {
-        return Eigen::Vector3d((*this)[POSE_LINEAR_ACCELERATION_X], (*this)[POSE_LINEAR_ACCELERATION_Y], (*this)[POSE_LINEAR_ACCELERATION_Z]);
+    PoseVector3<T> get_linear_acceleration_m_per_sec_sqr() const {
+        return PoseVector3<T>((*this)[POSE_LINEAR_ACCELERATION_X], (*this)[POSE_LINEAR_ACCELERATION_Y], (*this)[POSE_LINEAR_ACCELERATION_Z]);
     }
-    Eigen::Quaterniond get_error_quaterniond() const {
-        return Eigen::Quaterniond((*this)[POSE_ERROR_QUATERNION_W], (*this)[POSE_ERROR_QUATERNION_X], (*this)[POSE_ERROR_QUATERNION_Y], (*this)[POSE_ERROR_QUATERNION_Z]);
+    Eigen::Quaternion<T> get_error_quaternion() const {
+        return Eigen::Quaternion<T>((*this)[POSE_ERROR_QUATERNION_W], (*this)[POSE_ERROR_QUATERNION_X], (*this)[POSE_ERROR_QUATERNION_Y], (*this)[POSE_ERROR_QUATERNION_Z]);
     }
 
     // Mutators
-    void set_position_meters(const Eigen::Vector3d &p) {
+    void set_position_meters(const PoseVector3<T> &p) {
         (*this)[POSE_POSITION_X] = p.x(); (*this)[POSE_POSITION_Y] = p.y(); (*this)[POSE_POSITION_Z] = p.z();
     }
-    void set_linear_velocity_m_per_sec(const Eigen::Vector3d &v) {
+    void set_linear_velocity_m_per_sec(const PoseVector3<T> &v) {
         (*this)[POSE_LINEAR_VELOCITY_X] = v.x(); (*this)[POSE_LINEAR_VELOCITY_Y] = v.y(); (*this)[POSE_LINEAR_VELOCITY_Z] = v.z();
     }
-    void set_linear_acceleration_m_per_sec_sqr(const Eigen::Vector3d &a) {
+    void set_linear_acceleration_m_per_sec_sqr(const PoseVector3<T> &a) {
         (*this)[POSE_LINEAR_ACCELERATION_X] = a.x(); (*this)[POSE_LINEAR_ACCELERATION_Y] = a.y(); (*this)[POSE_LINEAR_ACCELERATION_Z] = a.z();
     }
-    void set_error_quaterniond(const Eigen::Quaterniond &q) {
+    void set_error_quaternion(const Eigen::Quaternion<T> &q) {
         (*this)[POSE_ERROR_QUATERNION_W] = q.w();
         (*this)[POSE_ERROR_QUATERNION_X] = q.x();
         (*this)[POSE_ERROR_QUATERNION_Y] = q.y();
         (*this)[POSE_ERROR_QUATERNION_Z] = q.z();
     }
 };
-typedef PoseStateVector<double> PoseStateVectord;
 
 template<typename T>
 class PoseControlVector : public Kalman::Vector<T, POSE_CONTROL_PARAMETER_COUNT>
@@ -160,18 +178,17 @@ public:
 	KALMAN_VECTOR(PoseControlVector, T, POSE_CONTROL_PARAMETER_COUNT)
 
 	// Accessors
-	Eigen::Vector3d get_angular_rates() const {
-		return Eigen::Vector3d((*this)[POSE_CONTROL_GYROSCOPE_PITCH], (*this)[POSE_CONTROL_GYROSCOPE_YAW], (*this)[POSE_CONTROL_GYROSCOPE_ROLL]);
+	PoseVector3<T> get_angular_rates() const {
+		return PoseVector3<T>((*this)[POSE_CONTROL_GYROSCOPE_PITCH], (*this)[POSE_CONTROL_GYROSCOPE_YAW], (*this)[POSE_CONTROL_GYROSCOPE_ROLL]);
 	}
 
 	// Mutators
-	void set_angular_rates(const Eigen::Vector3d &v) {
+	void set_angular_rates(const PoseVector3<T> &v) {
 		(*this)[POSE_CONTROL_GYROSCOPE_PITCH] = v.x();
 		(*this)[POSE_CONTROL_GYROSCOPE_YAW] = v.y();
 		(*this)[POSE_CONTROL_GYROSCOPE_ROLL] = v.z();
 	}
 };
-typedef PoseControlVector<double> PoseControlVectord;
 
 /**
 * @brief System model for a controller
@@ -179,16 +196,17 @@ typedef PoseControlVector<double> PoseControlVectord;
 * This is the system model defining how a controller advances from one
 * time-step to the next, i.e. how the system state evolves over time.
 */
-class PoseSystemModel : public Kalman::SystemModel<PoseStateVectord, PoseControlVectord, Kalman::SquareRootBase>
+template<typename T>
+class PoseSystemModel : public Kalman::SystemModel<PoseStateVector<T>, PoseControlVector<T>, Kalman::SquareRootBase>
 {
 public:
-    inline void set_time_step(const double dt) { m_time_step = dt; }
+    inline void set_time_step(const T dt) { m_time_step = dt; }
 
     void init(const PoseFilterConstants &constants)
     {
         use_linear_acceleration = constants.position_constants.use_linear_acceleration;
         m_last_tracking_projection_area_px_sqr = -1.f;
-		m_gyro_bias = constants.orientation_constants.gyro_drift.cast<double>();
+		m_gyro_bias = constants.orientation_constants.gyro_drift.cast<T>();
         update_process_noise(constants, 0.f);
     }
 
@@ -220,15 +238,15 @@ public:
                 k_centimeters_to_meters*k_centimeters_to_meters*position_variance_cm_sqr;
 
             // Initialize the process covariance matrix Q
-            Kalman::Covariance<PoseStateVectord> Q = Kalman::Covariance<PoseStateVectord>::Zero();
-            Q_discrete_3rd_order_white_noise<PoseStateVectord>(mean_position_dT, position_variance_m_sqr, POSE_POSITION_X, Q);
-            Q_discrete_3rd_order_white_noise<PoseStateVectord>(mean_position_dT, position_variance_m_sqr, POSE_POSITION_Y, Q);
-            Q_discrete_3rd_order_white_noise<PoseStateVectord>(mean_position_dT, position_variance_m_sqr, POSE_POSITION_Z, Q);
-			Q_discrete_1st_order_white_noise<PoseStateVectord>(mean_orientation_dT, orientation_variance, POSE_ERROR_QUATERNION_W, Q);
-			Q_discrete_1st_order_white_noise<PoseStateVectord>(mean_orientation_dT, orientation_variance, POSE_ERROR_QUATERNION_X, Q);
-			Q_discrete_1st_order_white_noise<PoseStateVectord>(mean_orientation_dT, orientation_variance, POSE_ERROR_QUATERNION_Y, Q);
-			Q_discrete_1st_order_white_noise<PoseStateVectord>(mean_orientation_dT, orientation_variance, POSE_ERROR_QUATERNION_Z, Q);
-            setCovariance(Q);
+            Kalman::Covariance<PoseStateVector<T>> Q = Kalman::Covariance<PoseStateVector<T>>::Zero();
+            Q_discrete_3rd_order_white_noise<PoseStateVector<T>>(mean_position_dT, position_variance_m_sqr, POSE_POSITION_X, Q);
+            Q_discrete_3rd_order_white_noise<PoseStateVector<T>>(mean_position_dT, position_variance_m_sqr, POSE_POSITION_Y, Q);
+            Q_discrete_3rd_order_white_noise<PoseStateVector<T>>(mean_position_dT, position_variance_m_sqr, POSE_POSITION_Z, Q);
+			Q_discrete_1st_order_white_noise<PoseStateVector<T>>(mean_orientation_dT, orientation_variance, POSE_ERROR_QUATERNION_W, Q);
+			Q_discrete_1st_order_white_noise<PoseStateVector<T>>(mean_orientation_dT, orientation_variance, POSE_ERROR_QUATERNION_X, Q);
+			Q_discrete_1st_order_white_noise<PoseStateVector<T>>(mean_orientation_dT, orientation_variance, POSE_ERROR_QUATERNION_Y, Q);
+			Q_discrete_1st_order_white_noise<PoseStateVector<T>>(mean_orientation_dT, orientation_variance, POSE_ERROR_QUATERNION_Z, Q);
+            this->setCovariance(Q);
 
             // Keep track last tracking projection area we built the covariance matrix for
             m_last_tracking_projection_area_px_sqr = tracking_projection_area_px_sqr;
@@ -247,25 +265,25 @@ public:
     * @param [in] u The control vector input
     * @returns The (predicted) system state in the next time-step
     */
-    PoseStateVectord f(const PoseStateVectord& old_state, const PoseControlVectord& control) const
+    PoseStateVector<T> f(const PoseStateVector<T>& old_state, const PoseControlVector<T>& control) const
     {
         // Predicted state vector after transition
-        PoseStateVectord new_state;
+        PoseStateVector<T> new_state;
 
         // Extract parameters from the old state
-        const Eigen::Vector3d old_position_meters = old_state.get_position_meters();
-        const Eigen::Vector3d old_linear_velocity_m_per_sec = old_state.get_linear_velocity_m_per_sec();
-        const Eigen::Vector3d old_linear_acceleration_m_per_sec_sqr = old_state.get_linear_acceleration_m_per_sec_sqr();
+        const PoseVector3<T> old_position_meters = old_state.get_position_meters();
+        const PoseVector3<T> old_linear_velocity_m_per_sec = old_state.get_linear_velocity_m_per_sec();
+        const PoseVector3<T> old_linear_acceleration_m_per_sec_sqr = old_state.get_linear_acceleration_m_per_sec_sqr();
 
         // Extract parameters from the old state
-        const Eigen::Quaterniond error_q_old = old_state.get_error_quaterniond();
+        const Eigen::Quaternion<T> error_q_old = old_state.get_error_quaternion();
 
 		// Compute the true angular rate from the control vector
-		const Eigen::Vector3d omega = control - m_gyro_bias;
+		const PoseVector3<T> omega = control - m_gyro_bias;
 
         // Compute the position state update
-        Eigen::Vector3d new_position_meters;
-        Eigen::Vector3d new_linear_velocity_m_per_sec;
+        PoseVector3<T> new_position_meters;
+        PoseVector3<T> new_linear_velocity_m_per_sec;
         if (use_linear_acceleration)
         {
             new_position_meters =
@@ -287,13 +305,13 @@ public:
                 : old_linear_velocity_m_per_sec;
         }
 
-        const Eigen::Vector3d &new_linear_acceleration_m_per_sec_sqr = old_linear_acceleration_m_per_sec_sqr;
+        const PoseVector3<T> &new_linear_acceleration_m_per_sec_sqr = old_linear_acceleration_m_per_sec_sqr;
 
 		// Compute the quaternion derivative of the current state
 		// q_new= q + q_dot*dT
-		const Eigen::Quaterniond q_dot = eigen_angular_velocity_to_quaterniond_derivative(error_q_old, omega);
-		const Eigen::Quaterniond error_q_step = Eigen::Quaterniond(q_dot.coeffs() * m_time_step);
-		const Eigen::Quaterniond error_q_new = Eigen::Quaterniond(error_q_old.coeffs() + error_q_step.coeffs());
+		const Eigen::Quaternion<T> q_dot = pose_angular_velocity_to_quaternion_derivative(error_q_old, omega);
+		const Eigen::Quaternion<T> error_q_step = Eigen::Quaternion<T>(q_dot.coeffs() * m_time_step);
+		const Eigen::Quaternion<T> error_q_new = Eigen::Quaternion<T>(error_q_old.coeffs() + error_q_step.coeffs());
 
         // Save results to the new state
         new_state.set_position_meters(new_position_meters);
@@ -301,29 +319,38 @@ public:
         new_state.set_linear_acceleration_m_per_sec_sqr(new_linear_acceleration_m_per_sec_sqr);
 
         // Save results to the new state
-        new_state.set_error_quaterniond(error_q_new.normalized());
+        new_state.set_error_quaternion(error_q_new.normalized());
 
         return new_state;
     }
 
 protected:
     bool use_linear_acceleration;
-    double m_time_step;
+    T m_time_step;
     float m_last_tracking_projection_area_px_sqr;
-	Eigen::Vector3d m_gyro_bias;
+	PoseVector3<T> m_gyro_bias;
 };
 
-class PoseSRUKF : public Kalman::SquareRootUnscentedKalmanFilter<PoseStateVectord>
+template<typename T>
+class PoseSRUKF : public Kalman::SquareRootUnscentedKalmanFilter<PoseStateVector<T>>
 {
 public:
-    PoseSRUKF(double alpha = 1.0, double beta = 2.0, double kappa = 0.0)
-        : Kalman::SquareRootUnscentedKalmanFilter<PoseStateVectord>(alpha, beta, kappa)
+    typedef PoseStateVector<T> State;
+
+    PoseSRUKF(T alpha = 1.0, T beta = 2.0, T kappa = 0.0)
+        : Kalman::SquareRootUnscentedKalmanFilter<PoseStateVector<T>>(alpha, beta, kappa)
     {
     }
 
     State& getStateMutable()
     {
-        return x;
+        return this->x;
+    }
+
+    void restoreState(const State &state, const Kalman::CovarianceSquareRoot<State> &covariance_square_root)
+    {
+        this->x = state;
+        this->S = covariance_square_root;
     }
 };
 
@@ -334,35 +361,35 @@ public:
 	KALMAN_VECTOR(PoseGravMeasurementVector, T, POSE_G_MEASUREMENT_PARAMETER_COUNT)
 
 		// Accessors
-		Eigen::Vector3d get_accelerometer() const {
-		return Eigen::Vector3d((*this)[POSE_ACCELEROMETER_X], (*this)[POSE_ACCELEROMETER_Y], (*this)[POSE_ACCELEROMETER_Z]);
+		PoseVector3<T> get_accelerometer() const {
+		return PoseVector3<T>((*this)[POSE_ACCELEROMETER_X], (*this)[POSE_ACCELEROMETER_Y], (*this)[POSE_ACCELEROMETER_Z]);
 	}
 
 	// Mutators
-	void set_accelerometer(const Eigen::Vector3d &a) {
+	void set_accelerometer(const PoseVector3<T> &a) {
 		(*this)[POSE_ACCELEROMETER_X] = a.x(); (*this)[POSE_ACCELEROMETER_Y] = a.y(); (*this)[POSE_ACCELEROMETER_Z] = a.z();
 	}
 };
-typedef PoseGravMeasurementVector<double> PoseGravMeasurementVectord;
 
+template<typename T>
 class PoseGravMeasurementModel :
-	public Kalman::MeasurementModel<PoseStateVectord, PoseGravMeasurementVectord, Kalman::SquareRootBase>
+	public Kalman::MeasurementModel<PoseStateVector<T>, PoseGravMeasurementVector<T>, Kalman::SquareRootBase>
 {
 public:
-	void init(const OrientationFilterConstants &constants, const Eigen::Quaterniond *last_world_orientation_ptr)
+	void init(const OrientationFilterConstants &constants, const Eigen::Quaternion<T> *last_world_orientation_ptr)
 	{
 		// Update the measurement covariance R
-		Kalman::Covariance<PoseGravMeasurementVectord> R =
-			Kalman::Covariance<PoseGravMeasurementVectord>::Zero();
+		Kalman::Covariance<PoseGravMeasurementVector<T>> R =
+			Kalman::Covariance<PoseGravMeasurementVector<T>>::Zero();
 
 		// Only diagonals used so no need to compute Cholesky
 		static float r_accelerometer_scale = R_SCALE;
 		R(POSE_ACCELEROMETER_X, POSE_ACCELEROMETER_X) = r_accelerometer_scale*constants.accelerometer_variance.x();
 		R(POSE_ACCELEROMETER_Y, POSE_ACCELEROMETER_Y) = r_accelerometer_scale*constants.accelerometer_variance.y();
 		R(POSE_ACCELEROMETER_Z, POSE_ACCELEROMETER_Z) = r_accelerometer_scale*constants.accelerometer_variance.z();
-		setCovariance(R);
+		this->setCovariance(R);
 
-		identity_gravity_direction = constants.gravity_calibration_direction.cast<double>();
+		identity_gravity_direction = constants.gravity_calibration_direction.cast<T>();
 		m_last_world_orientation_ptr = last_world_orientation_ptr;
 	}
 
@@ -376,25 +403,25 @@ public:
 	* @param [in] x The system state in current time-step
 	* @returns The (predicted) sensor measurement for the system state
 	*/
-	PoseGravMeasurementVectord h(const PoseStateVectord& x) const
+	PoseGravMeasurementVector<T> h(const PoseStateVector<T>& x) const
 	{
-		PoseGravMeasurementVectord predicted_measurement;
+		PoseGravMeasurementVector<T> predicted_measurement;
 
 		// Use the orientation + linear acceleration state from the state for prediction
-		const Eigen::Quaterniond error_orientation = x.get_error_quaterniond();
-		const Eigen::Quaterniond world_to_local_orientation = 
+		const Eigen::Quaternion<T> error_orientation = x.get_error_quaternion();
+		const Eigen::Quaternion<T> world_to_local_orientation = 
 			eigen_quaternion_concatenate(*m_last_world_orientation_ptr, error_orientation).normalized();
 
 		// Convert the world space linear acceleration in the state into a local space predicted measurement in the accelerometer 
-		const Eigen::Vector3d world_linear_accel_g_units = x.get_linear_acceleration_m_per_sec_sqr() * k_ms2_to_g_units;
-		const Eigen::Vector3d local_linear_accel_g_units = eigen_vector3d_clockwise_rotate(world_to_local_orientation, world_linear_accel_g_units);
+		const PoseVector3<T> world_linear_accel_g_units = x.get_linear_acceleration_m_per_sec_sqr() * k_ms2_to_g_units;
+		const PoseVector3<T> local_linear_accel_g_units = pose_clockwise_rotate(world_to_local_orientation, world_linear_accel_g_units);
 
 		// Convert the world space gravitational acceleration in the state into a local space predicted measurement in the accelerometer 
-		const Eigen::Vector3d &world_gravity_accel_g_units = identity_gravity_direction;
-		const Eigen::Vector3d local_gravity_accel_g_units = eigen_vector3d_clockwise_rotate(world_to_local_orientation, world_gravity_accel_g_units);
+		const PoseVector3<T> &world_gravity_accel_g_units = identity_gravity_direction;
+		const PoseVector3<T> local_gravity_accel_g_units = pose_clockwise_rotate(world_to_local_orientation, world_gravity_accel_g_units);
 		
 		// Combine the linear and gravitational accelerometer predictions into the final predicted accelerometer reading
-		const Eigen::Vector3d accel_local = local_linear_accel_g_units + local_gravity_accel_g_units;
+		const PoseVector3<T> accel_local = local_linear_accel_g_units + local_gravity_accel_g_units;
 
 		// Save the predictions into the measurement vector
 		predicted_measurement.set_accelerometer(accel_local);
@@ -403,8 +430,8 @@ public:
 	}
 
 public:
-	Eigen::Vector3d identity_gravity_direction;
-	const Eigen::Quaterniond *m_last_world_orientation_ptr;
+	PoseVector3<T> identity_gravity_direction;
+	const Eigen::Quaternion<T> *m_last_world_orientation_ptr;
 };
 
 template<typename T>
@@ -414,32 +441,32 @@ public:
 	KALMAN_VECTOR(PoseMagGravMeasurementVector, T, POSE_MG_MEASUREMENT_PARAMETER_COUNT)
 
 	// Accessors
-	Eigen::Vector3d get_accelerometer() const {
-		return Eigen::Vector3d((*this)[POSE_ACCELEROMETER_X], (*this)[POSE_ACCELEROMETER_Y], (*this)[POSE_ACCELEROMETER_Z]);
+	PoseVector3<T> get_accelerometer() const {
+		return PoseVector3<T>((*this)[POSE_ACCELEROMETER_X], (*this)[POSE_ACCELEROMETER_Y], (*this)[POSE_ACCELEROMETER_Z]);
 	}
-	Eigen::Vector3d get_magnetometer() const {
-		return Eigen::Vector3d((*this)[POSE_MAGNETOMETER_X], (*this)[POSE_MAGNETOMETER_Y], (*this)[POSE_MAGNETOMETER_Z]);
+	PoseVector3<T> get_magnetometer() const {
+		return PoseVector3<T>((*this)[POSE_MAGNETOMETER_X], (*this)[POSE_MAGNETOMETER_Y], (*this)[POSE_MAGNETOMETER_Z]);
 	}
 
 	// Mutators
-	void set_accelerometer(const Eigen::Vector3d &a) {
+	void set_accelerometer(const PoseVector3<T> &a) {
 		(*this)[POSE_ACCELEROMETER_X] = a.x(); (*this)[POSE_ACCELEROMETER_Y] = a.y(); (*this)[POSE_ACCELEROMETER_Z] = a.z();
 	}
-	void set_magnetometer(const Eigen::Vector3d &m) {
+	void set_magnetometer(const PoseVector3<T> &m) {
 		(*this)[POSE_MAGNETOMETER_X] = m.x(); (*this)[POSE_MAGNETOMETER_Y] = m.y(); (*this)[POSE_MAGNETOMETER_Z] = m.z();
 	}
 };
-typedef PoseMagGravMeasurementVector<double> PoseMagGravMeasurementVectord;
 
+template<typename T>
 class PoseMagGravMeasurementModel :
-	public Kalman::MeasurementModel<PoseStateVectord, PoseMagGravMeasurementVectord, Kalman::SquareRootBase>
+	public Kalman::MeasurementModel<PoseStateVector<T>, PoseMagGravMeasurementVector<T>, Kalman::SquareRootBase>
 {
 public:
-	void init(const OrientationFilterConstants &constants, const Eigen::Quaterniond *last_world_orientation_ptr)
+	void init(const OrientationFilterConstants &constants, const Eigen::Quaternion<T> *last_world_orientation_ptr)
 	{
 		// Update the measurement covariance R
-		Kalman::Covariance<PoseMagGravMeasurementVectord> R =
-			Kalman::Covariance<PoseMagGravMeasurementVectord>::Zero();
+		Kalman::Covariance<PoseMagGravMeasurementVector<T>> R =
+			Kalman::Covariance<PoseMagGravMeasurementVector<T>>::Zero();
 
 		// Only diagonals used so no need to compute Cholesky
 		static float r_accelerometer_scale = R_SCALE;
@@ -450,10 +477,10 @@ public:
 		R(POSE_MAGNETOMETER_X, POSE_MAGNETOMETER_X) = r_magnetometer_scale*constants.magnetometer_variance.x();
 		R(POSE_MAGNETOMETER_Y, POSE_MAGNETOMETER_Y) = r_magnetometer_scale*constants.magnetometer_variance.y();
 		R(POSE_MAGNETOMETER_Z, POSE_MAGNETOMETER_Z) = r_magnetometer_scale*constants.magnetometer_variance.z();
-		setCovariance(R);
+		this->setCovariance(R);
 
-		identity_gravity_direction = constants.gravity_calibration_direction.cast<double>();
-		identity_magnetometer_direction = constants.magnetometer_calibration_direction.cast<double>();
+		identity_gravity_direction = constants.gravity_calibration_direction.cast<T>();
+		identity_magnetometer_direction = constants.magnetometer_calibration_direction.cast<T>();
 		m_last_world_orientation_ptr = last_world_orientation_ptr;
 	}
 
@@ -467,30 +494,30 @@ public:
 	* @param [in] x The system state in current time-step
 	* @returns The (predicted) sensor measurement for the system state
 	*/
-	PoseMagGravMeasurementVectord h(const PoseStateVectord& x) const
+	PoseMagGravMeasurementVector<T> h(const PoseStateVector<T>& x) const
 	{
-		PoseMagGravMeasurementVectord predicted_measurement;
+		PoseMagGravMeasurementVector<T> predicted_measurement;
 
 		// Use the orientation + linear acceleration state from the state for prediction
-		const Eigen::Quaterniond error_orientation = x.get_error_quaterniond();
-		const Eigen::Quaterniond world_to_local_orientation = 
+		const Eigen::Quaternion<T> error_orientation = x.get_error_quaternion();
+		const Eigen::Quaternion<T> world_to_local_orientation = 
 			eigen_quaternion_concatenate(*m_last_world_orientation_ptr, error_orientation).normalized();
 
 		// Convert the world space linear acceleration in the state into a local space predicted measurement in the accelerometer 
-		const Eigen::Vector3d world_linear_accel_g_units = x.get_linear_acceleration_m_per_sec_sqr() * k_ms2_to_g_units;
-		const Eigen::Vector3d local_linear_accel_g_units = eigen_vector3d_clockwise_rotate(world_to_local_orientation, world_linear_accel_g_units);
+		const PoseVector3<T> world_linear_accel_g_units = x.get_linear_acceleration_m_per_sec_sqr() * k_ms2_to_g_units;
+		const PoseVector3<T> local_linear_accel_g_units = pose_clockwise_rotate(world_to_local_orientation, world_linear_accel_g_units);
 
 		// Convert the world space gravitational acceleration in the state into a local space predicted measurement in the accelerometer 
-		const Eigen::Vector3d &world_gravity_accel_g_units = identity_gravity_direction;
-		const Eigen::Vector3d local_gravity_accel_g_units = eigen_vector3d_clockwise_rotate(world_to_local_orientation, world_gravity_accel_g_units);
+		const PoseVector3<T> &world_gravity_accel_g_units = identity_gravity_direction;
+		const PoseVector3<T> local_gravity_accel_g_units = pose_clockwise_rotate(world_to_local_orientation, world_gravity_accel_g_units);
 
 		// Combine the linear and gravitational accelerometer predictions into the final predicted accelerometer reading
-		const Eigen::Vector3d accel_local = local_linear_accel_g_units + local_gravity_accel_g_units;
+		const PoseVector3<T> accel_local = local_linear_accel_g_units + local_gravity_accel_g_units;
 
 		// Use the orientation from the state to predict
 		// what the magnetometer reading should be (in the space of the controller)
-		const Eigen::Vector3d &mag_world = identity_magnetometer_direction;
-		const Eigen::Vector3d mag_local = eigen_vector3d_clockwise_rotate(world_to_local_orientation, mag_world);
+		const PoseVector3<T> &mag_world = identity_magnetometer_direction;
+		const PoseVector3<T> mag_local = pose_clockwise_rotate(world_to_local_orientation, mag_world);
 
 		// Save the predictions into the measurement vector
 		predicted_measurement.set_accelerometer(accel_local);
@@ -500,10 +527,10 @@ public:
 	}
 
 public:
-	Eigen::Vector3d identity_gravity_direction;
-	Eigen::Vector3d identity_magnetometer_direction;
-	const Eigen::Quaterniond *m_last_world_orientation_ptr;
-	//Eigen::Vector3d m_last_world_linear_acceleration_m_per_sec_sqr;
+	PoseVector3<T> identity_gravity_direction;
+	PoseVector3<T> identity_magnetometer_direction;
+	const Eigen::Quaternion<T> *m_last_world_orientation_ptr;
+	//PoseVector3<T> m_last_world_linear_acceleration_m_per_sec_sqr;
 };
 
 template<typename T>
@@ -513,21 +540,20 @@ public:
     KALMAN_VECTOR(PoseLEDMeasurementVector, T, POSE_LED_MEASUREMENT_PARAMETER_COUNT)
 
     // Accessors
-    Eigen::Vector3d get_LED_position_meters() const {
-        return Eigen::Vector3d(
+    PoseVector3<T> get_LED_position_meters() const {
+        return PoseVector3<T>(
                 (*this)[POSE_LED_POSITION_X], 
                 (*this)[POSE_LED_POSITION_Y],
                 (*this)[POSE_LED_POSITION_Z]);
     }
 
     // Mutators
-    void set_LED_position_meters(const Eigen::Vector3d &p) {
+    void set_LED_position_meters(const PoseVector3<T> &p) {
         (*this)[POSE_LED_POSITION_X] = p.x();
 		(*this)[POSE_LED_POSITION_Y] = p.y();
 		(*this)[POSE_LED_POSITION_Z] = p.z();
     }
 };
-typedef PoseLEDMeasurementVector<double> PoseLEDMeasurementVectord;
 
 /**
 * @brief LED Measurement model for measuring PSVR controller
@@ -535,11 +561,12 @@ typedef PoseLEDMeasurementVector<double> PoseLEDMeasurementVectord;
 * This is the measurement model for measuring the position and magnetometer of the PSVR controller.
 * The measurement is given by the optical trackers.
 */
+template<typename T>
 class PoseLEDMeasurementModel : 
-    public Kalman::MeasurementModel<PoseStateVectord, PoseLEDMeasurementVectord, Kalman::SquareRootBase>
+    public Kalman::MeasurementModel<PoseStateVector<T>, PoseLEDMeasurementVector<T>, Kalman::SquareRootBase>
 {
 public:
-    void init(const PoseFilterConstants &constants, int led_index, const Eigen::Quaterniond *last_world_orientation)
+    void init(const PoseFilterConstants &constants, int led_index, const Eigen::Quaternion<T> *last_world_orientation)
     {
         m_last_world_orientation_ptr = last_world_orientation;
 		m_last_tracking_projection_area_px_sqr = -1.f;
@@ -551,10 +578,10 @@ public:
 
 		// LED model is in centimeters while filter is in meters
         m_LED_model_vertex= 
-			Eigen::Vector3d(
-				static_cast<double>(p.x * k_centimeters_to_meters),
-				static_cast<double>(p.y * k_centimeters_to_meters),
-				static_cast<double>(p.z * k_centimeters_to_meters));
+			PoseVector3<T>(
+				static_cast<T>(p.x * k_centimeters_to_meters),
+				static_cast<T>(p.y * k_centimeters_to_meters),
+				static_cast<T>(p.z * k_centimeters_to_meters));
     }
 
 	void updateMeasurementCovariance(
@@ -577,11 +604,11 @@ public:
 			// Update the measurement covariance R
             // Only diagonals used so no need to compute Cholesky
             static float r_position_scale = R_SCALE;
-			Kalman::Covariance<PoseLEDMeasurementVectord> R = Kalman::Covariance<PoseLEDMeasurementVectord>::Zero();
+			Kalman::Covariance<PoseLEDMeasurementVector<T>> R = Kalman::Covariance<PoseLEDMeasurementVector<T>>::Zero();
 			R(POSE_LED_POSITION_X, POSE_LED_POSITION_X) = fmax(r_position_scale*position_variance_m_sqr, R_MIN);
 			R(POSE_LED_POSITION_Y, POSE_LED_POSITION_Y) = fmax(r_position_scale*position_variance_m_sqr, R_MIN);
 			R(POSE_LED_POSITION_Z, POSE_LED_POSITION_Z) = fmax(r_position_scale*position_variance_m_sqr, R_MIN);
-			setCovariance(R);
+			this->setCovariance(R);
 
 			// Keep track last position quality we built the covariance matrix for
 			m_last_tracking_projection_area_px_sqr = tracking_projection_area_px_sqr;
@@ -598,29 +625,29 @@ public:
     * @param [in] x The system state in current time-step
     * @returns The (predicted) sensor measurement for the system state
     */
-    PoseLEDMeasurementVectord h(const PoseStateVectord& x) const
+    PoseLEDMeasurementVector<T> h(const PoseStateVector<T>& x) const
     {
-		PoseLEDMeasurementVectord predicted_measurement;
+		PoseLEDMeasurementVector<T> predicted_measurement;
 
         // Use the position and orientation from the state for predictions
-        const Eigen::Vector3d position_meters= x.get_position_meters();
-        const Eigen::Quaterniond error_orientation = x.get_error_quaterniond();
-        const Eigen::Quaterniond local_to_world_orientation = 
+        const PoseVector3<T> position_meters= x.get_position_meters();
+        const Eigen::Quaternion<T> error_orientation = x.get_error_quaternion();
+        const Eigen::Quaternion<T> local_to_world_orientation = 
 			eigen_quaternion_concatenate(*m_last_world_orientation_ptr, error_orientation).normalized();
 
 		//predicted_measurement.set_optical_orientation(local_to_world_orientation);
 		//predicted_measurement.set_optical_position_meters(position_meters);
         // Compute where we expect to find the tracking LEDs
-        Eigen::Affine3d local_to_world= Eigen::Affine3d::Identity();
+        Eigen::Transform<T, 3, Eigen::Affine> local_to_world= Eigen::Transform<T, 3, Eigen::Affine>::Identity();
         local_to_world.linear()= local_to_world_orientation.toRotationMatrix();
         local_to_world.translation()= x.get_position_meters();
 
-		const Eigen::Vector3d led_model_vertex=
-			Eigen::Vector3d(
+		const PoseVector3<T> led_model_vertex=
+			PoseVector3<T>(
 				m_LED_model_vertex.x(),
 				m_LED_model_vertex.y(),
 				m_LED_model_vertex.z());
-        const Eigen::Vector3d predicted_led_position= local_to_world * led_model_vertex;
+        const PoseVector3<T> predicted_led_position= local_to_world * led_model_vertex;
 
         predicted_measurement.set_LED_position_meters(predicted_led_position);
 
@@ -628,8 +655,8 @@ public:
     }
 
 public:
-    Eigen::Vector3d m_LED_model_vertex; // in meters!
-    const Eigen::Quaterniond *m_last_world_orientation_ptr;
+    PoseVector3<T> m_LED_model_vertex; // in meters!
+    const Eigen::Quaternion<T> *m_last_world_orientation_ptr;
     double m_time_step;
 	float m_last_tracking_projection_area_px_sqr;
 };
@@ -641,8 +668,8 @@ public:
 	KALMAN_VECTOR(PoseOrientationMeasurementVector, T, POSE_OPTICAL_MEASUREMENT_PARAMETER_COUNT)
 
     // Accessors
-	Eigen::Quaterniond get_optical_quaterniond() const {
-		return Eigen::Quaterniond(
+	Eigen::Quaternion<T> get_optical_quaternion() const {
+		return Eigen::Quaternion<T>(
 			(*this)[POSE_OPTICAL_QUATERNION_W], 
 			(*this)[POSE_OPTICAL_QUATERNION_X],
 			(*this)[POSE_OPTICAL_QUATERNION_Y], 
@@ -650,20 +677,20 @@ public:
 	}
 
     // Mutators
-	void set_optical_quaterniond(const Eigen::Quaterniond &q) {
+	void set_optical_quaternion(const Eigen::Quaternion<T> &q) {
 		(*this)[POSE_OPTICAL_QUATERNION_W] = q.w();
 		(*this)[POSE_OPTICAL_QUATERNION_X] = q.x();
 		(*this)[POSE_OPTICAL_QUATERNION_Y] = q.y();
 		(*this)[POSE_OPTICAL_QUATERNION_Z] = q.z();
 	}
 };
-typedef PoseOrientationMeasurementVector<double> PoseOrientationMeasurementVectord;
 
+template<typename T>
 class PoseOrientationMeasurementModel
-	: public Kalman::MeasurementModel<PoseStateVectord, PoseOrientationMeasurementVectord, Kalman::SquareRootBase>
+	: public Kalman::MeasurementModel<PoseStateVector<T>, PoseOrientationMeasurementVector<T>, Kalman::SquareRootBase>
 {
 public:
-	void init(const OrientationFilterConstants &constants, const Eigen::Quaterniond *last_world_orientation)
+	void init(const OrientationFilterConstants &constants, const Eigen::Quaternion<T> *last_world_orientation)
 	{
 		m_last_tracking_projection_area = -1.f;
 		m_last_world_orientation_ptr= last_world_orientation;
@@ -679,8 +706,8 @@ public:
 			!is_nearly_equal(tracking_projection_area, m_last_tracking_projection_area, 10.f))
 		{
 			// Update the measurement covariance R
-			Kalman::Covariance<PoseOrientationMeasurementVectord> R =
-				Kalman::Covariance<PoseOrientationMeasurementVectord>::Zero();
+			Kalman::Covariance<PoseOrientationMeasurementVector<T>> R =
+				Kalman::Covariance<PoseOrientationMeasurementVector<T>>::Zero();
 			const float orientation_variance = constants.orientation_variance_curve.evaluate(tracking_projection_area);
 
 			static float r_scale = R_SCALE;
@@ -688,7 +715,7 @@ public:
 			R(POSE_OPTICAL_QUATERNION_X, POSE_OPTICAL_QUATERNION_X) = r_scale*orientation_variance;
 			R(POSE_OPTICAL_QUATERNION_Y, POSE_OPTICAL_QUATERNION_Y) = r_scale*orientation_variance;
 			R(POSE_OPTICAL_QUATERNION_Z, POSE_OPTICAL_QUATERNION_Z) = r_scale*orientation_variance;
-			setCovariance(R);
+			this->setCovariance(R);
 
 			// Keep track last tracking projection area we built the covariance matrix for
 			m_last_tracking_projection_area = tracking_projection_area;
@@ -705,27 +732,28 @@ public:
 	* @param [in] x The system state in current time-step
 	* @returns The (predicted) sensor measurement for the system state
 	*/
-	PoseOrientationMeasurementVectord h(const PoseStateVectord& x) const
+	PoseOrientationMeasurementVector<T> h(const PoseStateVector<T>& x) const
 	{
-		PoseOrientationMeasurementVectord predicted_measurement;
+		PoseOrientationMeasurementVector<T> predicted_measurement;
 
 		// Use the orientation from the state for prediction
-		const Eigen::Quaterniond error_orientation = x.get_error_quaterniond();
-		const Eigen::Quaterniond world_to_local_orientation = 
+		const Eigen::Quaternion<T> error_orientation = x.get_error_quaternion();
+		const Eigen::Quaternion<T> world_to_local_orientation = 
 			eigen_quaternion_concatenate(*m_last_world_orientation_ptr, error_orientation).normalized();
 
 		// Save the predictions into the measurement vector
-		predicted_measurement.set_optical_quaterniond(world_to_local_orientation);
+		predicted_measurement.set_optical_quaternion(world_to_local_orientation);
 
 		return predicted_measurement;
 	}
 
 public:
 	float m_last_tracking_projection_area;
-	const Eigen::Quaterniond *m_last_world_orientation_ptr;
+	const Eigen::Quaternion<T> *m_last_world_orientation_ptr;
 };
 
 
+/// The filter state that doesn't depend on the precision the filter math runs in
 class KalmanPoseFilterImpl
 {
 public:
@@ -741,86 +769,212 @@ public:
     /// Position that's considered the origin position 
     Eigen::Vector3f origin_position_meters; // meters
 
-    /// Used to model how the physics of the controller evolves
-    PoseSystemModel system_model;
+    /// The duration the filter has been running
+    double time;
 
-    /// Unscented Kalman Filter instance
-    PoseSRUKF ukf;
+    KalmanPoseFilterImpl()
+        : bIsValid(false)
+        , bSeenPositionMeasurement(false)
+        , bSeenOrientationMeasurement(false)
+        , origin_position_meters(Eigen::Vector3f::Zero())
+        , time(0.0)
+    {
+    }
 
-    /// The duration the filter has been running
+    virtual ~KalmanPoseFilterImpl()
+    {
+    }
+
+    virtual void init(const PoseFilterConstants &constants) = 0;
+    virtual void init(
+        const PoseFilterConstants &constants,
+        const Eigen::Vector3f &initial_position_meters,
+        const Eigen::Quaternionf &orientation) = 0;
+
+    /// Applies one packet on top of the current filter state
+    virtual void update(const PoseFilterConstants &constants, const float delta_time, const PoseFilterPacket &packet) = 0;
+
+    /// Makes the given orientation the output orientation and resets the UKF state
+    virtual void recenter_orientation(const Eigen::Quaternionf &orientation) = 0;
+
+    // -- State Accessors --
+    virtual Eigen::Quaternionf get_world_orientation() const = 0;
+    virtual Eigen::Vector3f get_position_meters() const = 0;
+    virtual Eigen::Vector3f get_linear_velocity_m_per_sec() const = 0;
+    virtual Eigen::Vector3f get_linear_acceleration_m_per_sec_sqr() const = 0;
+
+    // -- Fixed Lag Rollback --
+    /// Snapshots are kept in slots owned by the filter, one for each fixed lag history entry
+    virtual void save_snapshot(int slot) = 0;
+    virtual void restore_snapshot(int slot) = 0;
+};
+
+/// The parts of the filter state a packet update changes
+template<typename T>
+struct KalmanPoseFilterSnapshot
+{
+    bool bIsValid;
+    bool bSeenPositionMeasurement;
+    bool bSeenOrientationMeasurement;
+    PoseSystemModel<T> system_model;
+    PoseStateVector<T> state;
+    Kalman::CovarianceSquareRoot<PoseStateVector<T>> covariance_square_root;
     double time;
+    Eigen::Quaternion<T> world_orientation;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/// Pose filter state and math at a given precision.
+/// The sigma point count follows from the fixed size state vector, so it is known at compile time either way.
+template<typename T>
+class KalmanPoseFilterImplT : public KalmanPoseFilterImpl
+{
+public:
+    /// Used to model how the physics of the controller evolves
+    PoseSystemModel<T> system_model;
+
+    /// Unscented Kalman Filter instance
+    PoseSRUKF<T> ukf;
 
     /// The final output of this filter.
     /// This isn't part of the UKF state vector because it's non-linear.
     /// Instead we store an "error quaternion" in the UKF state vector and then apply it 
     /// to this quaternion after a time step and then zero out the error.
-    Eigen::Quaterniond world_orientation;
+    Eigen::Quaternion<T> world_orientation;
 
-    KalmanPoseFilterImpl()
-        : bIsValid(false)
-        , bSeenOrientationMeasurement(false)
+    /// Filter state from just before each fixed lag history entry was applied, indexed by history slot
+    std::vector<KalmanPoseFilterSnapshot<T>, Eigen::aligned_allocator<KalmanPoseFilterSnapshot<T>> > snapshots;
+
+    KalmanPoseFilterImplT()
+        : KalmanPoseFilterImpl()
         , system_model()
         , ukf(k_ukf_alpha, k_ukf_beta, k_ukf_kappa)
-        , world_orientation(Eigen::Quaternionf::Identity())
-        , time(0.0)
+        , world_orientation(Eigen::Quaternion<T>::Identity())
     {
     }
 
-    virtual void init(const PoseFilterConstants &constants)
+    void init(const PoseFilterConstants &constants) override
     {
         bIsValid = false;
         bSeenOrientationMeasurement = false;
         bSeenPositionMeasurement= false;
 
-        world_orientation = Eigen::Quaterniond::Identity();
+        world_orientation = Eigen::Quaternion<T>::Identity();
         origin_position_meters = Eigen::Vector3f::Zero();
 
         system_model.init(constants);
-        ukf.init(PoseStateVectord::Identity());
+        ukf.init(PoseStateVector<T>::Identity());
+        allocate_snapshots(constants);
     }
 
-    virtual void init(
+    void init(
         const PoseFilterConstants &constants,
         const Eigen::Vector3f &initial_position_meters,
-        const Eigen::Quaternionf &orientation)
+        const Eigen::Quaternionf &orientation) override
     {
         bIsValid = true;
         bSeenOrientationMeasurement = true;
         bSeenPositionMeasurement= true;
 
         origin_position_meters = Eigen::Vector3f::Zero();
-        world_orientation = orientation.cast<double>();
+        world_orientation = orientation.cast<T>();
 
-        PoseStateVectord state_vector = PoseStateVectord::Identity();
-        state_vector.set_position_meters(initial_position_meters.cast<double>());
+        PoseStateVector<T> state_vector = PoseStateVector<T>::Identity();
+        state_vector.set_position_meters(initial_position_meters.cast<T>());
 
         system_model.init(constants);
-        ukf.init(PoseStateVectord::Identity());
+        ukf.init(PoseStateVector<T>::Identity());
         apply_error_to_world_quaternion();
+        allocate_snapshots(constants);
+    }
+
+    void recenter_orientation(const Eigen::Quaternionf &orientation) override
+    {
+        world_orientation = orientation.cast<T>();
+        ukf.init(PoseStateVector<T>::Identity());
+    }
+
+    // -- State Accessors --
+    Eigen::Quaternionf get_world_orientation() const override
+    {
+        return compute_net_world_quaternion().template cast<float>();
+    }
+
+    Eigen::Vector3f get_position_meters() const override
+    {
+        return ukf.getState().get_position_meters().template cast<float>();
+    }
+
+    Eigen::Vector3f get_linear_velocity_m_per_sec() const override
+    {
+        return ukf.getState().get_linear_velocity_m_per_sec().template cast<float>();
+    }
+
+    Eigen::Vector3f get_linear_acceleration_m_per_sec_sqr() const override
+    {
+        return ukf.getState().get_linear_acceleration_m_per_sec_sqr().template cast<float>();
     }
 
     // -- World Quaternion Accessors --
-    inline Eigen::Quaterniond compute_net_world_quaternion() const
+    inline Eigen::Quaternion<T> compute_net_world_quaternion() const
     {
-        const Eigen::Quaterniond error_quaternion= ukf.getState().get_error_quaterniond();
-        const Eigen::Quaterniond output_quaternion = eigen_quaternion_concatenate(world_orientation, error_quaternion).normalized();
+        const Eigen::Quaternion<T> error_quaternion= ukf.getState().get_error_quaternion();
+        const Eigen::Quaternion<T> output_quaternion = eigen_quaternion_concatenate(world_orientation, error_quaternion).normalized();
         return output_quaternion;
     }
 
     // -- World Quaternion Mutators --
-    inline void set_world_quaternion(const Eigen::Quaterniond &orientation)
+    inline void set_world_quaternion(const Eigen::Quaternion<T> &orientation)
     {
         world_orientation = orientation;
-        ukf.getStateMutable().set_error_quaterniond(Eigen::Quaterniond::Identity());
+        ukf.getStateMutable().set_error_quaternion(Eigen::Quaternion<T>::Identity());
     }
 
     void apply_error_to_world_quaternion()
     {
         set_world_quaternion(compute_net_world_quaternion());
     }
+
+    // -- Fixed Lag Rollback --
+    void save_snapshot(int slot) override
+    {
+        KalmanPoseFilterSnapshot<T> &snapshot = snapshots[slot];
+
+        snapshot.bIsValid = bIsValid;
+        snapshot.bSeenPositionMeasurement = bSeenPositionMeasurement;
+        snapshot.bSeenOrientationMeasurement = bSeenOrientationMeasurement;
+        snapshot.system_model = system_model;
+        snapshot.state = ukf.getState();
+        snapshot.covariance_square_root = ukf.getCovarianceSquareRoot();
+        snapshot.time = time;
+        snapshot.world_orientation = world_orientation;
+    }
+
+    void restore_snapshot(int slot) override
+    {
+        const KalmanPoseFilterSnapshot<T> &snapshot = snapshots[slot];
+
+        bIsValid = snapshot.bIsValid;
+        bSeenPositionMeasurement = snapshot.bSeenPositionMeasurement;
+        bSeenOrientationMeasurement = snapshot.bSeenOrientationMeasurement;
+        system_model = snapshot.system_model;
+        ukf.restoreState(snapshot.state, snapshot.covariance_square_root);
+        time = snapshot.time;
+        world_orientation = snapshot.world_orientation;
+    }
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+    void allocate_snapshots(const PoseFilterConstants &constants)
+    {
+        snapshots.resize((constants.fixed_lag_window_seconds > 0.f) ? FIXED_LAG_MAX_HISTORY_COUNT : 0);
+    }
 };
 
-class PointCloudKalmanPoseFilterImpl : public KalmanPoseFilterImpl
+template<typename T>
+class PointCloudKalmanPoseFilterImpl : public KalmanPoseFilterImplT<T>
 {
 public:
 	virtual ~PointCloudKalmanPoseFilterImpl()
@@ -828,22 +982,22 @@ public:
 		cleanup();
 	}
 
-    std::vector<PoseLEDMeasurementModel *> led_measurement_models;
-	PoseOrientationMeasurementModel optical_measurement_model;
+    std::vector<PoseLEDMeasurementModel<T> *> led_measurement_models;
+	PoseOrientationMeasurementModel<T> optical_measurement_model;
 
     void init(const PoseFilterConstants &constants) override
     {
 		cleanup();
 
-        KalmanPoseFilterImpl::init(constants);
+        KalmanPoseFilterImplT<T>::init(constants);
 		for (int led_index = 0; led_index < constants.shape.shape.point_cloud.point_count; ++led_index)
 		{
-			PoseLEDMeasurementModel*led_model = new PoseLEDMeasurementModel();
+			PoseLEDMeasurementModel<T> *led_model = new PoseLEDMeasurementModel<T>();
 
-			led_model->init(constants, led_index, &world_orientation);
+			led_model->init(constants, led_index, &this->world_orientation);
 			led_measurement_models.push_back(led_model);
 		}
-		optical_measurement_model.init(constants.orientation_constants, &world_orientation);
+		optical_measurement_model.init(constants.orientation_constants, &this->world_orientation);
     }
 
     void init(
@@ -853,20 +1007,22 @@ public:
     {
 		cleanup();
 
-        KalmanPoseFilterImpl::init(constants, position, orientation);
+        KalmanPoseFilterImplT<T>::init(constants, position, orientation);
 		for (int led_index = 0; led_index < constants.shape.shape.point_cloud.point_count; ++led_index)
 		{
-			PoseLEDMeasurementModel*led_model = new PoseLEDMeasurementModel();
+			PoseLEDMeasurementModel<T> *led_model = new PoseLEDMeasurementModel<T>();
 
-			led_model->init(constants, led_index, &world_orientation);
+			led_model->init(constants, led_index, &this->world_orientation);
 			led_measurement_models.push_back(led_model);
 		}
-		optical_measurement_model.init(constants.orientation_constants, &world_orientation);
+		optical_measurement_model.init(constants.orientation_constants, &this->world_orientation);
     }
 
+    void update(const PoseFilterConstants &constants, const float delta_time, const PoseFilterPacket &packet) override;
+
 	void cleanup()
 	{
-		for (PoseLEDMeasurementModel *model : led_measurement_models)
+		for (PoseLEDMeasurementModel<T> *model : led_measurement_models)
 		{
 			delete model;
 		}
@@ -874,7 +1030,8 @@ public:
 	}
 };
 
-class MorpheusKalmanPoseFilterImpl : public KalmanPoseFilterImpl
+template<typename T>
+class MorpheusKalmanPoseFilterImpl : public KalmanPoseFilterImplT<T>
 {
 public:
 	virtual ~MorpheusKalmanPoseFilterImpl()
@@ -882,22 +1039,22 @@ public:
 		cleanup();
 	}
 
-	PoseGravMeasurementModel imu_measurement_model;
-	std::vector<PoseLEDMeasurementModel *> led_measurement_models;
-	PoseOrientationMeasurementModel optical_measurement_model;
+	PoseGravMeasurementModel<T> imu_measurement_model;
+	std::vector<PoseLEDMeasurementModel<T> *> led_measurement_models;
+	PoseOrientationMeasurementModel<T> optical_measurement_model;
 
     void init(const PoseFilterConstants &constants) override
     {
-        KalmanPoseFilterImpl::init(constants);
-		imu_measurement_model.init(constants.orientation_constants, &world_orientation);
+        KalmanPoseFilterImplT<T>::init(constants);
+		imu_measurement_model.init(constants.orientation_constants, &this->world_orientation);
 		for (int led_index = 0; led_index < constants.shape.shape.point_cloud.point_count; ++led_index)
 		{
-			PoseLEDMeasurementModel*led_model = new PoseLEDMeasurementModel();
+			PoseLEDMeasurementModel<T> *led_model = new PoseLEDMeasurementModel<T>();
 
-			led_model->init(constants, led_index, &world_orientation);
+			led_model->init(constants, led_index, &this->world_orientation);
 			led_measurement_models.push_back(led_model);
 		}
-		optical_measurement_model.init(constants.orientation_constants, &world_orientation);
+		optical_measurement_model.init(constants.orientation_constants, &this->world_orientation);
 	}
 
     void init(
@@ -905,21 +1062,23 @@ public:
         const Eigen::Vector3f &position,
         const Eigen::Quaternionf &orientation) override
     {
-        KalmanPoseFilterImpl::init(constants, position, orientation);
-		imu_measurement_model.init(constants.orientation_constants, &world_orientation);
+        KalmanPoseFilterImplT<T>::init(constants, position, orientation);
+		imu_measurement_model.init(constants.orientation_constants, &this->world_orientation);
 		for (int led_index = 0; led_index < constants.shape.shape.point_cloud.point_count; ++led_index)
 		{
-			PoseLEDMeasurementModel*led_model = new PoseLEDMeasurementModel();
+			PoseLEDMeasurementModel<T> *led_model = new PoseLEDMeasurementModel<T>();
 
-			led_model->init(constants, led_index, &world_orientation);
+			led_model->init(constants, led_index, &this->world_orientation);
 			led_measurement_models.push_back(led_model);
 		}
-		optical_measurement_model.init(constants.orientation_constants, &world_orientation);
+		optical_measurement_model.init(constants.orientation_constants, &this->world_orientation);
 	}
 
+    void update(const PoseFilterConstants &constants, const float delta_time, const PoseFilterPacket &packet) override;
+
 	void cleanup()
 	{
-		for (PoseLEDMeasurementModel *model : led_measurement_models)
+		for (PoseLEDMeasurementModel<T> *model : led_measurement_models)
 		{
 			delete model;
 		}
@@ -927,18 +1086,19 @@ public:
 	}
 };
 
-class DS4KalmanPoseFilterImpl : public KalmanPoseFilterImpl
+template<typename T>
+class DS4KalmanPoseFilterImpl : public KalmanPoseFilterImplT<T>
 {
 public:
-	PoseGravMeasurementModel imu_measurement_model;
-	PoseOrientationMeasurementModel optical_measurement_model;
+	PoseGravMeasurementModel<T> imu_measurement_model;
+	PoseOrientationMeasurementModel<T> optical_measurement_model;
 
 	void init(
 		const PoseFilterConstants &constants) override
 	{
-        KalmanPoseFilterImpl::init(constants);
-		imu_measurement_model.init(constants.orientation_constants, &world_orientation);
-		optical_measurement_model.init(constants.orientation_constants, &world_orientation);
+        KalmanPoseFilterImplT<T>::init(constants);
+		imu_measurement_model.init(constants.orientation_constants, &this->world_orientation);
+		optical_measurement_model.init(constants.orientation_constants, &this->world_orientation);
 	}
 
 	void init(
@@ -946,24 +1106,27 @@ public:
 		const Eigen::Vector3f &position,
 		const Eigen::Quaternionf &orientation) override
 	{
-        KalmanPoseFilterImpl::init(constants, position, orientation);
-		imu_measurement_model.init(constants.orientation_constants, &world_orientation);
-		optical_measurement_model.init(constants.orientation_constants, &world_orientation);
+        KalmanPoseFilterImplT<T>::init(constants, position, orientation);
+		imu_measurement_model.init(constants.orientation_constants, &this->world_orientation);
+		optical_measurement_model.init(constants.orientation_constants, &this->world_orientation);
 	}
+
+	void update(const PoseFilterConstants &constants, const float delta_time, const PoseFilterPacket &packet) override;
 };
 
-class PSMoveKalmanPoseFilterImpl : public KalmanPoseFilterImpl
+template<typename T>
+class PSMoveKalmanPoseFilterImpl : public KalmanPoseFilterImplT<T>
 {
 public:
-	PoseMagGravMeasurementModel imu_measurement_model;
-	PoseOrientationMeasurementModel optical_measurement_model;
+	PoseMagGravMeasurementModel<T> imu_measurement_model;
+	PoseOrientationMeasurementModel<T> optical_measurement_model;
 
 	void init(
 		const PoseFilterConstants &constants) override
 	{
-        KalmanPoseFilterImpl::init(constants);
-		imu_measurement_model.init(constants.orientation_constants, &world_orientation);
-		optical_measurement_model.init(constants.orientation_constants, &world_orientation);
+        KalmanPoseFilterImplT<T>::init(constants);
+		imu_measurement_model.init(constants.orientation_constants, &this->world_orientation);
+		optical_measurement_model.init(constants.orientation_constants, &this->world_orientation);
 	}
 
 	void init(
@@ -971,16 +1134,110 @@ public:
 		const Eigen::Vector3f &position,
 		const Eigen::Quaternionf &orientation) override
 	{
-        KalmanPoseFilterImpl::init(constants, position, orientation);
-		imu_measurement_model.init(constants.orientation_constants, &world_orientation);
-		optical_measurement_model.init(constants.orientation_constants, &world_orientation);
+        KalmanPoseFilterImplT<T>::init(constants, position, orientation);
+		imu_measurement_model.init(constants.orientation_constants, &this->world_orientation);
+		optical_measurement_model.init(constants.orientation_constants, &this->world_orientation);
 	}
+
+	void update(const PoseFilterConstants &constants, const float delta_time, const PoseFilterPacket &packet) override;
+};
+
+/// Creates the given filter implementation at the precision the constants ask for
+template<template<typename> class t_filter_impl>
+KalmanPoseFilterImpl *allocate_filter_impl(const PoseFilterConstants &constants)
+{
+    if (constants.use_single_precision)
+    {
+        return new t_filter_impl<float>();
+    }
+    else
+    {
+        return new t_filter_impl<double>();
+    }
+}
+
+/// A packet the filter applied.
+/// The filter state from just before it was applied is the filter's snapshot for the entry's slot.
+struct KalmanPoseFilterHistoryEntry
+{
+    std::chrono::time_point<std::chrono::high_resolution_clock> sample_time;
+    float time_step;
+    PoseFilterPacket packet;
+};
+
+/// The recently applied packets in sample time order, oldest first.
+/// Preallocated ring so that recording and replaying packets doesn't allocate.
+class KalmanPoseFilterHistory
+{
+public:
+    KalmanPoseFilterHistory(float window_seconds)
+        : m_entries(FIXED_LAG_MAX_HISTORY_COUNT)
+        , m_window(std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+            std::chrono::duration<float>(window_seconds)))
+        , m_start(0)
+        , m_count(0)
+    {
+    }
+
+    inline void clear() { m_start = 0; m_count = 0; }
+    inline int getCount() const { return m_count; }
+    inline bool getIsFull() const { return m_count >= static_cast<int>(m_entries.size()); }
+
+    /// Where the entry at index is stored, which is also the filter snapshot slot for it
+    inline int getSlot(int index) const
+    {
+        return (m_start + index) % static_cast<int>(m_entries.size());
+    }
+
+    inline KalmanPoseFilterHistoryEntry &at(int index)
+    {
+        return m_entries[getSlot(index)];
+    }
+
+    /// Makes room for an entry at index by moving the newer entries back one slot
+    KalmanPoseFilterHistoryEntry &insert(int index)
+    {
+        assert(!getIsFull() && index >= 0 && index <= m_count);
+
+        for (int move_index = m_count; move_index > index; --move_index)
+        {
+            at(move_index) = at(move_index - 1);
+        }
+        ++m_count;
+
+        return at(index);
+    }
+
+    inline void popOldest()
+    {
+        m_start = (m_start + 1) % m_entries.size();
+        --m_count;
+    }
+
+    /// Forgets the entries that fell out of the lag window.
+    /// Always keeps the newest entry, which the next packet's time step is measured from.
+    void trim()
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> oldest_time = at(m_count - 1).sample_time - m_window;
+
+        while (m_count > 1 && at(0).sample_time < oldest_time)
+        {
+            popOldest();
+        }
+    }
+
+private:
+    std::vector<KalmanPoseFilterHistoryEntry, Eigen::aligned_allocator<KalmanPoseFilterHistoryEntry> > m_entries;
+    std::chrono::high_resolution_clock::duration m_window;
+    int m_start;
+    int m_count;
 };
 
 //-- public interface --
 //-- KalmanPoseFilter --
 KalmanPoseFilter::KalmanPoseFilter()
     : m_filter(nullptr)
+    , m_history(nullptr)
 {
     memset(&m_constants, 0, sizeof(PoseFilterConstants));
 }
@@ -990,7 +1247,13 @@ KalmanPoseFilter::~KalmanPoseFilter()
     if (m_filter != nullptr)
     {
         delete m_filter;
-        m_filter;
+        m_filter = nullptr;
+    }
+
+    if (m_history != nullptr)
+    {
+        delete m_history;
+        m_history = nullptr;
     }
 }
 
@@ -1002,14 +1265,25 @@ bool KalmanPoseFilter::init(const PoseFilterConstants &constants)
     if (m_filter != nullptr)
     {
         delete m_filter;
-        m_filter;
+        m_filter = nullptr;
     }
 
     // Create and initialize the private filter implementation
-    KalmanPoseFilterImpl *filter = new KalmanPoseFilterImpl();
+    KalmanPoseFilterImpl *filter = allocateFilterImpl(constants);
     filter->init(constants);
     m_filter = filter;
 
+    // Create the packet history if late packets get rolled back into the filter
+    if (m_history != nullptr)
+    {
+        delete m_history;
+        m_history = nullptr;
+    }
+    if (constants.fixed_lag_window_seconds > 0.f)
+    {
+        m_history = new KalmanPoseFilterHistory(constants.fixed_lag_window_seconds);
+    }
+
     return true;
 }
 
@@ -1024,14 +1298,25 @@ bool KalmanPoseFilter::init(
     if (m_filter != nullptr)
     {
         delete m_filter;
-        m_filter;
+        m_filter = nullptr;
     }
 
     // Create and initialize the private filter implementation
-    KalmanPoseFilterImpl *filter = new KalmanPoseFilterImpl();
+    KalmanPoseFilterImpl *filter = allocateFilterImpl(constants);
     filter->init(constants, position, orientation);
     m_filter = filter;
 
+    // Create the packet history if late packets get rolled back into the filter
+    if (m_history != nullptr)
+    {
+        delete m_history;
+        m_history = nullptr;
+    }
+    if (constants.fixed_lag_window_seconds > 0.f)
+    {
+        m_history = new KalmanPoseFilterHistory(constants.fixed_lag_window_seconds);
+    }
+
     return true;
 }
 
@@ -1058,12 +1343,80 @@ double KalmanPoseFilter::getTimeInSeconds() const
 void KalmanPoseFilter::resetState()
 {
     m_filter->init(m_constants);
+
+    if (m_history != nullptr)
+    {
+        m_history->clear();
+    }
 }
 
 void KalmanPoseFilter::recenterOrientation(const Eigen::Quaternionf& q_pose)
 {
-    m_filter->world_orientation = q_pose.cast<double>();
-    m_filter->ukf.init(PoseStateVectord::Identity());
+    m_filter->recenter_orientation(q_pose);
+
+    // Rolling back past the recenter would undo it
+    if (m_history != nullptr)
+    {
+        m_history->clear();
+    }
+}
+
+void KalmanPoseFilter::update(const float delta_time, const PoseFilterPacket &packet)
+{
+    // Without a history, or until the filter has a state to roll back to, packets apply in arrival order
+    if (m_history == nullptr || !m_filter->bIsValid)
+    {
+        m_filter->update(m_constants, delta_time, packet);
+        return;
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> sample_time = compute_packet_sample_time(packet);
+
+    if (m_history->getIsFull())
+    {
+        m_history->popOldest();
+    }
+
+    // Find where the packet goes in the timeline. IMU packets almost always go at the end.
+    int insert_index = m_history->getCount();
+    while (insert_index > 0 && sample_time < m_history->at(insert_index - 1).sample_time)
+    {
+        --insert_index;
+    }
+
+    if (insert_index == 0 && m_history->getCount() > 0)
+    {
+        // Older than anything the filter can roll back to,
+        // so apply it now like the filter would without a lag window
+        insert_index = m_history->getCount();
+        sample_time = m_history->at(insert_index - 1).sample_time;
+    }
+    else if (insert_index < m_history->getCount())
+    {
+        // Roll the filter back to just before the first packet newer than this one
+        m_filter->restore_snapshot(m_history->getSlot(insert_index));
+    }
+
+    KalmanPoseFilterHistoryEntry &new_entry = m_history->insert(insert_index);
+    new_entry.sample_time = sample_time;
+    new_entry.packet = packet;
+
+    // Apply the packet, then replay the newer ones on top of it.
+    // Each replay costs one more filter update, so the lag window and history size bound the extra work.
+    for (int entry_index = insert_index; entry_index < m_history->getCount(); ++entry_index)
+    {
+        KalmanPoseFilterHistoryEntry &entry = m_history->at(entry_index);
+
+        entry.time_step =
+            (entry_index > 0)
+            ? compute_time_step(m_history->at(entry_index - 1).sample_time, entry.sample_time)
+            : delta_time;
+
+        m_filter->save_snapshot(m_history->getSlot(entry_index));
+        m_filter->update(m_constants, entry.time_step, entry.packet);
+    }
+
+    m_history->trim();
 }
 
 Eigen::Quaternionf KalmanPoseFilter::getOrientation(float time) const
@@ -1072,7 +1425,7 @@ Eigen::Quaternionf KalmanPoseFilter::getOrientation(float time) const
 
     if (m_filter->bIsValid)
     {
-        const Eigen::Quaternionf state_orientation = m_filter->compute_net_world_quaternion().cast<float>();
+        const Eigen::Quaternionf state_orientation = m_filter->get_world_orientation();
         Eigen::Quaternionf predicted_orientation = state_orientation;
 
         if (fabsf(time) > k_real_epsilon)
@@ -1109,8 +1462,8 @@ Eigen::Vector3f KalmanPoseFilter::getPositionCm(float time) const
 
     if (m_filter->bIsValid)
     {
-        Eigen::Vector3f state_position_meters= m_filter->ukf.getState().get_position_meters().cast<float>();
-		Eigen::Vector3f state_velocity_m_per_sec = m_filter->ukf.getState().get_linear_velocity_m_per_sec().cast<float>();
+        Eigen::Vector3f state_position_meters= m_filter->get_position_meters();
+		Eigen::Vector3f state_velocity_m_per_sec = m_filter->get_linear_velocity_m_per_sec();
         Eigen::Vector3f predicted_position =
             is_nearly_zero(time)
             ? state_position_meters
@@ -1124,58 +1477,41 @@ Eigen::Vector3f KalmanPoseFilter::getPositionCm(float time) const
 
 Eigen::Vector3f KalmanPoseFilter::getVelocityCmPerSec() const
 {
-	Eigen::Vector3d vel= m_filter->ukf.getState().get_linear_velocity_m_per_sec() * k_meters_to_centimeters;
+	Eigen::Vector3f vel= m_filter->get_linear_velocity_m_per_sec() * k_meters_to_centimeters;
 
-    return vel.cast<float>();
+    return vel;
 }
 
 Eigen::Vector3f KalmanPoseFilter::getAccelerationCmPerSecSqr() const
 {
-    Eigen::Vector3d accel= m_filter->ukf.getState().get_linear_acceleration_m_per_sec_sqr() * k_meters_to_centimeters;
+    Eigen::Vector3f accel= m_filter->get_linear_acceleration_m_per_sec_sqr() * k_meters_to_centimeters;
 
-	return accel.cast<float>();
+	return accel;
 }
 
-//-- KalmanPoseFilterPointCloud --
-bool KalmanPoseFilterPointCloud::init(const PoseFilterConstants &constants)
+bool KalmanPoseFilter::getIsFusingAtCaptureTime() const
 {
-    KalmanPoseFilter::init(constants);
-
-    PointCloudKalmanPoseFilterImpl *filter = new PointCloudKalmanPoseFilterImpl();
-    filter->init(constants);
-    m_filter = filter;
-
-    return true;
+    return m_history != nullptr;
 }
 
-bool KalmanPoseFilterPointCloud::init(
-    const PoseFilterConstants &constants,
-    const Eigen::Vector3f &position,
-    const Eigen::Quaternionf &orientation)
+//-- KalmanPoseFilterPointCloud --
+KalmanPoseFilterImpl *KalmanPoseFilterPointCloud::allocateFilterImpl(const PoseFilterConstants &constants) const
 {
-    KalmanPoseFilter::init(constants);
-
-    PointCloudKalmanPoseFilterImpl *filter = new PointCloudKalmanPoseFilterImpl();
-    filter->init(constants, position, orientation);
-    m_filter = filter;
-
-    return true;
+	return allocate_filter_impl<PointCloudKalmanPoseFilterImpl>(constants);
 }
 
-void KalmanPoseFilterPointCloud::update(const float delta_time, const PoseFilterPacket &packet)
+template<typename T>
+void PointCloudKalmanPoseFilterImpl<T>::update(const PoseFilterConstants &constants, const float delta_time, const PoseFilterPacket &packet)
 {
-    if (m_filter->bIsValid)
+    if (this->bIsValid)
     {
-        PointCloudKalmanPoseFilterImpl *filter = static_cast<PointCloudKalmanPoseFilterImpl *>(m_filter);
-		PoseOrientationMeasurementModel &optical_measurement_model = filter->optical_measurement_model;
-
         // Adjust the amount we trust the process model based on the total tracking projection area
-        filter->system_model.update_process_noise(
-			m_constants, 
+        this->system_model.update_process_noise(
+			constants, 
 			packet.tracking_projection_area_px_sqr);
 
         // Predict state for current time-step using the filters
-        filter->system_model.set_time_step(delta_time);
+        this->system_model.set_time_step(delta_time);
 
 		// Snap filter state if we haven't seen an optical measurement before
 		if (packet.has_optical_measurement())
@@ -1183,42 +1519,42 @@ void KalmanPoseFilterPointCloud::update(const float delta_time, const PoseFilter
 			assert(packet.tracking_projection_area_px_sqr > 0.f);
 
 			// If this is the first time we have seen the position, snap the position state
-			if (!m_filter->bSeenPositionMeasurement)
+			if (!this->bSeenPositionMeasurement)
 			{
-				const Eigen::Vector3d optical_position_meters = packet.get_optical_position_in_meters().cast<double>();
+				const PoseVector3<T> optical_position_meters = packet.get_optical_position_in_meters().cast<T>();
 
-				m_filter->ukf.getStateMutable().set_position_meters(optical_position_meters);
-				m_filter->bSeenPositionMeasurement = true;
+				this->ukf.getStateMutable().set_position_meters(optical_position_meters);
+				this->bSeenPositionMeasurement = true;
 			}
 
 			// If this is the first time we have seen the orientation, snap the orientation state
-			if (!m_filter->bSeenOrientationMeasurement)
+			if (!this->bSeenOrientationMeasurement)
 			{
-				const Eigen::Quaterniond world_quaternion = packet.optical_orientation.cast<double>();
+				const Eigen::Quaternion<T> world_quaternion = packet.optical_orientation.cast<T>();
 
-				filter->set_world_quaternion(world_quaternion);
-				m_filter->bSeenOrientationMeasurement = true;
+				this->set_world_quaternion(world_quaternion);
+				this->bSeenOrientationMeasurement = true;
 			}
 		}
 
 		// Apply a physics update to the filter state
 		if (packet.has_imu_measurements())
 		{
-			PoseControlVectord control;
-			control.set_angular_rates(packet.imu_gyroscope_rad_per_sec.cast<double>());
+			PoseControlVector<T> control;
+			control.set_angular_rates(packet.imu_gyroscope_rad_per_sec.cast<T>());
 
-			filter->ukf.predict(filter->system_model, control);
+			this->ukf.predict(this->system_model, control);
 		}
 		else
 		{
-			filter->ukf.predict(filter->system_model);
+			this->ukf.predict(this->system_model);
 		}
 
 		// Apply any optical measurement to the filter
 		if (packet.has_optical_measurement())
 		{
 			assert(packet.tracking_projection_area_px_sqr > 0.f);
-			const Eigen::Quaterniond world_quaternion = packet.optical_orientation.cast<double>();
+			const Eigen::Quaternion<T> world_quaternion = packet.optical_orientation.cast<T>();
 
 			//TODO: Port over point area and shape point index
 			//for (int model_led_index = 0; model_led_index < packet.optical_tracking_shape_cm.shape.pointcloud.point_count; ++model_led_index)
@@ -1231,80 +1567,57 @@ void KalmanPoseFilterPointCloud::update(const float delta_time, const PoseFilter
 			//	{
 			//		const PSVRVector3f &p = packet.optical_tracking_shape_cm.shape.pointcloud.points[model_led_index];
 			//		
-			//		PoseLEDMeasurementModel *led_model= filter->led_measurement_models[model_led_index];
-			//		led_model->updateMeasurementCovariance(m_constants, led_screen_area);
+			//		PoseLEDMeasurementModel<T> *led_model= this->led_measurement_models[model_led_index];
+			//		led_model->updateMeasurementCovariance(constants, led_screen_area);
 
-			//		PoseLEDMeasurementVectord led_measurement = PoseLEDMeasurementVectord::Zero();
+			//		PoseLEDMeasurementVector<T> led_measurement = PoseLEDMeasurementVector<T>::Zero();
 			//		led_measurement.set_LED_position_meters(
-			//			Eigen::Vector3d(
-			//				static_cast<double>(p.x * k_centimeters_to_meters), 
-			//				static_cast<double>(p.y * k_centimeters_to_meters),
-			//				static_cast<double>(p.z * k_centimeters_to_meters)));
+			//			PoseVector3<T>(
+			//				static_cast<T>(p.x * k_centimeters_to_meters), 
+			//				static_cast<T>(p.y * k_centimeters_to_meters),
+			//				static_cast<T>(p.z * k_centimeters_to_meters)));
 
-			//		filter->ukf.update(*led_model, led_measurement);
+			//		this->ukf.update(*led_model, led_measurement);
 			//	}
 			//}
 
-			PoseOrientationMeasurementVectord measurement = PoseOrientationMeasurementVectord::Zero();
-			measurement.set_optical_quaterniond(world_quaternion);
-			filter->ukf.update(optical_measurement_model, measurement);
+			PoseOrientationMeasurementVector<T> measurement = PoseOrientationMeasurementVector<T>::Zero();
+			measurement.set_optical_quaternion(world_quaternion);
+			this->ukf.update(optical_measurement_model, measurement);
 		}
 
         // Apply the orientation error in the UKF state to the output quaternion.
         // Zero out the error in the UKF state vector.
-        filter->apply_error_to_world_quaternion();
+        this->apply_error_to_world_quaternion();
 
-        filter->time+= (double)delta_time;
+        this->time+= (double)delta_time;
     }
     else
     {
-        m_filter->ukf.init(PoseStateVectord::Identity());
-        m_filter->time= 0.0;
-        m_filter->bIsValid = true;
+        this->ukf.init(PoseStateVector<T>::Identity());
+        this->time= 0.0;
+        this->bIsValid = true;
     }
 }
 
 //-- KalmanPoseFilterMorpheus --
-bool KalmanPoseFilterMorpheus::init(const PoseFilterConstants &constants)
+KalmanPoseFilterImpl *KalmanPoseFilterMorpheus::allocateFilterImpl(const PoseFilterConstants &constants) const
 {
-    KalmanPoseFilter::init(constants);
-
-    MorpheusKalmanPoseFilterImpl *filter = new MorpheusKalmanPoseFilterImpl();
-    filter->init(constants);
-    m_filter = filter;
-
-    return true;
+	return allocate_filter_impl<MorpheusKalmanPoseFilterImpl>(constants);
 }
 
-bool KalmanPoseFilterMorpheus::init(
-    const PoseFilterConstants &constants,
-    const Eigen::Vector3f &position,
-    const Eigen::Quaternionf &orientation)
-{
-    KalmanPoseFilter::init(constants);
-
-    MorpheusKalmanPoseFilterImpl *filter = new MorpheusKalmanPoseFilterImpl();
-    filter->init(constants, position, orientation);
-    m_filter = filter;
-
-    return true;
-}
-
-void KalmanPoseFilterMorpheus::update(const float delta_time, const PoseFilterPacket &packet)
+template<typename T>
+void MorpheusKalmanPoseFilterImpl<T>::update(const PoseFilterConstants &constants, const float delta_time, const PoseFilterPacket &packet)
 {
-	if (m_filter->bIsValid)
+	if (this->bIsValid)
 	{
-		MorpheusKalmanPoseFilterImpl *filter = static_cast<MorpheusKalmanPoseFilterImpl *>(m_filter);
-		PoseOrientationMeasurementModel &optical_measurement_model = filter->optical_measurement_model;
-		PoseGravMeasurementModel &imu_measurement_model= filter->imu_measurement_model;
-
 		// Adjust the amount we trust the process model based on the tracking projection area
-		filter->system_model.update_process_noise(
-			m_constants,
+		this->system_model.update_process_noise(
+			constants,
 			packet.tracking_projection_area_px_sqr);
 
 		// Predict state for current time-step using the filters
-		filter->system_model.set_time_step(delta_time);
+		this->system_model.set_time_step(delta_time);
 
 		// Snap filter state if we haven't seen an optical measurement before
 		if (packet.has_optical_measurement())
@@ -1312,42 +1625,42 @@ void KalmanPoseFilterMorpheus::update(const float delta_time, const PoseFilterPa
 			assert(packet.tracking_projection_area_px_sqr > 0.f);
 
 			// If this is the first time we have seen the position, snap the position state
-			if (!m_filter->bSeenPositionMeasurement)
+			if (!this->bSeenPositionMeasurement)
 			{
-				const Eigen::Vector3d optical_position_meters = packet.get_optical_position_in_meters().cast<double>();
+				const PoseVector3<T> optical_position_meters = packet.get_optical_position_in_meters().cast<T>();
 
-				m_filter->ukf.getStateMutable().set_position_meters(optical_position_meters);
-				m_filter->bSeenPositionMeasurement = true;
+				this->ukf.getStateMutable().set_position_meters(optical_position_meters);
+				this->bSeenPositionMeasurement = true;
 			}
 
 			// If this is the first time we have seen the orientation, snap the orientation state
-			if (!m_filter->bSeenOrientationMeasurement)
+			if (!this->bSeenOrientationMeasurement)
 			{
-				const Eigen::Quaterniond world_quaternion = packet.optical_orientation.cast<double>();
+				const Eigen::Quaternion<T> world_quaternion = packet.optical_orientation.cast<T>();
 
-				filter->set_world_quaternion(world_quaternion);
-				m_filter->bSeenOrientationMeasurement = true;
+				this->set_world_quaternion(world_quaternion);
+				this->bSeenOrientationMeasurement = true;
 			}
 		}
 
 		// Apply a physics update to the filter state
 		if (packet.has_imu_measurements())
 		{
-			PoseControlVectord control;
-			control.set_angular_rates(packet.imu_gyroscope_rad_per_sec.cast<double>());
+			PoseControlVector<T> control;
+			control.set_angular_rates(packet.imu_gyroscope_rad_per_sec.cast<T>());
 
-			filter->ukf.predict(filter->system_model, control);
+			this->ukf.predict(this->system_model, control);
 		}
 		else
 		{
-			filter->ukf.predict(filter->system_model);
+			this->ukf.predict(this->system_model);
 		}
 
 		// Apply any optical measurement to the filter
 		if (packet.has_optical_measurement())
 		{
 			assert(packet.tracking_projection_area_px_sqr > 0.f);
-			const Eigen::Quaterniond world_quaternion = packet.optical_orientation.cast<double>();
+			const Eigen::Quaternion<T> world_quaternion = packet.optical_orientation.cast<T>();
 
 			//TODO: Port over point area and shape point index
 			//for (int model_led_index = 0; model_led_index < packet.optical_tracking_shape_cm.shape.pointcloud.point_count; ++model_led_index)
@@ -1361,23 +1674,23 @@ void KalmanPoseFilterMorpheus::update(const float delta_time, const PoseFilterPa
 			//		const PSVRVector3f &p = packet.optical_tracking_shape_cm.shape.pointcloud.points[model_led_index];
 
 			//		// Update parameters on the LED model before applying the measurement
-			//		PoseLEDMeasurementModel *led_model = filter->led_measurement_models[model_led_index];
-			//		led_model->updateMeasurementCovariance(m_constants, led_screen_area);
+			//		PoseLEDMeasurementModel<T> *led_model = this->led_measurement_models[model_led_index];
+			//		led_model->updateMeasurementCovariance(constants, led_screen_area);
 
-			//		PoseLEDMeasurementVectord led_measurement = PoseLEDMeasurementVectord::Zero();
+			//		PoseLEDMeasurementVector<T> led_measurement = PoseLEDMeasurementVector<T>::Zero();
 			//		led_measurement.set_LED_position_meters(
-			//			Eigen::Vector3d(
-			//				static_cast<double>(p.x * k_centimeters_to_meters),
-			//				static_cast<double>(p.y * k_centimeters_to_meters),
-			//				static_cast<double>(p.z * k_centimeters_to_meters)));
+			//			PoseVector3<T>(
+			//				static_cast<T>(p.x * k_centimeters_to_meters),
+			//				static_cast<T>(p.y * k_centimeters_to_meters),
+			//				static_cast<T>(p.z * k_centimeters_to_meters)));
 
-			//		filter->ukf.update(*led_model, led_measurement);
+			//		this->ukf.update(*led_model, led_measurement);
 			//	}
 			//}
 
-			PoseOrientationMeasurementVectord measurement = PoseOrientationMeasurementVectord::Zero();
-			measurement.set_optical_quaterniond(world_quaternion);
-			filter->ukf.update(optical_measurement_model, measurement);
+			PoseOrientationMeasurementVector<T> measurement = PoseOrientationMeasurementVector<T>::Zero();
+			measurement.set_optical_quaternion(world_quaternion);
+			this->ukf.update(optical_measurement_model, measurement);
 		}
 
 		// Apply any IMU measurement to the filter
@@ -1385,66 +1698,42 @@ void KalmanPoseFilterMorpheus::update(const float delta_time, const PoseFilterPa
 		{
 			assert(packet.has_accelerometer_measurement);
 
-			PoseGravMeasurementVectord measurement = PoseGravMeasurementVectord::Zero();
-			measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<double>());
-			filter->ukf.update(filter->imu_measurement_model, measurement);
+			PoseGravMeasurementVector<T> measurement = PoseGravMeasurementVector<T>::Zero();
+			measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<T>());
+			this->ukf.update(this->imu_measurement_model, measurement);
 		}
 
 		// Apply the orientation error in the UKF state to the output quaternion.
 		// Zero out the error in the UKF state vector.
-		filter->apply_error_to_world_quaternion();
-		filter->time += (double)delta_time;
+		this->apply_error_to_world_quaternion();
+		this->time += (double)delta_time;
 	}
 	else
 	{
-		m_filter->ukf.init(PoseStateVectord::Identity());
-		m_filter->time = 0.0;
-		m_filter->bIsValid = true;
+		this->ukf.init(PoseStateVector<T>::Identity());
+		this->time = 0.0;
+		this->bIsValid = true;
 	}
 }
 
 //-- KalmanPoseFilterDS4 --
-bool KalmanPoseFilterDS4::init(
-	const PoseFilterConstants &constants)
+KalmanPoseFilterImpl *KalmanPoseFilterDS4::allocateFilterImpl(const PoseFilterConstants &constants) const
 {
-	KalmanPoseFilter::init(constants);
-
-	DS4KalmanPoseFilterImpl *filter = new DS4KalmanPoseFilterImpl();
-	filter->init(constants);
-	m_filter = filter;
-
-	return true;
-}
-
-bool KalmanPoseFilterDS4::init(
-	const PoseFilterConstants &constants,
-	const Eigen::Vector3f &position, 
-	const Eigen::Quaternionf &orientation)
-{
-    KalmanPoseFilter::init(constants, position, orientation);
-
-    DS4KalmanPoseFilterImpl *filter = new DS4KalmanPoseFilterImpl();
-    filter->init(constants, position, orientation);
-    m_filter = filter;
-
-    return true;
+	return allocate_filter_impl<DS4KalmanPoseFilterImpl>(constants);
 }
 
-void KalmanPoseFilterDS4::update(const float delta_time, const PoseFilterPacket &packet)
+template<typename T>
+void DS4KalmanPoseFilterImpl<T>::update(const PoseFilterConstants &constants, const float delta_time, const PoseFilterPacket &packet)
 {
-	if (m_filter->bIsValid)
+	if (this->bIsValid)
 	{
-		DS4KalmanPoseFilterImpl *filter = static_cast<DS4KalmanPoseFilterImpl *>(m_filter);
-		PoseOrientationMeasurementModel &optical_measurement_model = filter->optical_measurement_model;
-		PoseGravMeasurementModel &imu_measurement_model= filter->imu_measurement_model;
-
 		// Adjust the amount we trust the process model based on the tracking projection area
-		filter->system_model.update_process_noise(
-			m_constants,
+		this->system_model.update_process_noise(
+			constants,
 			packet.tracking_projection_area_px_sqr);
 
 		// Predict state for current time-step using the filters
-		filter->system_model.set_time_step(delta_time);
+		this->system_model.set_time_step(delta_time);
 
 		// Snap filter state if we haven't seen an optical measurement before
 		if (packet.has_optical_measurement())
@@ -1452,45 +1741,45 @@ void KalmanPoseFilterDS4::update(const float delta_time, const PoseFilterPacket
 			assert(packet.tracking_projection_area_px_sqr > 0.f);
 
 			// If this is the first time we have seen the position, snap the position state
-			if (!m_filter->bSeenPositionMeasurement)
+			if (!this->bSeenPositionMeasurement)
 			{
-				const Eigen::Vector3d optical_position_meters = packet.get_optical_position_in_meters().cast<double>();
+				const PoseVector3<T> optical_position_meters = packet.get_optical_position_in_meters().cast<T>();
 
-				m_filter->ukf.getStateMutable().set_position_meters(optical_position_meters);
-				m_filter->bSeenPositionMeasurement = true;
+				this->ukf.getStateMutable().set_position_meters(optical_position_meters);
+				this->bSeenPositionMeasurement = true;
 			}
 
 			// If this is the first time we have seen the orientation, snap the orientation state
-			if (!m_filter->bSeenOrientationMeasurement)
+			if (!this->bSeenOrientationMeasurement)
 			{
-				const Eigen::Quaterniond world_quaternion = packet.optical_orientation.cast<double>();
+				const Eigen::Quaternion<T> world_quaternion = packet.optical_orientation.cast<T>();
 
-				filter->set_world_quaternion(world_quaternion);
-				m_filter->bSeenOrientationMeasurement = true;
+				this->set_world_quaternion(world_quaternion);
+				this->bSeenOrientationMeasurement = true;
 			}
 		}
 
 		// Apply a physics update to the filter state
 		if (packet.has_imu_measurements())
 		{
-			PoseControlVectord control;
-			control.set_angular_rates(packet.imu_gyroscope_rad_per_sec.cast<double>());
+			PoseControlVector<T> control;
+			control.set_angular_rates(packet.imu_gyroscope_rad_per_sec.cast<T>());
 
-			filter->ukf.predict(filter->system_model, control);
+			this->ukf.predict(this->system_model, control);
 		}
 		else
 		{
-			filter->ukf.predict(filter->system_model);
+			this->ukf.predict(this->system_model);
 		}
 
 		// Apply any optical measurement to the filter
 		if (packet.has_optical_measurement())
 		{
 			assert(packet.tracking_projection_area_px_sqr > 0.f);
-			const Eigen::Quaterniond world_quaternion = packet.optical_orientation.cast<double>();
-			PoseOrientationMeasurementVectord measurement = PoseOrientationMeasurementVectord::Zero();
-			measurement.set_optical_quaterniond(world_quaternion);
-			filter->ukf.update(optical_measurement_model, measurement);
+			const Eigen::Quaternion<T> world_quaternion = packet.optical_orientation.cast<T>();
+			PoseOrientationMeasurementVector<T> measurement = PoseOrientationMeasurementVector<T>::Zero();
+			measurement.set_optical_quaternion(world_quaternion);
+			this->ukf.update(optical_measurement_model, measurement);
 		}
 
 		// Apply any IMU measurement to the filter
@@ -1498,66 +1787,42 @@ void KalmanPoseFilterDS4::update(const float delta_time, const PoseFilterPacket
 		{
 			assert(packet.has_accelerometer_measurement);
 
-			PoseGravMeasurementVectord measurement = PoseGravMeasurementVectord::Zero();
-			measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<double>());
-			filter->ukf.update(filter->imu_measurement_model, measurement);
+			PoseGravMeasurementVector<T> measurement = PoseGravMeasurementVector<T>::Zero();
+			measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<T>());
+			this->ukf.update(this->imu_measurement_model, measurement);
 		}
 
 		// Apply the orientation error in the UKF state to the output quaternion.
 		// Zero out the error in the UKF state vector.
-		filter->apply_error_to_world_quaternion();
-		filter->time += (double)delta_time;
+		this->apply_error_to_world_quaternion();
+		this->time += (double)delta_time;
 	}
 	else
 	{
-		m_filter->ukf.init(PoseStateVectord::Identity());
-		m_filter->time = 0.0;
-		m_filter->bIsValid = true;
+		this->ukf.init(PoseStateVector<T>::Identity());
+		this->time = 0.0;
+		this->bIsValid = true;
 	}
 }
 
 //-- PSMovePoseKalmanFilter --
-bool KalmanPoseFilterPSMove::init(
-	const PoseFilterConstants &constants)
+KalmanPoseFilterImpl *KalmanPoseFilterPSMove::allocateFilterImpl(const PoseFilterConstants &constants) const
 {
-	KalmanPoseFilter::init(constants);
-
-	PSMoveKalmanPoseFilterImpl *filter = new PSMoveKalmanPoseFilterImpl();
-	filter->init(constants);
-	m_filter = filter;
-
-	return true;
+	return allocate_filter_impl<PSMoveKalmanPoseFilterImpl>(constants);
 }
 
-bool KalmanPoseFilterPSMove::init(
-	const PoseFilterConstants &constants,
-	const Eigen::Vector3f &position,
-	const Eigen::Quaternionf &orientation)
-{
-    KalmanPoseFilter::init(constants, position, orientation);
-
-    PSMoveKalmanPoseFilterImpl *filter = new PSMoveKalmanPoseFilterImpl();
-    filter->init(constants, position, orientation);
-    m_filter = filter;
-
-    return true;
-}
-
-void KalmanPoseFilterPSMove::update(const float delta_time, const PoseFilterPacket &packet)
+template<typename T>
+void PSMoveKalmanPoseFilterImpl<T>::update(const PoseFilterConstants &constants, const float delta_time, const PoseFilterPacket &packet)
 {
-	if (m_filter->bIsValid)
+	if (this->bIsValid)
 	{
-		PSMoveKalmanPoseFilterImpl *filter = static_cast<PSMoveKalmanPoseFilterImpl *>(m_filter);
-		PoseOrientationMeasurementModel &optical_measurement_model = filter->optical_measurement_model;
-		PoseMagGravMeasurementModel &imu_measurement_model= filter->imu_measurement_model;
-
 		// Adjust the amount we trust the process model based on the tracking projection area
-		filter->system_model.update_process_noise(
-			m_constants,
+		this->system_model.update_process_noise(
+			constants,
 			packet.tracking_projection_area_px_sqr);
 
 		// Predict state for current time-step using the filters
-		filter->system_model.set_time_step(delta_time);
+		this->system_model.set_time_step(delta_time);
 
 		// Snap filter state if we haven't seen an optical measurement before
 		if (packet.has_optical_measurement())
@@ -1565,45 +1830,45 @@ void KalmanPoseFilterPSMove::update(const float delta_time, const PoseFilterPack
 			assert(packet.tracking_projection_area_px_sqr > 0.f);
 
 			// If this is the first time we have seen the position, snap the position state
-			if (!m_filter->bSeenPositionMeasurement)
+			if (!this->bSeenPositionMeasurement)
 			{
-				const Eigen::Vector3d optical_position_meters = packet.get_optical_position_in_meters().cast<double>();
+				const PoseVector3<T> optical_position_meters = packet.get_optical_position_in_meters().cast<T>();
 
-				m_filter->ukf.getStateMutable().set_position_meters(optical_position_meters);
-				m_filter->bSeenPositionMeasurement = true;
+				this->ukf.getStateMutable().set_position_meters(optical_position_meters);
+				this->bSeenPositionMeasurement = true;
 			}
 
 			// If this is the first time we have seen the orientation, snap the orientation state
-			if (!m_filter->bSeenOrientationMeasurement)
+			if (!this->bSeenOrientationMeasurement)
 			{
-				const Eigen::Quaterniond world_quaternion = packet.optical_orientation.cast<double>();
+				const Eigen::Quaternion<T> world_quaternion = packet.optical_orientation.cast<T>();
 
-				filter->set_world_quaternion(world_quaternion);
-				m_filter->bSeenOrientationMeasurement = true;
+				this->set_world_quaternion(world_quaternion);
+				this->bSeenOrientationMeasurement = true;
 			}
 		}
 
 		// Apply a physics update to the filter state
 		if (packet.has_imu_measurements())
 		{
-			PoseControlVectord control;
-			control.set_angular_rates(packet.imu_gyroscope_rad_per_sec.cast<double>());
+			PoseControlVector<T> control;
+			control.set_angular_rates(packet.imu_gyroscope_rad_per_sec.cast<T>());
 
-			filter->ukf.predict(filter->system_model, control);
+			this->ukf.predict(this->system_model, control);
 		}
 		else
 		{
-			filter->ukf.predict(filter->system_model);
+			this->ukf.predict(this->system_model);
 		}
 
 		// Apply any optical measurement to the filter
 		if (packet.has_optical_measurement())
 		{
 			assert(packet.tracking_projection_area_px_sqr > 0.f);
-			const Eigen::Quaterniond world_quaternion = packet.optical_orientation.cast<double>();
-			PoseOrientationMeasurementVectord measurement = PoseOrientationMeasurementVectord::Zero();
-			measurement.set_optical_quaterniond(world_quaternion);
-			filter->ukf.update(optical_measurement_model, measurement);
+			const Eigen::Quaternion<T> world_quaternion = packet.optical_orientation.cast<T>();
+			PoseOrientationMeasurementVector<T> measurement = PoseOrientationMeasurementVector<T>::Zero();
+			measurement.set_optical_quaternion(world_quaternion);
+			this->ukf.update(optical_measurement_model, measurement);
 		}
 
 		// Apply any IMU measurement to the filter
@@ -1611,22 +1876,22 @@ void KalmanPoseFilterPSMove::update(const float delta_time, const PoseFilterPack
 		{
 			assert(packet.has_accelerometer_measurement);
 
-			PoseMagGravMeasurementVectord measurement = PoseMagGravMeasurementVectord::Zero();
-			measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<double>());
-			measurement.set_magnetometer(packet.imu_magnetometer_unit.cast<double>());
-			filter->ukf.update(filter->imu_measurement_model, measurement);
+			PoseMagGravMeasurementVector<T> measurement = PoseMagGravMeasurementVector<T>::Zero();
+			measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<T>());
+			measurement.set_magnetometer(packet.imu_magnetometer_unit.cast<T>());
+			this->ukf.update(this->imu_measurement_model, measurement);
 		}
 
 		// Apply the orientation error in the UKF state to the output quaternion.
 		// Zero out the error in the UKF state vector.
-		filter->apply_error_to_world_quaternion();
-		filter->time += (double)delta_time;
+		this->apply_error_to_world_quaternion();
+		this->time += (double)delta_time;
 	}
 	else
 	{
-		m_filter->ukf.init(PoseStateVectord::Identity());
-		m_filter->time = 0.0;
-		m_filter->bIsValid = true;
+		this->ukf.init(PoseStateVector<T>::Identity());
+		this->time = 0.0;
+		this->bIsValid = true;
 	}
 }
 
@@ -1674,4 +1939,51 @@ void Q_discrete_3rd_order_white_noise(
     Q(i+0,i+0) = 0.25*q4; Q(i+0,i+1) = 0.5*q3; Q(i+0,i+2) = 0.5*q2;
     Q(i+1,i+0) =  0.5*q3; Q(i+1,i+1) =     q2; Q(i+1,i+2) =     q1;
     Q(i+2,i+0) =  0.5*q2; Q(i+2,i+1) =     q1; Q(i+2,i+2) =    1.0;
-}
\ No newline at end of file
+}
+
+// Optical packets are posted once the multicam pose is triangulated, 
+// but the camera exposed the frame the pipeline latency before that
+static std::chrono::time_point<std::chrono::high_resolution_clock> compute_packet_sample_time(
+    const PoseFilterPacket &packet)
+{
+    const PipelineStageTimes &stage_times = packet.stage_times;
+
+    if (packet.has_optical_measurement() && !packet.has_imu_measurements() &&
+        stage_times.capture_us != 0 && stage_times.triangulation_done_us > stage_times.capture_us)
+    {
+        return packet.timestamp - std::chrono::microseconds(stage_times.triangulation_done_us - stage_times.capture_us);
+    }
+
+    return packet.timestamp;
+}
+
+// Time between two packets in the fixed lag timeline, in seconds
+static float compute_time_step(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &previous_sample_time,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &sample_time)
+{
+    const std::chrono::duration<float> time_step = sample_time - previous_sample_time;
+
+    return clampf(time_step.count(), 0.f, FIXED_LAG_MAX_TIME_STEP);
+}
+
+// Overloads so the templated models pick the math helper matching their precision
+static Eigen::Vector3f pose_clockwise_rotate(const Eigen::Quaternionf &q, const Eigen::Vector3f &v)
+{
+    return eigen_vector3f_clockwise_rotate(q, v);
+}
+
+static Eigen::Vector3d pose_clockwise_rotate(const Eigen::Quaterniond &q, const Eigen::Vector3d &v)
+{
+    return eigen_vector3d_clockwise_rotate(q, v);
+}
+
+static Eigen::Quaternionf pose_angular_velocity_to_quaternion_derivative(const Eigen::Quaternionf &q, const Eigen::Vector3f &ang_vel)
+{
+    return eigen_angular_velocity_to_quaternion_derivative(q, ang_vel);
+}
+
+static Eigen::Quaterniond pose_angular_velocity_to_quaternion_derivative(const Eigen::Quaterniond &q, const Eigen::Vector3d &ang_vel)
+{
+    return eigen_angular_velocity_to_quaterniond_derivative(q, ang_vel);
+}
@@ -18,6 +18,9 @@ public:
 	// -- IStateFilter --
 	bool getIsStateValid() const override;
     double getTimeInSeconds() const override;
+    /// Applies the packet at the time it was sampled. When the fixed lag window is on, a late optical packet
+    /// rolls the filter back to its capture time and the newer packets get replayed on top of it.
+    void update(const float delta_time, const PoseFilterPacket &packet) override;
 	void resetState() override;
 	void recenterOrientation(const Eigen::Quaternionf& q_pose) override;
 
@@ -46,49 +49,44 @@ public:
     /// Get the current velocity of the filter state (cm/s^2)
     Eigen::Vector3f getAccelerationCmPerSecSqr() const override;
 
+    /// True when the fixed lag window is on
+    bool getIsFusingAtCaptureTime() const override;
+
 protected:
+    /// Creates the device specific filter implementation, at the precision the constants ask for
+    virtual class KalmanPoseFilterImpl *allocateFilterImpl(const PoseFilterConstants &constant) const = 0;
+
 	PoseFilterConstants m_constants;
 	class KalmanPoseFilterImpl *m_filter;
+	class KalmanPoseFilterHistory *m_history; // null when the fixed lag window is off
 };
 
 /// Kalman Pose filter for Optical Point Cloud
 class KalmanPoseFilterPointCloud : public KalmanPoseFilter
 {
-public:
-	bool init(const PoseFilterConstants &constant) override;
-	bool init(const PoseFilterConstants &constant, 
-              const Eigen::Vector3f &initial_position,
-              const Eigen::Quaternionf &initial_orientation) override;
-	void update(const float delta_time, const PoseFilterPacket &packet) override;
+protected:
+	class KalmanPoseFilterImpl *allocateFilterImpl(const PoseFilterConstants &constant) const override;
 };
 
 /// Kalman Pose filter for Optical Point Cloud + Angular Rate(Gyroscope) + Gravity(Accelerometer)
 class KalmanPoseFilterMorpheus : public KalmanPoseFilter
 {
-public:
-	bool init(const PoseFilterConstants &constant) override;
-	bool init(const PoseFilterConstants &constant, 
-              const Eigen::Vector3f &initial_position,
-              const Eigen::Quaternionf &initial_orientation) override;
-	void update(const float delta_time, const PoseFilterPacket &packet) override;
+protected:
+	class KalmanPoseFilterImpl *allocateFilterImpl(const PoseFilterConstants &constant) const override;
 };
 
 /// Kalman Pose filter for Optical Pose + Angular Rate(Gyroscope) + Gravity(Accelerometer)
 class KalmanPoseFilterDS4 : public KalmanPoseFilter
 {
-public:
-	bool init(const PoseFilterConstants &constant) override;
-	bool init(const PoseFilterConstants &constant, const Eigen::Vector3f &position, const Eigen::Quaternionf &orientation) override;
-	void update(const float delta_time, const PoseFilterPacket &packet) override;
+protected:
+	class KalmanPoseFilterImpl *allocateFilterImpl(const PoseFilterConstants &constant) const override;
 };
 
 /// Kalman Pose filter for Optical Position + Magnetometer + Angular Rate(Gyroscope) + Gravity(Accelerometer)
 class KalmanPoseFilterPSMove : public KalmanPoseFilter
 {
-public:
-	bool init(const PoseFilterConstants &constant) override;
-	bool init(const PoseFilterConstants &constant, const Eigen::Vector3f &position, const Eigen::Quaternionf &orientation) override;
-	void update(const float delta_time, const PoseFilterPacket &packet) override;
+protected:
+	class KalmanPoseFilterImpl *allocateFilterImpl(const PoseFilterConstants &constant) const override;
 };
 
 #endif // KALMAN_POSE_FILTER_H
\ No newline at end of file
@@ -61,7 +61,7 @@ struct OrientationFilterState
         }
         else
         {
-            SERVER_LOG_WARNING("OrientationFilter") << "Orientation is NaN!";
+            SERVER_MT_LOG_WARNING("OrientationFilter") << "Orientation is NaN!";
         }
 
         if (eigen_vector3f_is_valid(new_angular_velocity))
@@ -70,7 +70,7 @@ struct OrientationFilterState
         }
         else
         {
-            SERVER_LOG_WARNING("OrientationFilter") << "Angular Velocity is NaN!";
+            SERVER_MT_LOG_WARNING("OrientationFilter") << "Angular Velocity is NaN!";
         }
 
         if (eigen_vector3f_is_valid(new_angular_acceleration))
@@ -79,7 +79,7 @@ struct OrientationFilterState
         }
         else
         {
-            SERVER_LOG_WARNING("OrientationFilter") << "Angular Acceleration is NaN!";
+            SERVER_MT_LOG_WARNING("OrientationFilter") << "Angular Acceleration is NaN!";
         }
 
 		if (is_valid_float(delta_time))
@@ -89,7 +89,7 @@ struct OrientationFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "time delta is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "time delta is NaN!";
 		}
 
         // state is valid now that we have had an update
@@ -106,7 +106,7 @@ struct OrientationFilterState
         }
         else
         {
-            SERVER_LOG_WARNING("OrientationFilter") << "Orientation is NaN!";
+            SERVER_MT_LOG_WARNING("OrientationFilter") << "Orientation is NaN!";
         }
 
 		if (is_valid_float(delta_time))
@@ -116,7 +116,7 @@ struct OrientationFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "time delta is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "time delta is NaN!";
 		}
 
         // state is valid now that we have had an update
@@ -131,7 +131,7 @@ struct OrientationFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "optical time delta is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "optical time delta is NaN!";
 		}
 	}
 
@@ -143,7 +143,7 @@ struct OrientationFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "imu time delta is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "imu time delta is NaN!";
 		}
 	}
 };
@@ -58,6 +58,8 @@ void PoseFilterSpace::createFilterPacket(
     PoseFilterPacket &outFilterPacket) const
 {
 	outFilterPacket.timestamp= sensorPacket.timestamp;
+	// The filters use the capture time to slot late optical samples back into their history
+	outFilterPacket.stage_times= sensorPacket.stage_times;
 
 	outFilterPacket.current_orientation= poseFilter->getOrientation();
 	outFilterPacket.current_position_cm= poseFilter->getPositionCm();
@@ -4,6 +4,7 @@
 //-- includes -----
 #include "DeviceInterface.h"
 #include "MathEigen.h"
+#include "PipelineLatency.h"
 #include <chrono>
 
 //-- constants -----
@@ -49,6 +50,9 @@ struct PoseSensorPacket
 {
 	std::chrono::time_point<std::chrono::high_resolution_clock> timestamp;
 
+	// When the sample was captured and went through each stage of the pipeline (for latency stats)
+	PipelineStageTimes stage_times;
+
     // Optical readings in the world reference frame
     Eigen::Vector3f optical_position_cm;
     Eigen::Quaternionf optical_orientation;
@@ -68,6 +72,7 @@ struct PoseSensorPacket
 	inline void clear()
 	{
 		timestamp= std::chrono::time_point<std::chrono::high_resolution_clock>();
+		stage_times.clear();
 		optical_position_cm= Eigen::Vector3f::Zero();
 		optical_orientation= Eigen::Quaternionf::Identity();
 		tracking_projection_area_px_sqr= 0.f;
@@ -280,11 +285,19 @@ struct PoseFilterConstants
     OrientationFilterConstants orientation_constants;
     PositionFilterConstants position_constants;
 
+    /// How far back (seconds) a filter can roll back to fuse a late measurement, 0 disables rollback
+    float fixed_lag_window_seconds;
+
+    /// Run the filter math in float instead of double, for filters that support both
+    bool use_single_precision;
+
 	void clear()
 	{
         memset(&shape, 0, sizeof(CommonDeviceTrackingShape));
 		orientation_constants.clear();
 		position_constants.clear();
+		fixed_lag_window_seconds= 0.f;
+		use_single_precision= false;
 	}
 };
 
@@ -369,6 +382,10 @@ public:
 
     /// Get the current velocity of the filter state (cm/s^2)
     virtual Eigen::Vector3f getAccelerationCmPerSecSqr() const = 0;
+
+    /// True if late optical samples are fused at their capture time (fixed lag rollback)
+    /// rather than at the time they reach the filter
+    virtual bool getIsFusingAtCaptureTime() const = 0;
 };
 
 #endif // POSE_FILTER_INTERFACE_H
\ No newline at end of file
@@ -0,0 +1,233 @@
+#ifndef POSE_SENSOR_PACKET_QUEUE_H
+#define POSE_SENSOR_PACKET_QUEUE_H
+
+//-- includes -----
+#include "PoseFilterInterface.h"
+#include "readerwriterqueue.h" // lockfree queue
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+//-- constants -----
+// Packets a device or tracker thread can get ahead of the main thread before new ones are dropped (~0.5s of IMU data)
+#define POSE_SENSOR_PACKET_QUEUE_CAPACITY 512
+
+// Most packets one update feeds to the filter. Anything older in the backlog is dropped.
+#define POSE_SENSOR_PACKET_MERGE_CAPACITY 100
+
+//-- definitions -----
+/// Hands pose sensor packets from one producer thread (at a time) to the main thread.
+/// The storage is allocated up front: packets posted to a full queue are dropped and counted instead.
+class PoseSensorPacketQueue
+{
+public:
+    PoseSensorPacketQueue()
+        : m_queue(POSE_SENSOR_PACKET_QUEUE_CAPACITY)
+        , m_droppedCount(0)
+    {
+    }
+
+    /// Called on the producer thread
+    bool post(const PoseSensorPacket &packet)
+    {
+        // The lockfree queue rounds its storage up to a power of two, so cap the backlog here
+        if (m_queue.size_approx() >= POSE_SENSOR_PACKET_QUEUE_CAPACITY || !m_queue.try_enqueue(packet))
+        {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+
+    /// Called on the main thread
+    inline bool tryDequeue(PoseSensorPacket &out_packet) { return m_queue.try_dequeue(out_packet); }
+
+    inline uint64_t getDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+    inline void resetDroppedCount() { m_droppedCount.store(0, std::memory_order_relaxed); }
+
+private:
+    moodycamel::ReaderWriterQueue<PoseSensorPacket, 1024> m_queue;
+    std::atomic<uint64_t> m_droppedCount;
+};
+
+/// Instrumentation for one device's pose sensor packet queues
+struct PoseSensorQueueStats
+{
+    int imu_queue_depth_max; // deepest IMU backlog drained by one update
+    int optical_queue_depth_max; // deepest optical backlog drained by one update
+    uint64_t imu_dropped_count; // posted to a full IMU queue
+    uint64_t optical_dropped_count; // posted to a full optical queue
+    uint64_t merge_dropped_count; // older than what one update feeds to the filter
+
+    inline void clear()
+    {
+        imu_queue_depth_max= 0;
+        optical_queue_depth_max= 0;
+        imu_dropped_count= 0;
+        optical_dropped_count= 0;
+        merge_dropped_count= 0;
+    }
+};
+
+/// Merges the IMU and optical packet streams of a device into time order for the filter, without allocating.
+/// Each stream arrives already time ordered, so draining both into preallocated rings
+/// and walking them with a two-way merge replaces collecting and sorting every update.
+/// Only used on the main thread.
+class PoseSensorPacketMerger
+{
+public:
+    PoseSensorPacketMerger()
+    {
+        m_imuStream.allocate(POSE_SENSOR_PACKET_MERGE_CAPACITY);
+        m_opticalStream.allocate(POSE_SENSOR_PACKET_MERGE_CAPACITY);
+        resetStats();
+    }
+
+    /// Drains both queues, then skips past the oldest packets beyond the merge capacity.
+    /// Returns the number of packets nextPacket() will hand out.
+    int drainQueues(PoseSensorPacketQueue &imu_queue, PoseSensorPacketQueue &optical_queue)
+    {
+        const int imu_depth= m_imuStream.drain(imu_queue, m_mergeDroppedCount);
+        const int optical_depth= m_opticalStream.drain(optical_queue, m_mergeDroppedCount);
+
+        m_imuQueueDepthMax= std::max(m_imuQueueDepthMax, imu_depth);
+        m_opticalQueueDepthMax= std::max(m_opticalQueueDepthMax, optical_depth);
+
+        // Keep the newest packets across both streams, like the sort and trim this replaces
+        int excess= m_imuStream.count + m_opticalStream.count - POSE_SENSOR_PACKET_MERGE_CAPACITY;
+        while (excess > 0)
+        {
+            popOldestStream().skip();
+            ++m_mergeDroppedCount;
+            --excess;
+        }
+
+        return m_imuStream.count + m_opticalStream.count;
+    }
+
+    /// Hands out the drained packets oldest first, across both streams.
+    /// The packet stays valid until the next call. Returns nullptr once both streams are empty.
+    const PoseSensorPacket *nextPacket()
+    {
+        if (m_imuStream.count + m_opticalStream.count == 0)
+        {
+            return nullptr;
+        }
+
+        return &popOldestStream().pop();
+    }
+
+    inline uint64_t getMergeDroppedCount() const { return m_mergeDroppedCount; }
+
+    void getStats(const PoseSensorPacketQueue &imu_queue, const PoseSensorPacketQueue &optical_queue, PoseSensorQueueStats &out_stats) const
+    {
+        out_stats.imu_queue_depth_max= m_imuQueueDepthMax;
+        out_stats.optical_queue_depth_max= m_opticalQueueDepthMax;
+        out_stats.imu_dropped_count= imu_queue.getDroppedCount();
+        out_stats.optical_dropped_count= optical_queue.getDroppedCount();
+        out_stats.merge_dropped_count= m_mergeDroppedCount;
+    }
+
+    void resetStats()
+    {
+        m_imuQueueDepthMax= 0;
+        m_opticalQueueDepthMax= 0;
+        m_mergeDroppedCount= 0;
+    }
+
+private:
+    // Ring of the newest packets drained from one queue
+    struct PacketStream
+    {
+        std::vector<PoseSensorPacket, Eigen::aligned_allocator<PoseSensorPacket> > packets;
+        int start;
+        int count;
+
+        void allocate(int capacity)
+        {
+            packets.resize(capacity);
+            start= 0;
+            count= 0;
+        }
+
+        // Returns how many packets were waiting in the queue
+        int drain(PoseSensorPacketQueue &queue, uint64_t &dropped_count)
+        {
+            const int capacity= static_cast<int>(packets.size());
+            int depth= 0;
+
+            for (;;)
+            {
+                int slot;
+                if (count < capacity)
+                {
+                    slot= (start + count) % capacity;
+                }
+                else
+                {
+                    // Full, so the packet lands on top of the oldest one
+                    slot= start;
+                }
+
+                if (!queue.tryDequeue(packets[slot]))
+                {
+                    break;
+                }
+
+                ++depth;
+                if (count < capacity)
+                {
+                    ++count;
+                }
+                else
+                {
+                    start= (start + 1) % capacity;
+                    ++dropped_count;
+                }
+            }
+
+            return depth;
+        }
+
+        inline const PoseSensorPacket &front() const { return packets[start]; }
+
+        const PoseSensorPacket &pop()
+        {
+            const PoseSensorPacket &packet= packets[start];
+
+            start= (start + 1) % static_cast<int>(packets.size());
+            --count;
+
+            return packet;
+        }
+
+        inline void skip() { pop(); }
+    };
+
+    PacketStream &popOldestStream()
+    {
+        if (m_imuStream.count == 0)
+        {
+            return m_opticalStream;
+        }
+        else if (m_opticalStream.count == 0)
+        {
+            return m_imuStream;
+        }
+
+        // Ties go to the IMU packet, which is what the optical pose gets fused against
+        return (m_opticalStream.front().timestamp < m_imuStream.front().timestamp) ? m_opticalStream : m_imuStream;
+    }
+
+    PacketStream m_imuStream;
+    PacketStream m_opticalStream;
+
+    int m_imuQueueDepthMax;
+    int m_opticalQueueDepthMax;
+    uint64_t m_mergeDroppedCount;
+};
+
+#endif // POSE_SENSOR_PACKET_QUEUE_H
@@ -83,7 +83,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "Position is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "Position is NaN!";
 		}
 
 		if (eigen_vector3f_is_valid(new_velocity_m_per_sec))
@@ -92,7 +92,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "Velocity is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "Velocity is NaN!";
 		}
 
 		if (eigen_vector3f_is_valid(new_acceleration_m_per_sec_sqr))
@@ -101,7 +101,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "Acceleration is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "Acceleration is NaN!";
 		}
 
 		if (eigen_vector3f_is_valid(new_accelerometer_g_units))
@@ -110,7 +110,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "Accelerometer is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "Accelerometer is NaN!";
 		}
 
 		if (eigen_vector3f_is_valid(new_accelerometer_derivative_g_per_sec))
@@ -119,7 +119,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "AccelerometerDerivative is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "AccelerometerDerivative is NaN!";
 		}
 
 		if (is_valid_float(delta_time))
@@ -129,7 +129,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "time delta is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "time delta is NaN!";
 		}
 
         // state is valid now that we have had an update
@@ -154,7 +154,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "Position is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "Position is NaN!";
 		}
 
 		if (eigen_vector3f_is_valid(new_velocity_m_per_sec))
@@ -163,7 +163,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "Velocity is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "Velocity is NaN!";
 		}
 
 		if (is_valid_float(delta_time))
@@ -173,7 +173,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "time delta is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "time delta is NaN!";
 		}
 
         // state is valid now that we have had an update
@@ -188,7 +188,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "optical time delta is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "optical time delta is NaN!";
 		}
 	}
 
@@ -200,7 +200,7 @@ struct PositionFilterState
 		}
 		else
 		{
-			SERVER_LOG_WARNING("PositionFilter") << "imu time delta is NaN!";
+			SERVER_MT_LOG_WARNING("PositionFilter") << "imu time delta is NaN!";
 		}
 	}
 };
@@ -3,12 +3,17 @@
 #include "DeviceInterface.h"
 #include "DeviceManager.h"
 #include "HMDDeviceEnumerator.h"
+#include "HMDManager.h"
+#include "HidPacketRecording.h"
 #include "HidHMDDeviceEnumerator.h"
 #include "MathUtility.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
+#include "WorkerThread.h"
 #include "hidapi.h"
 #include "libusb.h"
+#include "readerwriterqueue.h" // lockfree queue
+#include <atomic>
 #include <vector>
 #include <cstdlib>
 #ifdef _WIN32
@@ -34,6 +39,10 @@
 #define MORPHEUS_COMMAND_MAX_PAYLOAD_LEN 60
 
 #define MORPHEUS_HMD_STATE_BUFFER_MAX 4
+// Sensor reports the HID read thread can get ahead of poll() before new ones are dropped (~0.25s)
+#define MORPHEUS_SENSOR_REPORT_QUEUE_CAPACITY 128
+// How long the HID read thread blocks waiting on a report before checking for a stop request
+#define MORPHEUS_HID_READ_TIMEOUT_MS 100
 #define METERS_TO_CENTIMETERS 100
 
 enum eMorpheusRequestType
@@ -178,6 +187,102 @@ struct MorpheusCommand
 };
 #pragma pack()
 
+// Reads sensor reports off the HID sensor interface as they arrive while recording,
+// so recordings get per-report timestamps rather than ones bunched up at each poll()
+class MorpheusHidPacketProcessor : public WorkerThread
+{
+public:
+	MorpheusHidPacketProcessor()
+		: WorkerThread("MorpheusSensorProcessor")
+		, m_hidDevice(nullptr)
+		, m_sensorReports(MORPHEUS_SENSOR_REPORT_QUEUE_CAPACITY)
+		, m_bHidReadFailed(false)
+	{
+	}
+
+	void start(hid_device *in_hid_device)
+	{
+		if (!hasThreadStarted())
+		{
+			m_hidDevice= in_hid_device;
+			m_bHidReadFailed= false;
+
+			// Perform blocking reads on the worker thread
+			hid_set_nonblocking(m_hidDevice, 0);
+
+			// Fire up the worker thread
+			WorkerThread::startThread();
+		}
+	}
+
+	// Must be called before start()
+	bool startRecording(const std::string &path, int product_id, const std::string &config_json)
+	{
+		return !hasThreadStarted() &&
+			m_recorder.open(path, CommonDeviceState::Morpheus, product_id, config_json);
+	}
+
+	void stop()
+	{
+		WorkerThread::stopThread();
+		m_recorder.close();
+
+		// Drop anything poll() didn't get to
+		MorpheusSensorData unused_report;
+		while (m_sensorReports.try_dequeue(unused_report));
+	}
+
+	// Called on the main thread
+	inline bool tryDequeueSensorReport(MorpheusSensorData &out_report) { return m_sensorReports.try_dequeue(out_report); }
+	inline bool getHidReadFailed() const { return m_bHidReadFailed.load(); }
+
+protected:
+	virtual bool doWork() override
+	{
+		// Attempt to read the next sensor update packet from the HMD
+		MorpheusSensorData report;
+		int res= hid_read_timeout(m_hidDevice, (unsigned char*)&report, sizeof(MorpheusSensorData), MORPHEUS_HID_READ_TIMEOUT_MS);
+
+		if (res > 0)
+		{
+			if (m_recorder.getIsOpen())
+			{
+				m_recorder.writePacket((const unsigned char *)&report, res);
+			}
+
+			// Drop the report if poll() has fallen too far behind
+			m_sensorReports.try_enqueue(report);
+		}
+		else if (res < 0)
+		{
+			char hidapi_err_mbs[256];
+			bool valid_error_mesg = 
+				ServerUtility::convert_wcs_to_mbs(hid_error(m_hidDevice), hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+			// Device no longer in valid state.
+			if (valid_error_mesg)
+			{
+				SERVER_MT_LOG_ERROR("MorpheusSensorProcessor::doWork") << "HID ERROR: " << hidapi_err_mbs;
+			}
+
+			m_bHidReadFailed= true;
+
+			// halt the worker thread
+			return false;
+		}
+
+		return true;
+	}
+
+	// Multi-threaded state
+	hid_device *m_hidDevice;
+	moodycamel::ReaderWriterQueue<MorpheusSensorData, MORPHEUS_SENSOR_REPORT_QUEUE_CAPACITY> m_sensorReports;
+	std::atomic_bool m_bHidReadFailed;
+
+	// Worker thread state
+	HidPacketRecordingWriter m_recorder;
+};
+
 // -- private methods
 static bool morpheus_open_usb_device(MorpheusUSBContext *morpheus_context);
 static void morpheus_close_usb_device(MorpheusUSBContext *morpheus_context);
@@ -366,10 +471,12 @@ MorpheusHMD::MorpheusHMD()
     , NextPollSequenceNumber(0)
     , InData(nullptr)
     , HMDStates()
+    , HIDPacketProcessor(nullptr)
 	, bIsTracking(false)
 {
     USBContext = new MorpheusUSBContext;
     InData = new MorpheusSensorData;
+    HIDPacketProcessor = new MorpheusHidPacketProcessor;
 
     HMDStates.clear();
 }
@@ -381,6 +488,7 @@ MorpheusHMD::~MorpheusHMD()
         SERVER_LOG_ERROR("~MorpheusHMD") << "HMD deleted without calling close() first!";
     }
 
+    delete HIDPacketProcessor;
     delete InData;
     delete USBContext;
 }
@@ -461,6 +569,19 @@ bool MorpheusHMD::open(
             // Reset the polling sequence counter
             NextPollSequenceNumber = 0;
 
+			// When recording, sensor reports are read and recorded on their own thread so that
+			// each one gets its own timestamp, then parsed in poll().
+			// Otherwise poll() keeps reading them without blocking on the main thread.
+			const HMDManagerConfig &manager_cfg= DeviceManager::getInstance()->m_hmd_manager->getConfig();
+			if (manager_cfg.record_hmd_hid_packets &&
+				HIDPacketProcessor->startRecording(
+					HidPacketRecordingWriter::makeRecordingPath(manager_cfg.hmd_recording_path, "Morpheus"),
+					MORPHEUS_PRODUCT_ID,
+					std::string()))
+			{
+				HIDPacketProcessor->start(USBContext->sensor_device_handle);
+			}
+
 			success = true;
         }
         else
@@ -477,6 +598,9 @@ void MorpheusHMD::close()
 {
     if (USBContext->sensor_device_handle != nullptr || USBContext->usb_device_handle != nullptr)
     {
+		// Stop reading sensor reports before the sensor interface goes away
+		HIDPacketProcessor->stop();
+
 		if (USBContext->sensor_device_handle != nullptr)
 		{
 			SERVER_LOG_INFO("MorpheusHMD::close") << "Closing MorpheusHMD sensor interface(" << USBContext->sensor_device_path << ")";
@@ -549,11 +673,29 @@ MorpheusHMD::poll()
 	if (getIsOpen())
 	{
 		static const int k_max_iterations = 32;
+		const bool bIsRecording = HIDPacketProcessor->hasThreadStarted();
 
 		for (int iteration = 0; iteration < k_max_iterations; ++iteration)
 		{
-			// Attempt to read the next update packet from the controller
-			int res = hid_read(USBContext->sensor_device_handle, (unsigned char*)InData, sizeof(MorpheusSensorData));
+			// Attempt to read the next update packet from the controller.
+			// When recording, the HID read thread has already read (and recorded) it.
+			int res;
+			if (bIsRecording)
+			{
+				if (HIDPacketProcessor->tryDequeueSensorReport(*InData))
+				{
+					res = sizeof(MorpheusSensorData);
+				}
+				else
+				{
+					// Only report a HID error once the reports read before it are used up
+					res = HIDPacketProcessor->getHidReadFailed() ? -1 : 0;
+				}
+			}
+			else
+			{
+				res = hid_read(USBContext->sensor_device_handle, (unsigned char*)InData, sizeof(MorpheusSensorData));
+			}
 
 			if (res == 0)
 			{
@@ -567,14 +709,18 @@ MorpheusHMD::poll()
 			}
 			else if (res < 0)
 			{
-				char hidapi_err_mbs[256];
-				bool valid_error_mesg = 
-					ServerUtility::convert_wcs_to_mbs(hid_error(USBContext->sensor_device_handle), hidapi_err_mbs, sizeof(hidapi_err_mbs));
-
-				// Device no longer in valid state.
-				if (valid_error_mesg)
+				// The HID read thread already logged its error
+				if (!bIsRecording)
 				{
-					SERVER_LOG_ERROR("PSMoveController::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
+					char hidapi_err_mbs[256];
+					bool valid_error_mesg = 
+						ServerUtility::convert_wcs_to_mbs(hid_error(USBContext->sensor_device_handle), hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+					// Device no longer in valid state.
+					if (valid_error_mesg)
+					{
+						SERVER_LOG_ERROR("PSMoveController::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
+					}
 				}
 				result = IHMDInterface::_PollResultFailure;
 
@@ -262,6 +262,9 @@ private:
     struct MorpheusSensorData *InData;                        // Buffer to hold most recent MorpheusAPI tracking state
     std::deque<MorpheusHMDState> HMDStates;
 
+    // Reads and records sensor reports on a worker thread while recording, see HidPacketRecording.h
+    class MorpheusHidPacketProcessor *HIDPacketProcessor;
+
 	bool bIsTracking;
 };
 
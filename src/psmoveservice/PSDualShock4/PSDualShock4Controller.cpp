@@ -2,12 +2,17 @@
 #include "AtomicPrimitives.h"
 #include "PSDualShock4Controller.h"
 #include "ControllerDeviceEnumerator.h"
+#include "ControllerManager.h"
+#include "DeviceManager.h"
+#include "HidPacketRecording.h"
 #include "MathUtility.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
 #include "WorkerThread.h"
 #include "BluetoothQueries.h"
+#include <boost/property_tree/json_parser.hpp>
 #include <algorithm>
+#include <sstream>
 #include <vector>
 #include <cstdlib>
 #ifdef _WIN32
@@ -304,9 +309,17 @@ public:
 		}
     }
 
+	// Must be called before start()
+	bool startRecording(const std::string &path, int product_id, const std::string &config_json)
+	{
+		return !hasThreadStarted() && 
+			m_recorder.open(path, CommonDeviceState::PSDualShock4, product_id, config_json);
+	}
+
 	void stop()
 	{
 		WorkerThread::stopThread();
+		m_recorder.close();
 	}
 
 protected:
@@ -330,6 +343,11 @@ protected:
 
 		if (res > 0)
 		{
+			if (m_recorder.getIsOpen())
+			{
+				m_recorder.writePacket((const unsigned char *)&m_currentHIDInputPacket, res);
+			}
+
 			PSDualShock4ControllerConfig cfg;
 			m_cfg.fetchValue(cfg);
 
@@ -453,6 +471,7 @@ protected:
 	AtomicObject<PSDualShock4ControllerConfig> m_cfg;
 
     // Worker thread state
+	HidPacketRecordingWriter m_recorder;
     int m_nextPollSequenceNumber;
 	DualShock4DataInput m_previousHIDInputPacket;
     DualShock4DataInput m_currentHIDInputPacket;
@@ -500,6 +519,9 @@ PSDualShock4ControllerConfig::config2ptree()
 	pt.put("PositionFilter.FilterType", position_filter_type);
     pt.put("PositionFilter.MaxVelocity", max_velocity);
 
+	pt.put("PoseFilter.FixedLagWindow", pose_filter_fixed_lag_window);
+	pt.put("PoseFilter.UseSinglePrecision", pose_filter_use_single_precision);
+
 	pt.put("PositionFilter.UseLinearAcceleration", position_use_linear_acceleration);
 	pt.put("PositionFilter.ApplyGravityMask", position_apply_gravity_mask);
 
@@ -555,6 +577,9 @@ PSDualShock4ControllerConfig::ptree2config(const boost::property_tree::ptree &pt
 		position_use_linear_acceleration= pt.get<bool>("PositionFilter.UseLinearAcceleration", position_use_linear_acceleration);
 		position_apply_gravity_mask= pt.get<bool>("PositionFilter.ApplyGravityMask", position_apply_gravity_mask);
 
+		pose_filter_fixed_lag_window= pt.get<float>("PoseFilter.FixedLagWindow", pose_filter_fixed_lag_window);
+		pose_filter_use_single_precision= pt.get<bool>("PoseFilter.UseSinglePrecision", pose_filter_use_single_precision);
+
 		// Get shared filter parameters
 		min_screen_projection_area = pt.get<float>("PoseFilter.MinScreenProjectionArea", min_screen_projection_area);
 
@@ -932,10 +957,6 @@ bool PSDualShock4Controller::open(
                 }
             }
 
-			// Create the sensor processor thread
-			m_HIDPacketProcessor= new DualShock4HidPacketProcessor(cfg);
-			m_HIDPacketProcessor->start(HIDDetails.Handle, m_controllerListener);
-
             if (success)
             {
                 // Build a unique name for the config file using bluetooth address of the controller
@@ -954,6 +975,29 @@ bool PSDualShock4Controller::open(
 				// Save it back out again in case any defaults changed
 				cfg.save();
             }
+
+			// Create the sensor processor thread (after the config load so it parses with the calibration)
+			m_HIDPacketProcessor= new DualShock4HidPacketProcessor(cfg);
+
+			const ControllerManagerConfig &manager_cfg= DeviceManager::getInstance()->m_controller_manager->getConfig();
+			if (success && IsBluetooth && manager_cfg.record_controller_hid_packets)
+			{
+				char szRecordingSuffix[18];
+				ServerUtility::bluetooth_cstr_address_normalize(
+					HIDDetails.Bt_addr.c_str(), true, '_',
+					szRecordingSuffix, sizeof(szRecordingSuffix));
+
+				std::ostringstream config_json;
+				boost::property_tree::write_json(config_json, cfg.config2ptree());
+
+				m_HIDPacketProcessor->startRecording(
+					HidPacketRecordingWriter::makeRecordingPath(
+						manager_cfg.controller_recording_path, std::string("DualShock4_") + szRecordingSuffix),
+					HIDDetails.product_id,
+					config_json.str());
+			}
+
+			m_HIDPacketProcessor->start(HIDDetails.Handle, m_controllerListener);
         }
         else
         {
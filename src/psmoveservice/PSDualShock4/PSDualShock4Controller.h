@@ -45,6 +45,8 @@ public:
         , version(CONFIG_VERSION)
 		, position_filter_type("ComplimentaryOpticalIMU")
 		, orientation_filter_type("ComplementaryOpticalARG")
+		, pose_filter_fixed_lag_window(0.f)
+		, pose_filter_use_single_precision(false)
         , max_poll_failure_count(100)
         , prediction_time(0.f)
         , accelerometer_noise_radius(0.015f) // rounded value from config tool measurement (g-units)
@@ -116,6 +118,12 @@ public:
 	// The type of orientation filter to use
 	std::string orientation_filter_type;
 
+	// How far back in seconds the PoseKalman filter can roll back to fuse a late optical measurement (0 disables)
+	float pose_filter_fixed_lag_window;
+
+	// Run the PoseKalman filter math in float instead of double (faster updates, a little more drift)
+	bool pose_filter_use_single_precision;
+
 	// The max number of polling failures before we consider the controller disconnected
     long max_poll_failure_count;
 	// The amount of prediction to apply to the controller pose after filtering
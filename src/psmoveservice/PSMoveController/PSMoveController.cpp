@@ -37,12 +37,18 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "AtomicPrimitives.h"
 #include "PSMoveController.h"
 #include "ControllerDeviceEnumerator.h"
+#include "ControllerManager.h"
+#include "DeviceManager.h"
+#include "HidPacketRecording.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
 #include "BluetoothQueries.h"
 #include "MathAlignment.h"
 #include "WorkerThread.h"
 
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -250,6 +256,8 @@ public:
 		, m_hidDevice(nullptr)
 		, m_controllerListener(nullptr)
 		, m_bSupportsMagnetometer(false)
+		, m_replayReader(nullptr)
+		, m_bHasTestedReplayMagnetometer(false)
 		, m_nextPollSequenceNumber(0)
 	{
 		setConfig(cfg);
@@ -313,9 +321,33 @@ public:
 		}
     }
 
+	// Replays a HID recording instead of reading from a device.
+	// The reader must outlive the worker thread.
+	void startReplay(
+		HidPacketRecordingReader *replay_reader, IControllerListener *controller_listener,
+		float replay_speed, bool bLoop)
+	{
+		if (!hasThreadStarted())
+		{
+			m_replayReader= replay_reader;
+			m_controllerListener= controller_listener;
+			m_replayReader->startReplay(replay_speed, bLoop);
+
+			WorkerThread::startThread();
+		}
+	}
+
+	// Must be called before start()
+	bool startRecording(const std::string &path, int product_id, const std::string &config_json)
+	{
+		return !hasThreadStarted() && 
+			m_recorder.open(path, CommonDeviceState::PSMove, product_id, config_json);
+	}
+
 	void stop()
 	{
 		WorkerThread::stopThread();
+		m_recorder.close();
 	}
 
 protected:
@@ -359,11 +391,64 @@ protected:
 		}
 	}
 
+	bool doReplayWork(const PSMoveControllerConfig &cfg)
+	{
+		const unsigned char *packet= nullptr;
+		size_t packet_size= 0;
+		int64_t sample_time_us= 0;
+
+		if (m_replayReader->waitForNextPacket(cfg.poll_timeout_ms, packet, packet_size, sample_time_us))
+		{
+			PSMoveControllerInputState newState;
+
+			newState.PollSequenceNumber = m_nextPollSequenceNumber;
+			++m_nextPollSequenceNumber;
+
+			if (m_model == _psmove_controller_ZCM2)
+			{
+				memcpy(&m_previousHIDInputPacket.data.zcm2, &m_currentHIDInputPacket.data.zcm2, sizeof(PSMoveDataInputZCM2));
+				memcpy(&m_currentHIDInputPacket.data.zcm2, packet, std::min(packet_size, sizeof(PSMoveDataInputZCM2)));
+				newState.parseDataInput(&cfg, &m_previousHIDInputPacket.data.zcm2, &m_currentHIDInputPacket.data.zcm2);
+			}
+			else
+			{
+				memcpy(&m_previousHIDInputPacket.data.zcm1, &m_currentHIDInputPacket.data.zcm1, sizeof(PSMoveDataInputZCM1));
+				memcpy(&m_currentHIDInputPacket.data.zcm1, packet, std::min(packet_size, sizeof(PSMoveDataInputZCM1)));
+				newState.parseDataInput(&cfg, &m_previousHIDInputPacket.data.zcm1, &m_currentHIDInputPacket.data.zcm1);
+
+				// Same test as testMagnetometer(), but on the first recorded packet
+				if (!m_bHasTestedReplayMagnetometer)
+				{
+					m_bSupportsMagnetometer = 
+						newState.RawMag[0] != 0 || newState.RawMag[1] != 0 || newState.RawMag[2] != 0;
+					m_bHasTestedReplayMagnetometer= true;
+				}
+			}
+
+			m_currentInputState.storeValue(newState);
+
+			// Hand over the recorded sample time so the filter sees the recorded packet timing
+			// regardless of the replay speed
+			if (m_controllerListener != nullptr)
+			{
+				m_controllerListener->notifyRecordedSensorDataReceived(&newState, sample_time_us);
+			}
+		}
+
+		// There is no device to write LED and rumble state to
+		return true;
+	}
+
 	virtual bool doWork() override
     {
 		PSMoveControllerConfig cfg;
 		m_cfg.fetchValue(cfg);
 
+		if (m_replayReader != nullptr)
+		{
+			return doReplayWork(cfg);
+		}
+
 		// Attempt to read the next sensor update packet from the HMD
         int res = -1;
 		if (m_model == _psmove_controller_ZCM2)
@@ -379,6 +464,11 @@ protected:
 
 		if (res > 0)
 		{
+			if (m_recorder.getIsOpen())
+			{
+				m_recorder.writePacket((const unsigned char *)&m_currentHIDInputPacket.data, res);
+			}
+
 			// https://github.com/hrl7/node-psvr/blob/master/lib/psvr.js
 			PSMoveControllerInputState newState;
 
@@ -486,6 +576,9 @@ protected:
 	AtomicObject<PSMoveControllerConfig> m_cfg;
 
     // Worker thread state
+	HidPacketRecordingReader *m_replayReader;
+	bool m_bHasTestedReplayMagnetometer;
+	HidPacketRecordingWriter m_recorder;
     int m_nextPollSequenceNumber;
 	PSMoveDataInput m_previousHIDInputPacket;
     PSMoveDataInput m_currentHIDInputPacket;
@@ -587,6 +680,9 @@ PSMoveControllerConfig::config2ptree()
 	pt.put("PositionFilter.FilterType", position_filter_type);
     pt.put("PositionFilter.MaxVelocity", max_velocity);
 
+	pt.put("PoseFilter.FixedLagWindow", pose_filter_fixed_lag_window);
+	pt.put("PoseFilter.UseSinglePrecision", pose_filter_use_single_precision);
+
 	pt.put("hand", hand);
 
 	writeTrackingColor(pt, tracking_color_id);
@@ -676,6 +772,9 @@ PSMoveControllerConfig::ptree2config(const boost::property_tree::ptree &pt)
 		position_filter_type= pt.get<std::string>("PositionFilter.FilterType", position_filter_type);
         max_velocity= pt.get<float>("PositionFilter.MaxVelocity", max_velocity);
 
+		pose_filter_fixed_lag_window= pt.get<float>("PoseFilter.FixedLagWindow", pose_filter_fixed_lag_window);
+		pose_filter_use_single_precision= pt.get<bool>("PoseFilter.UseSinglePrecision", pose_filter_use_single_precision);
+
 		tracking_color_id= static_cast<eCommonTrackingColorID>(readTrackingColor(pt));
 
 		hand= pt.get<std::string>("hand", hand);
@@ -962,6 +1061,7 @@ void PSMoveControllerOutputState::clear()
 PSMoveController::PSMoveController()
     : m_HIDPacketProcessor(nullptr)
 	, m_controllerListener(nullptr)
+	, ReplayReader(nullptr)
 {
 	HIDDetails.vendor_id = -1;
 	HIDDetails.product_id = -1;
@@ -982,6 +1082,11 @@ PSMoveController::~PSMoveController()
 	{
 		delete m_HIDPacketProcessor;
 	}
+
+	if (ReplayReader)
+	{
+		delete ReplayReader;
+	}
 }
 
 bool PSMoveController::open()
@@ -1033,6 +1138,10 @@ bool PSMoveController::open(
         SERVER_LOG_WARNING("PSMoveController::open") << "PSMoveController(" << cur_dev_path << ") already open. Ignoring request.";
         success= true;
     }
+    else if (pEnum->get_api_type() == ControllerDeviceEnumerator::CommunicationType_REPLAY)
+    {
+        success= openReplay(pEnum);
+    }
     else
     {
         char cur_dev_serial_number[256];
@@ -1135,6 +1244,23 @@ bool PSMoveController::open(
 
 			// Create the sensor processor thread
 			m_HIDPacketProcessor= new PSMoveHidPacketProcessor(cfg, (PSMoveControllerModelPID)HIDDetails.product_id);
+
+			const ControllerManagerConfig &manager_cfg= DeviceManager::getInstance()->m_controller_manager->getConfig();
+			if (success && IsBluetooth && manager_cfg.record_controller_hid_packets)
+			{
+				std::string btaddr = HIDDetails.Bt_addr;
+				std::replace(btaddr.begin(), btaddr.end(), ':', '_');
+
+				// Embed the calibration so the recording replays without this controller's config file
+				std::ostringstream config_json;
+				boost::property_tree::write_json(config_json, cfg.config2ptree());
+
+				m_HIDPacketProcessor->startRecording(
+					HidPacketRecordingWriter::makeRecordingPath(manager_cfg.controller_recording_path, "PSMove_"+btaddr),
+					HIDDetails.product_id,
+					config_json.str());
+			}
+
 			m_HIDPacketProcessor->start(HIDDetails.Handle, m_controllerListener);
 
 			if (bSaveConfig)
@@ -1152,6 +1278,63 @@ bool PSMoveController::open(
     return success;
 }
 
+bool PSMoveController::openReplay(const ControllerDeviceEnumerator *pEnum)
+{
+	const char *recording_path= pEnum->get_path();
+
+	SERVER_LOG_INFO("PSMoveController::open") << "Opening PSMoveController replay(" << recording_path << ")";
+
+	ReplayReader= new HidPacketRecordingReader();
+	if (!ReplayReader->open(recording_path))
+	{
+		delete ReplayReader;
+		ReplayReader= nullptr;
+
+		return false;
+	}
+
+	const std::string recording_name= boost::filesystem::path(recording_path).stem().string();
+
+	HIDDetails.vendor_id = pEnum->get_vendor_id();
+	HIDDetails.product_id = ReplayReader->getHeader().product_id;
+	HIDDetails.Device_path = recording_path;
+	HIDDetails.Bt_addr = recording_name;
+	HIDDetails.Host_bt_addr = "00:00:00:00:00:00";
+
+	// Behaves like a bluetooth controller so that it gets a pose filter and a tracking color
+	IsBluetooth = true;
+
+	// Start from the calibration that was embedded in the recording,
+	// but let a config file saved next to the other controller configs override it
+	cfg = PSMoveControllerConfig("PSMoveReplay_" + recording_name);
+	if (!ReplayReader->getDeviceConfigJson().empty())
+	{
+		try
+		{
+			std::istringstream config_json(ReplayReader->getDeviceConfigJson());
+			boost::property_tree::ptree pt;
+
+			boost::property_tree::read_json(config_json, pt);
+			cfg.ptree2config(pt);
+		}
+		catch (boost::property_tree::json_parser::json_parser_error &e)
+		{
+			SERVER_LOG_WARNING("PSMoveController::open") << "Failed to parse recorded config: " << e.what();
+		}
+	}
+	cfg.load();
+	cfg.save();
+
+	const ControllerManagerConfig &manager_cfg= DeviceManager::getInstance()->m_controller_manager->getConfig();
+
+	m_HIDPacketProcessor= new PSMoveHidPacketProcessor(cfg, (PSMoveControllerModelPID)HIDDetails.product_id);
+	m_HIDPacketProcessor->startReplay(
+		ReplayReader, m_controllerListener,
+		manager_cfg.controller_replay_speed, manager_cfg.loop_controller_replay);
+
+	return true;
+}
+
 void PSMoveController::close()
 {
     if (getIsOpen())
@@ -1177,6 +1360,12 @@ void PSMoveController::close()
             hid_close(HIDDetails.Handle_addr);
             HIDDetails.Handle_addr= nullptr;
         }
+
+		if (ReplayReader != nullptr)
+		{
+			delete ReplayReader;
+			ReplayReader= nullptr;
+		}
     }
     else
     {
@@ -1194,7 +1383,11 @@ PSMoveController::setHostBluetoothAddress(const std::string &new_host_bt_addr)
     bts[0] = PSMove_Req_SetBTAddr;
 
     unsigned char addr[6];
-    if (stringToPSMoveBTAddrUchar(new_host_bt_addr, addr, sizeof(addr)))
+    if (HIDDetails.Handle == nullptr)
+    {
+        SERVER_LOG_WARNING("PSMoveController::setBTAddress") << "PSMoveController(" << HIDDetails.Device_path << ") is a replay, can't assign a host address.";
+    }
+    else if (stringToPSMoveBTAddrUchar(new_host_bt_addr, addr, sizeof(addr)))
     {
         int res;
 
@@ -1357,7 +1550,7 @@ PSMoveController::getAssignedHostBluetoothAddress() const
 bool
 PSMoveController::getIsOpen() const
 {
-    return (HIDDetails.Handle != nullptr);
+    return (HIDDetails.Handle != nullptr || ReplayReader != nullptr);
 }
 
 bool
@@ -1783,6 +1976,11 @@ PSMoveController::enableDFUMode()
 	int res;
 	char mode_magic_val;
 
+	if (HIDDetails.Handle == nullptr)
+	{
+		return false;
+	}
+
 	if (getIsBluetooth())
 	{
 		mode_magic_val = 0x43;
@@ -1955,7 +2153,7 @@ bool
 PSMoveController::setLEDPWMFrequency(unsigned long freq)
 {
     bool success = false;
-    if ((freq >= 733) && (freq <= 24e6) && (freq != LedPWMF))
+    if ((freq >= 733) && (freq <= 24e6) && (freq != LedPWMF) && HIDDetails.Handle != nullptr)
     {
         unsigned char buf[7];
         
@@ -45,6 +45,8 @@ public:
         , prediction_time(0.f)
 		, position_filter_type("LowPassExponential")
 		, orientation_filter_type("ComplementaryMARG")
+		, pose_filter_fixed_lag_window(0.f)
+		, pose_filter_use_single_precision(false)
         , cal_ag_xyz_kbd({{ 
             {{ {{0, 0, 0}}, {{0, 0, 0}}, {{0, 0, 0}} }},
             {{ {{0, 0, 0}}, {{0, 0, 0}}, {{0, 0, 0}} }} 
@@ -103,6 +105,12 @@ public:
 	// The type of orientation filter to use
 	std::string orientation_filter_type;
 
+	// How far back in seconds the PoseKalman filter can roll back to fuse a late optical measurement (0 disables)
+	float pose_filter_fixed_lag_window;
+
+	// Run the PoseKalman filter math in float instead of double (faster updates, a little more drift)
+	bool pose_filter_use_single_precision;
+
 	// The accelerometer and gyroscope scale/bias/drift values read from the USB calibration packet
     std::array<std::array<std::array<float, 3>, 3>, 2> cal_ag_xyz_kbd;
 
@@ -302,6 +310,7 @@ private:
     void loadCalibrationZCM1();                         // Use USB or file if on BT
 	void loadCalibrationZCM2();                         // Use USB or file if on BT
 	bool loadFirmwareInfo();
+    bool openReplay(const class ControllerDeviceEnumerator *pEnum);
     
     // Constant while a controller is open
     PSMoveControllerConfig cfg;
@@ -318,5 +327,8 @@ private:
 	class PSMoveHidPacketProcessor* m_HIDPacketProcessor;
 	IControllerListener* m_controllerListener;
 
+    // Set when replaying a HID recording rather than reading a device
+    class HidPacketRecordingReader* ReplayReader;
+
 };
 #endif // PSMOVE_CONTROLLER_H
\ No newline at end of file
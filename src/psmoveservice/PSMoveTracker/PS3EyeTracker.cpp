@@ -5,9 +5,18 @@
 #include "PSEyeVideoCapture.h"
 #include "PSMoveProtocol.pb.h"
 #include "TrackerDeviceEnumerator.h"
+#include "TrackerFrameRecording.h"
 #include "TrackerManager.h"
+#include "DeviceManager.h"
+#include "VideoFramePool.h"
+#include "PipelineLatency.h"
 #include "opencv2/opencv.hpp"
 
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <chrono>
+#include <sstream>
+
 // -- constants -----
 #define PS3EYE_STATE_BUFFER_MAX 16
 
@@ -20,12 +29,19 @@ class PSEyeCaptureData
 {
 public:
     PSEyeCaptureData()
-        : frame()
+        : framePool()
+        , frame()
+        , recorder()
     {
 
     }
 
-    cv::Mat frame;
+    // Frames are debayered straight into pooled buffers that the tracker view reads in place
+    VideoFramePool framePool;
+    VideoFramePtr frame;
+
+    // Only open when tracker video recording is turned on in the tracker manager config
+    TrackerFrameRecordingWriter recorder;
 };
 
 // -- public methods
@@ -217,7 +233,7 @@ PS3EyeTrackerConfig::getColorRangeTable(const std::string &table_name) const
 	return table;
 }
 
-inline CommonHSVColorRangeTable *
+CommonHSVColorRangeTable *
 PS3EyeTrackerConfig::getOrAddColorRangeTable(const std::string &table_name)
 {
 	CommonHSVColorRangeTable *table= nullptr;	
@@ -363,6 +379,27 @@ bool PS3EyeTracker::open(const DeviceEnumerator *enumerator)
 		VideoCapture->set(cv::CAP_PROP_EXPOSURE, cfg.exposure);
 		VideoCapture->set(cv::CAP_PROP_GAIN, cfg.gain);
 		VideoCapture->set(cv::CAP_PROP_FPS, cfg.frame_rate);
+
+        const TrackerManagerConfig &trackerMgrConfig= DeviceManager::getInstance()->m_tracker_manager->getConfig();
+        if (trackerMgrConfig.record_tracker_video && !trackerMgrConfig.replay_tracker_video)
+        {
+            boost::filesystem::path recording_path(trackerMgrConfig.tracker_recording_path);
+            boost::system::error_code error;
+            boost::filesystem::create_directories(recording_path, error);
+            recording_path /= "PS3EyeTracker_" + identifier + TRACKER_RECORDING_FILE_EXTENSION;
+
+            // Embed the camera config so the replay has the calibration, pose and color presets
+            std::stringstream config_stream;
+            boost::property_tree::write_json(config_stream, cfg.config2ptree());
+
+            int width, height;
+            getVideoFrameDimensions(&width, &height, nullptr);
+
+            // PSEyeVideoCapture only hands out debayered frames, so that's what gets recorded
+            CaptureData->recorder.open(
+                recording_path.string(), TrackerRecordingPixelFormat_BGR,
+                width, height, width*3, cfg.frame_rate, config_stream.str());
+        }
     }
 
     return bSuccess;
@@ -384,14 +421,41 @@ IDeviceInterface::ePollResult PS3EyeTracker::poll()
 
     if (getIsOpen())
     {
+        int width, height;
+        getVideoFrameDimensions(&width, &height, nullptr);
+
+        // Don't touch the last frame, someone might still be reading it
+        std::shared_ptr<VideoFrame> pooledFrame = CaptureData->framePool.allocateFrame(width, height, width*3);
+        cv::Mat frameMat(height, width, CV_8UC3, pooledFrame->getMutableData());
+
         if (!VideoCapture->grab() || 
-            !VideoCapture->retrieve(CaptureData->frame, cv::CAP_OPENNI_BGR_IMAGE))
+            !VideoCapture->retrieve(frameMat, cv::CAP_OPENNI_BGR_IMAGE))
         {
             // Device still in valid state
             result = IControllerInterface::_PollResultSuccessNoData;
         }
         else
         {
+            if (frameMat.data != pooledFrame->getMutableData())
+            {
+                // The capture reallocated the frame because it doesn't match the size we expected.
+                // Fall back to copying it into a pooled buffer of the right size.
+                pooledFrame = CaptureData->framePool.allocateFrame(frameMat.cols, frameMat.rows, frameMat.cols*3);
+                cv::Mat pooledFrameMat(frameMat.rows, frameMat.cols, CV_8UC3, pooledFrame->getMutableData());
+                frameMat.copyTo(pooledFrameMat);
+            }
+
+            const int64_t timestamp_us= PipelineLatencyStats::getTimestampUs();
+
+            pooledFrame->setCaptureTimeUs(timestamp_us);
+            CaptureData->frame = pooledFrame;
+
+            if (CaptureData->recorder.getIsOpen() &&
+                pooledFrame->getWidth() == width && pooledFrame->getHeight() == height)
+            {
+                CaptureData->recorder.writeFrame(pooledFrame->getData(), timestamp_us);
+            }
+
             // New data available. Keep iterating.
             result = IControllerInterface::_PollResultSuccessNewData;
         }
@@ -522,13 +586,13 @@ bool PS3EyeTracker::getVideoFrameDimensions(
     return bSuccess;
 }
 
-const unsigned char *PS3EyeTracker::getVideoFrameBuffer() const
+VideoFramePtr PS3EyeTracker::getVideoFrame() const
 {
-    const unsigned char *result = nullptr;
+    VideoFramePtr result;
 
     if (CaptureData != nullptr)
     {
-        return static_cast<const unsigned char *>(CaptureData->frame.data);
+        result = CaptureData->frame;
     }
 
     return result;
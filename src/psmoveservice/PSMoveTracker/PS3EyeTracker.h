@@ -33,7 +33,7 @@ public:
     virtual void ptree2config(const boost::property_tree::ptree &pt);
 
 	const CommonHSVColorRangeTable *getColorRangeTable(const std::string &table_name) const;
-	inline CommonHSVColorRangeTable *getOrAddColorRangeTable(const std::string &table_name);
+	CommonHSVColorRangeTable *getOrAddColorRangeTable(const std::string &table_name);
     
     bool is_valid;
     long max_poll_failure_count;
@@ -104,7 +104,7 @@ public:
     ITrackerInterface::eDriverType getDriverType() const override;
     std::string getUSBDevicePath() const override;
     bool getVideoFrameDimensions(int *out_width, int *out_height, int *out_stride) const override;
-    const unsigned char *getVideoFrameBuffer() const override;
+    VideoFramePtr getVideoFrame() const override;
     void loadSettings() override;
     void saveSettings() override;
 	void setFrameWidth(double value, bool bUpdateConfig) override;
@@ -0,0 +1,557 @@
+// -- includes -----
+#include "ReplayTracker.h"
+#include "ServerLog.h"
+#include "PSMoveProtocol.pb.h"
+#include "TrackerDeviceEnumerator.h"
+#include "TrackerFrameRecording.h"
+#include "TrackerManager.h"
+#include "DeviceManager.h"
+#include "VideoFramePool.h"
+#include "PipelineLatency.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <limits>
+#include <sstream>
+#include <string.h>
+
+// -- constants -----
+#define REPLAY_TRACKER_STATE_BUFFER_MAX 16
+
+static const char *OPTION_FOV_SETTING = "FOV Setting";
+static const char *OPTION_FOV_RED_DOT = "Red Dot";
+static const char *OPTION_FOV_BLUE_DOT = "Blue Dot";
+
+// -- private definitions -----
+class ReplayFrameData
+{
+public:
+    ReplayFrameData()
+        : framePool()
+        , frame()
+        , replayedFrameCount(0)
+    {
+    }
+
+    // Recorded frames get copied out of the mapped file into pooled buffers,
+    // since the tracker view may still be reading a frame after its chunk has been unmapped
+    VideoFramePool framePool;
+    VideoFramePtr frame;
+
+    // Number of frames delivered since the replay (re)started
+    uint32_t replayedFrameCount;
+};
+
+// -- Replay Tracker
+ReplayTracker::ReplayTracker()
+    : cfg()
+    , RecordingPath()
+    , Reader(nullptr)
+    , FrameData(nullptr)
+    , NextFrameIndex(0)
+    , ReplayStartTime()
+    , bReplayAtMaxSpeed(false)
+    , bLoopReplay(true)
+    , NextPollSequenceNumber(0)
+    , TrackerStates()
+{
+}
+
+ReplayTracker::~ReplayTracker()
+{
+    if (getIsOpen())
+    {
+        SERVER_LOG_ERROR("~ReplayTracker") << "Tracker deleted without calling close() first!";
+    }
+}
+
+// -- IDeviceInterface
+bool ReplayTracker::matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const
+{
+    // Down-cast the enumerator so we can use the correct get_path.
+    const TrackerDeviceEnumerator *pEnum = static_cast<const TrackerDeviceEnumerator *>(enumerator);
+
+    bool matches = false;
+
+    if (pEnum->get_device_type() == CommonDeviceState::ReplayTracker)
+    {
+        std::string enumerator_path = pEnum->get_path();
+
+        matches = (enumerator_path == RecordingPath);
+    }
+
+    return matches;
+}
+
+bool ReplayTracker::open(const DeviceEnumerator *enumerator)
+{
+    const TrackerDeviceEnumerator *tracker_enumerator = static_cast<const TrackerDeviceEnumerator *>(enumerator);
+    const char *cur_dev_path = tracker_enumerator->get_path();
+
+    bool bSuccess = false;
+
+    if (getIsOpen())
+    {
+        SERVER_LOG_WARNING("ReplayTracker::open") << "ReplayTracker(" << cur_dev_path << ") already open. Ignoring request.";
+        bSuccess = true;
+    }
+    else
+    {
+        SERVER_LOG_INFO("ReplayTracker::open") << "Opening ReplayTracker(" << cur_dev_path << ")";
+
+        Reader = new TrackerFrameRecordingReader;
+
+        if (Reader->open(cur_dev_path) && Reader->getFrameCount() > 0)
+        {
+            FrameData = new ReplayFrameData;
+            RecordingPath = cur_dev_path;
+            bSuccess = true;
+        }
+        else
+        {
+            SERVER_LOG_ERROR("ReplayTracker::open") << "Failed to open ReplayTracker(" << cur_dev_path << ")";
+
+            close();
+        }
+    }
+
+    if (bSuccess)
+    {
+        const TrackerManagerConfig &trackerMgrConfig= DeviceManager::getInstance()->m_tracker_manager->getConfig();
+        const std::string recording_name= boost::filesystem::path(RecordingPath).stem().string();
+        std::string config_name = "ReplayTrackerConfig_";
+        config_name.append(recording_name);
+
+        cfg = PS3EyeTrackerConfig(config_name);
+
+        // Calibration done against the replay is kept in its own config,
+        // otherwise start from the config of the camera at the time of the recording
+        if (!cfg.load() && !Reader->getTrackerConfigJson().empty())
+        {
+            try
+            {
+                std::stringstream config_stream(Reader->getTrackerConfigJson());
+                boost::property_tree::ptree pt;
+
+                boost::property_tree::read_json(config_stream, pt);
+                cfg.ptree2config(pt);
+            }
+            catch (std::exception &e)
+            {
+                SERVER_LOG_WARNING("ReplayTracker::open") << "Failed to read the recorded tracker config: " << e.what();
+            }
+        }
+        cfg.save();
+
+        bReplayAtMaxSpeed= trackerMgrConfig.replay_tracker_at_max_speed;
+        bLoopReplay= trackerMgrConfig.loop_tracker_replay;
+        restartReplay();
+
+        SERVER_LOG_INFO("ReplayTracker::open") << "Replaying " << Reader->getFrameCount() << " frames ("
+            << Reader->getHeader().width << "x" << Reader->getHeader().height << ") "
+            << (bReplayAtMaxSpeed ? "at max speed" : "at recorded speed");
+    }
+
+    return bSuccess;
+}
+
+bool ReplayTracker::getIsOpen() const
+{
+    return Reader != nullptr && Reader->getIsOpen();
+}
+
+bool ReplayTracker::getIsReadyToPoll() const
+{
+    return getIsOpen();
+}
+
+IDeviceInterface::ePollResult ReplayTracker::poll()
+{
+    IDeviceInterface::ePollResult result = IDeviceInterface::_PollResultFailure;
+
+    if (getIsOpen())
+    {
+        // Start over (or stop) once every frame has been delivered
+        if (NextFrameIndex == Reader->getFrameCount())
+        {
+            const double replay_seconds=
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - ReplayStartTime).count();
+
+            // Report the throughput, which is the headless tracking benchmark when replaying at max speed
+            SERVER_LOG_INFO("ReplayTracker::poll") << "Replayed " << FrameData->replayedFrameCount
+                << " frames of " << RecordingPath << " in " << replay_seconds << "s ("
+                << ((replay_seconds > 0.0) ? FrameData->replayedFrameCount / replay_seconds : 0.0) << " fps)";
+
+            if (bLoopReplay)
+            {
+                restartReplay();
+            }
+            else
+            {
+                // Leave the tracker open on the last frame
+                NextFrameIndex= std::numeric_limits<uint32_t>::max();
+            }
+        }
+
+        int64_t frame_timestamp_us= 0;
+        const unsigned char *recorded_frame= nullptr;
+
+        if (NextFrameIndex < Reader->getFrameCount())
+        {
+            recorded_frame= Reader->getFrame(NextFrameIndex, frame_timestamp_us);
+        }
+
+        const int64_t replay_time_us=
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ReplayStartTime).count();
+
+        if (recorded_frame == nullptr ||
+            (!bReplayAtMaxSpeed && frame_timestamp_us > replay_time_us))
+        {
+            // Device still in valid state, the next frame just isn't due yet
+            result = IDeviceInterface::_PollResultSuccessNoData;
+        }
+        else
+        {
+            const TrackerRecordingFileHeader &header= Reader->getHeader();
+
+            // Don't touch the last frame, someone might still be reading it
+            std::shared_ptr<VideoFrame> pooledFrame =
+                FrameData->framePool.allocateFrame(header.width, header.height, header.stride);
+            memcpy(pooledFrame->getMutableData(), recorded_frame, pooledFrame->getBufferSize());
+            pooledFrame->setCaptureTimeUs(PipelineLatencyStats::getTimestampUs());
+
+            FrameData->frame = pooledFrame;
+            ++FrameData->replayedFrameCount;
+
+            // Never skip frames when falling behind, so every replay processes the same frames
+            ++NextFrameIndex;
+
+            // New data available. Keep iterating.
+            result = IDeviceInterface::_PollResultSuccessNewData;
+        }
+
+        {
+            ReplayTrackerState newState;
+
+            // Increment the sequence for every new polling packet
+            newState.PollSequenceNumber = NextPollSequenceNumber;
+            ++NextPollSequenceNumber;
+
+            // Make room for new entry if at the max queue size
+            if (TrackerStates.size() >= REPLAY_TRACKER_STATE_BUFFER_MAX)
+            {
+                TrackerStates.erase(TrackerStates.begin(), TrackerStates.begin() + TrackerStates.size() - REPLAY_TRACKER_STATE_BUFFER_MAX);
+            }
+
+            TrackerStates.push_back(newState);
+        }
+    }
+
+    return result;
+}
+
+void ReplayTracker::close()
+{
+    if (FrameData != nullptr)
+    {
+        delete FrameData;
+        FrameData = nullptr;
+    }
+
+    if (Reader != nullptr)
+    {
+        delete Reader;
+        Reader = nullptr;
+    }
+}
+
+long ReplayTracker::getMaxPollFailureCount() const
+{
+    return cfg.max_poll_failure_count;
+}
+
+CommonDeviceState::eDeviceType ReplayTracker::getDeviceType() const
+{
+    return CommonDeviceState::ReplayTracker;
+}
+
+const CommonDeviceState *ReplayTracker::getState(int lookBack) const
+{
+    const int queueSize = static_cast<int>(TrackerStates.size());
+    const CommonDeviceState * result =
+        (lookBack < queueSize) ? &TrackerStates.at(queueSize - lookBack - 1) : nullptr;
+
+    return result;
+}
+
+ITrackerInterface::eDriverType ReplayTracker::getDriverType() const
+{
+    // There is no driver type for recordings in the protocol
+    return ITrackerInterface::Generic_Webcam;
+}
+
+std::string ReplayTracker::getUSBDevicePath() const
+{
+    return RecordingPath;
+}
+
+bool ReplayTracker::getVideoFrameDimensions(
+    int *out_width,
+    int *out_height,
+    int *out_stride) const
+{
+    bool bSuccess = getIsOpen();
+
+    if (bSuccess)
+    {
+        const TrackerRecordingFileHeader &header= Reader->getHeader();
+
+        if (out_width != nullptr)
+        {
+            *out_width = header.width;
+        }
+
+        if (out_height != nullptr)
+        {
+            *out_height = header.height;
+        }
+
+        if (out_stride != nullptr)
+        {
+            *out_stride = header.stride;
+        }
+    }
+
+    return bSuccess;
+}
+
+VideoFramePtr ReplayTracker::getVideoFrame() const
+{
+    VideoFramePtr result;
+
+    if (FrameData != nullptr)
+    {
+        result = FrameData->frame;
+    }
+
+    return result;
+}
+
+void ReplayTracker::loadSettings()
+{
+    cfg.load();
+}
+
+void ReplayTracker::saveSettings()
+{
+    cfg.save();
+}
+
+// The recorded frames can't be re-captured with different camera settings,
+// so the video settings are only kept in the config.
+void ReplayTracker::setFrameWidth(double value, bool bUpdateConfig)
+{
+}
+
+double ReplayTracker::getFrameWidth() const
+{
+	return getIsOpen() ? static_cast<double>(Reader->getHeader().width) : cfg.frame_width;
+}
+
+void ReplayTracker::setFrameHeight(double value, bool bUpdateConfig)
+{
+}
+
+double ReplayTracker::getFrameHeight() const
+{
+	return getIsOpen() ? static_cast<double>(Reader->getHeader().height) : cfg.frame_height;
+}
+
+void ReplayTracker::setFrameRate(double value, bool bUpdateConfig)
+{
+}
+
+double ReplayTracker::getFrameRate() const
+{
+	return getIsOpen() ? Reader->getHeader().frame_rate : cfg.frame_rate;
+}
+
+void ReplayTracker::setExposure(double value, bool bUpdateConfig)
+{
+	if (bUpdateConfig)
+	{
+		cfg.exposure = value;
+	}
+}
+
+double ReplayTracker::getExposure() const
+{
+    return cfg.exposure;
+}
+
+void ReplayTracker::setGain(double value, bool bUpdateConfig)
+{
+	if (bUpdateConfig)
+	{
+		cfg.gain = value;
+	}
+}
+
+double ReplayTracker::getGain() const
+{
+	return cfg.gain;
+}
+
+void ReplayTracker::getCameraIntrinsics(
+    float &outFocalLengthX, float &outFocalLengthY,
+    float &outPrincipalX, float &outPrincipalY,
+    float &outDistortionK1, float &outDistortionK2, float &outDistortionK3,
+    float &outDistortionP1, float &outDistortionP2) const
+{
+    outFocalLengthX = static_cast<float>(cfg.focalLengthX);
+    outFocalLengthY = static_cast<float>(cfg.focalLengthY);
+    outPrincipalX = static_cast<float>(cfg.principalX);
+    outPrincipalY = static_cast<float>(cfg.principalY);
+    outDistortionK1 = static_cast<float>(cfg.distortionK1);
+    outDistortionK2 = static_cast<float>(cfg.distortionK2);
+    outDistortionK3 = static_cast<float>(cfg.distortionK3);
+    outDistortionP1 = static_cast<float>(cfg.distortionP1);
+    outDistortionP2 = static_cast<float>(cfg.distortionP2);
+}
+
+void ReplayTracker::setCameraIntrinsics(
+    float focalLengthX, float focalLengthY,
+    float principalX, float principalY,
+    float distortionK1, float distortionK2, float distortionK3,
+    float distortionP1, float distortionP2)
+{
+    cfg.focalLengthX = focalLengthX;
+    cfg.focalLengthY = focalLengthY;
+    cfg.principalX = principalX;
+    cfg.principalY = principalY;
+    cfg.distortionK1 = distortionK1;
+    cfg.distortionK2 = distortionK2;
+    cfg.distortionK3 = distortionK3;
+    cfg.distortionP1 = distortionP1;
+    cfg.distortionP2 = distortionP2;
+}
+
+CommonDevicePose ReplayTracker::getTrackerPose() const
+{
+    return cfg.pose;
+}
+
+void ReplayTracker::setTrackerPose(
+    const struct CommonDevicePose *pose)
+{
+    cfg.pose = *pose;
+    cfg.save();
+}
+
+void ReplayTracker::getFOV(float &outHFOV, float &outVFOV) const
+{
+    outHFOV = static_cast<float>(cfg.hfov);
+    outVFOV = static_cast<float>(cfg.vfov);
+}
+
+void ReplayTracker::getZRange(float &outZNear, float &outZFar) const
+{
+    outZNear = static_cast<float>(cfg.zNear);
+    outZFar = static_cast<float>(cfg.zFar);
+}
+
+void ReplayTracker::gatherTrackerOptions(
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+    PSMoveProtocol::OptionSet *optionSet = settings->add_option_sets();
+
+    optionSet->set_option_name(OPTION_FOV_SETTING);
+    optionSet->add_option_strings(OPTION_FOV_RED_DOT);
+    optionSet->add_option_strings(OPTION_FOV_BLUE_DOT);
+    optionSet->set_option_index(static_cast<int>(cfg.fovSetting));
+}
+
+bool ReplayTracker::setOptionIndex(
+    const std::string &option_name,
+    int option_index)
+{
+    bool bValidOption = false;
+
+    if (option_name == OPTION_FOV_SETTING &&
+        option_index >= 0 &&
+        option_index < PS3EyeTrackerConfig::eFOVSetting::MAX_FOV_SETTINGS)
+    {
+        cfg.fovSetting = static_cast<PS3EyeTrackerConfig::eFOVSetting>(option_index);
+
+        bValidOption = true;
+    }
+
+    return bValidOption;
+}
+
+bool ReplayTracker::getOptionIndex(
+    const std::string &option_name,
+    int &out_option_index) const
+{
+    bool bValidOption = false;
+
+    if (option_name == OPTION_FOV_SETTING)
+    {
+        out_option_index = static_cast<int>(cfg.fovSetting);
+        bValidOption = true;
+    }
+
+    return bValidOption;
+}
+
+void ReplayTracker::gatherTrackingColorPresets(
+	const std::string &controller_serial,
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+	const CommonHSVColorRangeTable *table= cfg.getColorRangeTable(controller_serial);
+
+    for (int list_index = 0; list_index < MAX_TRACKING_COLOR_TYPES; ++list_index)
+    {
+        const CommonHSVColorRange &hsvRange = table->color_presets[list_index];
+        const eCommonTrackingColorID colorType = static_cast<eCommonTrackingColorID>(list_index);
+
+        PSMoveProtocol::TrackingColorPreset *colorPreset= settings->add_color_presets();
+        colorPreset->set_color_type(static_cast<PSMoveProtocol::TrackingColorType>(colorType));
+        colorPreset->set_hue_center(hsvRange.hue_range.center);
+        colorPreset->set_hue_range(hsvRange.hue_range.range);
+        colorPreset->set_saturation_center(hsvRange.saturation_range.center);
+        colorPreset->set_saturation_range(hsvRange.saturation_range.range);
+        colorPreset->set_value_center(hsvRange.value_range.center);
+        colorPreset->set_value_range(hsvRange.value_range.range);
+    }
+}
+
+void ReplayTracker::setTrackingColorPreset(
+	const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    const CommonHSVColorRange *preset)
+{
+	CommonHSVColorRangeTable *table= cfg.getOrAddColorRangeTable(controller_serial);
+
+    table->color_presets[color] = *preset;
+    cfg.save();
+}
+
+void ReplayTracker::getTrackingColorPreset(
+	const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    CommonHSVColorRange *out_preset) const
+{
+	const CommonHSVColorRangeTable *table= cfg.getColorRangeTable(controller_serial);
+
+    *out_preset = table->color_presets[color];
+}
+
+// -- private methods -----
+void ReplayTracker::restartReplay()
+{
+    NextFrameIndex= 0;
+    ReplayStartTime= std::chrono::steady_clock::now();
+    FrameData->replayedFrameCount= 0;
+}
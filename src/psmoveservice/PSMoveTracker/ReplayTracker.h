@@ -0,0 +1,107 @@
+#ifndef REPLAY_TRACKER_H
+#define REPLAY_TRACKER_H
+
+// -- includes -----
+#include "PS3EyeTracker.h"
+#include <chrono>
+#include <string>
+#include <deque>
+
+// -- definitions -----
+struct ReplayTrackerState : public CommonDeviceState
+{
+    ReplayTrackerState()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        CommonDeviceState::clear();
+        DeviceType = CommonDeviceState::ReplayTracker;
+    }
+};
+
+/// Plays back a tracker recording (see TrackerFrameRecording.h) as if it were a live camera.
+/// Every recorded frame is delivered exactly once and in order, either at the recorded frame timing
+/// or as fast as the tracker view can consume them, so replays are deterministic.
+class ReplayTracker : public ITrackerInterface {
+public:
+    ReplayTracker();
+    virtual ~ReplayTracker();
+
+    // -- IDeviceInterface
+    bool matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const override;
+    bool open(const DeviceEnumerator *enumerator) override;
+    bool getIsOpen() const override;
+    bool getIsReadyToPoll() const override;
+    IDeviceInterface::ePollResult poll() override;
+    void close() override;
+    long getMaxPollFailureCount() const override;
+    static CommonDeviceState::eDeviceType getDeviceTypeStatic()
+    { return CommonDeviceState::ReplayTracker; }
+    CommonDeviceState::eDeviceType getDeviceType() const override;
+    const CommonDeviceState *getState(int lookBack = 0) const override;
+
+    // -- ITrackerInterface
+    ITrackerInterface::eDriverType getDriverType() const override;
+    std::string getUSBDevicePath() const override;
+    bool getVideoFrameDimensions(int *out_width, int *out_height, int *out_stride) const override;
+    VideoFramePtr getVideoFrame() const override;
+    void loadSettings() override;
+    void saveSettings() override;
+	void setFrameWidth(double value, bool bUpdateConfig) override;
+	double getFrameWidth() const override;
+	void setFrameHeight(double value, bool bUpdateConfig) override;
+	double getFrameHeight() const override;
+	void setFrameRate(double value, bool bUpdateConfig) override;
+	double getFrameRate() const override;
+    void setExposure(double value, bool bUpdateConfig) override;
+    double getExposure() const override;
+	void setGain(double value, bool bUpdateConfig) override;
+	double getGain() const override;
+    void getCameraIntrinsics(
+        float &outFocalLengthX, float &outFocalLengthY,
+        float &outPrincipalX, float &outPrincipalY,
+        float &outDistortionK1, float &outDistortionK2, float &outDistortionK3,
+        float &outDistortionP1, float &outDistortionP2) const override;
+    void setCameraIntrinsics(
+        float focalLengthX, float focalLengthY,
+        float principalX, float principalY,
+        float distortionK1, float distortionK2, float distortionK3,
+        float distortionP1, float distortionP2) override;
+    CommonDevicePose getTrackerPose() const override;
+    void setTrackerPose(const struct CommonDevicePose *pose) override;
+    void getFOV(float &outHFOV, float &outVFOV) const override;
+    void getZRange(float &outZNear, float &outZFar) const override;
+    void gatherTrackerOptions(PSMoveProtocol::Response_ResultTrackerSettings* settings) const override;
+    bool setOptionIndex(const std::string &option_name, int option_index) override;
+    bool getOptionIndex(const std::string &option_name, int &out_option_index) const override;
+    void gatherTrackingColorPresets(const std::string &controller_serial, PSMoveProtocol::Response_ResultTrackerSettings* settings) const override;
+    void setTrackingColorPreset(const std::string &controller_serial, eCommonTrackingColorID color, const CommonHSVColorRange *preset) override;
+    void getTrackingColorPreset(const std::string &controller_serial, eCommonTrackingColorID color, CommonHSVColorRange *out_preset) const override;
+
+    // -- Getters
+    // The recorded camera settings (calibration, pose and color presets)
+    inline const PS3EyeTrackerConfig &getConfig() const
+    { return cfg; }
+
+private:
+    void restartReplay();
+
+    PS3EyeTrackerConfig cfg;
+    std::string RecordingPath;
+    class TrackerFrameRecordingReader *Reader;
+    class ReplayFrameData *FrameData;
+
+    // Replay progress
+    uint32_t NextFrameIndex;
+    std::chrono::steady_clock::time_point ReplayStartTime;
+    bool bReplayAtMaxSpeed;
+    bool bLoopReplay;
+
+    // Read Tracker State
+    int NextPollSequenceNumber;
+    std::deque<ReplayTrackerState> TrackerStates;
+};
+#endif // REPLAY_TRACKER_H
@@ -0,0 +1,359 @@
+// -- includes -----
+#include "TrackerFrameRecording.h"
+#include "ServerLog.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <assert.h>
+#include <fstream>
+#include <string.h>
+
+// -- constants -----
+static const char k_recording_magic[8]= {'P', 'S', 'M', 'V', 'R', 'E', 'C', '\0'};
+static const uint32_t k_recording_version= 1;
+static const RecordingFileFormat k_recording_format(k_recording_magic, k_recording_version, "tracker");
+static const uint32_t k_frames_per_chunk= 64;
+static const uint64_t k_frames_alignment= 4096;
+
+// -- prototypes -----
+static uint64_t compute_frame_record_size(const TrackerRecordingFileHeader &header);
+static uint64_t compute_frames_offset(const TrackerRecordingFileHeader &header);
+
+// -- TrackerFrameRecordingWriter -----
+TrackerFrameRecordingWriter::TrackerFrameRecordingWriter()
+    : m_path()
+    , m_framesOffset(0)
+    , m_fileMapping(nullptr)
+    , m_chunkRegion(nullptr)
+    , m_mappedChunkIndex(0)
+    , m_firstTimestampUs(0)
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+TrackerFrameRecordingWriter::~TrackerFrameRecordingWriter()
+{
+    close();
+}
+
+bool TrackerFrameRecordingWriter::open(
+    const std::string &path,
+    eTrackerRecordingPixelFormat pixel_format, int width, int height, int stride, double frame_rate,
+    const std::string &tracker_config_json)
+{
+    close();
+
+    k_recording_format.initHeader(m_header, tracker_config_json);
+    m_header.pixel_format= pixel_format;
+    m_header.width= width;
+    m_header.height= height;
+    m_header.stride= stride;
+    m_header.frames_per_chunk= k_frames_per_chunk;
+    m_header.frame_count= 0;
+    m_header.frame_rate= frame_rate;
+    m_framesOffset= compute_frames_offset(m_header);
+    m_path= path;
+
+    // Write out the header and config, the frames get written through memory mapped chunks
+    {
+        std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open() || !k_recording_format.writeHeader(file, m_header, tracker_config_json))
+        {
+            SERVER_LOG_ERROR("TrackerFrameRecordingWriter::open") << "Failed to create tracker recording: " << path;
+            return false;
+        }
+    }
+
+    try
+    {
+        boost::filesystem::resize_file(path, m_framesOffset);
+        m_fileMapping= new boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_write);
+    }
+    catch (std::exception &e)
+    {
+        SERVER_LOG_ERROR("TrackerFrameRecordingWriter::open") << "Failed to map tracker recording: " << path << ", reason: " << e.what();
+        close();
+        return false;
+    }
+
+    SERVER_LOG_INFO("TrackerFrameRecordingWriter::open") << "Recording tracker video to: " << path;
+
+    return true;
+}
+
+bool TrackerFrameRecordingWriter::getIsOpen() const
+{
+    return m_fileMapping != nullptr;
+}
+
+bool TrackerFrameRecordingWriter::writeFrame(const unsigned char *frame_buffer, int64_t timestamp_us)
+{
+    if (!getIsOpen())
+    {
+        return false;
+    }
+
+    const uint32_t frame_index= m_header.frame_count;
+    const uint32_t chunk_index= frame_index / m_header.frames_per_chunk;
+
+    if ((m_chunkRegion == nullptr || chunk_index != m_mappedChunkIndex) && !mapChunk(chunk_index))
+    {
+        // Out of disk space or similar, stop recording rather than failing every frame
+        close();
+        return false;
+    }
+
+    if (frame_index == 0)
+    {
+        m_firstTimestampUs= timestamp_us;
+    }
+
+    const uint64_t record_size= compute_frame_record_size(m_header);
+    unsigned char *record=
+        static_cast<unsigned char *>(m_chunkRegion->get_address()) +
+        (frame_index % m_header.frames_per_chunk)*record_size;
+
+    TrackerRecordingFrameHeader frame_header;
+    frame_header.timestamp_us= timestamp_us - m_firstTimestampUs;
+    frame_header.frame_index= frame_index;
+    frame_header.reserved= 0;
+
+    memcpy(record, &frame_header, sizeof(frame_header));
+    memcpy(record + sizeof(frame_header), frame_buffer, static_cast<size_t>(m_header.stride)*m_header.height);
+    ++m_header.frame_count;
+
+    return true;
+}
+
+void TrackerFrameRecordingWriter::close()
+{
+    unmapChunk();
+
+    if (m_fileMapping != nullptr)
+    {
+        delete m_fileMapping;
+        m_fileMapping= nullptr;
+
+        // Trim the unused part of the last chunk and record the final frame count
+        try
+        {
+            boost::filesystem::resize_file(m_path, m_framesOffset + m_header.frame_count*compute_frame_record_size(m_header));
+        }
+        catch (std::exception &e)
+        {
+            SERVER_LOG_WARNING("TrackerFrameRecordingWriter::close") << "Failed to trim tracker recording: " << m_path << ", reason: " << e.what();
+        }
+
+        writeHeader();
+
+        SERVER_LOG_INFO("TrackerFrameRecordingWriter::close") << "Recorded " << m_header.frame_count << " frames to: " << m_path;
+    }
+}
+
+bool TrackerFrameRecordingWriter::mapChunk(uint32_t chunk_index)
+{
+    const uint64_t chunk_size= m_header.frames_per_chunk*compute_frame_record_size(m_header);
+    const uint64_t chunk_offset= m_framesOffset + chunk_index*chunk_size;
+
+    unmapChunk();
+
+    // Keep the frame count on disk current, in case we never get to close the recording
+    writeHeader();
+
+    try
+    {
+        boost::filesystem::resize_file(m_path, chunk_offset + chunk_size);
+        m_chunkRegion=
+            new boost::interprocess::mapped_region(
+                *m_fileMapping, boost::interprocess::read_write,
+                static_cast<boost::interprocess::offset_t>(chunk_offset), static_cast<size_t>(chunk_size));
+        m_mappedChunkIndex= chunk_index;
+    }
+    catch (std::exception &e)
+    {
+        SERVER_LOG_ERROR("TrackerFrameRecordingWriter::mapChunk") << "Failed to grow tracker recording: " << m_path << ", reason: " << e.what();
+        return false;
+    }
+
+    return true;
+}
+
+void TrackerFrameRecordingWriter::unmapChunk()
+{
+    if (m_chunkRegion != nullptr)
+    {
+        delete m_chunkRegion;
+        m_chunkRegion= nullptr;
+    }
+}
+
+void TrackerFrameRecordingWriter::writeHeader()
+{
+    std::fstream file(m_path.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+
+    if (file.is_open())
+    {
+        file.seekp(0);
+        file.write(reinterpret_cast<const char *>(&m_header), sizeof(m_header));
+    }
+}
+
+// -- TrackerFrameRecordingReader -----
+TrackerFrameRecordingReader::TrackerFrameRecordingReader()
+    : m_path()
+    , m_trackerConfigJson()
+    , m_framesOffset(0)
+    , m_fileMapping(nullptr)
+    , m_chunkRegion(nullptr)
+    , m_mappedChunkIndex(0)
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+TrackerFrameRecordingReader::~TrackerFrameRecordingReader()
+{
+    close();
+}
+
+bool TrackerFrameRecordingReader::open(const std::string &path)
+{
+    close();
+
+    m_path= path;
+
+    {
+        std::ifstream file(path.c_str(), std::ios::binary);
+
+        if (!k_recording_format.readHeader(file, path, m_header, m_trackerConfigJson))
+        {
+            return false;
+        }
+
+        if (m_header.pixel_format != TrackerRecordingPixelFormat_BGR ||
+            m_header.width <= 0 || m_header.height <= 0 || m_header.stride < m_header.width*3 ||
+            m_header.frames_per_chunk == 0)
+        {
+            SERVER_LOG_ERROR("TrackerFrameRecordingReader::open") << "Unsupported tracker recording: " << path;
+            return false;
+        }
+    }
+
+    m_framesOffset= compute_frames_offset(m_header);
+
+    try
+    {
+        // The recorder may not have been closed cleanly, in which case the header only counts
+        // the frames before the last chunk and the file may end in the middle of a chunk
+        const uint64_t complete_frames=
+            RecordingFileFormat::countCompleteRecords(
+                boost::filesystem::file_size(path), m_framesOffset, compute_frame_record_size(m_header));
+
+        m_header.frame_count= static_cast<uint32_t>(std::min<uint64_t>(m_header.frame_count, complete_frames));
+        m_fileMapping= new boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+    }
+    catch (std::exception &e)
+    {
+        SERVER_LOG_ERROR("TrackerFrameRecordingReader::open") << "Failed to map tracker recording: " << path << ", reason: " << e.what();
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool TrackerFrameRecordingReader::getIsOpen() const
+{
+    return m_fileMapping != nullptr;
+}
+
+void TrackerFrameRecordingReader::close()
+{
+    unmapChunk();
+
+    if (m_fileMapping != nullptr)
+    {
+        delete m_fileMapping;
+        m_fileMapping= nullptr;
+    }
+}
+
+const unsigned char *TrackerFrameRecordingReader::getFrame(uint32_t frame_index, int64_t &out_timestamp_us)
+{
+    if (!getIsOpen() || frame_index >= m_header.frame_count)
+    {
+        return nullptr;
+    }
+
+    const uint32_t chunk_index= frame_index / m_header.frames_per_chunk;
+
+    if ((m_chunkRegion == nullptr || chunk_index != m_mappedChunkIndex) && !mapChunk(chunk_index))
+    {
+        return nullptr;
+    }
+
+    const unsigned char *record=
+        static_cast<const unsigned char *>(m_chunkRegion->get_address()) +
+        (frame_index % m_header.frames_per_chunk)*compute_frame_record_size(m_header);
+
+    TrackerRecordingFrameHeader frame_header;
+    memcpy(&frame_header, record, sizeof(frame_header));
+    out_timestamp_us= frame_header.timestamp_us;
+
+    return record + sizeof(frame_header);
+}
+
+bool TrackerFrameRecordingReader::mapChunk(uint32_t chunk_index)
+{
+    const uint64_t record_size= compute_frame_record_size(m_header);
+    const uint32_t first_frame= chunk_index*m_header.frames_per_chunk;
+    const uint32_t chunk_frame_count= std::min(m_header.frames_per_chunk, m_header.frame_count - first_frame);
+
+    unmapChunk();
+
+    try
+    {
+        // The last chunk is usually only partially filled
+        m_chunkRegion=
+            new boost::interprocess::mapped_region(
+                *m_fileMapping, boost::interprocess::read_only,
+                static_cast<boost::interprocess::offset_t>(m_framesOffset + first_frame*record_size),
+                static_cast<size_t>(chunk_frame_count*record_size));
+        m_mappedChunkIndex= chunk_index;
+    }
+    catch (std::exception &e)
+    {
+        SERVER_LOG_ERROR("TrackerFrameRecordingReader::mapChunk") << "Failed to map tracker recording: " << m_path << ", reason: " << e.what();
+        return false;
+    }
+
+    return true;
+}
+
+void TrackerFrameRecordingReader::unmapChunk()
+{
+    if (m_chunkRegion != nullptr)
+    {
+        delete m_chunkRegion;
+        m_chunkRegion= nullptr;
+    }
+}
+
+// -- private methods -----
+static uint64_t compute_frame_record_size(const TrackerRecordingFileHeader &header)
+{
+    const uint64_t size= sizeof(TrackerRecordingFrameHeader) + static_cast<uint64_t>(header.stride)*header.height;
+
+    // Keep every frame header 16 byte aligned
+    return (size + 15) & ~static_cast<uint64_t>(15);
+}
+
+static uint64_t compute_frames_offset(const TrackerRecordingFileHeader &header)
+{
+    const uint64_t size= sizeof(TrackerRecordingFileHeader) + header.config_size;
+
+    return (size + k_frames_alignment - 1) & ~(k_frames_alignment - 1);
+}
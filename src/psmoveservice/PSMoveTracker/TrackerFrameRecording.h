@@ -0,0 +1,118 @@
+#ifndef TRACKER_FRAME_RECORDING_H
+#define TRACKER_FRAME_RECORDING_H
+
+// -- includes -----
+#include "RecordingFile.h"
+
+#include <stdint.h>
+#include <string>
+
+// -- pre-declarations -----
+namespace boost
+{
+    namespace interprocess
+    {
+        class file_mapping;
+        class mapped_region;
+    };
+};
+
+// -- constants -----
+#define TRACKER_RECORDING_FILE_EXTENSION ".psmrec"
+
+// -- definitions -----
+// A recording is a header, the json config of the tracker that was recorded,
+// and then chunks of fixed size frame records (timestamp + pixels).
+// The file grows a chunk at a time and only the current chunk is mapped into memory,
+// so recordings can get much bigger than the address space.
+enum eTrackerRecordingPixelFormat
+{
+    TrackerRecordingPixelFormat_BGR= 0, // 3 bytes per pixel, what the tracker views read
+};
+
+struct TrackerRecordingFileHeader
+{
+    RecordingFileTag tag;
+    uint32_t pixel_format; // eTrackerRecordingPixelFormat
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    uint32_t frames_per_chunk;
+    uint32_t frame_count; // number of complete frames in the file
+    uint32_t config_size; // size of the json config that follows the header
+    double frame_rate;
+    uint8_t reserved[16];
+};
+
+struct TrackerRecordingFrameHeader
+{
+    int64_t timestamp_us; // relative to the first frame of the recording
+    uint32_t frame_index;
+    uint32_t reserved;
+};
+
+class TrackerFrameRecordingWriter
+{
+public:
+    TrackerFrameRecordingWriter();
+    virtual ~TrackerFrameRecordingWriter();
+
+    bool open(
+        const std::string &path,
+        eTrackerRecordingPixelFormat pixel_format, int width, int height, int stride, double frame_rate,
+        const std::string &tracker_config_json);
+    bool getIsOpen() const;
+    bool writeFrame(const unsigned char *frame_buffer, int64_t timestamp_us);
+    void close();
+
+    inline uint32_t getFrameCount() const
+    { return m_header.frame_count; }
+
+private:
+    bool mapChunk(uint32_t chunk_index);
+    void unmapChunk();
+    void writeHeader();
+
+    std::string m_path;
+    TrackerRecordingFileHeader m_header;
+    uint64_t m_framesOffset;
+    boost::interprocess::file_mapping *m_fileMapping;
+    boost::interprocess::mapped_region *m_chunkRegion;
+    uint32_t m_mappedChunkIndex;
+    int64_t m_firstTimestampUs;
+};
+
+class TrackerFrameRecordingReader
+{
+public:
+    TrackerFrameRecordingReader();
+    virtual ~TrackerFrameRecordingReader();
+
+    bool open(const std::string &path);
+    bool getIsOpen() const;
+    void close();
+
+    /// Returns the pixels of the given frame, valid until the next call to getFrame() or close()
+    const unsigned char *getFrame(uint32_t frame_index, int64_t &out_timestamp_us);
+
+    inline const TrackerRecordingFileHeader &getHeader() const
+    { return m_header; }
+    inline uint32_t getFrameCount() const
+    { return m_header.frame_count; }
+    inline const std::string &getTrackerConfigJson() const
+    { return m_trackerConfigJson; }
+
+private:
+    bool mapChunk(uint32_t chunk_index);
+    void unmapChunk();
+
+    std::string m_path;
+    TrackerRecordingFileHeader m_header;
+    std::string m_trackerConfigJson;
+    uint64_t m_framesOffset;
+    boost::interprocess::file_mapping *m_fileMapping;
+    boost::interprocess::mapped_region *m_chunkRegion;
+    uint32_t m_mappedChunkIndex;
+};
+
+#endif // TRACKER_FRAME_RECORDING_H
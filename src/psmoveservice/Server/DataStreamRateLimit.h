@@ -0,0 +1,52 @@
+#ifndef DATA_STREAM_RATE_LIMIT_H
+#define DATA_STREAM_RATE_LIMIT_H
+
+//-- includes -----
+#include <algorithm>
+#include <chrono>
+
+//-- utility methods -----
+namespace DataStreamRateLimit
+{
+    typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_time_point;
+
+    /// Returns true if the stream should get the device state being published right now.
+    /// A rate limited stream that isn't due yet skips the state and gets flagged as deferred,
+    /// so that the freshest state goes out to it as soon as its publish interval has elapsed.
+    /// inout_deferred_deadline is pulled in to the time the skipped state becomes due.
+    /// Publishing with bDeferredStreamsOnly set only considers streams flagged as deferred.
+    /// t_stream_info is a ControllerStreamInfo or an HMDStreamInfo.
+    template <typename t_stream_info>
+    bool is_stream_publish_due(
+        t_stream_info &stream_info,
+        const t_time_point &now,
+        bool bDeferredStreamsOnly,
+        t_time_point &inout_deferred_deadline)
+    {
+        if (bDeferredStreamsOnly && !stream_info.has_deferred_publish)
+        {
+            return false;
+        }
+
+        if (stream_info.publish_rate_hz > 0.f)
+        {
+            const std::chrono::duration<double> publish_interval(1.0 / static_cast<double>(stream_info.publish_rate_hz));
+            const t_time_point due_time=
+                stream_info.last_publish_timestamp +
+                std::chrono::duration_cast<t_time_point::duration>(publish_interval);
+
+            if (now < due_time)
+            {
+                stream_info.has_deferred_publish= true;
+                inout_deferred_deadline= std::min(inout_deferred_deadline, due_time);
+                return false;
+            }
+        }
+
+        stream_info.has_deferred_publish= false;
+        stream_info.last_publish_timestamp= now;
+        return true;
+    }
+};
+
+#endif // DATA_STREAM_RATE_LIMIT_H
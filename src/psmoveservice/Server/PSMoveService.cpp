@@ -5,6 +5,7 @@
 #include "ServerNetworkManager.h"
 #include "ServerRequestHandler.h"
 #include "DeviceManager.h"
+#include "MainLoopWakeSignal.h"
 #include "ProtocolVersion.h"
 #include "ServerLog.h"
 #include "SharedTrackerState.h"
@@ -14,6 +15,7 @@
 #include <boost/asio.hpp>
 #include <boost/application.hpp>
 #include <boost/program_options.hpp>
+#include <algorithm>
 #include <fstream>
 #include <cstdio>
 #include <string>
@@ -32,6 +34,10 @@
 #define DAEMON_LOCK_FILE	"psmoveserviced.lock"
 #endif // defined(BOOST_POSIX_API)
 
+// Longest the event driven main loop sleeps with nothing to do.
+// Bounds how long async bluetooth requests and platform hotplug events wait to be looked at.
+static const int k_max_idle_wait_ms= 100;
+
 //-- definitions -----
 class PSMoveServiceImpl
 {
@@ -75,7 +81,14 @@ public:
                         update();
                     }
 
-					std::this_thread::sleep_for(std::chrono::milliseconds(cfg.tracker_sleep_ms));
+                    if (cfg.use_event_driven_main_loop)
+                    {
+                        wait_for_work();
+                    }
+                    else
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(cfg.tracker_sleep_ms));
+                    }
                 }
             }
             else
@@ -107,6 +120,7 @@ public:
         {
             SERVER_LOG_WARNING("PSMoveService") << "Received stop request. Stopping Service.";
             m_status->state(boost::application::status::stoped);
+            MainLoopWakeSignal::notify();
         }
 
         return true;
@@ -118,6 +132,7 @@ public:
         {
             SERVER_LOG_WARNING("PSMoveService") << "Received pause request. Pausing Service.";
             m_status->state(boost::application::status::paused);
+            MainLoopWakeSignal::notify();
         }
 
         return true;
@@ -129,6 +144,7 @@ public:
         {
             SERVER_LOG_WARNING("PSMoveService") << "Received resume request. Resuming Service.";
             m_status->state(boost::application::status::running);
+            MainLoopWakeSignal::notify();
         }
 
         return true;
@@ -179,7 +195,9 @@ private:
 		*/
         if (success)
         {
-            if (!m_network_manager.startup(&m_io_service, &m_request_handler))
+            const TrackerManagerConfig &cfg = DeviceManager::getInstance()->m_tracker_manager->getConfig();
+
+            if (!m_network_manager.startup(&m_io_service, &m_request_handler, cfg.use_event_driven_main_loop))
             {
                 SERVER_LOG_FATAL("PSMoveService") << "Failed to initialize the service network manager";
                 success= false;
@@ -218,6 +236,27 @@ private:
         m_network_manager.update();
     }
 
+    /// Sleeps until a device thread or the network thread hands over work,
+    /// or until the device managers have timed polling, reconnect or deferred publish work to do.
+    /// PS3Eye frames have no arrival signal (the camera driver has no frame callback), they are pulled at the tracker poll deadline.
+    void wait_for_work()
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+
+        // The network thread signals socket activity, startup() made sure it runs
+        std::chrono::time_point<std::chrono::high_resolution_clock> deadline= now + std::chrono::milliseconds(k_max_idle_wait_ms);
+
+        if (m_status->state() != boost::application::status::paused)
+        {
+            deadline= std::min(deadline, m_device_manager.getNextPollDeadline());
+        }
+
+        if (deadline > now)
+        {
+            MainLoopWakeSignal::waitUntil(deadline);
+        }
+    }
+
     void shutdown()
     {
         // Kill any pending request state
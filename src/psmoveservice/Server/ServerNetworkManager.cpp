@@ -2,15 +2,23 @@
 #include "ServerNetworkManager.h"
 #include "ServerRequestHandler.h"
 #include "ServerLog.h"
+#include "CompactDataFrame.h"
 #include "PackedMessage.h"
+#include "MainLoopWakeSignal.h"
+#include "PipelineLatency.h"
+#include "ProtocolMessagePool.h"
 #include "PSMoveProtocolInterface.h"
 #include "PSMoveProtocol.pb.h"
+#include "WorkerThread.h"
+#include "readerwriterqueue.h" // lockfree queue
+#include <atomic>
 #include <cassert>
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <vector>
 #include <deque>
+#include <algorithm>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
@@ -31,16 +39,86 @@ typedef map<int, ClientConnectionPtr> t_client_connection_map;
 typedef map<int, ClientConnectionPtr>::iterator t_client_connection_map_iter;
 typedef std::pair<int, ClientConnectionPtr> t_id_client_connection_pair;
 
+// Packed data frames handed from the main thread to a connection on the network thread
+typedef moodycamel::ReaderWriterQueue<PackedDataFramePtr> t_data_frame_queue;
+typedef std::shared_ptr<t_data_frame_queue> t_data_frame_queue_ptr;
+typedef map<int, t_data_frame_queue_ptr> t_data_frame_queue_map;
+
 //-- constants -----
 const int PSMOVE_SERVER_PORT = 9512;
 
+// How many data frames a connection can have waiting for the network thread before new ones are dropped
+const size_t k_data_frame_queue_capacity = 256;
+
+// How many packed data frames get recycled. Covers a frame per device for a few ticks worth of queued frames.
+const size_t k_packed_data_frame_pool_capacity = 64;
+
+//-- globals -----
+// Packed data frames only ever get packed on the main thread
+static ProtocolMessagePool<PackedDataFrame> g_packed_data_frame_pool(k_packed_data_frame_pool_capacity);
+
+// asio only gathers this many buffers into one send on some platforms, the rest would be silently cut off
+const size_t k_max_data_frames_per_datagram = 64;
+
 //-- private implementation -----
 class IServerNetworkEventListener
 {
 public:
+	virtual void handle_client_request(int connection_id, RequestPtr request) = 0;
 	virtual void handle_client_connection_stopped(int connection_id) = 0;
 };
 
+/// Something the network thread received that the main thread has to handle
+struct ServerNetworkEvent
+{
+    enum eEventType
+    {
+        ConnectionStarted,
+        ConnectionStopped,
+        RequestReceived,
+        InputDataFrameReceived
+    };
+
+    eEventType event_type;
+    int connection_id;
+    RequestPtr request;
+    DeviceInputDataFramePtr input_data_frame;
+    t_data_frame_queue_ptr data_frame_queue;
+};
+
+/// Runs the socket work of the network manager, so it isn't paced by the main loop
+class NetworkIOThread : public WorkerThread
+{
+public:
+    NetworkIOThread(asio::io_service &io_service)
+        : WorkerThread("NetworkIOThread")
+        , m_io_service(io_service)
+        , m_work(io_service)
+    {
+    }
+
+protected:
+    void onThreadHaltBegin() override
+    {
+        // Wake up the worker thread so that it sees the exit signal
+        m_io_service.stop();
+    }
+
+    bool doWork() override
+    {
+        // Blocks until a socket operation completes or a handler is posted
+        m_io_service.run_one();
+
+        return true;
+    }
+
+private:
+    asio::io_service &m_io_service;
+
+    // Keeps run_one() waiting when there are no socket operations pending
+    asio::io_service::work m_work;
+};
+
 //-- Network Manager Config -----
 const int NetworkManagerConfig::CONFIG_VERSION = 1;
 
@@ -48,6 +126,9 @@ NetworkManagerConfig::NetworkManagerConfig(const std::string &fnamebase)
     : PSMoveConfig(fnamebase)
 {
 	server_port= PSMOVE_SERVER_PORT;
+	batch_udp_data_frames= false;
+	udp_max_datagram_size= DEFAULT_OUTPUT_DATA_FRAME_DATAGRAM_SIZE;
+	use_network_thread= false;
 };
 
 const boost::property_tree::ptree
@@ -57,6 +138,9 @@ NetworkManagerConfig::config2ptree()
 
     pt.put("version", NetworkManagerConfig::CONFIG_VERSION);
 	pt.put("server_port", server_port);
+	pt.put("batch_udp_data_frames", batch_udp_data_frames);
+	pt.put("udp_max_datagram_size", udp_max_datagram_size);
+	pt.put("use_network_thread", use_network_thread);
 
     return pt;
 }
@@ -69,10 +153,13 @@ NetworkManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
     if (version == NetworkManagerConfig::CONFIG_VERSION)
     {
 		server_port = pt.get<int>("server_port", server_port);
+		batch_udp_data_frames = pt.get<bool>("batch_udp_data_frames", batch_udp_data_frames);
+		udp_max_datagram_size = pt.get<int>("udp_max_datagram_size", udp_max_datagram_size);
+		use_network_thread = pt.get<bool>("use_network_thread", use_network_thread);
     }
     else
     {
-        SERVER_LOG_WARNING("NetworkManagerConfig") <<
+        SERVER_MT_LOG_WARNING("NetworkManagerConfig") <<
             "Config version " << version << " does not match expected version " <<
             NetworkManagerConfig::CONFIG_VERSION << ", Using defaults.";
     }
@@ -92,7 +179,7 @@ public:
         // Socket should have been closed by this point
         if (m_tcp_socket.is_open())
         {
-            SERVER_LOG_ERROR("~ClientConnection") << "Client connection " << m_connection_id << " deleted without calling stop()";
+            SERVER_MT_LOG_ERROR("~ClientConnection") << "Client connection " << m_connection_id << " deleted without calling stop()";
         }
     }
 
@@ -100,14 +187,14 @@ public:
         IServerNetworkEventListener* network_event_listener,
         asio::io_service& io_service_ref,
         udp::socket& udp_socket_ref, 
-        ServerRequestHandler &request_handler_ref)
+        const NetworkManagerConfig &cfg)
     {
         return ClientConnectionPtr(
             new ClientConnection(
                 network_event_listener, 
                 io_service_ref, 
                 udp_socket_ref, 
-                request_handler_ref));
+                cfg));
     }
 
     int get_connection_id() const
@@ -120,9 +207,14 @@ public:
         return m_tcp_socket;
     }
 
+    t_data_frame_queue_ptr get_data_frame_queue() const
+    {
+        return m_data_frame_queue;
+    }
+
     void start()
     {
-        SERVER_LOG_INFO("ClientConnection::start") << "Starting client connection id " << m_connection_id;
+        SERVER_MT_LOG_INFO("ClientConnection::start") << "Starting client connection id " << m_connection_id;
 
         m_connection_started= true;
         m_connection_stopped= false;
@@ -139,7 +231,7 @@ public:
     {
         if (!m_connection_stopped)
         {
-            SERVER_LOG_INFO("ClientConnection::stop") << "Stopping client connection id " << m_connection_id;
+            SERVER_MT_LOG_INFO("ClientConnection::stop") << "Stopping client connection id " << m_connection_id;
 
             if (m_tcp_socket.is_open())
             {
@@ -148,13 +240,13 @@ public:
                 m_tcp_socket.shutdown(asio::socket_base::shutdown_both, error);
                 if (error)
                 {
-                    SERVER_LOG_ERROR("ClientConnection::stop") << "Unable to shut down the tcp socket: " << error.value();
+                    SERVER_MT_LOG_ERROR("ClientConnection::stop") << "Unable to shut down the tcp socket: " << error.value();
                 }
                 
                 m_tcp_socket.close(error);
                 if (error)
                 {
-                    SERVER_LOG_ERROR("ClientConnection::stop") << "Unable to close the tcp socket: " << error.value();
+                    SERVER_MT_LOG_ERROR("ClientConnection::stop") << "Unable to close the tcp socket: " << error.value();
                 }
             }
             
@@ -167,13 +259,13 @@ public:
         }
         else
         {
-            SERVER_LOG_WARNING("ClientConnection::stop") << "Client connection id " << m_connection_id << " already stopped. Ignoring stop request.";
+            SERVER_MT_LOG_WARNING("ClientConnection::stop") << "Client connection id " << m_connection_id << " already stopped. Ignoring stop request.";
         }
     }
 
     void bind_udp_remote_endpoint(const udp::endpoint &connecting_remote_endpoint)
     {
-        SERVER_LOG_DEBUG("ClientConnection::bind_udp_remote_endpoint") << "Binding connection_id " 
+        SERVER_MT_LOG_DEBUG("ClientConnection::bind_udp_remote_endpoint") << "Binding connection_id " 
             << m_connection_id << " to UDP remote endpoint " 
             << connecting_remote_endpoint.address().to_string() << ":"
             << connecting_remote_endpoint.port();
@@ -199,7 +291,9 @@ public:
 
     bool has_queued_controller_data_frames() const
     {
-        return m_connection_started && m_pending_dataframes.size() > 0;
+        return m_connection_started && 
+            (m_pending_dataframes.size() > m_in_flight_dataframe_count ||
+             (m_data_frame_queue && m_data_frame_queue->size_approx() > 0));
     }
 
     void add_tcp_response_to_write_queue(ResponsePtr response)
@@ -222,9 +316,9 @@ public:
                     m_packed_response.set_msg(response);
                     m_packed_response.pack(m_response_write_buffer);
 
-                    SERVER_LOG_DEBUG("ClientConnection::start_tcp_write_queued_response") << "Sending TCP response";
-                    SERVER_LOG_DEBUG("   ") << show_hex(m_response_write_buffer);
-                    SERVER_LOG_DEBUG("   ") << m_packed_response.get_msg()->ByteSize() << " bytes";
+                    SERVER_MT_LOG_DEBUG("ClientConnection::start_tcp_write_queued_response") << "Sending TCP response";
+                    SERVER_MT_LOG_DEBUG("   ") << show_hex(m_response_write_buffer);
+                    SERVER_MT_LOG_DEBUG("   ") << m_packed_response.get_msg()->ByteSize() << " bytes";
 
                     // The queue should prevent us from writing more than one request as once
                     assert(!m_has_pending_tcp_write);
@@ -248,9 +342,9 @@ public:
         return write_in_progress;
     }
     
-    void add_device_data_frame_to_write_queue(DeviceOutputDataFramePtr data_frame)
+    void add_device_data_frame_to_write_queue(PackedDataFramePtr packed_data_frame)
     {
-        m_pending_dataframes.push_back(data_frame);
+        m_pending_dataframes.push_back(packed_data_frame);
     }
 
     bool start_udp_write_queued_device_data_frame()
@@ -261,37 +355,73 @@ public:
         {
             if (!m_has_pending_udp_write)
             {
-                if (m_pending_dataframes.size() > 0)
+                size_t datagram_size= 0;
+
+                // Pick up the data frames the main thread handed over since the last write
+                if (m_data_frame_queue)
                 {
-                    DeviceOutputDataFramePtr dataframe= m_pending_dataframes.front();
+                    PackedDataFramePtr packed_data_frame;
 
-                    m_packed_output_dataframe.set_msg(dataframe);
-                    if (m_packed_output_dataframe.pack(m_output_dataframe_buffer, sizeof(m_output_dataframe_buffer)))
+                    while (m_data_frame_queue->try_dequeue(packed_data_frame))
                     {
-                        int msg_size= m_packed_output_dataframe.get_msg()->ByteSize();
-
-                        SERVER_LOG_DEBUG("ClientConnection::start_udp_write_queued_device_data_frame") << "Sending UDP DataFrame";
-                        SERVER_LOG_DEBUG("   ") << show_hex(m_output_dataframe_buffer, HEADER_SIZE+msg_size);
-                        SERVER_LOG_DEBUG("   ") << msg_size << " bytes";
-
-                        // The queue should prevent us from writing more than one data frame at once
-                        assert(!m_has_pending_udp_write);
-                        m_has_pending_udp_write= true;
-                        write_in_progress= true;
-
-                        // Start an asynchronous operation to send the data frame
-                        // NOTE: Even if the write completes immediate, the callback will only be called from io_service::poll()
-                        m_udp_socket_ref.async_send_to(
-                            boost::asio::buffer(m_output_dataframe_buffer, sizeof(m_output_dataframe_buffer)),
-                            m_udp_remote_endpoint,
-                            boost::bind(&ClientConnection::handle_udp_write_device_data_frame_complete, this, _1));
+                        m_pending_dataframes.push_back(packed_data_frame);
                     }
-                    else
+                }
+
+                // Gather as many of the queued data frames as fit into one datagram (just the first one if not batching).
+                // The packed frames may be shared with other connections, so they're sent in place rather than copied.
+                assert(m_in_flight_dataframe_count == 0);
+                m_output_datagram_buffers.clear();
+                while (m_in_flight_dataframe_count < m_pending_dataframes.size() &&
+                       m_in_flight_dataframe_count < k_max_data_frames_per_datagram)
+                {
+                    const size_t packed_size= m_pending_dataframes[m_in_flight_dataframe_count]->bytes.size();
+
+                    if (datagram_size + packed_size > m_max_datagram_size)
+                    {
+                        if (m_in_flight_dataframe_count == 0)
+                        {
+                            SERVER_MT_LOG_ERROR("ClientConnection::start_udp_write_queued_device_data_frame") 
+                                << "DataFrame too big to fit in packet!";
+
+                            // Drop it rather than stalling the queue
+                            m_pending_dataframes.pop_front();
+                            continue;
+                        }
+
+                        // Goes out in the next datagram
+                        break;
+                    }
+
+                    m_output_datagram_buffers.push_back(
+                        boost::asio::buffer(m_pending_dataframes[m_in_flight_dataframe_count]->bytes));
+                    datagram_size+= packed_size;
+                    ++m_in_flight_dataframe_count;
+
+                    if (!m_bBatchDataFrames)
                     {
-                        SERVER_LOG_ERROR("ClientConnection::start_udp_write_queued_device_data_frame") 
-                            << "DataFrame too big to fit in packet!";
+                        break;
                     }
                 }
+
+                if (m_in_flight_dataframe_count > 0)
+                {
+                    SERVER_MT_LOG_DEBUG("ClientConnection::start_udp_write_queued_device_data_frame") << "Sending UDP DataFrame";
+                    SERVER_MT_LOG_DEBUG("   ") << datagram_size << " bytes, " << m_in_flight_dataframe_count << " data frames";
+
+                    // The queue should prevent us from writing more than one datagram at once
+                    assert(!m_has_pending_udp_write);
+                    m_has_pending_udp_write= true;
+                    write_in_progress= true;
+
+                    // Start an asynchronous operation to send the packed data frames back to back in one datagram.
+                    // The in flight frames stay in m_pending_dataframes, keeping their bytes alive, until the send completes.
+                    // NOTE: Even if the write completes immediate, the callback will only be called from io_service::poll()
+                    m_udp_socket_ref.async_send_to(
+                        m_output_datagram_buffers,
+                        m_udp_remote_endpoint,
+                        boost::bind(&ClientConnection::handle_udp_write_device_data_frame_complete, this, _1));
+                }
             }
             else
             {
@@ -309,7 +439,6 @@ private:
 
     int m_connection_id;
 
-    ServerRequestHandler &m_request_handler_ref;
     tcp::socket m_tcp_socket;
     udp::socket &m_udp_socket_ref;
     udp::endpoint m_udp_remote_endpoint;
@@ -321,11 +450,14 @@ private:
     vector<uint8_t> m_response_write_buffer;
     PackedMessage<PSMoveProtocol::Response> m_packed_response;
 
-    uint8_t m_output_dataframe_buffer[HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
-    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> m_packed_output_dataframe;
+    vector<asio::const_buffer> m_output_datagram_buffers; // the packed data frames making up the datagram being sent
+    size_t m_max_datagram_size;
+    bool m_bBatchDataFrames;
 
     deque<ResponsePtr> m_pending_responses;
-    deque<DeviceOutputDataFramePtr> m_pending_dataframes;
+    deque<PackedDataFramePtr> m_pending_dataframes;
+    t_data_frame_queue_ptr m_data_frame_queue; // only used when the network thread is enabled
+    size_t m_in_flight_dataframe_count; // data frames at the front of m_pending_dataframes being sent
     
     bool m_connection_started;
     bool m_connection_stopped;
@@ -336,10 +468,9 @@ private:
         IServerNetworkEventListener *network_event_listener,
         asio::io_service& io_service_ref,
         udp::socket& udp_socket_ref , 
-        ServerRequestHandler &request_handler_ref)
+        const NetworkManagerConfig &cfg)
         : m_network_event_listener(network_event_listener)
         , m_connection_id(next_connection_id)
-        , m_request_handler_ref(request_handler_ref)
         , m_tcp_socket(io_service_ref)
         , m_udp_socket_ref(udp_socket_ref)
         , m_udp_remote_endpoint()
@@ -348,21 +479,37 @@ private:
         , m_packed_request(std::shared_ptr<PSMoveProtocol::Request>(new PSMoveProtocol::Request()))
         , m_response_write_buffer()
         , m_packed_response()
-        , m_packed_output_dataframe()
+        , m_output_datagram_buffers()
+        , m_max_datagram_size(0)
+        , m_bBatchDataFrames(cfg.batch_udp_data_frames)
         , m_pending_responses()
         , m_pending_dataframes()
+        , m_data_frame_queue()
+        , m_in_flight_dataframe_count(0)
         , m_connection_started(false)
         , m_connection_stopped(false)
         , m_has_pending_tcp_write(false)
         , m_has_pending_udp_write(false)
     {
-        memset(m_output_dataframe_buffer, 0, sizeof(m_output_dataframe_buffer));
+        // A data frame on its own must always fit
+        m_max_datagram_size= 
+            m_bBatchDataFrames
+            ? std::min<size_t>(
+                std::max<size_t>(cfg.udp_max_datagram_size, HEADER_SIZE + MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE),
+                MAX_OUTPUT_DATA_FRAME_DATAGRAM_SIZE)
+            : HEADER_SIZE + MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE;
+
+        if (cfg.use_network_thread)
+        {
+            m_data_frame_queue= t_data_frame_queue_ptr(new t_data_frame_queue(k_data_frame_queue_capacity));
+        }
+
         next_connection_id++;
     }
 
     void send_connection_info()
     {
-        SERVER_LOG_INFO("ClientConnection::send_connection_info") 
+        SERVER_MT_LOG_INFO("ClientConnection::send_connection_info") 
             << "Sending connection id to client " << m_connection_id;
 
         ResponsePtr response(new PSMoveProtocol::Response);
@@ -378,7 +525,7 @@ private:
 
     void start_tcp_read_request_header()
     {
-        SERVER_LOG_DEBUG("ClientConnection::start_tcp_read_request_header") 
+        SERVER_MT_LOG_DEBUG("ClientConnection::start_tcp_read_request_header") 
             << "Start TCP header read on connection id to client " << m_connection_id;
 
         m_request_read_buffer.resize(HEADER_SIZE);
@@ -395,13 +542,13 @@ private:
     {
         if (!error) 
         {
-            SERVER_LOG_DEBUG("ClientConnection::handle_tcp_read_request_header") 
+            SERVER_MT_LOG_DEBUG("ClientConnection::handle_tcp_read_request_header") 
                 << "Read TCP request header on connection id " << m_connection_id;
-            SERVER_LOG_DEBUG("    ") << show_hex(m_request_read_buffer);
+            SERVER_MT_LOG_DEBUG("    ") << show_hex(m_request_read_buffer);
 
             unsigned msg_len = m_packed_request.decode_header(m_request_read_buffer);
 
-            SERVER_LOG_DEBUG("    ") << "Body Size = " << msg_len << " bytes";
+            SERVER_MT_LOG_DEBUG("    ") << "Body Size = " << msg_len << " bytes";
 
             if (msg_len > 0)
             {
@@ -415,7 +562,7 @@ private:
         }
         else
         {
-            SERVER_LOG_ERROR("ClientConnection::handle_tcp_read_request_header") 
+            SERVER_MT_LOG_ERROR("ClientConnection::handle_tcp_read_request_header") 
                 << "Failed to read header on connection " << m_connection_id << ": " << error.message();
             stop();
         }
@@ -423,7 +570,7 @@ private:
 
     void start_tcp_read_request_body(unsigned msg_len)
     {
-        SERVER_LOG_DEBUG("ClientConnection::start_tcp_read_request_body") 
+        SERVER_MT_LOG_DEBUG("ClientConnection::start_tcp_read_request_body") 
             << "Start TCP request body read on connection id to client " << m_connection_id;
 
         // m_readbuf already contains the header in its first HEADER_SIZE
@@ -444,16 +591,16 @@ private:
     {
         if (!error) 
         {
-            SERVER_LOG_DEBUG("ClientConnection::handle_tcp_read_request_body")
+            SERVER_MT_LOG_DEBUG("ClientConnection::handle_tcp_read_request_body")
                 << "Read request body on connection" << m_connection_id;
-            SERVER_LOG_DEBUG("   ") << show_hex(m_request_read_buffer);
+            SERVER_MT_LOG_DEBUG("   ") << show_hex(m_request_read_buffer);
 
             handle_tcp_request();
             start_tcp_read_request_header();
         }
         else
         {
-            SERVER_LOG_ERROR("ClientConnection::handle_tcp_read_request_body") 
+            SERVER_MT_LOG_ERROR("ClientConnection::handle_tcp_read_request_body") 
                 << "Failed to read body on connection " << m_connection_id << ": " << error.message();
             stop();
         }
@@ -469,21 +616,16 @@ private:
         {
             RequestPtr request = m_packed_request.get_msg();
 
-            SERVER_LOG_DEBUG("ClientConnection::handle_tcp_request") 
+            SERVER_MT_LOG_DEBUG("ClientConnection::handle_tcp_request") 
                 << "Handle request type " << request->request_id() 
                 << " on connection id to client " << m_connection_id;
 
-            ResponsePtr response = m_request_handler_ref.handle_request(m_connection_id, request);            
-            if (response)
-            {
-                add_tcp_response_to_write_queue(response);
-            }
-
-            start_tcp_write_queued_response();
+            // The response gets queued with add_tcp_response_to_write_queue() once the request is handled
+            m_network_event_listener->handle_client_request(m_connection_id, request);
         }
         else
         {
-            SERVER_LOG_ERROR("ClientConnection::handle_tcp_request") 
+            SERVER_MT_LOG_ERROR("ClientConnection::handle_tcp_request") 
                 << "Failed to parse request on connection " << m_connection_id;
             stop();
         }
@@ -496,7 +638,7 @@ private:
 
         if (!ec)
         {
-            SERVER_LOG_DEBUG("ClientConnection::handle_write_response_complete") 
+            SERVER_MT_LOG_DEBUG("ClientConnection::handle_write_response_complete") 
                 << "Sent TCP response on connection id " << m_connection_id;
 
             // no longer is there a pending write
@@ -510,7 +652,7 @@ private:
         }
         else
         {
-            SERVER_LOG_ERROR("ClientConnection::handle_write_response_complete") 
+            SERVER_MT_LOG_ERROR("ClientConnection::handle_write_response_complete") 
                 << "Error sending request on connection " << m_connection_id << ": " << ec.message();
             stop();
         }
@@ -523,18 +665,33 @@ private:
 
         if (!ec)
         {
-            SERVER_LOG_TRACE("ClientConnection::handle_udp_write_device_data_frame_complete") 
+            SERVER_MT_LOG_TRACE("ClientConnection::handle_udp_write_device_data_frame_complete") 
                 << "Sent UDP data frame on connection id " << m_connection_id;
 
             // no longer is there a pending write
             m_has_pending_udp_write= false;
 
-            // Remove the dataframe from the pending send queue now that it's sent
-            m_pending_dataframes.pop_front();
+            const int64_t sent_us= PipelineLatencyStats::getTimestampUs();
+
+            // Remove the dataframes from the pending send queue now that they're sent
+            for (; m_in_flight_dataframe_count > 0; --m_in_flight_dataframe_count)
+            {
+                const PackedDataFramePtr &dataframe= m_pending_dataframes.front();
+
+                PipelineLatencyStats::recordStageLatency(
+                    PipelineLatencyStage_SerializedToSent, dataframe->serialized_us, sent_us);
+                PipelineLatencyStats::recordStageLatency(
+                    PipelineLatencyStage_CaptureToSent, dataframe->capture_us, sent_us);
+
+                m_pending_dataframes.pop_front();
+            }
+
+            // If there are more data frames waiting to be sent, start sending the next datagram
+            start_udp_write_queued_device_data_frame();
         }
         else
         {
-            SERVER_LOG_ERROR("ClientConnection::handle_udp_write_device_data_frame_complete") 
+            SERVER_MT_LOG_ERROR("ClientConnection::handle_udp_write_device_data_frame_complete") 
                 << "Error sending data frame on connection " << m_connection_id << ": " << ec.message();
 
             stop();
@@ -550,7 +707,10 @@ class ServerNetworkManagerImpl : public IServerNetworkEventListener
 public:
     ServerNetworkManagerImpl(asio::io_service &io_service, NetworkManagerConfig &cfg, ServerRequestHandler &requestHandler)
         : m_request_handler_ref(requestHandler)
-        , m_io_service(io_service)
+        , m_cfg(cfg)
+        , m_main_io_service(io_service)
+        , m_network_io_service(cfg.use_network_thread ? new asio::io_service : nullptr)
+        , m_io_service(cfg.use_network_thread ? *m_network_io_service : io_service)
         , m_tcp_acceptor(m_io_service, tcp::endpoint(tcp::v4(), cfg.server_port))
         , m_udp_socket(m_io_service, udp::endpoint(udp::v4(), cfg.server_port))
         , m_udp_connecting_remote_endpoint()
@@ -558,6 +718,13 @@ public:
         , m_udp_connection_result_write_buffer(false)
         , m_has_pending_udp_read(false)
         , m_connections()
+        , m_network_thread()
+        , m_bHandleEventsOnMainThread(false)
+        , m_network_events()
+        , m_data_frame_queues()
+        , m_bDataFrameFlushPending(false)
+        , m_request_pool()
+        , m_input_data_frame_pool()
     {
         memset(m_input_dataframe_buffer, 0, sizeof(m_input_dataframe_buffer));
     }
@@ -567,7 +734,45 @@ public:
         // All connections should have been closed at this point
         if (!m_connections.empty())
         {
-            SERVER_LOG_ERROR("~ServerNetworkManagerImpl") << "Network manager deleted while there were unclosed connections!";
+            SERVER_MT_LOG_ERROR("~ServerNetworkManagerImpl") << "Network manager deleted while there were unclosed connections!";
+        }
+    }
+
+    /// Called during PSMoveService::startup(), after start_connection_accept()
+    void start_network_thread()
+    {
+        if (m_network_io_service)
+        {
+            // From here on the sockets and connections belong to the network thread
+            m_bHandleEventsOnMainThread= true;
+
+            m_network_thread.reset(new NetworkIOThread(*m_network_io_service));
+            m_network_thread->startThread();
+        }
+    }
+
+    /// Called during PSMoveService::shutdown(), before close_all_connections()
+    void stop_network_thread()
+    {
+        if (m_network_thread)
+        {
+            m_network_thread->stopThread();
+            m_network_thread.reset();
+
+            // Connections can be stopped directly on the main thread now
+            m_bHandleEventsOnMainThread= false;
+
+            // Let the request handler clean up after connections that stopped while we were shutting down
+            ServerNetworkEvent network_event;
+            while (m_network_events.try_dequeue(network_event))
+            {
+                if (network_event.event_type == ServerNetworkEvent::ConnectionStopped)
+                {
+                    m_request_handler_ref.handle_client_connection_stopped(network_event.connection_id);
+                }
+            }
+
+            m_data_frame_queues.clear();
         }
     }
 
@@ -575,17 +780,15 @@ public:
     /// Called during PSMoveService::startup()
     void start_connection_accept()
     {
-        SERVER_LOG_DEBUG("ServerNetworkManager::start_tcp_accept") << "Start waiting for a new TCP connection";
+        SERVER_MT_LOG_DEBUG("ServerNetworkManager::start_tcp_accept") << "Start waiting for a new TCP connection";
         
         // Create a new connection to handle a client.
-        // Passing a reference to a request handler to each connection poses no problem 
-        // since the server is single-threaded.
         ClientConnectionPtr new_connection = 
             ClientConnection::create(
                 this, 
                 m_tcp_acceptor.get_io_service(), 
                 m_udp_socket, 
-                m_request_handler_ref);
+                m_cfg);
 
         // Add the connection to the list
         t_id_client_connection_pair map_entry(new_connection->get_connection_id(), new_connection);
@@ -604,6 +807,17 @@ public:
 
     void poll()
     {
+        if (m_network_thread)
+        {
+            // The sockets are serviced on the network thread, 
+            // just handle what it received since the last update
+            handle_network_events();
+
+            // Service anything else on the main io_service (i.e. the termination signals)
+            m_main_io_service.poll();
+            return;
+        }
+
         bool keep_polling= true;
         int iteration_count= 0;
         const static int k_max_iteration_count= 32;
@@ -630,7 +844,7 @@ public:
 
     void close_all_connections()
     {
-        SERVER_LOG_DEBUG("ServerNetworkManager::close_all_connections") << "Stopping all client connections";
+        SERVER_MT_LOG_DEBUG("ServerNetworkManager::close_all_connections") << "Stopping all client connections";
 
         // Stop all of the TCP connections
         while (m_connections.size() > 0)
@@ -651,13 +865,13 @@ public:
             m_udp_socket.shutdown(asio::socket_base::shutdown_both, error);
             if (error)
             {
-                SERVER_LOG_ERROR("ServerNetworkManager::close_all_connections") << "Problem shutting down the udp socket: " << error.message();
+                SERVER_MT_LOG_ERROR("ServerNetworkManager::close_all_connections") << "Problem shutting down the udp socket: " << error.message();
             }
 
             m_udp_socket.close(error);
             if (error)
             {
-                SERVER_LOG_ERROR("ServerNetworkManager::close_all_connections") << "Problem closing the udp socket: " << error.message();
+                SERVER_MT_LOG_ERROR("ServerNetworkManager::close_all_connections") << "Problem closing the udp socket: " << error.message();
             }
         }
 
@@ -666,73 +880,106 @@ public:
 
     void send_notification(int connection_id, ResponsePtr response)
     {
-        t_client_connection_map_iter entry = m_connections.find(connection_id);
-
         // Notifications have an invalid response ID
         response->set_request_id(-1);
-        
-        if (entry != m_connections.end())
-        {
-            ClientConnectionPtr connection= entry->second;
-
-            SERVER_LOG_DEBUG("ServerNetworkManager::send_notification") 
-                << "Sending response_type " << response->type() 
-                << " to connection " << connection_id;
 
-            connection->add_tcp_response_to_write_queue(response);
-            connection->start_tcp_write_queued_response();
+        if (m_network_thread)
+        {
+            // The connection can only be touched on the network thread
+            m_io_service.post(boost::bind(&ServerNetworkManagerImpl::write_response, this, connection_id, response));
         }
         else
         {
-            SERVER_LOG_DEBUG("ServerNetworkManager::send_notification") 
-                << "Can't send response_type " << response->type() 
-                << " to a disconnected connection " << connection_id;
+            write_response(connection_id, response);
         }
     }
 
     void send_notification_to_all_clients(ResponsePtr response)
     {
-        SERVER_LOG_DEBUG("ServerNetworkManager::send_notification") 
-            << "Sending response_type " << response->type() << "to all clients";
-
         // Notifications have an invalid response ID
         response->set_request_id(-1);
 
-        for (t_client_connection_map_iter iter= m_connections.begin(); iter != m_connections.end(); ++iter)
+        if (m_network_thread)
         {
-            ClientConnectionPtr connection= iter->second;
+            m_io_service.post(boost::bind(&ServerNetworkManagerImpl::write_response_to_all_clients, this, response));
+        }
+        else
+        {
+            write_response_to_all_clients(response);
+        }
+    }
 
-            if (connection->can_send_data_to_client())
+    void send_packed_device_data_frame(int connection_id, PackedDataFramePtr packed_data_frame)
+    {
+        if (m_network_thread)
+        {
+            t_data_frame_queue_map::iterator entry = m_data_frame_queues.find(connection_id);
+
+            if (entry != m_data_frame_queues.end())
             {
-                connection->add_tcp_response_to_write_queue(response);
-                connection->start_tcp_write_queued_response();
+                SERVER_MT_LOG_TRACE("ServerNetworkManager::send_device_data_frame") 
+                    << "Queuing data_frame for connection " << connection_id;
+
+                // Never block the main thread on a connection that can't keep up, drop the frame instead
+                if (entry->second->try_enqueue(packed_data_frame))
+                {
+                    request_data_frame_flush();
+                }
+                else
+                {
+                    SERVER_MT_LOG_DEBUG("ServerNetworkManager::send_device_data_frame") 
+                        << "Data frame queue full, dropping data_frame for connection " << connection_id;
+                }
+            }
+            else
+            {
+                SERVER_MT_LOG_ERROR("ServerNetworkManager::send_device_data_frame") 
+                    << "Can't send data_frame to unknown connection " << connection_id;
             }
+
+            return;
         }
-    }
 
-    void send_device_data_frame(int connection_id, DeviceOutputDataFramePtr data_frame)
-    {
         t_client_connection_map_iter entry = m_connections.find(connection_id);
 
         if (entry != m_connections.end())
         {
             ClientConnectionPtr connection= entry->second;
 
-            SERVER_LOG_TRACE("ServerNetworkManager::send_device_data_frame") 
+            SERVER_MT_LOG_TRACE("ServerNetworkManager::send_device_data_frame") 
                 << "Sending data_frame to connection " << connection_id;
 
-            connection->add_device_data_frame_to_write_queue(data_frame);
+            connection->add_device_data_frame_to_write_queue(packed_data_frame);
 
             start_udp_queued_data_frame_write();
         }
         else
         {
-            SERVER_LOG_ERROR("ServerNetworkManager::send_device_data_frame") 
+            SERVER_MT_LOG_ERROR("ServerNetworkManager::send_device_data_frame") 
                 << "Can't send data_frame to unknown connection " << connection_id;
         }
     }
 
     // -- IServerNetworkEventListener ----
+	virtual void handle_client_request(int connection_id, RequestPtr request) override
+    {
+        if (m_bHandleEventsOnMainThread)
+        {
+            // The connection reuses its request message for the next read, so hand off the contents
+            ServerNetworkEvent network_event;
+            network_event.event_type= ServerNetworkEvent::RequestReceived;
+            network_event.connection_id= connection_id;
+            network_event.request= m_request_pool.acquire();
+            network_event.request->Swap(request.get());
+
+            post_network_event(network_event);
+        }
+        else
+        {
+            handle_request_on_main_thread(connection_id, request);
+        }
+    }
+
 	virtual void handle_client_connection_stopped(int connection_id) override
     {
         t_client_connection_map_iter entry = m_connections.find(connection_id);
@@ -742,13 +989,33 @@ public:
             m_connections.erase(entry);
         }
 
-        // Tell the request handler to clean up any state associated with this connection
-        m_request_handler_ref.handle_client_connection_stopped(connection_id);
+        if (m_bHandleEventsOnMainThread)
+        {
+            ServerNetworkEvent network_event;
+            network_event.event_type= ServerNetworkEvent::ConnectionStopped;
+            network_event.connection_id= connection_id;
+
+            post_network_event(network_event);
+        }
+        else
+        {
+            // Tell the request handler to clean up any state associated with this connection
+            m_request_handler_ref.handle_client_connection_stopped(connection_id);
+        }
     }
 
 private:
     // Process and responds to incoming PSMoveService request
     ServerRequestHandler &m_request_handler_ref;
+
+    // Settings handed to each new client connection
+    const NetworkManagerConfig &m_cfg;
+
+    // The service's io_service, only polled for the sockets when there's no network thread
+    asio::io_service &m_main_io_service;
+
+    // Run by the network thread, when enabled
+    std::unique_ptr<asio::io_service> m_network_io_service;
     
     // Core i/o functionality for TCP/UDP sockets
     asio::io_service &m_io_service;
@@ -773,8 +1040,30 @@ private:
     bool m_has_pending_udp_read;
 
     // A mapping from connection_id -> ClientConnectionPtr
+    // Only touched on the network thread when it's enabled
     t_client_connection_map m_connections;
 
+    // Services the sockets, if enabled in the config
+    std::unique_ptr<NetworkIOThread> m_network_thread;
+
+    // If true, requests and connection changes are queued up for the main thread
+    bool m_bHandleEventsOnMainThread;
+
+    // Network thread -> main thread
+    moodycamel::ReaderWriterQueue<ServerNetworkEvent> m_network_events;
+
+    // Main thread -> network thread, a mapping from connection_id -> that connection's data frame queue
+    // Only touched on the main thread
+    t_data_frame_queue_map m_data_frame_queues;
+
+    // Set while a flush of the data frame queues is posted to the network thread
+    std::atomic_bool m_bDataFrameFlushPending;
+
+    // Recycled messages for handing requests and input data frames to the main thread
+    // Only acquired from on the network thread
+    ProtocolMessagePool<PSMoveProtocol::Request> m_request_pool;
+    ProtocolMessagePool<PSMoveProtocol::DeviceInputDataFrame> m_input_data_frame_pool;
+
 protected:
     void handle_tcp_accept(ClientConnectionPtr connection, const boost::system::error_code& error)
     {        
@@ -782,14 +1071,25 @@ protected:
         //
         if (!error)
         {
-            SERVER_LOG_DEBUG("ServerNetworkManager::handle_tcp_accept") << "Accepting a new connection";
+            SERVER_MT_LOG_DEBUG("ServerNetworkManager::handle_tcp_accept") << "Accepting a new connection";
             
             // Start the connection
             connection->start();
+
+            if (m_bHandleEventsOnMainThread)
+            {
+                // Hand the connection's data frame queue to the main thread
+                ServerNetworkEvent network_event;
+                network_event.event_type= ServerNetworkEvent::ConnectionStarted;
+                network_event.connection_id= connection->get_connection_id();
+                network_event.data_frame_queue= connection->get_data_frame_queue();
+
+                post_network_event(network_event);
+            }
         }
         else
         {
-            SERVER_LOG_DEBUG("ServerNetworkManager::handle_tcp_accept") << 
+            SERVER_MT_LOG_DEBUG("ServerNetworkManager::handle_tcp_accept") << 
                 "Failed to accept new connection: " << error.message();
 
             // Stop the failed connection
@@ -804,7 +1104,7 @@ protected:
     {
         if (!m_has_pending_udp_read)
         {
-            SERVER_LOG_DEBUG("ServerNetworkManager::start_udp_receive_connection_id") << "waiting for UDP input dataframe";
+            SERVER_MT_LOG_DEBUG("ServerNetworkManager::start_udp_receive_connection_id") << "waiting for UDP input dataframe";
 
             m_has_pending_udp_read = true;
             m_udp_socket.async_receive_from(
@@ -828,7 +1128,7 @@ protected:
         }
         else
         {
-            SERVER_LOG_ERROR("ServerNetworkManager::handle_udp_read_connection_id") 
+            SERVER_MT_LOG_ERROR("ServerNetworkManager::handle_udp_read_connection_id") 
                 << "Failed to receive UDP connection id: "<< error.message();
         }
 
@@ -843,13 +1143,13 @@ protected:
         // No longer is there a pending read
         m_has_pending_udp_read = false;
 
-        SERVER_LOG_DEBUG("ClientNetworkManager::handle_udp_data_frame_received") << "Parsing DataFrame";
+        SERVER_MT_LOG_DEBUG("ClientNetworkManager::handle_udp_data_frame_received") << "Parsing DataFrame";
 
         // TODO: Switch on data frame type to choose which m_packed_data_frame_X to use.
         unsigned msg_len = m_packed_input_dataframe.decode_header(m_input_dataframe_buffer, sizeof(m_input_dataframe_buffer));
         unsigned total_len = HEADER_SIZE + msg_len;
-        SERVER_LOG_DEBUG("    ") << show_hex(m_input_dataframe_buffer, total_len);
-        SERVER_LOG_DEBUG("    ") << msg_len << " bytes";
+        SERVER_MT_LOG_DEBUG("    ") << show_hex(m_input_dataframe_buffer, total_len);
+        SERVER_MT_LOG_DEBUG("    ") << msg_len << " bytes";
 
         // Parse the response buffer
         if (m_packed_input_dataframe.unpack(m_input_dataframe_buffer, total_len))
@@ -861,7 +1161,7 @@ protected:
 
             if (iter != m_connections.end())
             {
-                SERVER_LOG_DEBUG("ServerNetworkManager::handle_udp_data_frame_received")
+                SERVER_MT_LOG_DEBUG("ServerNetworkManager::handle_udp_data_frame_received")
                     << "Found UDP client connected with matching connection_id: " << data_frame->connection_id();
 
                 ClientConnectionPtr connection = iter->second;
@@ -877,11 +1177,25 @@ protected:
                 }
 
                 // Process the incoming data frame
-                m_request_handler_ref.handle_input_data_frame(data_frame);
+                if (m_bHandleEventsOnMainThread)
+                {
+                    // The input data frame message gets reused for the next read, so hand off the contents
+                    ServerNetworkEvent network_event;
+                    network_event.event_type= ServerNetworkEvent::InputDataFrameReceived;
+                    network_event.connection_id= data_frame->connection_id();
+                    network_event.input_data_frame= m_input_data_frame_pool.acquire();
+                    network_event.input_data_frame->Swap(data_frame.get());
+
+                    post_network_event(network_event);
+                }
+                else
+                {
+                    m_request_handler_ref.handle_input_data_frame(data_frame);
+                }
             }
             else 
             {
-                SERVER_LOG_ERROR("ServerNetworkManager::handle_udp_data_frame_received")
+                SERVER_MT_LOG_ERROR("ServerNetworkManager::handle_udp_data_frame_received")
                     << "UDP client connected with INVALID connection_id: " << data_frame->connection_id();
 
                 if (data_frame->device_category() == PSMoveProtocol::DeviceInputDataFrame_DeviceCategory_INVALID)
@@ -896,7 +1210,7 @@ protected:
 
     void start_udp_send_connection_result(bool success)
     {
-        SERVER_LOG_DEBUG("ServerNetworkManager::start_udp_send_connection_result") 
+        SERVER_MT_LOG_DEBUG("ServerNetworkManager::start_udp_send_connection_result") 
             << "Send result: " << success;
 
         m_udp_connection_result_write_buffer= success;
@@ -910,7 +1224,7 @@ protected:
     {
         if (error) 
         {
-            SERVER_LOG_ERROR("ServerNetworkManager::handle_udp_write_connection_result") 
+            SERVER_MT_LOG_ERROR("ServerNetworkManager::handle_udp_write_connection_result") 
                 << "Failed to send UDP connection response: "<< error.message();
         }
 
@@ -920,17 +1234,16 @@ protected:
 
     void start_udp_queued_data_frame_write()
     {
+        // Each connection has its own datagram buffers, so they can all have a write in flight at once
         for (t_client_connection_map_iter iter= m_connections.begin(); iter != m_connections.end(); ++iter)
         {
             ClientConnectionPtr connection= iter->second;
 
-            if (connection->start_udp_write_queued_device_data_frame())
+            if (!connection->has_pending_udp_write() && 
+                connection->start_udp_write_queued_device_data_frame())
             {
-                SERVER_LOG_TRACE("ServerNetworkManager::start_udp_queued_data_frame_write") 
+                SERVER_MT_LOG_TRACE("ServerNetworkManager::start_udp_queued_data_frame_write") 
                     << "Send queued UDP data on connection id: " << iter->first;
-
-                // Don't start a write on any other connection until this one is finished 
-                break;
             }
         }        
     }
@@ -938,27 +1251,134 @@ protected:
     bool has_queued_controller_data_frames_ready_to_start()
     {
         bool has_queued_write_ready_to_start= false;
-        bool udp_socket_available= true;
 
         for (t_client_connection_map_iter iter= m_connections.begin(); iter != m_connections.end(); ++iter)
         {
             ClientConnectionPtr connection= iter->second;
 
-            if (connection->has_pending_udp_write())
+            if (!connection->has_pending_udp_write() && connection->has_queued_controller_data_frames())
             {
-                // Can't start any new udp write until any current udp write is done
-                udp_socket_available= false;
+                // Found a connection with a pending udp write ready to go
+                has_queued_write_ready_to_start= true;
                 break;
             }
+        }
 
-            if (connection->has_queued_controller_data_frames())
+        return has_queued_write_ready_to_start;
+    }
+
+    // Called on the network thread (or the main thread when it's disabled)
+    void write_response(int connection_id, ResponsePtr response)
+    {
+        t_client_connection_map_iter entry = m_connections.find(connection_id);
+
+        if (entry != m_connections.end())
+        {
+            ClientConnectionPtr connection= entry->second;
+
+            SERVER_MT_LOG_DEBUG("ServerNetworkManager::write_response") 
+                << "Sending response_type " << response->type() 
+                << " to connection " << connection_id;
+
+            connection->add_tcp_response_to_write_queue(response);
+            connection->start_tcp_write_queued_response();
+        }
+        else
+        {
+            SERVER_MT_LOG_DEBUG("ServerNetworkManager::write_response") 
+                << "Can't send response_type " << response->type() 
+                << " to a disconnected connection " << connection_id;
+        }
+    }
+
+    // Called on the network thread (or the main thread when it's disabled)
+    void write_response_to_all_clients(ResponsePtr response)
+    {
+        SERVER_MT_LOG_DEBUG("ServerNetworkManager::write_response_to_all_clients") 
+            << "Sending response_type " << response->type() << "to all clients";
+
+        for (t_client_connection_map_iter iter= m_connections.begin(); iter != m_connections.end(); ++iter)
+        {
+            ClientConnectionPtr connection= iter->second;
+
+            if (connection->can_send_data_to_client())
             {
-                // Found a connection with a pending udp write ready to go
-                has_queued_write_ready_to_start= true;
+                connection->add_tcp_response_to_write_queue(response);
+                connection->start_tcp_write_queued_response();
+            }
+        }
+    }
+
+    void handle_request_on_main_thread(int connection_id, RequestPtr request)
+    {
+        ResponsePtr response = m_request_handler_ref.handle_request(connection_id, request);
+
+        if (response)
+        {
+            if (m_network_thread)
+            {
+                m_io_service.post(boost::bind(&ServerNetworkManagerImpl::write_response, this, connection_id, response));
+            }
+            else
+            {
+                write_response(connection_id, response);
+            }
+        }
+    }
+
+    // Called on the network thread, wakes up the main loop to handle the event
+    void post_network_event(const ServerNetworkEvent &network_event)
+    {
+        m_network_events.enqueue(network_event);
+        MainLoopWakeSignal::notify();
+    }
+
+    // Called on the main thread with whatever the network thread received since the last update
+    void handle_network_events()
+    {
+        ServerNetworkEvent network_event;
+
+        while (m_network_events.try_dequeue(network_event))
+        {
+            switch (network_event.event_type)
+            {
+            case ServerNetworkEvent::ConnectionStarted:
+                m_data_frame_queues.insert(
+                    t_data_frame_queue_map::value_type(network_event.connection_id, network_event.data_frame_queue));
+                break;
+            case ServerNetworkEvent::ConnectionStopped:
+                m_data_frame_queues.erase(network_event.connection_id);
+
+                // Tell the request handler to clean up any state associated with this connection
+                m_request_handler_ref.handle_client_connection_stopped(network_event.connection_id);
+                break;
+            case ServerNetworkEvent::RequestReceived:
+                handle_request_on_main_thread(network_event.connection_id, network_event.request);
+                break;
+            case ServerNetworkEvent::InputDataFrameReceived:
+                m_request_handler_ref.handle_input_data_frame(network_event.input_data_frame);
+                break;
             }
         }
+    }
+
+    // Called on the main thread after queuing up data frames
+    void request_data_frame_flush()
+    {
+        // Only need one flush in flight, it picks up everything queued before it runs
+        if (!m_bDataFrameFlushPending.exchange(true))
+        {
+            m_io_service.post(boost::bind(&ServerNetworkManagerImpl::handle_data_frame_flush, this));
+        }
+    }
+
+    // Called on the network thread
+    void handle_data_frame_flush()
+    {
+        // Cleared first so data frames queued from here on post another flush
+        m_bDataFrameFlushPending.store(false);
 
-        return udp_socket_available && has_queued_write_ready_to_start;
+        start_udp_queued_data_frame_write();
     }
 };
 
@@ -991,12 +1411,21 @@ ServerNetworkManager::~ServerNetworkManager()
 
 bool ServerNetworkManager::startup(
 	boost::asio::io_service *io_service,
-    ServerRequestHandler *requestHandler)
+    ServerRequestHandler *requestHandler,
+    bool bRequireNetworkThread)
 {    
     m_instance= this;
+
+    // Only for this run, the saved config keeps the user's choice
+    if (bRequireNetworkThread && !m_cfg.use_network_thread)
+    {
+        SERVER_LOG_INFO("ServerNetworkManager::startup") << "Servicing the sockets on the network thread for the event driven main loop";
+        m_cfg.use_network_thread= true;
+    }
     
 	implementation_ptr= new ServerNetworkManagerImpl(*io_service, m_cfg, *requestHandler);
     implementation_ptr->start_connection_accept();
+    implementation_ptr->start_network_thread();
 
     return true;
 }
@@ -1013,6 +1442,7 @@ void ServerNetworkManager::shutdown()
 {
 	if (implementation_ptr != nullptr)
 	{    
+	    implementation_ptr->stop_network_thread();
 	    implementation_ptr->close_all_connections();
 	}
     
@@ -1036,9 +1466,70 @@ void ServerNetworkManager::send_notification_to_all_clients(ResponsePtr response
 }
 
 void ServerNetworkManager::send_device_data_frame(int connection_id, DeviceOutputDataFramePtr data_frame)
+{
+	PackedDataFramePtr packed_data_frame= pack_device_data_frame(data_frame);
+
+	if (packed_data_frame)
+	{
+		send_packed_device_data_frame(connection_id, packed_data_frame);
+	}
+}
+
+PackedDataFramePtr ServerNetworkManager::pack_device_data_frame(DeviceOutputDataFramePtr data_frame)
+{
+	std::shared_ptr<PackedDataFrame> packed_data_frame= g_packed_data_frame_pool.acquire();
+
+	if (data_frame->has_pipeline_timestamps())
+	{
+		// Stamped before packing so the client gets it too (the packing time itself isn't counted)
+		packed_data_frame->capture_us= data_frame->pipeline_timestamps().capture_us();
+		packed_data_frame->serialized_us= PipelineLatencyStats::getTimestampUs();
+		data_frame->mutable_pipeline_timestamps()->set_serialized_us(packed_data_frame->serialized_us);
+
+		PipelineLatencyStats::recordStageLatency(
+			PipelineLatencyStage_FilterToSerialized, 
+			data_frame->pipeline_timestamps().filter_done_us(), 
+			packed_data_frame->serialized_us);
+	}
+
+	PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> packed_message(data_frame);
+	if (!packed_message.pack(packed_data_frame->bytes))
+	{
+		SERVER_LOG_ERROR("ServerNetworkManager::pack_device_data_frame") << "Failed to pack data frame!";
+		return PackedDataFramePtr();
+	}
+
+	return packed_data_frame;
+}
+
+PackedDataFramePtr ServerNetworkManager::pack_compact_device_data_frame(
+	const CompactDataFrame &compact_frame,
+	const PipelineStageTimes *stage_times)
+{
+	std::shared_ptr<PackedDataFrame> packed_data_frame= g_packed_data_frame_pool.acquire();
+
+	if (stage_times != nullptr && stage_times->filter_done_us != 0)
+	{
+		packed_data_frame->capture_us= stage_times->capture_us;
+		packed_data_frame->serialized_us= PipelineLatencyStats::getTimestampUs();
+
+		PipelineLatencyStats::recordStageLatency(
+			PipelineLatencyStage_FilterToSerialized, 
+			stage_times->filter_done_us, 
+			packed_data_frame->serialized_us);
+	}
+
+	// Fixed layout, so packing is a single copy
+	const unsigned char *compact_bytes= reinterpret_cast<const unsigned char *>(&compact_frame);
+	packed_data_frame->bytes.assign(compact_bytes, compact_bytes + sizeof(CompactDataFrame));
+
+	return packed_data_frame;
+}
+
+void ServerNetworkManager::send_packed_device_data_frame(int connection_id, PackedDataFramePtr packed_data_frame)
 {
 	if (implementation_ptr != nullptr)
 	{    
-		implementation_ptr->send_device_data_frame(connection_id, data_frame);
+		implementation_ptr->send_packed_device_data_frame(connection_id, packed_data_frame);
 	}
 }
@@ -5,8 +5,14 @@
 #include "PSMoveProtocolInterface.h"
 #include "PSMoveConfig.h"
 
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
 //-- pre-declarations -----
 class ServerRequestHandler;
+struct CompactDataFrame;
+struct PipelineStageTimes;
 
 namespace boost {
     namespace asio {
@@ -27,7 +33,27 @@ public:
 
     long version;
 	int server_port;
+	bool batch_udp_data_frames; // pack the queued data frames of a connection into one datagram (needs clients that parse batches)
+	int udp_max_datagram_size; // size limit of a batched datagram in bytes
+	bool use_network_thread; // service the sockets on their own thread rather than in update()
+};
+
+/// A device data frame packed (length header + message) once and shared by every connection it's sent to
+struct PackedDataFrame
+{
+    std::vector<unsigned char> bytes;
+    int64_t capture_us; // pipeline timestamps for the latency stats, 0 if the frame has none
+    int64_t serialized_us;
+
+    // Recycling a packed frame keeps the capacity of its byte buffer
+    void Clear()
+    {
+        bytes.clear();
+        capture_us= 0;
+        serialized_us= 0;
+    }
 };
+typedef std::shared_ptr<const PackedDataFrame> PackedDataFramePtr;
 
 // -Server Network Manager-
 /// Maintains TCP/UDP connection state with PSMoveClients.
@@ -48,12 +74,15 @@ public:
     /// Called first by PSMoveService::startup()
     /**
      Calls ServerNetworkManagerImpl::start_connection_accept()
+     bRequireNetworkThread services the sockets on the network thread even if the config doesn't ask for it
+     (the event driven main loop has no other way of noticing socket activity)
      */
-    bool startup(boost::asio::io_service *io_service, ServerRequestHandler *request_handler);
+    bool startup(boost::asio::io_service *io_service, ServerRequestHandler *request_handler, bool bRequireNetworkThread);
     
     /// Called last by PSMoveService::update()
     /**
      Calls ServerNetworkManagerImpl::poll()
+     With the network thread enabled this only hands the received requests to the request handler
      */
     void update();
     
@@ -69,6 +98,21 @@ public:
     
     void send_device_data_frame(int connection_id, DeviceOutputDataFramePtr data_frame);
 
+    /// Packs a data frame for send_packed_device_data_frame(), stamping its serialized time.
+    /// Returns an empty pointer if the frame can't be packed.
+    static PackedDataFramePtr pack_device_data_frame(DeviceOutputDataFramePtr data_frame);
+
+    /// Packs a compact data frame for send_packed_device_data_frame().
+    /// The stage times of the sample it came from, if any, feed the latency stats.
+    static PackedDataFramePtr pack_compact_device_data_frame(
+        const CompactDataFrame &compact_frame, const PipelineStageTimes *stage_times);
+
+    /// Queues an already packed data frame, the bytes aren't copied
+    void send_packed_device_data_frame(int connection_id, PackedDataFramePtr packed_data_frame);
+
+    /// True if the sockets are serviced on the network thread rather than polled in update()
+    inline bool getUsesNetworkThread() const { return m_cfg.use_network_thread; }
+
 private:   
 	/// Configuration settings used by the network manager
 	NetworkManagerConfig m_cfg;
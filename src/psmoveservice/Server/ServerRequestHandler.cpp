@@ -3,7 +3,9 @@
 
 #include "BluetoothRequests.h"
 #include "BluetoothQueries.h"
+#include "CompactDataFrame.h"
 #include "ControllerManager.h"
+#include "DataStreamRateLimit.h"
 #include "DeviceManager.h"
 #include "DeviceEnumerator.h"
 #include "MathEigen.h"
@@ -11,7 +13,9 @@
 #include "MorpheusHMD.h"
 #include "VirtualHMD.h"
 #include "OrientationFilter.h"
+#include "PipelineLatency.h"
 #include "PositionFilter.h"
+#include "ProtocolMessagePool.h"
 #include "ProtocolVersion.h"
 #include "PS3EyeTracker.h"
 #include "PSDualShock4Controller.h"
@@ -25,13 +29,18 @@
 #include "ServerHMDView.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
+#include "SharedDeviceState.h"
 #include "TrackerManager.h"
 #include "VirtualController.h"
 
+#include <algorithm>
 #include <cassert>
 #include <bitset>
+#include <chrono>
 #include <map>
 #include <boost/shared_ptr.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 //-- pre-declarations -----
 class ServerRequestHandlerImpl;
@@ -77,6 +86,7 @@ typedef std::map<int, RequestConnectionStatePtr> t_connection_state_map;
 typedef std::map<int, RequestConnectionStatePtr>::iterator t_connection_state_iter;
 typedef std::map<int, RequestConnectionStatePtr>::const_iterator t_connection_state_const_iter;
 typedef std::pair<int, RequestConnectionStatePtr> t_id_connection_state_pair;
+typedef std::pair<int, PackedDataFramePtr> t_packed_data_frame_entry;
 
 struct RequestContext
 {
@@ -84,6 +94,106 @@ struct RequestContext
     RequestPtr request;
 };
 
+class SharedDeviceStateReadWriteAccessor
+{
+public:
+    SharedDeviceStateReadWriteAccessor()
+        : m_shared_memory_object(nullptr)
+        , m_region(nullptr)
+    {}
+
+    ~SharedDeviceStateReadWriteAccessor()
+    {
+        dispose();
+    }
+
+    bool initialize(const char *shared_memory_name)
+    {
+        bool bSuccess = false;
+
+        try
+        {
+            SERVER_LOG_INFO("SharedMemory::initialize()") << "Allocating shared memory: " << shared_memory_name;
+
+            // Remember the name of the shared memory
+            m_shared_memory_name = shared_memory_name;
+
+            // Make sure the shared memory block has been removed first
+            boost::interprocess::shared_memory_object::remove(shared_memory_name);
+
+            // Allow non admin-level processed to access the shared memory
+            boost::interprocess::permissions permissions;
+            permissions.set_unrestricted();
+
+            // Create the shared memory object
+            m_shared_memory_object =
+                new boost::interprocess::shared_memory_object(
+                    boost::interprocess::create_only,
+                    shared_memory_name,
+                    boost::interprocess::read_write,
+                    permissions);
+
+            // Resize the shared memory
+            m_shared_memory_object->truncate(sizeof(SharedDeviceStateHeader));
+
+            // Map all of the shared memory for read/write access
+            m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_write);
+
+            // Initialize the shared memory (call constructor using placement new)
+            // This make sure the device slot atomics have the constructor called on them.
+            new (getDeviceStateHeader()) SharedDeviceStateHeader();
+
+            bSuccess = true;
+        }
+        catch (boost::interprocess::interprocess_exception &e)
+        {
+            dispose();
+            SERVER_LOG_ERROR("SharedMemory::initialize()") << "Failed to allocated shared memory: " << m_shared_memory_name
+                << ", reason: " << e.what();
+        }
+
+        return bSuccess;
+    }
+
+    void dispose()
+    {
+        if (m_region != nullptr)
+        {
+            // Call the destructor manually on the header since it was constructed via placement new
+            getDeviceStateHeader()->~SharedDeviceStateHeader();
+
+            delete m_region;
+            m_region = nullptr;
+        }
+
+        if (m_shared_memory_object != nullptr)
+        {
+            delete m_shared_memory_object;
+            m_shared_memory_object = nullptr;
+
+            if (!boost::interprocess::shared_memory_object::remove(m_shared_memory_name))
+            {
+                SERVER_LOG_ERROR("SharedMemory::dispose") << "Failed to free shared memory: " << m_shared_memory_name;
+            }
+        }
+    }
+
+    inline bool getIsInitialized() const
+    {
+        return m_region != nullptr;
+    }
+
+    SharedDeviceStateHeader *getDeviceStateHeader()
+    {
+        return reinterpret_cast<SharedDeviceStateHeader *>(m_region->get_address());
+    }
+
+private:
+    const char *m_shared_memory_name;
+    boost::interprocess::shared_memory_object *m_shared_memory_object;
+    boost::interprocess::mapped_region *m_region;
+};
+
 //-- private implementation -----
 class ServerRequestHandlerImpl
 {
@@ -91,6 +201,12 @@ public:
     ServerRequestHandlerImpl(DeviceManager &deviceManager)
         : m_device_manager(deviceManager)
         , m_connection_state_map()
+        , m_scratch_data_frame(new PSMoveProtocol::DeviceOutputDataFrame)
+        , m_packed_data_frame_cache()
+        , m_response_pool()
+        , m_data_frame_pool()
+        , m_message_pool_miss_rate()
+        , m_shared_device_state_accessor()
     {
     }
 
@@ -100,6 +216,20 @@ public:
         // "Delete called on 'class ServerRequestHandlerImpl' that has virtual functions but non-virtual destructor"
     }
 
+    bool startup()
+    {
+        // Same host clients fall back to data frames if the shared memory isn't available,
+        // so failing to allocate it isn't fatal
+        m_shared_device_state_accessor.initialize(SHARED_DEVICE_STATE_MEMORY_NAME);
+
+        return true;
+    }
+
+    void shutdown()
+    {
+        m_shared_device_state_accessor.dispose();
+    }
+
     bool any_active_bluetooth_requests() const
     {
         bool any_active= false;
@@ -120,6 +250,8 @@ public:
 
     void update()
     {
+        m_message_pool_miss_rate.update();
+
         for (t_connection_state_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
         {
             int connection_id= iter->first;
@@ -175,211 +307,223 @@ public:
         context.request= request;
         context.connection_state= FindOrCreateConnectionState(connection_id);
 
-        // All responses track which request they came from
+        // All responses track which request they came from.
+        // The pooled response is only handed back if the request type had a handler.
+        ResponsePtr pooled_response= m_response_pool.acquire();
         PSMoveProtocol::Response *response= nullptr;
 
         switch (request->type())
         {
             // Controller Requests
             case PSMoveProtocol::Request_RequestType_GET_CONTROLLER_LIST:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__get_controller_list(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_START_CONTROLLER_DATA_STREAM:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__start_controller_data_stream(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_STOP_CONTROLLER_DATA_STREAM:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__stop_controller_data_stream(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_RESET_ORIENTATION:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__reset_orientation(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_UNPAIR_CONTROLLER:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__unpair_controller(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_PAIR_CONTROLLER:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__pair_controller(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_CANCEL_BLUETOOTH_REQUEST:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__cancel_bluetooth_request(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_LED_TRACKING_COLOR:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_led_tracking_color(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_CONTROLLER_MAGNETOMETER_CALIBRATION:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_controller_magnetometer_calibration(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_CONTROLLER_ACCELEROMETER_CALIBRATION:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_controller_accelerometer_calibration(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_CONTROLLER_GYROSCOPE_CALIBRATION:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_controller_gyroscope_calibration(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_OPTICAL_NOISE_CALIBRATION:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_optical_noise_calibration(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_ORIENTATION_FILTER:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_orientation_filter(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_POSITION_FILTER:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_position_filter(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_CONTROLLER_PREDICTION_TIME:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_controller_prediction_time(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_ATTACHED_CONTROLLER:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_attached_controller(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_GAMEPAD_INDEX:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_gamepad_index(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_CONTROLLER_DATA_STREAM_TRACKER_INDEX:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_controller_data_stream_tracker_index(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_CONTROLLER_HAND:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_controller_hand(context, response);
                 break;
 
             // Tracker Requests
             case PSMoveProtocol::Request_RequestType_GET_TRACKER_LIST:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__get_tracker_list(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_START_TRACKER_DATA_STREAM:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__start_tracker_data_stream(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_STOP_TRACKER_DATA_STREAM:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__stop_tracker_data_stream(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_GET_TRACKER_SETTINGS:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__get_tracker_settings(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_TRACKER_FRAME_WIDTH:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_tracker_frame_width(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_TRACKER_FRAME_HEIGHT:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_tracker_frame_height(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_TRACKER_FRAME_RATE:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_tracker_frame_rate(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_TRACKER_EXPOSURE:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_tracker_exposure(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_TRACKER_GAIN:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_tracker_gain(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_TRACKER_OPTION:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_tracker_option(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_TRACKER_COLOR_PRESET:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_tracker_color_preset(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_TRACKER_POSE:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_tracker_pose(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_TRACKER_INTRINSICS:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_tracker_intrinsics(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SAVE_TRACKER_PROFILE:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__save_tracker_profile(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_RELOAD_TRACKER_SETTINGS:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__reload_tracker_settings(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_APPLY_TRACKER_PROFILE:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__apply_tracker_profile(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SEARCH_FOR_NEW_TRACKERS:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__search_for_new_trackers(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_GET_TRACKING_SPACE_SETTINGS:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__get_tracking_space_settings(context, response);
                 break;
 
             // HMD Requests
             case PSMoveProtocol::Request_RequestType_GET_HMD_LIST:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__get_hmd_list(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_START_HMD_DATA_STREAM:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__start_hmd_data_stream(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_STOP_HMD_DATA_STREAM:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__stop_hmd_data_stream(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_HMD_LED_TRACKING_COLOR:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_hmd_led_tracking_color(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_HMD_ACCELEROMETER_CALIBRATION:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_hmd_accelerometer_calibration(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_HMD_GYROSCOPE_CALIBRATION:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_hmd_gyroscope_calibration(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_HMD_ORIENTATION_FILTER:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_hmd_orientation_filter(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_HMD_POSITION_FILTER:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_hmd_position_filter(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_HMD_PREDICTION_TIME:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_hmd_prediction_time(context, response);
                 break;
             case PSMoveProtocol::Request_RequestType_SET_HMD_DATA_STREAM_TRACKER_INDEX:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__set_hmd_data_stream_tracker_index(context, response);
                 break;
 
             // General Service Requests
             case PSMoveProtocol::Request_RequestType_GET_SERVICE_VERSION:
-                response = new PSMoveProtocol::Response;
+                response = pooled_response.get();
                 handle_request__get_service_version(context, response);
                 break;
 
+            case PSMoveProtocol::Request_RequestType_GET_SERVICE_LATENCY_STATS:
+                response = pooled_response.get();
+                handle_request__get_service_latency_stats(context, response);
+                break;
+
+            case PSMoveProtocol::Request_RequestType_GET_SERVICE_TIME:
+                response = pooled_response.get();
+                handle_request__get_service_time(context, response);
+                break;
+
             default:
                 assert(0 && "Whoops, bad request!");
         }
@@ -389,7 +533,7 @@ public:
             response->set_request_id(request->request_id());
         }
 
-        return ResponsePtr(response);
+        return (response != nullptr) ? pooled_response : ResponsePtr();
     }
 
     void handle_input_data_frame(DeviceInputDataFramePtr data_frame)
@@ -500,9 +644,12 @@ public:
 
     void publish_controller_data_frame(
          ServerControllerView *controller_view, 
-         ServerRequestHandler::t_generate_controller_data_frame_for_stream callback)
+         ServerRequestHandler::t_generate_controller_data_frame_for_stream callback,
+         bool bDeferredStreamsOnly)
     {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
         int controller_id= controller_view->getDeviceID();
+        DataStreamRateLimit::t_time_point deferred_deadline= DataStreamRateLimit::t_time_point::max();
 
         // Notify any connections that care about the controller update
         for (t_connection_state_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
@@ -510,19 +657,48 @@ public:
             int connection_id= iter->first;
             RequestConnectionStatePtr connection_state= iter->second;
 
-            if (connection_state->active_controller_streams.test(controller_id))
+            if (connection_state->active_controller_streams.test(controller_id) &&
+                !connection_state->active_controller_stream_info[controller_id].shared_memory_only &&
+                DataStreamRateLimit::is_stream_publish_due(
+                    connection_state->active_controller_stream_info[controller_id], now, bDeferredStreamsOnly, deferred_deadline))
             {
                 const ControllerStreamInfo &streamInfo=
                     connection_state->active_controller_stream_info[controller_id];
+                const int data_frame_key= streamInfo.getDataFrameKey();
+                PackedDataFramePtr packed_data_frame= find_packed_data_frame(data_frame_key);
 
-                // Fill out a data frame specific to this stream using the given callback
-                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
-                callback(controller_view, &streamInfo, data_frame.get());
+                if (!packed_data_frame)
+                {
+                    // Fill out a data frame specific to this stream using the given callback
+                    if (streamInfo.use_compact_data_frames)
+                    {
+                        packed_data_frame= pack_compact_controller_data_frame(controller_view, streamInfo);
+                    }
+                    else
+                    {
+                        m_scratch_data_frame->Clear();
+                        callback(controller_view, &streamInfo, m_scratch_data_frame.get());
+
+                        packed_data_frame= ServerNetworkManager::pack_device_data_frame(m_scratch_data_frame);
+                    }
+                    m_packed_data_frame_cache.push_back(t_packed_data_frame_entry(data_frame_key, packed_data_frame));
+                }
 
                 // Send the controller data frame over the network
-                ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+                if (packed_data_frame)
+                {
+                    ServerNetworkManager::get_instance()->send_packed_device_data_frame(connection_id, packed_data_frame);
+                }
             }
         }
+
+        m_packed_data_frame_cache.clear();
+
+        // Come back for the rate limited streams that skipped this state
+        if (deferred_deadline != DataStreamRateLimit::t_time_point::max())
+        {
+            controller_view->markStateAsDeferred(deferred_deadline);
+        }
     }
 
     void publish_tracker_data_frame(
@@ -543,7 +719,7 @@ public:
                     connection_state->active_tracker_stream_info[tracker_id];
 
                 // Fill out a data frame specific to this stream using the given callback
-                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
+                DeviceOutputDataFramePtr data_frame= m_data_frame_pool.acquire();
                 callback(tracker_view, &streamInfo, data_frame);
 
                 // Send the tracker data frame over the network
@@ -554,9 +730,12 @@ public:
 
     void publish_hmd_data_frame(
         class ServerHMDView *hmd_view,
-        ServerRequestHandler::t_generate_hmd_data_frame_for_stream callback)
+        ServerRequestHandler::t_generate_hmd_data_frame_for_stream callback,
+        bool bDeferredStreamsOnly)
     {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
         int hmd_id = hmd_view->getDeviceID();
+        DataStreamRateLimit::t_time_point deferred_deadline = DataStreamRateLimit::t_time_point::max();
 
         // Notify any connections that care about the tracker update
         for (t_connection_state_iter iter = m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
@@ -564,22 +743,138 @@ public:
             int connection_id = iter->first;
             RequestConnectionStatePtr connection_state = iter->second;
 
-            if (connection_state->active_hmd_streams.test(hmd_id))
+            if (connection_state->active_hmd_streams.test(hmd_id) &&
+                !connection_state->active_hmd_stream_info[hmd_id].shared_memory_only &&
+                DataStreamRateLimit::is_stream_publish_due(
+                    connection_state->active_hmd_stream_info[hmd_id], now, bDeferredStreamsOnly, deferred_deadline))
             {
                 const HMDStreamInfo &streamInfo =
                     connection_state->active_hmd_stream_info[hmd_id];
+                const int data_frame_key= streamInfo.getDataFrameKey();
+                PackedDataFramePtr packed_data_frame= find_packed_data_frame(data_frame_key);
 
-                // Fill out a data frame specific to this stream using the given callback
-                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
-                callback(hmd_view, &streamInfo, data_frame);
+                if (!packed_data_frame)
+                {
+                    // Fill out a data frame specific to this stream using the given callback
+                    if (streamInfo.use_compact_data_frames)
+                    {
+                        packed_data_frame= pack_compact_hmd_data_frame(hmd_view, streamInfo);
+                    }
+                    else
+                    {
+                        m_scratch_data_frame->Clear();
+                        callback(hmd_view, &streamInfo, m_scratch_data_frame);
+
+                        packed_data_frame= ServerNetworkManager::pack_device_data_frame(m_scratch_data_frame);
+                    }
+                    m_packed_data_frame_cache.push_back(t_packed_data_frame_entry(data_frame_key, packed_data_frame));
+                }
 
                 // Send the hmd data frame over the network
-                ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+                if (packed_data_frame)
+                {
+                    ServerNetworkManager::get_instance()->send_packed_device_data_frame(connection_id, packed_data_frame);
+                }
             }
         }
+
+        m_packed_data_frame_cache.clear();
+
+        // Come back for the rate limited streams that skipped this state
+        if (deferred_deadline != DataStreamRateLimit::t_time_point::max())
+        {
+            hmd_view->markStateAsDeferred(deferred_deadline);
+        }
     }    
 
+    SharedDeviceStateSlot<SharedControllerState> *get_shared_controller_state_slot(int controller_id)
+    {
+        SharedDeviceStateSlot<SharedControllerState> *slot= nullptr;
+
+        if (m_shared_device_state_accessor.getIsInitialized() &&
+            ServerUtility::is_index_valid(controller_id, PSMOVESERVICE_MAX_CONTROLLER_COUNT))
+        {
+            for (t_connection_state_const_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
+            {
+                const RequestConnectionStatePtr &connection_state= iter->second;
+
+                if (connection_state->active_controller_streams.test(controller_id) &&
+                    connection_state->active_controller_stream_info[controller_id].shared_memory_only)
+                {
+                    slot= &m_shared_device_state_accessor.getDeviceStateHeader()->controllers[controller_id];
+                    break;
+                }
+            }
+        }
+
+        return slot;
+    }
+
+    SharedDeviceStateSlot<SharedHMDState> *get_shared_hmd_state_slot(int hmd_id)
+    {
+        SharedDeviceStateSlot<SharedHMDState> *slot= nullptr;
+
+        if (m_shared_device_state_accessor.getIsInitialized() &&
+            ServerUtility::is_index_valid(hmd_id, PSMOVESERVICE_MAX_HMD_COUNT))
+        {
+            for (t_connection_state_const_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
+            {
+                const RequestConnectionStatePtr &connection_state= iter->second;
+
+                if (connection_state->active_hmd_streams.test(hmd_id) &&
+                    connection_state->active_hmd_stream_info[hmd_id].shared_memory_only)
+                {
+                    slot= &m_shared_device_state_accessor.getDeviceStateHeader()->hmds[hmd_id];
+                    break;
+                }
+            }
+        }
+
+        return slot;
+    }
+
 protected:
+    static PackedDataFramePtr pack_compact_controller_data_frame(
+        const ServerControllerView *controller_view,
+        const ControllerStreamInfo &stream_info)
+    {
+        SharedControllerState controller_state;
+        CompactDataFrame compact_frame;
+
+        // The shared device state already has everything a compact data frame carries
+        ServerControllerView::generate_controller_shared_state(controller_view, &controller_state);
+        compact_frame.encodeControllerState(controller_view->getDeviceID(), controller_state, stream_info.include_physics_data);
+
+        return ServerNetworkManager::pack_compact_device_data_frame(compact_frame, &controller_view->getLastFilterStageTimes());
+    }
+
+    static PackedDataFramePtr pack_compact_hmd_data_frame(
+        const ServerHMDView *hmd_view,
+        const HMDStreamInfo &stream_info)
+    {
+        SharedHMDState hmd_state;
+        CompactDataFrame compact_frame;
+
+        ServerHMDView::generate_hmd_shared_state(hmd_view, &hmd_state);
+        compact_frame.encodeHmdState(hmd_view->getDeviceID(), hmd_state, stream_info.include_physics_data);
+
+        return ServerNetworkManager::pack_compact_device_data_frame(compact_frame, &hmd_view->getLastFilterStageTimes());
+    }
+
+    PackedDataFramePtr find_packed_data_frame(int data_frame_key) const
+    {
+        // Only a handful of distinct stream configurations per device, a linear search is fine
+        for (const t_packed_data_frame_entry &entry : m_packed_data_frame_cache)
+        {
+            if (entry.first == data_frame_key)
+            {
+                return entry.second;
+            }
+        }
+
+        return PackedDataFramePtr();
+    }
+
     RequestConnectionStatePtr FindOrCreateConnectionState(int connection_id)
     {
         t_connection_state_iter iter= m_connection_state_map.find(connection_id);
@@ -809,6 +1104,21 @@ protected:
                 streamInfo.include_calibrated_sensor_data = request.include_calibrated_sensor_data();
                 streamInfo.include_raw_tracker_data = request.include_raw_tracker_data();
                 streamInfo.disable_roi = request.disable_roi();
+                streamInfo.shared_memory_only =
+                    request.shared_memory_only() &&
+                    m_shared_device_state_accessor.getIsInitialized() &&
+                    !streamInfo.include_raw_sensor_data &&
+                    !streamInfo.include_calibrated_sensor_data &&
+                    !streamInfo.include_raw_tracker_data;
+                // Compact data frames only carry the pose, physics, buttons and analog values,
+                // which virtual controllers don't fit (they have arbitrary axes)
+                streamInfo.use_compact_data_frames =
+                    request.use_compact_data_frames() &&
+                    controller_view->getControllerDeviceType() != CommonDeviceState::VirtualController &&
+                    !streamInfo.include_raw_sensor_data &&
+                    !streamInfo.include_calibrated_sensor_data &&
+                    !streamInfo.include_raw_tracker_data;
+                streamInfo.publish_rate_hz = std::max(request.publish_rate_hz(), 0.f);
 
                 SERVER_LOG_INFO("ServerRequestHandler") << "Start controller(" << controller_id << ") stream ("
                     << "pos=" << streamInfo.include_position_data
@@ -817,6 +1127,9 @@ protected:
                     << ",cal_sens=" << streamInfo.include_calibrated_sensor_data
                     << ",trkr=" << streamInfo.include_raw_tracker_data
                     << ",roi=" << streamInfo.disable_roi
+                    << ",shm=" << streamInfo.shared_memory_only
+                    << ",compact=" << streamInfo.use_compact_data_frames
+                    << ",rate=" << streamInfo.publish_rate_hz
                     << ")";
 
                 if (streamInfo.include_position_data)
@@ -1819,6 +2132,10 @@ protected:
                 case CommonControllerState::PS3EYE:
                     tracker_info->set_tracker_type(PSMoveProtocol::PS3EYE);
                     break;
+                case CommonControllerState::ReplayTracker:
+                    // Replays of PS3EYE recordings look like a PS3EYE to clients
+                    tracker_info->set_tracker_type(PSMoveProtocol::PS3EYE);
+                    break;
                 default:
                     assert(0 && "Unhandled tracker type");
                 }
@@ -2732,6 +3049,18 @@ protected:
                 streamInfo.include_calibrated_sensor_data = request.include_calibrated_sensor_data();
                 streamInfo.include_raw_tracker_data = request.include_raw_tracker_data();
                 streamInfo.disable_roi = request.disable_roi();
+                streamInfo.shared_memory_only =
+                    request.shared_memory_only() &&
+                    m_shared_device_state_accessor.getIsInitialized() &&
+                    !streamInfo.include_raw_sensor_data &&
+                    !streamInfo.include_calibrated_sensor_data &&
+                    !streamInfo.include_raw_tracker_data;
+                streamInfo.use_compact_data_frames =
+                    request.use_compact_data_frames() &&
+                    !streamInfo.include_raw_sensor_data &&
+                    !streamInfo.include_calibrated_sensor_data &&
+                    !streamInfo.include_raw_tracker_data;
+                streamInfo.publish_rate_hz = std::max(request.publish_rate_hz(), 0.f);
 
                 SERVER_LOG_INFO("ServerRequestHandler") << "Start hmd(" << hmd_id << ") stream ("
                     << "pos=" << streamInfo.include_position_data
@@ -2740,6 +3069,9 @@ protected:
                     << ",cal_sens=" << streamInfo.include_calibrated_sensor_data
                     << ",trkr=" << streamInfo.include_raw_tracker_data
                     << ",roi=" << streamInfo.disable_roi
+                    << ",shm=" << streamInfo.shared_memory_only
+                    << ",compact=" << streamInfo.use_compact_data_frames
+                    << ",rate=" << streamInfo.publish_rate_hz
                     << ")";
 
                 if (streamInfo.disable_roi)
@@ -3116,6 +3448,76 @@ protected:
         response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
     }
 
+    void handle_request__get_service_latency_stats(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        PSMoveProtocol::Response_ResultServiceLatencyStats* latency_stats = response->mutable_result_service_latency_stats();
+
+        response->set_type(PSMoveProtocol::Response_ResponseType_SERVICE_LATENCY_STATS);
+
+        for (int stage_index = 0; stage_index < PipelineLatencyStage_COUNT; ++stage_index)
+        {
+            const ePipelineLatencyStage stage = static_cast<ePipelineLatencyStage>(stage_index);
+            const LatencyHistogramSummary summary = PipelineLatencyStats::getStageHistogram(stage).getSummary();
+            PSMoveProtocol::Response_ResultServiceLatencyStats_StageLatency *stage_latency = latency_stats->add_stages();
+
+            stage_latency->set_stage_name(PipelineLatencyStats::getStageName(stage));
+            stage_latency->set_sample_count(summary.sample_count);
+            stage_latency->set_p50_us(summary.p50_us);
+            stage_latency->set_p99_us(summary.p99_us);
+            stage_latency->set_max_us(summary.max_us);
+        }
+
+        latency_stats->set_message_pool_misses_per_second(
+            static_cast<float>(m_message_pool_miss_rate.getMissesPerSecond()));
+
+        const bool reset_stats= context.request->request_get_service_latency_stats().reset_stats();
+
+        for (int controller_id = 0; controller_id < ControllerManager::k_max_devices; ++controller_id)
+        {
+            ServerControllerViewPtr controller_view= m_device_manager.getControllerViewPtr(controller_id);
+
+            if (controller_view && controller_view->getIsOpen())
+            {
+                PoseSensorQueueStats queue_stats;
+                controller_view->getPoseSensorQueueStats(queue_stats);
+
+                PSMoveProtocol::Response_ResultServiceLatencyStats_ControllerQueueStats *controller_queue= 
+                    latency_stats->add_controller_queues();
+                controller_queue->set_controller_id(controller_id);
+                controller_queue->set_imu_queue_depth_max(queue_stats.imu_queue_depth_max);
+                controller_queue->set_optical_queue_depth_max(queue_stats.optical_queue_depth_max);
+                controller_queue->set_imu_dropped_count(queue_stats.imu_dropped_count);
+                controller_queue->set_optical_dropped_count(queue_stats.optical_dropped_count);
+                controller_queue->set_merge_dropped_count(queue_stats.merge_dropped_count);
+
+                if (reset_stats)
+                {
+                    controller_view->resetPoseSensorQueueStats();
+                }
+            }
+        }
+
+        if (reset_stats)
+        {
+            PipelineLatencyStats::resetAll();
+        }
+
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+    }
+
+    void handle_request__get_service_time(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        response->set_type(PSMoveProtocol::Response_ResponseType_SERVICE_TIME);
+
+        // Clients time the round trip of this request to line their clock up with the data frame sample times
+        response->mutable_result_service_time()->set_service_time_us(PipelineLatencyStats::getTimestampUs());
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+    }
+
     // -- Data Frame Updates -----
     void handle_data_frame__controller_packet(
         RequestConnectionStatePtr connection_state,
@@ -3177,6 +3579,7 @@ protected:
                         }
                     } break;
                 case CommonDeviceState::eDeviceType::PSNavi:
+                case CommonDeviceState::eDeviceType::VirtualController:
                     {
                         // Nothing to update...
                     } break;
@@ -3219,6 +3622,12 @@ protected:
                             streamInfo.led_override_active= controller_view->getIsLEDOverrideActive();
                         }
                     } break;
+                case CommonDeviceState::eDeviceType::PS3EYE:
+                case CommonDeviceState::eDeviceType::ReplayTracker:
+                default:
+                    {
+                        // Trackers, live or replayed, and HMDs don't take controller input
+                    } break;
                 }
             }
         }
@@ -3227,6 +3636,19 @@ protected:
 private:
     DeviceManager &m_device_manager;
     t_connection_state_map m_connection_state_map;
+
+    // Data frames are generated into the scratch frame, packed once per distinct stream key
+    // and shared by every connection streaming that device with the same key
+    DeviceOutputDataFramePtr m_scratch_data_frame;
+    std::vector<t_packed_data_frame_entry> m_packed_data_frame_cache;
+
+    // Recycled responses and data frames, so steady state tracking doesn't hit the heap
+    ProtocolMessagePool<PSMoveProtocol::Response> m_response_pool;
+    ProtocolMessagePool<PSMoveProtocol::DeviceOutputDataFrame> m_data_frame_pool;
+    ProtocolMessagePoolMissRate m_message_pool_miss_rate;
+
+    // Controller and HMD state for same host clients, written by the device views on publish
+    SharedDeviceStateReadWriteAccessor m_shared_device_state_accessor;
 };
 
 //-- public interface -----
@@ -3256,7 +3678,7 @@ bool ServerRequestHandler::any_active_bluetooth_requests() const
 bool ServerRequestHandler::startup()
 {
     m_instance= this;
-    return true;
+    return m_implementation_ptr->startup();
 }
 
 void ServerRequestHandler::update()
@@ -3266,6 +3688,7 @@ void ServerRequestHandler::update()
 
 void ServerRequestHandler::shutdown()
 {
+    m_implementation_ptr->shutdown();
     m_instance= NULL;
 }
 
@@ -3286,9 +3709,10 @@ void ServerRequestHandler::handle_client_connection_stopped(int connection_id)
 
 void ServerRequestHandler::publish_controller_data_frame(
     ServerControllerView *controller_view, 
-    t_generate_controller_data_frame_for_stream callback)
+    t_generate_controller_data_frame_for_stream callback,
+    bool bDeferredStreamsOnly)
 {
-    return m_implementation_ptr->publish_controller_data_frame(controller_view, callback);
+    return m_implementation_ptr->publish_controller_data_frame(controller_view, callback, bDeferredStreamsOnly);
 }
 
 void ServerRequestHandler::publish_tracker_data_frame(
@@ -3300,7 +3724,18 @@ void ServerRequestHandler::publish_tracker_data_frame(
 
 void ServerRequestHandler::publish_hmd_data_frame(
     class ServerHMDView *hmd_view,
-    t_generate_hmd_data_frame_for_stream callback)
+    t_generate_hmd_data_frame_for_stream callback,
+    bool bDeferredStreamsOnly)
+{
+    return m_implementation_ptr->publish_hmd_data_frame(hmd_view, callback, bDeferredStreamsOnly);
+}
+
+SharedDeviceStateSlot<SharedControllerState> *ServerRequestHandler::get_shared_controller_state_slot(int controller_id)
+{
+    return m_implementation_ptr->get_shared_controller_state_slot(controller_id);
+}
+
+SharedDeviceStateSlot<SharedHMDState> *ServerRequestHandler::get_shared_hmd_state_slot(int hmd_id)
 {
-    return m_implementation_ptr->publish_hmd_data_frame(hmd_view, callback);
+    return m_implementation_ptr->get_shared_hmd_state_slot(hmd_id);
 }
@@ -3,9 +3,13 @@
 
 // -- includes -----
 #include "PSMoveProtocolInterface.h"
+#include <chrono>
 
 // -- pre-declarations -----
 class DeviceManager;
+struct SharedControllerState;
+struct SharedHMDState;
+template <typename t_device_state> struct SharedDeviceStateSlot;
 namespace boost {
     namespace program_options {
         class variables_map;
@@ -21,8 +25,13 @@ struct ControllerStreamInfo
     bool include_raw_tracker_data;
     bool led_override_active;
 	bool disable_roi;
+    bool shared_memory_only;
+    bool use_compact_data_frames;
+    bool has_deferred_publish;
+    float publish_rate_hz;
     int last_data_input_sequence_number;
     int selected_tracker_index;
+    std::chrono::time_point<std::chrono::high_resolution_clock> last_publish_timestamp;
 
     inline void Clear()
     {
@@ -33,8 +42,25 @@ struct ControllerStreamInfo
         include_raw_tracker_data = false;
         led_override_active = false;
 		disable_roi = false;
+        shared_memory_only = false;
+        use_compact_data_frames = false;
+        has_deferred_publish = false;
+        publish_rate_hz = 0.f;
 		last_data_input_sequence_number = -1;
         selected_tracker_index = 0;
+        last_publish_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+    }
+
+    /// Streams with the same key get identical data frames, so they can share one
+    inline int getDataFrameKey() const
+    {
+        return
+            (include_position_data ? 0x01 : 0) |
+            (include_physics_data ? 0x02 : 0) |
+            (include_raw_sensor_data ? 0x04 : 0) |
+            (include_calibrated_sensor_data ? 0x08 : 0) |
+            (include_raw_tracker_data ? (0x10 | (selected_tracker_index << 5)) : 0) |
+            (use_compact_data_frames ? 0x40000000 : 0);
     }
 };
 
@@ -58,7 +84,12 @@ struct HMDStreamInfo
 	bool include_calibrated_sensor_data;
 	bool include_raw_tracker_data;
 	bool disable_roi;
+    bool shared_memory_only;
+    bool use_compact_data_frames;
+    bool has_deferred_publish;
+    float publish_rate_hz;
     int selected_tracker_index;
+    std::chrono::time_point<std::chrono::high_resolution_clock> last_publish_timestamp;
 
     inline void Clear()
     {
@@ -68,7 +99,24 @@ struct HMDStreamInfo
 		include_calibrated_sensor_data = false;
 		include_raw_tracker_data = false;
 		disable_roi = false;
+        shared_memory_only = false;
+        use_compact_data_frames = false;
+        has_deferred_publish = false;
+        publish_rate_hz = 0.f;
         selected_tracker_index = 0;
+        last_publish_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+    }
+
+    /// Streams with the same key get identical data frames, so they can share one
+    inline int getDataFrameKey() const
+    {
+        return
+            (include_position_data ? 0x01 : 0) |
+            (include_physics_data ? 0x02 : 0) |
+            (include_raw_sensor_data ? 0x04 : 0) |
+            (include_calibrated_sensor_data ? 0x08 : 0) |
+            (include_raw_tracker_data ? (0x10 | (selected_tracker_index << 5)) : 0) |
+            (use_compact_data_frames ? 0x40000000 : 0);
     }
 };
 
@@ -94,13 +142,17 @@ public:
     /// we need to provide a callback that will fill out a data frame given:
     /// * A \ref ServerControllerView we want to publish to all listening connections
     /// * A \ref ControllerStreamInfo that describes what info the connection wants
-    /// This callback will be called for each listening connection
+    /// This callback will be called once for each distinct ControllerStreamInfo::getDataFrameKey()
+    /// and the packed data frame is shared by all of the connections with that key.
+    /// Rate limited streams that aren't due yet are skipped and the controller state is marked as deferred.
+    /// Publishing with bDeferredStreamsOnly set only sends to those skipped streams.
     typedef void (*t_generate_controller_data_frame_for_stream)(
             const class ServerControllerView *controller_view,
             const ControllerStreamInfo *stream_info,
             PSMoveProtocol::DeviceOutputDataFrame *data_frame);
     void publish_controller_data_frame(
-        class ServerControllerView *controller_view, t_generate_controller_data_frame_for_stream callback);
+        class ServerControllerView *controller_view, t_generate_controller_data_frame_for_stream callback,
+        bool bDeferredStreamsOnly);
 
     /// When publishing tracker data to all listening connections
     /// we need to provide a callback that will fill out a data frame given:
@@ -118,13 +170,22 @@ public:
     /// we need to provide a callback that will fill out a data frame given:
     /// * A \ref ServerHMDView we want to publish to all listening connections
     /// * A \ref HMDStreamInfo that describes what info the connection wants
-    /// This callback will be called for each listening connection
+    /// This callback will be called once for each distinct HMDStreamInfo::getDataFrameKey()
+    /// and the packed data frame is shared by all of the connections with that key.
+    /// Rate limited streams are handled the same way as for controllers.
     typedef void(*t_generate_hmd_data_frame_for_stream)(
         const class ServerHMDView *hmd_view,
         const HMDStreamInfo *stream_info,
         DeviceOutputDataFramePtr &data_frame);
     void publish_hmd_data_frame(
-        class ServerHMDView *hmd_view, t_generate_hmd_data_frame_for_stream callback);        
+        class ServerHMDView *hmd_view, t_generate_hmd_data_frame_for_stream callback,
+        bool bDeferredStreamsOnly);        
+
+    /// Same host clients can read the controller and HMD state straight out of shared memory.
+    /// Returns the shared memory slot to write a device's state to,
+    /// or nullptr if no connection is reading that device through shared memory.
+    SharedDeviceStateSlot<SharedControllerState> *get_shared_controller_state_slot(int controller_id);
+    SharedDeviceStateSlot<SharedHMDState> *get_shared_hmd_state_slot(int hmd_id);
 
 private:
     // private implementation - same lifetime as the ServerRequestHandler
@@ -0,0 +1,95 @@
+//-- includes -----
+#include "ColorMembershipCube.h"
+
+#include <string.h>
+
+//-- constants -----
+static const int k_blue_cell_count= 1 << ColorMembershipCube::k_blue_bits;
+
+//-- public interface -----
+ColorMembershipCube::ColorMembershipCube()
+    : m_bIsValid(false)
+{
+    memset(m_cells, 0, sizeof(m_cells));
+    memset(&m_bounds, 0, sizeof(m_bounds));
+}
+
+void ColorMembershipCube::rebuild(const HSVColorClassifierBounds &bounds)
+{
+    static_assert(k_blue_cell_count == 32, "a run of blue cells is expected to fill half of a cell word");
+
+    HSVColorClassifierBounds classifier_bounds= bounds;
+    classifier_bounds.mask_bits= 1;
+
+    // Classify the center color of every cell, one run of blue cells at a time
+    uint8_t bgr_row[k_blue_cell_count*3];
+    uint8_t mask_row[k_blue_cell_count];
+
+    memset(m_cells, 0, sizeof(m_cells));
+
+    for (int red_cell = 0; red_cell < (1 << k_red_bits); ++red_cell)
+    {
+        const uint8_t r= static_cast<uint8_t>((red_cell << (8 - k_red_bits)) | (1 << (7 - k_red_bits)));
+
+        for (int green_cell = 0; green_cell < (1 << k_green_bits); ++green_cell)
+        {
+            const uint8_t g= static_cast<uint8_t>((green_cell << (8 - k_green_bits)) | (1 << (7 - k_green_bits)));
+
+            for (int blue_cell = 0; blue_cell < k_blue_cell_count; ++blue_cell)
+            {
+                bgr_row[blue_cell*3 + 0]= static_cast<uint8_t>((blue_cell << (8 - k_blue_bits)) | (1 << (7 - k_blue_bits)));
+                bgr_row[blue_cell*3 + 1]= g;
+                bgr_row[blue_cell*3 + 2]= r;
+            }
+
+            HSVColorClassifier::classify_bgr_row(bgr_row, mask_row, k_blue_cell_count, &classifier_bounds, 1);
+
+            uint64_t run_bits= 0;
+            for (int blue_cell = 0; blue_cell < k_blue_cell_count; ++blue_cell)
+            {
+                run_bits|= static_cast<uint64_t>(mask_row[blue_cell]) << blue_cell;
+            }
+
+            const int cell_index= compute_cell_index(0, g, r);
+            m_cells[cell_index >> 6]|= run_bits << (cell_index & 63);
+        }
+    }
+
+    m_bounds= bounds;
+    m_bIsValid= true;
+}
+
+bool ColorMembershipCube::getHasBounds(const HSVColorClassifierBounds &bounds) const
+{
+    return
+        m_bIsValid &&
+        m_bounds.hue_min[0] == bounds.hue_min[0] && m_bounds.hue_max[0] == bounds.hue_max[0] &&
+        m_bounds.hue_min[1] == bounds.hue_min[1] && m_bounds.hue_max[1] == bounds.hue_max[1] &&
+        m_bounds.saturation_min == bounds.saturation_min && m_bounds.saturation_max == bounds.saturation_max &&
+        m_bounds.value_min == bounds.value_min && m_bounds.value_max == bounds.value_max;
+}
+
+void ColorMembershipCube::classify_bgr_row(
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const ColorMembershipCube * const *cubes, const uint8_t *mask_bits, int cube_count)
+{
+    for (int pixel_index = 0; pixel_index < pixel_count; ++pixel_index)
+    {
+        const int cell_index= compute_cell_index(bgr_row[0], bgr_row[1], bgr_row[2]);
+        const int word_index= cell_index >> 6;
+        const int bit_index= cell_index & 63;
+        uint8_t mask= 0;
+
+        for (int cube_index = 0; cube_index < cube_count; ++cube_index)
+        {
+            if (((cubes[cube_index]->m_cells[word_index] >> bit_index) & 1) != 0)
+            {
+                mask|= mask_bits[cube_index];
+            }
+        }
+
+        *out_mask_row= mask;
+        bgr_row+= 3;
+        ++out_mask_row;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef COLOR_MEMBERSHIP_CUBE_H
+#define COLOR_MEMBERSHIP_CUBE_H
+
+//-- includes -----
+#include "HSVColorClassifier.h"
+
+//-- definitions -----
+// A bit-packed RGB cube quantized to 5-6-5 bits per channel (8KB) that answers
+// "is this BGR pixel inside the given HSV bounds" with a single cache-resident lookup.
+// Each cell stores the classification of its center color, so pixels near the edge
+// of the bounds can be off by up to one quantization step compared to HSVColorClassifier.
+class ColorMembershipCube
+{
+public:
+    static const int k_red_bits= 5;
+    static const int k_green_bits= 6;
+    static const int k_blue_bits= 5;
+    static const int k_cell_count= 1 << (k_red_bits + k_green_bits + k_blue_bits);
+    static const int k_word_count= k_cell_count / 64;
+
+    ColorMembershipCube();
+
+    /// Reclassifies every cell against the given bounds (the bounds mask_bits are ignored)
+    void rebuild(const HSVColorClassifierBounds &bounds);
+
+    bool getHasBounds(const HSVColorClassifierBounds &bounds) const;
+
+    /// Classifies a row of BGR pixels against several cubes at once
+    /// \param bgr_row The source pixels, 3 bytes per pixel in BGR order
+    /// \param out_mask_row One byte per pixel: the OR of the mask_bits of every cube containing the pixel
+    /// \param pixel_count The number of pixels in the row
+    /// \param cubes The cubes to test each pixel against
+    /// \param mask_bits The bits to set in the mask for each cube
+    /// \param cube_count The number of cubes
+    static void classify_bgr_row(
+        const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+        const ColorMembershipCube * const *cubes, const uint8_t *mask_bits, int cube_count);
+
+private:
+    static inline int compute_cell_index(const uint8_t b, const uint8_t g, const uint8_t r)
+    {
+        return
+            ((r >> (8 - k_red_bits)) << (k_green_bits + k_blue_bits)) |
+            ((g >> (8 - k_green_bits)) << k_blue_bits) |
+            (b >> (8 - k_blue_bits));
+    }
+
+    uint64_t m_cells[k_word_count];
+    HSVColorClassifierBounds m_bounds;
+    bool m_bIsValid;
+};
+
+#endif // COLOR_MEMBERSHIP_CUBE_H
@@ -0,0 +1,621 @@
+//-- includes -----
+#include "HSVColorClassifier.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define HSV_CLASSIFIER_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        // MSVC lets any function use any intrinsic
+        #define HSV_CLASSIFIER_TARGET(isa)
+    #else
+        // GCC and clang need the instruction set enabled per function
+        #define HSV_CLASSIFIER_TARGET(isa) __attribute__((target(isa)))
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define HSV_CLASSIFIER_NEON
+    #include <arm_neon.h>
+#endif
+
+//-- constants -----
+// Fixed point precision used by OpenCV's 8-bit RGB->HSV conversion
+static const int k_hsv_shift= 12;
+static const int k_hsv_round= 1 << (k_hsv_shift - 1);
+static const int k_hue_range= 180;
+
+// Number of pixels processed per iteration of the vectorized loops
+static const int k_simd_block_size= 16;
+
+//-- definitions -----
+// Reciprocal tables used to divide by the value and the chroma (same as cv::RGB2HSV_b)
+struct HSVDivisionTables
+{
+    int32_t sdiv[256];
+    int32_t hdiv[256];
+
+    HSVDivisionTables()
+    {
+        sdiv[0]= 0;
+        hdiv[0]= 0;
+
+        for (int i = 1; i < 256; ++i)
+        {
+            // std::lrint rounds half to even, same as cv::saturate_cast<int>(double)
+            sdiv[i]= static_cast<int32_t>(std::lrint((255 << k_hsv_shift) / (1.0*i)));
+            hdiv[i]= static_cast<int32_t>(std::lrint((k_hue_range << k_hsv_shift) / (6.0*i)));
+        }
+    }
+};
+
+//-- prototypes -----
+static const HSVDivisionTables &get_division_tables();
+static HSVColorClassifier::eInstructionSet detect_instruction_set();
+static bool is_instruction_set_supported(HSVColorClassifier::eInstructionSet instruction_set);
+static void classify_bgr_row_scalar(
+    const HSVDivisionTables &tables,
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count);
+
+#if defined(HSV_CLASSIFIER_X86)
+static int classify_bgr_row_sse41(
+    const HSVDivisionTables &tables,
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count);
+static int classify_bgr_row_avx2(
+    const HSVDivisionTables &tables,
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count);
+#elif defined(HSV_CLASSIFIER_NEON)
+static int classify_bgr_row_neon(
+    const HSVDivisionTables &tables,
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count);
+#endif
+
+//-- public interface -----
+HSVColorClassifier::eInstructionSet HSVColorClassifier::get_instruction_set()
+{
+    static const eInstructionSet k_instruction_set= detect_instruction_set();
+
+    return k_instruction_set;
+}
+
+const char *HSVColorClassifier::get_instruction_set_name(eInstructionSet instruction_set)
+{
+    switch (instruction_set)
+    {
+    case Scalar:
+        return "Scalar";
+    case SSE41:
+        return "SSE4.1";
+    case AVX2:
+        return "AVX2";
+    case NEON:
+        return "NEON";
+    default:
+        return "Unknown";
+    }
+}
+
+void HSVColorClassifier::classify_bgr_row(
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count)
+{
+    classify_bgr_row_with_instruction_set(get_instruction_set(), bgr_row, out_mask_row, pixel_count, bounds, bounds_count);
+}
+
+void HSVColorClassifier::classify_bgr_row_with_instruction_set(
+    eInstructionSet instruction_set,
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count)
+{
+    assert(bounds_count >= 0 && bounds_count <= HSV_COLOR_CLASSIFIER_MAX_BOUNDS);
+    const HSVDivisionTables &tables= get_division_tables();
+    int processed_count= 0;
+
+    if (bounds_count > HSV_COLOR_CLASSIFIER_MAX_BOUNDS)
+    {
+        bounds_count= HSV_COLOR_CLASSIFIER_MAX_BOUNDS;
+    }
+
+    if (is_instruction_set_supported(instruction_set))
+    {
+        switch (instruction_set)
+        {
+    #if defined(HSV_CLASSIFIER_X86)
+        case SSE41:
+            processed_count= classify_bgr_row_sse41(tables, bgr_row, out_mask_row, pixel_count, bounds, bounds_count);
+            break;
+        case AVX2:
+            processed_count= classify_bgr_row_avx2(tables, bgr_row, out_mask_row, pixel_count, bounds, bounds_count);
+            break;
+    #elif defined(HSV_CLASSIFIER_NEON)
+        case NEON:
+            processed_count= classify_bgr_row_neon(tables, bgr_row, out_mask_row, pixel_count, bounds, bounds_count);
+            break;
+    #endif
+        default:
+            break;
+        }
+    }
+
+    // The vectorized loops only handle whole blocks of pixels, finish the rest of the row here
+    classify_bgr_row_scalar(
+        tables,
+        bgr_row + processed_count*3, out_mask_row + processed_count, pixel_count - processed_count,
+        bounds, bounds_count);
+}
+
+//-- private methods -----
+static const HSVDivisionTables &get_division_tables()
+{
+    static const HSVDivisionTables k_tables;
+
+    return k_tables;
+}
+
+static HSVColorClassifier::eInstructionSet detect_instruction_set()
+{
+#if defined(HSV_CLASSIFIER_X86)
+    #if defined(_MSC_VER)
+    int cpu_info[4];
+    bool bHasSSE41= false;
+    bool bHasAVX2= false;
+
+    __cpuid(cpu_info, 0);
+    const int max_function_id= cpu_info[0];
+
+    if (max_function_id >= 1)
+    {
+        __cpuid(cpu_info, 1);
+        bHasSSE41= (cpu_info[2] & (1 << 19)) != 0;
+
+        // AVX needs both the CPU support and the OS saving the YMM registers
+        const bool bHasOSXSAVE= (cpu_info[2] & (1 << 27)) != 0;
+        const bool bHasAVX= (cpu_info[2] & (1 << 28)) != 0;
+
+        if (bHasOSXSAVE && bHasAVX && (_xgetbv(0) & 0x6) == 0x6 && max_function_id >= 7)
+        {
+            __cpuidex(cpu_info, 7, 0);
+            bHasAVX2= (cpu_info[1] & (1 << 5)) != 0;
+        }
+    }
+    #else
+    __builtin_cpu_init();
+    const bool bHasSSE41= __builtin_cpu_supports("sse4.1") != 0;
+    const bool bHasAVX2= __builtin_cpu_supports("avx2") != 0;
+    #endif
+
+    if (bHasAVX2)
+    {
+        return HSVColorClassifier::AVX2;
+    }
+    else if (bHasSSE41)
+    {
+        return HSVColorClassifier::SSE41;
+    }
+    else
+    {
+        return HSVColorClassifier::Scalar;
+    }
+#elif defined(HSV_CLASSIFIER_NEON)
+    return HSVColorClassifier::NEON;
+#else
+    return HSVColorClassifier::Scalar;
+#endif
+}
+
+static bool is_instruction_set_supported(HSVColorClassifier::eInstructionSet instruction_set)
+{
+    const HSVColorClassifier::eInstructionSet best_instruction_set= HSVColorClassifier::get_instruction_set();
+
+    switch (instruction_set)
+    {
+    case HSVColorClassifier::Scalar:
+        return true;
+    case HSVColorClassifier::SSE41:
+        return best_instruction_set == HSVColorClassifier::SSE41 || best_instruction_set == HSVColorClassifier::AVX2;
+    case HSVColorClassifier::AVX2:
+        return best_instruction_set == HSVColorClassifier::AVX2;
+    case HSVColorClassifier::NEON:
+        return best_instruction_set == HSVColorClassifier::NEON;
+    default:
+        return false;
+    }
+}
+
+static void classify_bgr_row_scalar(
+    const HSVDivisionTables &tables,
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count)
+{
+    for (int pixel_index = 0; pixel_index < pixel_count; ++pixel_index)
+    {
+        const int b= bgr_row[0];
+        const int g= bgr_row[1];
+        const int r= bgr_row[2];
+
+        // Same integer math as cv::RGB2HSV_b
+        const int v= std::max(b, std::max(g, r));
+        const int vmin= std::min(b, std::min(g, r));
+        const int diff= v - vmin;
+        const int vr= v == r ? -1 : 0;
+        const int vg= v == g ? -1 : 0;
+
+        const int s= (diff*tables.sdiv[v] + k_hsv_round) >> k_hsv_shift;
+        int h= (vr & (g - b)) + (~vr & ((vg & (b - r + 2*diff)) + ((~vg) & (r - g + 4*diff))));
+        h= (h*tables.hdiv[diff] + k_hsv_round) >> k_hsv_shift;
+        h+= h < 0 ? k_hue_range : 0;
+
+        uint8_t mask= 0;
+        for (int bounds_index = 0; bounds_index < bounds_count; ++bounds_index)
+        {
+            const HSVColorClassifierBounds &bound= bounds[bounds_index];
+
+            if (s >= bound.saturation_min && s <= bound.saturation_max &&
+                v >= bound.value_min && v <= bound.value_max &&
+                ((h >= bound.hue_min[0] && h <= bound.hue_max[0]) || (h >= bound.hue_min[1] && h <= bound.hue_max[1])))
+            {
+                mask|= bound.mask_bits;
+            }
+        }
+
+        *out_mask_row= mask;
+        bgr_row+= 3;
+        ++out_mask_row;
+    }
+}
+
+#if defined(HSV_CLASSIFIER_X86)
+// Per bounds: saturation min/max, value min/max, hue0 min/max, hue1 min/max, mask bits
+static const int k_bounds_vector_count= 9;
+
+// Splits 16 packed BGR pixels into 16 blue, 16 green and 16 red bytes
+HSV_CLASSIFIER_TARGET("sse4.1")
+static inline void deinterleave_bgr_sse41(
+    const uint8_t *bgr, __m128i &out_b, __m128i &out_g, __m128i &out_r)
+{
+    const __m128i a0= _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgr));
+    const __m128i a1= _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgr + 16));
+    const __m128i a2= _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgr + 32));
+
+    out_b= _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+    out_g= _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+    out_r= _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+// Classifies 4 pixels whose channels are in the low 4 bytes of the given vectors
+HSV_CLASSIFIER_TARGET("sse4.1")
+static inline __m128i classify_4_pixels_sse41(
+    const HSVDivisionTables &tables,
+    const __m128i &b8, const __m128i &g8, const __m128i &r8, const __m128i &v8, const __m128i &diff8,
+    const uint8_t *v_bytes, const uint8_t *diff_bytes,
+    const __m128i *bounds_vectors, int bounds_count)
+{
+    const __m128i zero= _mm_setzero_si128();
+    const __m128i round= _mm_set1_epi32(k_hsv_round);
+
+    const __m128i b= _mm_cvtepu8_epi32(b8);
+    const __m128i g= _mm_cvtepu8_epi32(g8);
+    const __m128i r= _mm_cvtepu8_epi32(r8);
+    const __m128i v= _mm_cvtepu8_epi32(v8);
+    const __m128i diff= _mm_cvtepu8_epi32(diff8);
+    const __m128i vr= _mm_cmpeq_epi32(v, r);
+    const __m128i vg= _mm_cmpeq_epi32(v, g);
+
+    // No gather in SSE, so the reciprocals are looked up one lane at a time
+    const __m128i sdiv= _mm_setr_epi32(
+        tables.sdiv[v_bytes[0]], tables.sdiv[v_bytes[1]], tables.sdiv[v_bytes[2]], tables.sdiv[v_bytes[3]]);
+    const __m128i hdiv= _mm_setr_epi32(
+        tables.hdiv[diff_bytes[0]], tables.hdiv[diff_bytes[1]], tables.hdiv[diff_bytes[2]], tables.hdiv[diff_bytes[3]]);
+
+    const __m128i s= _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(diff, sdiv), round), k_hsv_shift);
+
+    const __m128i h_when_vr= _mm_sub_epi32(g, b);
+    const __m128i h_when_vg= _mm_add_epi32(_mm_sub_epi32(b, r), _mm_slli_epi32(diff, 1));
+    const __m128i h_otherwise= _mm_add_epi32(_mm_sub_epi32(r, g), _mm_slli_epi32(diff, 2));
+    __m128i h= _mm_blendv_epi8(_mm_blendv_epi8(h_otherwise, h_when_vg, vg), h_when_vr, vr);
+    h= _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(h, hdiv), round), k_hsv_shift);
+    h= _mm_add_epi32(h, _mm_and_si128(_mm_cmplt_epi32(h, zero), _mm_set1_epi32(k_hue_range)));
+
+    __m128i mask= zero;
+    for (int bounds_index = 0; bounds_index < bounds_count; ++bounds_index)
+    {
+        const __m128i *bv= bounds_vectors + bounds_index*k_bounds_vector_count;
+        const __m128i outside_sv= _mm_or_si128(
+            _mm_or_si128(_mm_cmpgt_epi32(bv[0], s), _mm_cmpgt_epi32(s, bv[1])),
+            _mm_or_si128(_mm_cmpgt_epi32(bv[2], v), _mm_cmpgt_epi32(v, bv[3])));
+        const __m128i outside_h= _mm_and_si128(
+            _mm_or_si128(_mm_cmpgt_epi32(bv[4], h), _mm_cmpgt_epi32(h, bv[5])),
+            _mm_or_si128(_mm_cmpgt_epi32(bv[6], h), _mm_cmpgt_epi32(h, bv[7])));
+
+        mask= _mm_or_si128(mask, _mm_andnot_si128(_mm_or_si128(outside_sv, outside_h), bv[8]));
+    }
+
+    return mask;
+}
+
+HSV_CLASSIFIER_TARGET("sse4.1")
+static int classify_bgr_row_sse41(
+    const HSVDivisionTables &tables,
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count)
+{
+    __m128i bounds_vectors[HSV_COLOR_CLASSIFIER_MAX_BOUNDS*k_bounds_vector_count];
+    for (int bounds_index = 0; bounds_index < bounds_count; ++bounds_index)
+    {
+        const HSVColorClassifierBounds &bound= bounds[bounds_index];
+        __m128i *bv= bounds_vectors + bounds_index*k_bounds_vector_count;
+
+        bv[0]= _mm_set1_epi32(bound.saturation_min);
+        bv[1]= _mm_set1_epi32(bound.saturation_max);
+        bv[2]= _mm_set1_epi32(bound.value_min);
+        bv[3]= _mm_set1_epi32(bound.value_max);
+        bv[4]= _mm_set1_epi32(bound.hue_min[0]);
+        bv[5]= _mm_set1_epi32(bound.hue_max[0]);
+        bv[6]= _mm_set1_epi32(bound.hue_min[1]);
+        bv[7]= _mm_set1_epi32(bound.hue_max[1]);
+        bv[8]= _mm_set1_epi32(bound.mask_bits);
+    }
+
+    int pixel_index= 0;
+    for (; pixel_index + k_simd_block_size <= pixel_count; pixel_index+= k_simd_block_size)
+    {
+        __m128i b8, g8, r8;
+        deinterleave_bgr_sse41(bgr_row + pixel_index*3, b8, g8, r8);
+
+        const __m128i v8= _mm_max_epu8(b8, _mm_max_epu8(g8, r8));
+        const __m128i diff8= _mm_sub_epi8(v8, _mm_min_epu8(b8, _mm_min_epu8(g8, r8)));
+
+        uint8_t v_bytes[k_simd_block_size];
+        uint8_t diff_bytes[k_simd_block_size];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(v_bytes), v8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(diff_bytes), diff8);
+
+        const __m128i mask0= classify_4_pixels_sse41(
+            tables, b8, g8, r8, v8, diff8,
+            v_bytes, diff_bytes, bounds_vectors, bounds_count);
+        const __m128i mask1= classify_4_pixels_sse41(
+            tables,
+            _mm_srli_si128(b8, 4), _mm_srli_si128(g8, 4), _mm_srli_si128(r8, 4), _mm_srli_si128(v8, 4), _mm_srli_si128(diff8, 4),
+            v_bytes + 4, diff_bytes + 4, bounds_vectors, bounds_count);
+        const __m128i mask2= classify_4_pixels_sse41(
+            tables,
+            _mm_srli_si128(b8, 8), _mm_srli_si128(g8, 8), _mm_srli_si128(r8, 8), _mm_srli_si128(v8, 8), _mm_srli_si128(diff8, 8),
+            v_bytes + 8, diff_bytes + 8, bounds_vectors, bounds_count);
+        const __m128i mask3= classify_4_pixels_sse41(
+            tables,
+            _mm_srli_si128(b8, 12), _mm_srli_si128(g8, 12), _mm_srli_si128(r8, 12), _mm_srli_si128(v8, 12), _mm_srli_si128(diff8, 12),
+            v_bytes + 12, diff_bytes + 12, bounds_vectors, bounds_count);
+
+        const __m128i mask= _mm_packus_epi16(_mm_packus_epi32(mask0, mask1), _mm_packus_epi32(mask2, mask3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out_mask_row + pixel_index), mask);
+    }
+
+    return pixel_index;
+}
+
+// Classifies 8 pixels whose channels are in the low 8 bytes of the given vectors
+HSV_CLASSIFIER_TARGET("avx2")
+static inline __m256i classify_8_pixels_avx2(
+    const HSVDivisionTables &tables,
+    const __m128i &b8, const __m128i &g8, const __m128i &r8, const __m128i &v8, const __m128i &diff8,
+    const __m256i *bounds_vectors, int bounds_count)
+{
+    const __m256i zero= _mm256_setzero_si256();
+    const __m256i round= _mm256_set1_epi32(k_hsv_round);
+
+    const __m256i b= _mm256_cvtepu8_epi32(b8);
+    const __m256i g= _mm256_cvtepu8_epi32(g8);
+    const __m256i r= _mm256_cvtepu8_epi32(r8);
+    const __m256i v= _mm256_cvtepu8_epi32(v8);
+    const __m256i diff= _mm256_cvtepu8_epi32(diff8);
+    const __m256i vr= _mm256_cmpeq_epi32(v, r);
+    const __m256i vg= _mm256_cmpeq_epi32(v, g);
+
+    const __m256i sdiv= _mm256_i32gather_epi32(reinterpret_cast<const int *>(tables.sdiv), v, 4);
+    const __m256i hdiv= _mm256_i32gather_epi32(reinterpret_cast<const int *>(tables.hdiv), diff, 4);
+
+    const __m256i s= _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(diff, sdiv), round), k_hsv_shift);
+
+    const __m256i h_when_vr= _mm256_sub_epi32(g, b);
+    const __m256i h_when_vg= _mm256_add_epi32(_mm256_sub_epi32(b, r), _mm256_slli_epi32(diff, 1));
+    const __m256i h_otherwise= _mm256_add_epi32(_mm256_sub_epi32(r, g), _mm256_slli_epi32(diff, 2));
+    __m256i h= _mm256_blendv_epi8(_mm256_blendv_epi8(h_otherwise, h_when_vg, vg), h_when_vr, vr);
+    h= _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(h, hdiv), round), k_hsv_shift);
+    h= _mm256_add_epi32(h, _mm256_and_si256(_mm256_cmpgt_epi32(zero, h), _mm256_set1_epi32(k_hue_range)));
+
+    __m256i mask= zero;
+    for (int bounds_index = 0; bounds_index < bounds_count; ++bounds_index)
+    {
+        const __m256i *bv= bounds_vectors + bounds_index*k_bounds_vector_count;
+        const __m256i outside_sv= _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi32(bv[0], s), _mm256_cmpgt_epi32(s, bv[1])),
+            _mm256_or_si256(_mm256_cmpgt_epi32(bv[2], v), _mm256_cmpgt_epi32(v, bv[3])));
+        const __m256i outside_h= _mm256_and_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi32(bv[4], h), _mm256_cmpgt_epi32(h, bv[5])),
+            _mm256_or_si256(_mm256_cmpgt_epi32(bv[6], h), _mm256_cmpgt_epi32(h, bv[7])));
+
+        mask= _mm256_or_si256(mask, _mm256_andnot_si256(_mm256_or_si256(outside_sv, outside_h), bv[8]));
+    }
+
+    return mask;
+}
+
+HSV_CLASSIFIER_TARGET("avx2")
+static int classify_bgr_row_avx2(
+    const HSVDivisionTables &tables,
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count)
+{
+    __m256i bounds_vectors[HSV_COLOR_CLASSIFIER_MAX_BOUNDS*k_bounds_vector_count];
+    for (int bounds_index = 0; bounds_index < bounds_count; ++bounds_index)
+    {
+        const HSVColorClassifierBounds &bound= bounds[bounds_index];
+        __m256i *bv= bounds_vectors + bounds_index*k_bounds_vector_count;
+
+        bv[0]= _mm256_set1_epi32(bound.saturation_min);
+        bv[1]= _mm256_set1_epi32(bound.saturation_max);
+        bv[2]= _mm256_set1_epi32(bound.value_min);
+        bv[3]= _mm256_set1_epi32(bound.value_max);
+        bv[4]= _mm256_set1_epi32(bound.hue_min[0]);
+        bv[5]= _mm256_set1_epi32(bound.hue_max[0]);
+        bv[6]= _mm256_set1_epi32(bound.hue_min[1]);
+        bv[7]= _mm256_set1_epi32(bound.hue_max[1]);
+        bv[8]= _mm256_set1_epi32(bound.mask_bits);
+    }
+
+    int pixel_index= 0;
+    for (; pixel_index + k_simd_block_size <= pixel_count; pixel_index+= k_simd_block_size)
+    {
+        __m128i b8, g8, r8;
+        deinterleave_bgr_sse41(bgr_row + pixel_index*3, b8, g8, r8);
+
+        const __m128i v8= _mm_max_epu8(b8, _mm_max_epu8(g8, r8));
+        const __m128i diff8= _mm_sub_epi8(v8, _mm_min_epu8(b8, _mm_min_epu8(g8, r8)));
+
+        const __m256i mask_lo= classify_8_pixels_avx2(
+            tables, b8, g8, r8, v8, diff8, bounds_vectors, bounds_count);
+        const __m256i mask_hi= classify_8_pixels_avx2(
+            tables,
+            _mm_srli_si128(b8, 8), _mm_srli_si128(g8, 8), _mm_srli_si128(r8, 8), _mm_srli_si128(v8, 8), _mm_srli_si128(diff8, 8),
+            bounds_vectors, bounds_count);
+
+        // Pack within 128-bit halves to keep the pixels in order
+        const __m128i mask_lo16= _mm_packus_epi32(_mm256_castsi256_si128(mask_lo), _mm256_extracti128_si256(mask_lo, 1));
+        const __m128i mask_hi16= _mm_packus_epi32(_mm256_castsi256_si128(mask_hi), _mm256_extracti128_si256(mask_hi, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out_mask_row + pixel_index), _mm_packus_epi16(mask_lo16, mask_hi16));
+    }
+
+    return pixel_index;
+}
+#elif defined(HSV_CLASSIFIER_NEON)
+// Per bounds: saturation min/max, value min/max, hue0 min/max, hue1 min/max, mask bits
+static const int k_bounds_vector_count= 9;
+
+// Widens bytes [4*group, 4*group+3] of the given vector to 32-bit lanes
+static inline int32x4_t widen_u8_group_neon(const uint8x16_t x, const int group)
+{
+    const uint16x8_t x16= (group < 2) ? vmovl_u8(vget_low_u8(x)) : vmovl_u8(vget_high_u8(x));
+    const uint16x4_t x16_half= (group & 1) ? vget_high_u16(x16) : vget_low_u16(x16);
+
+    return vreinterpretq_s32_u32(vmovl_u16(x16_half));
+}
+
+static inline uint32x4_t classify_4_pixels_neon(
+    const HSVDivisionTables &tables,
+    const uint8x16x3_t &bgr8, const uint8x16_t v8, const uint8x16_t diff8, const int group,
+    const uint8_t *v_bytes, const uint8_t *diff_bytes,
+    const int32x4_t *bounds_vectors, int bounds_count)
+{
+    const int32x4_t zero= vdupq_n_s32(0);
+    const int32x4_t round= vdupq_n_s32(k_hsv_round);
+
+    const int32x4_t b= widen_u8_group_neon(bgr8.val[0], group);
+    const int32x4_t g= widen_u8_group_neon(bgr8.val[1], group);
+    const int32x4_t r= widen_u8_group_neon(bgr8.val[2], group);
+    const int32x4_t v= widen_u8_group_neon(v8, group);
+    const int32x4_t diff= widen_u8_group_neon(diff8, group);
+    const uint32x4_t vr= vceqq_s32(v, r);
+    const uint32x4_t vg= vceqq_s32(v, g);
+
+    // No gather in NEON, so the reciprocals are looked up one lane at a time
+    const int32_t sdiv_lanes[4]= {
+        tables.sdiv[v_bytes[0]], tables.sdiv[v_bytes[1]], tables.sdiv[v_bytes[2]], tables.sdiv[v_bytes[3]]};
+    const int32_t hdiv_lanes[4]= {
+        tables.hdiv[diff_bytes[0]], tables.hdiv[diff_bytes[1]], tables.hdiv[diff_bytes[2]], tables.hdiv[diff_bytes[3]]};
+    const int32x4_t sdiv= vld1q_s32(sdiv_lanes);
+    const int32x4_t hdiv= vld1q_s32(hdiv_lanes);
+
+    const int32x4_t s= vshrq_n_s32(vaddq_s32(vmulq_s32(diff, sdiv), round), k_hsv_shift);
+
+    const int32x4_t h_when_vr= vsubq_s32(g, b);
+    const int32x4_t h_when_vg= vaddq_s32(vsubq_s32(b, r), vshlq_n_s32(diff, 1));
+    const int32x4_t h_otherwise= vaddq_s32(vsubq_s32(r, g), vshlq_n_s32(diff, 2));
+    int32x4_t h= vbslq_s32(vr, h_when_vr, vbslq_s32(vg, h_when_vg, h_otherwise));
+    h= vshrq_n_s32(vaddq_s32(vmulq_s32(h, hdiv), round), k_hsv_shift);
+    h= vaddq_s32(h, vandq_s32(vreinterpretq_s32_u32(vcltq_s32(h, zero)), vdupq_n_s32(k_hue_range)));
+
+    uint32x4_t mask= vdupq_n_u32(0);
+    for (int bounds_index = 0; bounds_index < bounds_count; ++bounds_index)
+    {
+        const int32x4_t *bv= bounds_vectors + bounds_index*k_bounds_vector_count;
+        const uint32x4_t outside_sv= vorrq_u32(
+            vorrq_u32(vcgtq_s32(bv[0], s), vcgtq_s32(s, bv[1])),
+            vorrq_u32(vcgtq_s32(bv[2], v), vcgtq_s32(v, bv[3])));
+        const uint32x4_t outside_h= vandq_u32(
+            vorrq_u32(vcgtq_s32(bv[4], h), vcgtq_s32(h, bv[5])),
+            vorrq_u32(vcgtq_s32(bv[6], h), vcgtq_s32(h, bv[7])));
+
+        mask= vorrq_u32(mask, vbicq_u32(vreinterpretq_u32_s32(bv[8]), vorrq_u32(outside_sv, outside_h)));
+    }
+
+    return mask;
+}
+
+static int classify_bgr_row_neon(
+    const HSVDivisionTables &tables,
+    const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+    const HSVColorClassifierBounds *bounds, int bounds_count)
+{
+    int32x4_t bounds_vectors[HSV_COLOR_CLASSIFIER_MAX_BOUNDS*k_bounds_vector_count];
+    for (int bounds_index = 0; bounds_index < bounds_count; ++bounds_index)
+    {
+        const HSVColorClassifierBounds &bound= bounds[bounds_index];
+        int32x4_t *bv= bounds_vectors + bounds_index*k_bounds_vector_count;
+
+        bv[0]= vdupq_n_s32(bound.saturation_min);
+        bv[1]= vdupq_n_s32(bound.saturation_max);
+        bv[2]= vdupq_n_s32(bound.value_min);
+        bv[3]= vdupq_n_s32(bound.value_max);
+        bv[4]= vdupq_n_s32(bound.hue_min[0]);
+        bv[5]= vdupq_n_s32(bound.hue_max[0]);
+        bv[6]= vdupq_n_s32(bound.hue_min[1]);
+        bv[7]= vdupq_n_s32(bound.hue_max[1]);
+        bv[8]= vdupq_n_s32(bound.mask_bits);
+    }
+
+    int pixel_index= 0;
+    for (; pixel_index + k_simd_block_size <= pixel_count; pixel_index+= k_simd_block_size)
+    {
+        // vld3 splits the packed pixels into blue, green and red for free
+        const uint8x16x3_t bgr8= vld3q_u8(bgr_row + pixel_index*3);
+        const uint8x16_t v8= vmaxq_u8(bgr8.val[0], vmaxq_u8(bgr8.val[1], bgr8.val[2]));
+        const uint8x16_t diff8= vsubq_u8(v8, vminq_u8(bgr8.val[0], vminq_u8(bgr8.val[1], bgr8.val[2])));
+
+        uint8_t v_bytes[k_simd_block_size];
+        uint8_t diff_bytes[k_simd_block_size];
+        vst1q_u8(v_bytes, v8);
+        vst1q_u8(diff_bytes, diff8);
+
+        uint16x4_t mask16[4];
+        for (int group = 0; group < 4; ++group)
+        {
+            const uint32x4_t mask32= classify_4_pixels_neon(
+                tables, bgr8, v8, diff8, group,
+                v_bytes + 4*group, diff_bytes + 4*group, bounds_vectors, bounds_count);
+
+            mask16[group]= vmovn_u32(mask32);
+        }
+
+        const uint8x8_t mask_lo= vmovn_u16(vcombine_u16(mask16[0], mask16[1]));
+        const uint8x8_t mask_hi= vmovn_u16(vcombine_u16(mask16[2], mask16[3]));
+        vst1q_u8(out_mask_row + pixel_index, vcombine_u8(mask_lo, mask_hi));
+    }
+
+    return pixel_index;
+}
+#endif
@@ -0,0 +1,65 @@
+#ifndef HSV_COLOR_CLASSIFIER_H
+#define HSV_COLOR_CLASSIFIER_H
+
+//-- includes -----
+#include <stdint.h>
+
+//-- constants -----
+// Max number of color ranges that can be tested in a single pass (one per mask bit)
+#define HSV_COLOR_CLASSIFIER_MAX_BOUNDS 8
+
+//-- definitions -----
+// Integer HSV bounds in OpenCV's 8-bit HSV space (hue in [0, 180], saturation and value in [0, 255]).
+// The hue angle can wrap around, so it's tested against two ranges.
+// An unused hue range has hue_min > hue_max.
+struct HSVColorClassifierBounds
+{
+    uint8_t hue_min[2];
+    uint8_t hue_max[2];
+    uint8_t saturation_min;
+    uint8_t saturation_max;
+    uint8_t value_min;
+    uint8_t value_max;
+
+    // The bits OR'd into the mask for every pixel inside the bounds
+    uint8_t mask_bits;
+};
+
+// Converts packed 8-bit BGR pixels to HSV and tests them against a set of HSV bounds in one pass.
+// The HSV conversion is bit exact with cv::cvtColor(..., cv::COLOR_BGR2HSV) on 8-bit images,
+// so the resulting mask matches cvtColor followed by cv::inRange.
+namespace HSVColorClassifier
+{
+    enum eInstructionSet
+    {
+        Scalar,
+        SSE41,
+        AVX2,
+        NEON,
+
+        MAX_INSTRUCTION_SETS
+    };
+
+    /// The fastest instruction set supported by the CPU we are running on
+    eInstructionSet get_instruction_set();
+    const char *get_instruction_set_name(eInstructionSet instruction_set);
+
+    /// Classifies a row of BGR pixels against the given bounds
+    /// \param bgr_row The source pixels, 3 bytes per pixel in BGR order
+    /// \param out_mask_row One byte per pixel: the OR of the mask_bits of every bounds the pixel falls in
+    /// \param pixel_count The number of pixels in the row
+    /// \param bounds The bounds to test each pixel against
+    /// \param bounds_count The number of bounds, at most HSV_COLOR_CLASSIFIER_MAX_BOUNDS
+    void classify_bgr_row(
+        const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+        const HSVColorClassifierBounds *bounds, int bounds_count);
+
+    /// Same as classify_bgr_row() but forces a specific instruction set.
+    /// Falls back to the scalar code if the instruction set isn't supported.
+    void classify_bgr_row_with_instruction_set(
+        eInstructionSet instruction_set,
+        const uint8_t *bgr_row, uint8_t *out_mask_row, int pixel_count,
+        const HSVColorClassifierBounds *bounds, int bounds_count);
+};
+
+#endif // HSV_COLOR_CLASSIFIER_H
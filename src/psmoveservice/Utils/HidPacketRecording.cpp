@@ -0,0 +1,272 @@
+//-- includes -----
+#include "HidPacketRecording.h"
+#include "ServerLog.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <string.h>
+#include <thread>
+
+//-- constants -----
+static const char k_recording_magic[8]= {'P', 'S', 'M', 'H', 'I', 'D', '\0', '\0'};
+static const uint32_t k_recording_version= 1;
+static const RecordingFileFormat k_recording_format(k_recording_magic, k_recording_version, "HID");
+static const size_t k_record_header_size= sizeof(uint32_t) + sizeof(uint16_t);
+
+//-- HidPacketRecordingWriter -----
+HidPacketRecordingWriter::HidPacketRecordingWriter()
+    : m_file()
+    , m_path()
+    , m_lastPacketTime()
+    , m_packetCount(0)
+{
+}
+
+HidPacketRecordingWriter::~HidPacketRecordingWriter()
+{
+    close();
+}
+
+std::string HidPacketRecordingWriter::makeRecordingPath(const std::string &folder, const std::string &device_name)
+{
+    boost::filesystem::path recording_path(folder);
+    boost::system::error_code error;
+
+    boost::filesystem::create_directories(recording_path, error);
+    recording_path /= device_name + HID_PACKET_RECORDING_FILE_EXTENSION;
+
+    return recording_path.string();
+}
+
+bool HidPacketRecordingWriter::open(
+    const std::string &path,
+    int device_type,
+    int product_id,
+    const std::string &device_config_json)
+{
+    close();
+
+    m_file.open(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open())
+    {
+        SERVER_LOG_ERROR("HidPacketRecordingWriter::open") << "Failed to create HID recording: " << path;
+        return false;
+    }
+
+    HidPacketRecordingFileHeader header;
+    k_recording_format.initHeader(header, device_config_json);
+    header.device_type= static_cast<uint32_t>(device_type);
+    header.product_id= product_id;
+
+    const bool bWroteHeader= k_recording_format.writeHeader(m_file, header, device_config_json);
+
+    m_path= path;
+    m_packetCount= 0;
+
+    SERVER_LOG_INFO("HidPacketRecordingWriter::open") << "Recording HID packets to: " << path;
+
+    return bWroteHeader;
+}
+
+bool HidPacketRecordingWriter::getIsOpen() const
+{
+    return m_file.is_open();
+}
+
+bool HidPacketRecordingWriter::writePacket(const unsigned char *packet, size_t packet_size)
+{
+    if (!m_file.is_open() || packet_size > 0xffff)
+    {
+        return false;
+    }
+
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+    const int64_t delta_us=
+        (m_packetCount > 0)
+        ? std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastPacketTime).count()
+        : 0;
+    const uint32_t record_delta_us= static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(delta_us, 0), 0xffffffff));
+    const uint16_t record_size= static_cast<uint16_t>(packet_size);
+
+    // The file stream buffers the writes, so this doesn't stall the HID read loop
+    m_file.write(reinterpret_cast<const char *>(&record_delta_us), sizeof(record_delta_us));
+    m_file.write(reinterpret_cast<const char *>(&record_size), sizeof(record_size));
+    m_file.write(reinterpret_cast<const char *>(packet), packet_size);
+
+    if (!m_file.good())
+    {
+        SERVER_MT_LOG_ERROR("HidPacketRecordingWriter::writePacket") << "Failed to write HID recording: " << m_path << ", stopping recording.";
+        m_file.close();
+        return false;
+    }
+
+    m_lastPacketTime= now;
+    ++m_packetCount;
+
+    return true;
+}
+
+void HidPacketRecordingWriter::close()
+{
+    if (m_file.is_open())
+    {
+        m_file.close();
+
+        SERVER_MT_LOG_INFO("HidPacketRecordingWriter::close") << "Recorded " << m_packetCount << " HID packets to: " << m_path;
+    }
+}
+
+//-- HidPacketRecordingReader -----
+HidPacketRecordingReader::HidPacketRecordingReader()
+    : m_path()
+    , m_deviceConfigJson()
+    , m_packetData()
+    , m_packetOffsets()
+    , m_packetSizes()
+    , m_packetTimestamps()
+    , m_replaySpeed(1.f)
+    , m_bLoop(false)
+    , m_bIsOpen(false)
+    , m_nextPacketIndex(0)
+    , m_loopTimeOffsetUs(0)
+    , m_passStartTime()
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+bool HidPacketRecordingReader::open(const std::string &path)
+{
+    close();
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!k_recording_format.readHeader(file, path, m_header, m_deviceConfigJson))
+    {
+        return false;
+    }
+
+    // Read the whole recording up front, a partial record at the end (from a crash) is dropped
+    int64_t timestamp_us= 0;
+    for (;;)
+    {
+        uint32_t record_delta_us;
+        uint16_t record_size;
+
+        if (!file.read(reinterpret_cast<char *>(&record_delta_us), sizeof(record_delta_us)) ||
+            !file.read(reinterpret_cast<char *>(&record_size), sizeof(record_size)))
+        {
+            break;
+        }
+
+        const size_t offset= m_packetData.size();
+        m_packetData.resize(offset + record_size);
+        if (record_size > 0 && !file.read(reinterpret_cast<char *>(&m_packetData[offset]), record_size))
+        {
+            m_packetData.resize(offset);
+            break;
+        }
+
+        timestamp_us+= record_delta_us;
+        m_packetOffsets.push_back(offset);
+        m_packetSizes.push_back(record_size);
+        m_packetTimestamps.push_back(timestamp_us);
+    }
+
+    m_path= path;
+    m_bIsOpen= true;
+
+    return true;
+}
+
+bool HidPacketRecordingReader::getIsOpen() const
+{
+    return m_bIsOpen;
+}
+
+void HidPacketRecordingReader::close()
+{
+    m_bIsOpen= false;
+    m_deviceConfigJson.clear();
+    m_packetData.clear();
+    m_packetOffsets.clear();
+    m_packetSizes.clear();
+    m_packetTimestamps.clear();
+}
+
+void HidPacketRecordingReader::startReplay(float replay_speed, bool bLoop)
+{
+    m_replaySpeed= std::max(replay_speed, 0.f);
+    m_bLoop= bLoop;
+    m_nextPacketIndex= 0;
+    m_loopTimeOffsetUs= 0;
+    m_passStartTime= std::chrono::high_resolution_clock::now();
+}
+
+bool HidPacketRecordingReader::waitForNextPacket(
+    int timeout_ms,
+    const unsigned char *&out_packet,
+    size_t &out_packet_size,
+    int64_t &out_sample_time_us)
+{
+    const size_t packet_count= getPacketCount();
+
+    if (!m_bIsOpen || packet_count == 0)
+    {
+        return false;
+    }
+
+    if (m_nextPacketIndex >= packet_count)
+    {
+        if (!m_bLoop)
+        {
+            // The replay is over, don't spin the caller
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return false;
+        }
+
+        // Keep the sample times increasing, with the average packet interval between passes
+        const int64_t pass_duration_us= m_packetTimestamps.back();
+        const int64_t mean_interval_us= (packet_count > 1) ? pass_duration_us / static_cast<int64_t>(packet_count - 1) : 1000;
+
+        m_loopTimeOffsetUs+= pass_duration_us + mean_interval_us;
+        m_nextPacketIndex= 0;
+        m_passStartTime= std::chrono::high_resolution_clock::now();
+    }
+
+    const int64_t timestamp_us= m_packetTimestamps[m_nextPacketIndex];
+
+    if (m_replaySpeed > 0.f)
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> due_time=
+            m_passStartTime +
+            std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+                std::chrono::duration<double, std::micro>(static_cast<double>(timestamp_us) / m_replaySpeed));
+        const std::chrono::time_point<std::chrono::high_resolution_clock> timeout_time=
+            std::chrono::high_resolution_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+        if (due_time > timeout_time)
+        {
+            std::this_thread::sleep_until(timeout_time);
+            return false;
+        }
+
+        std::this_thread::sleep_until(due_time);
+    }
+
+    out_packet= getPacket(m_nextPacketIndex);
+    out_packet_size= m_packetSizes[m_nextPacketIndex];
+    out_sample_time_us= m_loopTimeOffsetUs + timestamp_us;
+    ++m_nextPacketIndex;
+
+    if (m_nextPacketIndex == packet_count)
+    {
+        const double pass_seconds=
+            std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - m_passStartTime).count();
+
+        // The replay throughput, i.e. the pipeline benchmark when replaying as fast as possible
+        SERVER_MT_LOG_INFO("HidPacketRecordingReader") << "Replayed " << packet_count << " HID packets of " << m_path
+            << " in " << pass_seconds << "s (" << ((pass_seconds > 0.0) ? packet_count / pass_seconds : 0.0) << " packets/s)";
+    }
+
+    return true;
+}
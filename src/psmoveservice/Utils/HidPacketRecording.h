@@ -0,0 +1,110 @@
+#ifndef HID_PACKET_RECORDING_H
+#define HID_PACKET_RECORDING_H
+
+//-- includes -----
+#include "RecordingFile.h"
+
+#include <chrono>
+#include <fstream>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//-- constants -----
+#define HID_PACKET_RECORDING_FILE_EXTENSION ".psmhid"
+
+//-- definitions -----
+// A recording is a header, the json config of the device that was recorded,
+// and then one record per HID input report: the time since the previous report
+// in microseconds (uint32), the report size (uint16) and the report bytes.
+struct HidPacketRecordingFileHeader
+{
+    RecordingFileTag tag;
+    uint32_t device_type; // CommonDeviceState::eDeviceType
+    int32_t product_id; // tells apart device models that use different report layouts
+    uint32_t config_size; // size of the json config that follows the header
+    uint8_t reserved[8];
+};
+
+/// Logs raw HID input reports with high resolution timestamps.
+/// Only the thread reading the HID device should write packets.
+class HidPacketRecordingWriter
+{
+public:
+    HidPacketRecordingWriter();
+    virtual ~HidPacketRecordingWriter();
+
+    /// Creates the recording folder if needed and returns "<folder>/<device_name>.psmhid"
+    static std::string makeRecordingPath(const std::string &folder, const std::string &device_name);
+
+    bool open(const std::string &path, int device_type, int product_id, const std::string &device_config_json);
+    bool getIsOpen() const;
+    bool writePacket(const unsigned char *packet, size_t packet_size);
+    void close();
+
+    inline uint32_t getPacketCount() const
+    { return m_packetCount; }
+
+private:
+    std::ofstream m_file;
+    std::string m_path;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_lastPacketTime;
+    uint32_t m_packetCount;
+};
+
+/// Loads a HID packet recording into memory and hands the reports back out at the recorded timing
+/// (optionally sped up), so that replays don't depend on disk speed.
+class HidPacketRecordingReader
+{
+public:
+    HidPacketRecordingReader();
+
+    bool open(const std::string &path);
+    bool getIsOpen() const;
+    void close();
+
+    /// Rewinds to the first packet and sets the pace for waitForNextPacket()
+    /// \param replay_speed Multiple of the recorded speed, 0 means as fast as possible
+    /// \param bLoop Start over after the last packet rather than ending the replay
+    void startReplay(float replay_speed, bool bLoop);
+
+    /// Blocks until the next packet is due. Returns false on a timeout or once the replay has ended.
+    /// \param out_sample_time_us When the packet was recorded, relative to the start of the replay.
+    ///        Keeps increasing when the replay loops.
+    bool waitForNextPacket(
+        int timeout_ms,
+        const unsigned char *&out_packet, size_t &out_packet_size, int64_t &out_sample_time_us);
+
+    inline const HidPacketRecordingFileHeader &getHeader() const
+    { return m_header; }
+    inline const std::string &getDeviceConfigJson() const
+    { return m_deviceConfigJson; }
+    inline size_t getPacketCount() const
+    { return m_packetOffsets.size(); }
+    inline const unsigned char *getPacket(size_t packet_index) const
+    { return m_packetData.data() + m_packetOffsets[packet_index]; }
+    inline size_t getPacketSize(size_t packet_index) const
+    { return m_packetSizes[packet_index]; }
+    inline int64_t getPacketTimestamp(size_t packet_index) const
+    { return m_packetTimestamps[packet_index]; }
+
+private:
+    std::string m_path;
+    HidPacketRecordingFileHeader m_header;
+    std::string m_deviceConfigJson;
+    std::vector<unsigned char> m_packetData;
+    std::vector<size_t> m_packetOffsets;
+    std::vector<uint16_t> m_packetSizes;
+    std::vector<int64_t> m_packetTimestamps; // relative to the first packet
+
+    // Replay state
+    float m_replaySpeed;
+    bool m_bLoop;
+    bool m_bIsOpen;
+    size_t m_nextPacketIndex;
+    int64_t m_loopTimeOffsetUs;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_passStartTime;
+};
+
+#endif // HID_PACKET_RECORDING_H
@@ -0,0 +1,41 @@
+//-- includes -----
+#include "MainLoopWakeSignal.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+//-- statics -----
+static std::mutex g_wake_mutex;
+static std::condition_variable g_wake_condition;
+static std::atomic_bool g_bIsWakePending(false);
+
+//-- public methods -----
+void MainLoopWakeSignal::notify()
+{
+    // Already pending means the main loop hasn't consumed the last notification yet,
+    // so there's no one to wake. Keeps the per-packet cost of the HID threads to one atomic op.
+    if (!g_bIsWakePending.exchange(true))
+    {
+        // Taking the lock orders the flag against a main loop that is just about to wait
+        {
+            std::lock_guard<std::mutex> lock(g_wake_mutex);
+        }
+        g_wake_condition.notify_one();
+    }
+}
+
+bool MainLoopWakeSignal::waitUntil(const std::chrono::time_point<std::chrono::high_resolution_clock> &deadline)
+{
+    std::unique_lock<std::mutex> lock(g_wake_mutex);
+
+    const bool bWasNotified= g_wake_condition.wait_until(lock, deadline, [] {
+        return g_bIsWakePending.load();
+    });
+
+    // Whatever got signalled is handled by the update that follows this wait,
+    // including a notification that slipped in after a timeout
+    g_bIsWakePending.store(false);
+
+    return bWasNotified;
+}
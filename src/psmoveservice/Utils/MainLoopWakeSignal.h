@@ -0,0 +1,23 @@
+#ifndef MAIN_LOOP_WAKE_SIGNAL_H
+#define MAIN_LOOP_WAKE_SIGNAL_H
+
+//-- includes -----
+#include <chrono>
+
+//-- definitions -----
+/// Wakes the service main loop when another thread has handed it work
+/// (a new HID report, a processed tracker frame, a USB transfer result, a network event).
+/// Notifications that arrive while the main loop is busy aren't lost:
+/// the next wait returns straight away.
+class MainLoopWakeSignal
+{
+public:
+    /// Lets the main loop know there is work waiting. Safe to call from any thread.
+    static void notify();
+
+    /// Blocks the main thread until notify() gets called or the deadline passes.
+    /// Returns true if woken by a notification.
+    static bool waitUntil(const std::chrono::time_point<std::chrono::high_resolution_clock> &deadline);
+};
+
+#endif // MAIN_LOOP_WAKE_SIGNAL_H
@@ -0,0 +1,165 @@
+//-- includes -----
+#include "PipelineLatency.h"
+
+#include <algorithm>
+#include <chrono>
+
+//-- constants -----
+static const char *k_stage_names[PipelineLatencyStage_COUNT]= {
+    "frame_capture_to_segmentation",
+    "segmentation_to_triangulation",
+    "triangulation_to_filter",
+    "sensor_capture_to_filter",
+    "filter_to_serialized",
+    "serialized_to_sent",
+    "capture_to_sent",
+};
+
+//-- statics -----
+LatencyHistogram PipelineLatencyStats::m_stageHistograms[PipelineLatencyStage_COUNT];
+
+//-- LatencyHistogram -----
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(int64_t latency_us)
+{
+    // Clock adjustments between threads can't make a stage take negative time
+    const uint32_t clamped_latency_us=
+        static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(latency_us, 0), 0xffffffff));
+
+    m_buckets[computeBucketIndex(clamped_latency_us)].fetch_add(1, std::memory_order_relaxed);
+    m_sampleCount.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t max_latency_us= m_maxLatencyUs.load(std::memory_order_relaxed);
+    while (clamped_latency_us > max_latency_us &&
+           !m_maxLatencyUs.compare_exchange_weak(max_latency_us, clamped_latency_us, std::memory_order_relaxed))
+    {
+        // max_latency_us was reloaded by the failed exchange
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (int bucket_index= 0; bucket_index < k_bucket_count; ++bucket_index)
+    {
+        m_buckets[bucket_index].store(0, std::memory_order_relaxed);
+    }
+    m_sampleCount.store(0, std::memory_order_relaxed);
+    m_maxLatencyUs.store(0, std::memory_order_relaxed);
+}
+
+LatencyHistogramSummary LatencyHistogram::getSummary() const
+{
+    uint32_t bucket_counts[k_bucket_count];
+    uint64_t total_count= 0;
+
+    // Take the total from the buckets we read, so the percentiles are consistent with them
+    for (int bucket_index= 0; bucket_index < k_bucket_count; ++bucket_index)
+    {
+        bucket_counts[bucket_index]= m_buckets[bucket_index].load(std::memory_order_relaxed);
+        total_count+= bucket_counts[bucket_index];
+    }
+
+    LatencyHistogramSummary summary;
+    summary.sample_count= m_sampleCount.load(std::memory_order_relaxed);
+    summary.max_us= m_maxLatencyUs.load(std::memory_order_relaxed);
+    summary.p50_us= 0;
+    summary.p99_us= 0;
+
+    if (total_count > 0)
+    {
+        const uint64_t p50_rank= std::max<uint64_t>((total_count * 50 + 99) / 100, 1);
+        const uint64_t p99_rank= std::max<uint64_t>((total_count * 99 + 99) / 100, 1);
+        uint64_t running_count= 0;
+        bool bFoundP50= false;
+
+        for (int bucket_index= 0; bucket_index < k_bucket_count; ++bucket_index)
+        {
+            running_count+= bucket_counts[bucket_index];
+
+            if (!bFoundP50 && running_count >= p50_rank)
+            {
+                summary.p50_us= std::min(computeBucketUpperBound(bucket_index), summary.max_us);
+                bFoundP50= true;
+            }
+
+            if (running_count >= p99_rank)
+            {
+                summary.p99_us= std::min(computeBucketUpperBound(bucket_index), summary.max_us);
+                break;
+            }
+        }
+    }
+
+    return summary;
+}
+
+int LatencyHistogram::computeBucketIndex(uint32_t latency_us)
+{
+    if (latency_us < 4)
+    {
+        return static_cast<int>(latency_us);
+    }
+
+    // Power of two bucket, then split into 4 linear sub-buckets using the next two bits
+    int highest_bit= 2;
+    while (highest_bit < 31 && (latency_us >> (highest_bit + 1)) != 0)
+    {
+        ++highest_bit;
+    }
+
+    const int sub_bucket= static_cast<int>((latency_us >> (highest_bit - 2)) & 0x3);
+
+    return 4*(highest_bit - 1) + sub_bucket;
+}
+
+uint32_t LatencyHistogram::computeBucketUpperBound(int bucket_index)
+{
+    if (bucket_index < 4)
+    {
+        return static_cast<uint32_t>(bucket_index);
+    }
+
+    const int highest_bit= bucket_index/4 + 1;
+    const uint64_t sub_bucket= static_cast<uint64_t>(bucket_index % 4);
+    const uint64_t bucket_width= static_cast<uint64_t>(1) << (highest_bit - 2);
+    const uint64_t lower_bound= (4 + sub_bucket) * bucket_width;
+
+    return static_cast<uint32_t>(std::min<uint64_t>(lower_bound + bucket_width - 1, 0xffffffff));
+}
+
+//-- PipelineLatencyStats -----
+int64_t PipelineLatencyStats::getTimestampUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PipelineLatencyStats::recordStageLatency(ePipelineLatencyStage stage, int64_t start_us, int64_t end_us)
+{
+    if (start_us != 0 && end_us != 0)
+    {
+        m_stageHistograms[stage].record(end_us - start_us);
+    }
+}
+
+const LatencyHistogram &PipelineLatencyStats::getStageHistogram(ePipelineLatencyStage stage)
+{
+    return m_stageHistograms[stage];
+}
+
+const char *PipelineLatencyStats::getStageName(ePipelineLatencyStage stage)
+{
+    return k_stage_names[stage];
+}
+
+void PipelineLatencyStats::resetAll()
+{
+    for (int stage_index= 0; stage_index < PipelineLatencyStage_COUNT; ++stage_index)
+    {
+        m_stageHistograms[stage_index].reset();
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef PIPELINE_LATENCY_H
+#define PIPELINE_LATENCY_H
+
+//-- includes -----
+#include <atomic>
+#include <stdint.h>
+
+//-- constants -----
+enum ePipelineLatencyStage
+{
+    PipelineLatencyStage_FrameCaptureToSegmentation,    // video frame grabbed -> tracking colors classified
+    PipelineLatencyStage_SegmentationToTriangulation,   // tracking colors classified -> multicam pose fused
+    PipelineLatencyStage_TriangulationToFilter,         // multicam pose fused -> pose filter updated
+    PipelineLatencyStage_SensorCaptureToFilter,         // HID report received -> pose filter updated
+    PipelineLatencyStage_FilterToSerialized,            // pose filter updated -> data frame packed
+    PipelineLatencyStage_SerializedToSent,              // data frame packed -> UDP send completed
+    PipelineLatencyStage_CaptureToSent,                 // HID report or video frame captured -> UDP send completed
+
+    PipelineLatencyStage_COUNT
+};
+
+//-- definitions -----
+/// When each stage of the pipeline finished with a sample, in PipelineLatencyStats::getTimestampUs() time.
+/// Zero means the sample didn't go through that stage (e.g. IMU samples aren't segmented).
+struct PipelineStageTimes
+{
+    int64_t capture_us;
+    int64_t segmentation_done_us;
+    int64_t triangulation_done_us;
+    int64_t filter_done_us;
+
+    inline void clear()
+    {
+        capture_us= 0;
+        segmentation_done_us= 0;
+        triangulation_done_us= 0;
+        filter_done_us= 0;
+    }
+
+    /// When the filter state was at once the sample is fused: IMU samples as soon as they are captured,
+    /// optical samples as soon as they are triangulated, unless the filter rolls back to fuse them
+    /// at their capture time (see IPoseFilter::getIsFusingAtCaptureTime()).
+    /// The latency histograms measure from the stage times either way.
+    inline int64_t getFilterSampleTimeUs(bool bFusedAtCaptureTime) const
+    {
+        return (triangulation_done_us != 0 && !bFusedAtCaptureTime) ? triangulation_done_us : capture_us;
+    }
+};
+
+struct LatencyHistogramSummary
+{
+    uint32_t sample_count;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+/// A log-linear histogram of latencies in microseconds (4 buckets per power of two, so ~25% resolution).
+/// Any number of threads can record samples concurrently; recording is a couple of relaxed atomic adds.
+class LatencyHistogram
+{
+public:
+    static const int k_bucket_count= 128;
+
+    LatencyHistogram();
+
+    void record(int64_t latency_us);
+    void reset();
+
+    /// Percentiles are the upper bound of the bucket they fall in, clamped to the max seen.
+    /// Samples recorded while the summary is computed may or may not be counted.
+    LatencyHistogramSummary getSummary() const;
+
+private:
+    static int computeBucketIndex(uint32_t latency_us);
+    static uint32_t computeBucketUpperBound(int bucket_index);
+
+    std::atomic<uint32_t> m_buckets[k_bucket_count];
+    std::atomic<uint32_t> m_sampleCount;
+    std::atomic<uint32_t> m_maxLatencyUs;
+};
+
+/// Service wide latency histograms for each stage of the tracking pipeline,
+/// from the HID report or video frame capture to the UDP send of the data frame.
+class PipelineLatencyStats
+{
+public:
+    /// Monotonic time in microseconds that all of the pipeline stage times are measured in
+    static int64_t getTimestampUs();
+
+    /// Records the time between two stage timestamps. Ignored if either stage didn't happen.
+    static void recordStageLatency(ePipelineLatencyStage stage, int64_t start_us, int64_t end_us);
+
+    static const LatencyHistogram &getStageHistogram(ePipelineLatencyStage stage);
+    static const char *getStageName(ePipelineLatencyStage stage);
+    static void resetAll();
+
+private:
+    static LatencyHistogram m_stageHistograms[PipelineLatencyStage_COUNT];
+};
+
+#endif // PIPELINE_LATENCY_H
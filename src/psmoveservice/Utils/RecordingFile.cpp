@@ -0,0 +1,71 @@
+//-- includes -----
+#include "RecordingFile.h"
+#include "ServerLog.h"
+
+#include <istream>
+#include <ostream>
+
+//-- RecordingFileFormat -----
+RecordingFileFormat::RecordingFileFormat(const char *magic, uint32_t version, const char *recording_name)
+    : m_recordingName(recording_name)
+{
+    memcpy(m_tag.magic, magic, sizeof(m_tag.magic));
+    m_tag.version= version;
+}
+
+uint64_t RecordingFileFormat::countCompleteRecords(uint64_t file_size, uint64_t records_offset, uint64_t record_size)
+{
+    return (file_size > records_offset && record_size > 0) ? (file_size - records_offset) / record_size : 0;
+}
+
+bool RecordingFileFormat::writeHeaderBytes(
+    std::ostream &file,
+    const void *header,
+    size_t header_size,
+    const std::string &config_json) const
+{
+    file.write(static_cast<const char *>(header), header_size);
+    file.write(config_json.data(), config_json.size());
+
+    return file.good();
+}
+
+bool RecordingFileFormat::readHeaderBytes(
+    std::istream &file,
+    const std::string &path,
+    void *out_header,
+    size_t header_size) const
+{
+    if (!file.read(static_cast<char *>(out_header), header_size))
+    {
+        SERVER_LOG_ERROR("RecordingFileFormat::readHeader") << "Failed to read " << m_recordingName << " recording: " << path;
+        return false;
+    }
+
+    RecordingFileTag tag;
+    memcpy(&tag, out_header, sizeof(tag));
+
+    if (memcmp(tag.magic, m_tag.magic, sizeof(tag.magic)) != 0 || tag.version != m_tag.version)
+    {
+        SERVER_LOG_ERROR("RecordingFileFormat::readHeader") << "Unsupported " << m_recordingName << " recording: " << path;
+        return false;
+    }
+
+    return true;
+}
+
+bool RecordingFileFormat::readConfig(
+    std::istream &file,
+    const std::string &path,
+    uint32_t config_size,
+    std::string &out_config_json) const
+{
+    out_config_json.resize(config_size);
+    if (config_size > 0 && !file.read(&out_config_json[0], config_size))
+    {
+        SERVER_LOG_ERROR("RecordingFileFormat::readHeader") << "Truncated " << m_recordingName << " recording: " << path;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef RECORDING_FILE_H
+#define RECORDING_FILE_H
+
+//-- includes -----
+#include <iosfwd>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+//-- definitions -----
+/// Every recording file header starts with this: which kind of recording it is and its format version
+struct RecordingFileTag
+{
+    char magic[8];
+    uint32_t version;
+};
+
+/// The file format code the tracker frame and HID packet recordings share.
+/// A recording is a header, the json config of the device that was recorded, and then the recorded samples.
+/// The header type has to start with a RecordingFileTag named 'tag' and have a 'config_size'.
+class RecordingFileFormat
+{
+public:
+    /// \param recording_name What kind of recording this is in log messages, e.g. "tracker"
+    RecordingFileFormat(const char *magic, uint32_t version, const char *recording_name);
+
+    /// Clears the header and stamps the tag and the config size into it
+    template <typename t_file_header>
+    void initHeader(t_file_header &header, const std::string &config_json) const
+    {
+        static_assert(offsetof(t_file_header, tag) == 0, "the recording file header has to start with its tag");
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.tag.magic, m_tag.magic, sizeof(m_tag.magic));
+        header.tag.version= m_tag.version;
+        header.config_size= static_cast<uint32_t>(config_json.size());
+    }
+
+    /// Writes the header followed by the json config
+    template <typename t_file_header>
+    bool writeHeader(std::ostream &file, const t_file_header &header, const std::string &config_json) const
+    {
+        return writeHeaderBytes(file, &header, sizeof(header), config_json);
+    }
+
+    /// Reads the header and the json config. Fails (and logs why) when the file can't be read,
+    /// is another kind of recording or version, or ends before the config does.
+    template <typename t_file_header>
+    bool readHeader(std::istream &file, const std::string &path, t_file_header &out_header, std::string &out_config_json) const
+    {
+        return
+            readHeaderBytes(file, path, &out_header, sizeof(out_header)) &&
+            readConfig(file, path, out_header.config_size, out_config_json);
+    }
+
+    /// The number of fixed size records that made it to disk in full. A recording that wasn't closed cleanly
+    /// can end part way through a record, and its header may not count the last records written.
+    static uint64_t countCompleteRecords(uint64_t file_size, uint64_t records_offset, uint64_t record_size);
+
+private:
+    bool writeHeaderBytes(std::ostream &file, const void *header, size_t header_size, const std::string &config_json) const;
+    bool readHeaderBytes(std::istream &file, const std::string &path, void *out_header, size_t header_size) const;
+    bool readConfig(std::istream &file, const std::string &path, uint32_t config_size, std::string &out_config_json) const;
+
+    RecordingFileTag m_tag;
+    const char *m_recordingName;
+};
+
+#endif // RECORDING_FILE_H
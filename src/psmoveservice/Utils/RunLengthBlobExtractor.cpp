@@ -0,0 +1,390 @@
+//-- includes -----
+#include "RunLengthBlobExtractor.h"
+
+#include <assert.h>
+#include <limits.h>
+
+//-- prototypes -----
+static inline int64_t sum_of_integers(int64_t n);
+static inline int64_t sum_of_squares(int64_t n);
+
+//-- public interface -----
+RunLengthBlobExtractor::RunLengthBlobExtractor()
+    : m_componentCount(0)
+{
+}
+
+int RunLengthBlobExtractor::extractBiggestBlobs(
+    const uint8_t *mask, int width, int height, int stride,
+    int origin_x, int origin_y, int max_blob_count)
+{
+    m_runs.clear();
+    m_labelParents.clear();
+    m_labelStats.clear();
+    m_blobs.clear();
+    m_componentCount= 0;
+
+    // Runs of the previous row are [prev_row_begin, prev_row_end) in m_runs
+    size_t prev_row_begin= 0;
+    size_t prev_row_end= 0;
+
+    for (int row = 0; row < height; ++row)
+    {
+        const uint8_t *mask_row= mask + static_cast<ptrdiff_t>(row)*stride;
+        const size_t row_begin= m_runs.size();
+        size_t prev_run_index= prev_row_begin;
+        int x= 0;
+
+        while (x < width)
+        {
+            // Skip the background
+            while (x < width && mask_row[x] == 0)
+            {
+                ++x;
+            }
+
+            if (x >= width)
+            {
+                break;
+            }
+
+            Run run;
+            run.x_begin= x;
+            while (x < width && mask_row[x] != 0)
+            {
+                ++x;
+            }
+            run.x_end= x;
+            run.y= row;
+            run.label= -1;
+
+            // Skip the runs in the row above that end before this one can touch them.
+            // Runs further along may still touch the next run in this row, so they're left alone.
+            while (prev_run_index < prev_row_end && m_runs[prev_run_index].x_end < run.x_begin)
+            {
+                ++prev_run_index;
+            }
+
+            // Merge with every run above that touches this one, diagonals included
+            for (size_t test_index = prev_run_index;
+                test_index < prev_row_end && m_runs[test_index].x_begin <= run.x_end;
+                ++test_index)
+            {
+                const int above_label= m_runs[test_index].label;
+
+                if (run.label == -1)
+                {
+                    run.label= above_label;
+                }
+                else
+                {
+                    mergeLabels(run.label, above_label);
+                }
+            }
+
+            if (run.label == -1)
+            {
+                run.label= createLabel();
+            }
+
+            accumulateRun(run);
+            m_runs.push_back(run);
+        }
+
+        prev_row_begin= row_begin;
+        prev_row_end= m_runs.size();
+    }
+
+    // Labels always point at a smaller label, so a single forward pass resolves every root
+    // and folds the moments of every label into its root
+    const int label_count= static_cast<int>(m_labelParents.size());
+    for (int label = 0; label < label_count; ++label)
+    {
+        const int parent= m_labelParents[label];
+
+        if (parent == label)
+        {
+            ++m_componentCount;
+        }
+        else
+        {
+            const int root= m_labelParents[parent];
+            BlobInfo &root_stats= m_labelStats[root];
+            const BlobInfo &label_stats= m_labelStats[label];
+
+            m_labelParents[label]= root;
+            root_stats.m00+= label_stats.m00;
+            root_stats.m10+= label_stats.m10;
+            root_stats.m01+= label_stats.m01;
+            root_stats.m20+= label_stats.m20;
+            root_stats.m11+= label_stats.m11;
+            root_stats.m02+= label_stats.m02;
+            root_stats.x_min= (label_stats.x_min < root_stats.x_min) ? label_stats.x_min : root_stats.x_min;
+            root_stats.y_min= (label_stats.y_min < root_stats.y_min) ? label_stats.y_min : root_stats.y_min;
+            root_stats.x_max= (label_stats.x_max > root_stats.x_max) ? label_stats.x_max : root_stats.x_max;
+            root_stats.y_max= (label_stats.y_max > root_stats.y_max) ? label_stats.y_max : root_stats.y_max;
+        }
+    }
+
+    selectBiggestBlobs(max_blob_count);
+    traceBlobBoundaries();
+
+    // Move everything from mask space into image space
+    for (BlobInfo &blob : m_blobs)
+    {
+        const int64_t ox= origin_x;
+        const int64_t oy= origin_y;
+
+        // Moments about the image origin from moments about the mask origin
+        blob.m20+= 2*ox*blob.m10 + ox*ox*blob.m00;
+        blob.m02+= 2*oy*blob.m01 + oy*oy*blob.m00;
+        blob.m11+= ox*blob.m01 + oy*blob.m10 + ox*oy*blob.m00;
+        blob.m10+= ox*blob.m00;
+        blob.m01+= oy*blob.m00;
+        blob.x_min+= origin_x;
+        blob.x_max+= origin_x;
+        blob.y_min+= origin_y;
+        blob.y_max+= origin_y;
+
+        BlobPoint *boundary= m_boundaryPoints.data() + blob.boundary_start;
+        for (int point_index = 0; point_index < blob.boundary_count; ++point_index)
+        {
+            boundary[point_index].x+= origin_x;
+            boundary[point_index].y+= origin_y;
+        }
+    }
+
+    return getBlobCount();
+}
+
+//-- private methods -----
+int RunLengthBlobExtractor::createLabel()
+{
+    const int label= static_cast<int>(m_labelParents.size());
+
+    BlobInfo stats;
+    stats.m00= stats.m10= stats.m01= 0;
+    stats.m20= stats.m11= stats.m02= 0;
+    stats.x_min= stats.y_min= INT_MAX;
+    stats.x_max= stats.y_max= INT_MIN;
+    stats.boundary_start= 0;
+    stats.boundary_count= 0;
+
+    m_labelParents.push_back(label);
+    m_labelStats.push_back(stats);
+
+    return label;
+}
+
+int RunLengthBlobExtractor::findRoot(int label)
+{
+    while (m_labelParents[label] != label)
+    {
+        // Path halving
+        m_labelParents[label]= m_labelParents[m_labelParents[label]];
+        label= m_labelParents[label];
+    }
+
+    return label;
+}
+
+void RunLengthBlobExtractor::mergeLabels(int label_a, int label_b)
+{
+    const int root_a= findRoot(label_a);
+    const int root_b= findRoot(label_b);
+
+    // The smaller label becomes the root, which keeps every parent below its child
+    if (root_a < root_b)
+    {
+        m_labelParents[root_b]= root_a;
+    }
+    else if (root_b < root_a)
+    {
+        m_labelParents[root_a]= root_b;
+    }
+}
+
+void RunLengthBlobExtractor::accumulateRun(const Run &run)
+{
+    BlobInfo &stats= m_labelStats[run.label];
+    const int64_t length= run.x_end - run.x_begin;
+    const int64_t sum_x= sum_of_integers(run.x_end - 1) - sum_of_integers(run.x_begin - 1);
+    const int64_t sum_x2= sum_of_squares(run.x_end - 1) - sum_of_squares(run.x_begin - 1);
+    const int64_t y= run.y;
+
+    stats.m00+= length;
+    stats.m10+= sum_x;
+    stats.m01+= y*length;
+    stats.m20+= sum_x2;
+    stats.m11+= y*sum_x;
+    stats.m02+= y*y*length;
+    stats.x_min= (run.x_begin < stats.x_min) ? run.x_begin : stats.x_min;
+    stats.x_max= (run.x_end - 1 > stats.x_max) ? run.x_end - 1 : stats.x_max;
+    stats.y_min= (run.y < stats.y_min) ? run.y : stats.y_min;
+    stats.y_max= (run.y > stats.y_max) ? run.y : stats.y_max;
+}
+
+void RunLengthBlobExtractor::selectBiggestBlobs(int max_blob_count)
+{
+    const int label_count= static_cast<int>(m_labelParents.size());
+
+    // Keep the N biggest roots sorted largest first with an insertion sort,
+    // N is small (one controller or a handful of HMD LEDs)
+    m_blobLabels.clear();
+    for (int label = 0; label < label_count && max_blob_count > 0; ++label)
+    {
+        if (m_labelParents[label] != label)
+        {
+            continue;
+        }
+
+        const int64_t area= m_labelStats[label].m00;
+        int insert_index= static_cast<int>(m_blobLabels.size());
+
+        while (insert_index > 0 && m_labelStats[m_blobLabels[insert_index - 1]].m00 < area)
+        {
+            --insert_index;
+        }
+
+        if (insert_index < max_blob_count)
+        {
+            if (static_cast<int>(m_blobLabels.size()) < max_blob_count)
+            {
+                m_blobLabels.push_back(label);
+            }
+
+            for (int shift_index = static_cast<int>(m_blobLabels.size()) - 1; shift_index > insert_index; --shift_index)
+            {
+                m_blobLabels[shift_index]= m_blobLabels[shift_index - 1];
+            }
+            m_blobLabels[insert_index]= label;
+        }
+    }
+
+    for (int label : m_blobLabels)
+    {
+        m_blobs.push_back(m_labelStats[label]);
+    }
+}
+
+void RunLengthBlobExtractor::traceBlobBoundaries()
+{
+    const int blob_count= getBlobCount();
+
+    m_labelBlobIndices.assign(m_labelParents.size(), -1);
+    m_blobRowOffsets.clear();
+    m_rowExtents.clear();
+    m_boundaryPoints.clear();
+
+    // A blob is connected, so every row between its top and bottom has at least one run
+    for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+    {
+        const BlobInfo &blob= m_blobs[blob_index];
+        const RowExtent empty_extent= {INT_MAX, INT_MIN};
+
+        m_labelBlobIndices[m_blobLabels[blob_index]]= blob_index;
+        m_blobRowOffsets.push_back(static_cast<int>(m_rowExtents.size()));
+        m_rowExtents.insert(m_rowExtents.end(), blob.y_max - blob.y_min + 1, empty_extent);
+    }
+
+    // Find the leftmost and rightmost pixel of every row of the kept blobs
+    if (blob_count > 0)
+    {
+        for (const Run &run : m_runs)
+        {
+            const int blob_index= m_labelBlobIndices[m_labelParents[run.label]];
+
+            if (blob_index != -1)
+            {
+                RowExtent &extent= m_rowExtents[m_blobRowOffsets[blob_index] + run.y - m_blobs[blob_index].y_min];
+
+                extent.x_left= (run.x_begin < extent.x_left) ? run.x_begin : extent.x_left;
+                extent.x_right= (run.x_end - 1 > extent.x_right) ? run.x_end - 1 : extent.x_right;
+            }
+        }
+    }
+
+    // Walk down the left side and back up the right side
+    for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+    {
+        BlobInfo &blob= m_blobs[blob_index];
+        const RowExtent *extents= m_rowExtents.data() + m_blobRowOffsets[blob_index];
+        const int row_count= blob.y_max - blob.y_min + 1;
+
+        blob.boundary_start= static_cast<int>(m_boundaryPoints.size());
+        blob.boundary_count= 0;
+
+        for (int row_index = 0; row_index < row_count; ++row_index)
+        {
+            appendBoundaryPoint(blob, extents[row_index].x_left, blob.y_min + row_index);
+        }
+
+        for (int row_index = row_count - 1; row_index >= 0; --row_index)
+        {
+            appendBoundaryPoint(blob, extents[row_index].x_right, blob.y_min + row_index);
+        }
+
+        // The polygon wraps around, so the first point can be collinear with its neighbors too
+        while (blob.boundary_count > 2)
+        {
+            const BlobPoint &prev= m_boundaryPoints[blob.boundary_start + blob.boundary_count - 1];
+            const BlobPoint &point= m_boundaryPoints[blob.boundary_start];
+            const BlobPoint &next= m_boundaryPoints[blob.boundary_start + 1];
+            const int cross= (point.x - prev.x)*(next.y - point.y) - (point.y - prev.y)*(next.x - point.x);
+            const int dot= (point.x - prev.x)*(next.x - point.x) + (point.y - prev.y)*(next.y - point.y);
+
+            if (cross != 0 || dot < 0)
+            {
+                break;
+            }
+
+            m_boundaryPoints.erase(m_boundaryPoints.begin() + blob.boundary_start);
+            --blob.boundary_count;
+        }
+    }
+}
+
+void RunLengthBlobExtractor::appendBoundaryPoint(BlobInfo &blob, int x, int y)
+{
+    const BlobPoint point= {x, y};
+
+    if (blob.boundary_count >= 1)
+    {
+        const BlobPoint &last= m_boundaryPoints.back();
+
+        if (last.x == x && last.y == y)
+        {
+            // Single pixel wide rows show up on both sides
+            return;
+        }
+
+        if (blob.boundary_count >= 2)
+        {
+            const BlobPoint &before_last= m_boundaryPoints[m_boundaryPoints.size() - 2];
+            const int cross= (last.x - before_last.x)*(y - last.y) - (last.y - before_last.y)*(x - last.x);
+            const int dot= (last.x - before_last.x)*(x - last.x) + (last.y - before_last.y)*(y - last.y);
+
+            if (cross == 0 && dot >= 0)
+            {
+                // Still going in the same direction, the last point is redundant
+                m_boundaryPoints.back()= point;
+                return;
+            }
+        }
+    }
+
+    m_boundaryPoints.push_back(point);
+    ++blob.boundary_count;
+}
+
+static inline int64_t sum_of_integers(int64_t n)
+{
+    // 0 + 1 + ... + n (and 0 for n == -1)
+    return n*(n + 1)/2;
+}
+
+static inline int64_t sum_of_squares(int64_t n)
+{
+    // 0 + 1 + 4 + ... + n^2 (and 0 for n == -1)
+    return n*(n + 1)*(2*n + 1)/6;
+}
@@ -0,0 +1,113 @@
+#ifndef RUN_LENGTH_BLOB_EXTRACTOR_H
+#define RUN_LENGTH_BLOB_EXTRACTOR_H
+
+//-- includes -----
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//-- definitions -----
+struct BlobPoint
+{
+    int x;
+    int y;
+};
+
+struct BlobInfo
+{
+    // Raw pixel moments in image space (m00 is the pixel count)
+    int64_t m00;
+    int64_t m10, m01;
+    int64_t m20, m11, m02;
+
+    // Inclusive pixel bounds
+    int x_min, y_min;
+    int x_max, y_max;
+
+    // Outline of the blob, see RunLengthBlobExtractor::getBlobBoundary()
+    int boundary_start;
+    int boundary_count;
+
+    inline int getArea() const
+    { return static_cast<int>(m00); }
+    inline float getCenterX() const
+    { return static_cast<float>(static_cast<double>(m10) / static_cast<double>(m00)); }
+    inline float getCenterY() const
+    { return static_cast<float>(static_cast<double>(m01) / static_cast<double>(m00)); }
+};
+
+// Single pass run-length connected component labeller for tracker masks.
+// Every run of non-zero pixels in a row gets merged with the 8-connected runs of the row above
+// through a union-find, the pixel moments get summed per run as the rows go by,
+// and only the N biggest blobs get their outline traced at the end.
+// All of the working storage is kept between calls, so once it has grown to fit
+// the busiest mask it sees, extracting blobs doesn't allocate.
+class RunLengthBlobExtractor
+{
+public:
+    RunLengthBlobExtractor();
+
+    /// Finds the biggest 8-connected blobs of non-zero pixels in the mask, sorted by area (largest first)
+    /// \param mask The top left pixel of the mask, one byte per pixel
+    /// \param width The width of the mask in pixels
+    /// \param height The height of the mask in pixels
+    /// \param stride The number of bytes between rows of the mask
+    /// \param origin_x The image space x coordinate of the first mask column (i.e. the ROI offset)
+    /// \param origin_y The image space y coordinate of the first mask row
+    /// \param max_blob_count The maximum number of blobs to keep
+    /// \return The number of blobs found, at most max_blob_count
+    int extractBiggestBlobs(
+        const uint8_t *mask, int width, int height, int stride,
+        int origin_x, int origin_y, int max_blob_count);
+
+    inline int getBlobCount() const
+    { return static_cast<int>(m_blobs.size()); }
+    inline const BlobInfo &getBlob(int blob_index) const
+    { return m_blobs[blob_index]; }
+
+    /// The outline of the blob as a closed polygon of boundary pixels: the leftmost pixel of every row
+    /// going down, then the rightmost pixel of every row going back up, with collinear points dropped.
+    /// Holes and concavities between runs on the same row are filled in.
+    inline const BlobPoint *getBlobBoundary(int blob_index) const
+    { return m_boundaryPoints.data() + m_blobs[blob_index].boundary_start; }
+
+    /// The number of connected components in the last mask (including the ones that weren't kept)
+    inline int getComponentCount() const
+    { return m_componentCount; }
+
+private:
+    struct Run
+    {
+        int x_begin; // first pixel
+        int x_end; // one past the last pixel
+        int y;
+        int label;
+    };
+
+    struct RowExtent
+    {
+        int x_left;
+        int x_right;
+    };
+
+    int createLabel();
+    int findRoot(int label);
+    void mergeLabels(int label_a, int label_b);
+    void accumulateRun(const Run &run);
+    void selectBiggestBlobs(int max_blob_count);
+    void traceBlobBoundaries();
+    void appendBoundaryPoint(BlobInfo &blob, int x, int y);
+
+    std::vector<Run> m_runs;
+    std::vector<int> m_labelParents;
+    std::vector<BlobInfo> m_labelStats;
+    std::vector<int> m_labelBlobIndices;
+    std::vector<BlobInfo> m_blobs;
+    std::vector<int> m_blobLabels;
+    std::vector<int> m_blobRowOffsets;
+    std::vector<RowExtent> m_rowExtents;
+    std::vector<BlobPoint> m_boundaryPoints;
+    int m_componentCount;
+};
+
+#endif // RUN_LENGTH_BLOB_EXTRACTOR_H
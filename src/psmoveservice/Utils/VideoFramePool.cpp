@@ -0,0 +1,126 @@
+//-- includes -----
+#include "VideoFramePool.h"
+
+#include <assert.h>
+#include <mutex>
+#include <vector>
+
+//-- constants -----
+// Frames beyond this many sitting idle in the pool get freed instead of recycled
+static const size_t k_max_free_frames= 8;
+
+//-- private definitions -----
+// Shared between the pool and the frames it hands out,
+// so that a frame can find its way back after the pool is gone
+struct VideoFramePoolState
+{
+    std::mutex freeFramesMutex;
+    std::vector<VideoFrame *> freeFrames;
+    int allocatedFrameCount;
+    bool bIsPoolAlive;
+
+    VideoFramePoolState()
+        : freeFrames()
+        , allocatedFrameCount(0)
+        , bIsPoolAlive(true)
+    {
+    }
+
+    ~VideoFramePoolState()
+    {
+        for (VideoFrame *frame : freeFrames)
+        {
+            delete frame;
+        }
+    }
+
+    VideoFrame *allocateFrame(int width, int height, int stride)
+    {
+        std::lock_guard<std::mutex> lock(freeFramesMutex);
+
+        while (!freeFrames.empty())
+        {
+            VideoFrame *frame= freeFrames.back();
+            freeFrames.pop_back();
+
+            if (frame->m_width == width && frame->m_height == height && frame->m_stride == stride)
+            {
+                return frame;
+            }
+
+            // Left over from before the frame size changed
+            delete frame;
+            --allocatedFrameCount;
+        }
+
+        ++allocatedFrameCount;
+        return new VideoFrame(width, height, stride);
+    }
+
+    void releaseFrame(VideoFrame *frame)
+    {
+        std::lock_guard<std::mutex> lock(freeFramesMutex);
+
+        if (bIsPoolAlive && freeFrames.size() < k_max_free_frames)
+        {
+            freeFrames.push_back(frame);
+        }
+        else
+        {
+            delete frame;
+            --allocatedFrameCount;
+        }
+    }
+};
+
+//-- public methods -----
+VideoFrame::VideoFrame(int width, int height, int stride)
+    : m_data(nullptr)
+    , m_width(width)
+    , m_height(height)
+    , m_stride(stride)
+    , m_captureTimeUs(0)
+{
+    assert(width > 0 && height > 0 && stride >= width);
+    m_data= new unsigned char[getBufferSize()];
+}
+
+VideoFrame::~VideoFrame()
+{
+    delete[] m_data;
+}
+
+VideoFramePool::VideoFramePool()
+    : m_state(new VideoFramePoolState)
+{
+}
+
+VideoFramePool::~VideoFramePool()
+{
+    // Frames still in use get freed when their last reference goes away
+    std::lock_guard<std::mutex> lock(m_state->freeFramesMutex);
+    m_state->bIsPoolAlive= false;
+}
+
+std::shared_ptr<VideoFrame> VideoFramePool::allocateFrame(int width, int height, int stride)
+{
+    std::shared_ptr<VideoFramePoolState> state= m_state;
+    VideoFrame *frame= state->allocateFrame(width, height, stride);
+    frame->m_captureTimeUs= 0;
+
+    return std::shared_ptr<VideoFrame>(frame, [state](VideoFrame *released_frame) {
+        state->releaseFrame(released_frame);
+    });
+}
+
+int VideoFramePool::getAllocatedFrameCount() const
+{
+    std::lock_guard<std::mutex> lock(m_state->freeFramesMutex);
+    return m_state->allocatedFrameCount;
+}
+
+int VideoFramePool::getFreeFrameCount() const
+{
+    std::lock_guard<std::mutex> lock(m_state->freeFramesMutex);
+    return static_cast<int>(m_state->freeFrames.size());
+}
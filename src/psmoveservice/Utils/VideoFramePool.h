@@ -0,0 +1,74 @@
+#ifndef VIDEO_FRAME_POOL_H
+#define VIDEO_FRAME_POOL_H
+
+//-- includes -----
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+//-- pre-declarations -----
+struct VideoFramePoolState;
+
+//-- definitions -----
+// A pooled video frame buffer.
+// Frames are handed around by reference counted pointer and return to their pool
+// when the last reference is dropped, so a frame never changes while someone holds on to it.
+class VideoFrame
+{
+public:
+    inline const unsigned char *getData() const
+    { return m_data; }
+    inline unsigned char *getMutableData()
+    { return m_data; }
+    inline int getWidth() const
+    { return m_width; }
+    inline int getHeight() const
+    { return m_height; }
+    inline int getStride() const
+    { return m_stride; }
+    inline size_t getBufferSize() const
+    { return static_cast<size_t>(m_stride)*static_cast<size_t>(m_height); }
+    /// When the driver grabbed the frame, in PipelineLatencyStats::getTimestampUs() time
+    inline int64_t getCaptureTimeUs() const
+    { return m_captureTimeUs; }
+    inline void setCaptureTimeUs(int64_t capture_time_us)
+    { m_captureTimeUs= capture_time_us; }
+
+private:
+    friend class VideoFramePool;
+    friend struct VideoFramePoolState;
+
+    VideoFrame(int width, int height, int stride);
+    ~VideoFrame();
+
+    unsigned char *m_data;
+    int m_width;
+    int m_height;
+    int m_stride;
+    int64_t m_captureTimeUs;
+};
+typedef std::shared_ptr<const VideoFrame> VideoFramePtr;
+
+// Recycles video frame buffers so that a frame can be captured once
+// and then read in place by everything that needs it, with no copies.
+// Frames may outlive the pool: they get freed instead of recycled in that case.
+class VideoFramePool
+{
+public:
+    VideoFramePool();
+    virtual ~VideoFramePool();
+
+    /// Returns a frame buffer of the given size that no one else references.
+    /// The contents of the buffer are undefined (it's typically a recycled frame).
+    std::shared_ptr<VideoFrame> allocateFrame(int width, int height, int stride);
+
+    /// The number of frames the pool has allocated and not yet freed (in use + free)
+    int getAllocatedFrameCount() const;
+    /// The number of frames waiting in the pool to be reused
+    int getFreeFrameCount() const;
+
+private:
+    std::shared_ptr<VideoFramePoolState> m_state;
+};
+
+#endif // VIDEO_FRAME_POOL_H
@@ -0,0 +1,265 @@
+//-- includes -----
+#include "WorkStealingJobPool.h"
+#include "WorkerThread.h"
+#include "ServerLog.h"
+
+//-- definitions -----
+class JobPoolWorkerThread : public WorkerThread
+{
+public:
+	JobPoolWorkerThread(WorkStealingJobPool *pool, int queue_index, const std::string &thread_name)
+		: WorkerThread(thread_name)
+		, m_pool(pool)
+		, m_queueIndex(queue_index)
+		, m_lastBatchId(0)
+	{
+	}
+
+protected:
+	void onThreadHaltBegin() override
+	{
+		// Wake the thread up if it's waiting for a batch so that it sees the exit flag
+		m_pool->wakeWorkers();
+	}
+
+	bool doWork() override
+	{
+		if (m_pool->waitForBatch(m_lastBatchId, m_exitSignaled))
+		{
+			m_pool->runAvailableJobs(m_queueIndex);
+		}
+
+		return true;
+	}
+
+private:
+	WorkStealingJobPool *m_pool;
+	const int m_queueIndex;
+	int m_lastBatchId;
+};
+
+//-- public interface -----
+WorkStealingJobPool::WorkStealingJobPool(const std::string &pool_name, int max_job_count)
+	: m_poolName(pool_name)
+	, m_jobs(max_job_count)
+	, m_jobCount(0)
+	, m_workers()
+	, m_queues(nullptr)
+	, m_queueCount(0)
+	, m_pendingJobCount({ 0 })
+	, m_batchId(0)
+{
+	// The calling thread always gets a queue
+	allocateQueues(1);
+}
+
+WorkStealingJobPool::~WorkStealingJobPool()
+{
+	stopWorkers();
+	freeQueues();
+}
+
+void WorkStealingJobPool::startWorkers(int worker_count)
+{
+	stopWorkers();
+
+	if (worker_count > 0)
+	{
+		SERVER_LOG_INFO("WorkStealingJobPool::startWorkers") << "Starting " << worker_count << " workers for job pool: " << m_poolName;
+
+		allocateQueues(worker_count + 1);
+
+		for (int worker_index = 0; worker_index < worker_count; ++worker_index)
+		{
+			JobPoolWorkerThread *worker=
+				new JobPoolWorkerThread(this, worker_index + 1, m_poolName + std::to_string(worker_index));
+
+			worker->startThread();
+			m_workers.push_back(worker);
+		}
+	}
+}
+
+void WorkStealingJobPool::stopWorkers()
+{
+	if (m_workers.size() > 0)
+	{
+		for (JobPoolWorkerThread *worker : m_workers)
+		{
+			worker->stopThread();
+			delete worker;
+		}
+		m_workers.clear();
+
+		allocateQueues(1);
+	}
+}
+
+bool WorkStealingJobPool::addJob(t_job_function job_function, void *job_context)
+{
+	if (m_jobCount >= static_cast<int>(m_jobs.size()))
+	{
+		SERVER_LOG_ERROR("WorkStealingJobPool::addJob") << "Job pool " << m_poolName << " is full (" << m_jobs.size() << " jobs)";
+		return false;
+	}
+
+	m_jobs[m_jobCount].function= job_function;
+	m_jobs[m_jobCount].context= job_context;
+	++m_jobCount;
+
+	return true;
+}
+
+void WorkStealingJobPool::runJobs()
+{
+	if (m_jobCount == 0)
+	{
+		return;
+	}
+
+	// Count the jobs before dealing them out since an idle worker may start stealing right away
+	m_pendingJobCount.store(m_jobCount);
+
+	for (int queue_index = 0; queue_index < m_queueCount; ++queue_index)
+	{
+		JobQueue &queue= m_queues[queue_index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		queue.head= 0;
+		queue.tail= 0;
+		for (int job_index = queue_index; job_index < m_jobCount; job_index+= m_queueCount)
+		{
+			queue.job_indices[queue.tail]= job_index;
+			++queue.tail;
+		}
+	}
+
+	if (m_workers.size() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_batchMutex);
+
+		++m_batchId;
+		m_batchStartedCondition.notify_all();
+	}
+
+	// Help out with the batch rather than just waiting on it
+	runAvailableJobs(0);
+
+	// Block until the jobs the workers picked up are done too
+	{
+		std::unique_lock<std::mutex> lock(m_batchMutex);
+
+		m_batchFinishedCondition.wait(lock, [this] { return m_pendingJobCount.load() == 0; });
+	}
+
+	m_jobCount= 0;
+}
+
+//-- private methods -----
+void WorkStealingJobPool::allocateQueues(int queue_count)
+{
+	freeQueues();
+
+	m_queues= new JobQueue[queue_count];
+	m_queueCount= queue_count;
+
+	for (int queue_index = 0; queue_index < queue_count; ++queue_index)
+	{
+		JobQueue &queue= m_queues[queue_index];
+
+		queue.job_indices.resize(m_jobs.size());
+		queue.head= 0;
+		queue.tail= 0;
+	}
+}
+
+void WorkStealingJobPool::freeQueues()
+{
+	if (m_queues != nullptr)
+	{
+		delete[] m_queues;
+		m_queues= nullptr;
+		m_queueCount= 0;
+	}
+}
+
+bool WorkStealingJobPool::waitForBatch(int &last_batch_id, const std::atomic_bool &exit_signaled)
+{
+	std::unique_lock<std::mutex> lock(m_batchMutex);
+
+	m_batchStartedCondition.wait(lock, [this, &last_batch_id, &exit_signaled] {
+		return exit_signaled.load() || m_batchId != last_batch_id;
+	});
+
+	if (exit_signaled.load())
+	{
+		return false;
+	}
+
+	last_batch_id= m_batchId;
+
+	return true;
+}
+
+void WorkStealingJobPool::wakeWorkers()
+{
+	std::lock_guard<std::mutex> lock(m_batchMutex);
+
+	m_batchStartedCondition.notify_all();
+}
+
+void WorkStealingJobPool::runAvailableJobs(int queue_index)
+{
+	int job_index;
+
+	while (tryPopJob(queue_index, job_index) || tryStealJob(queue_index, job_index))
+	{
+		const Job &job= m_jobs[job_index];
+
+		job.function(job.context);
+
+		// The last job out wakes up the thread waiting on the batch
+		if (m_pendingJobCount.fetch_sub(1) == 1)
+		{
+			std::lock_guard<std::mutex> lock(m_batchMutex);
+
+			m_batchFinishedCondition.notify_all();
+		}
+	}
+}
+
+bool WorkStealingJobPool::tryPopJob(int queue_index, int &out_job_index)
+{
+	JobQueue &queue= m_queues[queue_index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+
+	if (queue.head < queue.tail)
+	{
+		--queue.tail;
+		out_job_index= queue.job_indices[queue.tail];
+
+		return true;
+	}
+
+	return false;
+}
+
+bool WorkStealingJobPool::tryStealJob(int thief_queue_index, int &out_job_index)
+{
+	// Start with the next queue over so that the thieves spread out over the victims
+	for (int offset = 1; offset < m_queueCount; ++offset)
+	{
+		JobQueue &queue= m_queues[(thief_queue_index + offset) % m_queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.head < queue.tail)
+		{
+			out_job_index= queue.job_indices[queue.head];
+			++queue.head;
+
+			return true;
+		}
+	}
+
+	return false;
+}
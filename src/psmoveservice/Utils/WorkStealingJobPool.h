@@ -0,0 +1,86 @@
+#ifndef WORK_STEALING_JOB_POOL_H
+#define WORK_STEALING_JOB_POOL_H
+
+//-- includes -----
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//-- pre-declarations -----
+class JobPoolWorkerThread;
+
+//-- definitions -----
+/// Runs batches of independent jobs on a fixed set of worker threads plus the thread calling runJobs().
+/// Each batch is dealt out round robin to one queue per thread. A thread that runs out of its own jobs
+/// steals from the front of the other queues, so a few slow jobs don't hold up the rest of the batch.
+/// Jobs are added and run from one thread (the main thread). Nothing is allocated once the workers start.
+class WorkStealingJobPool
+{
+public:
+	typedef void (*t_job_function)(void *job_context);
+
+	WorkStealingJobPool(const std::string &pool_name, int max_job_count);
+	virtual ~WorkStealingJobPool();
+
+	/// With no worker threads the jobs all run on the thread calling runJobs()
+	void startWorkers(int worker_count);
+	void stopWorkers();
+
+	inline int getWorkerCount() const { return static_cast<int>(m_workers.size()); }
+	inline int getPendingJobCount() const { return m_jobCount; }
+
+	/// Adds a job to the next batch. Returns false if the batch is already full.
+	bool addJob(t_job_function job_function, void *job_context);
+
+	/// Runs every job added since the last call and blocks until all of them have finished
+	void runJobs();
+
+private:
+	struct Job
+	{
+		t_job_function function;
+		void *context;
+	};
+
+	// Job indices dealt to one thread. The owner pops from the back, thieves take from the front.
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::vector<int> job_indices;
+		int head;
+		int tail;
+	};
+
+	void allocateQueues(int queue_count);
+	void freeQueues();
+
+	// Called by the worker threads
+	bool waitForBatch(int &last_batch_id, const std::atomic_bool &exit_signaled);
+	void wakeWorkers();
+	void runAvailableJobs(int queue_index);
+
+	bool tryPopJob(int queue_index, int &out_job_index);
+	bool tryStealJob(int thief_queue_index, int &out_job_index);
+
+	friend class JobPoolWorkerThread;
+
+	const std::string m_poolName;
+
+	// Main Thread State
+	std::vector<Job> m_jobs;
+	int m_jobCount;
+	std::vector<JobPoolWorkerThread *> m_workers;
+
+	// Multithreaded state
+	JobQueue *m_queues; // queue 0 belongs to the thread calling runJobs()
+	int m_queueCount;
+	std::atomic_int m_pendingJobCount;
+	std::mutex m_batchMutex;
+	std::condition_variable m_batchStartedCondition;
+	std::condition_variable m_batchFinishedCondition;
+	int m_batchId;
+};
+
+#endif // WORK_STEALING_JOB_POOL_H
@@ -9,6 +9,7 @@ class WorkerThread
 {
 public:
 	WorkerThread(const std::string thread_name);
+	virtual ~WorkerThread() { }
 
 	inline bool hasThreadStarted() const
 	{
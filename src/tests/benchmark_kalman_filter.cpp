@@ -0,0 +1,196 @@
+#include "kalman_filter_test_data.h"
+
+#include <algorithm>
+#include <chrono>
+
+//-- constants -----
+#define DEFAULT_ITERATION_COUNT 20
+
+//-- definitions -----
+/// The filter output for every sample of a trace, plus how fast the filter got through it
+struct FilterRunResult
+{
+	std::vector<Eigen::Vector3f> positions_cm;
+	std::vector<Eigen::Quaternionf, Eigen::aligned_allocator<Eigen::Quaternionf> > orientations;
+	int update_count;
+	double update_seconds;
+};
+
+//-- prototypes -----
+static bool run_filter(
+	const bool bUseSinglePrecision,
+	const int iteration_count,
+	const ControllerInputStream &stationary_stream,
+	ControllerInputStream &movement_stream,
+	FilterRunResult &out_result);
+static void print_filter_run(const char *label, const FilterRunResult &result);
+static void print_filter_drift(const FilterRunResult &reference, const FilterRunResult &result);
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		printf("usage benchmark_kalman_filter <stationary_file.csv> <movement_file.csv> [iteration_count]");
+		return -1;
+	}
+
+	ControllerInputStream stationary_stream(argv[1]);
+	if (stationary_stream.getSampleCount() <= 1)
+	{
+		printf("Stationary file: %s, doesn't contain more than one sample", argv[1]);
+		return -1;
+	}
+
+	ControllerInputStream movement_stream(argv[2]);
+	if (movement_stream.getSampleCount() <= 1)
+	{
+		printf("Movement file: %s, doesn't contain more than one sample", argv[2]);
+		return -1;
+	}
+
+	const int iteration_count = (argc >= 4) ? std::max(atoi(argv[3]), 1) : DEFAULT_ITERATION_COUNT;
+
+	FilterRunResult double_result;
+	FilterRunResult float_result;
+	if (!run_filter(false, iteration_count, stationary_stream, movement_stream, double_result) ||
+		!run_filter(true, iteration_count, stationary_stream, movement_stream, float_result))
+	{
+		printf("Pose kalman filter not supported for this controller type");
+		return -1;
+	}
+
+	printf("%d samples x %d iterations\n", static_cast<int>(movement_stream.getSampleCount()), iteration_count);
+	print_filter_run("double", double_result);
+	print_filter_run("float", float_result);
+	print_filter_drift(double_result, float_result);
+
+	return 0;
+}
+
+//-- private functions -----
+static bool
+run_filter(
+	const bool bUseSinglePrecision,
+	const int iteration_count,
+	const ControllerInputStream &stationary_stream,
+	ControllerInputStream &movement_stream,
+	FilterRunResult &out_result)
+{
+	const CommonDeviceState::eDeviceType controller_type = movement_stream.getControllerType();
+	if (controller_type != CommonDeviceState::PSMove && controller_type != CommonDeviceState::PSDualShock4)
+	{
+		return false;
+	}
+
+	PoseFilterConstants constants;
+	PoseFilterSpace *pose_filter_space =
+		(controller_type == CommonDeviceState::PSMove)
+		? init_filter_constants_for_psmove(stationary_stream, constants)
+		: init_filter_constants_for_psdualshock4(stationary_stream, constants);
+	constants.use_single_precision = bUseSinglePrecision;
+
+	const ControllerSample &initialSample = movement_stream.getSample(0);
+	const Eigen::Vector3f initial_pos(initialSample.pos[0], initialSample.pos[1], initialSample.pos[2]);
+	const Eigen::Quaternionf initial_ori(initialSample.ori[0], initialSample.ori[1], initialSample.ori[2], initialSample.ori[3]);
+	const float initial_dT = stationary_stream.computeMeanTimeDelta();
+
+	out_result.positions_cm.clear();
+	out_result.orientations.clear();
+	out_result.update_count = 0;
+	out_result.update_seconds = 0.0;
+
+	// The first pass records the filter output, the rest only get timed
+	for (int iteration = 0; iteration <= iteration_count; ++iteration)
+	{
+		KalmanPoseFilter *pose_filter = nullptr;
+		if (controller_type == CommonDeviceState::PSMove)
+		{
+			pose_filter = new KalmanPoseFilterPSMove();
+		}
+		else
+		{
+			pose_filter = new KalmanPoseFilterDS4();
+		}
+		pose_filter->init(constants, initial_pos, initial_ori);
+
+		float lastTime = initialSample.time - initial_dT;
+
+		movement_stream.reset();
+		while (movement_stream.hasNext())
+		{
+			const ControllerSample &sample = movement_stream.next();
+			const float dT = sample.time - lastTime;
+			lastTime = sample.time;
+
+			PoseFilterPacket filterPacket;
+			create_filter_packet(sample, pose_filter_space, pose_filter, filterPacket);
+
+			if (iteration == 0)
+			{
+				pose_filter->update(dT, filterPacket);
+
+				out_result.positions_cm.push_back(pose_filter->getPositionCm());
+				out_result.orientations.push_back(pose_filter->getOrientation());
+			}
+			else
+			{
+				const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				pose_filter->update(dT, filterPacket);
+				const std::chrono::duration<double> update_time = std::chrono::high_resolution_clock::now() - start;
+
+				out_result.update_seconds += update_time.count();
+				++out_result.update_count;
+			}
+		}
+
+		delete pose_filter;
+	}
+
+	delete pose_filter_space;
+
+	return true;
+}
+
+static void
+print_filter_run(const char *label, const FilterRunResult &result)
+{
+	const double updates_per_second =
+		(result.update_seconds > 0.0) ? static_cast<double>(result.update_count) / result.update_seconds : 0.0;
+
+	printf("%-6s: %.0f updates/s (%.3f us/update)\n",
+		label, updates_per_second,
+		(result.update_count > 0) ? 1000000.0 * result.update_seconds / static_cast<double>(result.update_count) : 0.0);
+}
+
+static void
+print_filter_drift(const FilterRunResult &reference, const FilterRunResult &result)
+{
+	const size_t sample_count = std::min(reference.positions_cm.size(), result.positions_cm.size());
+	double max_position_error_cm = 0.0, mean_position_error_cm = 0.0;
+	double max_angle_error_deg = 0.0, mean_angle_error_deg = 0.0;
+
+	for (size_t sample_index = 0; sample_index < sample_count; ++sample_index)
+	{
+		const double position_error_cm = (reference.positions_cm[sample_index] - result.positions_cm[sample_index]).norm();
+
+		// Angle of the rotation between the two orientations (q and -q are the same rotation)
+		const double cos_half_angle =
+			std::min(fabs(static_cast<double>(reference.orientations[sample_index].dot(result.orientations[sample_index]))), 1.0);
+		const double angle_error_deg = 2.0 * acos(cos_half_angle) * k_radians_to_degreees;
+
+		max_position_error_cm = std::max(max_position_error_cm, position_error_cm);
+		mean_position_error_cm += position_error_cm;
+		max_angle_error_deg = std::max(max_angle_error_deg, angle_error_deg);
+		mean_angle_error_deg += angle_error_deg;
+	}
+
+	if (sample_count > 0)
+	{
+		mean_position_error_cm /= static_cast<double>(sample_count);
+		mean_angle_error_deg /= static_cast<double>(sample_count);
+	}
+
+	printf("float drift from double: position max %.6f cm, mean %.6f cm; orientation max %.6f deg, mean %.6f deg\n",
+		max_position_error_cm, mean_position_error_cm, max_angle_error_deg, mean_angle_error_deg);
+}
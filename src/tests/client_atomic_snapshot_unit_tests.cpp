@@ -0,0 +1,84 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "ClientAtomicPrimitives.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_client_atomic_snapshot_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("client_atomic_snapshot")
+		UNIT_TEST_MODULE_CALL_TEST(atomic_snapshot_test_empty);
+		UNIT_TEST_MODULE_CALL_TEST(atomic_snapshot_test_latest_value);
+		UNIT_TEST_MODULE_CALL_TEST(atomic_snapshot_test_buffer_rotation);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+atomic_snapshot_test_empty()
+{
+	UNIT_TEST_BEGIN("empty")
+
+	AtomicSnapshot<int> snapshot;
+	int value= -1;
+
+	// Nothing was published yet, so the output is left alone
+	success= !snapshot.fetchValue(value) && value == -1;
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+atomic_snapshot_test_latest_value()
+{
+	UNIT_TEST_BEGIN("latest value")
+
+	AtomicSnapshot<int> snapshot;
+	int value= 0;
+
+	// Only the newest of several stores is visible to the reader
+	snapshot.storeValue(1);
+	snapshot.storeValue(2);
+	snapshot.storeValue(3);
+
+	success= snapshot.fetchValue(value) && value == 3;
+	assert(success);
+
+	// Fetching again without a new store returns the same value
+	if (success)
+	{
+		value= 0;
+		success= snapshot.fetchValue(value) && value == 3;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+atomic_snapshot_test_buffer_rotation()
+{
+	UNIT_TEST_BEGIN("buffer rotation")
+
+	AtomicSnapshot<int> snapshot;
+
+	// Interleave stores and fetches long enough to cycle every buffer through every role
+	for (int iteration = 0; success && iteration < 32; ++iteration)
+	{
+		const int store_count= (iteration % 3) + 1;
+		for (int store_index = 0; store_index < store_count; ++store_index)
+		{
+			snapshot.storeValue(iteration*10 + store_index);
+		}
+
+		int value= -1;
+		success= snapshot.fetchValue(value) && value == iteration*10 + store_count - 1;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
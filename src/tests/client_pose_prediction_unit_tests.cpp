@@ -0,0 +1,169 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "ClientPosePrediction.h"
+#include "unit_test.h"
+
+//-- constants -----
+static const float k_position_tolerance_cm= 0.001f;
+static const float k_quaternion_component_tolerance= 0.0001f;
+
+//-- public interface -----
+bool run_client_pose_prediction_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("client_pose_prediction")
+		UNIT_TEST_MODULE_CALL_TEST(service_clock_test_min_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(service_clock_test_window);
+		UNIT_TEST_MODULE_CALL_TEST(pose_prediction_test_position);
+		UNIT_TEST_MODULE_CALL_TEST(pose_prediction_test_orientation);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+static PSMPosef make_identity_pose()
+{
+	PSMPosef pose;
+	memset(&pose, 0, sizeof(pose));
+	pose.Orientation.w= 1.f;
+
+	return pose;
+}
+
+bool
+service_clock_test_min_round_trip()
+{
+	UNIT_TEST_BEGIN("min round trip")
+
+	// The service clock runs 5s ahead of the client clock
+	const int64_t k_offset_us= 5000000;
+	ServiceClockEstimator estimator;
+
+	success= !estimator.getHasEstimate();
+	assert(success);
+
+	// Slow and lopsided round trip: the response took 8ms longer than the request
+	if (success)
+	{
+		estimator.addSample(1000, 1000 + 1000 + k_offset_us, 1000 + 10000);
+		success= estimator.getHasEstimate() && estimator.getServiceTimeOffsetUs() != k_offset_us;
+		assert(success);
+	}
+
+	// A quick symmetric round trip wins over it
+	if (success)
+	{
+		estimator.addSample(20000, 20000 + 250 + k_offset_us, 20000 + 500);
+		success= 
+			estimator.getServiceTimeOffsetUs() == k_offset_us &&
+			estimator.getRoundTripUs() == 500 &&
+			estimator.clientToServiceTimeUs(100) == 100 + k_offset_us;
+		assert(success);
+	}
+
+	// A later slower round trip doesn't replace it
+	if (success)
+	{
+		estimator.addSample(40000, 40000 + 500 + k_offset_us, 40000 + 3000);
+		success= estimator.getServiceTimeOffsetUs() == k_offset_us;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+service_clock_test_window()
+{
+	UNIT_TEST_BEGIN("sample window")
+
+	ServiceClockEstimator estimator;
+
+	// A quick round trip with the old offset
+	estimator.addSample(0, 1000 + 50, 100);
+
+	// Once it ages out of the window, the best of the newer ones is used
+	for (int sample_index = 0; success && sample_index < SERVICE_CLOCK_SAMPLE_WINDOW_SIZE; ++sample_index)
+	{
+		const int64_t sent_us= 1000000*(sample_index + 1);
+
+		success= estimator.getServiceTimeOffsetUs() == 1000;
+		assert(success);
+
+		estimator.addSample(sent_us, sent_us + 2000 + 100, sent_us + 200);
+	}
+
+	if (success)
+	{
+		success= estimator.getIsSampleWindowFull() && estimator.getServiceTimeOffsetUs() == 2000;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+pose_prediction_test_position()
+{
+	UNIT_TEST_BEGIN("position")
+
+	PSMPhysicsData physics;
+	memset(&physics, 0, sizeof(physics));
+	physics.LinearVelocityCmPerSec.x= 10.f;
+	physics.LinearAccelerationCmPerSecSqr.y= -100.f;
+
+	PSMPosef pose= make_identity_pose();
+	pose.Position.z= 5.f;
+
+	// x: 10*0.1, y: -100*0.1^2/2, z: unchanged
+	const PSMPosef predicted= extrapolatePose(pose, physics, 0.1f);
+
+	success=
+		fabsf(predicted.Position.x - 1.f) < k_position_tolerance_cm &&
+		fabsf(predicted.Position.y - -0.5f) < k_position_tolerance_cm &&
+		fabsf(predicted.Position.z - 5.f) < k_position_tolerance_cm &&
+		predicted.Orientation.w == 1.f;
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+pose_prediction_test_orientation()
+{
+	UNIT_TEST_BEGIN("orientation")
+
+	// Spin a quarter turn per second about the y axis
+	const float k_half_pi= 1.57079633f;
+	PSMPhysicsData physics;
+	memset(&physics, 0, sizeof(physics));
+	physics.AngularVelocityRadPerSec.y= k_half_pi;
+
+	const PSMPosef pose= make_identity_pose();
+	const PSMPosef predicted= extrapolatePose(pose, physics, 1.f);
+	const float half_angle_cos= cosf(0.5f*k_half_pi);
+	const float half_angle_sin= sinf(0.5f*k_half_pi);
+
+	success=
+		fabsf(predicted.Orientation.w - half_angle_cos) < k_quaternion_component_tolerance &&
+		fabsf(predicted.Orientation.x) < k_quaternion_component_tolerance &&
+		fabsf(predicted.Orientation.y - half_angle_sin) < k_quaternion_component_tolerance &&
+		fabsf(predicted.Orientation.z) < k_quaternion_component_tolerance;
+	assert(success);
+
+	// Going back in time undoes it
+	if (success)
+	{
+		const PSMPosef restored= extrapolatePose(predicted, physics, -1.f);
+
+		success=
+			fabsf(restored.Orientation.w - 1.f) < k_quaternion_component_tolerance &&
+			fabsf(restored.Orientation.y) < k_quaternion_component_tolerance;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
@@ -7,11 +7,18 @@
 #include "MathUtility.h"
 #include "unit_test.h"
 
+static Eigen::Matrix<float, 3, 4>
+math_alignment_make_camera_projection_matrix(const float yaw_radians, const Eigen::Vector3f &camera_position);
+static Eigen::Vector2f
+math_alignment_project_point(const Eigen::Matrix<float, 3, 4> &projection_matrix, const Eigen::Vector3f &point);
+
 //-- public interface -----
 bool run_math_alignment_unit_tests()
 {
 	UNIT_TEST_MODULE_BEGIN("math_alignment")
 		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_best_fit_exponential);
+		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_triangulate_n_view);
+		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_triangulate_n_view_weights);
 	UNIT_TEST_MODULE_END()
 }
 
@@ -46,4 +53,122 @@ math_alignment_test_best_fit_exponential()
 	assert(success);	
 	
 	UNIT_TEST_COMPLETE()
-}
\ No newline at end of file
+}
+
+bool
+math_alignment_test_triangulate_n_view()
+{
+	UNIT_TEST_BEGIN("triangulate_n_view")
+
+	const int k_view_count = 3;
+	const Eigen::Matrix<float, 3, 4> projection_matrices[k_view_count] = {
+		math_alignment_make_camera_projection_matrix(0.f, Eigen::Vector3f(0.f, 20.f, -150.f)),
+		math_alignment_make_camera_projection_matrix(k_real_quarter_pi, Eigen::Vector3f(-110.f, 30.f, -110.f)),
+		math_alignment_make_camera_projection_matrix(-k_real_quarter_pi, Eigen::Vector3f(110.f, 10.f, -110.f))
+	};
+	const Eigen::Vector3f point(5.f, -10.f, 20.f);
+
+	Eigen::Vector2f screen_locations[k_view_count];
+	for (int view_index = 0; view_index < k_view_count; ++view_index)
+	{
+		screen_locations[view_index] = math_alignment_project_point(projection_matrices[view_index], point);
+	}
+
+	// Exact projections give back the point, with or without refinement
+	Eigen::Vector3f position;
+	success = eigen_alignment_triangulate_weighted_n_view(projection_matrices, screen_locations, nullptr, k_view_count, 0, &position);
+	assert(success);
+	success = position.isApprox(point, k_positional_epsilon);
+	assert(success);
+
+	success = eigen_alignment_triangulate_weighted_n_view(projection_matrices, screen_locations, nullptr, k_view_count, 3, &position);
+	assert(success);
+	success = position.isApprox(point, k_positional_epsilon);
+	assert(success);
+
+	// Noisy projections still land close to the point
+	screen_locations[0] += Eigen::Vector2f(0.5f, -0.5f);
+	screen_locations[1] += Eigen::Vector2f(-0.5f, 0.25f);
+	screen_locations[2] += Eigen::Vector2f(0.25f, 0.5f);
+	success = eigen_alignment_triangulate_weighted_n_view(projection_matrices, screen_locations, nullptr, k_view_count, 3, &position);
+	assert(success);
+	success = (position - point).norm() < 1.f;
+	assert(success);
+
+	// One view isn't enough
+	success = !eigen_alignment_triangulate_weighted_n_view(projection_matrices, screen_locations, nullptr, 1, 3, &position);
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+math_alignment_test_triangulate_n_view_weights()
+{
+	UNIT_TEST_BEGIN("triangulate_n_view_weights")
+
+	const int k_view_count = 3;
+	const Eigen::Matrix<float, 3, 4> projection_matrices[k_view_count] = {
+		math_alignment_make_camera_projection_matrix(0.f, Eigen::Vector3f(0.f, 20.f, -150.f)),
+		math_alignment_make_camera_projection_matrix(k_real_quarter_pi, Eigen::Vector3f(-110.f, 30.f, -110.f)),
+		math_alignment_make_camera_projection_matrix(-k_real_quarter_pi, Eigen::Vector3f(110.f, 10.f, -110.f))
+	};
+	const Eigen::Vector3f point(-15.f, 5.f, 0.f);
+
+	Eigen::Vector2f screen_locations[k_view_count];
+	for (int view_index = 0; view_index < k_view_count; ++view_index)
+	{
+		screen_locations[view_index] = math_alignment_project_point(projection_matrices[view_index], point);
+	}
+
+	// A wildly wrong view with no weight is ignored
+	screen_locations[2] += Eigen::Vector2f(80.f, -60.f);
+	float weights[k_view_count] = { 1.f, 1.f, 0.f };
+
+	Eigen::Vector3f position;
+	success = eigen_alignment_triangulate_weighted_n_view(projection_matrices, screen_locations, weights, k_view_count, 3, &position);
+	assert(success);
+	success = position.isApprox(point, k_positional_epsilon);
+	assert(success);
+
+	// With a small weight it only pulls the result a little
+	weights[2] = 0.01f;
+	Eigen::Vector3f weighted_position;
+	success = eigen_alignment_triangulate_weighted_n_view(projection_matrices, screen_locations, weights, k_view_count, 3, &weighted_position);
+	assert(success);
+
+	Eigen::Vector3f unweighted_position;
+	success = eigen_alignment_triangulate_weighted_n_view(projection_matrices, screen_locations, nullptr, k_view_count, 3, &unweighted_position);
+	assert(success);
+	success = (weighted_position - point).norm() < (unweighted_position - point).norm();
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+// Pinhole camera at camera_position turned yaw_radians about +Y, looking down its +Z axis
+static Eigen::Matrix<float, 3, 4>
+math_alignment_make_camera_projection_matrix(const float yaw_radians, const Eigen::Vector3f &camera_position)
+{
+	Eigen::Matrix3f intrinsic_matrix;
+	intrinsic_matrix <<
+		550.f, 0.f, 320.f,
+		0.f, -550.f, 240.f,
+		0.f, 0.f, 1.f;
+
+	const Eigen::Matrix3f world_to_camera = eigen_quaternion_angle_axis(yaw_radians, Eigen::Vector3f::UnitY()).toRotationMatrix().transpose();
+
+	Eigen::Matrix<float, 3, 4> extrinsic_matrix;
+	extrinsic_matrix.leftCols<3>() = world_to_camera;
+	extrinsic_matrix.col(3) = -world_to_camera * camera_position;
+
+	return intrinsic_matrix * extrinsic_matrix;
+}
+
+static Eigen::Vector2f
+math_alignment_project_point(const Eigen::Matrix<float, 3, 4> &projection_matrix, const Eigen::Vector3f &point)
+{
+	const Eigen::Vector3f h = projection_matrix * point.homogeneous();
+
+	return h.head<2>() / h.z();
+}
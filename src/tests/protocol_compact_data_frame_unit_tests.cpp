@@ -0,0 +1,182 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "CompactDataFrame.h"
+#include "unit_test.h"
+
+//-- constants -----
+// Half of a quantization step of each field, plus float rounding slop
+static const float k_quaternion_component_tolerance= 0.002f;
+static const float k_position_tolerance= 0.5f*COMPACT_DATA_FRAME_POSITION_CM_PER_UNIT + 0.0001f;
+static const float k_velocity_tolerance= 0.5f*COMPACT_DATA_FRAME_VELOCITY_CM_PER_UNIT + 0.0001f;
+
+//-- public interface -----
+bool run_protocol_compact_data_frame_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("protocol_compact_data_frame")
+		UNIT_TEST_MODULE_CALL_TEST(compact_data_frame_test_quaternion_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(compact_data_frame_test_controller_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(compact_data_frame_test_unpack);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+static bool is_same_rotation(const float a[4], const float b[4], float tolerance)
+{
+	// q and -q are the same rotation
+	const float dot= a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+	const float sign= (dot < 0.f) ? -1.f : 1.f;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		if (fabsf(a[i] - sign*b[i]) > tolerance)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+compact_data_frame_test_quaternion_round_trip()
+{
+	UNIT_TEST_BEGIN("quaternion round trip")
+
+	// Sweep rotations about a tilted axis, which makes each component the largest one at some point
+	const float axis_length= sqrtf(1.f + 4.f + 9.f);
+	const float axis[3]= {1.f/axis_length, -2.f/axis_length, 3.f/axis_length};
+
+	for (float angle = -6.28f; success && angle <= 6.28f; angle += 0.05f)
+	{
+		const float s= sinf(0.5f*angle);
+		const float q[4]= {cosf(0.5f*angle), axis[0]*s, axis[1]*s, axis[2]*s};
+		float decoded[4];
+
+		CompactDataFrame::decodeQuaternion(CompactDataFrame::encodeQuaternion(q), decoded);
+
+		success= is_same_rotation(q, decoded, k_quaternion_component_tolerance);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+compact_data_frame_test_controller_round_trip()
+{
+	UNIT_TEST_BEGIN("controller round trip")
+
+	SharedControllerState state;
+	memset(&state, 0, sizeof(state));
+	state.controller_type= 2; // DualShock4
+	state.sequence_num= 1234;
+	state.state_flags= SharedDeviceStateFlag_IsConnected | SharedDeviceStateFlag_IsPositionValid;
+	state.button_down_bitmask= 0x5;
+	state.orientation[0]= 0.5f;
+	state.orientation[1]= 0.5f;
+	state.orientation[2]= -0.5f;
+	state.orientation[3]= 0.5f;
+	state.position_cm[0]= 12.34f;
+	state.position_cm[1]= -150.02f;
+	state.position_cm[2]= 300.f;
+	state.physics.velocity_cm_per_sec[0]= -42.17f;
+	state.analog_values[0]= -1.f;
+	state.analog_values[1]= 1.f;
+	state.analog_values[4]= 0.5f;
+	state.sample_time_us= 123456789012LL;
+	state.prediction_time= 0.02f;
+
+	CompactDataFrame frame;
+	frame.encodeControllerState(3, state, true);
+
+	SharedControllerState decoded;
+	frame.decodeControllerState(decoded);
+
+	success= frame.device_category == CompactDataFrameDevice_Controller && frame.device_id == 3;
+	assert(success);
+
+	if (success)
+	{
+		success=
+			decoded.controller_type == state.controller_type &&
+			decoded.sequence_num == state.sequence_num &&
+			decoded.state_flags == state.state_flags &&
+			decoded.button_down_bitmask == state.button_down_bitmask &&
+			decoded.sample_time_us == state.sample_time_us &&
+			decoded.prediction_time == state.prediction_time;
+		assert(success);
+	}
+
+	if (success)
+	{
+		success= is_same_rotation(state.orientation, decoded.orientation, k_quaternion_component_tolerance);
+		assert(success);
+	}
+
+	for (int i = 0; success && i < 3; ++i)
+	{
+		success= fabsf(state.position_cm[i] - decoded.position_cm[i]) <= k_position_tolerance;
+		assert(success);
+	}
+
+	if (success)
+	{
+		success= fabsf(state.physics.velocity_cm_per_sec[0] - decoded.physics.velocity_cm_per_sec[0]) <= k_velocity_tolerance;
+		assert(success);
+	}
+
+	// DualShock4 analog values are quantized to a byte (a stick step is 2/255)
+	for (int i = 0; success && i < SHARED_CONTROLLER_ANALOG_VALUE_COUNT; ++i)
+	{
+		success= fabsf(state.analog_values[i] - decoded.analog_values[i]) <= 2.f/255.f;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+compact_data_frame_test_unpack()
+{
+	UNIT_TEST_BEGIN("unpack")
+
+	SharedHMDState state;
+	memset(&state, 0, sizeof(state));
+	state.hmd_type= 0; // Morpheus
+	state.orientation[0]= 1.f;
+
+	CompactDataFrame frame;
+	frame.encodeHmdState(1, state, false);
+
+	uint8_t buffer[sizeof(CompactDataFrame)];
+	memcpy(buffer, &frame, sizeof(frame));
+
+	CompactDataFrame unpacked;
+	success=
+		CompactDataFrame::isCompactDataFrame(buffer, sizeof(buffer)) &&
+		CompactDataFrame::unpack(buffer, sizeof(buffer), unpacked) &&
+		(unpacked.section_flags & CompactDataFrameSection_Physics) == 0;
+	assert(success);
+
+	// Truncated frames are rejected
+	if (success)
+	{
+		success= !CompactDataFrame::unpack(buffer, sizeof(buffer) - 1, unpacked);
+		assert(success);
+	}
+
+	// So are protobuf data frames, which start with a zero length byte
+	if (success)
+	{
+		buffer[0]= 0;
+		success= !CompactDataFrame::isCompactDataFrame(buffer, sizeof(buffer));
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,131 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string>
+
+#include "ProtocolMessagePool.h"
+#include "unit_test.h"
+
+//-- definitions -----
+// Stands in for a protobuf message, which is all the pool needs
+struct TestMessage
+{
+	int value;
+	std::string text;
+
+	TestMessage() : value(0), text() {}
+
+	void Clear()
+	{
+		value= 0;
+		text.clear();
+	}
+};
+
+//-- public interface -----
+bool run_protocol_message_pool_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("protocol_message_pool")
+		UNIT_TEST_MODULE_CALL_TEST(protocol_message_pool_test_reuse);
+		UNIT_TEST_MODULE_CALL_TEST(protocol_message_pool_test_in_use);
+		UNIT_TEST_MODULE_CALL_TEST(protocol_message_pool_test_capacity);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+protocol_message_pool_test_reuse()
+{
+	UNIT_TEST_BEGIN("reuse")
+
+	ProtocolMessagePool<TestMessage> pool(4);
+	const TestMessage *first_message= nullptr;
+
+	{
+		std::shared_ptr<TestMessage> message= pool.acquire();
+		message->value= 42;
+		message->text= "a string long enough to live on the heap";
+		first_message= message.get();
+	}
+
+	// Once released the same message comes back, cleared
+	const uint64_t global_count= getProtocolMessagePoolMissCounter().load();
+	for (int tick = 0; success && tick < 100; ++tick)
+	{
+		std::shared_ptr<TestMessage> message= pool.acquire();
+
+		success= message.get() == first_message && message->value == 0 && message->text.empty();
+		assert(success);
+	}
+
+	if (success)
+	{
+		success= 
+			pool.getAllocationCount() == 1 &&
+			getProtocolMessagePoolMissCounter().load() == global_count;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+protocol_message_pool_test_in_use()
+{
+	UNIT_TEST_BEGIN("in use")
+
+	ProtocolMessagePool<TestMessage> pool(4);
+
+	std::shared_ptr<TestMessage> held_message= pool.acquire();
+	held_message->value= 7;
+
+	// Messages someone still references never get handed out again
+	std::shared_ptr<TestMessage> other_message= pool.acquire();
+	success= other_message != held_message && held_message->value == 7;
+	assert(success);
+
+	if (success)
+	{
+		other_message.reset();
+
+		std::shared_ptr<TestMessage> message= pool.acquire();
+		success= message != held_message && pool.getAllocationCount() == 2;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+protocol_message_pool_test_capacity()
+{
+	UNIT_TEST_BEGIN("capacity")
+
+	ProtocolMessagePool<TestMessage> pool(2);
+	std::shared_ptr<TestMessage> messages[3];
+
+	// Past capacity the pool still hands out messages, it just doesn't keep them
+	for (int i = 0; i < 3; ++i)
+	{
+		messages[i]= pool.acquire();
+	}
+
+	success= pool.getPooledMessageCount() == 2 && pool.getAllocationCount() == 3;
+	assert(success);
+
+	if (success)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			messages[i].reset();
+		}
+
+		pool.acquire();
+		pool.acquire();
+		success= pool.getAllocationCount() == 3;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,97 @@
+#ifndef RECORDING_TEST_UTILS_H
+#define RECORDING_TEST_UTILS_H
+
+// Helpers the tracker frame and HID packet recording tests share
+
+//-- includes -----
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+//-- utility methods -----
+/// A recording path in the temp folder that no other test run uses, e.g. "tracker_recording_test_1a2b-3c4d.psmrec"
+inline std::string make_temp_recording_path(const std::string &name_prefix, const std::string &extension)
+{
+	const boost::filesystem::path path=
+		boost::filesystem::temp_directory_path() /
+		boost::filesystem::unique_path(name_prefix + "_%%%%-%%%%" + extension);
+
+	return path.string();
+}
+
+/// Fills in the contents of the given recorded sample (frame pixels or HID report),
+/// so that the reader side can tell every sample and every byte apart
+inline void fill_test_sample(int sample_index, size_t sample_size, std::vector<unsigned char> &out_sample)
+{
+	out_sample.resize(sample_size);
+
+	for (size_t byte_index = 0; byte_index < sample_size; ++byte_index)
+	{
+		out_sample[byte_index]= static_cast<unsigned char>(sample_index*31 + byte_index*7 + 1);
+	}
+}
+
+/// True if a sample read back from a recording is the one fill_test_sample() wrote
+inline bool check_test_sample(int sample_index, size_t expected_size, const unsigned char *sample, size_t sample_size)
+{
+	std::vector<unsigned char> expected_sample;
+	fill_test_sample(sample_index, expected_size, expected_sample);
+
+	return
+		sample != nullptr &&
+		sample_size == expected_size &&
+		(sample_size == 0 || memcmp(sample, expected_sample.data(), sample_size) == 0);
+}
+
+/// Cuts bytes off the end of the recording, as if the service died while recording
+inline void truncate_test_recording(const std::string &path, uintmax_t cut_size)
+{
+	const uintmax_t file_size= boost::filesystem::file_size(path);
+
+	boost::filesystem::resize_file(path, file_size - cut_size);
+}
+
+/// Checks that the reader turns down the recording at the given path once its magic is stomped on,
+/// and a missing recording. Deletes the recording.
+template <typename t_recording_reader>
+bool check_reader_rejects_bad_header(const std::string &path)
+{
+	bool success;
+
+	{
+		FILE *file= fopen(path.c_str(), "r+b");
+
+		success= file != nullptr;
+		if (success)
+		{
+			fputs("NOTAREC", file);
+			fclose(file);
+		}
+	}
+
+	if (success)
+	{
+		t_recording_reader reader;
+
+		success= !reader.open(path) && !reader.getIsOpen();
+	}
+
+	if (success)
+	{
+		t_recording_reader reader;
+
+		boost::filesystem::remove(path);
+		success= !reader.open(path) && !reader.getIsOpen();
+	}
+
+	boost::filesystem::remove(path);
+
+	return success;
+}
+
+#endif // RECORDING_TEST_UTILS_H
@@ -0,0 +1,299 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <vector>
+
+#include "ColorMembershipCube.h"
+#include "HSVColorClassifier.h"
+#include "unit_test.h"
+
+//-- constants -----
+static const int k_red_cell_count= 1 << ColorMembershipCube::k_red_bits;
+static const int k_green_cell_count= 1 << ColorMembershipCube::k_green_bits;
+static const int k_blue_cell_count= 1 << ColorMembershipCube::k_blue_bits;
+// Not a multiple of the blue cell count, so the OR test rows don't line up with the cube's runs
+static const int k_frame_pixel_count= 4099;
+
+//-- prototypes -----
+static void build_cell_center_frame(std::vector<uint8_t> &out_bgr_frame);
+static void build_random_cell_center_frame(std::vector<uint8_t> &out_bgr_frame);
+static uint8_t compute_cell_center(int cell, int channel_bits);
+static int build_test_bounds(HSVColorClassifierBounds *out_bounds);
+static void set_bounds(
+	HSVColorClassifierBounds &bounds,
+	int hue_min0, int hue_max0, int hue_min1, int hue_max1,
+	int saturation_min, int saturation_max, int value_min, int value_max,
+	int mask_bit_index);
+static bool check_mask_hits_and_misses(const std::vector<uint8_t> &mask);
+
+//-- public interface -----
+bool run_service_color_membership_cube_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_color_membership_cube")
+		UNIT_TEST_MODULE_CALL_TEST(color_membership_cube_test_cell_centers);
+		UNIT_TEST_MODULE_CALL_TEST(color_membership_cube_test_multiple_cubes);
+		UNIT_TEST_MODULE_CALL_TEST(color_membership_cube_test_rebuild);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+color_membership_cube_test_cell_centers()
+{
+	UNIT_TEST_BEGIN("cell centers")
+
+	// Every cell's center color, which the cube classifies exactly like the HSV classifier
+	std::vector<uint8_t> bgr_frame;
+	build_cell_center_frame(bgr_frame);
+	const int pixel_count= static_cast<int>(bgr_frame.size() / 3);
+
+	HSVColorClassifierBounds bounds[HSV_COLOR_CLASSIFIER_MAX_BOUNDS];
+	const int bounds_count= build_test_bounds(bounds);
+
+	std::vector<uint8_t> classifier_mask(pixel_count);
+	std::vector<uint8_t> cube_mask(pixel_count);
+	ColorMembershipCube *cube= new ColorMembershipCube();
+
+	for (int bounds_index = 0; success && bounds_index < bounds_count; ++bounds_index)
+	{
+		const HSVColorClassifierBounds &test_bounds= bounds[bounds_index];
+		const ColorMembershipCube *cubes[1]= { cube };
+		const uint8_t mask_bits[1]= { test_bounds.mask_bits };
+
+		HSVColorClassifier::classify_bgr_row(
+			bgr_frame.data(), classifier_mask.data(), pixel_count, &test_bounds, 1);
+
+		cube->rebuild(test_bounds);
+		memset(cube_mask.data(), 0xcd, cube_mask.size());
+		ColorMembershipCube::classify_bgr_row(
+			bgr_frame.data(), cube_mask.data(), pixel_count, cubes, mask_bits, 1);
+
+		success= memcmp(classifier_mask.data(), cube_mask.data(), classifier_mask.size()) == 0;
+		assert(success);
+	}
+
+	delete cube;
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+color_membership_cube_test_multiple_cubes()
+{
+	UNIT_TEST_BEGIN("multiple cubes")
+
+	std::vector<uint8_t> bgr_frame;
+	build_random_cell_center_frame(bgr_frame);
+
+	HSVColorClassifierBounds bounds[HSV_COLOR_CLASSIFIER_MAX_BOUNDS];
+	const int bounds_count= build_test_bounds(bounds);
+
+	// One cube per bounds, each with its own mask bit, the way the tracker segments all tracking colors at once
+	std::vector<ColorMembershipCube> cube_storage(bounds_count);
+	const ColorMembershipCube *cubes[HSV_COLOR_CLASSIFIER_MAX_BOUNDS];
+	uint8_t mask_bits[HSV_COLOR_CLASSIFIER_MAX_BOUNDS];
+	for (int bounds_index = 0; bounds_index < bounds_count; ++bounds_index)
+	{
+		cube_storage[bounds_index].rebuild(bounds[bounds_index]);
+		cubes[bounds_index]= &cube_storage[bounds_index];
+		mask_bits[bounds_index]= bounds[bounds_index].mask_bits;
+	}
+
+	std::vector<uint8_t> classifier_mask(k_frame_pixel_count);
+	std::vector<uint8_t> cube_mask(k_frame_pixel_count);
+
+	HSVColorClassifier::classify_bgr_row(
+		bgr_frame.data(), classifier_mask.data(), k_frame_pixel_count, bounds, bounds_count);
+
+	memset(cube_mask.data(), 0xcd, cube_mask.size());
+	ColorMembershipCube::classify_bgr_row(
+		bgr_frame.data(), cube_mask.data(), k_frame_pixel_count, cubes, mask_bits, bounds_count);
+
+	success= memcmp(classifier_mask.data(), cube_mask.data(), classifier_mask.size()) == 0;
+	assert(success);
+
+	// Some pixels should fall in more than one cube, otherwise the OR isn't tested
+	if (success)
+	{
+		bool bAnyOverlap= false;
+		for (const uint8_t mask : cube_mask)
+		{
+			bAnyOverlap|= (mask & (mask - 1)) != 0;
+		}
+
+		success= bAnyOverlap && check_mask_hits_and_misses(cube_mask);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+color_membership_cube_test_rebuild()
+{
+	UNIT_TEST_BEGIN("rebuild")
+
+	HSVColorClassifierBounds bounds[HSV_COLOR_CLASSIFIER_MAX_BOUNDS];
+	build_test_bounds(bounds);
+
+	const HSVColorClassifierBounds &old_bounds= bounds[1];
+	ColorMembershipCube *cube= new ColorMembershipCube();
+
+	// A new cube has no bounds, so it always gets built before it's used
+	success= !cube->getHasBounds(old_bounds);
+	assert(success);
+
+	if (success)
+	{
+		cube->rebuild(old_bounds);
+
+		// The mask bits aren't part of the cube
+		HSVColorClassifierBounds other_mask_bounds= old_bounds;
+		other_mask_bounds.mask_bits= 0x80;
+
+		success= cube->getHasBounds(old_bounds) && cube->getHasBounds(other_mask_bounds);
+		assert(success);
+	}
+
+	// Changing any one of the bounds has to invalidate the cube
+	for (int field_index = 0; success && field_index < 8; ++field_index)
+	{
+		HSVColorClassifierBounds changed_bounds= old_bounds;
+		uint8_t *fields[8]= {
+			&changed_bounds.hue_min[0], &changed_bounds.hue_max[0],
+			&changed_bounds.hue_min[1], &changed_bounds.hue_max[1],
+			&changed_bounds.saturation_min, &changed_bounds.saturation_max,
+			&changed_bounds.value_min, &changed_bounds.value_max
+		};
+		*fields[field_index]+= 1;
+
+		success= !cube->getHasBounds(changed_bounds);
+		assert(success);
+	}
+
+	// Once rebuilt for the new bounds, the cube classifies against them and not the old ones
+	if (success)
+	{
+		const HSVColorClassifierBounds &new_bounds= bounds[2];
+
+		std::vector<uint8_t> bgr_frame;
+		build_cell_center_frame(bgr_frame);
+		const int pixel_count= static_cast<int>(bgr_frame.size() / 3);
+
+		std::vector<uint8_t> classifier_mask(pixel_count);
+		std::vector<uint8_t> cube_mask(pixel_count);
+		const ColorMembershipCube *cubes[1]= { cube };
+		const uint8_t mask_bits[1]= { new_bounds.mask_bits };
+
+		cube->rebuild(new_bounds);
+
+		HSVColorClassifier::classify_bgr_row(
+			bgr_frame.data(), classifier_mask.data(), pixel_count, &new_bounds, 1);
+		ColorMembershipCube::classify_bgr_row(
+			bgr_frame.data(), cube_mask.data(), pixel_count, cubes, mask_bits, 1);
+
+		success=
+			cube->getHasBounds(new_bounds) && !cube->getHasBounds(old_bounds) &&
+			memcmp(classifier_mask.data(), cube_mask.data(), classifier_mask.size()) == 0 &&
+			check_mask_hits_and_misses(cube_mask);
+		assert(success);
+	}
+
+	delete cube;
+
+	UNIT_TEST_COMPLETE()
+}
+
+static void build_cell_center_frame(std::vector<uint8_t> &out_bgr_frame)
+{
+	out_bgr_frame.resize(ColorMembershipCube::k_cell_count*3);
+
+	uint8_t *bgr= out_bgr_frame.data();
+	for (int red_cell = 0; red_cell < k_red_cell_count; ++red_cell)
+	{
+		for (int green_cell = 0; green_cell < k_green_cell_count; ++green_cell)
+		{
+			for (int blue_cell = 0; blue_cell < k_blue_cell_count; ++blue_cell)
+			{
+				bgr[0]= compute_cell_center(blue_cell, ColorMembershipCube::k_blue_bits);
+				bgr[1]= compute_cell_center(green_cell, ColorMembershipCube::k_green_bits);
+				bgr[2]= compute_cell_center(red_cell, ColorMembershipCube::k_red_bits);
+				bgr+= 3;
+			}
+		}
+	}
+}
+
+static void build_random_cell_center_frame(std::vector<uint8_t> &out_bgr_frame)
+{
+	out_bgr_frame.resize(k_frame_pixel_count*3);
+
+	uint32_t seed= 12345;
+	for (int pixel_index = 0; pixel_index < k_frame_pixel_count; ++pixel_index)
+	{
+		uint8_t *bgr= &out_bgr_frame[pixel_index*3];
+
+		// Fixed LCG so the frame is the same on every run
+		seed= seed*1664525u + 1013904223u;
+		bgr[0]= compute_cell_center((seed >> 24) % k_blue_cell_count, ColorMembershipCube::k_blue_bits);
+		bgr[1]= compute_cell_center((seed >> 16) % k_green_cell_count, ColorMembershipCube::k_green_bits);
+		bgr[2]= compute_cell_center((seed >> 8) % k_red_cell_count, ColorMembershipCube::k_red_bits);
+	}
+}
+
+static uint8_t compute_cell_center(int cell, int channel_bits)
+{
+	return static_cast<uint8_t>((cell << (8 - channel_bits)) | (1 << (7 - channel_bits)));
+}
+
+static int build_test_bounds(HSVColorClassifierBounds *out_bounds)
+{
+	int bounds_count= 0;
+
+	// Tracking color style bounds: red wraps around the hue circle, the rest don't
+	set_bounds(out_bounds[bounds_count], 0, 10, 170, 180, 80, 255, 40, 255, bounds_count); ++bounds_count;
+	set_bounds(out_bounds[bounds_count], 50, 70, 1, 0, 80, 255, 40, 255, bounds_count); ++bounds_count;
+	set_bounds(out_bounds[bounds_count], 110, 130, 1, 0, 80, 255, 40, 255, bounds_count); ++bounds_count;
+	set_bounds(out_bounds[bounds_count], 80, 100, 1, 0, 30, 200, 100, 220, bounds_count); ++bounds_count;
+	// Wide bounds that overlap the ones above
+	set_bounds(out_bounds[bounds_count], 0, 180, 1, 0, 60, 255, 60, 255, bounds_count); ++bounds_count;
+	// Grays only: any hue, low saturation
+	set_bounds(out_bounds[bounds_count], 0, 180, 1, 0, 0, 20, 0, 255, bounds_count); ++bounds_count;
+
+	assert(bounds_count <= HSV_COLOR_CLASSIFIER_MAX_BOUNDS);
+
+	return bounds_count;
+}
+
+static void set_bounds(
+	HSVColorClassifierBounds &bounds,
+	int hue_min0, int hue_max0, int hue_min1, int hue_max1,
+	int saturation_min, int saturation_max, int value_min, int value_max,
+	int mask_bit_index)
+{
+	bounds.hue_min[0]= static_cast<uint8_t>(hue_min0);
+	bounds.hue_max[0]= static_cast<uint8_t>(hue_max0);
+	bounds.hue_min[1]= static_cast<uint8_t>(hue_min1);
+	bounds.hue_max[1]= static_cast<uint8_t>(hue_max1);
+	bounds.saturation_min= static_cast<uint8_t>(saturation_min);
+	bounds.saturation_max= static_cast<uint8_t>(saturation_max);
+	bounds.value_min= static_cast<uint8_t>(value_min);
+	bounds.value_max= static_cast<uint8_t>(value_max);
+	bounds.mask_bits= static_cast<uint8_t>(1 << mask_bit_index);
+}
+
+// Matching masks prove nothing unless the pixels both hit and miss the bounds
+static bool check_mask_hits_and_misses(const std::vector<uint8_t> &mask)
+{
+	bool bAnyHit= false;
+	bool bAnyMiss= false;
+	for (const uint8_t value : mask)
+	{
+		bAnyHit|= value != 0;
+		bAnyMiss|= value == 0;
+	}
+
+	return bAnyHit && bAnyMiss;
+}
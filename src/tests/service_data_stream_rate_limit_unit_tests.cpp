@@ -0,0 +1,200 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "DataStreamRateLimit.h"
+#include "unit_test.h"
+
+//-- constants -----
+// 100Hz, one state every 10ms
+static const float k_publish_rate_hz= 100.f;
+static const int k_publish_interval_ms= 10;
+
+//-- private definitions -----
+typedef DataStreamRateLimit::t_time_point t_time_point;
+
+// The rate limit fields of a ControllerStreamInfo/HMDStreamInfo
+struct TestStreamInfo
+{
+	bool has_deferred_publish;
+	float publish_rate_hz;
+	t_time_point last_publish_timestamp;
+
+	inline void Clear()
+	{
+		has_deferred_publish= false;
+		publish_rate_hz= 0.f;
+		last_publish_timestamp= t_time_point();
+	}
+};
+
+//-- private methods -----
+static t_time_point time_at_ms(int time_ms);
+
+//-- public interface -----
+bool run_service_data_stream_rate_limit_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_data_stream_rate_limit")
+		UNIT_TEST_MODULE_CALL_TEST(data_stream_rate_limit_test_unlimited_stream);
+		UNIT_TEST_MODULE_CALL_TEST(data_stream_rate_limit_test_publish_window);
+		UNIT_TEST_MODULE_CALL_TEST(data_stream_rate_limit_test_deferred_streams_only);
+		UNIT_TEST_MODULE_CALL_TEST(data_stream_rate_limit_test_earliest_deadline);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+data_stream_rate_limit_test_unlimited_stream()
+{
+	UNIT_TEST_BEGIN("unlimited stream")
+
+	TestStreamInfo stream_info;
+	stream_info.Clear();
+
+	// Every state goes out, however close together, and nothing gets deferred
+	for (int time_ms = 0; success && time_ms < 5; ++time_ms)
+	{
+		t_time_point deferred_deadline= t_time_point::max();
+
+		success=
+			DataStreamRateLimit::is_stream_publish_due(stream_info, time_at_ms(time_ms), false, deferred_deadline) &&
+			!stream_info.has_deferred_publish &&
+			stream_info.last_publish_timestamp == time_at_ms(time_ms) &&
+			deferred_deadline == t_time_point::max();
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_stream_rate_limit_test_publish_window()
+{
+	UNIT_TEST_BEGIN("publish window")
+
+	TestStreamInfo stream_info;
+	stream_info.Clear();
+	stream_info.publish_rate_hz= k_publish_rate_hz;
+
+	t_time_point deferred_deadline= t_time_point::max();
+
+	success= DataStreamRateLimit::is_stream_publish_due(stream_info, time_at_ms(1000), false, deferred_deadline);
+	assert(success);
+
+	// Too soon: skipped, flagged as deferred, due one interval after the last publish
+	if (success)
+	{
+		success=
+			!DataStreamRateLimit::is_stream_publish_due(stream_info, time_at_ms(1004), false, deferred_deadline) &&
+			stream_info.has_deferred_publish &&
+			stream_info.last_publish_timestamp == time_at_ms(1000) &&
+			deferred_deadline == time_at_ms(1000 + k_publish_interval_ms);
+		assert(success);
+	}
+
+	// Due at the deadline, which clears the deferred flag and restarts the window
+	if (success)
+	{
+		deferred_deadline= t_time_point::max();
+
+		success=
+			DataStreamRateLimit::is_stream_publish_due(stream_info, time_at_ms(1000 + k_publish_interval_ms), false, deferred_deadline) &&
+			!stream_info.has_deferred_publish &&
+			stream_info.last_publish_timestamp == time_at_ms(1000 + k_publish_interval_ms) &&
+			deferred_deadline == t_time_point::max();
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_stream_rate_limit_test_deferred_streams_only()
+{
+	UNIT_TEST_BEGIN("deferred streams only")
+
+	TestStreamInfo up_to_date_stream;
+	up_to_date_stream.Clear();
+	up_to_date_stream.publish_rate_hz= k_publish_rate_hz;
+	up_to_date_stream.last_publish_timestamp= time_at_ms(1000);
+
+	TestStreamInfo deferred_stream;
+	deferred_stream.Clear();
+	deferred_stream.publish_rate_hz= k_publish_rate_hz;
+	deferred_stream.last_publish_timestamp= time_at_ms(1000);
+	deferred_stream.has_deferred_publish= true;
+
+	t_time_point deferred_deadline= t_time_point::max();
+
+	// A re-publish leaves streams that already got the state alone, even once their window is up
+	success=
+		!DataStreamRateLimit::is_stream_publish_due(up_to_date_stream, time_at_ms(1020), true, deferred_deadline) &&
+		!up_to_date_stream.has_deferred_publish &&
+		up_to_date_stream.last_publish_timestamp == time_at_ms(1000) &&
+		deferred_deadline == t_time_point::max();
+	assert(success);
+
+	// A deferred stream that still isn't due stays deferred
+	if (success)
+	{
+		success=
+			!DataStreamRateLimit::is_stream_publish_due(deferred_stream, time_at_ms(1005), true, deferred_deadline) &&
+			deferred_stream.has_deferred_publish &&
+			deferred_deadline == time_at_ms(1000 + k_publish_interval_ms);
+		assert(success);
+	}
+
+	// Once due it gets the skipped state
+	if (success)
+	{
+		deferred_deadline= t_time_point::max();
+
+		success=
+			DataStreamRateLimit::is_stream_publish_due(deferred_stream, time_at_ms(1012), true, deferred_deadline) &&
+			!deferred_stream.has_deferred_publish &&
+			deferred_stream.last_publish_timestamp == time_at_ms(1012) &&
+			deferred_deadline == t_time_point::max();
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_stream_rate_limit_test_earliest_deadline()
+{
+	UNIT_TEST_BEGIN("earliest deadline")
+
+	TestStreamInfo slow_stream;
+	slow_stream.Clear();
+	slow_stream.publish_rate_hz= k_publish_rate_hz / 2.f;
+	slow_stream.last_publish_timestamp= time_at_ms(1000);
+
+	TestStreamInfo fast_stream;
+	fast_stream.Clear();
+	fast_stream.publish_rate_hz= k_publish_rate_hz;
+	fast_stream.last_publish_timestamp= time_at_ms(1000);
+
+	TestStreamInfo unlimited_stream;
+	unlimited_stream.Clear();
+
+	// The device has to come back for whichever skipped stream is due first
+	t_time_point deferred_deadline= t_time_point::max();
+	const bool bSlowDue= DataStreamRateLimit::is_stream_publish_due(slow_stream, time_at_ms(1002), false, deferred_deadline);
+	const bool bFastDue= DataStreamRateLimit::is_stream_publish_due(fast_stream, time_at_ms(1002), false, deferred_deadline);
+	const bool bUnlimitedDue= DataStreamRateLimit::is_stream_publish_due(unlimited_stream, time_at_ms(1002), false, deferred_deadline);
+
+	success=
+		!bSlowDue && !bFastDue && bUnlimitedDue &&
+		deferred_deadline == time_at_ms(1000 + k_publish_interval_ms);
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+static t_time_point
+time_at_ms(int time_ms)
+{
+	return t_time_point() + std::chrono::milliseconds(time_ms);
+}
@@ -0,0 +1,260 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HidPacketRecording.h"
+#include "recording_test_utils.h"
+#include "unit_test.h"
+
+//-- constants -----
+// Sizes of the recorded reports, including an empty one and a full 64 byte one
+static const size_t k_packet_sizes[]= {49, 49, 0, 64, 1, 49, 17, 64, 49, 3};
+static const int k_packet_count= sizeof(k_packet_sizes) / sizeof(k_packet_sizes[0]);
+static const int k_device_type= 2;
+static const int k_product_id= 0x03d5;
+static const char *k_device_config_json= "{ \"version\": \"3\", \"prediction_time\": \"0.05\" }";
+// The writer gets a short pause before this packet, so its timestamp gap is known to be at least that long
+static const int k_delayed_packet_index= 4;
+static const int k_packet_delay_ms= 5;
+
+//-- prototypes -----
+static std::string make_temp_hid_recording_path();
+static bool write_test_recording(const std::string &path);
+static bool check_recorded_packet(const unsigned char *packet, size_t packet_size, int packet_index);
+
+//-- public interface -----
+bool run_service_hid_packet_recording_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_hid_packet_recording")
+		UNIT_TEST_MODULE_CALL_TEST(hid_packet_recording_test_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(hid_packet_recording_test_replay_loop);
+		UNIT_TEST_MODULE_CALL_TEST(hid_packet_recording_test_truncated_file);
+		UNIT_TEST_MODULE_CALL_TEST(hid_packet_recording_test_bad_header);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+hid_packet_recording_test_round_trip()
+{
+	UNIT_TEST_BEGIN("round trip")
+
+	const std::string path= make_temp_hid_recording_path();
+
+	success= write_test_recording(path);
+	assert(success);
+
+	HidPacketRecordingReader reader;
+	if (success)
+	{
+		success= reader.open(path) && reader.getIsOpen();
+		assert(success);
+	}
+
+	if (success)
+	{
+		const HidPacketRecordingFileHeader &header= reader.getHeader();
+
+		success=
+			reader.getPacketCount() == k_packet_count &&
+			header.device_type == k_device_type &&
+			header.product_id == k_product_id &&
+			reader.getDeviceConfigJson() == k_device_config_json;
+		assert(success);
+	}
+
+	// Same reports in the same order, with timestamps that start at zero and never go backwards
+	for (int packet_index = 0; success && packet_index < k_packet_count; ++packet_index)
+	{
+		success=
+			check_recorded_packet(reader.getPacket(packet_index), reader.getPacketSize(packet_index), packet_index) &&
+			(packet_index > 0
+				? reader.getPacketTimestamp(packet_index) >= reader.getPacketTimestamp(packet_index - 1)
+				: reader.getPacketTimestamp(packet_index) == 0);
+		assert(success);
+	}
+
+	if (success)
+	{
+		const int64_t delayed_gap_us=
+			reader.getPacketTimestamp(k_delayed_packet_index) - reader.getPacketTimestamp(k_delayed_packet_index - 1);
+
+		success= delayed_gap_us >= k_packet_delay_ms*1000;
+		assert(success);
+	}
+
+	reader.close();
+	boost::filesystem::remove(path);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+hid_packet_recording_test_replay_loop()
+{
+	UNIT_TEST_BEGIN("replay loop")
+
+	const std::string path= make_temp_hid_recording_path();
+
+	success= write_test_recording(path);
+	assert(success);
+
+	HidPacketRecordingReader reader;
+	if (success)
+	{
+		success= reader.open(path);
+		assert(success);
+	}
+
+	// As fast as possible, looping: two passes of the same packets with sample times that keep increasing
+	if (success)
+	{
+		int64_t last_sample_time_us= -1;
+
+		reader.startReplay(0.f, true);
+		for (int replay_index = 0; success && replay_index < 2*k_packet_count; ++replay_index)
+		{
+			const unsigned char *packet= nullptr;
+			size_t packet_size= 0;
+			int64_t sample_time_us= 0;
+
+			success=
+				reader.waitForNextPacket(0, packet, packet_size, sample_time_us) &&
+				check_recorded_packet(packet, packet_size, replay_index % k_packet_count) &&
+				(replay_index == k_packet_count
+					? sample_time_us > last_sample_time_us
+					: sample_time_us >= last_sample_time_us);
+			assert(success);
+
+			last_sample_time_us= sample_time_us;
+		}
+	}
+
+	// Without looping the replay ends after the last packet
+	if (success)
+	{
+		const unsigned char *packet= nullptr;
+		size_t packet_size= 0;
+		int64_t sample_time_us= 0;
+
+		reader.startReplay(0.f, false);
+		for (int packet_index = 0; success && packet_index < k_packet_count; ++packet_index)
+		{
+			success= reader.waitForNextPacket(0, packet, packet_size, sample_time_us);
+			assert(success);
+		}
+
+		success= success && !reader.waitForNextPacket(0, packet, packet_size, sample_time_us);
+		assert(success);
+	}
+
+	reader.close();
+	boost::filesystem::remove(path);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+hid_packet_recording_test_truncated_file()
+{
+	UNIT_TEST_BEGIN("truncated file")
+
+	const std::string path= make_temp_hid_recording_path();
+
+	success= write_test_recording(path);
+	assert(success);
+
+	// Cut the last report short.
+	// The partial record gets dropped and everything before it still loads.
+	if (success)
+	{
+		truncate_test_recording(path, k_packet_sizes[k_packet_count - 1] - 1);
+	}
+
+	HidPacketRecordingReader reader;
+	if (success)
+	{
+		success= reader.open(path) && reader.getPacketCount() == k_packet_count - 1;
+		assert(success);
+	}
+
+	for (int packet_index = 0; success && packet_index < k_packet_count - 1; ++packet_index)
+	{
+		success= check_recorded_packet(reader.getPacket(packet_index), reader.getPacketSize(packet_index), packet_index);
+		assert(success);
+	}
+
+	reader.close();
+	boost::filesystem::remove(path);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+hid_packet_recording_test_bad_header()
+{
+	UNIT_TEST_BEGIN("bad header")
+
+	const std::string path= make_temp_hid_recording_path();
+
+	success= write_test_recording(path);
+	assert(success);
+
+	if (success)
+	{
+		success= check_reader_rejects_bad_header<HidPacketRecordingReader>(path);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+static std::string make_temp_hid_recording_path()
+{
+	return make_temp_recording_path("hid_recording_test", HID_PACKET_RECORDING_FILE_EXTENSION);
+}
+
+static bool write_test_recording(const std::string &path)
+{
+	HidPacketRecordingWriter writer;
+	std::vector<unsigned char> packet;
+
+	if (!writer.open(path, k_device_type, k_product_id, k_device_config_json))
+	{
+		return false;
+	}
+
+	for (int packet_index = 0; packet_index < k_packet_count; ++packet_index)
+	{
+		if (packet_index == k_delayed_packet_index)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(k_packet_delay_ms));
+		}
+
+		fill_test_sample(packet_index, k_packet_sizes[packet_index], packet);
+
+		if (!writer.writePacket(packet.data(), packet.size()))
+		{
+			return false;
+		}
+	}
+
+	// Reports too big for the record format are refused rather than written truncated
+	std::vector<unsigned char> oversized_packet(0x10000);
+	const bool bRefusedOversizedPacket= !writer.writePacket(oversized_packet.data(), oversized_packet.size());
+
+	const bool bWroteAllPackets= writer.getPacketCount() == k_packet_count;
+	writer.close();
+
+	return bRefusedOversizedPacket && bWroteAllPackets;
+}
+
+static bool check_recorded_packet(const unsigned char *packet, size_t packet_size, int packet_index)
+{
+	return check_test_sample(packet_index, k_packet_sizes[packet_index], packet, packet_size);
+}
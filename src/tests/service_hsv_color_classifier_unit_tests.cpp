@@ -0,0 +1,218 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <vector>
+
+#include "HSVColorClassifier.h"
+#include "unit_test.h"
+
+//-- constants -----
+// Odd sizes so that every row ends in a partial block the vectorized loops hand back to the scalar code
+static const int k_frame_width= 333;
+static const int k_frame_height= 17;
+
+//-- prototypes -----
+static void build_test_frame(std::vector<uint8_t> &out_bgr_frame);
+static int build_test_bounds(HSVColorClassifierBounds *out_bounds);
+static void set_bounds(
+	HSVColorClassifierBounds &bounds,
+	int hue_min0, int hue_max0, int hue_min1, int hue_max1,
+	int saturation_min, int saturation_max, int value_min, int value_max,
+	int mask_bit_index);
+
+//-- public interface -----
+bool run_service_hsv_color_classifier_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_hsv_color_classifier")
+		UNIT_TEST_MODULE_CALL_TEST(hsv_color_classifier_test_simd_matches_scalar);
+		UNIT_TEST_MODULE_CALL_TEST(hsv_color_classifier_test_row_tails);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+hsv_color_classifier_test_simd_matches_scalar()
+{
+	UNIT_TEST_BEGIN("simd matches scalar")
+
+	std::vector<uint8_t> bgr_frame;
+	build_test_frame(bgr_frame);
+
+	HSVColorClassifierBounds bounds[HSV_COLOR_CLASSIFIER_MAX_BOUNDS];
+	const int bounds_count= build_test_bounds(bounds);
+
+	std::vector<uint8_t> scalar_mask(k_frame_width*k_frame_height);
+	std::vector<uint8_t> simd_mask(k_frame_width*k_frame_height);
+
+	// Every bounds count, so that the unused bounds slots of the vectorized loops get exercised too
+	for (int test_bounds_count = 1; success && test_bounds_count <= bounds_count; ++test_bounds_count)
+	{
+		for (int row = 0; row < k_frame_height; ++row)
+		{
+			HSVColorClassifier::classify_bgr_row_with_instruction_set(
+				HSVColorClassifier::Scalar,
+				&bgr_frame[row*k_frame_width*3], &scalar_mask[row*k_frame_width], k_frame_width,
+				bounds, test_bounds_count);
+		}
+
+		// Instruction sets the CPU doesn't support fall back to the scalar code, which trivially matches
+		for (int instruction_set = HSVColorClassifier::Scalar + 1;
+			success && instruction_set < HSVColorClassifier::MAX_INSTRUCTION_SETS;
+			++instruction_set)
+		{
+			memset(simd_mask.data(), 0xcd, simd_mask.size());
+
+			for (int row = 0; row < k_frame_height; ++row)
+			{
+				HSVColorClassifier::classify_bgr_row_with_instruction_set(
+					static_cast<HSVColorClassifier::eInstructionSet>(instruction_set),
+					&bgr_frame[row*k_frame_width*3], &simd_mask[row*k_frame_width], k_frame_width,
+					bounds, test_bounds_count);
+			}
+
+			success= memcmp(scalar_mask.data(), simd_mask.data(), scalar_mask.size()) == 0;
+			assert(success);
+		}
+	}
+
+	// Make sure the frame actually hits and misses the bounds, otherwise matching proves nothing
+	if (success)
+	{
+		bool bAnyHit= false;
+		bool bAnyMiss= false;
+		for (const uint8_t mask : scalar_mask)
+		{
+			bAnyHit|= mask != 0;
+			bAnyMiss|= mask == 0;
+		}
+
+		success= bAnyHit && bAnyMiss;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+hsv_color_classifier_test_row_tails()
+{
+	UNIT_TEST_BEGIN("row tails")
+
+	std::vector<uint8_t> bgr_frame;
+	build_test_frame(bgr_frame);
+
+	HSVColorClassifierBounds bounds[HSV_COLOR_CLASSIFIER_MAX_BOUNDS];
+	const int bounds_count= build_test_bounds(bounds);
+
+	// Short rows starting at odd offsets, so the vectorized loads are unaligned
+	// and any write past the end of the row lands on the guard bytes
+	const int k_max_pixel_count= 70;
+	const uint8_t k_guard_value= 0xcd;
+	uint8_t scalar_mask[k_max_pixel_count + 1];
+	uint8_t simd_mask[k_max_pixel_count + 1];
+
+	for (int pixel_count = 0; success && pixel_count <= k_max_pixel_count; ++pixel_count)
+	{
+		const int pixel_offset= (pixel_count*7) % 5;
+		const uint8_t *bgr_row= &bgr_frame[pixel_offset*3];
+
+		HSVColorClassifier::classify_bgr_row_with_instruction_set(
+			HSVColorClassifier::Scalar, bgr_row, scalar_mask, pixel_count, bounds, bounds_count);
+
+		for (int instruction_set = HSVColorClassifier::Scalar + 1;
+			success && instruction_set < HSVColorClassifier::MAX_INSTRUCTION_SETS;
+			++instruction_set)
+		{
+			memset(simd_mask, k_guard_value, sizeof(simd_mask));
+
+			HSVColorClassifier::classify_bgr_row_with_instruction_set(
+				static_cast<HSVColorClassifier::eInstructionSet>(instruction_set),
+				bgr_row, simd_mask, pixel_count, bounds, bounds_count);
+
+			success=
+				memcmp(scalar_mask, simd_mask, pixel_count) == 0 &&
+				simd_mask[pixel_count] == k_guard_value;
+			assert(success);
+		}
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+static void build_test_frame(std::vector<uint8_t> &out_bgr_frame)
+{
+	out_bgr_frame.resize(k_frame_width*k_frame_height*3);
+
+	uint32_t seed= 12345;
+	for (int pixel_index = 0; pixel_index < k_frame_width*k_frame_height; ++pixel_index)
+	{
+		uint8_t *bgr= &out_bgr_frame[pixel_index*3];
+
+		// Sprinkle in the edge cases of the HSV conversion:
+		// grays (zero chroma), black, white and each channel being the max
+		switch (pixel_index % 11)
+		{
+		case 0:
+			bgr[0]= bgr[1]= bgr[2]= static_cast<uint8_t>(pixel_index);
+			break;
+		case 1:
+			bgr[0]= bgr[1]= bgr[2]= (pixel_index % 2 == 0) ? 0 : 255;
+			break;
+		default:
+			{
+				// Fixed LCG so the frame is the same on every run
+				seed= seed*1664525u + 1013904223u;
+				bgr[0]= static_cast<uint8_t>(seed >> 24);
+				bgr[1]= static_cast<uint8_t>(seed >> 16);
+				bgr[2]= static_cast<uint8_t>(seed >> 8);
+
+				// Saturate one channel now and then
+				if (pixel_index % 11 == 2)
+				{
+					bgr[(pixel_index / 11) % 3]= 255;
+				}
+			} break;
+		}
+	}
+}
+
+static int build_test_bounds(HSVColorClassifierBounds *out_bounds)
+{
+	int bounds_count= 0;
+
+	// Tracking color style bounds: red wraps around the hue circle, the rest don't
+	set_bounds(out_bounds[bounds_count], 0, 10, 170, 180, 80, 255, 40, 255, bounds_count); ++bounds_count;
+	set_bounds(out_bounds[bounds_count], 50, 70, 1, 0, 80, 255, 40, 255, bounds_count); ++bounds_count;
+	set_bounds(out_bounds[bounds_count], 110, 130, 1, 0, 80, 255, 40, 255, bounds_count); ++bounds_count;
+	set_bounds(out_bounds[bounds_count], 80, 100, 1, 0, 30, 200, 100, 220, bounds_count); ++bounds_count;
+	set_bounds(out_bounds[bounds_count], 140, 160, 1, 0, 0, 255, 0, 255, bounds_count); ++bounds_count;
+	// Grays only: any hue, low saturation
+	set_bounds(out_bounds[bounds_count], 0, 180, 1, 0, 0, 20, 0, 255, bounds_count); ++bounds_count;
+	// Degenerate single hue
+	set_bounds(out_bounds[bounds_count], 30, 30, 1, 0, 0, 255, 0, 255, bounds_count); ++bounds_count;
+	// Dark pixels of any hue
+	set_bounds(out_bounds[bounds_count], 0, 180, 1, 0, 0, 255, 0, 30, bounds_count); ++bounds_count;
+
+	assert(bounds_count <= HSV_COLOR_CLASSIFIER_MAX_BOUNDS);
+
+	return bounds_count;
+}
+
+static void set_bounds(
+	HSVColorClassifierBounds &bounds,
+	int hue_min0, int hue_max0, int hue_min1, int hue_max1,
+	int saturation_min, int saturation_max, int value_min, int value_max,
+	int mask_bit_index)
+{
+	bounds.hue_min[0]= static_cast<uint8_t>(hue_min0);
+	bounds.hue_max[0]= static_cast<uint8_t>(hue_max0);
+	bounds.hue_min[1]= static_cast<uint8_t>(hue_min1);
+	bounds.hue_max[1]= static_cast<uint8_t>(hue_max1);
+	bounds.saturation_min= static_cast<uint8_t>(saturation_min);
+	bounds.saturation_max= static_cast<uint8_t>(saturation_max);
+	bounds.value_min= static_cast<uint8_t>(value_min);
+	bounds.value_max= static_cast<uint8_t>(value_max);
+	bounds.mask_bits= static_cast<uint8_t>(1 << mask_bit_index);
+}
@@ -0,0 +1,184 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <chrono>
+
+#include "KalmanPoseFilter.h"
+#include "unit_test.h"
+
+//-- constants -----
+// A 200Hz IMU stream with one camera frame exposed part way through it
+static const int k_imu_packet_count= 12;
+static const int k_imu_packet_interval_us= 5000;
+
+// The camera exposes the frame just after this IMU packet...
+static const int k_optical_capture_after_imu_index= 4;
+static const int k_optical_capture_offset_us= 2000;
+
+// ...and the triangulated pose reaches the filter a camera frame and then some later, after this IMU packet
+static const int k_optical_capture_to_triangulation_us= 25000;
+static const int k_optical_arrives_after_imu_index= 9;
+
+static const float k_fixed_lag_window_seconds= 0.1f;
+
+static const float k_position_tolerance_cm= 0.0001f;
+static const float k_orientation_tolerance= 0.000001f;
+
+//-- private methods -----
+typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_sample_time;
+
+static void init_filter_constants(PoseFilterConstants &constants);
+static void make_imu_packet(const t_sample_time &timestamp, PoseFilterPacket &out_packet);
+static void make_optical_packet(const t_sample_time &capture_timestamp, PoseFilterPacket &out_packet);
+static bool filter_states_match(const KalmanPoseFilter &filter_a, const KalmanPoseFilter &filter_b);
+
+//-- public interface -----
+bool run_service_kalman_pose_filter_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_kalman_pose_filter")
+		UNIT_TEST_MODULE_CALL_TEST(kalman_pose_filter_test_late_optical_rollback);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+kalman_pose_filter_test_late_optical_rollback()
+{
+	UNIT_TEST_BEGIN("late optical rollback")
+
+	PoseFilterConstants constants;
+	init_filter_constants(constants);
+
+	const t_sample_time start_time= std::chrono::high_resolution_clock::now();
+	const float imu_time_step= static_cast<float>(k_imu_packet_interval_us) / 1000000.f;
+
+	PoseFilterPacket imu_packets[k_imu_packet_count];
+	for (int imu_index= 0; imu_index < k_imu_packet_count; ++imu_index)
+	{
+		make_imu_packet(start_time + std::chrono::microseconds(imu_index*k_imu_packet_interval_us), imu_packets[imu_index]);
+	}
+
+	PoseFilterPacket optical_packet;
+	make_optical_packet(
+		start_time + std::chrono::microseconds(k_optical_capture_after_imu_index*k_imu_packet_interval_us + k_optical_capture_offset_us),
+		optical_packet);
+
+	// One filter gets the optical packet where the camera exposed it...
+	KalmanPoseFilterPSMove in_order_filter;
+	in_order_filter.init(constants, Eigen::Vector3f::Zero(), Eigen::Quaternionf::Identity());
+	for (int imu_index= 0; imu_index < k_imu_packet_count; ++imu_index)
+	{
+		in_order_filter.update(imu_time_step, imu_packets[imu_index]);
+
+		if (imu_index == k_optical_capture_after_imu_index)
+		{
+			in_order_filter.update(imu_time_step, optical_packet);
+		}
+	}
+
+	// ...the other gets it when the pipeline delivers it, so it has to roll back past the newer IMU packets
+	KalmanPoseFilterPSMove late_filter;
+	late_filter.init(constants, Eigen::Vector3f::Zero(), Eigen::Quaternionf::Identity());
+	for (int imu_index= 0; imu_index < k_imu_packet_count; ++imu_index)
+	{
+		late_filter.update(imu_time_step, imu_packets[imu_index]);
+
+		if (imu_index == k_optical_arrives_after_imu_index)
+		{
+			late_filter.update(imu_time_step, optical_packet);
+		}
+	}
+
+	success= in_order_filter.getIsStateValid() && late_filter.getIsStateValid();
+	assert(success);
+
+	if (success)
+	{
+		success= filter_states_match(in_order_filter, late_filter);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+static void
+init_filter_constants(PoseFilterConstants &constants)
+{
+	constants.clear();
+	constants.fixed_lag_window_seconds= k_fixed_lag_window_seconds;
+
+	const float mean_update_time_delta= static_cast<float>(k_imu_packet_interval_us) / 1000000.f;
+	const Eigen::Vector3f gravity_calibration_direction(0.f, 1.f, 0.f);
+
+	OrientationFilterConstants &orientation_constants= constants.orientation_constants;
+	orientation_constants.gravity_calibration_direction= gravity_calibration_direction;
+	orientation_constants.magnetometer_calibration_direction= Eigen::Vector3f(0.234017432f, 0.873125494f, 0.42765367f).normalized();
+	orientation_constants.mean_update_time_delta= mean_update_time_delta;
+	orientation_constants.orientation_variance_curve.A= 0.005f;
+	orientation_constants.orientation_variance_curve.B= 0.f;
+	orientation_constants.orientation_variance_curve.MaxValue= 1.f;
+	orientation_constants.accelerometer_variance= Eigen::Vector3f(0.0001f, 0.0001f, 0.0001f);
+	orientation_constants.gyro_variance= Eigen::Vector3f(0.00001f, 0.00001f, 0.00001f);
+	orientation_constants.magnetometer_variance= Eigen::Vector3f(0.001f, 0.001f, 0.001f);
+
+	PositionFilterConstants &position_constants= constants.position_constants;
+	position_constants.gravity_calibration_direction= gravity_calibration_direction;
+	position_constants.accelerometer_variance= Eigen::Vector3f(0.0001f, 0.0001f, 0.0001f);
+	position_constants.accelerometer_noise_radius= 0.0139137721f;
+	position_constants.max_velocity= 1.f;
+	position_constants.mean_update_time_delta= mean_update_time_delta;
+	position_constants.position_variance_curve.A= 0.44888f;
+	position_constants.position_variance_curve.B= -0.00402f;
+	position_constants.position_variance_curve.MaxValue= 1.f;
+}
+
+static void
+make_imu_packet(const t_sample_time &timestamp, PoseFilterPacket &out_packet)
+{
+	out_packet.clear();
+	out_packet.timestamp= timestamp;
+
+	// Turning slowly while held still
+	out_packet.imu_accelerometer_g_units= Eigen::Vector3f(0.f, 1.f, 0.f);
+	out_packet.imu_magnetometer_unit= Eigen::Vector3f(0.234017432f, 0.873125494f, 0.42765367f).normalized();
+	out_packet.imu_gyroscope_rad_per_sec= Eigen::Vector3f(0.1f, 0.2f, 0.3f);
+	out_packet.has_accelerometer_measurement= true;
+	out_packet.has_magnetometer_measurement= true;
+	out_packet.has_gyroscope_measurement= true;
+}
+
+static void
+make_optical_packet(const t_sample_time &capture_timestamp, PoseFilterPacket &out_packet)
+{
+	out_packet.clear();
+
+	// Posted once triangulated, carrying the latency back to the capture
+	out_packet.timestamp= capture_timestamp + std::chrono::microseconds(k_optical_capture_to_triangulation_us);
+	out_packet.stage_times.capture_us= 1000000;
+	out_packet.stage_times.segmentation_done_us= out_packet.stage_times.capture_us + k_optical_capture_to_triangulation_us/2;
+	out_packet.stage_times.triangulation_done_us= out_packet.stage_times.capture_us + k_optical_capture_to_triangulation_us;
+
+	out_packet.optical_position_cm= Eigen::Vector3f(1.f, 2.f, 3.f);
+	out_packet.optical_orientation= Eigen::Quaternionf(Eigen::AngleAxisf(0.05f, Eigen::Vector3f::UnitY()));
+	out_packet.tracking_projection_area_px_sqr= 400.f;
+}
+
+static bool
+filter_states_match(const KalmanPoseFilter &filter_a, const KalmanPoseFilter &filter_b)
+{
+	// Rolling back restores the exact filter state, so the replay should land on the same state
+	const bool bPositionMatches=
+		(filter_a.getPositionCm() - filter_b.getPositionCm()).norm() <= k_position_tolerance_cm &&
+		(filter_a.getVelocityCmPerSec() - filter_b.getVelocityCmPerSec()).norm() <= k_position_tolerance_cm;
+
+	// q and -q are the same rotation
+	const bool bOrientationMatches=
+		1.f - fabsf(filter_a.getOrientation().dot(filter_b.getOrientation())) <= k_orientation_tolerance &&
+		(filter_a.getAngularVelocityRadPerSec() - filter_b.getAngularVelocityRadPerSec()).norm() <= k_orientation_tolerance;
+
+	const bool bTimeMatches= fabs(filter_a.getTimeInSeconds() - filter_b.getTimeInSeconds()) <= k_orientation_tolerance;
+
+	return bPositionMatches && bOrientationMatches && bTimeMatches;
+}
@@ -0,0 +1,77 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "PipelineLatency.h"
+#include "unit_test.h"
+
+//-- constants -----
+// A camera frame takes a frame interval and then some to get through segmentation and triangulation
+static const int64_t k_capture_us= 1000000;
+static const int64_t k_segmentation_done_us= k_capture_us + 25000;
+static const int64_t k_triangulation_done_us= k_capture_us + 33000;
+static const int64_t k_filter_done_us= k_capture_us + 34000;
+
+//-- public interface -----
+bool run_service_pipeline_latency_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_pipeline_latency")
+		UNIT_TEST_MODULE_CALL_TEST(pipeline_latency_test_optical_sample_time);
+		UNIT_TEST_MODULE_CALL_TEST(pipeline_latency_test_imu_sample_time);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+pipeline_latency_test_optical_sample_time()
+{
+	UNIT_TEST_BEGIN("optical sample time")
+
+	PipelineStageTimes stage_times;
+	stage_times.clear();
+	stage_times.capture_us= k_capture_us;
+	stage_times.segmentation_done_us= k_segmentation_done_us;
+	stage_times.triangulation_done_us= k_triangulation_done_us;
+	stage_times.filter_done_us= k_filter_done_us;
+
+	// The pose is fused when it is triangulated, not when the camera exposed the frame,
+	// otherwise clients extrapolate a camera frame too far
+	success= stage_times.getFilterSampleTimeUs(false) == k_triangulation_done_us;
+	assert(success);
+
+	// Unless the filter rolls back to fuse it where the camera exposed the frame
+	if (success)
+	{
+		success= stage_times.getFilterSampleTimeUs(true) == k_capture_us;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+pipeline_latency_test_imu_sample_time()
+{
+	UNIT_TEST_BEGIN("imu sample time")
+
+	PipelineStageTimes stage_times;
+	stage_times.clear();
+
+	success= stage_times.getFilterSampleTimeUs(false) == 0;
+	assert(success);
+
+	// IMU samples skip segmentation and triangulation, so they are fused as of their capture
+	if (success)
+	{
+		stage_times.capture_us= k_capture_us;
+		stage_times.filter_done_us= k_filter_done_us;
+
+		success=
+			stage_times.getFilterSampleTimeUs(false) == k_capture_us &&
+			stage_times.getFilterSampleTimeUs(true) == k_capture_us;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,315 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+
+#include "PoseSensorPacketQueue.h"
+#include "unit_test.h"
+
+//-- constants -----
+// IMU packets come in every 4ms, optical ones every 16ms half way between two IMU packets
+static const int k_imu_interval_ms= 4;
+static const int k_optical_interval_ms= 16;
+static const int k_optical_offset_ms= 2;
+
+// Together more than one update feeds to the filter
+static const int k_trim_imu_packet_count= 90;
+static const int k_trim_optical_packet_count= 30;
+
+// More than the merger's ring holds, less than the queue holds
+static const int k_overwrite_packet_count= POSE_SENSOR_PACKET_MERGE_CAPACITY + 50;
+
+//-- private definitions -----
+typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_packet_time;
+
+struct ExpectedPacket
+{
+	int time_ms;
+	bool is_imu;
+};
+
+//-- private methods -----
+static int post_test_packets(
+	PoseSensorPacketQueue &queue, bool is_imu, int first_time_ms, int interval_ms, int packet_count,
+	std::vector<ExpectedPacket> &out_expected);
+static bool sort_expected_packets(const ExpectedPacket &a, const ExpectedPacket &b);
+static bool check_merged_packets(PoseSensorPacketMerger &merger, const ExpectedPacket *expected, int expected_count);
+
+//-- public interface -----
+bool run_service_pose_sensor_packet_merger_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_pose_sensor_packet_merger")
+		UNIT_TEST_MODULE_CALL_TEST(pose_sensor_packet_merger_test_merge_order);
+		UNIT_TEST_MODULE_CALL_TEST(pose_sensor_packet_merger_test_trim_keeps_newest);
+		UNIT_TEST_MODULE_CALL_TEST(pose_sensor_packet_merger_test_ring_overwrite);
+		UNIT_TEST_MODULE_CALL_TEST(pose_sensor_packet_merger_test_queue_stats);
+		UNIT_TEST_MODULE_CALL_TEST(pose_sensor_packet_queue_test_dropped_count);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+pose_sensor_packet_merger_test_merge_order()
+{
+	UNIT_TEST_BEGIN("merge order")
+
+	PoseSensorPacketQueue imu_queue;
+	PoseSensorPacketQueue optical_queue;
+	PoseSensorPacketMerger merger;
+	std::vector<ExpectedPacket> expected;
+
+	// The last optical packet lands on an IMU packet's time, the IMU packet has to come out first
+	post_test_packets(imu_queue, true, 0, k_imu_interval_ms, 10, expected);
+	post_test_packets(optical_queue, false, k_optical_offset_ms, k_optical_interval_ms, 2, expected);
+	post_test_packets(optical_queue, false, 2*k_optical_interval_ms, k_optical_interval_ms, 1, expected);
+	std::stable_sort(expected.begin(), expected.end(), sort_expected_packets);
+
+	success= merger.drainQueues(imu_queue, optical_queue) == static_cast<int>(expected.size());
+	assert(success);
+
+	if (success)
+	{
+		success= check_merged_packets(merger, expected.data(), static_cast<int>(expected.size()));
+		assert(success);
+	}
+
+	if (success)
+	{
+		success= merger.getMergeDroppedCount() == 0;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+pose_sensor_packet_merger_test_trim_keeps_newest()
+{
+	UNIT_TEST_BEGIN("trim keeps newest")
+
+	PoseSensorPacketQueue imu_queue;
+	PoseSensorPacketQueue optical_queue;
+	PoseSensorPacketMerger merger;
+	std::vector<ExpectedPacket> expected;
+
+	post_test_packets(imu_queue, true, 0, k_imu_interval_ms, k_trim_imu_packet_count, expected);
+	post_test_packets(optical_queue, false, k_optical_offset_ms, k_optical_interval_ms, k_trim_optical_packet_count, expected);
+	std::stable_sort(expected.begin(), expected.end(), sort_expected_packets);
+
+	// The oldest packets go, whichever stream they came from
+	const int excess= static_cast<int>(expected.size()) - POSE_SENSOR_PACKET_MERGE_CAPACITY;
+
+	success= excess > 0 && merger.drainQueues(imu_queue, optical_queue) == POSE_SENSOR_PACKET_MERGE_CAPACITY;
+	assert(success);
+
+	if (success)
+	{
+		success= check_merged_packets(merger, expected.data() + excess, POSE_SENSOR_PACKET_MERGE_CAPACITY);
+		assert(success);
+	}
+
+	if (success)
+	{
+		success= merger.getMergeDroppedCount() == static_cast<uint64_t>(excess);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+pose_sensor_packet_merger_test_ring_overwrite()
+{
+	UNIT_TEST_BEGIN("ring overwrite")
+
+	PoseSensorPacketQueue imu_queue;
+	PoseSensorPacketQueue optical_queue;
+	PoseSensorPacketMerger merger;
+	std::vector<ExpectedPacket> expected;
+
+	// A backlog longer than the IMU ring wraps it, leaving the newest packets in order
+	post_test_packets(imu_queue, true, 0, k_imu_interval_ms, k_overwrite_packet_count, expected);
+
+	const int overwritten= k_overwrite_packet_count - POSE_SENSOR_PACKET_MERGE_CAPACITY;
+
+	success= merger.drainQueues(imu_queue, optical_queue) == POSE_SENSOR_PACKET_MERGE_CAPACITY;
+	assert(success);
+
+	if (success)
+	{
+		success= check_merged_packets(merger, expected.data() + overwritten, POSE_SENSOR_PACKET_MERGE_CAPACITY);
+		assert(success);
+	}
+
+	if (success)
+	{
+		success= merger.getMergeDroppedCount() == static_cast<uint64_t>(overwritten);
+		assert(success);
+	}
+
+	// The ring starts mid buffer now, the next drain has to pick up from there
+	if (success)
+	{
+		expected.clear();
+		post_test_packets(imu_queue, true, k_overwrite_packet_count*k_imu_interval_ms, k_imu_interval_ms, 10, expected);
+
+		success=
+			merger.drainQueues(imu_queue, optical_queue) == 10 &&
+			check_merged_packets(merger, expected.data(), 10);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+pose_sensor_packet_merger_test_queue_stats()
+{
+	UNIT_TEST_BEGIN("queue stats")
+
+	PoseSensorPacketQueue imu_queue;
+	PoseSensorPacketQueue optical_queue;
+	PoseSensorPacketMerger merger;
+	PoseSensorQueueStats stats;
+	std::vector<ExpectedPacket> expected;
+
+	post_test_packets(imu_queue, true, 0, k_imu_interval_ms, 12, expected);
+	post_test_packets(optical_queue, false, k_optical_offset_ms, k_optical_interval_ms, 3, expected);
+	merger.drainQueues(imu_queue, optical_queue);
+	while (merger.nextPacket() != nullptr)
+	{
+	}
+
+	// A shallower backlog doesn't lower the high water marks
+	post_test_packets(imu_queue, true, 100, k_imu_interval_ms, 4, expected);
+	post_test_packets(optical_queue, false, 100 + k_optical_offset_ms, k_optical_interval_ms, 1, expected);
+	merger.drainQueues(imu_queue, optical_queue);
+	while (merger.nextPacket() != nullptr)
+	{
+	}
+
+	stats.clear();
+	merger.getStats(imu_queue, optical_queue, stats);
+
+	success=
+		stats.imu_queue_depth_max == 12 &&
+		stats.optical_queue_depth_max == 3 &&
+		stats.imu_dropped_count == 0 &&
+		stats.optical_dropped_count == 0 &&
+		stats.merge_dropped_count == 0;
+	assert(success);
+
+	if (success)
+	{
+		merger.resetStats();
+		merger.getStats(imu_queue, optical_queue, stats);
+
+		success=
+			stats.imu_queue_depth_max == 0 &&
+			stats.optical_queue_depth_max == 0 &&
+			stats.merge_dropped_count == 0;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+pose_sensor_packet_queue_test_dropped_count()
+{
+	UNIT_TEST_BEGIN("queue dropped count")
+
+	PoseSensorPacketQueue queue;
+	std::vector<ExpectedPacket> expected;
+
+	success= post_test_packets(queue, true, 0, k_imu_interval_ms, POSE_SENSOR_PACKET_QUEUE_CAPACITY, expected) == POSE_SENSOR_PACKET_QUEUE_CAPACITY;
+	assert(success);
+
+	// Anything past the capacity is dropped and counted, the queued packets are untouched
+	if (success)
+	{
+		success=
+			post_test_packets(queue, true, 0, k_imu_interval_ms, 3, expected) == 0 &&
+			queue.getDroppedCount() == 3;
+		assert(success);
+	}
+
+	if (success)
+	{
+		PoseSensorPacket packet;
+
+		success=
+			queue.tryDequeue(packet) &&
+			packet.timestamp == t_packet_time() &&
+			post_test_packets(queue, true, 0, k_imu_interval_ms, 1, expected) == 1 &&
+			queue.getDroppedCount() == 3;
+		assert(success);
+	}
+
+	if (success)
+	{
+		queue.resetDroppedCount();
+
+		success= queue.getDroppedCount() == 0;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+// Returns how many packets the queue took
+static int
+post_test_packets(
+	PoseSensorPacketQueue &queue, bool is_imu, int first_time_ms, int interval_ms, int packet_count,
+	std::vector<ExpectedPacket> &out_expected)
+{
+	int posted_count= 0;
+
+	for (int packet_index = 0; packet_index < packet_count; ++packet_index)
+	{
+		const int time_ms= first_time_ms + packet_index*interval_ms;
+
+		PoseSensorPacket packet;
+		packet.clear();
+		packet.timestamp= t_packet_time() + std::chrono::milliseconds(time_ms);
+		packet.has_gyroscope_measurement= is_imu;
+		packet.tracking_projection_area_px_sqr= is_imu ? 0.f : 1.f;
+
+		if (queue.post(packet))
+		{
+			ExpectedPacket expected= {time_ms, is_imu};
+
+			out_expected.push_back(expected);
+			++posted_count;
+		}
+	}
+
+	return posted_count;
+}
+
+// Time order, with IMU packets ahead of optical ones at the same time (used with a stable sort)
+static bool
+sort_expected_packets(const ExpectedPacket &a, const ExpectedPacket &b)
+{
+	return (a.time_ms != b.time_ms) ? (a.time_ms < b.time_ms) : (a.is_imu && !b.is_imu);
+}
+
+static bool
+check_merged_packets(PoseSensorPacketMerger &merger, const ExpectedPacket *expected, int expected_count)
+{
+	bool success= true;
+
+	for (int packet_index = 0; success && packet_index < expected_count; ++packet_index)
+	{
+		const PoseSensorPacket *packet= merger.nextPacket();
+
+		success=
+			packet != nullptr &&
+			packet->timestamp == t_packet_time() + std::chrono::milliseconds(expected[packet_index].time_ms) &&
+			packet->has_gyroscope_measurement == expected[packet_index].is_imu;
+	}
+
+	return success && merger.nextPacket() == nullptr;
+}
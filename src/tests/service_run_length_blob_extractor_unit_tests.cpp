@@ -0,0 +1,310 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "RunLengthBlobExtractor.h"
+#include "unit_test.h"
+
+//-- constants -----
+static const int k_mask_width= 121;
+static const int k_mask_height= 67;
+static const int k_mask_stride= 128; // padded rows, like an ROI of a bigger mask
+static const int k_origin_x= 40;
+static const int k_origin_y= 25;
+
+//-- prototypes -----
+static void build_test_mask(std::vector<uint8_t> &out_mask);
+static void find_reference_blobs(const std::vector<uint8_t> &mask, std::vector<BlobInfo> &out_blobs);
+static bool blob_stats_match(const BlobInfo &a, const BlobInfo &b);
+
+//-- public interface -----
+bool run_service_run_length_blob_extractor_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_run_length_blob_extractor")
+		UNIT_TEST_MODULE_CALL_TEST(blob_extractor_test_matches_flood_fill);
+		UNIT_TEST_MODULE_CALL_TEST(blob_extractor_test_diagonal_connectivity);
+		UNIT_TEST_MODULE_CALL_TEST(blob_extractor_test_rectangle_boundary);
+		UNIT_TEST_MODULE_CALL_TEST(blob_extractor_test_empty_mask);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+blob_extractor_test_matches_flood_fill()
+{
+	UNIT_TEST_BEGIN("matches flood fill")
+
+	std::vector<uint8_t> mask;
+	build_test_mask(mask);
+
+	std::vector<BlobInfo> reference_blobs;
+	find_reference_blobs(mask, reference_blobs);
+
+	// The mask needs plenty of blobs for the test to mean anything
+	success= reference_blobs.size() > 20;
+	assert(success);
+
+	// Run twice so the second pass goes through the storage kept from the first one
+	RunLengthBlobExtractor extractor;
+	const int k_max_blob_count= 8;
+	for (int pass = 0; success && pass < 2; ++pass)
+	{
+		const int blob_count=
+			extractor.extractBiggestBlobs(
+				mask.data(), k_mask_width, k_mask_height, k_mask_stride,
+				k_origin_x, k_origin_y, k_max_blob_count);
+
+		success=
+			blob_count == k_max_blob_count &&
+			extractor.getBlobCount() == blob_count &&
+			extractor.getComponentCount() == static_cast<int>(reference_blobs.size());
+		assert(success);
+
+		// Sorted by area, and every kept blob is one of the biggest components of the reference.
+		// Blobs of equal area can come in any order, so match them up by their stats.
+		std::vector<bool> reference_used(reference_blobs.size(), false);
+		for (int blob_index = 0; success && blob_index < blob_count; ++blob_index)
+		{
+			const BlobInfo &blob= extractor.getBlob(blob_index);
+
+			success= blob.getArea() == reference_blobs[blob_index].getArea();
+			assert(success);
+
+			bool bFound= false;
+			for (size_t reference_index = 0; !bFound && reference_index < reference_blobs.size(); ++reference_index)
+			{
+				if (!reference_used[reference_index] && blob_stats_match(blob, reference_blobs[reference_index]))
+				{
+					reference_used[reference_index]= true;
+					bFound= true;
+				}
+			}
+
+			success&= bFound;
+			assert(success);
+		}
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+blob_extractor_test_diagonal_connectivity()
+{
+	UNIT_TEST_BEGIN("diagonal connectivity")
+
+	// A staircase of single pixels touching only at their corners is one blob.
+	// The lone pixel in the corner is a second one.
+	const int k_size= 8;
+	uint8_t mask[k_size*k_size];
+	memset(mask, 0, sizeof(mask));
+	for (int i = 0; i < k_size - 2; ++i)
+	{
+		mask[i*k_size + i]= 255;
+	}
+	mask[k_size - 1]= 255;
+
+	RunLengthBlobExtractor extractor;
+	const int blob_count= extractor.extractBiggestBlobs(mask, k_size, k_size, k_size, 0, 0, 4);
+
+	success=
+		blob_count == 2 &&
+		extractor.getComponentCount() == 2 &&
+		extractor.getBlob(0).getArea() == k_size - 2 &&
+		extractor.getBlob(1).getArea() == 1 &&
+		extractor.getBlob(1).x_min == k_size - 1 && extractor.getBlob(1).y_min == 0;
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+blob_extractor_test_rectangle_boundary()
+{
+	UNIT_TEST_BEGIN("rectangle boundary")
+
+	// A solid rectangle in image space [12, 18] x [33, 36] (the mask starts at 10, 30)
+	const int k_width= 10;
+	const int k_height= 8;
+	uint8_t mask[k_width*k_height];
+	memset(mask, 0, sizeof(mask));
+	for (int y = 3; y <= 6; ++y)
+	{
+		for (int x = 2; x <= 8; ++x)
+		{
+			mask[y*k_width + x]= 1;
+		}
+	}
+
+	RunLengthBlobExtractor extractor;
+	const int blob_count= extractor.extractBiggestBlobs(mask, k_width, k_height, k_width, 10, 30, 1);
+
+	success= blob_count == 1;
+	assert(success);
+
+	if (success)
+	{
+		const BlobInfo &blob= extractor.getBlob(0);
+
+		success=
+			blob.getArea() == 7*4 &&
+			blob.x_min == 12 && blob.x_max == 18 &&
+			blob.y_min == 33 && blob.y_max == 36 &&
+			blob.getCenterX() == 15.f && blob.getCenterY() == 34.5f;
+		assert(success);
+	}
+
+	// The collinear points along each side get dropped, leaving just the corners:
+	// down the left side, then back up the right side
+	if (success)
+	{
+		const BlobInfo &blob= extractor.getBlob(0);
+		const BlobPoint *boundary= extractor.getBlobBoundary(0);
+		const BlobPoint k_expected_corners[4]= {{12, 33}, {12, 36}, {18, 36}, {18, 33}};
+
+		success= blob.boundary_count == 4;
+		for (int point_index = 0; success && point_index < 4; ++point_index)
+		{
+			success=
+				boundary[point_index].x == k_expected_corners[point_index].x &&
+				boundary[point_index].y == k_expected_corners[point_index].y;
+		}
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+blob_extractor_test_empty_mask()
+{
+	UNIT_TEST_BEGIN("empty mask")
+
+	uint8_t mask[16*16];
+	memset(mask, 0, sizeof(mask));
+
+	RunLengthBlobExtractor extractor;
+	const int blob_count= extractor.extractBiggestBlobs(mask, 16, 16, 16, 0, 0, 4);
+
+	success= blob_count == 0 && extractor.getBlobCount() == 0 && extractor.getComponentCount() == 0;
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+static void build_test_mask(std::vector<uint8_t> &out_mask)
+{
+	// The padding bytes past the width of each row are set so that reading them would show up as extra blobs
+	out_mask.assign(k_mask_stride*k_mask_height, 0xff);
+
+	// Fixed LCG so the mask is the same on every run.
+	// About a third of the pixels are set, which gives lots of small irregular 8-connected blobs.
+	uint32_t seed= 4321;
+	for (int y = 0; y < k_mask_height; ++y)
+	{
+		for (int x = 0; x < k_mask_width; ++x)
+		{
+			seed= seed*1664525u + 1013904223u;
+			out_mask[y*k_mask_stride + x]= ((seed >> 16) % 3 == 0) ? 255 : 0;
+		}
+	}
+
+	// Plus a few solid shapes big enough to be the tracked blobs
+	for (int y = 5; y < 20; ++y)
+	{
+		for (int x = 10; x < 30; ++x)
+		{
+			out_mask[y*k_mask_stride + x]= 255;
+		}
+	}
+	for (int y = 40; y < 60; ++y)
+	{
+		const int half_width= std::min(y - 40, 59 - y);
+		for (int x = 80 - half_width; x <= 80 + half_width; ++x)
+		{
+			out_mask[y*k_mask_stride + x]= 255;
+		}
+	}
+}
+
+static void find_reference_blobs(const std::vector<uint8_t> &mask, std::vector<BlobInfo> &out_blobs)
+{
+	std::vector<bool> visited(k_mask_width*k_mask_height, false);
+	std::vector<int> stack;
+
+	out_blobs.clear();
+
+	for (int start_y = 0; start_y < k_mask_height; ++start_y)
+	{
+		for (int start_x = 0; start_x < k_mask_width; ++start_x)
+		{
+			if (mask[start_y*k_mask_stride + start_x] == 0 || visited[start_y*k_mask_width + start_x])
+			{
+				continue;
+			}
+
+			BlobInfo blob;
+			memset(&blob, 0, sizeof(blob));
+			blob.x_min= blob.y_min= INT32_MAX;
+			blob.x_max= blob.y_max= INT32_MIN;
+
+			// Flood fill the 8-connected component
+			visited[start_y*k_mask_width + start_x]= true;
+			stack.push_back(start_y*k_mask_width + start_x);
+			while (!stack.empty())
+			{
+				const int pixel_index= stack.back();
+				const int x= pixel_index % k_mask_width;
+				const int y= pixel_index / k_mask_width;
+				stack.pop_back();
+
+				const int64_t image_x= x + k_origin_x;
+				const int64_t image_y= y + k_origin_y;
+				blob.m00+= 1;
+				blob.m10+= image_x;
+				blob.m01+= image_y;
+				blob.m20+= image_x*image_x;
+				blob.m11+= image_x*image_y;
+				blob.m02+= image_y*image_y;
+				blob.x_min= std::min(blob.x_min, static_cast<int>(image_x));
+				blob.x_max= std::max(blob.x_max, static_cast<int>(image_x));
+				blob.y_min= std::min(blob.y_min, static_cast<int>(image_y));
+				blob.y_max= std::max(blob.y_max, static_cast<int>(image_y));
+
+				for (int neighbor_y = std::max(y - 1, 0); neighbor_y <= std::min(y + 1, k_mask_height - 1); ++neighbor_y)
+				{
+					for (int neighbor_x = std::max(x - 1, 0); neighbor_x <= std::min(x + 1, k_mask_width - 1); ++neighbor_x)
+					{
+						const int neighbor_index= neighbor_y*k_mask_width + neighbor_x;
+
+						if (mask[neighbor_y*k_mask_stride + neighbor_x] != 0 && !visited[neighbor_index])
+						{
+							visited[neighbor_index]= true;
+							stack.push_back(neighbor_index);
+						}
+					}
+				}
+			}
+
+			out_blobs.push_back(blob);
+		}
+	}
+
+	std::stable_sort(
+		out_blobs.begin(), out_blobs.end(),
+		[](const BlobInfo &a, const BlobInfo &b) { return a.m00 > b.m00; });
+}
+
+static bool blob_stats_match(const BlobInfo &a, const BlobInfo &b)
+{
+	return
+		a.m00 == b.m00 &&
+		a.m10 == b.m10 && a.m01 == b.m01 &&
+		a.m20 == b.m20 && a.m11 == b.m11 && a.m02 == b.m02 &&
+		a.x_min == b.x_min && a.y_min == b.y_min &&
+		a.x_max == b.x_max && a.y_max == b.y_max;
+}
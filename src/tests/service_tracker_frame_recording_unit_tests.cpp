@@ -0,0 +1,203 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string>
+#include <vector>
+
+#include "TrackerFrameRecording.h"
+#include "recording_test_utils.h"
+#include "unit_test.h"
+
+//-- constants -----
+// A tiny frame with padded rows, and enough frames to fill a couple of chunks plus a partial one
+static const int k_frame_width= 13;
+static const int k_frame_height= 7;
+static const int k_frame_stride= 48;
+static const int k_frame_size= k_frame_stride*k_frame_height;
+static const int k_frame_count= 150;
+static const double k_frame_rate= 60.0;
+static const int64_t k_first_timestamp_us= 123456789;
+static const char *k_tracker_config_json= "{ \"version\": \"1\", \"exposure\": \"32\" }";
+
+//-- prototypes -----
+static std::string make_temp_tracker_recording_path();
+static int64_t get_test_frame_timestamp_us(int frame_index);
+static bool write_test_recording(const std::string &path);
+static bool check_recorded_frame(TrackerFrameRecordingReader &reader, int frame_index);
+
+//-- public interface -----
+bool run_service_tracker_frame_recording_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_tracker_frame_recording")
+		UNIT_TEST_MODULE_CALL_TEST(tracker_frame_recording_test_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(tracker_frame_recording_test_truncated_file);
+		UNIT_TEST_MODULE_CALL_TEST(tracker_frame_recording_test_bad_header);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+tracker_frame_recording_test_round_trip()
+{
+	UNIT_TEST_BEGIN("round trip")
+
+	const std::string path= make_temp_tracker_recording_path();
+
+	success= write_test_recording(path);
+	assert(success);
+
+	TrackerFrameRecordingReader reader;
+	if (success)
+	{
+		success= reader.open(path);
+		assert(success);
+	}
+
+	if (success)
+	{
+		const TrackerRecordingFileHeader &header= reader.getHeader();
+
+		success=
+			reader.getFrameCount() == k_frame_count &&
+			header.pixel_format == TrackerRecordingPixelFormat_BGR &&
+			header.width == k_frame_width &&
+			header.height == k_frame_height &&
+			header.stride == k_frame_stride &&
+			header.frame_rate == k_frame_rate &&
+			reader.getTrackerConfigJson() == k_tracker_config_json;
+		assert(success);
+	}
+
+	// Read the frames in order, then jump around so the reader has to remap chunks
+	for (int frame_index = 0; success && frame_index < k_frame_count; ++frame_index)
+	{
+		success= check_recorded_frame(reader, frame_index);
+		assert(success);
+	}
+	for (int frame_index = k_frame_count - 1; success && frame_index >= 0; frame_index-= 37)
+	{
+		success= check_recorded_frame(reader, frame_index);
+		assert(success);
+	}
+
+	// Reading past the end fails cleanly
+	if (success)
+	{
+		int64_t timestamp_us= 0;
+
+		success= reader.getFrame(k_frame_count, timestamp_us) == nullptr;
+		assert(success);
+	}
+
+	reader.close();
+	boost::filesystem::remove(path);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+tracker_frame_recording_test_truncated_file()
+{
+	UNIT_TEST_BEGIN("truncated file")
+
+	const std::string path= make_temp_tracker_recording_path();
+
+	success= write_test_recording(path);
+	assert(success);
+
+	// Cut the file off part way through the last frame.
+	// The reader should only hand out the frames that made it to disk in full.
+	if (success)
+	{
+		truncate_test_recording(path, k_frame_stride*2);
+	}
+
+	TrackerFrameRecordingReader reader;
+	if (success)
+	{
+		success= reader.open(path) && reader.getFrameCount() == k_frame_count - 1;
+		assert(success);
+	}
+
+	for (int frame_index = 0; success && frame_index < k_frame_count - 1; ++frame_index)
+	{
+		success= check_recorded_frame(reader, frame_index);
+		assert(success);
+	}
+
+	reader.close();
+	boost::filesystem::remove(path);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+tracker_frame_recording_test_bad_header()
+{
+	UNIT_TEST_BEGIN("bad header")
+
+	const std::string path= make_temp_tracker_recording_path();
+
+	success= write_test_recording(path);
+	assert(success);
+
+	if (success)
+	{
+		success= check_reader_rejects_bad_header<TrackerFrameRecordingReader>(path);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+static std::string make_temp_tracker_recording_path()
+{
+	return make_temp_recording_path("tracker_recording_test", TRACKER_RECORDING_FILE_EXTENSION);
+}
+
+static int64_t get_test_frame_timestamp_us(int frame_index)
+{
+	// Uneven frame spacing, like a real camera
+	return k_first_timestamp_us + frame_index*16667 + (frame_index % 3)*250;
+}
+
+static bool write_test_recording(const std::string &path)
+{
+	TrackerFrameRecordingWriter writer;
+	std::vector<unsigned char> frame;
+
+	if (!writer.open(
+			path,
+			TrackerRecordingPixelFormat_BGR, k_frame_width, k_frame_height, k_frame_stride, k_frame_rate,
+			k_tracker_config_json))
+	{
+		return false;
+	}
+
+	for (int frame_index = 0; frame_index < k_frame_count; ++frame_index)
+	{
+		fill_test_sample(frame_index, k_frame_size, frame);
+
+		if (!writer.writeFrame(frame.data(), get_test_frame_timestamp_us(frame_index)))
+		{
+			return false;
+		}
+	}
+
+	const bool bWroteAllFrames= writer.getFrameCount() == k_frame_count;
+	writer.close();
+
+	return bWroteAllFrames;
+}
+
+static bool check_recorded_frame(TrackerFrameRecordingReader &reader, int frame_index)
+{
+	int64_t timestamp_us= -1;
+	const unsigned char *frame= reader.getFrame(frame_index, timestamp_us);
+
+	// Timestamps are stored relative to the first frame
+	return
+		check_test_sample(frame_index, k_frame_size, frame, k_frame_size) &&
+		timestamp_us == get_test_frame_timestamp_us(frame_index) - k_first_timestamp_us;
+}
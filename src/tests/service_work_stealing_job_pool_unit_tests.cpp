@@ -0,0 +1,232 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "WorkStealingJobPool.h"
+#include "unit_test.h"
+
+//-- constants -----
+static const int k_max_job_count= 256;
+static const int k_worker_count= 3;
+
+// Several times the thread count so that every queue gets more than one job
+static const int k_large_batch_job_count= 200;
+static const int k_batch_repeat_count= 3;
+
+// A few slow jobs bunched at the front of the batch, the rest are trivial
+static const int k_uneven_batch_job_count= 32;
+static const int k_slow_job_count= 4;
+static const int k_slow_job_cost_ms= 5;
+
+static const int k_zero_worker_job_count= 16;
+
+//-- private definitions -----
+struct TestJob
+{
+	std::atomic_int run_count;
+	int cost_ms;
+	std::thread::id thread_id;
+};
+
+//-- private methods -----
+static void init_test_jobs(TestJob *jobs, int job_count);
+static bool add_test_jobs(WorkStealingJobPool &pool, TestJob *jobs, int job_count);
+static bool test_jobs_ran(const TestJob *jobs, int job_count, int expected_run_count);
+static void run_test_job(void *job_context);
+
+//-- public interface -----
+bool run_service_work_stealing_job_pool_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("service_work_stealing_job_pool")
+		UNIT_TEST_MODULE_CALL_TEST(work_stealing_job_pool_test_zero_workers);
+		UNIT_TEST_MODULE_CALL_TEST(work_stealing_job_pool_test_large_batch);
+		UNIT_TEST_MODULE_CALL_TEST(work_stealing_job_pool_test_uneven_job_costs);
+		UNIT_TEST_MODULE_CALL_TEST(work_stealing_job_pool_test_full_batch);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+bool
+work_stealing_job_pool_test_zero_workers()
+{
+	UNIT_TEST_BEGIN("zero workers")
+
+	WorkStealingJobPool pool("ZeroWorkerPool", k_max_job_count);
+	static TestJob jobs[k_zero_worker_job_count];
+	init_test_jobs(jobs, k_zero_worker_job_count);
+
+	success= pool.getWorkerCount() == 0 && add_test_jobs(pool, jobs, k_zero_worker_job_count);
+	assert(success);
+
+	if (success)
+	{
+		pool.runJobs();
+
+		success= pool.getPendingJobCount() == 0 && test_jobs_ran(jobs, k_zero_worker_job_count, 1);
+		assert(success);
+	}
+
+	// With no workers to hand them to, every job runs on the thread calling runJobs()
+	for (int job_index = 0; success && job_index < k_zero_worker_job_count; ++job_index)
+	{
+		success= jobs[job_index].thread_id == std::this_thread::get_id();
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+work_stealing_job_pool_test_large_batch()
+{
+	UNIT_TEST_BEGIN("batch larger than worker count")
+
+	WorkStealingJobPool pool("LargeBatchPool", k_max_job_count);
+	pool.startWorkers(k_worker_count);
+
+	static TestJob jobs[k_large_batch_job_count];
+	init_test_jobs(jobs, k_large_batch_job_count);
+
+	success= pool.getWorkerCount() == k_worker_count;
+	assert(success);
+
+	// Back to back batches reuse the same queues and workers
+	for (int batch_index = 0; success && batch_index < k_batch_repeat_count; ++batch_index)
+	{
+		success= add_test_jobs(pool, jobs, k_large_batch_job_count);
+		assert(success);
+
+		if (success)
+		{
+			pool.runJobs();
+
+			success= pool.getPendingJobCount() == 0 && test_jobs_ran(jobs, k_large_batch_job_count, batch_index + 1);
+			assert(success);
+		}
+	}
+
+	pool.stopWorkers();
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+work_stealing_job_pool_test_uneven_job_costs()
+{
+	UNIT_TEST_BEGIN("uneven job costs")
+
+	WorkStealingJobPool pool("UnevenCostPool", k_max_job_count);
+	pool.startWorkers(k_worker_count);
+
+	static TestJob jobs[k_uneven_batch_job_count];
+	init_test_jobs(jobs, k_uneven_batch_job_count);
+
+	for (int job_index = 0; job_index < k_slow_job_count; ++job_index)
+	{
+		jobs[job_index].cost_ms= k_slow_job_cost_ms;
+	}
+
+	success= add_test_jobs(pool, jobs, k_uneven_batch_job_count);
+	assert(success);
+
+	if (success)
+	{
+		// runJobs() can't return until the slow jobs are done, wherever they ended up running
+		pool.runJobs();
+
+		success= pool.getPendingJobCount() == 0 && test_jobs_ran(jobs, k_uneven_batch_job_count, 1);
+		assert(success);
+	}
+
+	pool.stopWorkers();
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+work_stealing_job_pool_test_full_batch()
+{
+	UNIT_TEST_BEGIN("full batch")
+
+	const int max_job_count= k_zero_worker_job_count / 2;
+
+	WorkStealingJobPool pool("FullBatchPool", max_job_count);
+	pool.startWorkers(k_worker_count);
+
+	static TestJob jobs[k_zero_worker_job_count];
+	init_test_jobs(jobs, k_zero_worker_job_count);
+
+	// Jobs past the end of the batch are turned away
+	success= add_test_jobs(pool, jobs, max_job_count) && !pool.addJob(run_test_job, &jobs[max_job_count]);
+	assert(success);
+
+	if (success)
+	{
+		pool.runJobs();
+
+		success=
+			test_jobs_ran(jobs, max_job_count, 1) &&
+			test_jobs_ran(jobs + max_job_count, k_zero_worker_job_count - max_job_count, 0);
+		assert(success);
+	}
+
+	pool.stopWorkers();
+
+	UNIT_TEST_COMPLETE()
+}
+
+static void
+init_test_jobs(TestJob *jobs, int job_count)
+{
+	for (int job_index = 0; job_index < job_count; ++job_index)
+	{
+		jobs[job_index].run_count.store(0);
+		jobs[job_index].cost_ms= 0;
+		jobs[job_index].thread_id= std::thread::id();
+	}
+}
+
+static bool
+add_test_jobs(WorkStealingJobPool &pool, TestJob *jobs, int job_count)
+{
+	bool bAllAdded= true;
+
+	for (int job_index = 0; bAllAdded && job_index < job_count; ++job_index)
+	{
+		bAllAdded= pool.addJob(run_test_job, &jobs[job_index]);
+	}
+
+	return bAllAdded && pool.getPendingJobCount() == job_count;
+}
+
+static bool
+test_jobs_ran(const TestJob *jobs, int job_count, int expected_run_count)
+{
+	for (int job_index = 0; job_index < job_count; ++job_index)
+	{
+		if (jobs[job_index].run_count.load() != expected_run_count)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+run_test_job(void *job_context)
+{
+	TestJob *job= reinterpret_cast<TestJob *>(job_context);
+
+	if (job->cost_ms > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(job->cost_ms));
+	}
+
+	job->thread_id= std::this_thread::get_id();
+	job->run_count.fetch_add(1);
+}
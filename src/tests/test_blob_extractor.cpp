@@ -0,0 +1,226 @@
+// Micro-benchmark for finding the biggest N blobs in a tracker mask:
+// 1) cv::findContours + cv::contourArea + sort (the original ServerTrackerView path)
+// 2) RunLengthBlobExtractor
+// Usage: test_blob_extractor [mask image]...
+// Recorded masks (any image format OpenCV reads, non-zero pixels are foreground) can be passed
+// on the command line, otherwise a set of synthetic masks is generated.
+// The centers of the biggest blobs are compared before timing.
+
+#include "RunLengthBlobExtractor.h"
+#include "opencv2/opencv.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+//-- constants -----
+static const int k_frame_width= 640;
+static const int k_frame_height= 480;
+static const int k_max_blob_count= 7; // CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT
+static const int k_warmup_iterations= 10;
+static const int k_timed_iterations= 200;
+static const float k_max_center_error= 1.f; // pixels
+static const int k_min_checked_blob_area= 20; // outline centers of tiny blobs are too far off to compare
+
+//-- definitions -----
+struct TestMask
+{
+    std::string name;
+    cv::Mat mask;
+};
+
+//-- prototypes -----
+static void build_synthetic_masks(std::vector<TestMask> &out_masks);
+static int find_contours_opencv(const cv::Mat &mask, std::vector<std::vector<cv::Point> > &out_contours, std::vector<std::pair<double, int> > &out_sorted_contours);
+static int find_blobs(RunLengthBlobExtractor &extractor, const cv::Mat &mask);
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    std::vector<TestMask> masks;
+    bool bSuccess= true;
+
+    for (int arg_index = 1; arg_index < argc; ++arg_index)
+    {
+        TestMask test_mask;
+        test_mask.name= argv[arg_index];
+        test_mask.mask= cv::imread(argv[arg_index], cv::IMREAD_GRAYSCALE);
+
+        if (test_mask.mask.empty())
+        {
+            printf("Failed to load mask: %s\n", argv[arg_index]);
+            return -1;
+        }
+
+        masks.push_back(test_mask);
+    }
+
+    if (masks.empty())
+    {
+        build_synthetic_masks(masks);
+    }
+
+    printf("Biggest %d blobs, %d iterations per mask\n\n", k_max_blob_count, k_timed_iterations);
+    printf("%-24s %8s %8s %12s %12s %7s\n", "mask", "blobs", "kept", "findContours", "run-length", "speedup");
+
+    RunLengthBlobExtractor extractor;
+    std::vector<std::vector<cv::Point> > contours;
+    std::vector<std::pair<double, int> > sorted_contours;
+
+    for (const TestMask &test_mask : masks)
+    {
+        // Make sure both paths agree before timing them
+        const int contour_count= find_contours_opencv(test_mask.mask, contours, sorted_contours);
+        const int blob_count= find_blobs(extractor, test_mask.mask);
+
+        // Not an error: findContours(CV_RETR_EXTERNAL) skips blobs sitting in the holes of other blobs
+        if (contour_count != extractor.getComponentCount())
+        {
+            printf("%s: findContours found %d outer blobs, the run-length extractor found %d blobs\n",
+                test_mask.name.c_str(), contour_count, extractor.getComponentCount());
+        }
+
+        // Blob centers are matched up by distance since near ties in area can sort either way
+        for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+        {
+            const BlobInfo &blob= extractor.getBlob(blob_index);
+            const cv::Point2f blob_center(blob.getCenterX(), blob.getCenterY());
+
+            if (blob.getArea() < k_min_checked_blob_area)
+            {
+                continue;
+            }
+
+            float best_distance= static_cast<float>(k_frame_width);
+            for (const std::vector<cv::Point> &contour : contours)
+            {
+                const cv::Moments mu= cv::moments(contour);
+
+                if (mu.m00 > 0.0)
+                {
+                    const cv::Point2f contour_center(
+                        static_cast<float>(mu.m10 / mu.m00), static_cast<float>(mu.m01 / mu.m00));
+
+                    best_distance= std::min(best_distance, static_cast<float>(cv::norm(blob_center - contour_center)));
+                }
+            }
+
+            if (best_distance > k_max_center_error)
+            {
+                printf("%s: blob center (%.1f, %.1f) is %.2f pixels from the nearest contour center!\n",
+                    test_mask.name.c_str(), blob_center.x, blob_center.y, best_distance);
+                bSuccess= false;
+            }
+        }
+
+        double opencv_ms= 0.0;
+        double extractor_ms= 0.0;
+        for (int iteration = 0; iteration < k_warmup_iterations + k_timed_iterations; ++iteration)
+        {
+            const std::chrono::high_resolution_clock::time_point start= std::chrono::high_resolution_clock::now();
+            find_contours_opencv(test_mask.mask, contours, sorted_contours);
+            const std::chrono::high_resolution_clock::time_point middle= std::chrono::high_resolution_clock::now();
+            find_blobs(extractor, test_mask.mask);
+            const std::chrono::high_resolution_clock::time_point end= std::chrono::high_resolution_clock::now();
+
+            if (iteration >= k_warmup_iterations)
+            {
+                opencv_ms+= std::chrono::duration<double, std::milli>(middle - start).count();
+                extractor_ms+= std::chrono::duration<double, std::milli>(end - middle).count();
+            }
+        }
+
+        printf("%-24s %8d %8d %9.3f ms %9.3f ms %6.2fx\n",
+            test_mask.name.c_str(), contour_count, blob_count,
+            opencv_ms / k_timed_iterations, extractor_ms / k_timed_iterations,
+            (extractor_ms > 0.0) ? opencv_ms / extractor_ms : 0.0);
+    }
+
+    printf("\n%s\n", bSuccess ? "All blobs match" : "BLOB MISMATCH");
+
+    return bSuccess ? 0 : -1;
+}
+
+//-- private methods -----
+static void build_synthetic_masks(std::vector<TestMask> &out_masks)
+{
+    cv::RNG rng(0x1234);
+
+    // A single controller bulb with a little sensor noise
+    {
+        TestMask test_mask= {"controller", cv::Mat::zeros(k_frame_height, k_frame_width, CV_8UC1)};
+
+        cv::circle(test_mask.mask, cv::Point(320, 240), 40, cv::Scalar(255), -1);
+        for (int speck_index = 0; speck_index < 50; ++speck_index)
+        {
+            test_mask.mask.at<uint8_t>(rng.uniform(0, k_frame_height), rng.uniform(0, k_frame_width))= 255;
+        }
+
+        out_masks.push_back(test_mask);
+    }
+
+    // HMD LEDs: a handful of small ellipses
+    {
+        TestMask test_mask= {"hmd leds", cv::Mat::zeros(k_frame_height, k_frame_width, CV_8UC1)};
+
+        for (int led_index = 0; led_index < 9; ++led_index)
+        {
+            const cv::Point center(100 + 50*led_index, 200 + 10*(led_index % 3));
+            const cv::Size axes(rng.uniform(4, 12), rng.uniform(3, 8));
+
+            cv::ellipse(test_mask.mask, center, axes, rng.uniform(0., 180.), 0, 360, cv::Scalar(255), -1);
+        }
+
+        out_masks.push_back(test_mask);
+    }
+
+    // Lots of noise from a badly calibrated color range
+    {
+        TestMask test_mask= {"noisy", cv::Mat(k_frame_height, k_frame_width, CV_8UC1)};
+
+        rng.fill(test_mask.mask, cv::RNG::UNIFORM, cv::Scalar(0), cv::Scalar(256));
+        cv::threshold(test_mask.mask, test_mask.mask, 230, 255, cv::THRESH_BINARY);
+        cv::circle(test_mask.mask, cv::Point(200, 300), 60, cv::Scalar(255), -1);
+
+        out_masks.push_back(test_mask);
+    }
+
+    // A sphere close to the camera, clipped by the edge of the frame
+    {
+        TestMask test_mask= {"large clipped", cv::Mat::zeros(k_frame_height, k_frame_width, CV_8UC1)};
+
+        cv::circle(test_mask.mask, cv::Point(600, 100), 150, cv::Scalar(255), -1);
+
+        out_masks.push_back(test_mask);
+    }
+}
+
+static int find_contours_opencv(
+    const cv::Mat &mask,
+    std::vector<std::vector<cv::Point> > &out_contours,
+    std::vector<std::pair<double, int> > &out_sorted_contours)
+{
+    // Same as computeBiggestNContoursOpenCV() in ServerTrackerView.cpp.
+    // findContours modifies its input on older OpenCV versions.
+    cv::Mat mask_copy= mask.clone();
+
+    out_contours.clear();
+    cv::findContours(mask_copy, out_contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
+
+    out_sorted_contours.clear();
+    for (int contour_index = 0; contour_index < static_cast<int>(out_contours.size()); ++contour_index)
+    {
+        out_sorted_contours.push_back(std::make_pair(cv::contourArea(out_contours[contour_index]), contour_index));
+    }
+    std::sort(out_sorted_contours.rbegin(), out_sorted_contours.rend());
+
+    return static_cast<int>(out_contours.size());
+}
+
+static int find_blobs(RunLengthBlobExtractor &extractor, const cv::Mat &mask)
+{
+    return extractor.extractBiggestBlobs(
+        mask.ptr<uint8_t>(0), mask.cols, mask.rows, static_cast<int>(mask.step), 0, 0, k_max_blob_count);
+}
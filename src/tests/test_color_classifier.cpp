@@ -0,0 +1,325 @@
+// Micro-benchmark for the tracker color segmentation paths on a 640x480 frame:
+// 1) cv::cvtColor + cv::inRange (+ second cv::inRange and cv::bitwise_or when the hue wraps)
+// 2) The 48MB BGR->HSV lookup table + cv::inRange (same as OpenCVBGRToHSVMapper in ServerTrackerView)
+// 3) The fused HSVColorClassifier kernel, once per supported instruction set
+// 4) The quantized ColorMembershipCube lookup
+// Every exact path is checked against the cv::cvtColor mask before it's timed.
+
+#include "ColorMembershipCube.h"
+#include "HSVColorClassifier.h"
+#include "opencv2/opencv.hpp"
+
+#include <chrono>
+#include <stdio.h>
+
+//-- constants -----
+static const int k_frame_width= 640;
+static const int k_frame_height= 480;
+static const int k_warmup_iterations= 10;
+static const int k_timed_iterations= 200;
+
+//-- definitions -----
+typedef cv::Point3_<uint8_t> ColorTuple;
+
+// Mirrors OpenCVBGRToHSVMapper in ServerTrackerView.cpp
+class BGRToHSVLookupTable
+{
+public:
+    BGRToHSVLookupTable()
+    {
+        bgr2hsv = cv::Mat(256*256*256, 1, CV_8UC3);
+
+        int LUTIndex = 0;
+        for (int r = 0; r < 256; ++r)
+        {
+            for (int g = 0; g < 256; ++g)
+            {
+                for (int b = 0; b < 256; ++b)
+                {
+                    bgr2hsv.at<ColorTuple>(LUTIndex, 0) = ColorTuple(b, g, r);
+                    ++LUTIndex;
+                }
+            }
+        }
+
+        cv::cvtColor(bgr2hsv, bgr2hsv, cv::COLOR_BGR2HSV);
+    }
+
+    void cvtColor(const cv::Mat &bgrBuffer, cv::Mat &hsvBuffer) const
+    {
+        hsvBuffer.forEach<ColorTuple>([&bgrBuffer, this](ColorTuple &hsvColor, const int position[]) -> void {
+            const ColorTuple &bgrColor = bgrBuffer.at<ColorTuple>(position[0], position[1]);
+            const int LUTIndex = (256 * 256)*bgrColor.z + 256*bgrColor.y + bgrColor.x;
+
+            hsvColor = bgr2hsv.at<ColorTuple>(LUTIndex, 0);
+        });
+    }
+
+private:
+    cv::Mat bgr2hsv;
+};
+
+//-- prototypes -----
+static void build_test_frame(cv::Mat &bgr);
+static HSVColorClassifierBounds make_bounds(int hue_center, int hue_range, int sat_min, int sat_max, int val_min, int val_max);
+static void in_range_with_wrap(const cv::Mat &hsv, const HSVColorClassifierBounds &bounds, cv::Mat &lower, cv::Mat &upper, cv::Mat &out_mask);
+static void classify_frame(HSVColorClassifier::eInstructionSet instruction_set, const cv::Mat &bgr, const HSVColorClassifierBounds &bounds, cv::Mat &out_mask);
+static void print_result(const char *name, double total_ms, double baseline_ms);
+
+//-- entry point -----
+int main(int, char**)
+{
+    cv::Mat bgr(k_frame_height, k_frame_width, CV_8UC3);
+    cv::Mat hsv(k_frame_height, k_frame_width, CV_8UC3);
+    cv::Mat lower(k_frame_height, k_frame_width, CV_8UC1);
+    cv::Mat upper(k_frame_height, k_frame_width, CV_8UC1);
+    cv::Mat reference_mask(k_frame_height, k_frame_width, CV_8UC1);
+    cv::Mat test_mask(k_frame_height, k_frame_width, CV_8UC1);
+    bool bSuccess= true;
+
+    build_test_frame(bgr);
+
+    // Magenta with a hue range that wraps past 180, so the OpenCV paths need both inRange calls
+    const HSVColorClassifierBounds bounds= make_bounds(150, 45, 64, 255, 32, 255);
+
+    printf("Frame: %dx%d, %d iterations per path\n", k_frame_width, k_frame_height, k_timed_iterations);
+    printf("Best instruction set: %s\n\n",
+        HSVColorClassifier::get_instruction_set_name(HSVColorClassifier::get_instruction_set()));
+
+    // cv::cvtColor + cv::inRange
+    double cvt_color_ms= 0.0;
+    {
+        cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+        in_range_with_wrap(hsv, bounds, lower, upper, reference_mask);
+
+        for (int iteration = 0; iteration < k_warmup_iterations + k_timed_iterations; ++iteration)
+        {
+            const std::chrono::high_resolution_clock::time_point start= std::chrono::high_resolution_clock::now();
+            cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+            in_range_with_wrap(hsv, bounds, lower, upper, test_mask);
+            const std::chrono::high_resolution_clock::time_point end= std::chrono::high_resolution_clock::now();
+
+            if (iteration >= k_warmup_iterations)
+            {
+                cvt_color_ms+= std::chrono::duration<double, std::milli>(end - start).count();
+            }
+        }
+
+        print_result("cvtColor + inRange", cvt_color_ms, cvt_color_ms);
+    }
+
+    // Lookup table + cv::inRange
+    {
+        const BGRToHSVLookupTable lookup_table;
+        double lookup_table_ms= 0.0;
+
+        lookup_table.cvtColor(bgr, hsv);
+        in_range_with_wrap(hsv, bounds, lower, upper, test_mask);
+        if (cv::countNonZero(test_mask != reference_mask) > 0)
+        {
+            printf("Lookup table mask doesn't match the cvtColor mask!\n");
+            bSuccess= false;
+        }
+
+        for (int iteration = 0; iteration < k_warmup_iterations + k_timed_iterations; ++iteration)
+        {
+            const std::chrono::high_resolution_clock::time_point start= std::chrono::high_resolution_clock::now();
+            lookup_table.cvtColor(bgr, hsv);
+            in_range_with_wrap(hsv, bounds, lower, upper, test_mask);
+            const std::chrono::high_resolution_clock::time_point end= std::chrono::high_resolution_clock::now();
+
+            if (iteration >= k_warmup_iterations)
+            {
+                lookup_table_ms+= std::chrono::duration<double, std::milli>(end - start).count();
+            }
+        }
+
+        print_result("Lookup table + inRange", lookup_table_ms, cvt_color_ms);
+    }
+
+    // Fused classifier, for every instruction set this CPU supports
+    for (int isa_index = 0; isa_index < HSVColorClassifier::MAX_INSTRUCTION_SETS; ++isa_index)
+    {
+        const HSVColorClassifier::eInstructionSet instruction_set= static_cast<HSVColorClassifier::eInstructionSet>(isa_index);
+        const bool bIsSupported=
+            instruction_set == HSVColorClassifier::Scalar ||
+            instruction_set == HSVColorClassifier::get_instruction_set() ||
+            (instruction_set == HSVColorClassifier::SSE41 && HSVColorClassifier::get_instruction_set() == HSVColorClassifier::AVX2);
+
+        if (!bIsSupported)
+        {
+            continue;
+        }
+
+        double classifier_ms= 0.0;
+        char name[64];
+        snprintf(name, sizeof(name), "Fused classifier (%s)", HSVColorClassifier::get_instruction_set_name(instruction_set));
+
+        classify_frame(instruction_set, bgr, bounds, test_mask);
+        if (cv::countNonZero(test_mask != reference_mask) > 0)
+        {
+            printf("%s mask doesn't match the cvtColor mask!\n", name);
+            bSuccess= false;
+        }
+
+        for (int iteration = 0; iteration < k_warmup_iterations + k_timed_iterations; ++iteration)
+        {
+            const std::chrono::high_resolution_clock::time_point start= std::chrono::high_resolution_clock::now();
+            classify_frame(instruction_set, bgr, bounds, test_mask);
+            const std::chrono::high_resolution_clock::time_point end= std::chrono::high_resolution_clock::now();
+
+            if (iteration >= k_warmup_iterations)
+            {
+                classifier_ms+= std::chrono::duration<double, std::milli>(end - start).count();
+            }
+        }
+
+        print_result(name, classifier_ms, cvt_color_ms);
+    }
+
+    // Color membership cube (approximate near the edges of the bounds, so only the difference is reported)
+    {
+        static ColorMembershipCube cube;
+        const ColorMembershipCube *cubes[1]= {&cube};
+        const uint8_t mask_bits[1]= {255};
+        double rebuild_ms= 0.0;
+        double cube_ms= 0.0;
+
+        for (int iteration = 0; iteration < k_timed_iterations; ++iteration)
+        {
+            const std::chrono::high_resolution_clock::time_point start= std::chrono::high_resolution_clock::now();
+            cube.rebuild(bounds);
+            const std::chrono::high_resolution_clock::time_point end= std::chrono::high_resolution_clock::now();
+
+            rebuild_ms+= std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        for (int iteration = 0; iteration < k_warmup_iterations + k_timed_iterations; ++iteration)
+        {
+            const std::chrono::high_resolution_clock::time_point start= std::chrono::high_resolution_clock::now();
+            for (int row = 0; row < bgr.rows; ++row)
+            {
+                ColorMembershipCube::classify_bgr_row(
+                    bgr.ptr<uint8_t>(row), test_mask.ptr<uint8_t>(row), bgr.cols, cubes, mask_bits, 1);
+            }
+            const std::chrono::high_resolution_clock::time_point end= std::chrono::high_resolution_clock::now();
+
+            if (iteration >= k_warmup_iterations)
+            {
+                cube_ms+= std::chrono::duration<double, std::milli>(end - start).count();
+            }
+        }
+
+        print_result("Color membership cube", cube_ms, cvt_color_ms);
+        printf("  cube size: %d bytes, rebuild: %.3f ms, pixels differing from cvtColor: %.3f%%\n",
+            static_cast<int>(sizeof(cube)), rebuild_ms / k_timed_iterations,
+            100.0 * cv::countNonZero(test_mask != reference_mask) / (k_frame_width * k_frame_height));
+    }
+
+    printf("\n%s\n", bSuccess ? "All masks match" : "MASK MISMATCH");
+
+    return bSuccess ? 0 : -1;
+}
+
+//-- private methods -----
+static void build_test_frame(cv::Mat &bgr)
+{
+    // Noise covers the whole color cube, the blobs give the mask some solid areas
+    cv::RNG rng(0x1234);
+    rng.fill(bgr, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    const cv::Scalar blob_colors[]= {
+        cv::Scalar(255, 0, 255), // magenta
+        cv::Scalar(200, 30, 255), // magenta leaning red
+        cv::Scalar(255, 255, 0), // cyan
+        cv::Scalar(0, 0, 255), // red
+    };
+
+    for (int blob_index = 0; blob_index < 16; ++blob_index)
+    {
+        const cv::Point center(rng.uniform(0, k_frame_width), rng.uniform(0, k_frame_height));
+        const int radius= rng.uniform(10, 60);
+
+        cv::circle(bgr, center, radius, blob_colors[blob_index % 4], -1);
+    }
+}
+
+static HSVColorClassifierBounds make_bounds(
+    int hue_center, int hue_range, int sat_min, int sat_max, int val_min, int val_max)
+{
+    const int hue_min= hue_center - hue_range;
+    const int hue_max= hue_center + hue_range;
+    HSVColorClassifierBounds bounds;
+
+    if (hue_min < 0)
+    {
+        bounds.hue_min[0]= 0;
+        bounds.hue_max[0]= static_cast<uint8_t>(hue_max);
+        bounds.hue_min[1]= static_cast<uint8_t>(180 + hue_min);
+        bounds.hue_max[1]= 180;
+    }
+    else if (hue_max > 180)
+    {
+        bounds.hue_min[0]= 0;
+        bounds.hue_max[0]= static_cast<uint8_t>(hue_max - 180);
+        bounds.hue_min[1]= static_cast<uint8_t>(hue_min);
+        bounds.hue_max[1]= 180;
+    }
+    else
+    {
+        bounds.hue_min[0]= static_cast<uint8_t>(hue_min);
+        bounds.hue_max[0]= static_cast<uint8_t>(hue_max);
+        bounds.hue_min[1]= 1; // empty range
+        bounds.hue_max[1]= 0;
+    }
+
+    bounds.saturation_min= static_cast<uint8_t>(sat_min);
+    bounds.saturation_max= static_cast<uint8_t>(sat_max);
+    bounds.value_min= static_cast<uint8_t>(val_min);
+    bounds.value_max= static_cast<uint8_t>(val_max);
+    bounds.mask_bits= 255;
+
+    return bounds;
+}
+
+static void in_range_with_wrap(
+    const cv::Mat &hsv, const HSVColorClassifierBounds &bounds,
+    cv::Mat &lower, cv::Mat &upper, cv::Mat &out_mask)
+{
+    cv::inRange(
+        hsv,
+        cv::Scalar(bounds.hue_min[0], bounds.saturation_min, bounds.value_min),
+        cv::Scalar(bounds.hue_max[0], bounds.saturation_max, bounds.value_max),
+        lower);
+
+    if (bounds.hue_min[1] <= bounds.hue_max[1])
+    {
+        cv::inRange(
+            hsv,
+            cv::Scalar(bounds.hue_min[1], bounds.saturation_min, bounds.value_min),
+            cv::Scalar(bounds.hue_max[1], bounds.saturation_max, bounds.value_max),
+            upper);
+        cv::bitwise_or(lower, upper, out_mask);
+    }
+    else
+    {
+        lower.copyTo(out_mask);
+    }
+}
+
+static void classify_frame(
+    HSVColorClassifier::eInstructionSet instruction_set,
+    const cv::Mat &bgr, const HSVColorClassifierBounds &bounds, cv::Mat &out_mask)
+{
+    for (int row = 0; row < bgr.rows; ++row)
+    {
+        HSVColorClassifier::classify_bgr_row_with_instruction_set(
+            instruction_set, bgr.ptr<uint8_t>(row), out_mask.ptr<uint8_t>(row), bgr.cols, &bounds, 1);
+    }
+}
+
+static void print_result(const char *name, double total_ms, double baseline_ms)
+{
+    printf("%-28s %8.3f ms/frame  %5.2fx\n",
+        name, total_ms / k_timed_iterations, (total_ms > 0.0) ? baseline_ms / total_ms : 0.0);
+}
@@ -10,9 +10,23 @@ int
 main(int argc, char* argv[])
 {
 	UNIT_TEST_SUITE_BEGIN()
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_client_atomic_snapshot_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_client_pose_prediction_unit_tests);
 		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_math_alignment_unit_tests);
 		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_math_eigen_unit_tests);
 		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_math_utility_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_data_stream_rate_limit_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_hsv_color_classifier_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_color_membership_cube_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_run_length_blob_extractor_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_hid_packet_recording_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_pipeline_latency_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_pose_sensor_packet_merger_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_kalman_pose_filter_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_tracker_frame_recording_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_service_work_stealing_job_pool_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_protocol_compact_data_frame_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_protocol_message_pool_unit_tests);
 	UNIT_TEST_SUITE_END()
 
 	return success ? EXIT_SUCCESS : EXIT_FAILURE;